@@ -38,6 +38,8 @@ extern "C" {
  * Values greater than 0 are specific non-error return codes
  */
 typedef enum {
+	/** Returned by the internal read when an oversized publish was streamed to a stream subscription */
+			MQTT_PUBLISH_STREAMED = 7,
 	/** Returned when the Network physical layer is connected */
 			NETWORK_PHYSICAL_LAYER_CONNECTED = 6,
 	/** Returned when the Network is manually disconnected */
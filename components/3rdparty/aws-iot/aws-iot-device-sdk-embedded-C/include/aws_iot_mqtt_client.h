@@ -220,6 +220,33 @@ typedef enum _ClientState {
 typedef void (*pApplicationHandler_t)(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen,
 									  IoT_Publish_Message_Params *pParams, void *pClientData);
 
+/**
+ * @brief Stream Callback Event
+ *
+ * Events passed to a stream subscription handler, in this order for every publish.
+ * ABORT replaces END when the connection failed in the middle of the payload.
+ *
+ */
+typedef enum {
+	MQTT_STREAM_BEGIN = 0,	///< Publish received, pParams->payloadLen is 0
+	MQTT_STREAM_DATA = 1,	///< pParams->payload holds pParams->payloadLen bytes starting at offset
+	MQTT_STREAM_END = 2,	///< Whole payload delivered, a QoS1 PUBACK is sent after the handler returns
+	MQTT_STREAM_ABORT = 3	///< Payload incomplete, no PUBACK is sent
+} IoT_Stream_Event;
+
+/**
+ * @brief Stream Callback Handler Type
+ *
+ * Defining a TYPE for definition of stream callback function pointers.
+ * Used to pass a publish larger than the read buffer to the application in chunks.
+ * The topic name and the chunk are only valid during the call. The handler runs with
+ * the TLS read lock held and must not call blocking MQTT APIs.
+ *
+ */
+typedef void (*pStreamHandler_t)(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen,
+								 IoT_Stream_Event event, size_t offset, size_t totalLen,
+								 IoT_Publish_Message_Params *pParams, void *pClientData);
+
 /**
  * @brief MQTT Message Handler
  *
@@ -232,6 +259,7 @@ typedef struct _MessageHandlers {
 	uint16_t topicNameLen;
 	QoS qos;
 	pApplicationHandler_t pApplicationHandler;
+	pStreamHandler_t pStreamHandler;
 	void *pApplicationHandlerData;
 } MessageHandlers;   /* Message handlers are indexed by subscription topic */
 
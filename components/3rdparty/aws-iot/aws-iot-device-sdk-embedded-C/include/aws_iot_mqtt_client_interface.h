@@ -132,6 +132,29 @@ IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName
 IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
 								   QoS qos, pApplicationHandler_t pApplicationHandler, void *pApplicationHandlerData);
 
+/**
+ * @brief Subscribe to an MQTT topic, receiving the payloads in chunks.
+ *
+ * Same as aws_iot_mqtt_subscribe, but publishes on the topic are passed to pStreamHandler
+ * as BEGIN, DATA and END events. A publish larger than the read buffer is not dropped,
+ * its payload is read in pieces of the free read buffer space and handed over as it arrives.
+ * For QoS1 the PUBACK is sent after the END event.
+ * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet.
+ * @warning pTopicName and pApplicationHandlerData need to be static in memory.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to subscribe to. pTopicName needs to be static in memory since
+ *     no malloc are performed by the SDK
+ * @param topicNameLen Length of the topic name
+ * @param pStreamHandler Reference to the stream handler function for this subscription
+ * @param pApplicationHandlerData Point to data passed to the callback.
+ *    pApplicationHandlerData also needs to be static in memory  since no malloc are performed by the SDK
+ *
+ * @return An IoT Error Type defining successful/failed subscription
+ */
+IoT_Error_t aws_iot_mqtt_subscribe_stream(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+										  QoS qos, pStreamHandler_t pStreamHandler, void *pApplicationHandlerData);
+
 /**
  * @brief Subscribe to an MQTT topic.
  *
@@ -218,6 +218,7 @@ IoT_Error_t aws_iot_mqtt_init(AWS_IoT_Client *pClient, const IoT_Client_Init_Par
 	for(i = 0; i < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++i) {
 		pClient->clientData.messageHandlers[i].topicName = NULL;
 		pClient->clientData.messageHandlers[i].pApplicationHandler = NULL;
+		pClient->clientData.messageHandlers[i].pStreamHandler = NULL;
 		pClient->clientData.messageHandlers[i].pApplicationHandlerData = NULL;
 		pClient->clientData.messageHandlers[i].qos = QOS0;
 	}
@@ -378,18 +378,47 @@ static IoT_Error_t _aws_iot_mqtt_internal_decode_packet_remaining_len(AWS_IoT_Cl
 	FUNC_EXIT_RC(rc);
 }
 
+/* read and discard the rest of a packet that does not fit in the read buffer */
+static IoT_Error_t _aws_iot_mqtt_internal_drain_packet(AWS_IoT_Client *pClient, size_t rem_len, Timer *pTimer) {
+	size_t total_bytes_read, bytes_to_be_read, read_len;
+	IoT_Error_t rc;
+
+	rc = SUCCESS;
+	total_bytes_read = 0;
+	while(total_bytes_read < rem_len) {
+		if((rem_len - total_bytes_read) >= pClient->clientData.readBufSize) {
+			bytes_to_be_read = pClient->clientData.readBufSize;
+		} else {
+			bytes_to_be_read = rem_len - total_bytes_read;
+		}
+		read_len = 0;
+		rc = pClient->networkStack.read(&(pClient->networkStack), pClient->clientData.readBuf, bytes_to_be_read,
+										pTimer, &read_len);
+		if(SUCCESS != rc || 0 == read_len) {
+			break;
+		}
+		total_bytes_read += read_len;
+	}
+
+	/* Check buffer was correctly emptied, otherwise, return error message. */
+	if(total_bytes_read == rem_len) {
+		aws_iot_mqtt_internal_flushBuffers(pClient);
+		return MQTT_RX_BUFFER_TOO_SHORT_ERROR;
+	}
+
+	return (SUCCESS == rc) ? FAILURE : rc;
+}
+
+static IoT_Error_t _aws_iot_mqtt_internal_stream_publish(AWS_IoT_Client *pClient, size_t offset, size_t rem_len,
+														 Timer *pTimer);
+
 static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, Timer *pTimer, uint8_t *pPacketType) {
-	size_t rem_len, total_bytes_read, bytes_to_be_read, read_len;
+	size_t rem_len, read_len;
 	IoT_Error_t rc;
     size_t offset = 0;
 	MQTTHeader header = {0};
-	Timer packetTimer;
-	init_timer(&packetTimer);
-	countdown_ms(&packetTimer, pClient->clientData.packetTimeoutMs);
 
 	rem_len = 0;
-	total_bytes_read = 0;
-	bytes_to_be_read = 0;
 	read_len = 0;
 
     rc = _aws_iot_mqtt_internal_readWrapper( pClient, offset, 1, pTimer, &read_len );
@@ -406,32 +435,15 @@ static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, T
 		return rc;
 	} 
      
-	/* if the buffer is too short then the message will be dropped silently */
+	/* if the buffer is too short then the message will be dropped silently,
+	 * unless it is a publish on a stream subscription */
 	if((rem_len + offset) >= pClient->clientData.readBufSize) {
-		bytes_to_be_read = pClient->clientData.readBufSize;
-		do {
-			rc = pClient->networkStack.read(&(pClient->networkStack), pClient->clientData.readBuf, bytes_to_be_read,
-											pTimer, &read_len);
-			if(SUCCESS == rc) {
-				total_bytes_read += read_len;
-				if((rem_len - total_bytes_read) >= pClient->clientData.readBufSize) {
-					bytes_to_be_read = pClient->clientData.readBufSize;
-				} else {
-					bytes_to_be_read = rem_len - total_bytes_read;
-				}
-			}
-		} while(total_bytes_read < rem_len && SUCCESS == rc);
-
-        /* Check buffer was correctly emptied, otherwise, return error message. */
-        if ( total_bytes_read == rem_len )
-        {
-            aws_iot_mqtt_internal_flushBuffers( pClient );
-            return MQTT_RX_BUFFER_TOO_SHORT_ERROR;
-        }
-        else
-        {
-            return rc;
-        }
+		header.byte = pClient->clientData.readBuf[0];
+		if(PUBLISH != MQTT_HEADER_FIELD_TYPE(header.byte)) {
+			return _aws_iot_mqtt_internal_drain_packet(pClient, rem_len, pTimer);
+		}
+		*pPacketType = PUBLISH;
+		return _aws_iot_mqtt_internal_stream_publish(pClient, offset, rem_len, pTimer);
 	}
 
 	/* 3. read the rest of the buffer using a callback to supply the rest of the data */
@@ -489,12 +501,65 @@ static bool _aws_iot_mqtt_internal_is_topic_matched(char *pTopicFilter, char *pT
 	return (curn == curn_end) && (*curf == '\0');
 }
 
+static bool _aws_iot_mqtt_internal_is_handler_matched(MessageHandlers *pHandler, char *pTopicName,
+													  uint16_t topicNameLen) {
+	if(NULL == pHandler->topicName) {
+		return false;
+	}
+
+	return ((topicNameLen == pHandler->topicNameLen)
+			&&
+			(strncmp(pTopicName, (char *) pHandler->topicName, topicNameLen) == 0))
+		   || _aws_iot_mqtt_internal_is_topic_matched((char *) pHandler->topicName, pTopicName, topicNameLen);
+}
+
+/* hand a publish that is already in the read buffer to a stream handler in one piece */
+static void _aws_iot_mqtt_internal_stream_whole(AWS_IoT_Client *pClient, MessageHandlers *pHandler,
+												char *pTopicName, uint16_t topicNameLen,
+												IoT_Publish_Message_Params *pMessageParams) {
+	IoT_Publish_Message_Params chunk = *pMessageParams;
+	size_t totalLen = pMessageParams->payloadLen;
+
+	chunk.payload = NULL;
+	chunk.payloadLen = 0;
+	pHandler->pStreamHandler(pClient, pTopicName, topicNameLen, MQTT_STREAM_BEGIN, 0, totalLen, &chunk,
+							 pHandler->pApplicationHandlerData);
+	if(0 < totalLen) {
+		pHandler->pStreamHandler(pClient, pTopicName, topicNameLen, MQTT_STREAM_DATA, 0, totalLen, pMessageParams,
+								 pHandler->pApplicationHandlerData);
+	}
+	pHandler->pStreamHandler(pClient, pTopicName, topicNameLen, MQTT_STREAM_END, totalLen, totalLen, &chunk,
+							 pHandler->pApplicationHandlerData);
+}
+
+/* pass one stream event to every matching stream handler, returns the number of handlers called */
+static uint32_t _aws_iot_mqtt_internal_stream_event(AWS_IoT_Client *pClient, char *pTopicName,
+													uint16_t topicNameLen, IoT_Stream_Event event, size_t offset,
+													size_t totalLen, IoT_Publish_Message_Params *pParams) {
+	uint32_t itr, count;
+	MessageHandlers *pHandler;
+
+	count = 0;
+	for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++itr) {
+		pHandler = &(pClient->clientData.messageHandlers[itr]);
+		if(NULL != pHandler->pStreamHandler
+		   && _aws_iot_mqtt_internal_is_handler_matched(pHandler, pTopicName, topicNameLen)) {
+			pHandler->pStreamHandler(pClient, pTopicName, topicNameLen, event, offset, totalLen, pParams,
+									 pHandler->pApplicationHandlerData);
+			count++;
+		}
+	}
+
+	return count;
+}
+
 static IoT_Error_t _aws_iot_mqtt_internal_deliver_message(AWS_IoT_Client *pClient, char *pTopicName,
 														  uint16_t topicNameLen,
 														  IoT_Publish_Message_Params *pMessageParams) {
 	uint32_t itr;
 	IoT_Error_t rc;
 	ClientState clientState;
+	MessageHandlers *pHandler;
 
 	FUNC_ENTRY;
 
@@ -510,17 +575,13 @@ static IoT_Error_t _aws_iot_mqtt_internal_deliver_message(AWS_IoT_Client *pClien
 
 	/* Find the right message handler - indexed by topic */
 	for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++itr) {
-		if(NULL != pClient->clientData.messageHandlers[itr].topicName) {
-			if(((topicNameLen == pClient->clientData.messageHandlers[itr].topicNameLen)
-				&&
-				(strncmp(pTopicName, (char *) pClient->clientData.messageHandlers[itr].topicName, topicNameLen) == 0))
-			   || _aws_iot_mqtt_internal_is_topic_matched((char *) pClient->clientData.messageHandlers[itr].topicName,
-														  pTopicName, topicNameLen)) {
-				if(NULL != pClient->clientData.messageHandlers[itr].pApplicationHandler) {
-					pClient->clientData.messageHandlers[itr].pApplicationHandler(pClient, pTopicName, topicNameLen,
-																				 pMessageParams,
-																				 pClient->clientData.messageHandlers[itr].pApplicationHandlerData);
-				}
+		pHandler = &(pClient->clientData.messageHandlers[itr]);
+		if(_aws_iot_mqtt_internal_is_handler_matched(pHandler, pTopicName, topicNameLen)) {
+			if(NULL != pHandler->pApplicationHandler) {
+				pHandler->pApplicationHandler(pClient, pTopicName, topicNameLen, pMessageParams,
+											  pHandler->pApplicationHandlerData);
+			} else if(NULL != pHandler->pStreamHandler) {
+				_aws_iot_mqtt_internal_stream_whole(pClient, pHandler, pTopicName, topicNameLen, pMessageParams);
 			}
 		}
 	}
@@ -578,6 +639,136 @@ static IoT_Error_t _aws_iot_mqtt_internal_handle_publish(AWS_IoT_Client *pClient
 	FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Stream a publish that does not fit in the read buffer.
+ *
+ * Reads the variable header into the read buffer behind the fixed header, then the payload
+ * in pieces of the remaining buffer space, restarting the packet timeout for every piece.
+ * Each piece is passed to the matching stream handlers while the client is in the
+ * CB_RETURN state. Without a matching stream handler, or when the topic name does not fit,
+ * the packet is dropped as before.
+ *
+ * @return MQTT_PUBLISH_STREAMED once the payload was delivered and acknowledged
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_stream_publish(AWS_IoT_Client *pClient, size_t offset, size_t rem_len,
+														 Timer *pTimer) {
+	unsigned char *pReadBuf = pClient->clientData.readBuf;
+	size_t hdr_len, base, payload_len, payload_off, chunk, read_len;
+	uint16_t topicNameLen;
+	uint32_t len, timeout_ms;
+	char *pTopicName;
+	ClientState clientState;
+	IoT_Publish_Message_Params msg;
+	Timer packetTimer;
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	read_len = 0;
+	msg.isDup = (uint8_t) MQTT_HEADER_FIELD_DUP(pReadBuf[0]);
+	msg.qos = (QoS) MQTT_HEADER_FIELD_QOS(pReadBuf[0]);
+	msg.isRetained = (uint8_t) MQTT_HEADER_FIELD_RETAIN(pReadBuf[0]);
+	msg.id = 0;
+	msg.payload = NULL;
+	msg.payloadLen = 0;
+
+	rc = _aws_iot_mqtt_internal_readWrapper(pClient, offset, 2, pTimer, &read_len);
+	if(SUCCESS != rc || 2 != read_len) {
+		FUNC_EXIT_RC(FAILURE);
+	}
+	topicNameLen = (uint16_t) ((pReadBuf[offset] << 8) | pReadBuf[offset + 1]);
+	hdr_len = 2 + (size_t) topicNameLen + ((QOS0 != msg.qos) ? 2 : 0);
+	base = offset + hdr_len;
+	if(hdr_len > rem_len || base >= pClient->clientData.readBufSize) {
+		rc = _aws_iot_mqtt_internal_drain_packet(pClient, rem_len - 2, pTimer);
+		FUNC_EXIT_RC(rc);
+	}
+
+	rc = _aws_iot_mqtt_internal_readWrapper(pClient, offset + 2, hdr_len - 2, pTimer, &read_len);
+	if(SUCCESS != rc || (hdr_len - 2) != read_len) {
+		FUNC_EXIT_RC(FAILURE);
+	}
+	pTopicName = (char *) &pReadBuf[offset + 2];
+	if(QOS0 != msg.qos) {
+		msg.id = (uint16_t) ((pReadBuf[base - 2] << 8) | pReadBuf[base - 1]);
+	}
+	payload_len = rem_len - hdr_len;
+
+	/* Same as for delivery from the buffer, yield must not be called from the handlers */
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN);
+
+	if(0 == _aws_iot_mqtt_internal_stream_event(pClient, pTopicName, topicNameLen, MQTT_STREAM_BEGIN, 0,
+												payload_len, &msg)) {
+		aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
+		rc = _aws_iot_mqtt_internal_drain_packet(pClient, payload_len, pTimer);
+		FUNC_EXIT_RC(rc);
+	}
+
+	/* an unset packet timeout falls back to the command timeout */
+	timeout_ms = pClient->clientData.packetTimeoutMs;
+	if(0 == timeout_ms) {
+		timeout_ms = pClient->clientData.commandTimeoutMs;
+	}
+	init_timer(&packetTimer);
+	chunk = 0;
+	for(payload_off = 0; payload_off < payload_len; payload_off += chunk) {
+		chunk = pClient->clientData.readBufSize - base;
+		if(chunk > payload_len - payload_off) {
+			chunk = payload_len - payload_off;
+		}
+		/* every piece reuses the buffer space behind the variable header */
+		pClient->clientData.readBufIndex = base;
+		countdown_ms(&packetTimer, timeout_ms);
+		read_len = 0;
+		rc = _aws_iot_mqtt_internal_readWrapper(pClient, base, chunk, &packetTimer, &read_len);
+		if(SUCCESS != rc || chunk != read_len) {
+			break;
+		}
+		msg.payload = &pReadBuf[base];
+		msg.payloadLen = chunk;
+		_aws_iot_mqtt_internal_stream_event(pClient, pTopicName, topicNameLen, MQTT_STREAM_DATA, payload_off,
+											payload_len, &msg);
+	}
+
+	msg.payload = NULL;
+	msg.payloadLen = 0;
+	if(payload_off < payload_len) {
+		/* the connection is out of sync now, the caller's error leads to a disconnect */
+		_aws_iot_mqtt_internal_stream_event(pClient, pTopicName, topicNameLen, MQTT_STREAM_ABORT, payload_off,
+											payload_len, &msg);
+		aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
+		aws_iot_mqtt_internal_flushBuffers(pClient);
+		FUNC_EXIT_RC((SUCCESS == rc) ? FAILURE : rc);
+	}
+
+	_aws_iot_mqtt_internal_stream_event(pClient, pTopicName, topicNameLen, MQTT_STREAM_END, payload_len,
+										payload_len, &msg);
+	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
+	aws_iot_mqtt_internal_flushBuffers(pClient);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	if(QOS0 != msg.qos) {
+		/* Message assumed to be QoS1 since we do not support QoS2 at this time */
+		len = 0;
+		rc = aws_iot_mqtt_internal_serialize_ack(pClient->clientData.writeBuf, pClient->clientData.writeBufSize,
+												 PUBACK, 0, msg.id, &len);
+		if(SUCCESS != rc) {
+			FUNC_EXIT_RC(rc);
+		}
+
+		countdown_ms(&packetTimer, pClient->clientData.commandTimeoutMs);
+		rc = aws_iot_mqtt_internal_send_packet(pClient, len, &packetTimer);
+		if(SUCCESS != rc) {
+			FUNC_EXIT_RC(rc);
+		}
+	}
+
+	FUNC_EXIT_RC(MQTT_PUBLISH_STREAMED);
+}
+
 IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTimer, uint8_t *pPacketType) {
 	IoT_Error_t rc;
 
@@ -601,7 +792,7 @@ IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTi
 
 #ifdef _ENABLE_THREAD_SUPPORT_
 	threadRc = aws_iot_mqtt_client_unlock_mutex(pClient, &(pClient->clientData.tls_read_mutex));
-	if(SUCCESS != threadRc && (MQTT_NOTHING_TO_READ == rc || SUCCESS == rc)) {
+	if(SUCCESS != threadRc && (MQTT_NOTHING_TO_READ == rc || MQTT_PUBLISH_STREAMED == rc || SUCCESS == rc)) {
 		return threadRc;
 	}
 #endif
@@ -609,6 +800,9 @@ IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTi
 	if(MQTT_NOTHING_TO_READ == rc) {
 		/* Nothing to read, not a cycle failure */
 		return SUCCESS;
+	} else if(MQTT_PUBLISH_STREAMED == rc) {
+		/* Publish already delivered and acknowledged while reading */
+		return SUCCESS;
 	} else if(SUCCESS != rc) {
 		return rc;
 	}
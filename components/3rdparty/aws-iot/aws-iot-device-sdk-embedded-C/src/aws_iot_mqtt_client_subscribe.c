@@ -199,6 +199,7 @@ static uint32_t _aws_iot_mqtt_get_free_message_handler_index(AWS_IoT_Client *pCl
  *     no malloc are performed by the SDK
  * @param topicNameLen Length of the topic name
  * @param pApplicationHandler_t Reference to the handler function for this subscription
+ * @param pStreamHandler Reference to the stream handler function, NULL for a plain subscription
  * @param pApplicationHandlerData Point to data passed to the callback. 
  *    pApplicationHandlerData also needs to be static in memory  since no malloc are performed by the SDK
  *
@@ -207,6 +208,7 @@ static uint32_t _aws_iot_mqtt_get_free_message_handler_index(AWS_IoT_Client *pCl
 static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, const char *pTopicName,
 													uint16_t topicNameLen, QoS qos,
 													pApplicationHandler_t pApplicationHandler,
+													pStreamHandler_t pStreamHandler,
 													void *pApplicationHandlerData) {
 	uint16_t txPacketId, rxPacketId;
 	uint32_t serializedLen, indexOfFreeMessageHandler, count;
@@ -266,6 +268,8 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
 			topicNameLen;
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].pApplicationHandler =
 			pApplicationHandler;
+	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].pStreamHandler =
+			pStreamHandler;
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].pApplicationHandlerData =
 			pApplicationHandlerData;
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].qos = qos;
@@ -273,6 +277,47 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
 	FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Validate and perform a subscribe with either kind of handler.
+ *
+ * Shared by the plain and the stream subscribe API. Responsible for the validations
+ * and the client state changes around the internal subscribe above.
+ *
+ * @return An IoT Error Type defining successful/failed subscription
+ */
+static IoT_Error_t _aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+										   QoS qos, pApplicationHandler_t pApplicationHandler,
+										   pStreamHandler_t pStreamHandler, void *pApplicationHandlerData) {
+	ClientState clientState;
+	IoT_Error_t rc, subRc;
+
+	FUNC_ENTRY;
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
+	}
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	if(CLIENT_STATE_CONNECTED_IDLE != clientState && CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN != clientState) {
+		FUNC_EXIT_RC(MQTT_CLIENT_NOT_IDLE_ERROR);
+	}
+
+	rc = aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_SUBSCRIBE_IN_PROGRESS);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	subRc = _aws_iot_mqtt_internal_subscribe(pClient, pTopicName, topicNameLen, qos,
+											 pApplicationHandler, pStreamHandler, pApplicationHandlerData);
+
+	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_SUBSCRIBE_IN_PROGRESS, clientState);
+	if(SUCCESS == subRc && SUCCESS != rc) {
+		subRc = rc;
+	}
+
+	FUNC_EXIT_RC(subRc);
+}
+
 /**
  * @brief Subscribe to an MQTT topic.
  *
@@ -295,8 +340,7 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
  */
 IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
 								   QoS qos, pApplicationHandler_t pApplicationHandler, void *pApplicationHandlerData) {
-	ClientState clientState;
-	IoT_Error_t rc, subRc;
+	IoT_Error_t rc;
 
 	FUNC_ENTRY;
 
@@ -304,29 +348,45 @@ IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicNa
 		FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	if(!aws_iot_mqtt_is_client_connected(pClient)) {
-		FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
-	}
+	rc = _aws_iot_mqtt_subscribe(pClient, pTopicName, topicNameLen, qos,
+								 pApplicationHandler, NULL, pApplicationHandlerData);
 
-	clientState = aws_iot_mqtt_get_client_state(pClient);
-	if(CLIENT_STATE_CONNECTED_IDLE != clientState && CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN != clientState) {
-		FUNC_EXIT_RC(MQTT_CLIENT_NOT_IDLE_ERROR);
-	}
+	FUNC_EXIT_RC(rc);
+}
 
-	rc = aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_SUBSCRIBE_IN_PROGRESS);
-	if(SUCCESS != rc) {
-		FUNC_EXIT_RC(rc);
-	}
+/**
+ * @brief Subscribe to an MQTT topic, receiving the payloads in chunks.
+ *
+ * Called to send a subscribe message to the broker requesting a subscription
+ * to an MQTT topic. Publishes on the topic are passed to pStreamHandler, also
+ * those that do not fit in the read buffer.
+ * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet.
+ * @warning pTopicName and pApplicationHandlerData need to be static in memory.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to subscribe to. pTopicName needs to be static in memory since
+ *     no malloc are performed by the SDK
+ * @param topicNameLen Length of the topic name
+ * @param pStreamHandler Reference to the stream handler function for this subscription
+ * @param pApplicationHandlerData Point to data passed to the callback.
+ *    pApplicationHandlerData also needs to be static in memory  since no malloc are performed by the SDK
+ *
+ * @return An IoT Error Type defining successful/failed subscription
+ */
+IoT_Error_t aws_iot_mqtt_subscribe_stream(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+										  QoS qos, pStreamHandler_t pStreamHandler, void *pApplicationHandlerData) {
+	IoT_Error_t rc;
 
-	subRc = _aws_iot_mqtt_internal_subscribe(pClient, pTopicName, topicNameLen, qos,
-											 pApplicationHandler, pApplicationHandlerData);
+	FUNC_ENTRY;
 
-	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_SUBSCRIBE_IN_PROGRESS, clientState);
-	if(SUCCESS == subRc && SUCCESS != rc) {
-		subRc = rc;
+	if(NULL == pClient || NULL == pTopicName || NULL == pStreamHandler) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	FUNC_EXIT_RC(subRc);
+	rc = _aws_iot_mqtt_subscribe(pClient, pTopicName, topicNameLen, qos,
+								 NULL, pStreamHandler, pApplicationHandlerData);
+
+	FUNC_EXIT_RC(rc);
 }
 
 /**
@@ -32,3 +32,7 @@ TEST_GROUP_C_WRAPPER(CommonTests, NullClientSetAutoreconnect)
 TEST_GROUP_C_WRAPPER(CommonTests, UnexpectedAckFiltering)
 TEST_GROUP_C_WRAPPER(CommonTests, BigMQTTRxMessageIgnore)
 TEST_GROUP_C_WRAPPER(CommonTests, BigMQTTRxMessageReadNextMessage)
+TEST_GROUP_C_WRAPPER(CommonTests, BigMQTTRxMessageStreamQoS1)
+TEST_GROUP_C_WRAPPER(CommonTests, BigMQTTRxMessageStreamQoS0)
+TEST_GROUP_C_WRAPPER(CommonTests, SmallMQTTRxMessageStream)
+TEST_GROUP_C_WRAPPER(CommonTests, BigMQTTRxMessageStreamAbort)
@@ -25,6 +25,7 @@
 #include "aws_iot_mqtt_client_interface.h"
 #include "aws_iot_log.h"
 #include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
 
 static IoT_Client_Init_Params initParams;
 static IoT_Client_Connect_Params connectParams;
@@ -52,6 +53,70 @@ static void iot_tests_unit_common_subscribe_callback_handler(AWS_IoT_Client *pCl
 	}
 }
 
+#define STREAM_TEST_PAYLOAD_LEN 1500
+
+static char streamPayload[STREAM_TEST_PAYLOAD_LEN + 1];
+static char streamBuffer[STREAM_TEST_PAYLOAD_LEN + 2];
+static size_t streamNextOffset;
+static size_t streamTotalLen;
+static uint32_t streamEvents[MQTT_STREAM_ABORT + 1];
+static uint16_t streamPacketId;
+static unsigned char streamPubackBeforeEnd;
+static unsigned char streamOffsetError;
+
+static void iot_tests_unit_common_stream_callback_handler(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+														  IoT_Stream_Event event, size_t offset, size_t totalLen,
+														  IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pData);
+
+	if(16 != topicNameLen || 0 != strncmp("limitTest/topic1", topicName, topicNameLen)) {
+		streamOffsetError = 1;
+	}
+	streamEvents[event]++;
+	switch(event) {
+		case MQTT_STREAM_BEGIN:
+			streamNextOffset = 0;
+			streamTotalLen = totalLen;
+			streamPacketId = params->id;
+			break;
+		case MQTT_STREAM_DATA:
+			/* chunks have to arrive in order and without gaps */
+			if(offset != streamNextOffset || totalLen != streamTotalLen || offset + params->payloadLen > totalLen
+			   || offset + params->payloadLen > sizeof(streamBuffer)) {
+				streamOffsetError = 1;
+				break;
+			}
+			memcpy(&streamBuffer[offset], params->payload, params->payloadLen);
+			streamNextOffset += params->payloadLen;
+			break;
+		case MQTT_STREAM_END:
+			if(offset != streamNextOffset || offset != totalLen) {
+				streamOffsetError = 1;
+			}
+			streamPubackBeforeEnd = isLastTLSTxMessagePuback();
+			break;
+		default:
+			break;
+	}
+}
+
+static void iot_tests_unit_common_stream_reset(void) {
+	uint32_t i;
+
+	for(i = 0; i < STREAM_TEST_PAYLOAD_LEN; i++) {
+		streamPayload[i] = (char) ('a' + (i % 26));
+	}
+	streamPayload[STREAM_TEST_PAYLOAD_LEN] = '\0';
+	memset(streamBuffer, 0, sizeof(streamBuffer));
+	memset(streamEvents, 0, sizeof(streamEvents));
+	streamNextOffset = 0;
+	streamTotalLen = 0;
+	streamPacketId = 0;
+	streamPubackBeforeEnd = 0;
+	streamOffsetError = 0;
+}
+
 TEST_GROUP_C_SETUP(CommonTests) {
 	ResetTLSBuffer();
 	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, NULL);
@@ -184,3 +249,126 @@ TEST_C(CommonTests, BigMQTTRxMessageReadNextMessage) {
 	CHECK_EQUAL_C_INT(rc, SUCCESS);
 	CHECK_EQUAL_C_STRING("XXX", cbBuffer);
 }
+
+/**
+ * A publish larger than the read buffer on a stream subscription is passed to the handler in
+ * ordered chunks instead of being dropped, and the QoS1 PUBACK follows the END event.
+ */
+TEST_C(CommonTests, BigMQTTRxMessageStreamQoS1) {
+	IoT_Error_t rc = FAILURE;
+
+	IOT_DEBUG("\n-->Running CommonTests - Stream Large Incoming QoS1 Message \n");
+
+	iot_tests_unit_common_stream_reset();
+	setTLSRxBufferForSuback("limitTest/topic1", 16, QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe_stream(&iotClient, "limitTest/topic1", 16, QOS1,
+									   iot_tests_unit_common_stream_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	testPubMsgParams.qos = QOS1;
+	setTLSRxBufferWithMsgOnSubscribedTopic("limitTest/topic1", 16, QOS1, testPubMsgParams, streamPayload);
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_BEGIN]);
+	CHECK_C(1 < streamEvents[MQTT_STREAM_DATA]);
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_END]);
+	CHECK_EQUAL_C_INT(0, streamEvents[MQTT_STREAM_ABORT]);
+	CHECK_EQUAL_C_INT(0, streamOffsetError);
+	CHECK_EQUAL_C_INT(STREAM_TEST_PAYLOAD_LEN + 1, streamTotalLen);
+	CHECK_EQUAL_C_STRING(streamPayload, streamBuffer);
+	CHECK_EQUAL_C_INT(0x0203, streamPacketId);
+	CHECK_EQUAL_C_INT(0, streamPubackBeforeEnd);
+	CHECK_EQUAL_C_INT(1, isLastTLSTxMessagePuback());
+	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_IDLE, aws_iot_mqtt_get_client_state(&iotClient));
+}
+
+/**
+ * A QoS0 publish is streamed the same way, without a PUBACK.
+ */
+TEST_C(CommonTests, BigMQTTRxMessageStreamQoS0) {
+	IoT_Error_t rc = FAILURE;
+
+	IOT_DEBUG("\n-->Running CommonTests - Stream Large Incoming QoS0 Message \n");
+
+	iot_tests_unit_common_stream_reset();
+	setTLSRxBufferForSuback("limitTest/topic1", 16, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe_stream(&iotClient, "limitTest/topic1", 16, QOS0,
+									   iot_tests_unit_common_stream_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	testPubMsgParams.qos = QOS0;
+	setTLSRxBufferWithMsgOnSubscribedTopic("limitTest/topic1", 16, QOS0, testPubMsgParams, streamPayload);
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_BEGIN]);
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_END]);
+	CHECK_EQUAL_C_INT(0, streamOffsetError);
+	CHECK_EQUAL_C_STRING(streamPayload, streamBuffer);
+	CHECK_EQUAL_C_INT(0, isLastTLSTxMessagePuback());
+
+	/* the connection stays in sync for the next packet */
+	iot_tests_unit_common_stream_reset();
+	streamPayload[3] = '\0';
+	setTLSRxBufferWithMsgOnSubscribedTopic("limitTest/topic1", 16, QOS0, testPubMsgParams, streamPayload);
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING("abc", streamBuffer);
+}
+
+/**
+ * A publish that fits in the read buffer reaches a stream subscription as a single chunk.
+ */
+TEST_C(CommonTests, SmallMQTTRxMessageStream) {
+	IoT_Error_t rc = FAILURE;
+
+	IOT_DEBUG("\n-->Running CommonTests - Stream Small Incoming Message \n");
+
+	iot_tests_unit_common_stream_reset();
+	setTLSRxBufferForSuback("limitTest/topic1", 16, QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe_stream(&iotClient, "limitTest/topic1", 16, QOS1,
+									   iot_tests_unit_common_stream_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	streamPayload[10] = '\0';
+	testPubMsgParams.qos = QOS1;
+	setTLSRxBufferWithMsgOnSubscribedTopic("limitTest/topic1", 16, QOS1, testPubMsgParams, streamPayload);
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_BEGIN]);
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_DATA]);
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_END]);
+	CHECK_EQUAL_C_INT(0, streamOffsetError);
+	CHECK_EQUAL_C_INT(11, streamTotalLen);
+	CHECK_EQUAL_C_STRING("abcdefghij", streamBuffer);
+	CHECK_EQUAL_C_INT(1, isLastTLSTxMessagePuback());
+}
+
+/**
+ * A publish cut off in the middle of the payload ends with ABORT and is not acknowledged.
+ */
+TEST_C(CommonTests, BigMQTTRxMessageStreamAbort) {
+	IoT_Error_t rc = FAILURE;
+
+	IOT_DEBUG("\n-->Running CommonTests - Abort Stream of Truncated Message \n");
+
+	iot_tests_unit_common_stream_reset();
+	setTLSRxBufferForSuback("limitTest/topic1", 16, QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe_stream(&iotClient, "limitTest/topic1", 16, QOS1,
+									   iot_tests_unit_common_stream_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	testPubMsgParams.qos = QOS1;
+	setTLSRxBufferWithMsgOnSubscribedTopic("limitTest/topic1", 16, QOS1, testPubMsgParams, streamPayload);
+	RxBuffer.len = AWS_IOT_MQTT_RX_BUF_LEN + 100;
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_C(SUCCESS != rc);
+
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_BEGIN]);
+	CHECK_EQUAL_C_INT(0, streamEvents[MQTT_STREAM_END]);
+	CHECK_EQUAL_C_INT(1, streamEvents[MQTT_STREAM_ABORT]);
+	CHECK_EQUAL_C_INT(0, streamOffsetError);
+	CHECK_EQUAL_C_INT(0, isLastTLSTxMessagePuback());
+}
@@ -847,6 +847,40 @@ int vsprintf(char *buffer, const char *format, va_list ap)
 
 extern volatile bool sys_log_all_enable;
 
+#ifdef CFG_COREDUMP
+/* the last console output, for the crash record */
+#define LOG_TAIL_SIZE 512   /* power of 2 */
+static char log_tail[LOG_TAIL_SIZE];
+static uint32_t log_tail_pos;
+
+static inline void log_tail_put(char c)
+{
+    log_tail[log_tail_pos++ & (LOG_TAIL_SIZE - 1)] = c;
+}
+
+/* oldest part first, returns the bytes held */
+int bl_log_tail_get(const char **p1, int *l1, const char **p2, int *l2)
+{
+    uint32_t pos = log_tail_pos;
+    uint32_t start = pos & (LOG_TAIL_SIZE - 1);
+
+    if (pos < LOG_TAIL_SIZE) {
+        *p1 = log_tail;
+        *l1 = pos;
+        *p2 = NULL;
+        *l2 = 0;
+        return pos;
+    }
+    *p1 = log_tail + start;
+    *l1 = LOG_TAIL_SIZE - start;
+    *p2 = log_tail;
+    *l2 = start;
+    return LOG_TAIL_SIZE;
+}
+#else
+#define log_tail_put(c)
+#endif
+
 void vprint(const char *fmt, va_list argp)
 {
     char *str;
@@ -856,6 +890,7 @@ void vprint(const char *fmt, va_list argp)
         str = string;
         if (0 < vsprintf(string, fmt, argp)) {
             while ('\0' != (ch = *(str++))) {
+                log_tail_put(ch);
 #if !defined(DISABLE_PRINT)
                 bl_uart_data_send(0, ch);
 #endif
@@ -866,6 +901,7 @@ void vprint(const char *fmt, va_list argp)
 
 int bl_putchar(int c)
 {
+    log_tail_put(c);
 #if !defined(DISABLE_PRINT)
     bl_uart_data_send(0, c);
 #endif
@@ -879,6 +915,7 @@ int puts(const char *s)
 
     if (sys_log_all_enable) {
         while ('\0' != (c = *(s++))) {
+            log_tail_put(c);
 #if !defined(DISABLE_PRINT)
             bl_uart_data_send(0, c);
 #endif
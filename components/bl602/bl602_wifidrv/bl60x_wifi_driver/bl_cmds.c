@@ -39,124 +39,266 @@
 #define os_printf(...) do {} while(0)
 static void cmd_dump(const struct bl_cmd *cmd)
 {
+    (void)cmd;
     os_printf("tkn[%d]  flags:%04x  result:%3d  cmd:%4d-%-24s - reqcfm(%4d-%-s)\n",
            cmd->tkn, cmd->flags, cmd->result, cmd->id, RWNX_ID2STR(cmd->id),
            cmd->reqid, cmd->reqid != (lmac_msg_id_t)-1 ? RWNX_ID2STR(cmd->reqid) : "none");
 }
 
-static void cmd_complete(struct bl_cmd_mgr *cmd_mgr, struct bl_cmd *cmd)
+/* a full timer queue leaves it unarmed, the next push or expiry tries again */
+static void cmd_mgr_arm(struct bl_cmd_mgr *cmd_mgr, u32 ticks)
+{
+    cmd_mgr->timer_armed = !os_timer_restart(&cmd_mgr->timer, ticks);
+}
+
+static void cmd_push(struct bl_cmd_mgr *cmd_mgr, struct bl_cmd *cmd)
+{
+    struct bl_hw *bl_hw = container_of(cmd_mgr, struct bl_hw, cmd_mgr);
+
+    cmd->flags &= ~RWNX_CMD_FLAG_WAIT_PUSH;
+    cmd->push_tick = os_tick_get();
+    cmd_mgr->push_busy = 1;
+    if (!cmd_mgr->timer_armed) {
+        cmd_mgr_arm(cmd_mgr, RWNX_80211_CMD_TIMEOUT_MS);
+    }
+    ipc_host_msg_push(bl_hw->ipc_env, cmd, sizeof(struct lmac_msg) + cmd->a2e_msg->param_len);
+    os_free(cmd->a2e_msg);
+    cmd->a2e_msg = NULL;
+}
+
+/* push the oldest command not sent yet, the IPC takes one message per ACK */
+static void cmd_push_next(struct bl_cmd_mgr *cmd_mgr)
+{
+    struct bl_cmd *cur;
+
+    if (cmd_mgr->push_busy) {
+        return;
+    }
+    list_for_each_entry(cur, &cmd_mgr->cmds, list) {
+        if (cur->flags & RWNX_CMD_FLAG_WAIT_PUSH) {
+            cmd_push(cmd_mgr, cur);
+            break;
+        }
+    }
+}
+
+static void cmd_complete(struct bl_cmd_mgr *cmd_mgr, struct bl_cmd *cmd, u32 result)
 {
     os_printf("[CMDS] CMD complete: %p\r\n", cmd);
 
     cmd_mgr->queue_sz--;
     list_del(&cmd->list);
     cmd->flags |= RWNX_CMD_FLAG_DONE;
+    cmd->result = result;
+    if (0 == result) {
+        cmd_mgr->failed_recoveries = 0;
+    }
+    if (cmd->flags & RWNX_CMD_FLAG_WAIT_PUSH) {
+        os_free(cmd->a2e_msg);
+        cmd->a2e_msg = NULL;
+    }
     if (cmd->flags & RWNX_CMD_FLAG_NONBLOCK) {
         os_printf("[CMDS] NONBLOCK CMD, free now %p\r\n", cmd);
         os_free(cmd);
     } else {
-        if (RWNX_CMD_WAIT_COMPLETE(cmd->flags)) {
-            os_printf("[CMDS] BLOCK EVENT is ready, complete now %p\r\n", cmd);
-            cmd->result = 0;
-            os_event_send(&(cmd->complete), 0x1);
+        os_event_send(&cmd_mgr->complete, 1 << cmd->slot);
+    }
+}
+
+/*
+ * The firmware missed the ACK or CFM of a command. Whatever was sent before
+ * is given up on, so the IPC is resynchronized and the commands not sent yet
+ * go on. After RWNX_CMD_MAX_RECOVERY recoveries without any command completing
+ * the firmware is considered dead.
+ */
+static void cmd_mgr_recover(struct bl_cmd_mgr *cmd_mgr, struct bl_cmd *expired)
+{
+    struct bl_hw *bl_hw = container_of(cmd_mgr, struct bl_hw, cmd_mgr);
+    struct bl_cmd *cur, *nxt;
+    bool crashed;
+
+    cmd_dump(expired);
+    cmd_mgr->recoveries++;
+    crashed = (++cmd_mgr->failed_recoveries > RWNX_CMD_MAX_RECOVERY);
+    if (crashed) {
+        cmd_mgr->state = RWNX_CMD_MGR_STATE_CRASHED;
+    }
+
+    list_for_each_entry_safe(cur, nxt, &cmd_mgr->cmds, list) {
+        if (cur == expired) {
+            continue;
+        }
+        if (crashed || !(cur->flags & RWNX_CMD_FLAG_WAIT_PUSH)) {
+            cmd_complete(cmd_mgr, cur, EPIPE);
+        }
+    }
+    cmd_complete(cmd_mgr, expired, ETIMEDOUT);
+    /* failed_recoveries was reset if the expired command had a result */
+    if (crashed) {
+        cmd_mgr->failed_recoveries = RWNX_CMD_MAX_RECOVERY + 1;
+    }
+
+    if (cmd_mgr->push_busy) {
+        /* the ACK of the message given up on may still come, and the IPC
+         * would credit it to the next one, so the A2E buffer stays taken
+         * until it does or RWNX_CMD_RESYNC_GUARD_MS has passed */
+        ipc_host_msg_resync(bl_hw->ipc_env);
+        cmd_mgr->resync_wait = 1;
+        cmd_mgr->resync_tick = os_tick_get();
+    } else {
+        cmd_push_next(cmd_mgr);
+    }
+}
+
+/*
+ * Recover from the pushed commands that had no ACK or CFM within
+ * RWNX_80211_CMD_TIMEOUT_MS, blocking or not, and end the resync guard once
+ * it has passed. Runs on every queue(), when a waiter's wait runs out and
+ * from the timer, which is kept armed for the next deadline as nonblocking
+ * commands have no waiter.
+ *
+ * @return ticks until the next deadline
+ */
+static u32 cmd_mgr_expire(struct bl_cmd_mgr *cmd_mgr)
+{
+    struct bl_cmd *cur;
+    u32 now, age, wait;
+    bool watch;
+
+again:
+    now = os_tick_get();
+    wait = RWNX_80211_CMD_TIMEOUT_MS;
+    watch = cmd_mgr->resync_wait;
+    if (cmd_mgr->resync_wait) {
+        age = now - cmd_mgr->resync_tick;
+        if (age < RWNX_CMD_RESYNC_GUARD_MS) {
+            wait = RWNX_CMD_RESYNC_GUARD_MS - age;
+        } else {
+            /* that ACK is lost as well */
+            cmd_mgr->resync_wait = 0;
+            cmd_mgr->push_busy = 0;
+            cmd_push_next(cmd_mgr);
+        }
+    }
+    list_for_each_entry(cur, &cmd_mgr->cmds, list) {
+        if (cur->flags & RWNX_CMD_FLAG_WAIT_PUSH) {
+            continue;
+        }
+        age = now - cur->push_tick;
+        if (age >= RWNX_80211_CMD_TIMEOUT_MS) {
+            /* completes every pushed command */
+            cmd_mgr_recover(cmd_mgr, cur);
+            goto again;
+        }
+        if (RWNX_80211_CMD_TIMEOUT_MS - age < wait) {
+            wait = RWNX_80211_CMD_TIMEOUT_MS - age;
         }
+        watch = true;
     }
+
+    if (watch) {
+        cmd_mgr_arm(cmd_mgr, wait);
+    }
+    return wait;
+}
+
+static void cmd_mgr_timeout(timer_cb_arg_t data)
+{
+    struct bl_cmd_mgr *cmd_mgr = os_timer_data(data);
+
+    /* the timer task runs every timer, it does not wait on the lock. If
+     * even the retry cannot be queued the next queue() arms it again */
+    if (os_mutex_trytake(cmd_mgr->lock)) {
+        os_timer_restart(&cmd_mgr->timer, RWNX_CMD_TIMER_RETRY_MS);
+        return;
+    }
+    cmd_mgr->timer_armed = 0;
+    cmd_mgr_expire(cmd_mgr);
+    os_mutex_give(cmd_mgr->lock);
+}
+
+static int cmd_slot_alloc(struct bl_cmd_mgr *cmd_mgr)
+{
+    int slot;
+
+    for (slot = 0; slot < RWNX_CMD_MAX_SLOTS; slot++) {
+        if (!(cmd_mgr->slots & (1 << slot))) {
+            cmd_mgr->slots |= (1 << slot);
+            return slot;
+        }
+    }
+    return -1;
 }
 
 static int cmd_mgr_queue(struct bl_cmd_mgr *cmd_mgr, struct bl_cmd *cmd)
 {
-    struct bl_hw *bl_hw = container_of(cmd_mgr, struct bl_hw, cmd_mgr);
-    struct bl_cmd *last;
-    unsigned long tout;
-    bool defer_push = false;
-    uint32_t e;
+    u32 wait, e;
+    int slot = -1, ret;
 
     RWNX_DBG(RWNX_FN_ENTRY_STR);
 
     os_mutex_take(cmd_mgr->lock, OS_WAITING_FOREVER);
+    cmd_mgr_expire(cmd_mgr);
 
     if (cmd_mgr->state == RWNX_CMD_MGR_STATE_CRASHED) {
-        os_printf("cmd queue crashed\r\n");
         cmd->result = EPIPE;
-        RWNX_DBG(RWNX_FN_LEAVE_STR);
-        os_mutex_give(cmd_mgr->lock);
-        return -EPIPE;
+    } else if (cmd_mgr->queue_sz >= cmd_mgr->max_queue_sz ||
+            (!(cmd->flags & RWNX_CMD_FLAG_NONBLOCK) && (slot = cmd_slot_alloc(cmd_mgr)) < 0)) {
+        os_printf("Too many cmds (%d) already queued\r\n", cmd_mgr->max_queue_sz);
+        cmd->result = ENOMEM;
+    } else {
+        cmd->result = 0;
     }
-
-    if (!list_empty(&cmd_mgr->cmds)) {
-        if (cmd_mgr->queue_sz == cmd_mgr->max_queue_sz) {
-            os_printf("Too many cmds (%d) already queued\r\n",
-                   cmd_mgr->max_queue_sz);
-            cmd->result = ENOMEM;
-            RWNX_DBG(RWNX_FN_LEAVE_STR);
-            os_mutex_give(cmd_mgr->lock);
-            return -ENOMEM;
-        }
-        last = list_entry(cmd_mgr->cmds.prev, struct bl_cmd, list);
-        //FIXME comment out the following code block, since it is buggy
-#if 1
-        if (last->flags & (RWNX_CMD_FLAG_WAIT_ACK | RWNX_CMD_FLAG_WAIT_PUSH)) {
-#if 0 // queue even NONBLOCK command.
-            if (cmd->flags & RWNX_CMD_FLAG_NONBLOCK) {
-                printk(KERN_CRIT"cmd queue busy\n");
-                cmd->result = -EBUSY;
-                spin_unlock_bh(&cmd_mgr->lock);
-                RWNX_DBG(RWNX_FN_LEAVE_STR);
-                return -EBUSY;
-            }
-#endif
-            cmd->flags |= RWNX_CMD_FLAG_WAIT_PUSH;
-            defer_push = true;
-        }
-#endif
+    if (cmd->result) {
+        ret = -cmd->result;
+        os_mutex_give(cmd_mgr->lock);
+        os_free(cmd->a2e_msg);
+        cmd->a2e_msg = NULL;
+        RWNX_DBG(RWNX_FN_LEAVE_STR);
+        return ret;
     }
 
-    cmd->flags |= RWNX_CMD_FLAG_WAIT_ACK;
+    cmd->flags |= RWNX_CMD_FLAG_WAIT_ACK | RWNX_CMD_FLAG_WAIT_PUSH;
     if (cmd->flags & RWNX_CMD_FLAG_REQ_CFM)
         cmd->flags |= RWNX_CMD_FLAG_WAIT_CFM;
 
     cmd->tkn    = cmd_mgr->next_tkn++;
     cmd->result = EINTR;
-
-    if (!(cmd->flags & RWNX_CMD_FLAG_NONBLOCK)) {
-        os_event_init(&(cmd->complete));
-    }
-
+    cmd->slot   = slot;
 
     list_add_tail(&cmd->list, &cmd_mgr->cmds);
     cmd_mgr->queue_sz++;
-    tout = (RWNX_80211_CMD_TIMEOUT_MS * cmd_mgr->queue_sz);//TODO FIXME better timeout
-    os_mutex_give(cmd_mgr->lock);
+    cmd_push_next(cmd_mgr);
 
-    if (!defer_push) {
-        os_printf("pushing CMD, param_len is %d...\r\n", cmd->a2e_msg->param_len);
-        ipc_host_msg_push(bl_hw->ipc_env, cmd, sizeof(struct lmac_msg) + cmd->a2e_msg->param_len);
-        os_free(cmd->a2e_msg);
+    if (cmd->flags & RWNX_CMD_FLAG_NONBLOCK) {
+        /* cmd belongs to the manager now and may already be freed */
+        os_mutex_give(cmd_mgr->lock);
+        RWNX_DBG(RWNX_FN_LEAVE_STR);
+        return 0;
     }
 
-    if (!(cmd->flags & RWNX_CMD_FLAG_NONBLOCK)) {
-        os_printf("Waiting ACK...\r\n");
-        os_event_recv(&(cmd->complete), ((1 << 0)), tout, e);
-        if (e & (1 << 0)) {
-            os_printf("cmd OK\r\n");
-        } else {
-            os_printf("cmd timed-out\r\n");
-            cmd_dump(cmd);
-            os_mutex_take(cmd_mgr->lock, OS_WAITING_FOREVER);
-            cmd_mgr->state = RWNX_CMD_MGR_STATE_CRASHED;
-            if (!(cmd->flags & RWNX_CMD_FLAG_DONE)) {
-                cmd->result = ETIMEDOUT;
-                cmd_complete(cmd_mgr, cmd);
-            }
-            os_mutex_give(cmd_mgr->lock);
+    /* the timeout runs from the push, a command waiting behind others is
+     * covered by the timeouts of those, nonblocking ones included */
+    while (1) {
+        wait = cmd_mgr_expire(cmd_mgr);
+        if (cmd->flags & RWNX_CMD_FLAG_DONE) {
+            break;
+        }
+        os_mutex_give(cmd_mgr->lock);
+        os_event_recv(&cmd_mgr->complete, 1 << slot, wait, e);
+        os_mutex_take(cmd_mgr->lock, OS_WAITING_FOREVER);
+        if (e & (1 << slot)) {
+            break;
         }
-        os_event_delete((EventGroupHandle_t)&(cmd->complete));//detach after block read
-    } else {
-        os_printf("No need to wait for CMD\r\n");
-        cmd->result = 0;
     }
+    /* the bit may have been set after the wait gave up */
+    os_event_clear(&cmd_mgr->complete, 1 << slot);
+    cmd_mgr->slots &= ~(1 << slot);
+    ret = -cmd->result;
+    os_mutex_give(cmd_mgr->lock);
+
     RWNX_DBG(RWNX_FN_LEAVE_STR);
-    return 0;
+    return ret;
 }
 
 static void cmd_mgr_print(struct bl_cmd_mgr *cmd_mgr)
@@ -182,60 +324,53 @@ static void cmd_mgr_drain(struct bl_cmd_mgr *cmd_mgr)
 
     os_mutex_take(cmd_mgr->lock, OS_WAITING_FOREVER);
     list_for_each_entry_safe(cur, nxt, &cmd_mgr->cmds, list) {
-        list_del(&cur->list);
-        cmd_mgr->queue_sz--;
-        if (!(cur->flags & RWNX_CMD_FLAG_NONBLOCK)) {
-            os_event_send(&(cur->complete), 0x1);
-        }
+        cmd_complete(cmd_mgr, cur, EINTR);
+    }
+    /* nothing is pushed or waited for any more */
+    cmd_mgr->push_busy = 0;
+    cmd_mgr->resync_wait = 0;
+    if (cmd_mgr->timer_armed) {
+        /* a stop that does not get through only runs an idle expiry */
+        os_timer_stop(&cmd_mgr->timer);
+        cmd_mgr->timer_armed = 0;
     }
     os_mutex_give(cmd_mgr->lock);
 }
 
 static int cmd_mgr_llind(struct bl_cmd_mgr *cmd_mgr, struct bl_cmd *cmd)
 {
-    struct bl_cmd *cur, *acked = NULL, *next = NULL;
+    struct bl_cmd *cur, *acked = NULL;
 
     RWNX_DBG(RWNX_FN_ENTRY_STR);
 
     os_mutex_take(cmd_mgr->lock, OS_WAITING_FOREVER);
+    if (!cmd) {
+        /* late ACK of the message cmd_mgr_recover() gave up on */
+        cmd_mgr->resync_wait = 0;
+        cmd_mgr->push_busy = 0;
+        cmd_push_next(cmd_mgr);
+        os_mutex_give(cmd_mgr->lock);
+        return 0;
+    }
     list_for_each_entry(cur, &cmd_mgr->cmds, list) {
-        os_printf("Search cmds list cmd %p vs cur %p...\r\n", cmd, cur);
-        if (!acked) {
-            os_printf("Finding acked...\r\n");
-            if (cur->tkn == cmd->tkn) {
-                os_printf("Found acked\r\n");
-                if (WARN_ON_ONCE(cur != cmd)) {
-                    cmd_dump(cmd);
-                }
-                acked = cur;
-                continue;
+        if (cur->tkn == cmd->tkn) {
+            if (WARN_ON_ONCE(cur != cmd)) {
+                cmd_dump(cmd);
             }
-        }
-        if (cur->flags & RWNX_CMD_FLAG_WAIT_PUSH) {
-                os_printf("Found WAIT_PUSH\r\n");
-                next = cur;
-                break;
+            acked = cur;
+            break;
         }
     }
     if (!acked) {
         os_printf("Error: acked cmd not found\r\n");
     } else {
-        cmd->flags &= ~RWNX_CMD_FLAG_WAIT_ACK;
-        if (RWNX_CMD_WAIT_COMPLETE(cmd->flags)) {
-            os_printf("[BUG] should cmd complete allowed here?\r\n");//FIXME attention
-            cmd_complete(cmd_mgr, cmd);// XXX potential buggy
-        } else {
-            os_printf("[IPC] Wait Until ACKED for cmd %p, flags %08X\r\n", cmd, cmd->flags);
+        acked->flags &= ~RWNX_CMD_FLAG_WAIT_ACK;
+        if (RWNX_CMD_WAIT_COMPLETE(acked->flags)) {
+            cmd_complete(cmd_mgr, acked, 0);
         }
     }
-    if (next) {
-        struct bl_hw *bl_hw = container_of(cmd_mgr, struct bl_hw, cmd_mgr);
-        next->flags &= ~RWNX_CMD_FLAG_WAIT_PUSH;
-        os_printf("Pushing new CMD in llind...\r\n");
-        ipc_host_msg_push(bl_hw->ipc_env, next,
-                          sizeof(struct lmac_msg) + next->a2e_msg->param_len);
-        os_free(next->a2e_msg);
-    }
+    cmd_mgr->push_busy = 0;
+    cmd_push_next(cmd_mgr);
     os_mutex_give(cmd_mgr->lock);
 
     return 0;
@@ -274,7 +409,7 @@ static int cmd_mgr_msgind(struct bl_cmd_mgr *cmd_mgr, struct ipc_e2a_msg *msg, m
                 }
 
                 if (RWNX_CMD_WAIT_COMPLETE(cmd->flags)) {
-                    cmd_complete(cmd_mgr, cmd);
+                    cmd_complete(cmd_mgr, cmd, 0);
                 }
 
                 break;
@@ -298,6 +433,9 @@ void bl_cmd_mgr_init(struct bl_cmd_mgr *cmd_mgr)
     INIT_LIST_HEAD(&cmd_mgr->cmds);
     cmd_mgr->lock = os_mutex_create("wifi_cmd_lock");
     ASSERT_ERR(NULL != cmd_mgr->lock);
+    os_event_init(&cmd_mgr->complete);
+    os_timer_init(&cmd_mgr->timer, "wifi_cmd_timer", cmd_mgr_timeout, cmd_mgr,
+            RWNX_80211_CMD_TIMEOUT_MS, OS_TIMER_TYPE_ONESHOT);
 
     cmd_mgr->max_queue_sz = RWNX_CMD_MAX_QUEUED;
     cmd_mgr->queue  = &cmd_mgr_queue;
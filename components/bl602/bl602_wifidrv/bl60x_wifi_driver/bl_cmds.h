@@ -70,6 +70,17 @@ struct bl_cmd;
 typedef int (*msg_cb_fct)(struct bl_hw *bl_hw, struct bl_cmd *cmd, struct ipc_e2a_msg *msg);
 
 #define RWNX_CMD_MAX_QUEUED         8
+/* completion bits of blocking commands, a bit stays taken until its waiter
+ * has run so there are more of them than queue entries */
+#define RWNX_CMD_MAX_SLOTS          (2 * RWNX_CMD_MAX_QUEUED)
+/* timeouts recovered from in a row before the manager gives up */
+#define RWNX_CMD_MAX_RECOVERY       3
+/* how long after a recovery the ACK of the message given up on may still
+ * come, nothing is pushed meanwhile */
+#define RWNX_CMD_RESYNC_GUARD_MS    100
+/* the timer does not wait for the manager lock, it comes back this much later */
+#define RWNX_CMD_TIMER_RETRY_MS     10
+
 struct bl_cmd {
     struct list_head list;
     lmac_msg_id_t id;
@@ -78,8 +89,9 @@ struct bl_cmd {
     char            *e2a_msg;
     u32 tkn;
     u16 flags;
+    u8 slot;
+    u32 push_tick;
 
-    os_event_t complete;
     u32 result;
 };
 
@@ -98,6 +110,20 @@ struct bl_cmd_mgr {
     struct list_head cmds;
     os_mutex_t lock;
 
+    /* one bit per blocking command, set on completion */
+    os_event_t complete;
+    u32 slots;
+    /* a pushed command waits for its ACK, the IPC has a single A2E buffer */
+    u8 push_busy;
+    /* push_busy is held for the ACK of a message given up on */
+    u8 resync_wait;
+    u8 failed_recoveries;
+    u32 resync_tick;
+    /* runs to the next deadline while a command is pushed */
+    os_timer_t timer;
+    u8 timer_armed;
+    u32 recoveries;
+
     int  (*queue)(struct bl_cmd_mgr *, struct bl_cmd *);
     int  (*llind)(struct bl_cmd_mgr *, struct bl_cmd *);
     int  (*msgind)(struct bl_cmd_mgr *, struct ipc_e2a_msg *, msg_cb_fct);
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include "bl_ie.h"
+
+#define IE_ID_SSID              0
+#define IE_ID_DS                3
+#define IE_ID_COUNTRY           7
+#define IE_ID_HT_CAP            45
+#define IE_ID_RSN               48
+#define IE_ID_HT_OP             61
+#define IE_ID_VHT_CAP           191
+#define IE_ID_VHT_OP            192
+#define IE_ID_VENDOR            221
+
+/* element id to slot + 1, 0 for elements that are not recorded */
+#define IE_SLOT_VENDOR          0xFF
+
+static const uint8_t ie_slot_of_id[256] = {
+    [IE_ID_SSID]        = BL_IE_SSID + 1,
+    [IE_ID_DS]          = BL_IE_DS + 1,
+    [IE_ID_COUNTRY]     = BL_IE_COUNTRY + 1,
+    [IE_ID_HT_CAP]      = BL_IE_HT_CAP + 1,
+    [IE_ID_RSN]         = BL_IE_RSN + 1,
+    [IE_ID_HT_OP]       = BL_IE_HT_OP + 1,
+    [IE_ID_VHT_CAP]     = BL_IE_VHT_CAP + 1,
+    [IE_ID_VHT_OP]      = BL_IE_VHT_OP + 1,
+    [IE_ID_VENDOR]      = IE_SLOT_VENDOR,
+};
+
+static const uint8_t oui_wfa[3] = {0x00, 0x50, 0xF2};
+static const uint8_t oui_ieee[3] = {0x00, 0x0F, 0xAC};
+
+/* Microsoft/WFA vendor OUI type to slot + 1 */
+static const uint8_t ie_slot_of_wfa_type[5] = {
+    0, BL_IE_WPA + 1, BL_IE_WMM + 1, 0, BL_IE_WPS + 1,
+};
+
+/* suite selector type to BL_IE_CIPHER_*, same numbering for RSN and WPA */
+static const uint8_t cipher_of_type[6] = {
+    0, BL_IE_CIPHER_WEP40, BL_IE_CIPHER_TKIP, 0, BL_IE_CIPHER_CCMP, BL_IE_CIPHER_WEP104,
+};
+
+/* AKM suite type to BL_IE_AKM_* */
+static const uint8_t akm_of_type[9] = {
+    0, BL_IE_AKM_8021X, BL_IE_AKM_PSK, 0, 0, BL_IE_AKM_8021X, BL_IE_AKM_PSK, 0, BL_IE_AKM_SAE,
+};
+
+/**
+ * Walk the elements of a management frame body once and record where the
+ * elements of interest are. Every recorded element lies completely inside
+ * buf, a truncated last element is not recorded. Slots hold 16 bit offsets
+ * so that clearing the index is three stores, bodies are cut at 64 KiB.
+ *
+ * @return number of elements
+ */
+int bl_ie_parse(const uint8_t *buf, int len, struct bl_ie_index *idx)
+{
+    const uint8_t *end;
+    uint8_t slot;
+    int count = 0;
+
+    if (len > 0xFFFF) {
+        len = 0xFFFF;
+    }
+    end = buf + len;
+    idx->buf = buf;
+    memset(idx->off, 0, sizeof(idx->off));
+
+    while (end - buf >= 2) {
+        if (buf[1] > end - buf - 2) {
+            break;
+        }
+
+        slot = ie_slot_of_id[buf[0]];
+        if (slot == IE_SLOT_VENDOR) {
+            slot = 0;
+            if (buf[1] >= 4 && buf[2] == oui_wfa[0] && buf[3] == oui_wfa[1] &&
+                buf[4] == oui_wfa[2] && buf[5] < sizeof(ie_slot_of_wfa_type)) {
+                slot = ie_slot_of_wfa_type[buf[5]];
+            }
+        }
+        if (slot && !idx->off[slot - 1]) {
+            idx->off[slot - 1] = buf - idx->buf + 1;
+        }
+
+        buf += buf[1] + 2;
+        count++;
+    }
+
+    return count;
+}
+
+static uint8_t suite_lookup(const uint8_t *suite, const uint8_t *oui,
+        const uint8_t *table, int table_len)
+{
+    if (memcmp(suite, oui, 3) || suite[3] >= table_len) {
+        return 0;
+    }
+    return table[suite[3]];
+}
+
+/*
+ * Common body of RSN and WPA elements after the version: group cipher,
+ * pairwise cipher list, AKM list and RSN capabilities, each of them
+ * optional from the end. p/end bound the element body.
+ */
+static int parse_suites(const uint8_t *p, const uint8_t *end, const uint8_t *oui,
+        struct bl_ie_suites *suites)
+{
+    int count;
+
+    memset(suites, 0, sizeof(*suites));
+    if (end - p < 4) {
+        /* default group and pairwise cipher is CCMP for RSN, TKIP for WPA */
+        suites->group = suites->pairwise = (oui == oui_ieee) ? BL_IE_CIPHER_CCMP : BL_IE_CIPHER_TKIP;
+        return end == p ? 0 : -1;
+    }
+    suites->group = suite_lookup(p, oui, cipher_of_type, sizeof(cipher_of_type));
+    p += 4;
+
+    if (end - p < 2) {
+        suites->pairwise = (oui == oui_ieee) ? BL_IE_CIPHER_CCMP : BL_IE_CIPHER_TKIP;
+        return end == p ? 0 : -1;
+    }
+    count = p[0] | (p[1] << 8);
+    p += 2;
+    if (count > (end - p) / 4) {
+        return -1;
+    }
+    for (; count; count--, p += 4) {
+        suites->pairwise |= suite_lookup(p, oui, cipher_of_type, sizeof(cipher_of_type));
+    }
+
+    if (end - p < 2) {
+        return end == p ? 0 : -1;
+    }
+    count = p[0] | (p[1] << 8);
+    p += 2;
+    if (count > (end - p) / 4) {
+        return -1;
+    }
+    for (; count; count--, p += 4) {
+        suites->akm |= suite_lookup(p, oui, akm_of_type, sizeof(akm_of_type));
+    }
+
+    if (end - p >= 2) {
+        /* RSN capabilities, bit 6 is MFPR */
+        suites->mfp_required = (p[0] >> 6) & 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Parse an RSN element, ie points to the element id.
+ *
+ * @return 0 on success, -1 if the element is malformed
+ */
+int bl_ie_parse_rsn(const uint8_t *ie, struct bl_ie_suites *suites)
+{
+    const uint8_t *end = ie + 2 + ie[1];
+
+    /* version 1 */
+    if (ie[1] < 2 || ie[2] != 1 || ie[3] != 0) {
+        memset(suites, 0, sizeof(*suites));
+        return -1;
+    }
+    return parse_suites(ie + 4, end, oui_ieee, suites);
+}
+
+/**
+ * Parse a WPA vendor element, ie points to the element id.
+ *
+ * @return 0 on success, -1 if the element is malformed
+ */
+int bl_ie_parse_wpa(const uint8_t *ie, struct bl_ie_suites *suites)
+{
+    const uint8_t *end = ie + 2 + ie[1];
+
+    /* OUI, type and version 1 */
+    if (ie[1] < 6 || ie[6] != 1 || ie[7] != 0) {
+        memset(suites, 0, sizeof(*suites));
+        return -1;
+    }
+    return parse_suites(ie + 8, end, oui_wfa, suites);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_IE_H__
+#define __BL_IE_H__
+
+#include <stdint.h>
+
+/* Elements remembered by bl_ie_parse(), the first occurrence wins */
+enum bl_ie_slot {
+    BL_IE_SSID,
+    BL_IE_DS,
+    BL_IE_COUNTRY,
+    BL_IE_HT_CAP,
+    BL_IE_RSN,
+    BL_IE_HT_OP,
+    BL_IE_VHT_CAP,
+    BL_IE_VHT_OP,
+    BL_IE_WPA,          /* vendor 00:50:F2 type 1 */
+    BL_IE_WMM,          /* vendor 00:50:F2 type 2 */
+    BL_IE_WPS,          /* vendor 00:50:F2 type 4 */
+    BL_IE_SLOT_MAX,
+};
+
+struct bl_ie_index {
+    const uint8_t *buf;                 /* frame body given to bl_ie_parse() */
+    /* offset + 1 of the element header (id, len) of each slot, 0 if absent */
+    uint16_t off[BL_IE_SLOT_MAX];
+};
+
+#define BL_IE_CIPHER_WEP40      (1 << 0)
+#define BL_IE_CIPHER_WEP104     (1 << 1)
+#define BL_IE_CIPHER_TKIP       (1 << 2)
+#define BL_IE_CIPHER_CCMP       (1 << 3)
+
+#define BL_IE_AKM_8021X         (1 << 0)
+#define BL_IE_AKM_PSK           (1 << 1)
+#define BL_IE_AKM_SAE           (1 << 2)
+
+struct bl_ie_suites {
+    uint8_t group;              /* BL_IE_CIPHER_* */
+    uint8_t pairwise;           /* BL_IE_CIPHER_* mask */
+    uint8_t akm;                /* BL_IE_AKM_* mask */
+    uint8_t mfp_required;
+};
+
+int bl_ie_parse(const uint8_t *buf, int len, struct bl_ie_index *idx);
+int bl_ie_parse_rsn(const uint8_t *ie, struct bl_ie_suites *suites);
+int bl_ie_parse_wpa(const uint8_t *ie, struct bl_ie_suites *suites);
+
+/* element header of a slot, NULL if absent */
+static inline const uint8_t *bl_ie_get(const struct bl_ie_index *idx, enum bl_ie_slot slot)
+{
+    return idx->off[slot] ? idx->buf + idx->off[slot] - 1 : NULL;
+}
+
+static inline int bl_ie_len(const struct bl_ie_index *idx, enum bl_ie_slot slot)
+{
+    return idx->off[slot] ? idx->buf[idx->off[slot]] : -1;
+}
+
+#endif
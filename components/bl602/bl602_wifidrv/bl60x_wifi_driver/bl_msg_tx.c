@@ -360,10 +360,9 @@ static int bl_send_msg(struct bl_hw *bl_hw, const void *msg_params,
         cmd->flags |= RWNX_CMD_FLAG_REQ_CFM;
     ret = bl_hw->cmd_mgr.queue(&bl_hw->cmd_mgr, cmd);
 
-    if (!nonblock) {
+    /* a queued nonblock cmd is freed by the cmd manager on completion */
+    if (!nonblock || ret) {
         os_free(cmd);
-    } else {
-        ret = cmd->result;
     }
 
     RWNX_DBG(RWNX_FN_LEAVE_STR);
@@ -30,6 +30,7 @@
  */
 
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 #include <lwip/inet.h>
@@ -40,6 +41,7 @@
 #include "bl_cmds.h"
 #include "bl_rx.h"
 #include "bl_utils.h"
+#include "bl_ie.h"
 #include "ieee80211.h"
 #include <bl60x_fw_api.h>
 
@@ -441,200 +443,96 @@ static int bl_rx_scanu_join_cfm(struct bl_hw *bl_hw, struct bl_cmd *cmd, struct
     return 0;
 }
 
-static int find_ie_ssid(uint8_t *buffer, int len, uint8_t *result, int *ssid_len)
+static void scanu_fill_cipher(wifi_cipher_t *cipher, uint8_t mask)
 {
-    int i;
-
-    i = 0;
-    while (i < len) {
-#define IE_ID_SSID 0x00
-        if (IE_ID_SSID == buffer[0]) {//FIXME no magic ID for SSID
-            if (buffer[1] > 32) {
-                return -1;
-            }
-            *ssid_len = buffer[1];
-            memcpy(result, &(buffer[2]), buffer[1]);//NO check for len valid
-            result[buffer[1]] = '\0';
-            return 0;
-        } else {
-            /*move to next ie*/
-            i += buffer[1] + 2;//FIXME 2 is for id and len
-            buffer = buffer + buffer[1] + 2;
-        }
-    }
-
-    return -1;
+    cipher->wep40 = !!(mask & BL_IE_CIPHER_WEP40);
+    cipher->wep104 = !!(mask & BL_IE_CIPHER_WEP104);
+    cipher->tkip = !!(mask & BL_IE_CIPHER_TKIP);
+    cipher->ccmp = !!(mask & BL_IE_CIPHER_CCMP);
 }
 
-static int find_ie_ds(uint8_t *buffer, int len, uint8_t *result)
-{
-    int i;
-
-    i = 0;
-    while (i < len) {
-#define IE_ID_DS_CHANNEL 0x03
-        if (IE_ID_DS_CHANNEL == buffer[0]) {//FIXME no magic DS for SSID
-            if (buffer[1] > 32) {
-                return -1;
-            }
-            *result = buffer[2];
-            return 0;
-        } else {
-            /*move to next ie*/
-            i += buffer[1] + 2;//FIXME 2 is for id and len
-            buffer = buffer + buffer[1] + 2;
-        }
-    }
-
-    return -1;
-}
+/* indexed by pairwise TKIP, pairwise CCMP, group TKIP, group CCMP */
+static const uint8_t scanu_cipher_class[16] = {
+    [0x0 ... 0x3] = WIFI_EVENT_BEACON_IND_CIPHER_NONE,
+    [0x4]         = WIFI_EVENT_BEACON_IND_CIPHER_AES,
+    [0x5]         = WIFI_EVENT_BEACON_IND_CIPHER_AES,
+    [0x6]         = WIFI_EVENT_BEACON_IND_CIPHER_TKIP_AES,
+    [0x7]         = WIFI_EVENT_BEACON_IND_CIPHER_AES,
+    [0x8 ... 0xB] = WIFI_EVENT_BEACON_IND_CIPHER_TKIP,
+    [0xC ... 0xF] = WIFI_EVENT_BEACON_IND_CIPHER_TKIP_AES,
+};
 
-extern uint32_t mac_vsie_find(uint32_t addr, uint16_t buflen, uint8_t const *oui, uint8_t ouilen);
-extern uint32_t mac_ie_find(uint32_t addr, uint16_t buflen, uint8_t ie_id);
-extern unsigned char process_rsn_ie(uint8_t *rsn_ie, Cipher_t *mcstCipher,
-                  Cipher_t *ucstCipher, bool *is_pmf_required);
-extern unsigned char process_wpa_ie(uint8_t *wpa_ie, Cipher_t *mcstCipher,
-                  Cipher_t *ucstCipher);
-static uint8_t co_read8p(uint32_t addr)
+/* cipher of the beacon indication for the pairwise and group ciphers */
+static uint8_t scanu_cipher_classify(uint8_t pairwise, uint8_t group)
 {
-    return (*(uint8_t *)addr);
+    return scanu_cipher_class[(!!(pairwise & BL_IE_CIPHER_TKIP) << 3) |
+                              (!!(pairwise & BL_IE_CIPHER_CCMP) << 2) |
+                              (!!(group & BL_IE_CIPHER_TKIP) << 1) |
+                              (!!(group & BL_IE_CIPHER_CCMP))];
 }
-#define MAC_INFOELT_LEN_OFT               (1)
-#define MAC_INFOELT_INFO_OFT              (2)
 
-#define MAX_RSN_WPA_IE_LEN                (32)
+/* indexed by sec_mode.wpa2 << 1 | sec_mode.wpa */
+static const uint8_t scanu_auth_of_mode[4] = {
+    WIFI_EVENT_BEACON_IND_AUTH_WEP,
+    WIFI_EVENT_BEACON_IND_AUTH_WPA_PSK,
+    WIFI_EVENT_BEACON_IND_AUTH_WPA2_PSK,
+    WIFI_EVENT_BEACON_IND_AUTH_WPA_WPA2_PSK,
+};
+
 static int bl_rx_scanu_result_ind(struct bl_hw *bl_hw,
        struct bl_cmd *cmd, struct ipc_e2a_msg *msg)
 {
     struct scanu_result_ind *ind = (struct scanu_result_ind *)msg->param;
     struct ieee80211_mgmt *mgmt = (struct ieee80211_mgmt *)ind->payload;
     struct wifi_event_beacon_ind ind_new;
-    uint32_t elmt_addr, var_part_addr, var_part_len;
-    uint8_t ctype = 0;
-    uint8_t rsn_wpa_ie[MAX_RSN_WPA_IE_LEN];
-    uint8_t rsn_wpa_ie_len = 0;
-    uint8_t is_pmf_required = 0;
-
-    memset(rsn_wpa_ie, 0, MAX_RSN_WPA_IE_LEN);
+    struct bl_ie_index ies;
+    struct bl_ie_suites suites;
+    int var_part_len, rsn_ok = 0;
+    uint8_t pairwise = 0, group = 0;
 
     if (ieee80211_is_beacon(mgmt->frame_control)) {
         if (cb_beacon_ind) {
             memset(&ind_new, 0, sizeof(ind_new));
 
-            var_part_addr = (uint32_t)(mgmt->u.beacon.variable);
-            var_part_len = ind->length - (uint32_t)&(((struct ieee80211_mgmt*)NULL)->u.beacon.variable);
+            /* all elements are located in one pass */
+            var_part_len = (int)ind->length - (int)offsetof(struct ieee80211_mgmt, u.beacon.variable);
+            bl_ie_parse(mgmt->u.beacon.variable, var_part_len > 0 ? var_part_len : 0, &ies);
+
+            if (bl_ie_len(&ies, BL_IE_SSID) >= 0 && bl_ie_len(&ies, BL_IE_SSID) <= 32) {
+                ind_new.ssid_len = bl_ie_len(&ies, BL_IE_SSID);
+                memcpy(ind_new.ssid, bl_ie_get(&ies, BL_IE_SSID) + 2, ind_new.ssid_len);
+            }
+            if (bl_ie_len(&ies, BL_IE_DS) >= 1) {
+                ind_new.channel = bl_ie_get(&ies, BL_IE_DS)[2];
+            }
 
-            find_ie_ssid(mgmt->u.beacon.variable, ind->length, ind_new.ssid, &ind_new.ssid_len);
-            find_ie_ds(mgmt->u.beacon.variable, ind->length, &ind_new.channel);
             if (WLAN_CAPABILITY_PRIVACY & (le16_to_cpu(mgmt->u.beacon.capab_info))) {
-                // retrieve RSN field
-                #define MAC_ELTID_RSN_IEEE               48
-                elmt_addr = mac_ie_find(var_part_addr, var_part_len, MAC_ELTID_RSN_IEEE);
-                if (elmt_addr != 0) {
+                if (bl_ie_get(&ies, BL_IE_RSN)) {
                     ind_new.sec_mode.wpa2 = 1;
-
-                    rsn_wpa_ie_len = co_read8p(elmt_addr + MAC_INFOELT_LEN_OFT) + MAC_INFOELT_INFO_OFT;
-                    memcpy(rsn_wpa_ie, (uint8_t*)elmt_addr, rsn_wpa_ie_len);
-                    rsn_wpa_ie_len = process_rsn_ie(
-                        rsn_wpa_ie, (Cipher_t *)&ind_new.rsn_mcstCipher,
-                        (Cipher_t *)&ind_new.rsn_ucstCipher, (bool *)&is_pmf_required);
+                    rsn_ok = !bl_ie_parse_rsn(bl_ie_get(&ies, BL_IE_RSN), &suites);
+                    scanu_fill_cipher(&ind_new.rsn_mcstCipher, suites.group);
+                    scanu_fill_cipher(&ind_new.rsn_ucstCipher, suites.pairwise);
+                    group |= suites.group;
+                    pairwise |= suites.pairwise;
                 }
-
-                elmt_addr = mac_vsie_find(var_part_addr, var_part_len, (uint8_t const *)"\x00\x50\xF2\x01", 4);
-                if (elmt_addr != 0) {
+                /* as before, the ciphers of a WPA/WPA2 AP come from its RSN
+                 * element, the WPA one is only parsed if that is broken */
+                if (bl_ie_get(&ies, BL_IE_WPA)) {
                     ind_new.sec_mode.wpa = 1;
-
-                    if(!rsn_wpa_ie_len)
-                    {
-                        rsn_wpa_ie_len = co_read8p(elmt_addr + MAC_INFOELT_LEN_OFT) + MAC_INFOELT_INFO_OFT;
-                        memcpy(rsn_wpa_ie, (uint8_t*)elmt_addr, rsn_wpa_ie_len);
-                        rsn_wpa_ie_len = process_wpa_ie(
-                                rsn_wpa_ie, (Cipher_t *)&ind_new.wpa_mcstCipher, (Cipher_t *)&ind_new.wpa_ucstCipher);
-                    }
                 }
-                if (ind_new.sec_mode.wpa == 1 && ind_new.sec_mode.wpa2 == 1) {
-                    ind_new.auth = WIFI_EVENT_BEACON_IND_AUTH_WPA_WPA2_PSK;
-                    if (ind_new.rsn_ucstCipher.ccmp == 1 || ind_new.wpa_ucstCipher.ccmp == 1){
-                        ctype++;
-                    }
-
-                    if (ind_new.rsn_ucstCipher.tkip == 1 || ind_new.wpa_ucstCipher.tkip == 1){
-                        ctype++;
-                        if (ctype == 2) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP_AES;
-                        } else if(ctype == 1) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP;
-                        }
-                        goto next;
-                    }
-                    if (ctype == 1) {
-                        if (ind_new.rsn_mcstCipher.ccmp == 1 || ind_new.wpa_mcstCipher.ccmp == 1){
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_AES;
-                        } else if(ind_new.rsn_mcstCipher.tkip == 1 || ind_new.wpa_mcstCipher.tkip == 1) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP_AES;
-                        } else {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_AES;
-                        }
-                    }
-                } else if (ind_new.sec_mode.wpa == 1) {
-                    ind_new.auth = WIFI_EVENT_BEACON_IND_AUTH_WPA_PSK;
-                    if (ind_new.wpa_ucstCipher.ccmp == 1){
-                        ctype++;
-                    }
-                    if (ind_new.wpa_ucstCipher.tkip == 1){
-                        ctype++;
-                        if (ctype == 2) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP_AES;
-                        } else if(ctype == 1) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP;
-                        }
-                        goto next;
-                    }
-                    if (ctype == 1) {
-                        if (ind_new.wpa_mcstCipher.ccmp == 1){
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_AES;
-                        } else if(ind_new.wpa_mcstCipher.tkip == 1) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP_AES;
-                        } else {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_AES;
-                        }
-                    }
-                } else if (ind_new.sec_mode.wpa2 == 1) {
-                    ind_new.auth = WIFI_EVENT_BEACON_IND_AUTH_WPA2_PSK;
-                    if (ind_new.rsn_ucstCipher.ccmp == 1){
-                        ctype++;
-                    }
-                    if (ind_new.rsn_ucstCipher.tkip == 1){
-                        ctype++;
-                        if (ctype == 2) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP_AES;
-                        } else if(ctype == 1) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP;
-                        }
-                        goto next;
-                    }
-                    if (ctype == 1) {
-                        if (ind_new.rsn_mcstCipher.ccmp == 1){
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_AES;
-                        } else if(ind_new.rsn_mcstCipher.tkip == 1) {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_TKIP_AES;
-                        } else {
-                            ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_AES;
-                        }
-                    }
-                } else {
-                    ind_new.auth = WIFI_EVENT_BEACON_IND_AUTH_WEP;
-                    ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_WEP;
+                if (bl_ie_get(&ies, BL_IE_WPA) && !rsn_ok) {
+                    bl_ie_parse_wpa(bl_ie_get(&ies, BL_IE_WPA), &suites);
+                    scanu_fill_cipher(&ind_new.wpa_mcstCipher, suites.group);
+                    scanu_fill_cipher(&ind_new.wpa_ucstCipher, suites.pairwise);
+                    group |= suites.group;
+                    pairwise |= suites.pairwise;
                 }
-next:
-                if (ind_new.sec_mode.wpa2 && ind_new.sec_mode.wpa) {
-                    ind_new.auth = WIFI_EVENT_BEACON_IND_AUTH_WPA_WPA2_PSK;
-                } else if (ind_new.sec_mode.wpa2) {
-                    ind_new.auth = WIFI_EVENT_BEACON_IND_AUTH_WPA2_PSK;
-                } else if (ind_new.sec_mode.wpa) {
-                    ind_new.auth = WIFI_EVENT_BEACON_IND_AUTH_WPA_PSK;
+
+                ind_new.auth = scanu_auth_of_mode[(ind_new.sec_mode.wpa2 << 1) | ind_new.sec_mode.wpa];
+                if (ind_new.sec_mode.wpa2 || ind_new.sec_mode.wpa) {
+                    ind_new.cipher = scanu_cipher_classify(pairwise, group);
                 } else {
-                    ind_new.auth = WIFI_EVENT_BEACON_IND_AUTH_WEP;
+                    ind_new.cipher = WIFI_EVENT_BEACON_IND_CIPHER_WEP;
                 }
             } else {
                 /*This is an open BSS*/
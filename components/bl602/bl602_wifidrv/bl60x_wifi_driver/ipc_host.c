@@ -196,10 +196,32 @@ uint32_t ipc_host_get_rawstatus(struct ipc_host_env_tag *env)
     return status;
 }
 
+/*
+ * Forget the message waiting for its ACK after the command manager gave up
+ * on it, a late ACK of that message must not be taken for the next one.
+ */
+void ipc_host_msg_resync(struct ipc_host_env_tag *env)
+{
+    env->msga2e_hostid = NULL;
+    env->msga2e_resync = 1;
+}
+
 static void ipc_host_msgack_handler(struct ipc_host_env_tag *env)
 {
     void *hostid = env->msga2e_hostid;
 
+    if (env->msga2e_resync) {
+        env->msga2e_resync = 0;
+        env->msga2e_cnt = ((struct lmac_msg *)(&env->shared->msg_a2e_buf.msg))->src_id & 0xFF;
+        if (!hostid) {
+            /* ACK of the message dropped by the resync, the A2E buffer
+             * is free again */
+            env->msga2e_cnt++;
+            env->cb.recv_msgack_ind(env->pthis, NULL);
+            return;
+        }
+    }
+
     ASSERT_ERR(hostid);
     ASSERT_ERR(env->msga2e_cnt == (((struct lmac_msg *)(&env->shared->msg_a2e_buf.msg))->src_id & 0xFF));
 
@@ -141,6 +141,8 @@ struct ipc_host_env_tag
     /// E2A ACKs of A2E MSGs
     uint8_t msga2e_cnt;
     void *msga2e_hostid;
+    // Set after a resync, the next ACK gives the counter again
+    uint8_t msga2e_resync;
 
     /// Fields for Debug MSGs handling
     // Global array used to store the hostid and hostbuf addresses for Debug messages
@@ -161,6 +163,7 @@ void ipc_host_init(struct ipc_host_env_tag *env,
                   struct ipc_shared_env_tag *shared_env_ptr,
                   void *pthis);
 int ipc_host_msg_push(struct ipc_host_env_tag *env, void *msg_buf, uint16_t len);
+void ipc_host_msg_resync(struct ipc_host_env_tag *env);
 uint32_t ipc_host_get_status(struct ipc_host_env_tag *env);
 uint32_t ipc_host_get_rawstatus(struct ipc_host_env_tag *env);
 volatile struct txdesc_host *ipc_host_txdesc_get(struct ipc_host_env_tag *env);
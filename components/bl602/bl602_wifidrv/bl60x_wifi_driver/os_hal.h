@@ -53,16 +53,24 @@ typedef struct rt_event os_event_t;
 #define os_event_send rt_event_send
 #define os_event_sendFromISR rt_event_send
 #define os_event_recv(irq_event, bits, timeout, val) rt_event_recv(irq_event, bits, RT_EVENT_FLAG_AND | RT_EVENT_FLAG_CLEAR, timeout, &val)
+#define os_event_clear(ev, bits) do { \
+    rt_uint32_t recved; \
+    rt_event_recv(ev, bits, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, 0, &recved); \
+} while (0)
+#define os_event_wait(ev, bits, timeout, val) rt_event_recv(ev, bits, RT_EVENT_FLAG_AND, timeout, &val)
 #define os_event_delete rt_event_detach
 /*mutex*/
 typedef rt_mutex_t os_mutex_t;
 #define os_mutex_create(name) rt_mutex_create(name, RT_IPC_FLAG_FIFO);
 #define os_mutex_take rt_mutex_take
+#define os_mutex_trytake(mutex) (RT_EOK == rt_mutex_take(mutex, 0) ? 0 : 1)
 #define os_mutex_give rt_mutex_release
 #define OS_WAITING_FOREVER RT_WAITING_FOREVER
 /*int related*/
 #define os_interrupt_enter(...) rt_interrupt_enter(...)
 #define os_interrupt_leave(...) rt_interrupt_leave(...)
+#define os_enter_critical rt_enter_critical
+#define os_exit_critical rt_exit_critical
 /*thread related*/
 #define os_thread_delay rt_thread_delay
 #define os_tick_get rt_tick_get
@@ -89,6 +97,8 @@ typedef rt_messagequeue os_messagequeue_t;
 );
 #define os_mq_send(mq, msg, len) rt_mq_send(mq, msg, len);
 #define os_mq_recv(mq, msg, len) rt_mq_recv(mq, msg, len, RT_WAITING_FOREVER)
+#define os_mq_send_timeout(mq, msg, len, timeout) rt_mq_send_wait(mq, msg, len, timeout)
+#define os_mq_recv_timeout(mq, msg, len, timeout) rt_mq_recv(mq, msg, len, timeout)
 /*timer related*/
 typedef rt_timer_t os_timer_t;
 typedef void* timer_cb_arg_t;
@@ -103,6 +113,13 @@ typedef void* timer_cb_arg_t;
         type \
 );
 #define os_timer_start(timer) rt_timer_start(timer)
+#define os_timer_restart(timer, ticks) ({ \
+    rt_tick_t period = ticks; \
+    rt_timer_stop(timer); \
+    rt_timer_control(timer, RT_TIMER_CTRL_SET_TIME, &period); \
+    RT_EOK == rt_timer_start(timer) ? 0 : 1; \
+})
+#define os_timer_stop(timer) (RT_EOK == rt_timer_stop(timer) ? 0 : 1)
 #define os_timer_startFromISR(timer) rt_timer_start(timer)
 #define os_timer_data(timer) (timer)
 
@@ -142,11 +159,17 @@ typedef StaticEventGroup_t os_event_t;
 #define os_event_recv(irq_event, bits, timeout, val) do { \
     val = xEventGroupWaitBits((EventGroupHandle_t)irq_event, bits, pdTRUE, pdFALSE, timeout); \
 } while (0)
+#define os_event_clear(ev, bits) xEventGroupClearBits((EventGroupHandle_t)ev, bits)
+/*wait for all bits without clearing them*/
+#define os_event_wait(ev, bits, timeout, val) do { \
+    val = xEventGroupWaitBits((EventGroupHandle_t)ev, bits, pdFALSE, pdTRUE, timeout); \
+} while (0)
 #define os_event_delete vEventGroupDelete
 /*mutex*/
 typedef SemaphoreHandle_t os_mutex_t;
 #define os_mutex_create(name) xSemaphoreCreateMutex()
 #define os_mutex_take xSemaphoreTake
+#define os_mutex_trytake(mutex) (pdTRUE == xSemaphoreTake(mutex, 0) ? 0 : 1)
 #define os_mutex_give xSemaphoreGive
 #define os_mutex_giveFromISR xSemaphoreGiveFromISR
 #define OS_WAITING_FOREVER portMAX_DELAY
@@ -154,6 +177,8 @@ typedef SemaphoreHandle_t os_mutex_t;
 /*int related*/
 #define os_interrupt_enter(...) do {} while(0)
 #define os_interrupt_leave(...) do {} while(0)
+#define os_enter_critical taskENTER_CRITICAL
+#define os_exit_critical taskEXIT_CRITICAL
 /*thread related*/
 #define os_thread_delay vTaskDelay
 #define os_tick_get xTaskGetTickCount
@@ -173,6 +198,8 @@ typedef StaticMessageBuffer_t os_messagequeue_t;
 #define os_mq_init(mq, name, buffer, msgsize, buffersize) (NULL != xMessageBufferCreateStatic(buffersize, buffer, mq) ? 0 : 1)
 #define os_mq_send(mq, msg, len) (xMessageBufferSend(mq, msg, len, portMAX_DELAY) > 0 ? 0 : 1)
 #define os_mq_recv(mq, msg, len) (xMessageBufferReceive(mq, msg, len, portMAX_DELAY) > 0 ? 0 : 1)
+#define os_mq_send_timeout(mq, msg, len, timeout) (xMessageBufferSend(mq, msg, len, timeout) > 0 ? 0 : 1)
+#define os_mq_recv_timeout(mq, msg, len, timeout) (xMessageBufferReceive(mq, msg, len, timeout) > 0 ? 0 : 1)
 /*timer related*/
 typedef StaticTimer_t os_timer_t;
 #define OS_TIMER_TYPE_ONESHOT pdFALSE
@@ -196,6 +223,9 @@ typedef TimerHandle_t timer_cb_arg_t;
 )
 #define os_timer_start(timer) xTimerStart((TimerHandle_t)timer, portMAX_DELAY);
 #define os_timer_startFromISR(timer) xTimerStartFromISR(timer, portMAX_DELAY);
+/*set a new period and start, also from the timer callback, 1 if the timer queue is full*/
+#define os_timer_restart(timer, ticks) (pdPASS == xTimerChangePeriod((TimerHandle_t)timer, ticks, 0) ? 0 : 1)
+#define os_timer_stop(timer) (pdPASS == xTimerStop((TimerHandle_t)timer, 0) ? 0 : 1)
 #define os_timer_data(timer) pvTimerGetTimerID(timer)
 
 #endif
@@ -59,7 +59,9 @@
 static void goToErrorState( struct stateMachine *stateMachine,
       struct event *const event );
 static struct transition *getTransition( struct stateMachine *stateMachine,
-      const struct state *state, struct event *const event );
+      const struct state *state, struct event *const event,
+      struct stateM_eventStats *stats );
+static void buildJumpTables( const struct state *state );
 
 void stateM_init( struct stateMachine *fsm,
       const struct state *initialState, const struct state *errorState )
@@ -70,6 +72,20 @@ void stateM_init( struct stateMachine *fsm,
    fsm->currentState = initialState;
    fsm->previousState = NULL;
    fsm->errorState = errorState;
+   fsm->stats = NULL;
+   fsm->numStats = 0;
+
+   buildJumpTables( initialState );
+}
+
+void stateM_setStats( struct stateMachine *fsm,
+      struct stateM_eventStats *stats, int numStats )
+{
+   if ( !fsm )
+      return;
+
+   fsm->stats = stats;
+   fsm->numStats = stats ? numStats : 0;
 }
 
 int stateM_handleEvent( struct stateMachine *fsm,
@@ -87,9 +103,20 @@ int stateM_handleEvent( struct stateMachine *fsm,
    if ( !fsm->currentState->numTransitions )
       return stateM_noStateChange;
 
+   struct stateM_eventStats *stats = NULL;
+   if ( event->type >= 0 && event->type < fsm->numStats )
+   {
+      stats = &fsm->stats[ event->type ];
+      stats->dispatched++;
+   }
+
    const struct state *nextState = fsm->currentState;
    do {
-      struct transition *transition = getTransition( fsm, nextState, event );
+      if ( stats )
+         stats->lookups++;
+
+      struct transition *transition = getTransition( fsm, nextState, event,
+            stats );
 
       /* If there were no transitions for the given event for the current
        * state, check if there are any transitions for any of the parent
@@ -100,6 +127,18 @@ int stateM_handleEvent( struct stateMachine *fsm,
          continue;
       }
 
+      if ( stats )
+         stats->transitions++;
+
+      /* An internal transition only runs its action: */
+      if ( transition->internal )
+      {
+         if ( transition->action )
+            transition->action( fsm->currentState->data, event,
+                  fsm->currentState->data );
+         return stateM_noStateChange;
+      }
+
       /* A transition must have a next state defined. If the user has not
        * defined the next state, go to error state: */
       if ( !transition->nextState )
@@ -179,11 +218,42 @@ static void goToErrorState( struct stateMachine *fsm,
       fsm->currentState->entryAction( fsm->currentState->data, event );
 }
 
+static bool checkGuard( struct transition *t, struct event *const event,
+      struct stateM_eventStats *stats )
+{
+   if ( !t->guard )
+      return true;
+
+   if ( stats )
+      stats->guards++;
+
+   return t->guard( t->condition, event );
+}
+
 static struct transition *getTransition( struct stateMachine *fsm,
-      const struct state *state, struct event *const event )
+      const struct state *state, struct event *const event,
+      struct stateM_eventStats *stats )
 {
+   struct stateM_jumpTable *table = state->jumpTable;
    size_t i;
 
+   /* Only visit the transitions of this event, in array order: */
+   if ( table && table->built )
+   {
+      if ( event->type < 0 || event->type >= table->numEvents )
+         return NULL;
+
+      for ( i = table->first[ event->type ]; i; i = table->next[ i - 1 ] )
+      {
+         struct transition *t = &state->transitions[ i - 1 ];
+
+         if ( checkGuard( t, event, stats ) )
+            return t;
+      }
+
+      return NULL;
+   }
+
    for ( i = 0; i < state->numTransitions; ++i )
    {
       struct transition *t = &state->transitions[ i ];
@@ -191,10 +261,8 @@ static struct transition *getTransition( struct stateMachine *fsm,
       /* A transition for the given event has been found: */
       if ( t->eventType == event->type )
       {
-         if ( !t->guard )
-            return t;
          /* If transition is guarded, ensure that the condition is held: */
-         else if ( t->guard( t->condition, event ) )
+         if ( checkGuard( t, event, stats ) )
             return t;
       }
    }
@@ -210,3 +278,56 @@ bool stateM_stopped( struct stateMachine *stateMachine )
 
    return stateMachine->currentState->numTransitions == 0;
 }
+
+static bool fillJumpTable( const struct state *state )
+{
+   struct stateM_jumpTable *table = state->jumpTable;
+   size_t i;
+   int type;
+
+   if ( state->numTransitions > table->numTransitions ||
+         state->numTransitions > 255 )
+      return false;
+
+   for ( i = 0; i < state->numTransitions; ++i )
+   {
+      type = state->transitions[ i ].eventType;
+      if ( type < 0 || type >= table->numEvents )
+         return false;
+   }
+
+   for ( type = 0; type < table->numEvents; ++type )
+      table->first[ type ] = 0;
+
+   /* Link backwards so that every chain is in array order: */
+   for ( i = state->numTransitions; i > 0; --i )
+   {
+      type = state->transitions[ i - 1 ].eventType;
+      table->next[ i - 1 ] = table->first[ type ];
+      table->first[ type ] = i;
+   }
+
+   return true;
+}
+
+static void buildJumpTables( const struct state *state )
+{
+   size_t i;
+
+   /* The built flag also stops the walk on cycles: */
+   if ( !state || !state->jumpTable || state->jumpTable->built )
+      return;
+
+   /* A table that does not fit is left unbuilt, the state is then scanned: */
+   state->jumpTable->built = true;
+   if ( !fillJumpTable( state ) )
+   {
+      state->jumpTable->built = false;
+      return;
+   }
+
+   buildJumpTables( state->parentState );
+   buildJumpTables( state->entryState );
+   for ( i = 0; i < state->numTransitions; ++i )
+      buildJumpTables( state->transitions[ i ].nextState );
+}
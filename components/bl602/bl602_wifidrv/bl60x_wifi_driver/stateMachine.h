@@ -129,6 +129,63 @@ struct event
 
 struct state;
 
+/**
+ * \brief Per event jump table of a state
+ *
+ * Filled by stateM_init(). With a table, stateM_handleEvent() only looks at
+ * the transitions of the incoming event instead of scanning all transitions
+ * of the state. Event types must then be in the range 0 to #numEvents - 1,
+ * other events are passed on to the parent state. Declare tables with
+ * #STATEM_JUMP_TABLE.
+ */
+struct stateM_jumpTable
+{
+   /** \brief Number of event types, events are 0 to numEvents - 1 */
+   int numEvents;
+   /** \brief Size of the #first array */
+   size_t numTransitions;
+   /** \brief Per event type, index + 1 of its first transition, 0 if none */
+   unsigned char *first;
+   /**
+    * \brief Per transition, index + 1 of the next transition with the same
+    * event type, 0 if it is the last one
+    */
+   unsigned char *next;
+   /** \brief Set once the table has been filled */
+   bool built;
+};
+
+/**
+ * \brief Define a static jump table for a state
+ *
+ * \param name name of the table, use its address as \ref state::jumpTable
+ * "jumpTable".
+ * \param nEvents number of event types.
+ * \param nTransitions number of transitions of the state (at most 255).
+ */
+#define STATEM_JUMP_TABLE( name, nEvents, nTransitions ) \
+   static unsigned char name##_first[ nEvents ]; \
+   static unsigned char name##_next[ nTransitions ]; \
+   static struct stateM_jumpTable name = { \
+      nEvents, nTransitions, name##_first, name##_next, false }
+
+/**
+ * \brief Dispatch cost of one event type
+ *
+ * \sa stateM_setStats()
+ */
+struct stateM_eventStats
+{
+   /** \brief Events handled */
+   unsigned long dispatched;
+   /** \brief States looked at, the current state and its parents */
+   unsigned long lookups;
+   /** \brief Guard calls */
+   unsigned long guards;
+   /** \brief Transitions taken, internal ones included */
+   unsigned long transitions;
+};
+
 /**
  * \brief Transition between a state and another state
  *
@@ -234,6 +291,18 @@ struct transition
     * stateMachine::errorState "error state".
     */
    const struct state *nextState;
+   /**
+    * \brief Internal transition
+    *
+    * If true, the state is not left: #nextState is ignored, no entry or exit
+    * action is called and #action gets the current state's \ref state::data
+    * "data" for both of its state arguments. The event is not handed to the
+    * parent states.
+    *
+    * Use this instead of a guard that does the work and returns false, so that
+    * guards stay free of side effects.
+    */
+   bool internal;
 };
 
 /**
@@ -366,6 +435,12 @@ struct state
     * \param event the event that triggered a transition will be passed.
     */
    void ( *exitAction )( void *stateData, struct event *event );
+   /**
+    * \brief Jump table of the state, may be NULL
+    *
+    * \sa stateM_jumpTable
+    */
+   struct stateM_jumpTable *jumpTable;
 };
 
 /**
@@ -392,6 +467,10 @@ struct stateMachine
     * error state.
     */
    const struct state *errorState;
+   /** \brief Dispatch counters indexed by event type, may be NULL */
+   struct stateM_eventStats *stats;
+   /** \brief Number of entries in #stats */
+   int numStats;
 };
 
 /**
@@ -410,6 +489,12 @@ struct stateMachine
  * state::entryState "entryState" defined, it will not be entered. The user
  * must explicitly set the initial state.
  *
+ * \note The \ref state::jumpTable "jump tables" of \pn{initialState} and of
+ * the states reachable from it are filled here. States without a table are
+ * not followed, their transitions are scanned on every event.
+ *
+ * \note Dispatch counters are detached, see stateM_setStats().
+ *
  * \param stateMachine the state machine to initialise.
  * \param initialState the initial state of the state machine.
  * \param errorState pointer to a state that acts a final state and notifies
@@ -418,6 +503,17 @@ struct stateMachine
 void stateM_init( struct stateMachine *stateMachine,
       const struct state *initialState, const struct state *errorState );
 
+/**
+ * \brief Count the dispatch cost of every event type
+ *
+ * \param stateMachine the state machine to count for.
+ * \param stats array indexed by event type, NULL to stop counting.
+ * \param numStats number of entries in \pn{stats}, events of other types are
+ * not counted.
+ */
+void stateM_setStats( struct stateMachine *stateMachine,
+      struct stateM_eventStats *stats, int numStats );
+
 /**
  * \brief stateM_handleEvent() return values
  */
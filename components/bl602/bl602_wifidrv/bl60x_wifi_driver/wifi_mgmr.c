@@ -152,7 +152,8 @@ char *wifi_mgmr_cipher_to_str(uint8_t cipher)
     }
 }
 
-static bool stateGlobalGuard_scan_beacon( void *ch, struct event *event )
+static void stateGlobalAction_scan_beacon( void *oldStateData, struct event *event,
+      void *newStateData )
 {
 #define SCAN_UPDATE_LIMIT_TIME_MS (3000)
 
@@ -165,9 +166,6 @@ static bool stateGlobalGuard_scan_beacon( void *ch, struct event *event )
 
     msg = event->data;
     scan = (wifi_mgmr_scan_item_t*)msg->data;
-    if (ch != (void*)msg->ev) {
-        return false;
-    }
 #ifdef DEBUG_SCAN_BEACON
     os_printf(DEBUG_HEADER "channel %02u, bssid %02X:%02X:%02X:%02X:%02X:%02X, rssi %3d, auth %s, cipher:%s \t, SSID %s\r\n",
             scan->channel,
@@ -186,10 +184,10 @@ static bool stateGlobalGuard_scan_beacon( void *ch, struct event *event )
     );
 #endif
     if (scan->channel > wifiMgmr.channel_nums || !scan->channel){
-        goto __exit;
+        return;
     }
     if (0 == scan->ssid[0] && (!_features_is_set(WIFI_MGMR_FEATURES_SCAN_SAVE_HIDDEN_SSID))) {
-        goto __exit;
+        return;
     }
 
     /*update scan_items, we just store the newly found item, or update exsiting one*/
@@ -252,97 +250,66 @@ static bool stateGlobalGuard_scan_beacon( void *ch, struct event *event )
             wifiMgmr.scan_items[i].is_used = 1;
         }
     }
-
-__exit:
-
-    /*we always return false, since we only store the info from beacon frame*/
-    return false;
 }
 
-static bool stateGlobalGuard_disable_autoreconnect( void *ch, struct event *event )
+static bool stateGlobalGuard_in_disconnect( void *ch, struct event *event )
 {
-    wifi_mgmr_msg_t *msg;
+    return (&stateDisconnect == wifiMgmr.m.currentState);
+}
 
-    msg = event->data;
-    if (ch != (void*)msg->ev) {
-        return false;
-    }
+static void stateGlobalAction_disable_autoreconnect_idle( void *oldStateData, struct event *event,
+      void *newStateData )
+{
+    os_printf("Disable Autoreconnect in Disconnec State\r\n");
+    os_printf(DEBUG_HEADER "Removing STA interface...\r\n");
+    bl_main_if_remove(wifiMgmr.wlan_sta.vif_index);
+    os_printf(DEBUG_HEADER "Global Action\r\n");
+}
 
-    if (&stateDisconnect == wifiMgmr.m.currentState) {
-        os_printf("Disable Autoreconnect in Disconnec State\r\n");
-        os_printf(DEBUG_HEADER "Removing STA interface...\r\n");
-        bl_main_if_remove(wifiMgmr.wlan_sta.vif_index);
-        return true;
-    }
+static void stateGlobalAction_disable_autoreconnect( void *oldStateData, struct event *event,
+      void *newStateData )
+{
     /*we need set disable now for future use*/
     os_printf("Disable Auto Reconnect\r\n");
     wifi_mgmr_profile_autoreconnect_disable(&wifiMgmr, -1);
-
-    /*we always return false, since we only store the info from beacon frame*/
-    return false;
 }
 
-static bool stateGlobalGuard_enable_autoreconnect( void *ch, struct event *event )
+static void stateGlobalAction_enable_autoreconnect( void *oldStateData, struct event *event,
+      void *newStateData )
 {
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch != (void*)msg->ev) {
-        return false;
-    }
-
     /*we need set enable now for future use*/
     os_printf("Enable Auto Reconnect\r\n");
     wifi_mgmr_profile_autoreconnect_enable(&wifiMgmr, -1);
-
-    /*we always return false, since we only store the info from beacon frame*/
-    return false;
 }
 
-static bool stateGlobalGuard_fw_disconnect(void *ch, struct event *event)
+static void stateGlobalAction_fw_disconnect( void *oldStateData, struct event *event,
+      void *newStateData )
 {
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (WIFI_MGMR_EVENT_FW_DISCONNECT == msg->ev) {
-        os_printf("Disconnect CMD\r\n");
-        bl_main_disconnect();
-    }
-
-    return false;
+    os_printf("Disconnect CMD\r\n");
+    bl_main_disconnect();
 }
 
-static bool stateGlobalGuard_fw_powersaving(void *ch, struct event *event)
+static void stateGlobalAction_fw_powersaving( void *oldStateData, struct event *event,
+      void *newStateData )
 {
     wifi_mgmr_msg_t *msg;
 
     msg = event->data;
-    if (WIFI_MGMR_EVENT_FW_POWERSAVING == msg->ev) {
-        os_printf("------>>>>>> Powersaving CMD, mode: %u\r\n", (unsigned int)msg->data1);
+    os_printf("------>>>>>> Powersaving CMD, mode: %u\r\n", (unsigned int)msg->data1);
 //TODO mode check?
-        bl_main_powersaving((int)msg->data1);
-    }
-
-    return false;
+    bl_main_powersaving((int)msg->data1);
 }
 
-static bool stateGlobalGuard_fw_scan(void *ch, struct event *event)
+static void stateGlobalAction_fw_scan( void *oldStateData, struct event *event,
+      void *newStateData )
 {
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    /*only check wifi scan command*/
-    if (WIFI_MGMR_EVENT_FW_SCAN != msg->ev) {
-        return false;
-    }
-
     /*pending wifi scan command*/
     if (&stateConnecting == wifiMgmr.m.currentState ||
             &stateConnectedIPNo == wifiMgmr.m.currentState ||
             &stateDisconnect == wifiMgmr.m.currentState) {
             os_printf("------>>>>>> Scan CMD Pending\r\n");
             _pending_task_set(WIFI_MGMR_PENDING_TASK_SCAN_BIT);
-            return false;
+            return;
     }
 
     /*Forbidden other cases*/
@@ -351,20 +318,12 @@ static bool stateGlobalGuard_fw_scan(void *ch, struct event *event)
             &stateSniffer != wifiMgmr.m.currentState) {
             os_printf("------>>>>>> FW busy\r\n");
             aos_post_event(EV_WIFI, CODE_WIFI_ON_SCAN_DONE, WIFI_SCAN_DONE_EVENT_BUSY);
-            return false;
+            return;
     }
 
     /*normal scan command*/
     os_printf("------>>>>>> Scan CMD\r\n");
     bl_main_scan();
-
-    return false;
-}
-
-static void stateGlobalAction( void *oldStateData, struct event *event,
-      void *newStateData )
-{
-    os_printf(DEBUG_HEADER "Global Action\r\n");
 }
 
 static void stateGlobalEnter( void *stateData, struct event *event )
@@ -378,17 +337,6 @@ static void stateGlobalExit( void *stateData, struct event *event )
 }
 
 /*function for state sniffer*/
-static bool stateSnifferGuard( void *ch, struct event *event )
-{
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch == (void*)msg->ev) {
-        return true;
-    }
-    return false;
-}
-
 static void stateSnifferAction( void *oldStateData, struct event *event,
       void *newStateData )
 {
@@ -398,54 +346,44 @@ static void stateSnifferAction( void *oldStateData, struct event *event,
     );
 }
 
-static bool stateSnifferGuard_ChannelSet( void *ch, struct event *event )
+static void stateSnifferAction_ChannelSet( void *oldStateData, struct event *event,
+      void *newStateData )
 {
     wifi_mgmr_msg_t *msg;
 
     msg = event->data;
-    if (ch != (void*)msg->ev) {
-        return false;
-    }
-
     bl_main_monitor_channel_set((int)msg->data1, (int)msg->data2);
-    /*will never trigger state change, since we just want to trigger the guard*/
-    return false;
 }
 
 static bool stateSnifferGuard_raw_send(void *ch, struct event *event)
+{
+    /* NO Raw Send in IDLE mode */
+    return ((&stateIdle) != wifiMgmr.m.currentState && (&stateIfaceDown) != wifiMgmr.m.currentState);
+}
+
+static void stateSnifferAction_raw_send( void *oldStateData, struct event *event,
+      void *newStateData )
 {
     wifi_mgmr_msg_t *msg;
     uint8_t *pkt;
     int len;
 
-    if ((&stateIdle) == wifiMgmr.m.currentState || (&stateIfaceDown) == wifiMgmr.m.currentState) {
-        /* NO Raw Send in IDLE mode */
-        return false;
-    }
-
     msg = event->data;
-    if (WIFI_MGMR_EVENT_FW_DATA_RAW_SEND == msg->ev) {
-        pkt = msg->data1;
-        len = (int)msg->data2;
-        blog_info("------>>>>>> RAW Send CMD, pkt %p, len %d\r\n", pkt, len);
-        bl_main_raw_send(pkt, len);
-    }
-
-    return false;
+    pkt = msg->data1;
+    len = (int)msg->data2;
+    blog_info("------>>>>>> RAW Send CMD, pkt %p, len %d\r\n", pkt, len);
+    bl_main_raw_send(pkt, len);
 }
 
-static bool stateGlobal_cfg_req(void *ch, struct event *event)
+static void stateGlobalAction_cfg_req( void *oldStateData, struct event *event,
+      void *newStateData )
 {
     wifi_mgmr_msg_t *msg;
     wifi_mgmr_cfg_element_msg_t *cfg_req;
 
     msg = event->data;
-    if (WIFI_MGMR_EVENT_FW_CFG_REQ == msg->ev) {
-        cfg_req = (wifi_mgmr_cfg_element_msg_t*)msg->data;
-        bl_main_cfg_task_req(cfg_req->ops, cfg_req->task, cfg_req->element, cfg_req->type, cfg_req->buf, NULL);
-    }
-
-    return false;
+    cfg_req = (wifi_mgmr_cfg_element_msg_t*)msg->data;
+    bl_main_cfg_task_req(cfg_req->ops, cfg_req->task, cfg_req->element, cfg_req->type, cfg_req->buf, NULL);
 }
 
 static void stateSnifferEnter( void *stateData, struct event *event )
@@ -461,17 +399,6 @@ static void stateSnifferExit( void *stateData, struct event *event )
 }
 
 /*function for state CONNECTING*/
-static bool stateConnectingGuard( void *ch, struct event *event )
-{
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch == (void*)msg->ev) {
-        return true;
-    }
-    return false;
-}
-
 static void stateConnectingAction_connected( void *oldStateData, struct event *event,
       void *newStateData )
 {
@@ -501,19 +428,16 @@ static void stateConnectingExit( void *stateData, struct event *event )
    os_printf(DEBUG_HEADER "Exiting %s state\r\n", (char *)stateData);
 }
 
-static bool stateGlobalGuard_AP(void *ev, struct event *event )
+static void stateGlobalAction_AP( void *oldStateData, struct event *event,
+      void *newStateData )
 {
     wifi_mgmr_msg_t *msg;
     wifi_mgmr_ap_msg_t *ap;
 
     msg = event->data;
-    if (WIFI_MGMR_EVENT_APP_AP_START != msg->ev) {
-        return false;
-    }
-
     if (bl_main_if_add(0, &(wifiMgmr.wlan_ap.netif), &(wifiMgmr.wlan_ap.vif_index))) {
         os_printf(DEBUG_HEADER "%s: add AP iface failed\r\n", __func__);
-        return false;
+        return;
     }
     netifapi_netif_set_link_up(&(wifiMgmr.wlan_ap.netif));
 void dhcpd_start(struct netif *netif);
@@ -527,19 +451,11 @@ void dhcpd_start(struct netif *netif);
     wifiMgmr.inf_ap_enabled = 1;
     dns_server_init();
     aos_post_event(EV_WIFI, CODE_WIFI_ON_AP_STARTED, 0);
-
-    return false;
 }
 
-static bool stateGlobalGuard_stop(void *ev, struct event *event )
+static void stateGlobalAction_stop( void *oldStateData, struct event *event,
+      void *newStateData )
 {
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (WIFI_MGMR_EVENT_APP_AP_STOP != msg->ev) {
-        return false;
-    }
-
     os_printf(DEBUG_HEADER "Stoping AP interface...\r\n");
     bl_main_apm_stop(wifiMgmr.wlan_ap.vif_index);
     os_printf(DEBUG_HEADER "Removing and deauth all sta client...\r\n");
@@ -553,23 +469,16 @@ err_t dhcp_server_stop(struct netif *netif);
     netifapi_netif_remove(&(wifiMgmr.wlan_ap.netif));
     wifiMgmr.inf_ap_enabled = 0;
     aos_post_event(EV_WIFI, CODE_WIFI_ON_AP_STOPPED, 0);
-
-    return false;
 }
 
-static bool stateGlobalGuard_conf_max_sta(void *ev, struct event *event )
+static void stateGlobalAction_conf_max_sta( void *oldStateData, struct event *event,
+      void *newStateData )
 {
     wifi_mgmr_msg_t *msg;
 
     msg = event->data;
-    if (WIFI_MGMR_EVENT_APP_CONF_MAX_STA != msg->ev) {
-        return false;
-    }
-
     os_printf(DEBUG_HEADER "Conf max sta supported %lu...\r\n", (uint32_t)msg->data1);
     bl_main_conf_max_sta((uint32_t)msg->data1);
-
-    return false;
 }
 
 //FIXME TODO ugly hack
@@ -584,15 +493,12 @@ int wifi_mgmr_api_denoise_enable(void);
     }
 }
 
-static bool stateGlobalGuard_denoise(void *ev, struct event *event )
+static void stateGlobalAction_denoise( void *oldStateData, struct event *event,
+      void *newStateData )
 {
     wifi_mgmr_msg_t *msg;
 
     msg = event->data;
-    if (WIFI_MGMR_EVENT_APP_DENOISE != msg->ev) {
-        return false;
-    }
-
     if (msg->data1) {
         /*TODO no more magic here*/
         //enable denoise
@@ -613,72 +519,77 @@ static bool stateGlobalGuard_denoise(void *ev, struct event *event )
         auto_repeat = 0;
         bl_main_denoise(0);
     }
-
-    return false;
 }
 
+/*
+ * Transitions are keyed by WIFI_MGMR_EVENT_XXX and looked up through the
+ * per state jump tables, guards have no side effects. Commands that do not
+ * change the state are internal transitions (last field true).
+ */
+STATEM_JUMP_TABLE(stateGlobal_table, WIFI_MGMR_EVENT_MAX, 13);
 static const struct state stateGlobal = {
    .parentState = NULL,
    .entryState = NULL,
    .transitions = (struct transition[])
    {
-      {EVENT_TYPE_GLB, (void*)WIFI_MGMR_EVENT_GLB_SCAN_IND_BEACON, &stateGlobalGuard_scan_beacon, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_GLB, (void*)WIFI_MGMR_EVENT_GLB_DISABLE_AUTORECONNECT, &stateGlobalGuard_disable_autoreconnect, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_GLB, (void*)WIFI_MGMR_EVENT_GLB_ENABLE_AUTORECONNECT, &stateGlobalGuard_enable_autoreconnect, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_AP_START, &stateGlobalGuard_AP, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_AP_STOP, &stateGlobalGuard_stop, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_CONF_MAX_STA, &stateGlobalGuard_conf_max_sta, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_DENOISE, &stateGlobalGuard_denoise, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_FW, (void*)WIFI_MGMR_EVENT_FW_DISCONNECT, &stateGlobalGuard_fw_disconnect, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_FW, (void*)WIFI_MGMR_EVENT_FW_POWERSAVING, &stateGlobalGuard_fw_powersaving, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_FW, (void*)WIFI_MGMR_EVENT_FW_SCAN, &stateGlobalGuard_fw_scan, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_FW,  (void*)WIFI_MGMR_EVENT_FW_DATA_RAW_SEND, &stateSnifferGuard_raw_send, &stateGlobalAction, &stateIdle},
-      {EVENT_TYPE_FW,  (void*)WIFI_MGMR_EVENT_FW_CFG_REQ, &stateGlobal_cfg_req, &stateGlobalAction, &stateIdle},
+      {WIFI_MGMR_EVENT_GLB_SCAN_IND_BEACON, NULL, NULL, &stateGlobalAction_scan_beacon, NULL, true},
+      {WIFI_MGMR_EVENT_GLB_DISABLE_AUTORECONNECT, NULL, &stateGlobalGuard_in_disconnect, &stateGlobalAction_disable_autoreconnect_idle, &stateIdle},
+      {WIFI_MGMR_EVENT_GLB_DISABLE_AUTORECONNECT, NULL, NULL, &stateGlobalAction_disable_autoreconnect, NULL, true},
+      {WIFI_MGMR_EVENT_GLB_ENABLE_AUTORECONNECT, NULL, NULL, &stateGlobalAction_enable_autoreconnect, NULL, true},
+      {WIFI_MGMR_EVENT_APP_AP_START, NULL, NULL, &stateGlobalAction_AP, NULL, true},
+      {WIFI_MGMR_EVENT_APP_AP_STOP, NULL, NULL, &stateGlobalAction_stop, NULL, true},
+      {WIFI_MGMR_EVENT_APP_CONF_MAX_STA, NULL, NULL, &stateGlobalAction_conf_max_sta, NULL, true},
+      {WIFI_MGMR_EVENT_APP_DENOISE, NULL, NULL, &stateGlobalAction_denoise, NULL, true},
+      {WIFI_MGMR_EVENT_FW_DISCONNECT, NULL, NULL, &stateGlobalAction_fw_disconnect, NULL, true},
+      {WIFI_MGMR_EVENT_FW_POWERSAVING, NULL, NULL, &stateGlobalAction_fw_powersaving, NULL, true},
+      {WIFI_MGMR_EVENT_FW_SCAN, NULL, NULL, &stateGlobalAction_fw_scan, NULL, true},
+      {WIFI_MGMR_EVENT_FW_DATA_RAW_SEND, NULL, &stateSnifferGuard_raw_send, &stateSnifferAction_raw_send, NULL, true},
+      {WIFI_MGMR_EVENT_FW_CFG_REQ, NULL, NULL, &stateGlobalAction_cfg_req, NULL, true},
    },
-   .numTransitions = 12,
+   .numTransitions = 13,
    .data = "group",
    .entryAction = &stateGlobalEnter,
    .exitAction = &stateGlobalExit,
+   .jumpTable = &stateGlobal_table,
 };
 
+STATEM_JUMP_TABLE(stateSniffer_table, WIFI_MGMR_EVENT_MAX, 2);
 static const struct state stateSniffer = {
    .parentState = &stateGlobal,
    .entryState = NULL,
    .transitions = (struct transition[])
    {
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_IDLE, &stateSnifferGuard, &stateSnifferAction, &stateIdle},
+      {WIFI_MGMR_EVENT_APP_IDLE, NULL, NULL, &stateSnifferAction, &stateIdle},
       /*Will NOT transfer state*/
-      {EVENT_TYPE_FW,  (void*)WIFI_MGMR_EVENT_FW_CHANNEL_SET, &stateSnifferGuard_ChannelSet, &stateSnifferAction, &stateIdle},
+      {WIFI_MGMR_EVENT_FW_CHANNEL_SET, NULL, NULL, &stateSnifferAction_ChannelSet, NULL, true},
    },
    .numTransitions = 2,
    .data = "sniffer",
    .entryAction = &stateSnifferEnter,
    .exitAction = &stateSnifferExit,
+   .jumpTable = &stateSniffer_table,
 };
 
+STATEM_JUMP_TABLE(stateConnecting_table, WIFI_MGMR_EVENT_MAX, 2);
 static const struct state stateConnecting = {
    .parentState = &stateGlobal,
    .entryState = NULL,
    .transitions = (struct transition[])
    {
-      {EVENT_TYPE_FW, (void*)WIFI_MGMR_EVENT_FW_IND_CONNECTED, &stateConnectingGuard, &stateConnectingAction_connected, &stateConnectedIPNo},
-      {EVENT_TYPE_FW, (void*)WIFI_MGMR_EVENT_FW_IND_DISCONNECT, &stateConnectingGuard, &stateConnectingAction_disconnect, &stateDisconnect},
+      {WIFI_MGMR_EVENT_FW_IND_CONNECTED, NULL, NULL, &stateConnectingAction_connected, &stateConnectedIPNo},
+      {WIFI_MGMR_EVENT_FW_IND_DISCONNECT, NULL, NULL, &stateConnectingAction_disconnect, &stateDisconnect},
    },
    .numTransitions = 2,
    .data = "connecting",
    .entryAction = &stateConnectingEnter,
    .exitAction = &stateConnectingExit,
+   .jumpTable = &stateConnecting_table,
 };
 
 /********************section for ilde *************************/
+/*the result of adding the STA interface decides the transition*/
 static bool stateIdleGuard_connect(void *ev, struct event *event )
 {
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ev != (void*)msg->ev) {
-        return false;
-    }
     if (bl_main_if_add(1, &wifiMgmr.wlan_sta.netif, &wifiMgmr.wlan_sta.vif_index)) {
         os_printf(DEBUG_HEADER "%s: add STA iface failed\r\n", __func__);
         return false;
@@ -686,19 +597,6 @@ static bool stateIdleGuard_connect(void *ev, struct event *event )
     return true;
 }
 
-static bool stateIdleGuard_sniffer(void *ev, struct event *event )
-{
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ev != (void*)msg->ev) {
-        return false;
-    }
-
-    bl_main_monitor();
-    return true;
-}
-
 static void stateIdleAction_connect( void *oldStateData, struct event *event,
       void *newStateData )
 {
@@ -747,6 +645,7 @@ static void stateIdleAction_connect( void *oldStateData, struct event *event,
 static void stateIdleAction_sniffer( void *oldStateData, struct event *event,
       void *newStateData )
 {
+    bl_main_monitor();
     os_printf(DEBUG_HEADER "State Action ###%s### --->>> ###%s###\r\n",
             (char*)oldStateData,
             (char*)newStateData
@@ -763,33 +662,29 @@ static void stateIdleExit( void *stateData, struct event *event )
    os_printf(DEBUG_HEADER "Entering %s state\r\n", (char *)stateData);
 }
 
+STATEM_JUMP_TABLE(stateIdle_table, WIFI_MGMR_EVENT_MAX, 2);
 static const struct state stateIdle = {
    .parentState = &stateGlobal,
    .entryState = NULL,
    .transitions = (struct transition[])
    {
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_CONNECT, &stateIdleGuard_connect, &stateIdleAction_connect, &stateConnecting},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_SNIFFER, &stateIdleGuard_sniffer, &stateIdleAction_sniffer, &stateSniffer},
+      {WIFI_MGMR_EVENT_APP_CONNECT, NULL, &stateIdleGuard_connect, &stateIdleAction_connect, &stateConnecting},
+      {WIFI_MGMR_EVENT_APP_SNIFFER, NULL, NULL, &stateIdleAction_sniffer, &stateSniffer},
    },
    .numTransitions = 2,
    .data = "idle",
    .entryAction = &stateIdleEnter,
    .exitAction = &stateIdleExit,
+   .jumpTable = &stateIdle_table,
 };
 /*==================================================================================================*/
 
 
 /********************section for ifacedown *************************/
+/*the result of the PHY up decides the transition*/
 static bool stateIfaceDownGuard_phyup(void *ev, struct event *event )
 {
     int error;
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ev != (void*)msg->ev) {
-        os_printf(DEBUG_HEADER "state mismatch\r\n");
-        return false;
-    }
 
     //TODO no such usage for function call
     error = bl_main_phy_up();
@@ -818,17 +713,19 @@ static void stateIfaceDownExit( void *stateData, struct event *event )
     os_printf(DEBUG_HEADER "Exiting %s state\r\n", (char *)stateData);
 }
 
+STATEM_JUMP_TABLE(stateIfaceDown_table, WIFI_MGMR_EVENT_MAX, 1);
 static const struct state stateIfaceDown = {
    .parentState = &stateGlobal,
    .entryState = NULL,
    .transitions = (struct transition[])
    {
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_PHY_UP, &stateIfaceDownGuard_phyup, &stateIfaceDownAction_phyup, &stateIdle},
+      {WIFI_MGMR_EVENT_APP_PHY_UP, NULL, &stateIfaceDownGuard_phyup, &stateIfaceDownAction_phyup, &stateIdle},
    },
    .numTransitions = 1,
    .data = "ifaceDown",
    .entryAction = &stateIfaceDownEnter,
    .exitAction = &stateIfaceDownExit,
+   .jumpTable = &stateIfaceDown_table,
 };
 /*==================================================================================================*/
 
@@ -850,29 +747,11 @@ static tsen_reload_data_t state_tsen_reload_data = {
 };
 
 
-static bool stateConnectedIPNoGuard(void *ch, struct event *event )
-{
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch == (void*)msg->ev) {
-        return true;
-    }
-    return false;
-}
-
-static bool stateConnectedIPNoGuard_disconnect(void *ch, struct event *event )
+static void stateConnectedAction_disconnect(void *oldStateData, struct event *event,
+      void *newStateData )
 {
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch != (void*)msg->ev) {
-        return false;
-    }
-
+    /*the firmware indicates the disconnection, which changes the state*/
     bl_main_disconnect();
-    /*will never trigger state change, since we just want to trigger the guard*/
-    return false;
 }
 
 static void stateConnectedIPNoAction_ipgot(void *oldStateData, struct event *event,
@@ -1044,19 +923,21 @@ static void stateConnectedIPNoExit(void *stateData, struct event *event )
     os_timer_delete_nodelay(&(stateConnectedIPNo_data->timer));//detach no stop
 }
 
+STATEM_JUMP_TABLE(stateConnectedIPNo_table, WIFI_MGMR_EVENT_MAX, 3);
 static const struct state stateConnectedIPNo = {
    .parentState = &stateGlobal,
    .entryState = NULL,
    .transitions = (struct transition[])
    {
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_IP_GOT, &stateConnectedIPNoGuard, &stateConnectedIPNoAction_ipgot, &stateConnectedIPYes},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_DISCONNECT, &stateConnectedIPNoGuard_disconnect, &stateConnectedIPNoAction_disconnect, &stateDisconnect},
-      {EVENT_TYPE_FW, (void*)WIFI_MGMR_EVENT_FW_IND_DISCONNECT, &stateConnectedIPNoGuard, &stateConnectedIPNoAction_disconnect, &stateDisconnect},
+      {WIFI_MGMR_EVENT_APP_IP_GOT, NULL, NULL, &stateConnectedIPNoAction_ipgot, &stateConnectedIPYes},
+      {WIFI_MGMR_EVENT_APP_DISCONNECT, NULL, NULL, &stateConnectedAction_disconnect, NULL, true},
+      {WIFI_MGMR_EVENT_FW_IND_DISCONNECT, NULL, NULL, &stateConnectedIPNoAction_disconnect, &stateDisconnect},
    },
    .numTransitions = 3,
    .data = &stateConnectedIPNo_data,
    .entryAction = &stateConnectedIPNoEnter,
    .exitAction = &stateConnectedIPNoExit,
+   .jumpTable = &stateConnectedIPNo_table,
 };
 /*==================================================================================================*/
 
@@ -1064,56 +945,14 @@ static const struct state stateConnectedIPNo = {
 
 
 /********************section for connected with IP address*************************/
-static bool stateConnectedIPYesGuard( void *ch, struct event *event )
-{
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch == (void*)msg->ev) {
-        return true;
-    }
-    return false;
-}
-
-static bool stateConnectedIPYesGuard_ip_update(void *ch, struct event *event)
-{
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch != (void*)msg->ev) {
-        return false;
-    }
-
-    return true;
-}
-
-static bool stateConnectedIPYesGuard_disconnect( void *ch, struct event *event )
-{
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch != (void*)msg->ev) {
-        return false;
-    }
-
-    bl_main_disconnect();
-    /*will never trigger state change, since we just want to trigger the guard*/
-    return false;
-}
-
-static bool stateConnectedIPYesGuard_rcconfig( void *ch, struct event *event )
+static void stateConnectedIPYesAction_rcconfig( void *oldStateData, struct event *event,
+      void *newStateData )
 {
     wifi_mgmr_msg_t *msg;
 
     msg = event->data;
-    if (ch != (void*)msg->ev) {
-        return false;
-    }
-
     os_printf(DEBUG_HEADER "rate config, use sta_idx 0, rate_config %04X\r\n", (unsigned int)(msg->data1));
     bl_main_rate_config(0, (uint32_t)msg->data1);
-    /*will never trigger state change, since we just want to trigger the guard*/
-    return false;
 }
 
 static void stateConnectedIPYes_action( void *oldStateData, struct event *event,
@@ -1153,20 +992,22 @@ static void stateConnectedIPYes_exit( void *stateData, struct event *event )
    }
 }
 
+STATEM_JUMP_TABLE(stateConnectedIPYes_table, WIFI_MGMR_EVENT_MAX, 4);
 static const struct state stateConnectedIPYes = {
    .parentState = &stateGlobal,
    .entryState = NULL,
    .transitions = (struct transition[])
    {
-      {EVENT_TYPE_GLB, (void*)WIFI_MGMR_EVENT_GLB_IP_UPDATE, &stateConnectedIPYesGuard_ip_update, &stateConnectedIPYes_action, &stateConnectedIPNo},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_DISCONNECT, &stateConnectedIPYesGuard_disconnect, &stateConnectedIPYes_action, &stateDisconnect},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_RC_CONFIG, &stateConnectedIPYesGuard_rcconfig, &stateConnectedIPYes_action, &stateDisconnect},
-      {EVENT_TYPE_FW, (void*)WIFI_MGMR_EVENT_FW_IND_DISCONNECT, &stateConnectedIPYesGuard, &stateConnectedIPYes_action, &stateDisconnect},
+      {WIFI_MGMR_EVENT_GLB_IP_UPDATE, NULL, NULL, &stateConnectedIPYes_action, &stateConnectedIPNo},
+      {WIFI_MGMR_EVENT_APP_DISCONNECT, NULL, NULL, &stateConnectedAction_disconnect, NULL, true},
+      {WIFI_MGMR_EVENT_APP_RC_CONFIG, NULL, NULL, &stateConnectedIPYesAction_rcconfig, NULL, true},
+      {WIFI_MGMR_EVENT_FW_IND_DISCONNECT, NULL, NULL, &stateConnectedIPYes_action, &stateDisconnect},
    },
    .numTransitions = 4,
    .data = "wifiConnected_IPOK",
    .entryAction = &stateConnectedIPYes_enter,
    .exitAction = &stateConnectedIPYes_exit,
+   .jumpTable = &stateConnectedIPYes_table,
 };
 /*==================================================================================================*/
 
@@ -1181,17 +1022,6 @@ static disconnectData_t stateDisconnect_data = {
     .name = "disconnect",
 };
 
-static bool stateDisconnect_guard( void *ch, struct event *event )
-{
-    wifi_mgmr_msg_t *msg;
-
-    msg = event->data;
-    if (ch == (void*)msg->ev) {
-        return true;
-    }
-    return false;
-}
-
 static void stateDisconnect_action_reconnect( void *oldStateData, struct event *event,
       void *newStateData )
 {
@@ -1309,18 +1139,20 @@ static void stateDisconnect_exit(void *stateData, struct event *event)
     }
 }
 
+STATEM_JUMP_TABLE(stateDisconnect_table, WIFI_MGMR_EVENT_MAX, 2);
 static const struct state stateDisconnect = {
    .parentState = &stateGlobal,
    .entryState = NULL,
    .transitions = (struct transition[])
    {
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_RECONNECT, &stateDisconnect_guard, &stateDisconnect_action_reconnect, &stateConnecting},
-      {EVENT_TYPE_APP, (void*)WIFI_MGMR_EVENT_APP_IDLE, &stateDisconnect_guard, &stateDisconnect_action_idle, &stateIdle},
+      {WIFI_MGMR_EVENT_APP_RECONNECT, NULL, NULL, &stateDisconnect_action_reconnect, &stateConnecting},
+      {WIFI_MGMR_EVENT_APP_IDLE, NULL, NULL, &stateDisconnect_action_idle, &stateIdle},
    },
    .numTransitions = 2,
    .data = &stateDisconnect_data,
    .entryAction = &stateDisconnect_enter,
    .exitAction = &stateDisconnect_exit,
+   .jumpTable = &stateDisconnect_table,
 };
 /*==================================================================================================*/
 
@@ -1329,17 +1161,28 @@ static const struct state stateError = {
    .entryAction = &printErrMsg
 };
 
-int wifi_mgmr_event_notify(wifi_mgmr_msg_t *msg)
+static struct stateM_eventStats wifi_mgmr_sm_stats[WIFI_MGMR_EVENT_MAX];
+
+void wifi_mgmr_sm_stats_dump(void)
 {
-    while (0 == wifiMgmr.ready) {
-        os_printf("Wait Wi-Fi Mgmr Start up...\r\n");
-        os_thread_delay(20);
-    }
-    if (os_mq_send(&(wifiMgmr.mq), msg, msg->len)) {
-        os_printf("Failed when send msg 0x%p, len dec:%u\r\n", msg, (unsigned int)msg->len);
-        return -1;
+    int i;
+    struct stateM_eventStats *st;
+
+    wifi_mgmr_chan_stats_dump(&(wifiMgmr.chan));
+    printf("event  dispatched    lookups     guards  transitions\r\n");
+    for (i = 0; i < WIFI_MGMR_EVENT_MAX; i++) {
+        st = &wifi_mgmr_sm_stats[i];
+        if (0 == st->dispatched) {
+            continue;
+        }
+        printf("%5d  %10lu %10lu %10lu %12lu\r\n",
+                i, st->dispatched, st->lookups, st->guards, st->transitions);
     }
-    return 0;
+}
+
+int wifi_mgmr_event_notify(wifi_mgmr_msg_t *msg)
+{
+    return wifi_mgmr_chan_post(&(wifiMgmr.chan), msg);
 }
 
 static void event_cb_wifi_event_mgmr(input_event_t *event, void *private_data)
@@ -1364,9 +1207,10 @@ void wifi_mgmr_start(void)
     wifi_mgmr_msg_t *msg;
 
     msg = (wifi_mgmr_msg_t*)(buffer + 1);
-    ev.type = EVENT_TYPE_APP;
+    ev.type = WIFI_MGMR_EVENT_APP_IDLE;
     ev.data = msg;
     stateM_init(&(wifiMgmr.m), &stateIfaceDown, &stateError);
+    stateM_setStats(&(wifiMgmr.m), wifi_mgmr_sm_stats, WIFI_MGMR_EVENT_MAX);
 
     /*register event cb for Wi-Fi Manager*/
     wifi_mgmr_event_init();
@@ -1384,15 +1228,14 @@ void wifi_mgmr_start(void)
 
     /*Run the event handler loop*/
     while (1) {
-        if (0 == os_mq_recv(&(wifiMgmr.mq), msg, WIFI_MGMR_MQ_MSG_SIZE)) {
+        if (0 == wifi_mgmr_chan_recv(&(wifiMgmr.chan), msg, WIFI_MGMR_MQ_MSG_SIZE)) {
             if (msg->ev == WIFI_MGMR_EVENT_APP_RELOAD_TSEN) {
                 __run_reload_tsen();
 
                 continue;
             }
 
-            ev.type = msg->ev < WIFI_MGMR_EVENT_MAXAPP_MINIFW ? EVENT_TYPE_APP :
-                (msg->ev < WIFI_MGMR_EVENT_MAXFW_MINI_GLOBAL ? EVENT_TYPE_FW : EVENT_TYPE_GLB);
+            ev.type = msg->ev;
             stateM_handleEvent(&(wifiMgmr.m), &ev);
         }
     }
@@ -1418,15 +1261,11 @@ int wifi_mgmr_init(void)
 {
     int ret;
 
-    ret = os_mq_init(
-            &(wifiMgmr.mq),
-            "wifiMgmr",
-            wifiMgmr.mq_pool,
-            WIFI_MGMR_MQ_MSG_SIZE,
-            sizeof(wifiMgmr.mq_pool)
-    );
-    wifiMgmr.ready = 1;//TODO check ret
     wifiMgmr.scan_item_timeout = WIFI_MGMR_CONFIG_SCAN_ITEM_TIMEOUT;
+    ret = wifi_mgmr_chan_init(&(wifiMgmr.chan));
+    if (ret) {
+        os_printf("Failed to init Wi-Fi Mgmr event channel\r\n");
+    }
     return ret;
 }
 
@@ -39,6 +39,8 @@
 #define WIFI_MGMR_PROFILES_MAX (2)
 #define WIFI_MGMR_MQ_MSG_SIZE (128 + 64 + 32)
 #define WIFI_MGMR_MQ_MSG_COUNT (10)
+#define WIFI_MGMR_CHAN_SCAN_SLOTS (16)
+#define WIFI_MGMR_CHAN_CTRL_TIMEOUT_MS (1000)
 
 /**
  ****************************************************************************************
@@ -97,6 +99,8 @@ typedef enum WIFI_MGMR_EVENT {
     WIFI_MGMR_EVENT_GLB_ENABLE_AUTORECONNECT,
     WIFI_MGMR_EVENT_GLB_IP_UPDATE,
 
+    /*Number of events, keep it last*/
+    WIFI_MGMR_EVENT_MAX,
 } WIFI_MGMR_EVENT_T;
 
 typedef enum WIFI_MGMR_CONNECTION_STATUS {
@@ -204,6 +208,40 @@ typedef struct wifi_mgmr_scan_item {
     uint32_t timestamp_lastseen;
 } wifi_mgmr_scan_item_t;
 
+/*Event channel from the driver and the APIs into the manager task.
+ *
+ * Control events go through a FIFO lane and are never reordered. Beacons
+ * and probe responses are merged per BSS into a small table by the producer
+ * and only a wakeup is signalled, the manager task drains control events
+ * first and then one scan entry at a time.
+ */
+typedef struct wifi_mgmr_chan_stats {
+    uint32_t ctrl_posted;
+    uint32_t ctrl_dropped;      /*lane full for WIFI_MGMR_CHAN_CTRL_TIMEOUT_MS*/
+    uint32_t scan_posted;
+    uint32_t scan_coalesced;    /*merged into an entry still pending*/
+    uint32_t scan_dropped;      /*new BSS while all slots are pending*/
+    uint32_t scan_delivered;
+} wifi_mgmr_chan_stats_t;
+
+typedef struct wifi_mgmr_chan {
+    volatile uint8_t ev_inited;
+    volatile uint8_t ready;
+    os_event_t ev;
+#define WIFI_MGMR_CHAN_EV_READY     (1 << 0)
+#define WIFI_MGMR_CHAN_EV_KICK      (1 << 1)
+    os_mutex_t ctrl_lock;
+    os_messagequeue_t mq;
+    uint8_t mq_pool[WIFI_MGMR_MQ_MSG_SIZE*WIFI_MGMR_MQ_MSG_COUNT];
+    /*scan lane, slots are delivered in the order the BSS first showed up*/
+    wifi_mgmr_scan_item_t scan[WIFI_MGMR_CHAN_SCAN_SLOTS];
+    uint32_t scan_used;
+    uint8_t scan_order[WIFI_MGMR_CHAN_SCAN_SLOTS];
+    uint8_t scan_head;
+    uint8_t scan_count;
+    wifi_mgmr_chan_stats_t stats;
+} wifi_mgmr_chan_t;
+
 struct wlan_netif {
     int mode;//0: sta; 1: ap
     uint8_t vif_index;
@@ -247,7 +285,6 @@ typedef struct wifi_mgmr_sta_basic_info {
 } wifi_mgmr_sta_basic_info_t;
 
 typedef struct wifi_mgmr {
-    uint8_t ready;//TODO mgmr init process
     /*filed for PHY*/
     int channel;
     int inf_ap_enabled;
@@ -260,8 +297,7 @@ typedef struct wifi_mgmr {
     int profile_active_index;
 
     wifi_mgmr_scan_item_t scan_items[WIFI_MGMR_SCAN_ITEMS_MAX];
-    os_messagequeue_t mq;
-    uint8_t mq_pool[WIFI_MGMR_MQ_MSG_SIZE*WIFI_MGMR_MQ_MSG_COUNT];
+    wifi_mgmr_chan_t chan;
     struct stateMachine m;
     os_timer_t timer;
     wifi_mgmr_connect_ind_stat_info_t wifi_mgmr_stat_info;
@@ -282,7 +318,13 @@ typedef struct wifi_mgmr {
 } wifi_mgmr_t;
 
 int wifi_mgmr_event_notify(wifi_mgmr_msg_t *msg);
+int wifi_mgmr_chan_init(wifi_mgmr_chan_t *chan);
+int wifi_mgmr_chan_post(wifi_mgmr_chan_t *chan, wifi_mgmr_msg_t *msg);
+int wifi_mgmr_chan_post_scan(wifi_mgmr_chan_t *chan, uint8_t channel, int8_t rssi, uint8_t auth, uint8_t mac[], uint8_t ssid[], int len, int8_t ppm_abs, int8_t ppm_rel, uint8_t cipher);
+int wifi_mgmr_chan_recv(wifi_mgmr_chan_t *chan, wifi_mgmr_msg_t *msg, int size);
+void wifi_mgmr_chan_stats_dump(wifi_mgmr_chan_t *chan);
 int wifi_mgmr_state_get_internal(int *state);
+void wifi_mgmr_sm_stats_dump(void);
 int wifi_mgmr_status_code_clean_internal(void);
 int wifi_mgmr_status_code_get_internal(int *s_code);
 int wifi_mgmr_set_country_code_internal(char *country_code);
@@ -295,29 +295,8 @@ int wifi_mgmr_api_sniffer_enable(void)
 
 int wifi_mgmr_api_scan_item_beacon(uint8_t channel, int8_t rssi, uint8_t auth, uint8_t mac[], uint8_t ssid[], int len, int8_t ppm_abs, int8_t ppm_rel, uint8_t cipher)
 {
-    wifi_mgmr_msg_t *msg;
-    wifi_mgmr_scan_item_t *scan;
-    uint8_t buffer[sizeof(wifi_mgmr_msg_t) + sizeof(wifi_mgmr_scan_item_t)];//XXX caution for stack overflow
-
-    memset(buffer, 0, sizeof(buffer));
-    msg = (wifi_mgmr_msg_t*)buffer;
-    msg->ev = WIFI_MGMR_EVENT_GLB_SCAN_IND_BEACON;
-    msg->data1 = (void*)0x11223344;
-    msg->data2 = (void*)0x55667788;
-    msg->len = sizeof(wifi_mgmr_msg_t) + sizeof(wifi_mgmr_scan_item_t);
-    scan = (wifi_mgmr_scan_item_t*)msg->data;
-    memcpy(scan->ssid, ssid, len);
-    scan->ssid_tail[0] = '\0';
-    scan->ssid_len = len;
-    memcpy(scan->bssid, mac, sizeof(scan->bssid));
-    scan->channel = channel;
-    scan->rssi = rssi;
-    scan->auth = auth;
-    scan->cipher = cipher;
-    scan->ppm_abs = ppm_abs;
-    scan->ppm_rel = ppm_rel;
-
-    wifi_mgmr_event_notify(msg);
+    /*merged into the scan lane, the manager task is only woken up*/
+    wifi_mgmr_chan_post_scan(&(wifiMgmr.chan), channel, rssi, auth, mac, ssid, len, ppm_abs, ppm_rel, cipher);
 
     return 0;
 }
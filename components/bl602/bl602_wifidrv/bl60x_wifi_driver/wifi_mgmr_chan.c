@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "wifi_mgmr.h"
+#include "os_hal.h"
+
+/*The event group doubles as the startup barrier, so it is created on first
+ *use by whoever comes first, producers may run before wifi_mgmr_init.
+ */
+static void chan_ev_init(wifi_mgmr_chan_t *chan)
+{
+    if (chan->ev_inited) {
+        return;
+    }
+    os_enter_critical();
+    if (0 == chan->ev_inited) {
+        os_event_init(&(chan->ev));
+        chan->ev_inited = 1;
+    }
+    os_exit_critical();
+}
+
+static void chan_wait_ready(wifi_mgmr_chan_t *chan)
+{
+    uint32_t bits;
+
+    if (chan->ready) {
+        return;
+    }
+    chan_ev_init(chan);
+    os_printf("Wait Wi-Fi Mgmr Start up...\r\n");
+    os_event_wait(&(chan->ev), WIFI_MGMR_CHAN_EV_READY, OS_WAITING_FOREVER, bits);
+    (void)bits;
+}
+
+int wifi_mgmr_chan_init(wifi_mgmr_chan_t *chan)
+{
+    int ret;
+
+    chan_ev_init(chan);
+    chan->ctrl_lock = os_mutex_create("wifiMgmrChan");
+    if (NULL == chan->ctrl_lock) {
+        return -1;
+    }
+    ret = os_mq_init(
+            &(chan->mq),
+            "wifiMgmr",
+            chan->mq_pool,
+            WIFI_MGMR_MQ_MSG_SIZE,
+            sizeof(chan->mq_pool)
+    );
+    if (ret) {
+        return ret;
+    }
+    chan->ready = 1;
+    os_event_send(&(chan->ev), WIFI_MGMR_CHAN_EV_READY);
+
+    return 0;
+}
+
+int wifi_mgmr_chan_post(wifi_mgmr_chan_t *chan, wifi_mgmr_msg_t *msg)
+{
+    int ret;
+
+    chan_wait_ready(chan);
+
+    /*the message buffer only supports one writer at a time*/
+    os_mutex_take(chan->ctrl_lock, OS_WAITING_FOREVER);
+    ret = os_mq_send_timeout(&(chan->mq), msg, msg->len, WIFI_MGMR_CHAN_CTRL_TIMEOUT_MS);
+    os_mutex_give(chan->ctrl_lock);
+    if (ret) {
+        chan->stats.ctrl_dropped++;
+        os_printf("Failed when send msg 0x%p, ev %d, len dec:%u\r\n", msg, msg->ev, (unsigned int)msg->len);
+        return -1;
+    }
+    chan->stats.ctrl_posted++;
+    os_event_send(&(chan->ev), WIFI_MGMR_CHAN_EV_KICK);
+
+    return 0;
+}
+
+/*same key as the scan_items table of the manager: bssid and ssid*/
+static int chan_scan_find(wifi_mgmr_chan_t *chan, uint8_t mac[], uint8_t ssid[], int len)
+{
+    int i, idx;
+    wifi_mgmr_scan_item_t *item;
+
+    for (i = 0; i < chan->scan_count; i++) {
+        idx = chan->scan_order[(chan->scan_head + i) % WIFI_MGMR_CHAN_SCAN_SLOTS];
+        item = &(chan->scan[idx]);
+        if (0 == memcmp(item->bssid, mac, sizeof(item->bssid)) &&
+                item->ssid_len == len && 0 == memcmp(item->ssid, ssid, len)) {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Called from the driver for every beacon and probe response. Never blocks:
+ * a BSS already pending is updated in place, a new BSS takes a free slot or
+ * is dropped when the manager task is that far behind.
+ */
+int wifi_mgmr_chan_post_scan(wifi_mgmr_chan_t *chan, uint8_t channel, int8_t rssi, uint8_t auth, uint8_t mac[], uint8_t ssid[], int len, int8_t ppm_abs, int8_t ppm_rel, uint8_t cipher)
+{
+    int idx, kick = 0;
+    wifi_mgmr_scan_item_t *item;
+
+    if (len < 0) {
+        len = 0;
+    } else if (len > sizeof(item->ssid)) {
+        len = sizeof(item->ssid);
+    }
+    chan_ev_init(chan);
+
+    os_enter_critical();
+    chan->stats.scan_posted++;
+    idx = chan_scan_find(chan, mac, ssid, len);
+    if (idx >= 0) {
+        chan->stats.scan_coalesced++;
+        item = &(chan->scan[idx]);
+        /*the manager would skip a weaker sample seen right after this one*/
+        if (rssi < item->rssi) {
+            os_exit_critical();
+            return 0;
+        }
+    } else if (chan->scan_count < WIFI_MGMR_CHAN_SCAN_SLOTS) {
+        for (idx = 0; chan->scan_used & (1 << idx); idx++) {
+        }
+        chan->scan_used |= (1 << idx);
+        chan->scan_order[(chan->scan_head + chan->scan_count) % WIFI_MGMR_CHAN_SCAN_SLOTS] = idx;
+        chan->scan_count++;
+        item = &(chan->scan[idx]);
+        memcpy(item->bssid, mac, sizeof(item->bssid));
+        memcpy(item->ssid, ssid, len);
+        memset(item->ssid + len, 0, sizeof(item->ssid) - len + sizeof(item->ssid_tail));
+        item->ssid_len = len;
+        kick = 1;
+    } else {
+        chan->stats.scan_dropped++;
+        os_exit_critical();
+        return -1;
+    }
+    item->channel = channel;
+    item->rssi = rssi;
+    item->auth = auth;
+    item->cipher = cipher;
+    item->ppm_abs = ppm_abs;
+    item->ppm_rel = ppm_rel;
+    os_exit_critical();
+
+    /*a pending entry already has a wakeup on the way*/
+    if (kick) {
+        os_event_send(&(chan->ev), WIFI_MGMR_CHAN_EV_KICK);
+    }
+    return 0;
+}
+
+static int chan_scan_pop(wifi_mgmr_chan_t *chan, wifi_mgmr_msg_t *msg, int size)
+{
+    int idx;
+    wifi_mgmr_msg_t hdr;
+
+    if (size < sizeof(wifi_mgmr_msg_t) + sizeof(wifi_mgmr_scan_item_t)) {
+        return -1;
+    }
+    os_enter_critical();
+    if (0 == chan->scan_count) {
+        os_exit_critical();
+        return -1;
+    }
+    idx = chan->scan_order[chan->scan_head];
+    chan->scan_head = (chan->scan_head + 1) % WIFI_MGMR_CHAN_SCAN_SLOTS;
+    chan->scan_count--;
+    memcpy(msg->data, &(chan->scan[idx]), sizeof(wifi_mgmr_scan_item_t));
+    chan->scan_used &= ~(1 << idx);
+    chan->stats.scan_delivered++;
+    os_exit_critical();
+
+    /*msg may be unaligned, see wifi_mgmr_start*/
+    hdr.ev = WIFI_MGMR_EVENT_GLB_SCAN_IND_BEACON;
+    hdr.data1 = (void*)0x11223344;
+    hdr.data2 = (void*)0x55667788;
+    hdr.len = sizeof(wifi_mgmr_msg_t) + sizeof(wifi_mgmr_scan_item_t);
+    memcpy(msg, &hdr, sizeof(hdr));
+
+    return 0;
+}
+
+/**
+ * Wait for the next event of the manager task. Control events always go
+ * first, so a connect request is never stuck behind a burst of beacons.
+ */
+int wifi_mgmr_chan_recv(wifi_mgmr_chan_t *chan, wifi_mgmr_msg_t *msg, int size)
+{
+    uint32_t bits;
+
+    chan_wait_ready(chan);
+    while (1) {
+        if (0 == os_mq_recv_timeout(&(chan->mq), msg, size, 0)) {
+            return 0;
+        }
+        if (0 == chan_scan_pop(chan, msg, size)) {
+            return 0;
+        }
+        /*a producer that posted since the checks above left the bit set*/
+        os_event_recv(&(chan->ev), WIFI_MGMR_CHAN_EV_KICK, OS_WAITING_FOREVER, bits);
+        (void)bits;
+    }
+}
+
+void wifi_mgmr_chan_stats_dump(wifi_mgmr_chan_t *chan)
+{
+    wifi_mgmr_chan_stats_t *st = &(chan->stats);
+
+    printf("ctrl: posted %lu dropped %lu\r\n",
+            (unsigned long)st->ctrl_posted, (unsigned long)st->ctrl_dropped);
+    printf("scan: posted %lu coalesced %lu dropped %lu delivered %lu pending %u\r\n",
+            (unsigned long)st->scan_posted, (unsigned long)st->scan_coalesced,
+            (unsigned long)st->scan_dropped, (unsigned long)st->scan_delivered,
+            chan->scan_count);
+}
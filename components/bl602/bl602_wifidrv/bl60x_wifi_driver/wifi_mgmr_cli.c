@@ -870,6 +870,11 @@ static void cmd_wifi_coex_pta_force_off(char *buf, int len, int argc, char **arg
     coex_wifi_pta_forece_enable(0);
 }
 
+static void cmd_wifi_sm_stat(char *buf, int len, int argc, char **argv)
+{
+    wifi_mgmr_sm_stats_dump();
+}
+
 static void cmd_wifi_state_get(char *buf, int len, int argc, char **argv)
 {
     int state = WIFI_STATE_UNKNOWN;
@@ -979,6 +984,7 @@ static const struct cli_command cmds_user[] STATIC_CLI_CMD_ATTRIBUTE = {
         { "wifi_sta_del", "delete one sta in AP mode", wifi_ap_sta_delete_cmd},
         { "wifi_edca_dump", "dump EDCA data", wifi_edca_dump_cmd},
         { "wifi_state", "get wifi_state", cmd_wifi_state_get},
+        { "wifi_sm_stat", "dump wifi state machine dispatch cost", cmd_wifi_sm_stat},
         { "wifi_update_power", "Power table test command", cmd_wifi_power_table_update},
 };
 
@@ -11,6 +11,7 @@ COMPONENT_SRCS := bl60x_wifi_driver/ipc_host.c \
 				  bl60x_wifi_driver/os_hal.c \
 				  bl60x_wifi_driver/bl_apis.c \
 				  bl60x_wifi_driver/bl_cmds.c \
+				  bl60x_wifi_driver/bl_ie.c \
 				  bl60x_wifi_driver/bl_irqs.c \
 				  bl60x_wifi_driver/bl_main.c \
 				  bl60x_wifi_driver/bl_mod_params.c \
@@ -25,6 +26,7 @@ COMPONENT_SRCS := bl60x_wifi_driver/ipc_host.c \
 				  bl60x_wifi_driver/wifi.c \
 				  bl60x_wifi_driver/wifi_mgmr.c \
 				  bl60x_wifi_driver/wifi_mgmr_api.c \
+				  bl60x_wifi_driver/wifi_mgmr_chan.c \
 				  bl60x_wifi_driver/wifi_mgmr_cli.c \
 				  bl60x_wifi_driver/wifi_mgmr_ext.c \
 				  bl60x_wifi_driver/wifi_mgmr_profile.c \
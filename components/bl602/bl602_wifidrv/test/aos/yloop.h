@@ -0,0 +1,37 @@
+/* Host test stand-in for the sources under test */
+#ifndef TEST_AOS_YLOOP_H
+#define TEST_AOS_YLOOP_H
+
+#include <stdint.h>
+
+#define  EV_WIFI                  0x0002
+#define  CODE_WIFI_ON_INIT_DONE   1
+#define  CODE_WIFI_ON_MGMR_DONE   2
+#define  CODE_WIFI_CMD_RECONNECT  3
+#define  CODE_WIFI_ON_CONNECTED   4
+#define  CODE_WIFI_ON_DISCONNECT  5
+#define  CODE_WIFI_ON_PRE_GOT_IP  6
+#define  CODE_WIFI_ON_GOT_IP      7
+#define  CODE_WIFI_ON_CONNECTING  8
+#define  CODE_WIFI_ON_SCAN_DONE   9
+#define  CODE_WIFI_ON_AP_STARTED        11
+#define  CODE_WIFI_ON_AP_STOPPED        12
+#define  CODE_WIFI_ON_MGMR_DENOISE      20
+#define  CODE_WIFI_ON_EMERGENCY_MAC     23
+
+typedef struct {
+    uint32_t time;
+    uint16_t type;
+    uint16_t code;
+    unsigned long value;
+    unsigned long extra;
+} input_event_t;
+
+typedef void (*aos_event_cb)(input_event_t *event, void *private_data);
+typedef void (*aos_call_t)(void *arg);
+
+int aos_register_event_filter(uint16_t type, aos_event_cb cb, void *priv);
+int aos_post_event(uint16_t type, uint16_t code, unsigned long value);
+int aos_post_delayed_action(int ms, aos_call_t action, void *arg);
+
+#endif
@@ -0,0 +1,11 @@
+/* Host test stand-in for the sources under test */
+#ifndef TEST_BL60X_FW_API_H
+#define TEST_BL60X_FW_API_H
+
+#define WLAN_FW_SUCCESSFUL                                        0
+#define WLAN_FW_4WAY_HANDSHAKE_ERROR_PSK_TIMEOUT_FAILURE          8
+#define WLAN_FW_SCAN_NO_BSSID_AND_CHANNEL                        12
+
+int bl60x_check_mac_status(int *is_ok);
+
+#endif
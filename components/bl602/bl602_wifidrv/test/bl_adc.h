@@ -0,0 +1,9 @@
+/* Host test stand-in for the sources under test */
+#ifndef TEST_BL_ADC_H
+#define TEST_BL_ADC_H
+
+#include <stdint.h>
+
+int bl_tsen_adc_get(int16_t *temp, uint8_t log_flag);
+
+#endif
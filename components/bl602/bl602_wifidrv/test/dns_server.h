@@ -0,0 +1,7 @@
+/* Host test stand-in for the sources under test */
+#ifndef TEST_DNS_SERVER_H
+#define TEST_DNS_SERVER_H
+
+void dns_server_init(void);
+
+#endif
@@ -0,0 +1,9 @@
+/* Host test stand-in for the sources under test */
+#ifndef TEST_HAL_SYS_H
+#define TEST_HAL_SYS_H
+
+#include <stdint.h>
+
+void hal_sys_capcode_update(uint8_t capin, uint8_t capout);
+
+#endif
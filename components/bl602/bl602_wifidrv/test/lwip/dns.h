@@ -0,0 +1,10 @@
+/* Host test stand-in for the sources under test, the calls are traced */
+#ifndef TEST_LWIP_DNS_H
+#define TEST_LWIP_DNS_H
+
+void test_trace(const char *fmt, ...);
+
+#define dns_setserver(numdns, dnsserver) \
+    test_trace("dns %d %08x", numdns, (unsigned)(dnsserver)->addr)
+
+#endif
@@ -0,0 +1,20 @@
+/* Host test stand-in for the sources under test */
+#ifndef TEST_LWIP_NETIF_H
+#define TEST_LWIP_NETIF_H
+
+#include <stdint.h>
+
+typedef int8_t err_t;
+
+typedef struct ip4_addr {
+    uint32_t addr;
+} ip4_addr_t;
+
+#define ip4_addr_set_u32(dest, src) ((dest)->addr = (src))
+#define ip4_addr_set_any(ipaddr) ((ipaddr)->addr = 0)
+
+struct netif {
+    ip4_addr_t ip_addr;
+};
+
+#endif
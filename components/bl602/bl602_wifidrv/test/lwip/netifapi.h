@@ -0,0 +1,17 @@
+/* Host test stand-in for the sources under test, the calls are traced */
+#ifndef TEST_LWIP_NETIFAPI_H
+#define TEST_LWIP_NETIFAPI_H
+
+#include <lwip/netif.h>
+
+void test_trace(const char *fmt, ...);
+
+#define netifapi_netif_set_link_up(n) test_trace("netif link up")
+#define netifapi_netif_common(n, voidfunc, errtfunc) test_trace("netif common")
+#define netifapi_netif_remove(n) test_trace("netif remove")
+#define netifapi_dhcp_stop(n) test_trace("dhcp stop")
+#define netifapi_netif_set_addr(n, ipaddr, netmask, gw) \
+    test_trace("netif addr %08x", (unsigned)(ipaddr)->addr)
+#define netifapi_netif_set_default(n) test_trace("netif default")
+
+#endif
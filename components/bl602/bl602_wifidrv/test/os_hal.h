@@ -0,0 +1,145 @@
+/* Host test stand-in for the sources under test. The real os_hal.h sits
+ * next to them and wins for their quoted includes, so its guard is taken
+ * here. Events, the message buffer and the critical section run on one
+ * thread: a wait that would block calls os_would_block() of the test.
+ */
+#ifndef TEST_OS_HAL_H
+#define TEST_OS_HAL_H
+#define __OS_HAL_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* calls out of the code under test, the test decides what they do */
+void test_trace(const char *fmt, ...);
+void os_would_block(void);
+
+extern uint32_t test_tick;
+extern int test_critical;
+
+#define os_printf(...) do {} while (0)
+#define os_malloc malloc
+#define os_free free
+#define os_tick_get() (test_tick)
+#define os_thread_delay(ticks) do {} while (0)
+#define os_thread_create(...) do {} while (0)
+#define OS_WAITING_FOREVER 0xffffffffu
+
+#define os_enter_critical() (test_critical++)
+#define os_exit_critical() (test_critical--)
+#define taskENTER_CRITICAL() os_enter_critical()
+#define taskEXIT_CRITICAL() os_exit_critical()
+
+typedef uint32_t os_event_t;
+#define os_event_init(ev) (*(ev) = 0)
+#define os_event_send(ev, bits) (*(ev) |= (bits))
+#define os_event_recv(ev, bits, timeout, val) do { \
+    if (!(*(ev) & (bits))) { \
+        os_would_block(); \
+    } \
+    val = *(ev); \
+    *(ev) &= ~(bits); \
+} while (0)
+#define os_event_wait(ev, bits, timeout, val) do { \
+    if ((*(ev) & (bits)) != (bits)) { \
+        os_would_block(); \
+    } \
+    val = *(ev); \
+} while (0)
+
+typedef int *os_mutex_t;
+extern int test_mutex;
+#define os_mutex_create(name) (&test_mutex)
+#define os_mutex_take(m, timeout) ((void)(*(m))++)
+#define os_mutex_give(m) ((void)(*(m))--)
+
+/* FreeRTOS message buffer: a byte ring of length word and message */
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t head;
+    uint32_t used;
+} os_messagequeue_t;
+
+static inline void test_mq_copy(os_messagequeue_t *mq, uint32_t off, uint8_t *dst,
+        const uint8_t *src, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        if (src) {
+            mq->buf[(off + i) % mq->size] = src[i];
+        } else {
+            dst[i] = mq->buf[(off + i) % mq->size];
+        }
+    }
+}
+
+static inline int test_mq_send(os_messagequeue_t *mq, const void *msg, uint32_t len)
+{
+    uint32_t tail = mq->head + mq->used;
+
+    if (mq->size - mq->used < len + 4) {
+        return 1;
+    }
+    test_mq_copy(mq, tail, NULL, (const uint8_t *)&len, 4);
+    test_mq_copy(mq, tail + 4, NULL, msg, len);
+    mq->used += len + 4;
+    return 0;
+}
+
+static inline int test_mq_recv(os_messagequeue_t *mq, void *msg, uint32_t len,
+        uint32_t timeout)
+{
+    uint32_t msg_len;
+
+    if (!mq->used) {
+        if (timeout) {
+            os_would_block();
+        }
+        return 1;
+    }
+    test_mq_copy(mq, mq->head, (uint8_t *)&msg_len, NULL, 4);
+    if (msg_len > len) {
+        return 1;
+    }
+    test_mq_copy(mq, mq->head + 4, msg, NULL, msg_len);
+    mq->head = (mq->head + 4 + msg_len) % mq->size;
+    mq->used -= 4 + msg_len;
+    return 0;
+}
+
+#define os_mq_init(mq, name, buffer, msgsize, buffersize) \
+    ((mq)->buf = (buffer), (mq)->size = (buffersize), (mq)->head = (mq)->used = 0, 0)
+#define os_mq_send(mq, msg, len) test_mq_send(mq, msg, len)
+#define os_mq_recv(mq, msg, len) test_mq_recv(mq, msg, len, OS_WAITING_FOREVER)
+#define os_mq_send_timeout(mq, msg, len, timeout) test_mq_send(mq, msg, len)
+#define os_mq_recv_timeout(mq, msg, len, timeout) test_mq_recv(mq, msg, len, timeout)
+
+/* timers only record what they were asked, the test fires them */
+typedef struct {
+    void (*cb)(void *data);
+    void *data;
+    uint32_t ticks;
+    int started;
+} os_timer_t;
+typedef void *timer_cb_arg_t;
+#define OS_TIMER_TYPE_ONESHOT 0
+#define OS_TIMER_TYPE_REPEATED 1
+#define os_timer_init(timer, name, callback, param, period, type) do { \
+    (timer)->cb = (void (*)(void *))(callback); \
+    (timer)->data = (param); \
+    (timer)->ticks = (period); \
+    test_trace("timer %s %u", name, (unsigned)(period)); \
+} while (0)
+#define os_timer_start(timer) ((timer)->started = 1)
+#define os_timer_delete(timer) os_timer_delete_nodelay(timer)
+#define os_timer_delete_nodelay(timer) do { \
+    (timer)->started = 0; \
+    test_trace("timer delete"); \
+} while (0)
+#define os_timer_data(data) (data)
+
+#endif
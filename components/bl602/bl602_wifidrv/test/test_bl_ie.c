@@ -0,0 +1,477 @@
+/*
+ * Host test, fuzz harness and benchmark of the scan result IE parser.
+ *
+ * A corpus of beacon bodies (WPA2 home AP, mixed WPA/WPA2, enterprise
+ * with MFP, SAE, open with a hidden SSID, one crowded with vendor
+ * elements, a truncated one and RSN elements cut short or malformed) is checked for
+ * the elements and suites found. Then mutated beacons go through the fuzz
+ * target, each in a heap block of its exact size, and bl_ie_parse() has
+ * to record the same elements as a plain walk. The benchmark times the
+ * corpus against the four separate element walks bl_rx.c used to do,
+ * built with -Os like the firmware. From this directory:
+ *
+ *   gcc -Os -I../bl60x_wifi_driver test_bl_ie.c ../bl60x_wifi_driver/bl_ie.c \
+ *       -o test_bl_ie
+ *   ./test_bl_ie [mutations]
+ *
+ * Add -fsanitize=address,undefined for the mutation run. The same file is
+ * a libFuzzer target and an AFL program:
+ *
+ *   clang -DBL_IE_LIBFUZZER -fsanitize=fuzzer,address,undefined \
+ *       -I../bl60x_wifi_driver test_bl_ie.c ../bl60x_wifi_driver/bl_ie.c \
+ *       -o fuzz_bl_ie
+ *   ./test_bl_ie -w corpus && ./fuzz_bl_ie corpus
+ *
+ *   afl-fuzz -i corpus -o findings -- ./test_bl_ie @@
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bl_ie.h"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+#define RSN_CCMP_PSK \
+    48, 20, 1, 0, 0x00, 0x0f, 0xac, 4, 1, 0, 0x00, 0x0f, 0xac, 4, \
+    1, 0, 0x00, 0x0f, 0xac, 2, 0x0c, 0
+#define WPA_TKIP_PSK \
+    221, 22, 0x00, 0x50, 0xf2, 1, 1, 0, 0x00, 0x50, 0xf2, 2, \
+    1, 0, 0x00, 0x50, 0xf2, 2, 1, 0, 0x00, 0x50, 0xf2, 2
+#define HT_CAP \
+    45, 26, 0xad, 0x01, 0x17, 0xff, 0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, \
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+#define HT_OP \
+    61, 22, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+#define WMM \
+    221, 24, 0x00, 0x50, 0xf2, 2, 1, 1, 0, 0, 3, 0xa4, 0, 0, 0x27, 0xa4, \
+    0, 0, 0x42, 0x43, 0x5e, 0, 0x62, 0x32, 0x2f, 0
+#define WPS \
+    221, 9, 0x00, 0x50, 0xf2, 4, 0x10, 0x4a, 0, 1, 0x10
+#define RATES \
+    1, 8, 0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18, 0x24
+#define VENDOR(n) \
+    221, 8, 0x00, 0x10, 0x18, n, 1, 2, 3, 4
+
+static const uint8_t home[] = {
+    0, 8, 'H', 'o', 'm', 'e', 'W', 'i', 'F', 'i', RATES, 3, 1, 6,
+    5, 4, 0, 1, 0, 0, 7, 6, 'C', 'N', 0x20, 1, 13, 20, 42, 1, 0,
+    RSN_CCMP_PSK, HT_CAP, HT_OP, WMM, WPS,
+};
+
+static const uint8_t mixed[] = {
+    0, 5, 'm', 'i', 'x', 'e', 'd', RATES, 3, 1, 11,
+    /* WPA TKIP, RSN TKIP and CCMP pairwise with a TKIP group */
+    WPA_TKIP_PSK,
+    48, 24, 1, 0, 0x00, 0x0f, 0xac, 2, 2, 0, 0x00, 0x0f, 0xac, 2,
+    0x00, 0x0f, 0xac, 4, 1, 0, 0x00, 0x0f, 0xac, 2, 0, 0, WMM,
+};
+
+static const uint8_t enterprise[] = {
+    0, 4, 'c', 'o', 'r', 'p', RATES, 3, 1, 36,
+    /* 802.1X and 802.1X-SHA256, MFP required */
+    48, 24, 1, 0, 0x00, 0x0f, 0xac, 4, 1, 0, 0x00, 0x0f, 0xac, 4,
+    2, 0, 0x00, 0x0f, 0xac, 1, 0x00, 0x0f, 0xac, 5, 0xc0, 0,
+    HT_CAP, HT_OP, 191, 12, 0x91, 0x59, 0x82, 0x0f, 0xea, 0xff, 0, 0,
+    0xea, 0xff, 0, 0, 192, 5, 1, 42, 0, 0xfc, 0xff, WMM,
+};
+
+static const uint8_t sae[] = {
+    0, 3, 'w', 'p', '3', RATES, 3, 1, 1,
+    /* MFP capable, not required */
+    48, 20, 1, 0, 0x00, 0x0f, 0xac, 4, 1, 0, 0x00, 0x0f, 0xac, 4,
+    1, 0, 0x00, 0x0f, 0xac, 8, 0x80, 0,
+};
+
+static const uint8_t hidden[] = {
+    0, 0, RATES, 3, 1, 6, 5, 4, 0, 1, 0, 0,
+};
+
+static const uint8_t crowded[] = {
+    0, 8, 'C', 'r', 'o', 'w', 'd', 'e', 'd', '!', RATES, 3, 1, 6,
+    VENDOR(1), VENDOR(2), VENDOR(3), VENDOR(4), VENDOR(5), VENDOR(6),
+    VENDOR(7), VENDOR(8), VENDOR(9), VENDOR(10), VENDOR(11), VENDOR(12),
+    HT_CAP, HT_OP, WPA_TKIP_PSK, RSN_CCMP_PSK, WMM, WPS,
+    /* a second SSID, the first one counts */
+    0, 3, 'b', 'a', 'd',
+};
+
+static const uint8_t truncated[] = {
+    0, 5, 't', 'r', 'u', 'n', 'c', 3, 1, 6,
+    48, 20, 1, 0, 0x00, 0x0f, 0xac, 4,
+};
+
+/* RSN of version only, defaults to CCMP */
+static const uint8_t rsn_short[] = {
+    0, 1, 's', 48, 2, 1, 0,
+    221, 10, 0x00, 0x50, 0xf2, 1, 1, 0, 0x00, 0x50, 0xf2, 2,
+};
+
+/* a pairwise count running past the element */
+static const uint8_t rsn_bad_count[] = {
+    0, 1, 'b', 48, 12, 1, 0, 0x00, 0x0f, 0xac, 4, 9, 0, 0x00, 0x0f, 0xac, 4,
+};
+
+/* half a group suite */
+static const uint8_t rsn_odd[] = {
+    0, 1, 'o', 48, 4, 1, 0, 0x00, 0x0f,
+};
+
+static const struct beacon {
+    const char *name;
+    const uint8_t *buf;
+    int len;
+    int elements;
+    int slot_len[BL_IE_SLOT_MAX];      /* -1 absent */
+    int rsn_err, wpa_err;
+    struct bl_ie_suites rsn, wpa;
+} corpus[] = {
+#define BEACON(b) .name = #b, .buf = b, .len = sizeof(b)
+    {
+        BEACON(home), .elements = 11,
+        .slot_len = { 8, 1, 6, 26, 20, 22, -1, -1, -1, 24, 9 },
+        .rsn = { BL_IE_CIPHER_CCMP, BL_IE_CIPHER_CCMP, BL_IE_AKM_PSK, 0 },
+    },
+    {
+        BEACON(mixed), .elements = 6,
+        .slot_len = { 5, 1, -1, -1, 24, -1, -1, -1, 22, 24, -1 },
+        .rsn = { BL_IE_CIPHER_TKIP, BL_IE_CIPHER_TKIP | BL_IE_CIPHER_CCMP, BL_IE_AKM_PSK, 0 },
+        .wpa = { BL_IE_CIPHER_TKIP, BL_IE_CIPHER_TKIP, BL_IE_AKM_PSK, 0 },
+    },
+    {
+        BEACON(enterprise), .elements = 9,
+        .slot_len = { 4, 1, -1, 26, 24, 22, 12, 5, -1, 24, -1 },
+        .rsn = { BL_IE_CIPHER_CCMP, BL_IE_CIPHER_CCMP, BL_IE_AKM_8021X, 1 },
+    },
+    {
+        BEACON(sae), .elements = 4,
+        .slot_len = { 3, 1, -1, -1, 20, -1, -1, -1, -1, -1, -1 },
+        .rsn = { BL_IE_CIPHER_CCMP, BL_IE_CIPHER_CCMP, BL_IE_AKM_SAE, 0 },
+    },
+    {
+        BEACON(hidden), .elements = 4,
+        .slot_len = { 0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+    },
+    {
+        BEACON(crowded), .elements = 22,
+        .slot_len = { 8, 1, -1, 26, 20, 22, -1, -1, 22, 24, 9 },
+        .rsn = { BL_IE_CIPHER_CCMP, BL_IE_CIPHER_CCMP, BL_IE_AKM_PSK, 0 },
+        .wpa = { BL_IE_CIPHER_TKIP, BL_IE_CIPHER_TKIP, BL_IE_AKM_PSK, 0 },
+    },
+    {
+        BEACON(truncated), .elements = 2,
+        .slot_len = { 5, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+    },
+    {
+        BEACON(rsn_short), .elements = 3,
+        .slot_len = { 1, -1, -1, -1, 2, -1, -1, -1, 10, -1, -1 },
+        .rsn = { BL_IE_CIPHER_CCMP, BL_IE_CIPHER_CCMP, 0, 0 },
+        .wpa = { BL_IE_CIPHER_TKIP, BL_IE_CIPHER_TKIP, 0, 0 },
+    },
+    {
+        BEACON(rsn_bad_count), .elements = 2,
+        .slot_len = { 1, -1, -1, -1, 12, -1, -1, -1, -1, -1, -1 },
+        .rsn_err = -1,
+    },
+    {
+        BEACON(rsn_odd), .elements = 2,
+        .slot_len = { 1, -1, -1, -1, 4, -1, -1, -1, -1, -1, -1 },
+        .rsn_err = -1,
+    },
+};
+
+#define CORPUS_SIZE (int)(sizeof(corpus) / sizeof(corpus[0]))
+
+static void test_corpus(void)
+{
+    struct bl_ie_index idx;
+    struct bl_ie_suites s;
+    int i, slot;
+
+    for (i = 0; i < CORPUS_SIZE; i++) {
+        const struct beacon *b = &corpus[i];
+
+        CHECK(bl_ie_parse(b->buf, b->len, &idx) == b->elements,
+              "%s: element count", b->name);
+        for (slot = 0; slot < BL_IE_SLOT_MAX; slot++) {
+            CHECK(bl_ie_len(&idx, slot) == b->slot_len[slot],
+                  "%s: slot %d length %d", b->name, slot, bl_ie_len(&idx, slot));
+        }
+
+        if (bl_ie_get(&idx, BL_IE_RSN)) {
+            CHECK(bl_ie_parse_rsn(bl_ie_get(&idx, BL_IE_RSN), &s) == b->rsn_err,
+                  "%s: RSN result", b->name);
+            CHECK(b->rsn_err || !memcmp(&s, &b->rsn, sizeof(s)),
+                  "%s: RSN group %x pairwise %x akm %x mfp %d", b->name,
+                  s.group, s.pairwise, s.akm, s.mfp_required);
+        }
+        if (bl_ie_get(&idx, BL_IE_WPA)) {
+            CHECK(bl_ie_parse_wpa(bl_ie_get(&idx, BL_IE_WPA), &s) == b->wpa_err,
+                  "%s: WPA result", b->name);
+            CHECK(b->wpa_err || !memcmp(&s, &b->wpa, sizeof(s)),
+                  "%s: WPA group %x pairwise %x akm %x", b->name,
+                  s.group, s.pairwise, s.akm);
+        }
+    }
+
+    /* the first SSID wins */
+    bl_ie_parse(crowded, sizeof(crowded), &idx);
+    CHECK(!memcmp(bl_ie_get(&idx, BL_IE_SSID) + 2, "Crowded!", 8), "second SSID used");
+}
+
+/* The elements bl_ie_parse() should record, by a plain walk */
+static int slot_of(const uint8_t *e)
+{
+    static const uint8_t wfa[3] = { 0x00, 0x50, 0xf2 };
+
+    switch (e[0]) {
+    case 0: return BL_IE_SSID;
+    case 3: return BL_IE_DS;
+    case 7: return BL_IE_COUNTRY;
+    case 45: return BL_IE_HT_CAP;
+    case 48: return BL_IE_RSN;
+    case 61: return BL_IE_HT_OP;
+    case 191: return BL_IE_VHT_CAP;
+    case 192: return BL_IE_VHT_OP;
+    case 221:
+        if (e[1] < 4 || memcmp(&e[2], wfa, 3)) {
+            return -1;
+        }
+        return e[5] == 1 ? BL_IE_WPA : e[5] == 2 ? BL_IE_WMM :
+               e[5] == 4 ? BL_IE_WPS : -1;
+    }
+
+    return -1;
+}
+
+static void walk(const uint8_t *buf, int len, const uint8_t **ie, int *count)
+{
+    int off = 0, slot;
+
+    memset(ie, 0, BL_IE_SLOT_MAX * sizeof(*ie));
+    *count = 0;
+
+    while (off + 2 <= len && off + 2 + buf[off + 1] <= len) {
+        slot = slot_of(&buf[off]);
+        if (slot >= 0 && !ie[slot]) {
+            ie[slot] = &buf[off];
+        }
+        off += 2 + buf[off + 1];
+        (*count)++;
+    }
+}
+
+static volatile unsigned sink;
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    struct bl_ie_index idx;
+    struct bl_ie_suites s;
+    const uint8_t *ref[BL_IE_SLOT_MAX], *ie;
+    int count, ref_count, slot, i;
+    uint8_t *buf;
+
+    if (size > 2048) {
+        return 0;
+    }
+
+    /* exact size, so that the sanitizers see any overread */
+    buf = malloc(size ? size : 1);
+    memcpy(buf, data, size);
+
+    count = bl_ie_parse(buf, size, &idx);
+    walk(buf, size, ref, &ref_count);
+    for (slot = 0; slot < BL_IE_SLOT_MAX; slot++) {
+        if (bl_ie_get(&idx, slot) != ref[slot]) {
+            break;
+        }
+    }
+    if (count != ref_count || slot < BL_IE_SLOT_MAX) {
+        printf("FAIL bl_ie_parse and the plain walk differ on %u bytes\r\n",
+               (unsigned)size);
+        abort();
+    }
+
+    for (slot = 0; slot < BL_IE_SLOT_MAX; slot++) {
+        ie = bl_ie_get(&idx, slot);
+        for (i = 0; ie && i < ie[1] + 2; i++) {
+            sink += ie[i];
+        }
+    }
+    if (bl_ie_get(&idx, BL_IE_RSN)) {
+        sink += bl_ie_parse_rsn(bl_ie_get(&idx, BL_IE_RSN), &s) + s.pairwise;
+    }
+    if (bl_ie_get(&idx, BL_IE_WPA)) {
+        sink += bl_ie_parse_wpa(bl_ie_get(&idx, BL_IE_WPA), &s) + s.pairwise;
+    }
+
+    free(buf);
+    return 0;
+}
+
+#ifndef BL_IE_LIBFUZZER
+static void fuzz(long mutations)
+{
+    uint8_t buf[512];
+    long n;
+    int len, m;
+
+    for (n = 0; n < mutations; n++) {
+        const struct beacon *b = &corpus[rand() % CORPUS_SIZE];
+
+        len = b->len + rand() % 16 - 8;
+        if (len < 0) {
+            len = 0;
+        }
+        for (m = 0; m < len; m++) {
+            buf[m] = m < b->len ? b->buf[m] : rand();
+        }
+        for (m = rand() % 8; m && len; m--) {
+            int p = rand() % len;
+
+            switch (rand() % 3) {
+            case 0:
+                buf[p] = rand();
+                break;
+            case 1:
+                buf[p] ^= 1 << (rand() % 8);
+                break;
+            default:
+                buf[p] = (rand() % 2) ? 0 : 0xff;
+                break;
+            }
+        }
+
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+}
+
+static double secs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* find_ie_ssid(), find_ie_ds(), mac_ie_find() and mac_vsie_find() */
+static int old_find(const uint8_t *b, int len, int id, const uint8_t *oui)
+{
+    int i = 0;
+
+    while (i + 2 <= len) {
+        if (b[i] == id && (!oui || (b[i + 1] >= 4 && !memcmp(&b[i + 2], oui, 4)))) {
+            return i;
+        }
+        i += b[i + 1] + 2;
+    }
+
+    return -1;
+}
+
+static void bench(long rounds)
+{
+    static const uint8_t wpa_oui[4] = { 0x00, 0x50, 0xf2, 1 };
+    struct bl_ie_index idx;
+    double t0, walks, one;
+    long r;
+    int i, bytes = 0;
+
+    for (i = 0; i < CORPUS_SIZE; i++) {
+        bytes += corpus[i].len;
+    }
+
+    t0 = secs();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < CORPUS_SIZE; i++) {
+            const struct beacon *b = &corpus[i];
+
+            sink += old_find(b->buf, b->len, 0, NULL) +
+                    old_find(b->buf, b->len, 3, NULL) +
+                    old_find(b->buf, b->len, 48, NULL) +
+                    old_find(b->buf, b->len, 221, wpa_oui);
+        }
+    }
+    walks = secs() - t0;
+
+    t0 = secs();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < CORPUS_SIZE; i++) {
+            sink += bl_ie_parse(corpus[i].buf, corpus[i].len, &idx);
+        }
+    }
+    one = secs() - t0;
+
+    printf("%d beacons of %d bytes on average: four walks %.1f ns, one pass %.1f ns\r\n",
+           CORPUS_SIZE, bytes / CORPUS_SIZE, walks / rounds / CORPUS_SIZE * 1e9,
+           one / rounds / CORPUS_SIZE * 1e9);
+}
+
+/* -w dir writes the corpus as fuzzer seeds, file arguments are run
+ * through the fuzz target as AFL does
+ */
+static int files(int argc, char *argv[])
+{
+    static uint8_t data[2048];
+    char path[256];
+    FILE *f;
+    size_t size;
+    int i;
+
+    if (!strcmp(argv[1], "-w") && argc == 3) {
+        for (i = 0; i < CORPUS_SIZE; i++) {
+            snprintf(path, sizeof(path), "%s/%s", argv[2], corpus[i].name);
+            f = fopen(path, "wb");
+            if (!f || fwrite(corpus[i].buf, corpus[i].len, 1, f) != 1) {
+                printf("cannot write %s\r\n", path);
+                return 1;
+            }
+            fclose(f);
+        }
+        return 0;
+    }
+
+    for (i = 1; i < argc; i++) {
+        f = fopen(argv[i], "rb");
+        if (!f) {
+            printf("cannot read %s\r\n", argv[i]);
+            return 1;
+        }
+        size = fread(data, 1, sizeof(data), f);
+        fclose(f);
+        LLVMFuzzerTestOneInput(data, size);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    long mutations = 1000000;
+
+    if (argc > 1 && (argv[1][0] < '0' || argv[1][0] > '9')) {
+        return files(argc, argv);
+    }
+    if (argc > 1) {
+        mutations = atol(argv[1]);
+    }
+
+    srand(1);
+    test_corpus();
+    fuzz(mutations);
+    printf("%ld mutated beacons\r\n", mutations);
+    bench(200000);
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
+#endif
@@ -0,0 +1,521 @@
+/*
+ * Host test of the command manager against a simulated firmware and A2E
+ * message buffer, on a tick clock that only runs while the caller waits.
+ * Covers pipelining, a full queue, a lost ACK, an ACK that comes after the
+ * command was given up on, a nonblocking command whose ACK is lost, a timer
+ * that finds the lock taken or cannot be armed, a drain, and a dead
+ * firmware. Every ACK has to be credited to the message the firmware
+ * acknowledged, and no message may be pushed over one not acknowledged
+ * yet. From this directory:
+ *
+ *   gcc -I../bl60x_wifi_driver test_cmd_mgr.c -o test_cmd_mgr
+ *   ./test_cmd_mgr
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* The headers next to bl_cmds.c win for its quoted includes, so their
+ * guards are taken here and the little bl_cmds.c needs is given instead.
+ */
+#define __OS_HAL_H__
+#define __RWNX_UTILS_H__
+#define _RWNX_STRS_H_
+#define LMAC_MSG_H_
+#define _LMAC_INT_H_
+#define _IPC_SHARED_H_
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint16_t lmac_msg_id_t;
+typedef uint16_t lmac_task_id_t;
+
+struct lmac_msg {
+    lmac_msg_id_t id;
+    lmac_task_id_t dest_id;
+    lmac_task_id_t src_id;
+    u16 param_len;
+    u32 param[];
+};
+
+struct ipc_e2a_msg {
+    u16 id;
+    u16 dummy_dest_id;
+    u16 dummy_src_id;
+    u16 param_len;
+    u32 param[8];
+};
+
+typedef struct {
+    u32 bits;
+} os_event_t;
+typedef int *os_mutex_t;
+typedef struct {
+    void (*cb)(void *data);
+    void *param;
+    u32 due;
+    int active;
+} os_timer_t;
+typedef os_timer_t *timer_cb_arg_t;
+
+static int mallocs, frees, lock_depth, timer_fails;
+static u32 sim_now;
+static u32 sim_wait(os_event_t *ev, u32 bits, u32 timeout);
+static void sim_free(void *ptr);
+
+#define os_malloc(size) (mallocs++, malloc(size))
+#define os_free(ptr) sim_free(ptr)
+#define os_event_init(ev) ((ev)->bits = 0)
+#define os_event_send(ev, b) ((ev)->bits |= (b))
+#define os_event_clear(ev, b) ((ev)->bits &= ~(b))
+#define os_event_recv(ev, b, timeout, val) do { val = sim_wait(ev, b, timeout); } while (0)
+#define os_mutex_create(name) (&lock_depth)
+#define os_mutex_take(l, t) do { if (lock_depth++) abort(); } while (0)
+#define os_mutex_trytake(l) (lock_depth ? 1 : (lock_depth++, 0))
+#define os_mutex_give(l) do { if (--lock_depth) abort(); } while (0)
+#define OS_WAITING_FOREVER 0xffffffff
+#define os_tick_get() sim_now
+#define OS_TIMER_TYPE_ONESHOT 0
+#define os_timer_init(timer, name, callback, data, ticks, type) do { \
+    (timer)->cb = (void (*)(void *))(callback); \
+    (timer)->param = (data); \
+} while (0)
+#define os_timer_restart(timer, ticks) (timer_fails ? (timer_fails--, 1) : \
+    ((timer)->due = sim_now + (ticks), (timer)->active = 1, 0))
+#define os_timer_stop(timer) ((timer)->active = 0)
+#define os_timer_data(timer) ((timer)->param)
+#define os_printf(...) do {} while (0)
+#define ASSERT_ERR(cond) do { if (!(cond)) abort(); } while (0)
+#define WARN_ON_ONCE(cond) (cond)
+#define RWNX_DBG(...) do {} while (0)
+#define RWNX_ID2STR(id) ""
+
+#include "bl_cmds.h"
+
+struct bl_hw {
+    struct bl_cmd_mgr cmd_mgr;
+    void *ipc_env;
+};
+
+void ipc_host_msg_push(void *env, void *msg_buf, u16 len);
+void ipc_host_msg_resync(void *env);
+
+#include "../bl60x_wifi_driver/bl_cmds.c"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+#define ACK_DELAY   2
+#define CFM_DELAY   5
+/* a manager that hangs is stopped here */
+#define SIM_LIMIT   (20 * RWNX_80211_CMD_TIMEOUT_MS)
+
+static struct bl_hw hw;
+
+/* The A2E buffer of ipc_host.c */
+static struct bl_cmd *ipc_hostid;
+static int ipc_resync;
+
+/* The firmware: the message in the A2E buffer and when it is acknowledged */
+static struct {
+    int has;
+    u16 id;
+    u32 ack_at;
+    int dead;
+    int drop_ack;           /* ACKs to lose */
+    u32 late_ack;           /* ticks to delay the next ACK by */
+    u32 last_ack;
+    u32 last_push;
+    struct {
+        u16 id;
+        u32 at;
+    } cfm[32];
+    int cfms;
+} fw;
+
+void ipc_host_msg_push(void *env, void *msg_buf, u16 len)
+{
+    struct bl_cmd *cmd = msg_buf;
+
+    ASSERT_ERR(!ipc_hostid);
+    CHECK(!fw.has, "message %u pushed over %u not acknowledged", cmd->id, fw.id);
+
+    ipc_hostid = cmd;
+    fw.has = 1;
+    fw.id = cmd->a2e_msg->id;
+    fw.ack_at = sim_now + ACK_DELAY + fw.late_ack;
+    fw.late_ack = 0;
+    fw.last_push = sim_now;
+}
+
+void ipc_host_msg_resync(void *env)
+{
+    ipc_hostid = NULL;
+    ipc_resync = 1;
+}
+
+/* ipc_host_msgack_handler() */
+static void ipc_ack(u16 id)
+{
+    struct bl_cmd *hostid = ipc_hostid;
+
+    fw.last_ack = sim_now;
+    if (ipc_resync) {
+        ipc_resync = 0;
+        if (!hostid) {
+            hw.cmd_mgr.llind(&hw.cmd_mgr, NULL);
+            return;
+        }
+    }
+
+    ASSERT_ERR(hostid);
+    CHECK(hostid->id == id, "ACK of %u credited to %u", id, hostid->id);
+    ipc_hostid = NULL;
+    hw.cmd_mgr.llind(&hw.cmd_mgr, hostid);
+}
+
+static int late_cfms;
+
+static int static_handler(struct bl_hw *bl_hw, struct bl_cmd *cmd, struct ipc_e2a_msg *msg)
+{
+    if (!cmd) {
+        late_cfms++;
+    }
+    return 0;
+}
+
+static void fw_step(void)
+{
+    int i;
+
+    if (++sim_now > SIM_LIMIT) {
+        printf("FAIL %s:%d command manager hangs\r\n", __FILE__, __LINE__);
+        printf("FAILED\r\n");
+        exit(1);
+    }
+
+    if (hw.cmd_mgr.timer.active && sim_now >= hw.cmd_mgr.timer.due) {
+        hw.cmd_mgr.timer.active = 0;
+        hw.cmd_mgr.timer.cb(&hw.cmd_mgr.timer);
+    }
+
+    if (fw.has && sim_now >= fw.ack_at) {
+        fw.has = 0;
+        if (fw.dead) {
+            /* nothing comes back */
+        } else if (fw.drop_ack) {
+            fw.drop_ack--;
+        } else {
+            /* the CFM id is the request id + 1 */
+            fw.cfm[fw.cfms].id = fw.id + 1;
+            fw.cfm[fw.cfms].at = sim_now + CFM_DELAY;
+            fw.cfms++;
+            ipc_ack(fw.id);
+        }
+    }
+
+    for (i = 0; i < fw.cfms; i++) {
+        if (fw.cfm[i].at <= sim_now) {
+            struct ipc_e2a_msg msg = { .id = fw.cfm[i].id };
+
+            fw.cfm[i--] = fw.cfm[--fw.cfms];
+            hw.cmd_mgr.msgind(&hw.cmd_mgr, &msg, static_handler);
+        }
+    }
+}
+
+static u32 sim_wait(os_event_t *ev, u32 bits, u32 timeout)
+{
+    u32 start = sim_now, got;
+
+    ASSERT_ERR(!lock_depth);
+    while (!(ev->bits & bits) && sim_now - start < timeout) {
+        fw_step();
+    }
+    got = ev->bits & bits;
+    ev->bits &= ~got;
+    return got;
+}
+
+static void run(u32 ticks)
+{
+    while (ticks--) {
+        fw_step();
+    }
+}
+
+/* nonblocking commands queued, the manager frees them once done */
+static struct bl_cmd *nonblock_cmds[RWNX_CMD_MAX_QUEUED + 1];
+static int nonblock_done, nonblock_result;
+
+static void sim_free(void *ptr)
+{
+    size_t i;
+
+    if (!ptr) {
+        return;
+    }
+    frees++;
+    for (i = 0; i < sizeof(nonblock_cmds) / sizeof(nonblock_cmds[0]); i++) {
+        if (nonblock_cmds[i] == ptr) {
+            nonblock_cmds[i] = NULL;
+            nonblock_done++;
+            nonblock_result = ((struct bl_cmd *)ptr)->result;
+            break;
+        }
+    }
+    free(ptr);
+}
+
+static void nonblock_track(struct bl_cmd *cmd, struct bl_cmd *old)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(nonblock_cmds) / sizeof(nonblock_cmds[0]); i++) {
+        if (nonblock_cmds[i] == old) {
+            nonblock_cmds[i] = cmd;
+            return;
+        }
+    }
+    abort();
+}
+
+static int send(u16 id, int nonblock, int cfm)
+{
+    struct bl_cmd *cmd = os_malloc(sizeof(*cmd));
+    int ret;
+
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->a2e_msg = os_malloc(sizeof(struct lmac_msg));
+    memset(cmd->a2e_msg, 0, sizeof(struct lmac_msg));
+    cmd->a2e_msg->id = cmd->id = id;
+    cmd->reqid = cfm ? id + 1 : (lmac_msg_id_t)-1;
+    cmd->flags = (nonblock ? RWNX_CMD_FLAG_NONBLOCK : 0) | (cfm ? RWNX_CMD_FLAG_REQ_CFM : 0);
+    if (nonblock) {
+        nonblock_track(cmd, NULL);
+    }
+
+    ret = hw.cmd_mgr.queue(&hw.cmd_mgr, cmd);
+    if (nonblock && ret) {
+        nonblock_track(NULL, cmd);
+    }
+    if (!nonblock || ret) {
+        os_free(cmd);
+    }
+    return ret;
+}
+
+static void test_pipeline(void)
+{
+    u32 t0;
+    int i;
+
+    CHECK(!send(10, 0, 1) && !send(12, 0, 0), "plain commands");
+
+    for (i = 0; i < RWNX_CMD_MAX_QUEUED; i++) {
+        CHECK(!send(20 + 2 * i, 1, 1), "nonblocking %d", i);
+    }
+    CHECK(send(50, 1, 1) == -ENOMEM && send(52, 0, 1) == -ENOMEM, "queue full");
+
+    t0 = sim_now;
+    nonblock_done = 0;
+    while (hw.cmd_mgr.queue_sz) {
+        fw_step();
+    }
+    CHECK(nonblock_done == RWNX_CMD_MAX_QUEUED && !nonblock_result, "pipeline");
+    CHECK(sim_now - t0 <= RWNX_CMD_MAX_QUEUED * ACK_DELAY + CFM_DELAY,
+          "pipeline took %u ticks", sim_now - t0);
+}
+
+static void test_lost_ack(void)
+{
+    u32 t0 = sim_now;
+
+    fw.drop_ack = 1;
+    CHECK(send(60, 0, 1) == -ETIMEDOUT, "lost ACK");
+    CHECK(sim_now - t0 == RWNX_80211_CMD_TIMEOUT_MS, "timed out after %u", sim_now - t0);
+    CHECK(hw.cmd_mgr.state != RWNX_CMD_MGR_STATE_CRASHED &&
+          hw.cmd_mgr.recoveries == 1, "recoveries %u", hw.cmd_mgr.recoveries);
+
+    /* the ACK never comes, the next command goes after the guard */
+    t0 = sim_now;
+    CHECK(!send(62, 0, 1) && !hw.cmd_mgr.failed_recoveries, "after the lost ACK");
+    CHECK(fw.last_push - t0 == RWNX_CMD_RESYNC_GUARD_MS,
+          "pushed %u after the recovery", fw.last_push - t0);
+}
+
+static void test_late_ack(void)
+{
+    u32 t0 = sim_now, late = RWNX_CMD_RESYNC_GUARD_MS / 2;
+
+    /* the ACK comes just after the command was given up on */
+    fw.late_ack = RWNX_80211_CMD_TIMEOUT_MS + late;
+    late_cfms = 0;
+    CHECK(send(64, 0, 1) == -ETIMEDOUT, "late ACK");
+    CHECK(!send(66, 0, 1), "after the late ACK");
+    CHECK(fw.last_push == t0 + RWNX_80211_CMD_TIMEOUT_MS + late + ACK_DELAY,
+          "pushed at %u, the stale ACK came at %u", fw.last_push - t0,
+          RWNX_80211_CMD_TIMEOUT_MS + late + ACK_DELAY);
+
+    /* its CFM goes to the static handler */
+    run(2 * CFM_DELAY);
+    CHECK(late_cfms == 1, "late CFM %d", late_cfms);
+    CHECK(!send(68, 0, 1) && !hw.cmd_mgr.queue_sz, "after the late CFM");
+}
+
+/* A nonblocking command without a waiter loses its ACK, like a TIM update.
+ * A command queued behind it may not hang.
+ */
+static void test_nonblock_lost_ack(void)
+{
+    u32 t0 = sim_now;
+
+    fw.drop_ack = 1;
+    nonblock_done = 0;
+    CHECK(!send(70, 1, 0), "nonblocking");
+    run(10);
+    CHECK(!send(72, 0, 1), "queued behind a nonblocking command with no ACK");
+    CHECK(nonblock_done == 1 && nonblock_result == ETIMEDOUT,
+          "nonblocking command done %d result %d", nonblock_done, nonblock_result);
+    CHECK(sim_now - t0 <= RWNX_80211_CMD_TIMEOUT_MS + RWNX_CMD_RESYNC_GUARD_MS +
+          ACK_DELAY + CFM_DELAY, "took %u", sim_now - t0);
+
+    /* the timer stops once nothing is pushed */
+    run(RWNX_80211_CMD_TIMEOUT_MS);
+    CHECK(!hw.cmd_mgr.timer.active, "timer runs while idle");
+
+    /* on its own, the timer recovers it and pushes what was queued during
+     * the guard */
+    fw.drop_ack = 1;
+    nonblock_done = 0;
+    t0 = sim_now;
+    CHECK(!send(74, 1, 0), "nonblocking");
+    run(RWNX_80211_CMD_TIMEOUT_MS);
+    CHECK(nonblock_done == 1 && nonblock_result == ETIMEDOUT,
+          "nonblocking command done %d result %d", nonblock_done, nonblock_result);
+    CHECK(!send(76, 1, 0), "nonblocking during the guard");
+    run(RWNX_CMD_RESYNC_GUARD_MS + ACK_DELAY);
+    CHECK(nonblock_done == 2 && !nonblock_result && !hw.cmd_mgr.queue_sz,
+          "nonblocking command queued during the guard");
+    CHECK(fw.last_push - t0 == RWNX_80211_CMD_TIMEOUT_MS + RWNX_CMD_RESYNC_GUARD_MS,
+          "pushed %u after the first", fw.last_push - t0);
+}
+
+/* The timer task finds the lock taken and comes back, it does not wait */
+static void test_timer_lock_busy(void)
+{
+    u32 due;
+
+    fw.drop_ack = 1;
+    nonblock_done = 0;
+    CHECK(!send(86, 1, 0), "nonblocking");
+    due = hw.cmd_mgr.timer.due;
+    run(due - sim_now - 1);
+    lock_depth = 1;
+    run(1);
+    lock_depth = 0;
+    CHECK(!nonblock_done && hw.cmd_mgr.timer.active &&
+          hw.cmd_mgr.timer.due == due + RWNX_CMD_TIMER_RETRY_MS,
+          "done %d, timer due %u after the lock was taken", nonblock_done,
+          hw.cmd_mgr.timer.due - due);
+    run(RWNX_CMD_TIMER_RETRY_MS);
+    CHECK(nonblock_done == 1 && nonblock_result == ETIMEDOUT,
+          "nonblocking command done %d result %d", nonblock_done, nonblock_result);
+    run(RWNX_CMD_RESYNC_GUARD_MS);
+    CHECK(!hw.cmd_mgr.push_busy && !hw.cmd_mgr.resync_wait, "guard not over");
+    run(RWNX_80211_CMD_TIMEOUT_MS);
+    CHECK(!hw.cmd_mgr.timer_armed && !hw.cmd_mgr.timer.active, "timer runs while idle");
+}
+
+/* A timer that could not be armed is armed by the next queue() */
+static void test_timer_fails(void)
+{
+    u32 t0 = sim_now;
+
+    fw.drop_ack = 1;
+    nonblock_done = 0;
+    timer_fails = 1;
+    CHECK(!send(88, 1, 0), "nonblocking");
+    CHECK(!hw.cmd_mgr.timer_armed && !hw.cmd_mgr.timer.active, "timer armed %d",
+          hw.cmd_mgr.timer_armed);
+    run(10);
+    CHECK(!send(90, 1, 0), "nonblocking behind it");
+    CHECK(hw.cmd_mgr.timer_armed && hw.cmd_mgr.timer.active &&
+          hw.cmd_mgr.timer.due == t0 + RWNX_80211_CMD_TIMEOUT_MS,
+          "timer armed %d due %u", hw.cmd_mgr.timer_armed, hw.cmd_mgr.timer.due - t0);
+    run(RWNX_80211_CMD_TIMEOUT_MS + RWNX_CMD_RESYNC_GUARD_MS + ACK_DELAY);
+    CHECK(nonblock_done == 2 && !hw.cmd_mgr.queue_sz, "nonblocking commands done %d",
+          nonblock_done);
+}
+
+/* A drain during the guard leaves nothing pushed, guarded or timed */
+static void test_drain(void)
+{
+    u32 t0;
+
+    fw.drop_ack = 1;
+    nonblock_done = 0;
+    CHECK(!send(92, 1, 0), "nonblocking");
+    run(RWNX_80211_CMD_TIMEOUT_MS);
+    CHECK(!send(94, 1, 0), "nonblocking during the guard");
+    hw.cmd_mgr.drain(&hw.cmd_mgr);
+    CHECK(nonblock_done == 2 && nonblock_result == EINTR && !hw.cmd_mgr.queue_sz,
+          "drained %d result %d", nonblock_done, nonblock_result);
+    CHECK(!hw.cmd_mgr.push_busy && !hw.cmd_mgr.resync_wait && !hw.cmd_mgr.timer_armed &&
+          !hw.cmd_mgr.timer.active, "push busy %d resync %d timer %d/%d",
+          hw.cmd_mgr.push_busy, hw.cmd_mgr.resync_wait, hw.cmd_mgr.timer_armed,
+          hw.cmd_mgr.timer.active);
+
+    /* the IPC is reset with the firmware, the next command goes at once */
+    ipc_resync = 0;
+    t0 = sim_now;
+    CHECK(!send(96, 0, 1), "after the drain");
+    CHECK(fw.last_push == t0, "pushed %u after the drain", fw.last_push - t0);
+}
+
+static void test_dead_firmware(void)
+{
+    int i;
+
+    fw.dead = 1;
+    for (i = 0; i <= RWNX_CMD_MAX_RECOVERY; i++) {
+        CHECK(send(80, 0, 1) == -ETIMEDOUT, "dead firmware %d", i);
+    }
+    CHECK(hw.cmd_mgr.state == RWNX_CMD_MGR_STATE_CRASHED, "not crashed");
+    CHECK(send(82, 0, 1) == -EPIPE && send(84, 1, 0) == -EPIPE, "after the crash");
+    CHECK(!hw.cmd_mgr.slots && !hw.cmd_mgr.queue_sz, "slots %x queue %u",
+          hw.cmd_mgr.slots, hw.cmd_mgr.queue_sz);
+}
+
+int main(void)
+{
+    bl_cmd_mgr_init(&hw.cmd_mgr);
+
+    test_pipeline();
+    test_lost_ack();
+    test_late_ack();
+    test_nonblock_lost_ack();
+    test_timer_lock_busy();
+    test_timer_fails();
+    test_drain();
+    test_dead_firmware();
+
+    CHECK(mallocs == frees, "%d allocations, %d frees", mallocs, frees);
+
+    printf("%u ticks, %u recoveries\r\n", sim_now, hw.cmd_mgr.recoveries);
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
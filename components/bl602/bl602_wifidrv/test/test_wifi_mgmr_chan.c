@@ -0,0 +1,214 @@
+/*
+ * Host test of the event channel of the Wi-Fi manager. Control events and
+ * beacons are posted in a fixed interleaving and the manager side has to
+ * get every control event first and in order, then the beacons once per
+ * BSS in the order the BSS first showed up, with the strongest sample.
+ * Full lanes drop and count instead of blocking the driver, and a control
+ * event posted while beacons are pending overtakes them. A wait of the
+ * manager task ends the receive through os_would_block(). From this
+ * directory:
+ *
+ *   gcc -I. -Wno-pointer-to-int-cast test_wifi_mgmr_chan.c -o test_wifi_mgmr_chan
+ *   ./test_wifi_mgmr_chan
+ */
+#include <setjmp.h>
+
+#include "os_hal.h"
+#include "../bl60x_wifi_driver/wifi_mgmr_chan.c"
+
+#define BEACON      WIFI_MGMR_EVENT_GLB_SCAN_IND_BEACON
+#define CONNECT     WIFI_MGMR_EVENT_APP_CONNECT
+#define SLOTS       WIFI_MGMR_CHAN_SCAN_SLOTS
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+uint32_t test_tick;
+int test_critical;
+int test_mutex;
+
+void test_trace(const char *fmt, ...)
+{
+}
+
+static jmp_buf would_block;
+static int may_block;
+
+void os_would_block(void)
+{
+    CHECK(may_block, "blocked");
+    longjmp(would_block, 1);
+}
+
+static wifi_mgmr_chan_t chan;
+
+/* Control events carry a sequence number */
+static int ctrl(int seq)
+{
+    uint32_t buffer[(sizeof(wifi_mgmr_msg_t) + 4) / 4];
+    wifi_mgmr_msg_t *msg = (wifi_mgmr_msg_t *)buffer;
+
+    memset(buffer, 0, sizeof(buffer));
+    msg->ev = CONNECT;
+    msg->len = sizeof(buffer);
+    memcpy(msg->data, &seq, 4);
+    return wifi_mgmr_chan_post(&chan, msg);
+}
+
+static int scan(int bss, int rssi, const char *ssid)
+{
+    uint8_t mac[6] = {1, 2, 3, 4, 5, bss};
+
+    return wifi_mgmr_chan_post_scan(&chan, 6, rssi, 0, mac, (uint8_t *)ssid,
+            strlen(ssid), 0, 0, 0);
+}
+
+static int beacon(int bss, int rssi)
+{
+    char ssid[16];
+
+    sprintf(ssid, "ap%d", bss);
+    return scan(bss, rssi, ssid);
+}
+
+/* An event for the manager task or 0 if it would wait. The value is the
+ * sequence of a control event and bss * 1000 + rssi + 100 of a beacon.
+ */
+static int recv(int *value)
+{
+    /* unaligned, like the buffer of wifi_mgmr_start() */
+    static uint8_t buffer[WIFI_MGMR_MQ_MSG_SIZE + 8];
+    wifi_mgmr_msg_t *msg = (wifi_mgmr_msg_t *)(buffer + 1);
+    wifi_mgmr_scan_item_t item;
+    wifi_mgmr_msg_t hdr;
+
+    may_block = 1;
+    if (setjmp(would_block)) {
+        may_block = 0;
+        return 0;
+    }
+    CHECK(0 == wifi_mgmr_chan_recv(&chan, msg, WIFI_MGMR_MQ_MSG_SIZE), "recv");
+    may_block = 0;
+
+    memcpy(&hdr, msg, sizeof(hdr));
+    if (hdr.ev == BEACON) {
+        memcpy(&item, msg->data, sizeof(item));
+        CHECK(item.ssid_len == strlen(item.ssid), "SSID %s length %u",
+                item.ssid, (unsigned)item.ssid_len);
+        *value = item.bssid[5] * 1000 + item.rssi + 100;
+    } else {
+        memcpy(value, msg->data, 4);
+    }
+    return hdr.ev;
+}
+
+static void test_order(void)
+{
+    static const int want_ev[] = {
+        CONNECT, CONNECT, CONNECT, BEACON, BEACON, BEACON, BEACON,
+    };
+    static const int want_value[] = {1, 2, 3, 1055, 2040, 3060, 2010};
+    int i, ev, value;
+
+    /* the driver may report beacons before the manager is up */
+    CHECK(0 == beacon(1, -50), "beacon before init");
+    may_block = 1;
+    if (!setjmp(would_block)) {
+        ctrl(0);
+        CHECK(0, "control event before init did not wait");
+    }
+    may_block = 0;
+
+    CHECK(0 == wifi_mgmr_chan_init(&chan), "init");
+    CHECK(chan.ev & WIFI_MGMR_CHAN_EV_KICK, "wakeup of the early beacon lost");
+
+    CHECK(0 == ctrl(1), "ctrl 1");
+    CHECK(0 == beacon(2, -70), "beacon");
+    CHECK(0 == beacon(2, -80), "beacon");
+    CHECK(0 == beacon(2, -60), "beacon");
+    CHECK(0 == ctrl(2), "ctrl 2");
+    CHECK(0 == beacon(3, -40), "beacon");
+    CHECK(0 == beacon(3, -55), "beacon");
+    CHECK(0 == beacon(1, -45), "beacon");
+    /* a hidden SSID of the same BSS is an entry of its own */
+    CHECK(0 == scan(2, -90, ""), "hidden");
+    CHECK(0 == ctrl(3), "ctrl 3");
+
+    for (i = 0; i < 7; i++) {
+        ev = recv(&value);
+        CHECK(ev == want_ev[i] && value == want_value[i],
+                "event %d: %d value %d, want %d value %d", i, ev, value,
+                want_ev[i], want_value[i]);
+    }
+    CHECK(!recv(&value), "more events");
+
+    CHECK(chan.stats.scan_posted == 8 && chan.stats.scan_coalesced == 4 &&
+            !chan.stats.scan_dropped && chan.stats.scan_delivered == 4,
+            "scan posted %u coalesced %u dropped %u delivered %u",
+            (unsigned)chan.stats.scan_posted, (unsigned)chan.stats.scan_coalesced,
+            (unsigned)chan.stats.scan_dropped, (unsigned)chan.stats.scan_delivered);
+}
+
+static void test_full(void)
+{
+    int i, sent = 0, value;
+
+    /* a new BSS is dropped, the pending ones still take updates */
+    for (i = 0; i < SLOTS; i++) {
+        CHECK(0 == beacon(10 + i, -50), "beacon %d", i);
+    }
+    CHECK(-1 == beacon(99, -30), "new BSS with all slots pending");
+    CHECK(0 == beacon(10, -20), "update of a pending BSS");
+    CHECK(chan.stats.scan_dropped == 1, "%u scan drops",
+            (unsigned)chan.stats.scan_dropped);
+
+    /* the control lane drops when full and the beacons take no room in it */
+    while (0 == ctrl(100 + sent)) {
+        sent++;
+    }
+    CHECK(sent == WIFI_MGMR_MQ_MSG_COUNT * WIFI_MGMR_MQ_MSG_SIZE /
+            (sizeof(wifi_mgmr_msg_t) + 8), "%d control events fit", sent);
+    CHECK(chan.stats.ctrl_dropped == 1, "%u control drops",
+            (unsigned)chan.stats.ctrl_dropped);
+    for (i = 0; i < sent; i++) {
+        CHECK(recv(&value) == CONNECT && value == 100 + i, "control %d", i);
+    }
+
+    /* one beacon out, then a late control event goes before the rest */
+    CHECK(recv(&value) == BEACON && value == 10 * 1000 + 80, "first beacon");
+    CHECK(0 == ctrl(500), "ctrl 500");
+    CHECK(recv(&value) == CONNECT && value == 500, "late control event");
+    for (i = 1; i < SLOTS; i++) {
+        CHECK(recv(&value) == BEACON && value == (10 + i) * 1000 + 50,
+                "beacon %d", i);
+    }
+    CHECK(!recv(&value), "more events");
+
+    /* the slots come back */
+    for (i = 0; i < 3 * SLOTS; i++) {
+        CHECK(0 == beacon(i, -50), "beacon %d", i);
+        CHECK(recv(&value) == BEACON && value == i * 1000 + 50,
+                "beacon %d", i);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    test_order();
+    test_full();
+
+    CHECK(!test_critical && !test_mutex, "critical %d mutex %d", test_critical,
+            test_mutex);
+    wifi_mgmr_chan_stats_dump(&chan);
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,575 @@
+/*
+ * Host test of the Wi-Fi manager state machine. A seeded random stream of
+ * every WIFI_MGMR_EVENT_XXX goes through stateM_handleEvent() with traced
+ * stand-ins for the firmware, profile, event and lwIP calls, some of which
+ * fail. For each event the trace has the new state and the calls it made,
+ * sorted, since only the set of calls per event is fixed. It ends with a
+ * hash of the scan table. The trace has to match wifi_mgmr_trace.txt,
+ * which was recorded from the state machine with the per-class transition
+ * lists that the jump tables replaced. The beacon path is also checked to
+ * take no guard calls. From this directory:
+ *
+ *   gcc -I. -Wno-pointer-to-int-cast test_wifi_mgmr_sm.c \
+ *       ../bl60x_wifi_driver/stateMachine.c -o test_wifi_mgmr_sm
+ *   ./test_wifi_mgmr_sm [-w] [wifi_mgmr_trace.txt]
+ *
+ * -w records the trace file instead of checking it.
+ */
+#include "os_hal.h"
+#include "../bl60x_wifi_driver/wifi_mgmr.c"
+
+#include <stdarg.h>
+
+#define EVENTS      3000
+#define TRACE_MAX   (256 * 1024)
+#define BLOCK_MAX   32
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+uint32_t test_tick;
+int test_critical;
+int test_mutex;
+
+/* The calls of the current event, sorted into the trace when it ends */
+static char block[BLOCK_MAX][64];
+static int block_len;
+static char trace[TRACE_MAX];
+static int trace_len;
+
+void test_trace(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (block_len == BLOCK_MAX) {
+        return;
+    }
+    va_start(ap, fmt);
+    vsnprintf(block[block_len++], sizeof(block[0]), fmt, ap);
+    va_end(ap);
+}
+
+void os_would_block(void)
+{
+    CHECK(0, "the state machine waited");
+}
+
+static int block_cmp(const void *a, const void *b)
+{
+    return strcmp(a, b);
+}
+
+static void trace_line(const char *fmt, ...)
+{
+    va_list ap;
+    int i;
+
+    qsort(block, block_len, sizeof(block[0]), block_cmp);
+    for (i = 0; i < block_len; i++) {
+        trace_len += snprintf(trace + trace_len, TRACE_MAX - trace_len,
+                "  %s\n", block[i]);
+    }
+    block_len = 0;
+
+    va_start(ap, fmt);
+    trace_len += vsnprintf(trace + trace_len, TRACE_MAX - trace_len, fmt, ap);
+    va_end(ap);
+}
+
+static uint32_t xorshift(uint32_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+/* Firmware calls that fail now and then, on their own stream */
+static uint32_t fail_rng = 7;
+static int autoreconnect = 1;
+
+static int fails(void)
+{
+    return !(xorshift(&fail_rng) % 4);
+}
+
+int bl_main_if_add(int is_sta, struct netif *netif, uint8_t *vif_index)
+{
+    int ret = fails();
+
+    test_trace("if_add %d -> %d", is_sta, ret);
+    return ret;
+}
+
+int bl_main_phy_up(void)
+{
+    int ret = fails();
+
+    test_trace("phy_up -> %d", ret);
+    return ret;
+}
+
+int bl60x_check_mac_status(int *is_ok)
+{
+    *is_ok = !!(xorshift(&fail_rng) % 8);
+    return 0;
+}
+
+int bl_main_connect(const uint8_t *ssid, int ssid_len, const uint8_t *psk,
+        int psk_len, const uint8_t *pmk, int pmk_len, const uint8_t *mac,
+        const uint8_t band, const uint16_t freq)
+{
+    test_trace("connect %.*s", ssid_len, ssid);
+    return 0;
+}
+
+int bl_main_apm_start(char *ssid, char *password, int channel,
+        uint8_t vif_index, uint8_t hidden_ssid)
+{
+    test_trace("apm_start %s %d", ssid, channel);
+    return 0;
+}
+
+int bl_main_cfg_task_req(uint32_t ops, uint32_t task, uint32_t element,
+        uint32_t type, void *arg1, void *arg2)
+{
+    test_trace("cfg %u %u", (unsigned)ops, (unsigned)task);
+    return 0;
+}
+
+int bl_main_conf_max_sta(uint8_t max_sta_supported)
+{
+    test_trace("max_sta %u", max_sta_supported);
+    return 0;
+}
+
+int bl_main_denoise(int mode)
+{
+    test_trace("denoise %d", mode);
+    return 0;
+}
+
+int bl_main_monitor_channel_set(int channel, int use_40MHZ)
+{
+    test_trace("channel %d", channel);
+    return 0;
+}
+
+int bl_main_powersaving(int mode)
+{
+    test_trace("powersaving %d", mode);
+    return 0;
+}
+
+int bl_main_rate_config(uint8_t sta_idx, uint16_t fixed_rate_cfg)
+{
+    test_trace("rate %u", fixed_rate_cfg);
+    return 0;
+}
+
+int bl_main_raw_send(uint8_t *pkt, int len)
+{
+    test_trace("raw_send %d", len);
+    return 0;
+}
+
+int bl_main_if_remove(uint8_t vif_index)
+{
+    test_trace("if_remove %u", vif_index);
+    return 0;
+}
+
+int bl_main_apm_stop(uint8_t vif_index)
+{
+    test_trace("apm_stop %u", vif_index);
+    return 0;
+}
+
+int bl_main_apm_sta_cnt_get(uint8_t *sta_cnt)
+{
+    test_trace("apm_sta_cnt_get");
+    return 0;
+}
+
+int bl_main_apm_sta_info_get(struct wifi_apm_sta_info *apm_sta_info, uint8_t idx)
+{
+    test_trace("apm_sta_info_get %u", idx);
+    return 0;
+}
+
+int bl_main_apm_sta_delete(uint8_t sta_idx)
+{
+    test_trace("apm_sta_delete %u", sta_idx);
+    return 0;
+}
+
+int bl_main_apm_remove_all_sta()
+{
+    test_trace("apm_remove_all_sta");
+    return 0;
+}
+
+int bl_main_disconnect(void)
+{
+    test_trace("disconnect");
+    return 0;
+}
+
+int bl_main_get_channel_nums()
+{
+    return 13;
+}
+
+int bl_main_monitor(void)
+{
+    test_trace("monitor");
+    return 0;
+}
+
+int bl_main_scan(void)
+{
+    test_trace("scan");
+    return 0;
+}
+
+int bl_main_set_country_code(char *country_code)
+{
+    test_trace("country_code %s", country_code);
+    return 0;
+}
+
+int bl_tsen_adc_get(int16_t *temp, uint8_t log_flag)
+{
+    *temp = 25;
+    return 0;
+}
+
+void phy_tcal_callback(int16_t temperature)
+{
+    test_trace("tcal %d", temperature);
+}
+
+void helper_record_dump()
+{
+    test_trace("record_dump");
+}
+
+void dns_server_init(void)
+{
+    test_trace("dns_server_init");
+}
+
+void hal_sys_capcode_update(uint8_t capin, uint8_t capout)
+{
+}
+
+int wifi_mgmr_api_denoise_enable(void)
+{
+    test_trace("api_denoise_enable");
+    return 0;
+}
+
+int wifi_mgmr_api_fw_disconnect(void)
+{
+    test_trace("api_fw_disconnect");
+    return 0;
+}
+
+int wifi_mgmr_api_fw_tsen_reload(void)
+{
+    test_trace("api_fw_tsen_reload");
+    return 0;
+}
+
+int wifi_mgmr_api_reconnect(void)
+{
+    test_trace("api_reconnect");
+    return 0;
+}
+
+int wifi_mgmr_drv_init(wifi_conf_t *conf)
+{
+    return 0;
+}
+
+int wifi_mgmr_event_init(void)
+{
+    return 0;
+}
+
+int wifi_mgmr_scan_complete_callback()
+{
+    test_trace("scan_complete");
+    return 0;
+}
+
+int wifi_netif_dhcp_start(struct netif *netif)
+{
+    test_trace("dhcp_start");
+    return 0;
+}
+
+int wifi_mgmr_profile_add(wifi_mgmr_t *mgmr, wifi_mgmr_profile_msg_t *profile_msg,
+        int index)
+{
+    test_trace("profile_add %s", profile_msg->ssid);
+    return 0;
+}
+
+int wifi_mgmr_profile_autoreconnect_disable(wifi_mgmr_t *mgmr, int index)
+{
+    autoreconnect = 0;
+    test_trace("autoreconnect off");
+    return 0;
+}
+
+int wifi_mgmr_profile_autoreconnect_enable(wifi_mgmr_t *mgmr, int index)
+{
+    autoreconnect = 1;
+    test_trace("autoreconnect on");
+    return 0;
+}
+
+int wifi_mgmr_profile_autoreconnect_is_enabled(wifi_mgmr_t *mgmr, int index)
+{
+    return autoreconnect;
+}
+
+int wifi_mgmr_profile_get(wifi_mgmr_t *mgmr, wifi_mgmr_profile_msg_t *profile_msg)
+{
+    return 0;
+}
+
+int aos_register_event_filter(uint16_t type, aos_event_cb cb, void *priv)
+{
+    return 0;
+}
+
+int aos_post_event(uint16_t type, uint16_t code, unsigned long value)
+{
+    test_trace("post %u %lu", code, value);
+    return 0;
+}
+
+int aos_post_delayed_action(int ms, aos_call_t action, void *arg)
+{
+    test_trace("delayed %d", ms);
+    return 0;
+}
+
+/* The event loop of wifi_mgmr_start() is not run here */
+int wifi_mgmr_chan_init(wifi_mgmr_chan_t *chan)
+{
+    return 0;
+}
+
+int wifi_mgmr_chan_post(wifi_mgmr_chan_t *chan, wifi_mgmr_msg_t *msg)
+{
+    test_trace("chan_post %d", msg->ev);
+    return 0;
+}
+
+int wifi_mgmr_chan_recv(wifi_mgmr_chan_t *chan, wifi_mgmr_msg_t *msg, int size)
+{
+    os_would_block();
+    return -1;
+}
+
+void wifi_mgmr_chan_stats_dump(wifi_mgmr_chan_t *chan)
+{
+}
+
+static const struct {
+    const struct state *state;
+    const char *name;
+} state_names[] = {
+    {&stateIdle, "idle"},
+    {&stateConnecting, "connecting"},
+    {&stateConnectedIPNo, "connected_ip_no"},
+    {&stateConnectedIPYes, "connected_ip_yes"},
+    {&stateDisconnect, "disconnect"},
+    {&stateIfaceDown, "iface_down"},
+    {&stateSniffer, "sniffer"},
+    {&stateError, "error"},
+};
+
+static int state_index(const struct state *state)
+{
+    int i;
+
+    for (i = 0; i < sizeof(state_names) / sizeof(state_names[0]); i++) {
+        if (state_names[i].state == state) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int dispatch(wifi_mgmr_msg_t *msg)
+{
+    struct event ev = {
+        .type = msg->ev,
+        .data = msg,
+    };
+
+    return stateM_handleEvent(&(wifiMgmr.m), &ev);
+}
+
+/* Beacons of 60 APs over channels 0-15, the rest have an SSID payload */
+static void random_msg(wifi_mgmr_msg_t *msg, int ev, uint32_t *rng)
+{
+    memset(msg, 0, WIFI_MGMR_MQ_MSG_SIZE);
+    msg->ev = ev;
+    msg->data1 = (void *)(uintptr_t)(xorshift(rng) % 3);
+    msg->data2 = (void *)(uintptr_t)(xorshift(rng) % 20);
+    if (ev == WIFI_MGMR_EVENT_GLB_SCAN_IND_BEACON) {
+        wifi_mgmr_scan_item_t *scan = (wifi_mgmr_scan_item_t *)msg->data;
+
+        scan->channel = xorshift(rng) % 16;
+        scan->rssi = -(int)(xorshift(rng) % 90);
+        snprintf(scan->ssid, sizeof(scan->ssid), "ap%u",
+                (unsigned)(xorshift(rng) % 60));
+        scan->bssid[0] = xorshift(rng) % 60;
+    } else {
+        snprintf((char *)msg->data, 16, "ssid%u", (unsigned)(xorshift(rng) % 5));
+    }
+}
+
+static void replay(void)
+{
+    static uint8_t pairs[sizeof(state_names) / sizeof(state_names[0])][WIFI_MGMR_EVENT_MAX];
+    uint32_t buffer[WIFI_MGMR_MQ_MSG_SIZE / 4];
+    wifi_mgmr_msg_t *msg = (wifi_mgmr_msg_t *)buffer;
+    uint32_t rng = 99, hash = 0;
+    int i, ev, ret, reached = 0;
+
+    for (i = 0; i < EVENTS; i++) {
+        ev = xorshift(&rng) % WIFI_MGMR_EVENT_MAX;
+        if (ev == WIFI_MGMR_EVENT_MAXAPP_MINIFW ||
+                ev == WIFI_MGMR_EVENT_MAXFW_MINI_GLOBAL ||
+                ev == WIFI_MGMR_EVENT_APP_RELOAD_TSEN) {
+            continue;
+        }
+
+        random_msg(msg, ev, &rng);
+        test_tick += xorshift(&rng) % 2000;
+        if (!pairs[state_index(wifiMgmr.m.currentState)][ev]++) {
+            reached++;
+        }
+        ret = dispatch(msg);
+        trace_line("ev %d -> %d %s\n", ev, ret,
+                state_names[state_index(wifiMgmr.m.currentState)].name);
+    }
+
+    for (i = 0; i < sizeof(wifiMgmr.scan_items); i++) {
+        hash = hash * 31 + ((uint8_t *)wifiMgmr.scan_items)[i];
+    }
+    trace_line("scan %08x\n", (unsigned)hash);
+
+    CHECK(test_critical == 0, "critical nesting %d", test_critical);
+    printf("%d events, %d (state, event) pairs\r\n", EVENTS, reached);
+}
+
+/* Once connected, a beacon takes the table of the state and of Global */
+static void test_beacon_stats(void)
+{
+    static const int up[] = {
+        WIFI_MGMR_EVENT_APP_PHY_UP,
+        WIFI_MGMR_EVENT_APP_CONNECT,
+        WIFI_MGMR_EVENT_FW_IND_CONNECTED,
+        WIFI_MGMR_EVENT_APP_IP_GOT,
+    };
+    struct stateM_eventStats *st = &wifi_mgmr_sm_stats[WIFI_MGMR_EVENT_GLB_SCAN_IND_BEACON];
+    uint32_t buffer[WIFI_MGMR_MQ_MSG_SIZE / 4];
+    wifi_mgmr_msg_t *msg = (wifi_mgmr_msg_t *)buffer;
+    uint32_t rng = 5;
+    int i, tries, changed = 0;
+
+    stateM_init(&(wifiMgmr.m), &stateIfaceDown, &stateError);
+    stateM_setStats(&(wifiMgmr.m), wifi_mgmr_sm_stats, WIFI_MGMR_EVENT_MAX);
+    for (i = 0; i < 4; i++) {
+        /* the firmware stand-in fails now and then, so try again */
+        for (tries = 0; tries < 20; tries++) {
+            memset(msg, 0, WIFI_MGMR_MQ_MSG_SIZE);
+            msg->ev = up[i];
+            strcpy((char *)msg->data, "home");
+            if (dispatch(msg) == stateM_stateChanged) {
+                break;
+            }
+        }
+    }
+    block_len = 0;
+    CHECK(wifiMgmr.m.currentState == &stateConnectedIPYes, "not connected");
+
+    memset(wifi_mgmr_sm_stats, 0, sizeof(wifi_mgmr_sm_stats));
+    for (i = 0; i < 1000; i++) {
+        random_msg(msg, WIFI_MGMR_EVENT_GLB_SCAN_IND_BEACON, &rng);
+        changed += dispatch(msg) != stateM_noStateChange;
+    }
+    block_len = 0;
+
+    CHECK(!changed, "%d beacons changed the state", changed);
+
+    CHECK(st->dispatched == 1000 && st->lookups == 2000 && !st->guards &&
+            st->transitions == 1000, "beacons: %lu dispatched, %lu lookups, "
+            "%lu guards, %lu transitions", st->dispatched, st->lookups,
+            st->guards, st->transitions);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = "wifi_mgmr_trace.txt";
+    static char want[TRACE_MAX];
+    int record = 0, i, line, len = 0;
+    FILE *f;
+
+    /* the task of the manager, not run here */
+    (void)_wifi_mgmr_entry;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-w")) {
+            record = 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    wifiMgmr.channel_nums = 13;
+    stateM_init(&(wifiMgmr.m), &stateIfaceDown, &stateError);
+    stateM_setStats(&(wifiMgmr.m), wifi_mgmr_sm_stats, WIFI_MGMR_EVENT_MAX);
+    replay();
+
+    f = fopen(path, record ? "w" : "r");
+    if (!f) {
+        printf("cannot open %s\r\n", path);
+        return 1;
+    }
+    if (record) {
+        fwrite(trace, 1, trace_len, f);
+        fclose(f);
+        printf("%d bytes to %s\r\n", trace_len, path);
+        return 0;
+    }
+    len = fread(want, 1, sizeof(want) - 1, f);
+    fclose(f);
+
+    /* report the first event that went another way */
+    for (i = 0, line = 1; i < len && i < trace_len && want[i] == trace[i]; i++) {
+        line += want[i] == '\n';
+    }
+    CHECK(len == trace_len && i == len, "trace differs from %s at line %d",
+            path, line);
+
+    test_beacon_stats();
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
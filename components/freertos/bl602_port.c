@@ -17,6 +17,9 @@
 #ifdef REBOOT_ON_EXCEPTION
 #include <bl_sys.h>
 #endif
+#ifdef CFG_COREDUMP
+#include <bl_coredump.h>
+#endif
 
 /* Functions required by FreeRTOS */
 #define TIME_5MS_IN_32768CYCLE  (164) // (5000/(1000000/32768))
@@ -63,6 +66,9 @@ static HeapRegion_t xHeapRegions[] =
   bl_dma_init();
   bl_rtc_init();
   hal_boot2_init();
+#ifdef CFG_COREDUMP
+  bl_coredump_init();
+#endif
   hal_board_cfg(0);
   
   /* Run timer throwaways */
@@ -73,6 +79,9 @@ static HeapRegion_t xHeapRegions[] =
 
 [[gnu::weak]] void vAssertCalled(void)
 {
+#ifdef CFG_COREDUMP
+  bl_coredump_save(BL_COREDUMP_ASSERT, NULL);
+#endif
 #ifdef REBOOT_ON_EXCEPTION
   bl_sys_reset_system();
 #else
@@ -155,6 +164,9 @@ void user_vAssertCalled(void) __attribute__ ((weak, alias ("vAssertCalled")));
 [[gnu::weak]] void vApplicationStackOverflowHook([[gnu::unused]] TaskHandle_t xTask, char *pcTaskName)
 {
   printf("[%s] Stack overflow, task name: %s\r\n", __func__, pcTaskName);
+#ifdef CFG_COREDUMP
+  bl_coredump_save(BL_COREDUMP_STACK_OVERFLOW, pcTaskName);
+#endif
 #ifdef REBOOT_ON_EXCEPTION
   bl_sys_reset_system();
 #else
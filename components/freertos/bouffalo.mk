@@ -11,6 +11,8 @@ COMPONENT_OBJS := $(patsubst %.c,%.o, \
                     tasks.c \
                     timers.c \
                     misaligned/misaligned_ldst.c \
+                    misaligned/misaligned_decode.c \
+                    misaligned/misaligned_prof.c \
                     misaligned/fp_asm.S \
                     panic/panic_c.c \
                     portable/GCC/RISC-V/port.c \
@@ -34,3 +36,7 @@ endif
 ASMFLAGS += -DportasmHANDLE_INTERRUPT=interrupt_entry
 
 CFLAGS += -Wno-unused-parameter
+
+ifeq ($(CONFIG_MISALIGNED_PROFILE),1)
+CFLAGS += -DCFG_MISALIGNED_PROFILE
+endif
@@ -114,7 +114,15 @@
 #define configUSE_MALLOC_FAILED_HOOK    1
 #define configUSE_APPLICATION_TASK_TAG  0
 #define configUSE_COUNTING_SEMAPHORES   1
+#ifdef CFG_CPU_PROFILE
+/* mcycle without the interrupts, see bl_cpu_prof.h */
+extern uint32_t bl_cpu_prof_counter(void);
+#define configGENERATE_RUN_TIME_STATS   1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() bl_cpu_prof_counter()
+#else
 #define configGENERATE_RUN_TIME_STATS   0
+#endif
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
 
@@ -147,6 +147,17 @@ typedef struct xTASK_STATUS
 	configSTACK_DEPTH_TYPE usStackHighWaterMark;	/* The minimum amount of stack space that has remained for the task since the task was created.  The closer this value is to zero the closer the task has come to overflowing its stack. */
 } TaskStatus_t;
 
+/* Used with the uxTaskGetSnapshotAll() function to return the stack of each
+task without locking the task lists. */
+typedef struct xTASK_SNAPSHOT
+{
+	TaskHandle_t xHandle;			/* The handle of the task to which the rest of the information in the structure relates. */
+	StackType_t *pxTopOfStack;		/* The stack pointer saved when the task last left the running state, or entered a trap. */
+	StackType_t *pxStackBase;		/* Points to the lowest address of the task's stack area. */
+	eTaskState eCurrentState;		/* The list the task was found in, eRunning for the task that was running. */
+	UBaseType_t uxCurrentPriority;	/* The priority at which the task was running (may be inherited). */
+} TaskSnapshot_t;
+
 /* Possible return values for eTaskConfirmSleepModeStatus(). */
 typedef enum
 {
@@ -1641,6 +1652,27 @@ TaskHandle_t xTaskGetIdleTaskHandle( void ) PRIVILEGED_FUNCTION;
  */
 UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime ) PRIVILEGED_FUNCTION;
 
+/**
+ * configUSE_TRACE_FACILITY must be defined as 1 in FreeRTOSConfig.h for
+ * uxTaskGetSnapshotAll() to be available.
+ *
+ * uxTaskGetSnapshotAll() populates a TaskSnapshot_t structure for each task
+ * in the system, for a crash handler that has to record the state of every
+ * task.  Unlike uxTaskGetSystemState() it neither suspends the scheduler nor
+ * enters a critical section, so it can be called from an exception or with
+ * interrupts disabled, and it only reads the task lists.  The caller must
+ * make sure that no task runs while it walks them.
+ *
+ * @param pxTaskSnapshotArray A pointer to an array of TaskSnapshot_t
+ * structures.
+ *
+ * @param uxArraySize The size of the array pointed to by the
+ * pxTaskSnapshotArray parameter.  Tasks that do not fit are left out.
+ *
+ * @return The number of TaskSnapshot_t structures that were populated.
+ */
+UBaseType_t uxTaskGetSnapshotAll( TaskSnapshot_t * const pxTaskSnapshotArray, const UBaseType_t uxArraySize ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * <PRE>void vTaskList( char *pcWriteBuffer );</PRE>
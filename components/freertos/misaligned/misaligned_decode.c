@@ -0,0 +1,104 @@
+// See LICENSE for license details.
+
+#include "misaligned_decode.h"
+#include "encoding.h"
+
+/* where the data register of an encoding lives */
+#define REG_RD    7, 5, 0     /* rd */
+#define REG_RS2   20, 5, 0    /* rs2 */
+#define REG_CRS2  2, 5, 0     /* rs2 of the CSS format */
+#define REG_CRS2S 2, 3, 8     /* rd' / rs2' of the CL and CS formats, x8..x15 */
+
+#define OP_NZ_REG 0x80        /* reg 0 is a reserved encoding */
+
+#define LOAD      0
+#define STORE     MISALIGNED_OP_STORE
+#define SIGNED    MISALIGNED_OP_SIGNED
+#define FP        MISALIGNED_OP_FP
+
+struct misaligned_insn {
+  uint32_t mask;
+  uint32_t match;
+  uint8_t len;
+  uint8_t flags;
+  uint8_t reg_shift;
+  uint8_t reg_bits;
+  uint8_t reg_base;
+};
+
+#define INSN(name, len, flags, reg) { MASK_##name, MATCH_##name, len, flags, reg }
+
+/* Byte loads and stores never trap, so they are not listed. Compressed and
+   32-bit encodings differ in the low two bits, so no two entries overlap. */
+static const struct misaligned_insn misaligned_insns[] = {
+  INSN(LW, 4, LOAD | SIGNED, REG_RD),
+  INSN(SW, 4, STORE, REG_RS2),
+  INSN(LH, 2, LOAD | SIGNED, REG_RD),
+  INSN(LHU, 2, LOAD, REG_RD),
+  INSN(SH, 2, STORE, REG_RS2),
+#if MISALIGNED_XLEN == 64
+  INSN(LD, 8, LOAD | SIGNED, REG_RD),
+  INSN(LWU, 4, LOAD, REG_RD),
+  INSN(SD, 8, STORE, REG_RS2),
+#endif
+#ifdef MISALIGNED_FP
+  INSN(FLW, 4, LOAD | FP, REG_RD),
+  INSN(FSW, 4, STORE | FP, REG_RS2),
+# if MISALIGNED_FLEN > 32
+  INSN(FLD, 8, LOAD | FP, REG_RD),
+  INSN(FSD, 8, STORE | FP, REG_RS2),
+# endif
+#endif
+#ifdef MISALIGNED_RVC
+  INSN(C_LW, 4, LOAD | SIGNED, REG_CRS2S),
+  INSN(C_LWSP, 4, LOAD | SIGNED | OP_NZ_REG, REG_RD),
+  INSN(C_SW, 4, STORE, REG_CRS2S),
+  INSN(C_SWSP, 4, STORE, REG_CRS2),
+# if MISALIGNED_XLEN == 64
+  INSN(C_LD, 8, LOAD | SIGNED, REG_CRS2S),
+  INSN(C_LDSP, 8, LOAD | SIGNED | OP_NZ_REG, REG_RD),
+  INSN(C_SD, 8, STORE, REG_CRS2S),
+  INSN(C_SDSP, 8, STORE, REG_CRS2),
+# endif
+# ifdef MISALIGNED_FP
+#  if MISALIGNED_XLEN == 32
+  INSN(C_FLW, 4, LOAD | FP, REG_CRS2S),
+  INSN(C_FLWSP, 4, LOAD | FP, REG_RD),
+  INSN(C_FSW, 4, STORE | FP, REG_CRS2S),
+  INSN(C_FSWSP, 4, STORE | FP, REG_CRS2),
+#  endif
+#  if MISALIGNED_FLEN > 32
+  INSN(C_FLD, 8, LOAD | FP, REG_CRS2S),
+  INSN(C_FLDSP, 8, LOAD | FP, REG_RD),
+  INSN(C_FSD, 8, STORE | FP, REG_CRS2S),
+  INSN(C_FSDSP, 8, STORE | FP, REG_CRS2),
+#  endif
+# endif
+#endif
+};
+
+int misaligned_decode(uintptr_t insn, misaligned_op_t *op)
+{
+  const struct misaligned_insn *p;
+  uint32_t reg;
+  int insn_len = (insn & 0x3) < 0x3 ? 2 : 4;
+
+  /* a compressed encoding only has 16 bits, the rest belongs to the next instruction */
+  if (insn_len == 2)
+    insn &= 0xffff;
+
+  for (p = misaligned_insns; p < misaligned_insns + sizeof(misaligned_insns) / sizeof(misaligned_insns[0]); p++) {
+    if ((insn & p->mask) != p->match)
+      continue;
+    reg = ((insn >> p->reg_shift) & ((1 << p->reg_bits) - 1)) + p->reg_base;
+    if ((p->flags & OP_NZ_REG) && reg == 0)
+      return -1;
+    op->len = p->len;
+    op->flags = p->flags & ~OP_NZ_REG;
+    op->reg = reg;
+    op->insn_len = insn_len;
+    return 0;
+  }
+
+  return -1;
+}
@@ -0,0 +1,40 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_MISALIGNED_DECODE_H
+#define _RISCV_MISALIGNED_DECODE_H
+
+#include <stdint.h>
+
+/* The decoder has no CSR or memory access, so it also builds on the host,
+   where it covers the BL602 ISA, rv32imafc. */
+#ifdef __riscv
+# define MISALIGNED_XLEN __riscv_xlen
+# ifdef __riscv_compressed
+#  define MISALIGNED_RVC 1
+# endif
+# if __riscv_float_abi_single
+#  define MISALIGNED_FP 1
+#  define MISALIGNED_FLEN __riscv_flen
+# endif
+#else
+# define MISALIGNED_XLEN 32
+# define MISALIGNED_RVC 1
+# define MISALIGNED_FP 1
+# define MISALIGNED_FLEN 32
+#endif
+
+#define MISALIGNED_OP_STORE   0x01  /* store, else load */
+#define MISALIGNED_OP_SIGNED  0x02  /* sign extend the loaded value */
+#define MISALIGNED_OP_FP      0x04  /* reg is a float register */
+
+typedef struct misaligned_op {
+  uint8_t len;        /* access width in bytes */
+  uint8_t flags;
+  uint8_t reg;        /* rd of a load, rs2 of a store */
+  uint8_t insn_len;   /* 2 or 4 */
+} misaligned_op_t;
+
+/* 0 and *op filled in for a load or store the trap handlers emulate, -1 otherwise */
+int misaligned_decode(uintptr_t insn, misaligned_op_t *op);
+
+#endif
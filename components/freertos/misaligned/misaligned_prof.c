@@ -0,0 +1,100 @@
+// See LICENSE for license details.
+
+#include "misaligned_prof.h"
+
+#ifdef CFG_MISALIGNED_PROFILE
+
+#include <stdlib.h>
+#include <string.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <cli.h>
+
+#define MISALIGNED_PROF_MASK   (MISALIGNED_PROF_SLOTS - 1)
+#define MISALIGNED_PROF_PROBES 8
+#define MISALIGNED_PROF_TOP    16
+
+/* pc is 2-byte aligned, bit 0 marks a store, 0 is an unused slot */
+struct misaligned_prof_slot {
+  uint32_t pc;
+  uint32_t count;
+};
+
+static struct {
+  struct misaligned_prof_slot slots[MISALIGNED_PROF_SLOTS];
+  uint32_t loads;
+  uint32_t stores;
+  uint32_t dropped;     /* hits of PCs that found no free slot */
+} prof;
+
+void misaligned_prof_hit(uintptr_t pc, int store)
+{
+  uint32_t key = (uint32_t)pc | (store ? 1 : 0);
+  uint32_t pos = ((uint32_t)pc >> 1) * 2654435761u >> 16;
+  int i;
+
+  if (store)
+    prof.stores++;
+  else
+    prof.loads++;
+
+  for (i = 0; i < MISALIGNED_PROF_PROBES; i++, pos++) {
+    struct misaligned_prof_slot *slot = &prof.slots[pos & MISALIGNED_PROF_MASK];
+
+    if (slot->pc == key) {
+      slot->count++;
+      return;
+    }
+    if (slot->pc == 0) {
+      slot->pc = key;
+      slot->count = 1;
+      return;
+    }
+  }
+  prof.dropped++;
+}
+
+void misaligned_prof_reset(void)
+{
+  taskENTER_CRITICAL();
+  memset(&prof, 0, sizeof(prof));
+  taskEXIT_CRITICAL();
+}
+
+static void cmd_misaligned(char *buf, int len, int argc, char **argv)
+{
+  struct misaligned_prof_slot top[MISALIGNED_PROF_TOP], slot;
+  int n = 0, i, j;
+
+  if (argc > 1 && 0 == strcmp(argv[1], "reset")) {
+    misaligned_prof_reset();
+    return;
+  }
+
+  aos_cli_printf("misaligned traps: load %lu store %lu dropped %lu\r\n",
+      prof.loads, prof.stores, prof.dropped);
+
+  /* keep the most frequent PCs, sorted by count */
+  for (i = 0; i < MISALIGNED_PROF_SLOTS; i++) {
+    slot = prof.slots[i];
+    if (slot.pc == 0 || (n == MISALIGNED_PROF_TOP && slot.count <= top[n - 1].count))
+      continue;
+    if (n < MISALIGNED_PROF_TOP)
+      n++;
+    for (j = n - 1; j > 0 && top[j - 1].count < slot.count; j--)
+      top[j] = top[j - 1];
+    top[j] = slot;
+  }
+
+  aos_cli_printf("pc         type  count\r\n");
+  for (i = 0; i < n; i++) {
+    aos_cli_printf("0x%08lx %s %lu\r\n", top[i].pc & ~1UL,
+        (top[i].pc & 1) ? "store" : "load ", top[i].count);
+  }
+}
+
+static const struct cli_command cmds_user[] STATIC_CLI_CMD_ATTRIBUTE = {
+  { "misaligned", "misaligned access traps by pc, 'misaligned reset' clears", cmd_misaligned },
+};
+
+#endif
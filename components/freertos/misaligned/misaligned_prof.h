@@ -0,0 +1,31 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_MISALIGNED_PROF_H
+#define _RISCV_MISALIGNED_PROF_H
+
+#include <stdint.h>
+
+/* Per-PC hit counts of the misaligned load/store traps, built with
+   CONFIG_MISALIGNED_PROFILE=1 and read with the "misaligned" command.
+   tools/misaligned_prof.py maps the PCs to functions and lines. */
+#ifdef CFG_MISALIGNED_PROFILE
+
+#ifndef MISALIGNED_PROF_SLOTS
+#define MISALIGNED_PROF_SLOTS 64      /* power of 2 */
+#endif
+
+/* called from the trap handlers with interrupts disabled */
+void misaligned_prof_hit(uintptr_t pc, int store);
+void misaligned_prof_reset(void);
+
+#else
+
+static inline void misaligned_prof_hit(uintptr_t pc, int store)
+{
+  (void)pc;
+  (void)store;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,202 @@
+// See LICENSE for license details.
+
+/*
+ * Host test of the misaligned load/store decoder, for the BL602 ISA,
+ * rv32imafc. Every emulated encoding is checked with a couple of registers,
+ * then all 16-bit encodings and the 32-bit load/store opcodes are checked
+ * against a reference decoder. From this directory:
+ *
+ *   gcc -I.. ../misaligned_decode.c test_misaligned_decode.c -o test_misaligned_decode
+ *   ./test_misaligned_decode
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+#include "misaligned_decode.h"
+#include "encoding.h"
+
+#define L   0
+#define S   MISALIGNED_OP_STORE
+#define X   MISALIGNED_OP_SIGNED
+#define F   MISALIGNED_OP_FP
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+      printf("FAIL %s:%d ", __FILE__, __LINE__); \
+      printf(__VA_ARGS__); \
+      printf("\r\n"); \
+      failures++; \
+    } \
+  } while (0)
+
+struct decode_case {
+  const char *name;
+  uint32_t insn;
+  int ok;
+  uint8_t len;
+  uint8_t flags;
+  uint8_t reg;
+  uint8_t insn_len;
+};
+
+/* register fields, rs1 and the immediates are filled with ones so that they
+   cannot be mistaken for part of the match */
+#define RD(r)     ((uint32_t)(r) << 7)
+#define RS2(r)    ((uint32_t)(r) << 20)
+#define CRS2(r)   ((uint32_t)(r) << 2)
+#define CRS2S(r)  ((uint32_t)((r) - 8) << 2)
+#define I_OTHER   (0xfff00000 | (31 << 15))
+#define S_OTHER   (0xfe000000 | (31 << 15) | (31 << 7))
+#define CL_OTHER  (0x1c00 | 0x0380 | 0x0060)
+#define CI_OTHER  (0x1000 | 0x007c)
+#define CSS_OTHER 0x1f80
+
+static const struct decode_case cases[] = {
+  {"lw a0",       MATCH_LW | RD(10) | I_OTHER,             1, 4, L | X, 10, 4},
+  {"lw x31",      MATCH_LW | RD(31),                       1, 4, L | X, 31, 4},
+  {"lw x0",       MATCH_LW | RD(0) | I_OTHER,              1, 4, L | X, 0, 4},
+  {"lh t0",       MATCH_LH | RD(5) | I_OTHER,              1, 2, L | X, 5, 4},
+  {"lhu s1",      MATCH_LHU | RD(9) | I_OTHER,             1, 2, L, 9, 4},
+  {"sw a5",       MATCH_SW | RS2(15) | S_OTHER,            1, 4, S, 15, 4},
+  {"sw zero",     MATCH_SW | RS2(0),                       1, 4, S, 0, 4},
+  {"sh ra",       MATCH_SH | RS2(1) | S_OTHER,             1, 2, S, 1, 4},
+  {"flw fa0",     MATCH_FLW | RD(10) | I_OTHER,            1, 4, L | F, 10, 4},
+  {"fsw ft11",    MATCH_FSW | RS2(31) | S_OTHER,           1, 4, S | F, 31, 4},
+  {"c.lw s0",     MATCH_C_LW | CRS2S(8) | CL_OTHER,        1, 4, L | X, 8, 2},
+  {"c.lw a5",     MATCH_C_LW | CRS2S(15),                  1, 4, L | X, 15, 2},
+  {"c.sw a1",     MATCH_C_SW | CRS2S(11) | CL_OTHER,       1, 4, S, 11, 2},
+  {"c.lwsp t6",   MATCH_C_LWSP | RD(31) | CI_OTHER,        1, 4, L | X, 31, 2},
+  {"c.lwsp x0",   MATCH_C_LWSP | RD(0) | CI_OTHER,         0, 0, 0, 0, 0},
+  {"c.swsp s2",   MATCH_C_SWSP | CRS2(18) | CSS_OTHER,     1, 4, S, 18, 2},
+  {"c.swsp imm0", MATCH_C_SWSP | CRS2(18),                 1, 4, S, 18, 2},
+  {"c.flw fs1",   MATCH_C_FLW | CRS2S(9) | CL_OTHER,       1, 4, L | F, 9, 2},
+  {"c.fsw fa4",   MATCH_C_FSW | CRS2S(14) | CL_OTHER,      1, 4, S | F, 14, 2},
+  {"c.flwsp ft0", MATCH_C_FLWSP | RD(0) | CI_OTHER,        1, 4, L | F, 0, 2},
+  {"c.fswsp fs7", MATCH_C_FSWSP | CRS2(23) | CSS_OTHER,    1, 4, S | F, 23, 2},
+  /* the upper half of a compressed fetch is the next instruction */
+  {"c.lw + lw",   (MATCH_LW << 16) | MATCH_C_LW | CRS2S(12), 1, 4, L | X, 12, 2},
+  {"c.sw + addi", (MATCH_ADDI << 16) | MATCH_C_SW | CRS2S(13), 1, 4, S, 13, 2},
+  /* never trap, or not emulated on rv32 */
+  {"lb",          MATCH_LB | RD(10),                       0, 0, 0, 0, 0},
+  {"lbu",         MATCH_LBU | RD(10),                      0, 0, 0, 0, 0},
+  {"sb",          MATCH_SB | RS2(10),                      0, 0, 0, 0, 0},
+  {"ld",          MATCH_LD | RD(10),                       0, 0, 0, 0, 0},
+  {"lwu",         MATCH_LWU | RD(10),                      0, 0, 0, 0, 0},
+  {"sd",          MATCH_SD | RS2(10),                      0, 0, 0, 0, 0},
+  {"fld",         MATCH_FLD | RD(10),                      0, 0, 0, 0, 0},
+  {"fsd",         MATCH_FSD | RS2(10),                     0, 0, 0, 0, 0},
+  {"c.fld",       MATCH_C_FLD | CRS2S(10),                 0, 0, 0, 0, 0},
+  {"c.fsdsp",     MATCH_C_FSDSP | CRS2(10),                0, 0, 0, 0, 0},
+  {"addi",        MATCH_ADDI | RD(10) | I_OTHER,           0, 0, 0, 0, 0},
+  {"amoadd.w",    MATCH_AMOADD_W | RD(10),                 0, 0, 0, 0, 0},
+  {"c.addi",      MATCH_C_ADDI | RD(10),                   0, 0, 0, 0, 0},
+  {"c.unimp",     0x0000,                                  0, 0, 0, 0, 0},
+};
+
+/* the if-chain the trap handlers used before the table, rv32 with C and F,
+   except that c.swsp no longer needs a nonzero bits 7..11, they are offset */
+static int reference(uint32_t insn, misaligned_op_t *op)
+{
+  int store = 0, fp = 0, sign = 0, len, reg;
+  int compressed = (insn & 3) != 3;
+
+  if (compressed)
+    insn &= 0xffff;
+  if ((insn & MASK_LW) == MATCH_LW)
+    len = 4, sign = 1, reg = (insn >> 7) & 31;
+  else if ((insn & MASK_FLW) == MATCH_FLW)
+    len = 4, fp = 1, reg = (insn >> 7) & 31;
+  else if ((insn & MASK_LH) == MATCH_LH)
+    len = 2, sign = 1, reg = (insn >> 7) & 31;
+  else if ((insn & MASK_LHU) == MATCH_LHU)
+    len = 2, reg = (insn >> 7) & 31;
+  else if ((insn & MASK_C_LW) == MATCH_C_LW)
+    len = 4, sign = 1, reg = 8 + ((insn >> 2) & 7);
+  else if ((insn & MASK_C_LWSP) == MATCH_C_LWSP && ((insn >> 7) & 31))
+    len = 4, sign = 1, reg = (insn >> 7) & 31;
+  else if ((insn & MASK_C_FLW) == MATCH_C_FLW)
+    len = 4, fp = 1, reg = 8 + ((insn >> 2) & 7);
+  else if ((insn & MASK_C_FLWSP) == MATCH_C_FLWSP)
+    len = 4, fp = 1, reg = (insn >> 7) & 31;
+  else if ((insn & MASK_SW) == MATCH_SW)
+    len = 4, store = 1, reg = (insn >> 20) & 31;
+  else if ((insn & MASK_FSW) == MATCH_FSW)
+    len = 4, store = 1, fp = 1, reg = (insn >> 20) & 31;
+  else if ((insn & MASK_SH) == MATCH_SH)
+    len = 2, store = 1, reg = (insn >> 20) & 31;
+  else if ((insn & MASK_C_SW) == MATCH_C_SW)
+    len = 4, store = 1, reg = 8 + ((insn >> 2) & 7);
+  else if ((insn & MASK_C_SWSP) == MATCH_C_SWSP)
+    len = 4, store = 1, reg = (insn >> 2) & 31;
+  else if ((insn & MASK_C_FSW) == MATCH_C_FSW)
+    len = 4, store = 1, fp = 1, reg = 8 + ((insn >> 2) & 7);
+  else if ((insn & MASK_C_FSWSP) == MATCH_C_FSWSP)
+    len = 4, store = 1, fp = 1, reg = (insn >> 2) & 31;
+  else
+    return -1;
+
+  op->len = len;
+  op->flags = (store ? S : L) | (sign ? X : 0) | (fp ? F : 0);
+  op->reg = reg;
+  op->insn_len = compressed ? 2 : 4;
+  return 0;
+}
+
+static int same(int rc, const misaligned_op_t *op, int rc_ref, const misaligned_op_t *ref)
+{
+  if (rc != rc_ref)
+    return 0;
+  return rc != 0 || (op->len == ref->len && op->flags == ref->flags &&
+      op->reg == ref->reg && op->insn_len == ref->insn_len);
+}
+
+int main(void)
+{
+  misaligned_op_t op, ref;
+  uint32_t insn, i, hi;
+  int rc, rc_ref, n = 0;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const struct decode_case *c = &cases[i];
+
+    rc = misaligned_decode(c->insn, &op);
+    if (!c->ok) {
+      CHECK(rc != 0, "%s: 0x%08x decoded", c->name, c->insn);
+      continue;
+    }
+    CHECK(0 == rc && op.len == c->len && op.flags == c->flags && op.reg == c->reg &&
+        op.insn_len == c->insn_len, "%s: 0x%08x rc %d len %u flags %u reg %u insn_len %u",
+        c->name, c->insn, rc, op.len, op.flags, op.reg, op.insn_len);
+  }
+
+  /* every compressed encoding, with an arbitrary next instruction above it */
+  for (insn = 0; insn < 0x10000; insn++) {
+    if ((insn & 3) == 3)
+      continue;
+    hi = (insn * 2654435761u) & 0xffff0000;
+    rc = misaligned_decode(hi | insn, &op);
+    rc_ref = reference(insn, &ref);
+    CHECK(same(rc, &op, rc_ref, &ref), "0x%04x: rc %d/%d", insn, rc, rc_ref);
+    n += 0 == rc;
+  }
+
+  /* every funct3, register and low immediate bits of the memory opcodes */
+  for (i = 0; i < 4; i++) {
+    static const uint32_t opcodes[] = {0x03, 0x23, 0x07, 0x27};
+
+    for (insn = 0; insn < (1 << 13); insn++) {
+      uint32_t word = opcodes[i] | (insn << 7) | 0xabc00000;
+
+      rc = misaligned_decode(word, &op);
+      rc_ref = reference(word, &ref);
+      CHECK(same(rc, &op, rc_ref, &ref), "0x%08x: rc %d/%d", word, rc, rc_ref);
+      n += 0 == rc;
+    }
+  }
+
+  printf("%d encodings decoded\r\n", n);
+  printf("%s\r\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
@@ -490,6 +490,12 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait, const BaseT
 
 	static UBaseType_t prvListTasksWithinSingleList( TaskStatus_t *pxTaskStatusArray, List_t *pxList, eTaskState eState ) PRIVILEGED_FUNCTION;
 
+	/*
+	 * Fill in a TaskSnapshot_t structure for each task in pxList, without
+	 * changing the list, at most uxArraySize of them.
+	 */
+	static UBaseType_t prvSnapshotTasksWithinSingleList( TaskSnapshot_t *pxTaskSnapshotArray, UBaseType_t uxArraySize, const List_t *pxList, eTaskState eState ) PRIVILEGED_FUNCTION;
+
 #endif
 
 /*
@@ -2588,6 +2594,39 @@ TCB_t *pxTCB;
 #endif /* configUSE_TRACE_FACILITY */
 /*----------------------------------------------------------*/
 
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+	UBaseType_t uxTaskGetSnapshotAll( TaskSnapshot_t * const pxTaskSnapshotArray, const UBaseType_t uxArraySize )
+	{
+	UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES;
+
+		do
+		{
+			uxQueue--;
+			uxTask += prvSnapshotTasksWithinSingleList( &( pxTaskSnapshotArray[ uxTask ] ), uxArraySize - uxTask, &( pxReadyTasksLists[ uxQueue ] ), eReady );
+		} while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+
+		uxTask += prvSnapshotTasksWithinSingleList( &( pxTaskSnapshotArray[ uxTask ] ), uxArraySize - uxTask, pxDelayedTaskList, eBlocked );
+		uxTask += prvSnapshotTasksWithinSingleList( &( pxTaskSnapshotArray[ uxTask ] ), uxArraySize - uxTask, pxOverflowDelayedTaskList, eBlocked );
+
+		#if( INCLUDE_vTaskDelete == 1 )
+		{
+			uxTask += prvSnapshotTasksWithinSingleList( &( pxTaskSnapshotArray[ uxTask ] ), uxArraySize - uxTask, &xTasksWaitingTermination, eDeleted );
+		}
+		#endif
+
+		#if ( INCLUDE_vTaskSuspend == 1 )
+		{
+			uxTask += prvSnapshotTasksWithinSingleList( &( pxTaskSnapshotArray[ uxTask ] ), uxArraySize - uxTask, &xSuspendedTaskList, eSuspended );
+		}
+		#endif
+
+		return uxTask;
+	}
+
+#endif /* configUSE_TRACE_FACILITY */
+/*----------------------------------------------------------*/
+
 #if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
 
 	TaskHandle_t xTaskGetIdleTaskHandle( void )
@@ -3871,6 +3910,37 @@ static void prvCheckTasksWaitingTermination( void )
 #endif /* configUSE_TRACE_FACILITY */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+	static UBaseType_t prvSnapshotTasksWithinSingleList( TaskSnapshot_t *pxTaskSnapshotArray, UBaseType_t uxArraySize, const List_t *pxList, eTaskState eState )
+	{
+	const ListItem_t *pxItem;
+	TCB_t *pxTCB;
+	UBaseType_t uxTask = 0, uxLength;
+
+		/* The length bounds the walk in case the crash being recorded has
+		corrupted the links. */
+		uxLength = listCURRENT_LIST_LENGTH( pxList );
+		pxItem = listGET_HEAD_ENTRY( pxList );
+
+		while( ( uxLength-- > ( UBaseType_t ) 0 ) && ( uxTask < uxArraySize ) && ( pxItem != listGET_END_MARKER( pxList ) ) )
+		{
+			pxTCB = listGET_LIST_ITEM_OWNER( pxItem );
+			pxTaskSnapshotArray[ uxTask ].xHandle = ( TaskHandle_t ) pxTCB;
+			pxTaskSnapshotArray[ uxTask ].pxTopOfStack = ( StackType_t * ) pxTCB->pxTopOfStack;
+			pxTaskSnapshotArray[ uxTask ].pxStackBase = pxTCB->pxStack;
+			pxTaskSnapshotArray[ uxTask ].eCurrentState = ( pxTCB == pxCurrentTCB ) ? eRunning : eState;
+			pxTaskSnapshotArray[ uxTask ].uxCurrentPriority = pxTCB->uxPriority;
+			uxTask++;
+			pxItem = listGET_NEXT( pxItem );
+		}
+
+		return uxTask;
+	}
+
+#endif /* configUSE_TRACE_FACILITY */
+/*-----------------------------------------------------------*/
+
 #if ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) )
 
 	static configSTACK_DEPTH_TYPE prvTaskCheckFreeStackSpace( const uint8_t * pucStackByte )
@@ -6,7 +6,9 @@ COMPONENT_ADD_INCLUDEDIRS +=
 COMPONENT_PRIV_INCLUDEDIRS := include
 
 ## This component's src
-COMPONENT_SRCS :=   src/bl_romfs.c
+COMPONENT_SRCS :=   src/bl_romfs.c \
+                    src/bl_romfs_index.c \
+                    src/bl_romfs_lz4.c
 
 COMPONENT_OBJS := $(patsubst %.c,%.o, $(COMPONENT_SRCS))
 
@@ -63,6 +63,14 @@
  * -A N,/name force named file(s) (shell globbing applied against the filenames)
  *       to be aligned on N bytes boundary
  * In both cases, N must be a power of two.
+ * -i    append a sorted, hashed path index to the root directory, the
+ *       bl_romfs driver then resolves paths with a binary search
+ * -z PATTERN store matching regular files as LZ4 compressed 4 KB blocks,
+ *       implies -i. Such files are no longer directly addressable through
+ *       IOCTL_ROMFS_GET_FILEBUF, so keep files played from flash out of it.
+ *
+ * Both extensions leave a valid romfs image, see bl_romfs_image.h for the
+ * layout of the index and of the compressed files.
  */
 
 /*
@@ -107,6 +115,17 @@ struct romfh {
 #define ROMFH_FIF 7
 #define ROMFH_EXEC 8
 
+/* keep in sync with bl_romfs_image.h */
+#define ROMFS_IDX_NAME ".romfs.idx"
+#define ROMFS_IDX_MAGIC 0x52494458 /* RIDX */
+#define ROMFS_IDX_VERSION 1
+#define ROMFS_IDX_F_LZ4 0x00000001
+#define ROMFS_ZBLK_MAGIC 0x525a3442 /* RZ4B */
+#define ROMFS_ZBLK_SHIFT 12
+#define ROMFS_ZBLK_SIZE (1 << ROMFS_ZBLK_SHIFT)
+#define ROMFS_ZBLK_RAW 0x80000000
+#define LZ4_BOUND(n) ((n) + (n)/255 + 16)
+
 struct filenode;
 
 struct filehdr {
@@ -135,6 +154,9 @@ struct filenode {
     unsigned int offset;
     unsigned int size;
     unsigned int pad;
+    /* contents built in memory: compressed stream or the index */
+    unsigned char *data;
+    int lz4;
 };
 
 struct aligns {
@@ -197,6 +219,8 @@ static int atoffs = 0;
 static int align = 16;
 struct aligns *alignlist = NULL;
 struct excludes *excludelist = NULL;
+struct excludes *compresslist = NULL;
+int mkindex = 0;
 int realbase;
 
 /* helper function to match an exclusion or align pattern */
@@ -266,7 +290,7 @@ void dumpdata(void *addr, int len, FILE *f)
 
     if (atoffs==512) {
         ri = (struct romfh *)&fixbuf;
-        fixsum(ri, atoffs<ntohl(ri->size)?atoffs:ntohl(ri->size));
+        fixsum(ri, atoffs<(int)ntohl(ri->size)?atoffs:(int)ntohl(ri->size));
         fwrite(fixbuf, atoffs, 1, f);
     }
     if (len) {
@@ -355,6 +379,10 @@ void dumpnode(struct filenode *node, FILE *f)
         memset(bigbuf, 0, sizeof(bigbuf));
         readlink(node->realname, bigbuf, node->size);
         dumpdataa(bigbuf, node->size, f);
+    } else if (S_ISREG(node->modes) && node->data) {
+        ri.nextfh |= htonl(ROMFH_REG);
+        dumpri(&ri, node, f);
+        dumpdataa(node->data, node->size, f);
     } else if (S_ISREG(node->modes)) {
         int offset, len, fd, max, avail;
         ri.nextfh |= htonl(ROMFH_REG);
@@ -369,7 +397,7 @@ void dumpnode(struct filenode *node, FILE *f)
 );
         if (fd) {
             while(offset < max) {
-                avail = max-offset < sizeof(bigbuf) ? max-offset : sizeof(bigbuf);
+                avail = max-offset < (int)sizeof(bigbuf) ? max-offset : (int)sizeof(bigbuf);
                 len = read(fd, bigbuf, avail);
                 if (len <= 0)
                     break;
@@ -380,7 +408,7 @@ void dumpnode(struct filenode *node, FILE *f)
         }
         max = (max+15)&~15;
         while (offset < max) {
-            avail = max-offset < sizeof(bigbuf) ? max-offset : sizeof(bigbuf);
+            avail = max-offset < (int)sizeof(bigbuf) ? max-offset : (int)sizeof(bigbuf);
             memset(bigbuf, 0, avail);
             dumpdata(bigbuf, avail, f);
             offset+=avail;
@@ -433,6 +461,7 @@ void dumpall(struct filenode *node, int lastoff, FILE *f)
 void freenode(struct filenode *n)
 {
     /* Rare, not yet */
+    (void)n;
 }
 
 void setnode(struct filenode *n, dev_t dev, ino_t ino, mode_t um)
@@ -493,6 +522,8 @@ struct filenode *newnode(const char *base, const char *name, int curroffset)
     node->orig_link = NULL;
     node->offset = curroffset;
     node->pad = 0;
+    node->data = NULL;
+    node->lz4 = 0;
 
     return node;
 }
@@ -535,6 +566,257 @@ int alignnode(struct filenode *node, int curroffset, int extraspace)
     return curroffset;
 }
 
+/* LZ4 compression and the path index */
+
+void put32(unsigned char *p, unsigned int v)
+{
+    v = htonl(v);
+    memcpy(p, &v, 4);
+}
+
+unsigned char *lz4length(unsigned char *op, int len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+unsigned char *lz4sequence(unsigned char *op, const unsigned char *lit, int litlen,
+    int off, int mlen)
+{
+    unsigned char *token = op++;
+
+    *token = (litlen < 15 ? litlen : 15) << 4;
+    if (litlen >= 15)
+        op = lz4length(op, litlen - 15);
+    memcpy(op, lit, litlen);
+    op += litlen;
+    if (!mlen)
+        return op;
+    *op++ = off & 0xff;
+    *op++ = off >> 8;
+    mlen -= 4;
+    *token |= mlen < 15 ? mlen : 15;
+    if (mlen >= 15)
+        op = lz4length(op, mlen - 15);
+    return op;
+}
+
+/* Greedy LZ4 block compressor, dst holds LZ4_BOUND(len) bytes. Follows the
+ * end of block rules of the format (last 5 bytes are literals, no match
+ * starts in the last 12 bytes) so any LZ4 decoder takes the blocks. */
+int lz4compress(const unsigned char *src, int len, unsigned char *dst)
+{
+    static int table[4096];
+    unsigned char *op = dst;
+    unsigned int seq, h;
+    int ip = 0, anchor = 0, ref, mlen;
+
+    memset(table, 0xff, sizeof(table));
+    while (ip < len - 12) {
+        memcpy(&seq, src + ip, 4);
+        h = (seq * 2654435761u) >> 20;
+        ref = table[h];
+        table[h] = ip;
+        if (ref < 0 || ip - ref > 65535 || memcmp(src + ref, src + ip, 4)) {
+            ip++;
+            continue;
+        }
+        mlen = 4;
+        while (ip + mlen < len - 5 && src[ref + mlen] == src[ip + mlen])
+            mlen++;
+        op = lz4sequence(op, src + anchor, ip - anchor, ip - ref, mlen);
+        ip += mlen;
+        anchor = ip;
+    }
+    op = lz4sequence(op, src + anchor, len - anchor, 0, 0);
+    return op - dst;
+}
+
+/* Replace the contents of a regular file by its block stream, files that
+ * do not shrink stay plain */
+void compressnode(struct filenode *node)
+{
+    unsigned char *in, *out, *p;
+    int fd, len, blocks, b, blen, clen, raw;
+
+    in = malloc(node->size + 1);
+    fd = open(node->realname, O_RDONLY
+#ifdef O_BINARY
+| O_BINARY
+#endif
+);
+    if (!in || fd < 0) {
+        fprintf(stderr, "cannot compress '%s'\n", node->realname);
+        exit(1);
+    }
+    for (len = 0; len < (int)node->size; len += b) {
+        b = read(fd, in + len, node->size - len);
+        if (b <= 0) {
+            fprintf(stderr, "short read of '%s'\n", node->realname);
+            exit(1);
+        }
+    }
+    close(fd);
+
+    blocks = (node->size + ROMFS_ZBLK_SIZE - 1) >> ROMFS_ZBLK_SHIFT;
+    out = malloc(16 + 4*blocks + blocks*LZ4_BOUND(ROMFS_ZBLK_SIZE));
+    if (!out) {
+        fprintf(stderr,"out of memory\n");
+        exit(1);
+    }
+    put32(out, ROMFS_ZBLK_MAGIC);
+    put32(out+4, node->size);
+    put32(out+8, blocks);
+    put32(out+12, ROMFS_ZBLK_SHIFT);
+    p = out + 16 + 4*blocks;
+    for (b = 0; b < blocks; b++) {
+        blen = node->size - (b << ROMFS_ZBLK_SHIFT);
+        if (blen > ROMFS_ZBLK_SIZE)
+            blen = ROMFS_ZBLK_SIZE;
+        clen = lz4compress(in + (b << ROMFS_ZBLK_SHIFT), blen, p);
+        raw = clen >= blen;
+        if (raw) {
+            memcpy(p, in + (b << ROMFS_ZBLK_SHIFT), blen);
+            clen = blen;
+        }
+        p += clen;
+        put32(out + 16 + 4*b, (p - (out + 16 + 4*blocks)) | (raw ? ROMFS_ZBLK_RAW : 0));
+    }
+    free(in);
+
+    len = p - out;
+    if (len >= (int)node->size) {
+        free(out);
+        return;
+    }
+    node->data = out;
+    node->size = len;
+    node->lz4 = 1;
+}
+
+struct idxent {
+    unsigned int hash;
+    unsigned int offset;
+    unsigned int flags;
+    char *path;
+};
+
+static struct idxent *idxents;
+static int idxcount, idxalloc;
+
+unsigned int idxhash(const char *path)
+{
+    unsigned int hash = 2166136261u;
+
+    while (*path)
+        hash = (hash ^ (unsigned char)*path++) * 16777619u;
+    return hash;
+}
+
+int idxcmp(const void *a, const void *b)
+{
+    const struct idxent *ea = a, *eb = b;
+
+    if (ea->hash != eb->hash)
+        return ea->hash < eb->hash ? -1 : 1;
+    return strcmp(ea->path, eb->path);
+}
+
+/* Same entries as the driver finds by walking: directories and regular
+ * files, no hard links */
+void collectindex(struct filenode *dir, const char *prefix)
+{
+    struct filenode *p;
+    struct idxent *e;
+    char *path;
+
+    for (p = dir->dirlist.head; p->next; p = p->next) {
+        if (!strcmp(p->name, ".") || !strcmp(p->name, ".."))
+            continue;
+        if (p->orig_link || !(S_ISDIR(p->modes) || S_ISREG(p->modes)))
+            continue;
+        path = malloc(strlen(prefix) + strlen(p->name) + 2);
+        if (!path) {
+            fprintf(stderr,"out of memory\n");
+            exit(1);
+        }
+        if (*prefix)
+            sprintf(path, "%s/%s", prefix, p->name);
+        else
+            strcpy(path, p->name);
+
+        if (idxcount == idxalloc) {
+            idxalloc = idxalloc ? idxalloc*2 : 64;
+            idxents = realloc(idxents, idxalloc * sizeof(*idxents));
+            if (!idxents) {
+                fprintf(stderr,"out of memory\n");
+                exit(1);
+            }
+        }
+        e = &idxents[idxcount++];
+        e->hash = idxhash(path);
+        e->offset = p->offset;
+        e->flags = p->lz4 ? ROMFS_IDX_F_LZ4 : 0;
+        e->path = path;
+
+        if (S_ISDIR(p->modes))
+            collectindex(p, path);
+    }
+}
+
+/* Append the index as the last file of the root directory */
+int addindex(struct filenode *root, int curroffset)
+{
+    struct filenode *n;
+    unsigned char *buf;
+    unsigned int flags = 0;
+    int i, len, str;
+
+    for (n = root->dirlist.head; n->next; n = n->next) {
+        if (!strcmp(n->name, ROMFS_IDX_NAME)) {
+            fprintf(stderr, "'%s' is reserved for the index\n", n->realname);
+            exit(1);
+        }
+    }
+    collectindex(root, "");
+    qsort(idxents, idxcount, sizeof(*idxents), idxcmp);
+
+    len = 16 + 16*idxcount;
+    for (i = 0; i < idxcount; i++)
+        len += strlen(idxents[i].path) + 1;
+    buf = malloc(len);
+    if (!buf) {
+        fprintf(stderr,"out of memory\n");
+        exit(1);
+    }
+    str = 16 + 16*idxcount;
+    for (i = 0; i < idxcount; i++) {
+        put32(buf + 16 + 16*i, idxents[i].hash);
+        put32(buf + 16 + 16*i + 4, idxents[i].offset);
+        put32(buf + 16 + 16*i + 8, str);
+        put32(buf + 16 + 16*i + 12, idxents[i].flags);
+        flags |= idxents[i].flags;
+        strcpy((char *)buf + str, idxents[i].path);
+        str += strlen(idxents[i].path) + 1;
+    }
+    put32(buf, ROMFS_IDX_MAGIC);
+    put32(buf + 4, ROMFS_IDX_VERSION);
+    put32(buf + 8, idxcount);
+    put32(buf + 12, flags);
+
+    n = newnode("", ROMFS_IDX_NAME, curroffset);
+    setnode(n, -1, -1, S_IFREG | 0444);
+    append(&root->dirlist, n);
+    curroffset = alignnode(n, curroffset, spaceneeded(n));
+    n->size = len;
+    n->data = buf;
+    return curroffset + spaceneeded(n);
+}
+
 int processdir(int level, const char *base, const char *dirname, struct stat *sb,
     struct filenode *dir, struct filenode *root, int curroffset)
 {
@@ -543,6 +825,8 @@ int processdir(int level, const char *base, const char *dirname, struct stat *sb
     struct filenode *n, *link;
     struct excludes *pe;
 
+    (void)dirname;
+
     if (level <= 1) {
         /* Ok, to make sure . and .. are handled correctly
          * we add them first.  Note also that we alloc them
@@ -669,6 +953,12 @@ int processdir(int level, const char *base, const char *dirname, struct stat *sb
         if (S_ISREG(sb->st_mode)) {
             curroffset = alignnode(n, curroffset, spaceneeded(n));
             n->size = sb->st_size;
+            for (pe = compresslist; pe; pe = pe->next) {
+                if (!nodematch(pe->pattern, n)) {
+                    compressnode(n);
+                    break;
+                }
+            }
         } else
             curroffset = alignnode(n, curroffset, 0);
         if (S_ISLNK(sb->st_mode)) {
@@ -706,6 +996,8 @@ void showhelp(const char *argv0)
     printf("  -a ALIGN               Align regular file data to ALIGN bytes\n");
     printf("  -A ALIGN,PATTERN       Align all objects matching pattern to at least ALIGN bytes\n");
     printf("  -x PATTERN             Exclude all objects matching pattern\n");
+    printf("  -i                     Add a path index for the bl_romfs driver\n");
+    printf("  -z PATTERN             LZ4 compress regular files matching pattern, implies -i\n");
     printf("  -h                     Show this help\n");
     printf("\n");
     printf("Report bugs to chexum@shadow.banki.hu\n");
@@ -728,7 +1020,7 @@ int main(int argc, char *argv[])
     struct excludes *pe, *pe2;
     FILE *f;
 
-    while ((c = getopt(argc, argv, "V:vd:f:ha:A:x:")) != EOF) {
+    while ((c = getopt(argc, argv, "V:vd:f:ha:A:x:iz:")) != EOF) {
         switch(c) {
         case 'd':
             dir = optarg;
@@ -787,6 +1079,16 @@ int main(int argc, char *argv[])
                 pe2->next = pe;
             }
             break;
+        case 'i':
+            mkindex = 1;
+            break;
+        case 'z':
+            pe = (struct excludes *)malloc(sizeof(*pe) + strlen(optarg) + 1);
+            pe->next = compresslist;
+            strcpy(pe->pattern, optarg);
+            compresslist = pe;
+            mkindex = 1;
+            break;
         default:
             exit(1);
         }
@@ -815,6 +1117,8 @@ int main(int argc, char *argv[])
     root = newnode(dir, volname, 0);
     root->parent = root;
     lastoff = processdir (1, dir, dir, &sb, root, root, spaceneeded(root));
+    if (mkindex)
+        lastoff = addindex(root, lastoff);
     if (verbose)
         shownode(0, root, stderr);
     dumpall(root, lastoff, f);
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_ROMFS_IMAGE_H__
+#define __BL_ROMFS_IMAGE_H__
+
+#include <stdint.h>
+
+#include <bl_romfs.h>
+
+/*
+ * Optional extensions written by genromfs -i / -z, a plain romfs reader still
+ * walks such an image, it only sees one more file in the root directory and
+ * the compressed files as their block streams. All words are big endian.
+ *
+ * Index, the regular file ROMFS_IDX_NAME in the root directory:
+ *   magic, version, count, flags
+ *   count entries { hash, header offset, path offset, flags }, sorted by hash
+ *   and then by path
+ *   the NUL terminated paths, relative to the root and without a leading '/'
+ * Only directories and regular files are indexed, the hash is FNV-1a.
+ *
+ * Compressed file, an indexed file with ROMFS_IDX_F_LZ4, its romfs size is
+ * the size of the stored stream:
+ *   magic, file size, block count, block shift
+ *   one end offset per block, relative to the end of this table, with
+ *   ROMFS_ZBLK_RAW set when the block is stored uncompressed
+ *   the blocks, LZ4 block format
+ */
+#define ROMFS_IDX_NAME          ".romfs.idx"
+#define ROMFS_IDX_MAGIC         U32MK_HL('R', 'I', 'D', 'X')
+#define ROMFS_IDX_VERSION       1
+#define ROMFS_IDX_F_LZ4         0x00000001  /* entry: file is compressed, index: some file is */
+
+#define ROMFS_ZBLK_MAGIC        U32MK_HL('R', 'Z', '4', 'B')
+#define ROMFS_ZBLK_SHIFT        12
+#define ROMFS_ZBLK_SIZE         (1 << ROMFS_ZBLK_SHIFT)
+#define ROMFS_ZBLK_RAW          0x80000000
+
+#ifndef ROMFS_ZCACHE_SLOTS
+#define ROMFS_ZCACHE_SLOTS      3
+#endif
+
+typedef struct romfs_idx {
+    const char *root;
+    const uint32_t *entries;
+    uint32_t count;
+    uint32_t flags;
+    const char *hdr;            /* the index file itself, hidden from readdir */
+} romfs_idx_t;
+
+typedef struct romfs_zslot {
+    const char *payload;        /* stream the block belongs to, NULL if unused */
+    uint32_t block;
+    uint32_t stamp;
+    uint8_t *buf;
+} romfs_zslot_t;
+
+typedef struct romfs_zcache {
+    romfs_zslot_t slot[ROMFS_ZCACHE_SLOTS];
+    uint32_t clock;
+    uint32_t hits;
+    uint32_t misses;
+} romfs_zcache_t;
+
+uint32_t romfs_idx_hash(const char *path, int len);
+/* 0 when root holds a valid index, -1 for a plain image */
+int romfs_idx_attach(romfs_idx_t *idx, const char *root);
+/* path relative to the root, len bytes of it, no trailing '/' */
+int romfs_idx_find(const romfs_idx_t *idx, const char *path, int len, char **hdr, uint32_t *flags);
+
+/* decoded length, -1 if src is not a valid LZ4 block fitting in dstlen */
+int romfs_lz4_decode(const uint8_t *src, int srclen, uint8_t *dst, int dstlen);
+/* mem holds ROMFS_ZCACHE_SLOTS * ROMFS_ZBLK_SIZE bytes */
+void romfs_zcache_init(romfs_zcache_t *cache, uint8_t *mem);
+/* file size of the stored stream, -1 if the stream is broken */
+int romfs_zfile_size(const char *payload, uint32_t stored, uint32_t *size);
+/* read like romfs_read, returns the copied length or -1 on a broken block */
+int romfs_zfile_read(romfs_zcache_t *cache, const char *payload, uint32_t stored,
+        uint32_t off, char *buf, uint32_t len);
+
+#endif
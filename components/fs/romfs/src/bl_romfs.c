@@ -36,6 +36,7 @@
 #include <aos/kernel.h>
 #include <bl_mtd.h>
 #include <bl_romfs.h>
+#include <bl_romfs_image.h>
 
 #include <utils_log.h>
 
@@ -51,6 +52,8 @@
 #define ROMFH_REG       2
 #define ROMFH_UNKNOW    3
 
+#define ROMFS_FARG_LZ4  0x1     /* f_arg tag of compressed files, headers are 16 byte aligned */
+
 struct romfh {
     int32_t nextfh;
     int32_t spec;
@@ -69,6 +72,9 @@ typedef struct _rom_dir_t
 
 static char *romfs_root = NULL;         /* The mount point of the physical addr */
 static bl_mtd_handle_t handle_romfs;
+static romfs_idx_t romfs_idx;           /* root is NULL for plain images */
+static romfs_zcache_t romfs_zcache;
+static aos_mutex_t romfs_zmutex;
 
 static int is_path_ch(char ch)
 {
@@ -151,6 +157,22 @@ static int romfs_mount(void)
     ROMFS_DUBUG("xip addr = %p\r\n", romfs_root);
     log_buf(romfs_root, 64);
 
+    if (0 != romfs_idx_attach(&romfs_idx, romfs_root)) {
+        return 0;
+    }
+    log_info("romfs index %lu entries, flags 0x%lx\r\n", romfs_idx.count, romfs_idx.flags);
+    if (romfs_idx.flags & ROMFS_IDX_F_LZ4) {
+        uint8_t *mem = aos_malloc(ROMFS_ZCACHE_SLOTS * ROMFS_ZBLK_SIZE);
+
+        if ((NULL == mem) || (0 != aos_mutex_new(&romfs_zmutex))) {
+            log_error("romfs block cache alloc error\r\n");
+            aos_free(mem);
+            romfs_root = NULL;
+            return -1;
+        }
+        romfs_zcache_init(&romfs_zcache, mem);
+    }
+
     return 0;
 }
 
@@ -187,6 +209,33 @@ static uint32_t dirent_size(void *addr)
     return U32HTONL(*((uint32_t *)addr + 2));
 }
 
+static char *dirent_payload(void *addr)
+{
+    return (char *)addr + ALIGNUP16(strlen((char *)addr + 16) + 1) + 16;
+}
+
+static char *file_hdr(file_t *fp)
+{
+    return (char *)((uintptr_t)fp->f_arg & ~(uintptr_t)ROMFS_FARG_LZ4);
+}
+
+static int file_is_lz4(file_t *fp)
+{
+    return ((uintptr_t)fp->f_arg & ROMFS_FARG_LZ4);
+}
+
+/* file size, the stream of a compressed file was checked by romfs_open */
+static uint32_t file_size(file_t *fp)
+{
+    uint32_t size = 0;
+
+    if (file_is_lz4(fp)) {
+        romfs_zfile_size(dirent_payload(file_hdr(fp)), dirent_size(file_hdr(fp)), &size);
+        return size;
+    }
+    return dirent_size(file_hdr(fp));
+}
+
 static int file_info(char *path, char **p_addr_start_input, char **p_addr_end_input)
 {
     char *addr_start = *p_addr_start_input;
@@ -248,12 +297,36 @@ static int file_info(char *path, char **p_addr_start_input, char **p_addr_end_in
     return 0;
 }
 
-/*
- * input : path
- * output: p_addr_start_input, p_addr_end_input
- * return: 0 success, other error
- */
-uint32_t dirent_file(char *path, void **p_addr_start_input, void **p_addr_end_input)
+/* resolve p_name, relative to the mount point, with the index of the image */
+static int dirent_index(char *p_name, void **p_addr_start_input, void **p_addr_end_input, uint32_t *flags)
+{
+    char *addr_start;
+    int len;
+
+    len = strlen(p_name);
+    if ((len > 0) && (p_name[len - 1] == '/')) {
+        len--;
+    }
+    if (0 == len) {
+        *p_addr_start_input = romfs_root;
+        *p_addr_end_input = (char *)romfs_endaddr();
+        return 0;
+    }
+
+    if (0 != romfs_idx_find(&romfs_idx, p_name, len, &addr_start, flags)) {
+        log_warn("not found path = %s\r\n", p_name);
+        return -1;
+    }
+    *p_addr_start_input = addr_start;
+    if (0 == dirent_hardfh(addr_start)) {
+        *p_addr_end_input = (char *)romfs_endaddr();
+    } else {
+        *p_addr_end_input = romfs_root + dirent_hardfh(addr_start);
+    }
+    return 0;
+}
+
+static int dirent_lookup(char *path, void **p_addr_start_input, void **p_addr_end_input, uint32_t *flags)
 {
     char *addr_start;
     char *addr_end;
@@ -286,6 +359,11 @@ uint32_t dirent_file(char *path, void **p_addr_start_input, void **p_addr_end_in
         p_name += 1;
     }
 
+    *flags = 0;
+    if (romfs_idx.root) {
+        return dirent_index(p_name, p_addr_start_input, p_addr_end_input, flags);
+    }
+
     /* search every one */
     addr_start = romfs_root;
     addr_end = (char *)romfs_endaddr();
@@ -342,10 +420,24 @@ uint32_t dirent_file(char *path, void **p_addr_start_input, void **p_addr_end_in
     return 0;
 }
 
+/*
+ * input : path
+ * output: p_addr_start_input, p_addr_end_input
+ * return: 0 success, other error
+ */
+uint32_t dirent_file(char *path, void **p_addr_start_input, void **p_addr_end_input)
+{
+    uint32_t flags;
+
+    return dirent_lookup(path, p_addr_start_input, p_addr_end_input, &flags);
+}
+
 static int romfs_open(file_t *fp, const char *path, [[gnu::unused]] int flags)
 {
     char *start_addr;
     char *end_addr;
+    uint32_t idx_flags;
+    uint32_t size;
 
     ROMFS_DUBUG("romfs open.\r\n");
 
@@ -362,12 +454,20 @@ static int romfs_open(file_t *fp, const char *path, [[gnu::unused]] int flags)
     }
 
     /* jump to the back of volume name, get addr_max */
-    if (0 != dirent_file((char *)path, (void **)&start_addr, (void **)&end_addr)) {
+    if (0 != dirent_lookup((char *)path, (void **)&start_addr, (void **)&end_addr, &idx_flags)) {
         return -2;
     }
 
     fp->f_arg = start_addr;
     fp->offset = 0;
+    if (idx_flags & ROMFS_IDX_F_LZ4) {
+        if (0 != romfs_zfile_size(dirent_payload(start_addr), dirent_size(start_addr), &size)) {
+            log_error("compressed file is broken.\r\n");
+            fp->f_arg = NULL;
+            return -3;
+        }
+        fp->f_arg = (void *)((uintptr_t)start_addr | ROMFS_FARG_LZ4);
+    }
 
     return 0;
 }
@@ -388,8 +488,21 @@ static ssize_t romfs_read(file_t *fp, char *buf, size_t length)
     int len;
 
     /* init payload_buf and payload_size */
-    payload_buf  = ((char *)fp->f_arg) + ALIGNUP16(strlen(((char *)fp->f_arg) + 16) + 1) + 16;
-    payload_size = dirent_size(fp->f_arg);
+    payload_buf  = dirent_payload(file_hdr(fp));
+    payload_size = dirent_size(file_hdr(fp));
+
+    if (file_is_lz4(fp)) {
+        /* the block cache is shared by all open files */
+        aos_mutex_lock(&romfs_zmutex, AOS_WAIT_FOREVER);
+        len = romfs_zfile_read(&romfs_zcache, payload_buf, payload_size, fp->offset, buf, length);
+        aos_mutex_unlock(&romfs_zmutex);
+        if (len < 0) {
+            log_error("compressed block is broken.\r\n");
+            return -1;
+        }
+        fp->offset += len;
+        return len;
+    }
 
     /* check arg */
     if (fp->offset >= payload_size) {
@@ -423,7 +536,11 @@ int romfs_ioctl(file_t *fp, int cmd, unsigned long arg)
         case (IOCTL_ROMFS_GET_FILEBUF):
         {
             ROMFS_DUBUG("IOCTL_ROMFS_GET_FILEBUF.\r\n");
-            file_buf->buf= ((char *)fp->f_arg) + ALIGNUP16(strlen(((char *)fp->f_arg) + 16) + 1) + 16;
+            if (file_is_lz4(fp)) {
+                log_warn("compressed file has no XIP buffer.\r\n");
+                return -4;
+            }
+            file_buf->buf= dirent_payload(fp->f_arg);
             file_buf->bufsize = dirent_size(fp->f_arg);
             return 0;
         }
@@ -446,7 +563,7 @@ static off_t romfs_lseek(file_t *fp, off_t off, int whence)
         return -1;
     }
 
-    payload_size = dirent_size(fp->f_arg);
+    payload_size = file_size(fp);
 
     if (whence == SEEK_SET) {
         if (off < 0) {
@@ -481,10 +598,12 @@ static int romfs_stat([[gnu::unused]] file_t *fp, const char *path, struct stat
 {
     char *start_addr = 0;
     char *end_addr = 0;
+    uint32_t flags;
+    uint32_t size;
     int res;
 
     ROMFS_DUBUG("romfs_stat path = %s\r\n", path);
-    res = dirent_file((char *)path, (void **)&start_addr, (void **)&end_addr);
+    res = dirent_lookup((char *)path, (void **)&start_addr, (void **)&end_addr, &flags);
 
     if (res != 0) {
         log_warn("dirent_file res = %d\r\n", res);
@@ -500,6 +619,13 @@ static int romfs_stat([[gnu::unused]] file_t *fp, const char *path, struct stat
             ROMFS_DUBUG("st_size set 0");
         } else if (ROMFH_REG == dirent_type(start_addr)) {
             st->st_size = dirent_size(start_addr);
+            if (flags & ROMFS_IDX_F_LZ4) {
+                if (0 != romfs_zfile_size(dirent_payload(start_addr), dirent_size(start_addr), &size)) {
+                    log_warn("compressed file is broken.\r\n");
+                    return -2;
+                }
+                st->st_size = size;
+            }
             ROMFS_DUBUG("st_size set %ld\r\n", st->st_size);
             st->st_mode = S_IFREG;
         } else {
@@ -558,6 +684,7 @@ static aos_dir_t *romfs_opendir([[gnu::unused]] file_t *fp, const char *path)
 static aos_dirent_t *romfs_readdir([[gnu::unused]] file_t *fp, aos_dir_t *dir)
 {
     romfs_dir_t    *dp = (romfs_dir_t *)dir;
+    char *hdr;
 
     if (!dp) {
         return NULL;
@@ -596,6 +723,7 @@ static aos_dirent_t *romfs_readdir([[gnu::unused]] file_t *fp, aos_dir_t *dir)
         }
 
         ROMFS_DUBUG("name = %s\r\n", (char *)(dp->dir_cur_addr + 16));
+        hdr = dp->dir_cur_addr;
         strncpy(dp->cur_dirent.d_name, dp->dir_cur_addr + 16, ROMFS_MAX_NAME_LEN);
         dp->cur_dirent.d_name[ROMFS_MAX_NAME_LEN] = '\0';
         ROMFS_DUBUG("name = %s\r\n", dp->cur_dirent.d_name);
@@ -611,6 +739,9 @@ static aos_dirent_t *romfs_readdir([[gnu::unused]] file_t *fp, aos_dir_t *dir)
              ((dp->cur_dirent.d_name[0] == '.') && (dp->cur_dirent.d_name[1] == '\0')) ) {
             ROMFS_DUBUG("......name = %s\r\n", dp->cur_dirent.d_name);
             continue;
+        } else if ((NULL != romfs_idx.root) && (hdr == romfs_idx.hdr)) {
+            /* the index is not a file of the image */
+            continue;
         } else {
             break;
         }
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include <bl_romfs_image.h>
+
+#define ROMFH_TYPE_MASK         0x00000007
+#define ROMFH_TYPE_REG          2
+
+#define IDX_HDR_WORDS           4
+#define IDX_ENTRY_WORDS         4
+
+static uint32_t word_at(const void *addr, int i)
+{
+    return U32NTOHL(((const uint32_t *)addr)[i]);
+}
+
+uint32_t romfs_idx_hash(const char *path, int len)
+{
+    uint32_t hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)path[i]) * 16777619u;
+    }
+    return hash;
+}
+
+int romfs_idx_attach(romfs_idx_t *idx, const char *root)
+{
+    const char *hdr, *data, *end;
+    uint32_t next, size, count;
+
+    memset(idx, 0, sizeof(*idx));
+    end = root + word_at(root, 2);
+
+    /* genromfs -i appends the index to the root directory, this walk is only
+     * done once at mount */
+    hdr = root + ALIGNUP16(strlen(root + 16) + 1) + 16;
+    while (hdr < end) {
+        next = word_at(hdr, 0);
+        if (ROMFH_TYPE_REG == (next & ROMFH_TYPE_MASK) && 0 == strcmp(hdr + 16, ROMFS_IDX_NAME)) {
+            break;
+        }
+        if (0 == (next & ~15)) {
+            return -1;
+        }
+        hdr = root + (next & ~15);
+    }
+    if (hdr >= end) {
+        return -1;
+    }
+
+    data = hdr + ALIGNUP16(strlen(hdr + 16) + 1) + 16;
+    size = word_at(hdr, 2);
+    if (size < IDX_HDR_WORDS * 4 || word_at(data, 0) != ROMFS_IDX_MAGIC ||
+            word_at(data, 1) != ROMFS_IDX_VERSION) {
+        return -1;
+    }
+    count = word_at(data, 2);
+    if (count > (size - IDX_HDR_WORDS * 4) / (IDX_ENTRY_WORDS * 4)) {
+        return -1;
+    }
+
+    idx->root = root;
+    idx->entries = (const uint32_t *)data + IDX_HDR_WORDS;
+    idx->count = count;
+    idx->flags = word_at(data, 3);
+    idx->hdr = hdr;
+    return 0;
+}
+
+static int idx_cmp(const romfs_idx_t *idx, uint32_t i, uint32_t hash, const char *path, int len)
+{
+    const uint32_t *e = idx->entries + i * IDX_ENTRY_WORDS;
+    const char *name;
+    int res;
+
+    if (word_at(e, 0) != hash) {
+        return word_at(e, 0) < hash ? -1 : 1;
+    }
+    name = (const char *)(idx->entries - IDX_HDR_WORDS) + word_at(e, 2);
+    res = strncmp(name, path, len);
+    if (res) {
+        return res;
+    }
+    return name[len] ? 1 : 0;
+}
+
+int romfs_idx_find(const romfs_idx_t *idx, const char *path, int len, char **hdr, uint32_t *flags)
+{
+    uint32_t hash = romfs_idx_hash(path, len);
+    uint32_t lo = 0, hi = idx->count, mid;
+    const uint32_t *e;
+    int res;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        res = idx_cmp(idx, mid, hash, path, len);
+        if (0 == res) {
+            e = idx->entries + mid * IDX_ENTRY_WORDS;
+            *hdr = (char *)idx->root + word_at(e, 1);
+            *flags = word_at(e, 3);
+            return 0;
+        }
+        if (res < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include <bl_romfs_image.h>
+
+#define ZHDR_WORDS              4
+
+static uint32_t word_at(const void *addr, int i)
+{
+    return U32NTOHL(((const uint32_t *)addr)[i]);
+}
+
+static int lz4_length(const uint8_t **ip, const uint8_t *iend, int len)
+{
+    uint8_t b;
+
+    if (len != 15) {
+        return len;
+    }
+    do {
+        if (*ip >= iend) {
+            return -1;
+        }
+        b = *(*ip)++;
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+int romfs_lz4_decode(const uint8_t *src, int srclen, uint8_t *dst, int dstlen)
+{
+    const uint8_t *ip = src, *iend = src + srclen;
+    uint8_t *op = dst, *oend = dst + dstlen;
+    const uint8_t *match;
+    int token, len, off;
+
+    while (ip < iend) {
+        token = *ip++;
+
+        len = lz4_length(&ip, iend, token >> 4);
+        if (len < 0 || len > iend - ip || len > oend - op) {
+            return -1;
+        }
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+        if (ip == iend) {
+            /* the last sequence has no match */
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        off = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (0 == off || off > op - dst) {
+            return -1;
+        }
+        len = lz4_length(&ip, iend, token & 15);
+        if (len < 0 || len + 4 > oend - op) {
+            return -1;
+        }
+        len += 4;
+        match = op - off;
+        if (off >= len) {
+            memcpy(op, match, len);
+            op += len;
+        } else {
+            /* overlapping copy repeats the last off bytes */
+            while (len--) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op - dst;
+}
+
+void romfs_zcache_init(romfs_zcache_t *cache, uint8_t *mem)
+{
+    int i;
+
+    memset(cache, 0, sizeof(*cache));
+    for (i = 0; i < ROMFS_ZCACHE_SLOTS; i++) {
+        cache->slot[i].buf = mem + i * ROMFS_ZBLK_SIZE;
+    }
+}
+
+int romfs_zfile_size(const char *payload, uint32_t stored, uint32_t *size)
+{
+    uint32_t blocks, table, last;
+
+    if (stored < ZHDR_WORDS * 4 || word_at(payload, 0) != ROMFS_ZBLK_MAGIC ||
+            word_at(payload, 3) != ROMFS_ZBLK_SHIFT) {
+        return -1;
+    }
+    *size = word_at(payload, 1);
+    blocks = word_at(payload, 2);
+    if (blocks != (*size + ROMFS_ZBLK_SIZE - 1) >> ROMFS_ZBLK_SHIFT ||
+            blocks > (stored - ZHDR_WORDS * 4) / 4) {
+        return -1;
+    }
+    table = ZHDR_WORDS * 4 + blocks * 4;
+    last = blocks ? word_at(payload, ZHDR_WORDS + blocks - 1) & ~ROMFS_ZBLK_RAW : 0;
+    if (last > stored - table) {
+        return -1;
+    }
+    return 0;
+}
+
+/* locate block b of a stream checked by romfs_zfile_size */
+static const uint8_t *zblock_src(const char *payload, uint32_t stored, uint32_t b,
+        uint32_t *srclen, int *raw)
+{
+    uint32_t blocks = word_at(payload, 2);
+    uint32_t table = (ZHDR_WORDS + blocks) * 4;
+    uint32_t start, end;
+
+    start = b ? word_at(payload, ZHDR_WORDS + b - 1) & ~ROMFS_ZBLK_RAW : 0;
+    end = word_at(payload, ZHDR_WORDS + b);
+    *raw = !!(end & ROMFS_ZBLK_RAW);
+    end &= ~ROMFS_ZBLK_RAW;
+    if (end < start || end > stored - table) {
+        return NULL;
+    }
+    *srclen = end - start;
+    return (const uint8_t *)payload + table + start;
+}
+
+static romfs_zslot_t *zcache_get(romfs_zcache_t *cache, const char *payload, uint32_t b,
+        const uint8_t *src, uint32_t srclen, uint32_t blen)
+{
+    romfs_zslot_t *slot, *victim = &cache->slot[0];
+    int i;
+
+    for (i = 0; i < ROMFS_ZCACHE_SLOTS; i++) {
+        slot = &cache->slot[i];
+        if (slot->payload == payload && slot->block == b) {
+            slot->stamp = ++cache->clock;
+            cache->hits++;
+            return slot;
+        }
+        if (NULL == slot->payload || (victim->payload && slot->stamp < victim->stamp)) {
+            victim = slot;
+        }
+    }
+
+    cache->misses++;
+    victim->payload = NULL;
+    if (romfs_lz4_decode(src, srclen, victim->buf, blen) != (int)blen) {
+        return NULL;
+    }
+    victim->payload = payload;
+    victim->block = b;
+    victim->stamp = ++cache->clock;
+    return victim;
+}
+
+int romfs_zfile_read(romfs_zcache_t *cache, const char *payload, uint32_t stored,
+        uint32_t off, char *buf, uint32_t len)
+{
+    uint32_t size, b, boff, blen, srclen, n, done = 0;
+    const uint8_t *src;
+    romfs_zslot_t *slot;
+    int raw;
+
+    if (romfs_zfile_size(payload, stored, &size)) {
+        return -1;
+    }
+    if (off >= size) {
+        return 0;
+    }
+    if (len > size - off) {
+        len = size - off;
+    }
+
+    while (done < len) {
+        b = off >> ROMFS_ZBLK_SHIFT;
+        boff = off & (ROMFS_ZBLK_SIZE - 1);
+        blen = size - (b << ROMFS_ZBLK_SHIFT);
+        if (blen > ROMFS_ZBLK_SIZE) {
+            blen = ROMFS_ZBLK_SIZE;
+        }
+        n = blen - boff;
+        if (n > len - done) {
+            n = len - done;
+        }
+
+        src = zblock_src(payload, stored, b, &srclen, &raw);
+        if (NULL == src) {
+            return -1;
+        }
+        if (raw) {
+            /* stored blocks are read in place like a plain file */
+            if (srclen != blen) {
+                return -1;
+            }
+            memcpy(buf + done, src + boff, n);
+        } else if (0 == boff && n == blen) {
+            /* a whole block goes straight to the caller */
+            if (romfs_lz4_decode(src, srclen, (uint8_t *)buf + done, blen) != (int)blen) {
+                return -1;
+            }
+        } else {
+            slot = zcache_get(cache, payload, b, src, srclen, blen);
+            if (NULL == slot) {
+                return -1;
+            }
+            memcpy(buf + done, slot->buf + boff, n);
+        }
+        off += n;
+        done += n;
+    }
+
+    return done;
+}
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Host test of the romfs index and of the compressed files. It generates a
+ * tree, builds plain, indexed and compressed images with genromfs, mounts
+ * each image from its file and checks every lookup and read against the
+ * tree. From this directory:
+ *
+ *   make -C ../../genromfs
+ *   gcc -I../../include test_romfs_image.c ../bl_romfs_index.c ../bl_romfs_lz4.c \
+ *       -o test_romfs_image
+ *   ./test_romfs_image ../../genromfs/genromfs
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <bl_romfs_image.h>
+
+#define PROMPTS         300
+
+typedef struct {
+    char path[64];
+    uint8_t *data;
+    uint32_t size;
+} tfile_t;
+
+static tfile_t files[PROMPTS + 16];
+static int nfiles;
+static const char *dirs[] = {"www", "www/css", "www/js", "prompts", "prompts/en"};
+static char tree[64];
+static int failures;
+static uint32_t seed = 12345;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\r\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static tfile_t *add_file(const char *path, uint32_t size)
+{
+    tfile_t *t = &files[nfiles++];
+
+    snprintf(t->path, sizeof(t->path), "%s", path);
+    t->size = size;
+    t->data = malloc(size + 1);
+    return t;
+}
+
+static void write_file(tfile_t *t)
+{
+    char real[256];
+    FILE *f;
+
+    snprintf(real, sizeof(real), "%s/%s", tree, t->path);
+    f = fopen(real, "wb");
+    if (NULL == f || fwrite(t->data, 1, t->size, f) != t->size) {
+        printf("cannot create %s\r\n", real);
+        exit(1);
+    }
+    fclose(f);
+}
+
+static void make_tree(void)
+{
+    static const char *words[] = {"<div class=\"row\">", "romfs ", "</div>\n", "0123", "bouffalo "};
+    char path[256];
+    tfile_t *t;
+    uint32_t i, j;
+
+    strcpy(tree, "/tmp/romfs_testXXXXXX");
+    if (NULL == mkdtemp(tree)) {
+        exit(1);
+    }
+    for (i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", tree, dirs[i]);
+        mkdir(path, 0755);
+    }
+
+    /* text, compresses well */
+    t = add_file("www/index.html", 20000);
+    for (i = 0; i < t->size; ) {
+        const char *w = words[rnd() % 5];
+        for (j = 0; w[j] && i < t->size; j++) {
+            t->data[i++] = w[j];
+        }
+    }
+    write_file(t);
+
+    /* random, must stay plain */
+    t = add_file("www/big.bin", 10000);
+    for (i = 0; i < t->size; i++) {
+        t->data[i] = rnd();
+    }
+    write_file(t);
+
+    /* compressible blocks around a raw one, last block is short */
+    t = add_file("www/css/mixed.css", 4 * ROMFS_ZBLK_SIZE + 1000);
+    for (i = 0; i < t->size; i++) {
+        t->data[i] = (i >> ROMFS_ZBLK_SHIFT) == 2 ? (uint8_t)rnd() : (uint8_t)"abcdefgh"[(i / 3) % 8];
+    }
+    write_file(t);
+
+    /* runs decode as overlapping matches */
+    t = add_file("www/js/app.js", 2 * ROMFS_ZBLK_SIZE);
+    for (i = 0; i < t->size; i++) {
+        t->data[i] = i < 5000 ? 'a' : "xy"[i & 1];
+    }
+    write_file(t);
+
+    t = add_file("empty.txt", 0);
+    write_file(t);
+
+    for (i = 0; i < PROMPTS; i++) {
+        snprintf(path, sizeof(path), "prompts/en/p%03u.pcm", i);
+        t = add_file(path, 32 + rnd() % 3000);
+        for (j = 0; j < t->size; j++) {
+            t->data[j] = (j % 64) < 32 ? i : rnd();
+        }
+        write_file(t);
+    }
+}
+
+static char *load_image(const char *file)
+{
+    FILE *f = fopen(file, "rb");
+    long size;
+    char *img;
+
+    if (NULL == f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    img = aligned_alloc(16, (size + 15) & ~15);
+    if (img && fread(img, 1, size, f) != (size_t)size) {
+        free(img);
+        img = NULL;
+    }
+    fclose(f);
+    return img;
+}
+
+static char *build(const char *genromfs, const char *opts, const char *name)
+{
+    char cmd[512], img[128];
+
+    snprintf(img, sizeof(img), "%s.%s.img", tree, name);
+    snprintf(cmd, sizeof(cmd), "%s %s -f %s -d %s -V test", genromfs, opts, img, tree);
+    if (system(cmd)) {
+        printf("'%s' failed\r\n", cmd);
+        exit(1);
+    }
+    return load_image(img);
+}
+
+static uint32_t be32(const char *p, int i)
+{
+    return U32NTOHL(((const uint32_t *)p)[i]);
+}
+
+static char *payload(char *hdr)
+{
+    return hdr + ALIGNUP16(strlen(hdr + 16) + 1) + 16;
+}
+
+/* reference lookup, the directory walk a plain reader does */
+static char *walk(char *root, const char *path)
+{
+    char *hdr = root + ALIGNUP16(strlen(root + 16) + 1) + 16;
+    const char *end;
+    int len;
+
+    while (1) {
+        end = strchr(path, '/');
+        len = end ? (int)(end - path) : (int)strlen(path);
+        while (strncmp(hdr + 16, path, len) || hdr[16 + len]) {
+            if (0 == (be32(hdr, 0) & ~15)) {
+                return NULL;
+            }
+            hdr = root + (be32(hdr, 0) & ~15);
+        }
+        if (NULL == end) {
+            return hdr;
+        }
+        path = end + 1;
+        hdr = root + (be32(hdr, 1) & ~15);
+    }
+}
+
+static void check_image(const char *name, char *root, int indexed, int compressed)
+{
+    static uint8_t mem[ROMFS_ZCACHE_SLOTS * ROMFS_ZBLK_SIZE];
+    static char buf[5 * ROMFS_ZBLK_SIZE];
+    static const char *missing[] = {"www/index.htm", "www/index.html/x", "prompts/en/p300.pcm", "ww", ROMFS_IDX_NAME};
+    romfs_idx_t idx;
+    romfs_zcache_t cache;
+    tfile_t *t;
+    char *hdr, *ihdr;
+    uint32_t flags, size, stored, off, len, expect;
+    int i, j, n, lz4_files = 0;
+
+    printf("%s image\r\n", name);
+    CHECK(0 == memcmp(root, "-rom1fs-", 8), "%s: magic", name);
+    CHECK((0 == romfs_idx_attach(&idx, root)) == indexed, "%s: index attach", name);
+    romfs_zcache_init(&cache, mem);
+
+    for (i = 0; i < nfiles; i++) {
+        t = &files[i];
+        /* every image stays readable by a plain directory walk */
+        hdr = walk(root, t->path);
+        CHECK(hdr, "%s: walk %s", name, t->path);
+        if (NULL == hdr) {
+            continue;
+        }
+        stored = be32(hdr, 2);
+        flags = 0;
+        if (indexed) {
+            ihdr = NULL;
+            CHECK(0 == romfs_idx_find(&idx, t->path, strlen(t->path), &ihdr, &flags) && ihdr == hdr,
+                    "%s: index %s", name, t->path);
+        }
+        if (0 == (flags & ROMFS_IDX_F_LZ4)) {
+            CHECK(stored == t->size && 0 == memcmp(payload(hdr), t->data, t->size),
+                    "%s: plain data %s", name, t->path);
+            continue;
+        }
+
+        lz4_files++;
+        CHECK(0 == romfs_zfile_size(payload(hdr), stored, &size) && size == t->size && stored < t->size,
+                "%s: size %s %u/%u", name, t->path, stored, t->size);
+        n = romfs_zfile_read(&cache, payload(hdr), stored, 0, buf, sizeof(buf));
+        CHECK(n == (int)t->size && 0 == memcmp(buf, t->data, t->size), "%s: read %s", name, t->path);
+        for (j = 0; j < 200; j++) {
+            off = rnd() % (t->size + 1);
+            len = rnd() % (2 * ROMFS_ZBLK_SIZE);
+            expect = len < t->size - off ? len : t->size - off;
+            n = romfs_zfile_read(&cache, payload(hdr), stored, off, buf, len);
+            CHECK(n == (int)expect && 0 == memcmp(buf, t->data + off, expect),
+                    "%s: read %s at %u+%u", name, t->path, off, len);
+        }
+    }
+
+    if (indexed) {
+        CHECK(idx.count == nfiles + sizeof(dirs) / sizeof(dirs[0]), "%s: %u entries", name, idx.count);
+        for (i = 0; i < (int)(sizeof(dirs) / sizeof(dirs[0])); i++) {
+            hdr = walk(root, dirs[i]);
+            CHECK(hdr && 0 == romfs_idx_find(&idx, dirs[i], strlen(dirs[i]), &ihdr, &flags) &&
+                    ihdr == hdr && (be32(hdr, 0) & 7) == 1, "%s: index dir %s", name, dirs[i]);
+        }
+        for (i = 0; i < (int)(sizeof(missing) / sizeof(missing[0])); i++) {
+            CHECK(0 != romfs_idx_find(&idx, missing[i], strlen(missing[i]), &ihdr, &flags),
+                    "%s: found %s", name, missing[i]);
+        }
+        /* lookups take the length, "www/js" out of "www/js/app.js" */
+        CHECK(0 == romfs_idx_find(&idx, "www/js/app.js", 6, &ihdr, &flags) && ihdr == walk(root, "www/js"),
+                "%s: partial path", name);
+        CHECK(!!(idx.flags & ROMFS_IDX_F_LZ4) == compressed, "%s: index flags", name);
+    }
+    CHECK(compressed ? lz4_files > 0 : lz4_files == 0, "%s: %d compressed files", name, lz4_files);
+    if (!compressed) {
+        return;
+    }
+
+    /* random data stays plain, text shrinks */
+    CHECK(0 == romfs_idx_find(&idx, "www/big.bin", 11, &ihdr, &flags) && 0 == flags, "%s: big.bin", name);
+    CHECK(0 == romfs_idx_find(&idx, "www/index.html", 14, &ihdr, &flags) && flags == ROMFS_IDX_F_LZ4,
+            "%s: index.html", name);
+    printf("     index.html %u -> %u bytes\r\n", files[0].size, be32(ihdr, 2));
+
+    /* small sequential reads decode each block once */
+    romfs_zcache_init(&cache, mem);
+    romfs_idx_find(&idx, "www/js/app.js", 13, &hdr, &flags);
+    for (off = 0; off < 2 * ROMFS_ZBLK_SIZE; off += 100) {
+        n = romfs_zfile_read(&cache, payload(hdr), be32(hdr, 2), off, buf, 100);
+        CHECK(n > 0 && 0 == memcmp(buf, files[3].data + off, n), "%s: app.js at %u", name, off);
+    }
+    CHECK(cache.misses == 2, "%s: %u misses %u hits", name, cache.misses, cache.hits);
+
+    /* broken streams are refused, not read past */
+    stored = be32(hdr, 2);
+    len = be32(payload(hdr), 4) & ~ROMFS_ZBLK_RAW;
+    CHECK(romfs_lz4_decode((uint8_t *)payload(hdr) + 24, len - 1, (uint8_t *)buf, ROMFS_ZBLK_SIZE) != ROMFS_ZBLK_SIZE,
+            "%s: truncated block", name);
+    CHECK(romfs_lz4_decode((uint8_t *)payload(hdr) + 24, len, (uint8_t *)buf, ROMFS_ZBLK_SIZE - 1) < 0,
+            "%s: short output", name);
+    CHECK(0 != romfs_zfile_size(payload(hdr), 12, &size), "%s: short stream", name);
+    CHECK(0 != romfs_zfile_size(payload(hdr) + 4, stored - 4, &size), "%s: bad magic", name);
+}
+
+static void fuzz_lz4(void)
+{
+    static uint8_t src[256], dst[ROMFS_ZBLK_SIZE];
+    int i, j, n;
+
+    for (i = 0; i < 100000; i++) {
+        for (j = 0; j < (int)sizeof(src); j++) {
+            src[j] = rnd();
+        }
+        n = romfs_lz4_decode(src, 1 + rnd() % sizeof(src), dst, 1 + rnd() % sizeof(dst));
+        CHECK(n <= (int)sizeof(dst), "fuzz %d", n);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    char *img;
+    char cmd[256];
+
+    if (argc < 2) {
+        printf("usage: %s <genromfs>\r\n", argv[0]);
+        return 1;
+    }
+    make_tree();
+
+    img = build(argv[1], "", "plain");
+    check_image("plain", img, 0, 0);
+    free(img);
+
+    img = build(argv[1], "-i", "index");
+    check_image("indexed", img, 1, 0);
+    free(img);
+
+    img = build(argv[1], "-z '*'", "lz4");
+    check_image("compressed", img, 1, 1);
+    free(img);
+
+    fuzz_lz4();
+
+    snprintf(cmd, sizeof(cmd), "rm -rf %s %s.*.img", tree, tree);
+    if (system(cmd)) {
+        printf("cleanup failed\r\n");
+    }
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Host test of the romfs VFS glue. Plain, indexed and compressed images of
+ * a small tree are built with genromfs and mapped below 4 GiB, as the XIP
+ * window is on the chip. romfs_register() mounts each one and the files go
+ * through a minimal aos VFS to the registered open/read/lseek/stat/ioctl
+ * and directory entry points. From this directory:
+ *
+ *   make -C ../../genromfs
+ *   gcc -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast -I. -I../../include \
+ *       -I../../../vfs/include -I../../../../sys/blmtd/include \
+ *       -I../../../../stage/yloop/include test_romfs_vfs.c ../bl_romfs_index.c \
+ *       ../bl_romfs_lz4.c -o test_romfs_vfs
+ *   ./test_romfs_vfs ../../genromfs/genromfs
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "../bl_romfs.c"
+
+#define FDS             4
+
+typedef struct {
+    const char *path;
+    uint8_t *data;
+    uint32_t size;
+    int lz4;                    /* stored compressed by genromfs -z */
+} tfile_t;
+
+static tfile_t files[] = {
+    {"/romfs/www/index.html", NULL, 20000, 1},
+    {"/romfs/www/big.bin", NULL, 10000, 0},
+    {"/romfs/www/css/site.css", NULL, 3 * ROMFS_ZBLK_SIZE + 100, 1},
+    {"/romfs/empty.txt", NULL, 0, 0},
+};
+
+static char tree[64];
+static char *xip;
+static fs_ops_t *romfs_fops;
+static file_t fds[FDS];
+static int fd_used[FDS];
+static int mutex_depth;
+static int failures;
+static uint32_t seed = 12345;
+
+#define NFILES          ((int)(sizeof(files) / sizeof(files[0])))
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\r\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+/* what bl_romfs.c needs from the rest of the SDK */
+void *aos_malloc(unsigned int size)
+{
+    return malloc(size);
+}
+
+void aos_free(void *mem)
+{
+    free(mem);
+}
+
+int aos_mutex_new(aos_mutex_t *mutex)
+{
+    (void)mutex;
+    return 0;
+}
+
+int aos_mutex_lock(aos_mutex_t *mutex, unsigned int timeout)
+{
+    (void)mutex;
+    (void)timeout;
+    mutex_depth++;
+    return 0;
+}
+
+int aos_mutex_unlock(aos_mutex_t *mutex)
+{
+    (void)mutex;
+    mutex_depth--;
+    return 0;
+}
+
+int bl_mtd_open(const char *name, bl_mtd_handle_t *handle, unsigned int flags)
+{
+    CHECK(0 == strcmp(name, BL_MTD_PARTITION_NAME_ROMFS) && (flags & BL_MTD_OPEN_FLAG_BUSADDR),
+          "partition %s flags %u", name, flags);
+    *handle = &xip;
+    return 0;
+}
+
+int bl_mtd_info(bl_mtd_handle_t handle, bl_mtd_info_t *info)
+{
+    (void)handle;
+    info->xip_addr = xip;
+    return 0;
+}
+
+int aos_register_fs(const char *path, fs_ops_t *fops, void *arg)
+{
+    (void)arg;
+    CHECK(0 == strcmp(path, ROMFS_MOUNTPOINT), "mount point %s", path);
+    romfs_fops = fops;
+    return 0;
+}
+
+/* The VFS front end, only the one file system is mounted */
+static file_t *fd_file(int fd)
+{
+    return (fd >= 0 && fd < FDS && fd_used[fd]) ? &fds[fd] : NULL;
+}
+
+int aos_open(const char *path, int flags)
+{
+    int fd;
+
+    for (fd = 0; fd < FDS && fd_used[fd]; fd++) {
+    }
+    if (FDS == fd) {
+        return -1;
+    }
+    memset(&fds[fd], 0, sizeof(fds[fd]));
+    if (0 != romfs_fops->open(&fds[fd], path, flags)) {
+        return -1;
+    }
+    fd_used[fd] = 1;
+    return fd;
+}
+
+int aos_close(int fd)
+{
+    file_t *fp = fd_file(fd);
+
+    if (NULL == fp) {
+        return -1;
+    }
+    romfs_fops->close(fp);
+    fd_used[fd] = 0;
+    return 0;
+}
+
+ssize_t aos_read(int fd, void *buf, size_t nbytes)
+{
+    file_t *fp = fd_file(fd);
+
+    return fp ? romfs_fops->read(fp, buf, nbytes) : -1;
+}
+
+off_t aos_lseek(int fd, off_t offset, int whence)
+{
+    file_t *fp = fd_file(fd);
+
+    return fp ? romfs_fops->lseek(fp, offset, whence) : -1;
+}
+
+int aos_ioctl(int fd, int cmd, unsigned long arg)
+{
+    file_t *fp = fd_file(fd);
+
+    return fp ? romfs_fops->ioctl(fp, cmd, arg) : -1;
+}
+
+int aos_stat(const char *path, struct stat *st)
+{
+    return romfs_fops->stat(NULL, path, st);
+}
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void make_tree(void)
+{
+    static const char *words[] = {"<div class=\"row\">", "romfs ", "</div>\n", "0123", "bouffalo "};
+    char real[256];
+    tfile_t *t;
+    uint32_t i, j;
+    FILE *f;
+
+    strcpy(tree, "/tmp/romfs_vfsXXXXXX");
+    if (NULL == mkdtemp(tree)) {
+        exit(1);
+    }
+    snprintf(real, sizeof(real), "%s/www", tree);
+    mkdir(real, 0755);
+    snprintf(real, sizeof(real), "%s/www/css", tree);
+    mkdir(real, 0755);
+
+    for (t = files; t < files + NFILES; t++) {
+        t->data = malloc(t->size + 1);
+        for (i = 0; i < t->size; ) {
+            if (t->lz4) {
+                const char *w = words[rnd() % 5];
+
+                for (j = 0; w[j] && i < t->size; j++) {
+                    t->data[i++] = w[j];
+                }
+            } else {
+                t->data[i++] = rnd();
+            }
+        }
+
+        snprintf(real, sizeof(real), "%s/%s", tree, t->path + strlen(ROMFS_MOUNTPOINT "/"));
+        f = fopen(real, "wb");
+        if (NULL == f || fwrite(t->data, 1, t->size, f) != t->size) {
+            printf("cannot create %s\r\n", real);
+            exit(1);
+        }
+        fclose(f);
+    }
+}
+
+/* genromfs into a file, then into a mapping the uint32_t casts of
+ * bl_romfs.c keep intact */
+static size_t build(const char *genromfs, const char *opts)
+{
+    char cmd[512], img[128];
+    size_t size;
+    long len;
+    FILE *f;
+
+    snprintf(img, sizeof(img), "%s.img", tree);
+    snprintf(cmd, sizeof(cmd), "%s %s -f %s -d %s -V test", genromfs, opts, img, tree);
+    if (system(cmd) || NULL == (f = fopen(img, "rb"))) {
+        printf("'%s' failed\r\n", cmd);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    size = (len + 4095) & ~4095;
+    xip = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (MAP_FAILED == xip || fread(xip, 1, len, f) != (size_t)len) {
+        printf("cannot map %s\r\n", img);
+        exit(1);
+    }
+    fclose(f);
+    remove(img);
+    return size;
+}
+
+static void check_stat(const char *name)
+{
+    struct stat st;
+    int i;
+
+    for (i = 0; i < NFILES; i++) {
+        memset(&st, 0, sizeof(st));
+        CHECK(0 == aos_stat(files[i].path, &st) && S_ISREG(st.st_mode) &&
+              st.st_size == (off_t)files[i].size,
+              "%s: stat %s size %ld", name, files[i].path, (long)st.st_size);
+    }
+
+    memset(&st, 0, sizeof(st));
+    CHECK(0 == aos_stat("/romfs/www/css", &st) && S_ISDIR(st.st_mode),
+          "%s: stat of a directory", name);
+    CHECK(0 == aos_stat("/romfs", &st) && 0 == st.st_size, "%s: stat of the root", name);
+    CHECK(0 != aos_stat("/romfs/www/none.html", &st), "%s: stat of a missing file", name);
+    CHECK(0 != aos_stat("/flash/www/index.html", &st), "%s: stat outside the mount", name);
+}
+
+static void check_read(const char *name, const tfile_t *t)
+{
+    static char buf[ROMFS_ZBLK_SIZE * 4];
+    uint32_t off;
+    int fd, n;
+
+    fd = aos_open(t->path, 0);
+    CHECK(fd >= 0, "%s: open %s", name, t->path);
+    if (fd < 0) {
+        return;
+    }
+
+    /* random chunks, so that reads straddle the compressed blocks and
+     * end anywhere near the end of the file */
+    for (off = 0; off <= t->size; off += n) {
+        n = aos_read(fd, buf, 1 + rnd() % 700);
+        if (n <= 0) {
+            break;
+        }
+        CHECK(off + n <= t->size && 0 == memcmp(buf, t->data + off, n),
+              "%s: %s read at %u", name, t->path, off);
+    }
+    CHECK(0 == n && off == t->size, "%s: %s read %u of %u, last %d",
+          name, t->path, off, t->size, n);
+    CHECK(0 == aos_read(fd, buf, sizeof(buf)), "%s: %s read past the end", name, t->path);
+
+    if (t->size >= 100) {
+        CHECK(aos_lseek(fd, t->size / 2, SEEK_SET) == (off_t)(t->size / 2) &&
+              50 == aos_read(fd, buf, 50) && 0 == memcmp(buf, t->data + t->size / 2, 50),
+              "%s: %s SEEK_SET", name, t->path);
+        CHECK(aos_lseek(fd, -60, SEEK_CUR) == (off_t)(t->size / 2 - 10) &&
+              20 == aos_read(fd, buf, 20) && 0 == memcmp(buf, t->data + t->size / 2 - 10, 20),
+              "%s: %s SEEK_CUR", name, t->path);
+        CHECK(aos_lseek(fd, -10, SEEK_END) == (off_t)(t->size - 10) &&
+              10 == aos_read(fd, buf, sizeof(buf)) && 0 == memcmp(buf, t->data + t->size - 10, 10),
+              "%s: %s SEEK_END", name, t->path);
+    }
+
+    /* bad seeks leave the offset alone */
+    aos_lseek(fd, 0, SEEK_SET);
+    CHECK(aos_lseek(fd, t->size + 1, SEEK_SET) < 0, "%s: %s seek past the end", name, t->path);
+    CHECK(aos_lseek(fd, -1, SEEK_SET) < 0, "%s: %s negative seek", name, t->path);
+    CHECK(aos_lseek(fd, 1, SEEK_END) < 0, "%s: %s seek after the end", name, t->path);
+    CHECK(aos_lseek(fd, 0, 7) < 0, "%s: %s bad whence", name, t->path);
+    CHECK(aos_lseek(fd, 0, SEEK_CUR) == 0, "%s: %s offset moved", name, t->path);
+
+    aos_close(fd);
+    CHECK(0 == mutex_depth, "%s: block cache lock held", name);
+}
+
+static void check_filebuf(const char *name, const tfile_t *t, int lz4)
+{
+    romfs_filebuf_t fb;
+    int fd, ret;
+
+    fd = aos_open(t->path, 0);
+    ret = aos_ioctl(fd, IOCTL_ROMFS_GET_FILEBUF, (unsigned long)&fb);
+    if (lz4) {
+        CHECK(ret < 0, "%s: XIP buffer of compressed %s", name, t->path);
+    } else {
+        CHECK(0 == ret && fb.bufsize == t->size && 0 == memcmp(fb.buf, t->data, t->size),
+              "%s: XIP buffer of %s", name, t->path);
+    }
+    aos_close(fd);
+}
+
+static void check_dir(const char *name)
+{
+    aos_dir_t *dir;
+    aos_dirent_t *de;
+    int seen = 0;
+
+    dir = romfs_fops->opendir(NULL, "/romfs/www");
+    CHECK(NULL != dir, "%s: opendir", name);
+    if (NULL == dir) {
+        return;
+    }
+    while (NULL != (de = romfs_fops->readdir(NULL, dir))) {
+        if (0 == strcmp(de->d_name, "index.html")) {
+            seen |= 1;
+        } else if (0 == strcmp(de->d_name, "big.bin")) {
+            seen |= 2;
+        } else if (0 == strcmp(de->d_name, "css")) {
+            seen |= 4;
+        } else {
+            CHECK(0, "%s: readdir gave %s", name, de->d_name);
+        }
+    }
+    CHECK(7 == seen, "%s: readdir saw 0x%x", name, seen);
+    romfs_fops->closedir(NULL, dir);
+}
+
+static void check_image(const char *genromfs, const char *name, const char *opts, int lz4)
+{
+    size_t size = build(genromfs, opts);
+    int i, fd;
+
+    CHECK(0 == romfs_register(), "%s: register", name);
+
+    check_stat(name);
+    for (i = 0; i < NFILES; i++) {
+        check_read(name, &files[i]);
+        check_filebuf(name, &files[i], lz4 && files[i].lz4);
+    }
+    check_dir(name);
+
+    CHECK(aos_open("/romfs/www/none.html", 0) < 0, "%s: open of a missing file", name);
+    CHECK(aos_open("/romfs//www/index.html", 0) < 0, "%s: open of a bad path", name);
+
+    /* every open file has its own offset */
+    fd = aos_open(files[0].path, 0);
+    i = aos_open(files[0].path, 0);
+    aos_lseek(fd, 100, SEEK_SET);
+    CHECK(0 == aos_lseek(i, 0, SEEK_CUR), "%s: offsets shared", name);
+    aos_close(fd);
+    aos_close(i);
+
+    munmap(xip, size);
+}
+
+int main(int argc, char *argv[])
+{
+    char cmd[256];
+
+    if (argc < 2) {
+        printf("usage: %s <genromfs>\r\n", argv[0]);
+        return 1;
+    }
+    make_tree();
+
+    check_image(argv[1], "plain", "", 0);
+    check_image(argv[1], "indexed", "-i", 0);
+    check_image(argv[1], "compressed", "-z '*'", 1);
+
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", tree);
+    if (system(cmd)) {
+        printf("cleanup failed\r\n");
+    }
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -15,10 +15,12 @@ COMPONENT_SRCS := bl602_hal/bl_uart.c \
                   bl602_hal/bl_dma.c \
                   bl602_hal/bl_irq.c \
                   bl602_hal/bl_sec.c \
+                  bl602_hal/bl_sec_drbg.c \
                   bl602_hal/bl_boot2.c \
                   bl602_hal/bl_timer.c \
                   bl602_hal/bl_timer_asm.S \
                   bl602_hal/bl_gpio.c \
+                  bl602_hal/bl_gpio_demux.c \
                   bl602_hal/bl_gpio_cli.c \
                   bl602_hal/bl_hbn.c \
                   bl602_hal/bl_efuse.c \
@@ -26,9 +28,14 @@ COMPONENT_SRCS := bl602_hal/bl_uart.c \
                   bl602_hal/bl_pwm.c \
                   bl602_hal/bl_sec_aes.c \
                   bl602_hal/bl_sec_sha.c \
+                  bl602_hal/bl_sec_sha_stream.c \
                   bl602_hal/bl_wifi.c \
                   bl602_hal/bl_wdt.c \
                   bl602_hal/bl_wdt_cli.c \
+                  bl602_hal/bl_coredump.c \
+                  bl602_hal/bl_coredump_record.c \
+                  bl602_hal/bl_cpu_prof.c \
+                  bl602_hal/bl_cpu_prof_stat.c \
                   bl602_hal/hal_uart.c \
                   bl602_hal/hal_gpio.c \
                   bl602_hal/hal_hbn.c \
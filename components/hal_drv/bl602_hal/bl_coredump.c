@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <cli.h>
+#include <bl602_timer.h>
+
+#include "bl_coredump.h"
+#include "bl_flash.h"
+#include "hal_boot2.h"
+
+#ifdef CFG_COREDUMP
+
+#ifndef BL_COREDUMP_STACK_BYTES
+#define BL_COREDUMP_STACK_BYTES     768     /* of the faulting stack, from sp up */
+#endif
+#ifndef BL_COREDUMP_TASK_BYTES
+#define BL_COREDUMP_TASK_BYTES      64      /* of every other stack, above its saved context */
+#endif
+#ifndef BL_COREDUMP_TASKS_MAX
+#define BL_COREDUMP_TASKS_MAX       24
+#endif
+
+/* stacks are in ram_tcm or ram_wifi, see flash.ld */
+#define COREDUMP_RAM_START          0x4200C000
+#define COREDUMP_RAM_END            0x4204A000
+
+/* the trap frame of portASM.S in words: mepc, f0-f31, fcsr, then x1, x5-x31
+ * and mstatus. Switched out tasks keep the same frame, sp was right above. */
+#define FRAME_MEPC                  0
+#define FRAME_X1                    35
+#define FRAME_X(n)                  (31 + (n))      /* n >= 5 */
+#define FRAME_MSTATUS               63
+#define FRAME_WORDS                 64
+
+/* debug.c keeps the console tail, oldest part first */
+extern int bl_log_tail_get(const char **p1, int *l1, const char **p2, int *l2);
+
+static uint32_t core_addr, core_size;
+static volatile int core_busy;
+/* static, the faulting stack may be about to overflow */
+static bl_coredump_writer_t core_writer;
+static TaskSnapshot_t core_tasks[BL_COREDUMP_TASKS_MAX];
+
+static uint32_t coredump_ram_len(uint32_t addr, uint32_t len)
+{
+    if (addr < COREDUMP_RAM_START || addr >= COREDUMP_RAM_END) {
+        return 0;
+    }
+    if (len > COREDUMP_RAM_END - addr) {
+        len = COREDUMP_RAM_END - addr;
+    }
+    return len;
+}
+
+static int coredump_flash_out(void *arg, uint32_t off, const void *data, uint32_t len)
+{
+    (void)arg;
+    return bl_flash_write(core_addr + off, (uint8_t *)data, len);
+}
+
+static int coredump_open(void)
+{
+    if (bl_flash_erase(core_addr, core_size)) {
+        return -1;
+    }
+    bl_coredump_begin(&core_writer, coredump_flash_out, NULL, core_size);
+    return 0;
+}
+
+/* the log tail as one section, dropping its oldest bytes when short of room */
+static void coredump_log(bl_coredump_writer_t *w)
+{
+    bl_coredump_part_t part[2];
+    const char *p1, *p2;
+    int l1, l2, room, cut;
+
+    if (bl_log_tail_get(&p1, &l1, &p2, &l2) <= 0 ||
+            w->size - w->off < sizeof(bl_coredump_sec_t) + 4) {
+        return;
+    }
+    room = (int)((w->size - w->off - sizeof(bl_coredump_sec_t)) & ~3);
+    if (l1 + l2 > room) {
+        cut = l1 + l2 - room;
+        if (cut >= l1) {
+            p1 = p2 + (cut - l1);
+            l1 = l2 - (cut - l1);
+            l2 = 0;
+        } else {
+            p1 += cut;
+            l1 -= cut;
+        }
+    }
+    part[0].data = p1;
+    part[0].len = l1;
+    part[1].data = p2;
+    part[1].len = l2;
+    bl_coredump_section(w, BL_COREDUMP_SEC_LOG, part, 2);
+}
+
+static void coredump_tasks(bl_coredump_writer_t *w, const bl_coredump_regs_t *regs)
+{
+    bl_coredump_task_t task;
+    bl_coredump_part_t part[2];
+    const TaskSnapshot_t *snap;
+    const uint32_t *frame;
+    uint32_t n, i;
+
+    n = uxTaskGetSnapshotAll(core_tasks, BL_COREDUMP_TASKS_MAX);
+    for (i = 0; i < n; i++) {
+        snap = &core_tasks[i];
+        memset(&task, 0, sizeof(task));
+        task.handle = (uint32_t)snap->xHandle;
+        task.stack_base = (uint32_t)snap->pxStackBase;
+        task.state = snap->eCurrentState;
+        task.prio = snap->uxCurrentPriority;
+        strncpy(task.name, pcTaskGetName(snap->xHandle), sizeof(task.name));
+        if (coredump_ram_len(task.stack_base, 4)) {
+            task.free_min = uxTaskGetStackHighWaterMark(snap->xHandle) * sizeof(StackType_t);
+        }
+
+        frame = (const uint32_t *)snap->pxTopOfStack;
+        if (eRunning == snap->eCurrentState) {
+            /* its stack is the STACK section already */
+            task.pc = regs->mepc;
+            task.ra = regs->x[1];
+            task.sp = regs->x[2];
+        } else if (FRAME_WORDS * 4 == coredump_ram_len((uint32_t)frame, FRAME_WORDS * 4)) {
+            task.pc = frame[FRAME_MEPC];
+            task.ra = frame[FRAME_X1];
+            task.sp = (uint32_t)(frame + FRAME_WORDS);
+        }
+
+        part[0].data = &task;
+        part[0].len = sizeof(task);
+        part[1].data = (const void *)task.sp;
+        part[1].len = (eRunning == snap->eCurrentState) ? 0 :
+            coredump_ram_len(task.sp, BL_COREDUMP_TASK_BYTES);
+        if (bl_coredump_section(w, BL_COREDUMP_SEC_TASK, part, 2) < 0) {
+            break;
+        }
+    }
+}
+
+/*
+ * Interrupts stay off and the scheduler suspended for good: bl_flash then
+ * finds no scheduler to suspend and leaves MIE alone, nothing can run again
+ * before the reset.
+ */
+static void coredump_write(uint32_t reason, const bl_coredump_regs_t *regs, const char *msg)
+{
+    bl_coredump_writer_t *w = &core_writer;
+    bl_coredump_heap_t heap;
+    bl_coredump_part_t part[2];
+    uint32_t sp;
+    int ret;
+
+    if (0 == core_size || core_busy) {
+        return;
+    }
+    core_busy = 1;
+    __disable_irq();
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        vTaskSuspendAll();
+    }
+
+    puts("[CORE] Writing crash record...\r\n");
+    if (coredump_open()) {
+        puts("[CORE] Erase failed\r\n");
+        return;
+    }
+
+    part[0].data = regs;
+    part[0].len = sizeof(*regs);
+    bl_coredump_section(w, BL_COREDUMP_SEC_REGS, part, 1);
+
+    if (msg) {
+        part[0].data = msg;
+        part[0].len = strlen(msg);
+        bl_coredump_section(w, BL_COREDUMP_SEC_MSG, part, 1);
+    }
+
+    heap.free = xPortGetFreeHeapSize();
+    heap.min_free = xPortGetMinimumEverFreeHeapSize();
+    part[0].data = &heap;
+    part[0].len = sizeof(heap);
+    bl_coredump_section(w, BL_COREDUMP_SEC_HEAP, part, 1);
+
+    sp = regs->x[2];
+    part[0].data = &sp;
+    part[0].len = sizeof(sp);
+    part[1].data = (const void *)sp;
+    part[1].len = coredump_ram_len(sp, BL_COREDUMP_STACK_BYTES);
+    bl_coredump_section(w, BL_COREDUMP_SEC_STACK, part, 2);
+
+    coredump_log(w);
+    coredump_tasks(w, regs);
+
+    ret = bl_coredump_end(w, reason, xTaskGetTickCount() * portTICK_PERIOD_MS);
+    if (ret < 0) {
+        puts("[CORE] Write failed\r\n");
+    } else {
+        printf("[CORE] %d bytes written\r\n", ret);
+    }
+}
+
+void bl_coredump_fault(uint32_t mcause, uint32_t mepc, uint32_t mtval, uintptr_t *regs)
+{
+    static bl_coredump_regs_t r;
+    const uint32_t *frame = (const uint32_t *)regs;
+    int n;
+
+    r.mcause = mcause;
+    r.mepc = mepc;
+    r.mtval = mtval;
+    r.mstatus = frame[FRAME_MSTATUS];
+    r.x[0] = 0;
+    r.x[1] = frame[FRAME_X1];
+    r.x[2] = (uint32_t)(frame + FRAME_WORDS);
+    /* never saved, the trap leaves them alone */
+    __asm volatile ("mv %0, gp" : "=r"(r.x[3]));
+    __asm volatile ("mv %0, tp" : "=r"(r.x[4]));
+    for (n = 5; n < 32; n++) {
+        r.x[n] = frame[FRAME_X(n)];
+    }
+
+    coredump_write(BL_COREDUMP_FAULT, &r, NULL);
+}
+
+void bl_coredump_save(uint32_t reason, const char *msg)
+{
+    static bl_coredump_regs_t r;
+    uint32_t mstatus;
+
+    /* the registers of this call, close enough to the caller's */
+    __asm volatile (
+        ".irp n,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+        "sw x\\n, (\\n * 4)(%0)\n"
+        ".endr\n"
+        : : "r"(r.x) : "memory");
+    __asm volatile ("csrr %0, mstatus" : "=r"(mstatus));
+
+    r.mcause = 0;
+    r.mepc = (uint32_t)__builtin_return_address(0);
+    r.mtval = 0;
+    r.mstatus = mstatus;
+    r.x[0] = 0;
+    r.x[1] = r.mepc;
+
+    coredump_write(reason, &r, msg);
+}
+
+int bl_coredump_erase(void)
+{
+    if (0 == core_size) {
+        return -1;
+    }
+    return bl_flash_erase(core_addr, core_size);
+}
+
+/* the whole record from flash when it checks out, vPortFree it */
+static uint8_t *coredump_load(void)
+{
+    bl_coredump_hdr_t hdr;
+    uint8_t *rec;
+
+    if (0 == core_size || bl_flash_read(core_addr, (uint8_t *)&hdr, sizeof(hdr)) ||
+            BL_COREDUMP_MAGIC != hdr.magic || hdr.length < sizeof(hdr) || hdr.length > core_size) {
+        return NULL;
+    }
+    rec = pvPortMalloc(hdr.length);
+    if (NULL == rec) {
+        return NULL;
+    }
+    if (bl_flash_read(core_addr, rec, hdr.length) || bl_coredump_check(rec, hdr.length)) {
+        vPortFree(rec);
+        return NULL;
+    }
+    return rec;
+}
+
+int bl_coredump_init(void)
+{
+    const bl_coredump_hdr_t *hdr;
+    uint32_t addr, size;
+    uint8_t *rec;
+    int wdt;
+
+    if (hal_boot2_partition_addr_active(BL_COREDUMP_PARTITION, &addr, &size) ||
+            size < sizeof(bl_coredump_hdr_t)) {
+        return -1;
+    }
+    core_addr = addr;
+    core_size = size;
+
+    wdt = (SET == WDT_GetResetStatus());
+    if (wdt) {
+        WDT_ClearResetStatus();
+    }
+    rec = coredump_load();
+    if (wdt && NULL == rec) {
+        /* the watchdog resets without warning, all there is to keep is that it did */
+        if (0 == coredump_open() && bl_coredump_end(&core_writer, BL_COREDUMP_WATCHDOG, 0) > 0) {
+            rec = coredump_load();
+        }
+    } else if (wdt) {
+        puts("[CORE] Watchdog reset, keeping the earlier record\r\n");
+    }
+    if (rec) {
+        hdr = (const bl_coredump_hdr_t *)rec;
+        printf("[CORE] %s record from a previous run, %lu bytes, see 'coredump'\r\n",
+                bl_coredump_reason_str(hdr->reason), hdr->length);
+        vPortFree(rec);
+    }
+
+    return 0;
+}
+
+static const char *const reg_names[32] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+    "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+    "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+    "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+};
+
+static const char *task_state_str(uint8_t state)
+{
+    static const char *const names[] = {"run", "ready", "block", "susp", "del"};
+
+    return state < sizeof(names)/sizeof(names[0]) ? names[state] : "?";
+}
+
+static void coredump_words(const uint8_t *p, uint32_t addr, uint32_t len)
+{
+    uint32_t i, word;
+
+    for (i = 0; i + 4 <= len; i += 4) {
+        memcpy(&word, p + i, 4);
+        printf("%s%08lx: %08lx", (i % 16) ? "  " : "    ", addr + i, word);
+        if (12 == i % 16 || i + 8 > len) {
+            puts("\r\n");
+        }
+    }
+}
+
+static void coredump_show(const uint8_t *rec)
+{
+    const bl_coredump_hdr_t *hdr = (const bl_coredump_hdr_t *)rec;
+    const bl_coredump_sec_t *sec = NULL;
+    const bl_coredump_regs_t *regs;
+    const bl_coredump_heap_t *heap;
+    const bl_coredump_task_t *task;
+    const uint8_t *data;
+    uint32_t addr, i;
+    int tasks = 0;
+
+    printf("%s, %lu ms after boot, %lu bytes\r\n",
+            bl_coredump_reason_str(hdr->reason), hdr->uptime_ms, hdr->length);
+    while (NULL != (sec = bl_coredump_next(rec, sec))) {
+        data = (const uint8_t *)(sec + 1);
+        switch (sec->type) {
+            case BL_COREDUMP_SEC_REGS:
+            {
+                regs = (const bl_coredump_regs_t *)data;
+                printf("mcause %08lx mepc %08lx mtval %08lx mstatus %08lx\r\n",
+                        regs->mcause, regs->mepc, regs->mtval, regs->mstatus);
+                for (i = 1; i < 32; i++) {
+                    printf("%4s %08lx%s", reg_names[i], regs->x[i], (0 == i % 4 || 31 == i) ? "\r\n" : "  ");
+                }
+            }
+            break;
+            case BL_COREDUMP_SEC_MSG:
+            {
+                printf("message: %.*s\r\n", sec->len, (const char *)data);
+            }
+            break;
+            case BL_COREDUMP_SEC_HEAP:
+            {
+                heap = (const bl_coredump_heap_t *)data;
+                printf("heap free %lu, min free %lu\r\n", heap->free, heap->min_free);
+            }
+            break;
+            case BL_COREDUMP_SEC_STACK:
+            {
+                memcpy(&addr, data, 4);
+                printf("stack, %u bytes:\r\n", sec->len - 4);
+                coredump_words(data + 4, addr, sec->len - 4);
+            }
+            break;
+            case BL_COREDUMP_SEC_TASK:
+            {
+                task = (const bl_coredump_task_t *)data;
+                if (0 == tasks++) {
+                    puts("handle   state prio pc       ra       sp       free name\r\n");
+                }
+                printf("%08lx %-5s %4u %08lx %08lx %08lx %4lu %.*s\r\n",
+                        task->handle, task_state_str(task->state), task->prio,
+                        task->pc, task->ra, task->sp, task->free_min,
+                        BL_COREDUMP_NAME_LEN, task->name);
+            }
+            break;
+            case BL_COREDUMP_SEC_LOG:
+            {
+                printf("log tail:\r\n%.*s\r\n", sec->len, (const char *)data);
+            }
+            break;
+            default:
+            {
+                printf("section %u, %u bytes\r\n", sec->type, sec->len);
+            }
+            break;
+        }
+    }
+}
+
+/* for tools/coredump.py */
+static void coredump_hex(const uint8_t *rec, uint32_t len)
+{
+    char line[2 * 32 + 1];
+    uint32_t off, i;
+
+    printf("coredump hex %lu\r\n", len);
+    for (off = 0; off < len; off += 32) {
+        for (i = 0; i < 32 && off + i < len; i++) {
+            snprintf(line + 2 * i, 3, "%02x", rec[off + i]);
+        }
+        printf("%04lx: %s\r\n", off, line);
+    }
+    puts("coredump end\r\n");
+}
+
+static void cmd_coredump([[gnu::unused]] char *buf, [[gnu::unused]] int len, int argc, char **argv)
+{
+    uint8_t *rec;
+
+    if (0 == core_size) {
+        puts("No \"" BL_COREDUMP_PARTITION "\" partition\r\n");
+        return;
+    }
+    if (argc > 1 && 0 == strcmp(argv[1], "erase")) {
+        printf("Erase %s\r\n", bl_coredump_erase() ? "failed" : "done");
+        return;
+    }
+    rec = coredump_load();
+    if (NULL == rec) {
+        puts("No crash record\r\n");
+        return;
+    }
+    if (argc > 1 && 0 == strcmp(argv[1], "hex")) {
+        coredump_hex(rec, ((const bl_coredump_hdr_t *)rec)->length);
+    } else {
+        coredump_show(rec);
+    }
+    vPortFree(rec);
+}
+
+static const struct cli_command cmds_user[] STATIC_CLI_CMD_ATTRIBUTE = {
+    {"coredump", "crash record of a previous run, 'coredump hex' for tools/coredump.py, 'coredump erase'", cmd_coredump},
+};
+
+#endif
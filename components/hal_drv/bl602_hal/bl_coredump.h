@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_COREDUMP_H__
+#define __BL_COREDUMP_H__
+#include <stdint.h>
+
+#include "bl_coredump_record.h"
+
+/*
+ * Post-mortem crash record, built with CONFIG_COREDUMP=1. A fault, a failed
+ * assert or a stack overflow writes registers, the stack of the current
+ * task, every task's saved context and top of stack, heap statistics and the
+ * console tail into the "core" partition, which survives the reset. The next
+ * boot reports it, the "coredump" command shows it and tools/coredump.py
+ * symbolizes "coredump hex" output against the ELF.
+ *
+ * The partition is opt-in, add it to the partition table with a size of a
+ * few flash sectors, here taken from the end of "media" in the 2M layout:
+ *
+ *   [[pt_entry]]
+ *   type = 7
+ *   name = "core"
+ *   device = 0
+ *   address0 = 0x1E7000
+ *   size0 = 0x2000
+ *   address1 = 0
+ *   size1 = 0
+ *   len = 0
+ *
+ * Without it, everything here does nothing.
+ */
+#define BL_COREDUMP_PARTITION       "core"
+
+/* after hal_boot2_init, with the heap up */
+int bl_coredump_init(void);
+/* from exception_entry, regs is the trap frame; returns once written */
+void bl_coredump_fault(uint32_t mcause, uint32_t mepc, uint32_t mtval, uintptr_t *regs);
+/* from a task, an ISR or a hook, msg may be NULL */
+void bl_coredump_save(uint32_t reason, const char *msg);
+int bl_coredump_erase(void);
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <utils_crc.h>
+
+#include "bl_coredump_record.h"
+
+/* The crash record format, free of any hardware so that the host tests and
+ * tools share it. The writer streams the record through a small buffer and
+ * never reads it back, which is what a flash partition wants. */
+
+static void rec_flush(bl_coredump_writer_t *w)
+{
+    if (w->fill && !w->err) {
+        if (w->out(w->arg, w->off - w->fill, w->buf, w->fill)) {
+            w->err = 1;
+        }
+    }
+    w->fill = 0;
+}
+
+static void rec_put(bl_coredump_writer_t *w, const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t n;
+
+    w->crc = utils_crc32_update(w->crc, data, len);
+    while (len) {
+        n = BL_COREDUMP_CHUNK - w->fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(w->buf + w->fill, p, n);
+        w->fill += n;
+        w->off += n;
+        p += n;
+        len -= n;
+        if (BL_COREDUMP_CHUNK == w->fill) {
+            rec_flush(w);
+        }
+    }
+}
+
+void bl_coredump_begin(bl_coredump_writer_t *w, bl_coredump_out_t out, void *arg, uint32_t size)
+{
+    w->out = out;
+    w->arg = arg;
+    w->size = size;
+    w->off = sizeof(bl_coredump_hdr_t);
+    w->crc = 0;
+    w->fill = 0;
+    w->err = (size < sizeof(bl_coredump_hdr_t));
+}
+
+int bl_coredump_section(bl_coredump_writer_t *w, uint16_t type, const bl_coredump_part_t *part, int n)
+{
+    static const uint8_t zero[3];
+    bl_coredump_sec_t sec;
+    uint32_t total = 0, room, cut = 0, len;
+    int i;
+
+    if (w->err || n <= 0 || w->size - w->off < sizeof(sec)) {
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        total += part[i].len;
+    }
+    /* whole words, so that the padding always fits */
+    room = (w->size - w->off - sizeof(sec)) & ~3;
+    if (room > 0xfffc) {
+        room = 0xfffc;
+    }
+    if (total > room) {
+        cut = total - room;
+        if (cut > part[n - 1].len) {
+            return -1;
+        }
+        total = room;
+    }
+
+    sec.type = type;
+    sec.len = total;
+    rec_put(w, &sec, sizeof(sec));
+    for (i = 0; i < n; i++) {
+        len = part[i].len;
+        if (i == n - 1) {
+            len -= cut;
+        }
+        rec_put(w, part[i].data, len);
+    }
+    rec_put(w, zero, (4 - (total & 3)) & 3);
+
+    return w->err ? -1 : (int)total;
+}
+
+int bl_coredump_end(bl_coredump_writer_t *w, uint32_t reason, uint32_t uptime_ms)
+{
+    bl_coredump_hdr_t hdr;
+
+    rec_flush(w);
+    if (w->err) {
+        return -1;
+    }
+
+    hdr.magic = BL_COREDUMP_MAGIC;
+    hdr.version = BL_COREDUMP_VERSION;
+    hdr.hdr_size = sizeof(hdr);
+    hdr.length = w->off;
+    hdr.crc = w->crc;
+    hdr.reason = reason;
+    hdr.uptime_ms = uptime_ms;
+    if (w->out(w->arg, 0, &hdr, sizeof(hdr))) {
+        w->err = 1;
+        return -1;
+    }
+
+    return w->off;
+}
+
+int bl_coredump_check(const uint8_t *rec, uint32_t size)
+{
+    const bl_coredump_hdr_t *hdr = (const bl_coredump_hdr_t *)rec;
+    const bl_coredump_sec_t *sec;
+    uint32_t off;
+
+    if (size < sizeof(*hdr) || BL_COREDUMP_MAGIC != hdr->magic ||
+            BL_COREDUMP_VERSION != hdr->version || sizeof(*hdr) != hdr->hdr_size ||
+            hdr->length < sizeof(*hdr) || hdr->length > size || (hdr->length & 3)) {
+        return -1;
+    }
+    if (utils_crc32_update(0, rec + sizeof(*hdr), hdr->length - sizeof(*hdr)) != hdr->crc) {
+        return -1;
+    }
+
+    /* the sections have to tile the record exactly */
+    for (off = sizeof(*hdr); off < hdr->length; ) {
+        if (hdr->length - off < sizeof(*sec)) {
+            return -1;
+        }
+        sec = (const bl_coredump_sec_t *)(rec + off);
+        off += sizeof(*sec) + ((sec->len + 3) & ~3);
+        if (off > hdr->length) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+const bl_coredump_sec_t *bl_coredump_next(const uint8_t *rec, const bl_coredump_sec_t *sec)
+{
+    const bl_coredump_hdr_t *hdr = (const bl_coredump_hdr_t *)rec;
+    const uint8_t *p;
+
+    if (NULL == sec) {
+        p = rec + hdr->hdr_size;
+    } else {
+        p = (const uint8_t *)(sec + 1) + ((sec->len + 3) & ~3);
+    }
+
+    return p < rec + hdr->length ? (const bl_coredump_sec_t *)p : NULL;
+}
+
+const char *bl_coredump_reason_str(uint32_t reason)
+{
+    switch (reason) {
+        case BL_COREDUMP_FAULT:
+            return "fault";
+        case BL_COREDUMP_ASSERT:
+            return "assert";
+        case BL_COREDUMP_STACK_OVERFLOW:
+            return "stack overflow";
+        case BL_COREDUMP_WATCHDOG:
+            return "watchdog";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_COREDUMP_RECORD_H__
+#define __BL_COREDUMP_RECORD_H__
+#include <stdint.h>
+
+/*
+ * Crash record, all fields little endian:
+ *   header, bl_coredump_hdr_t
+ *   sections, each a bl_coredump_sec_t followed by len bytes and padded to
+ *   4 bytes
+ * The CRC-32 covers everything after the header up to length. The record is
+ * streamed out front to back and the header is written last, so a record cut
+ * short by a second fault or a reset never checks out.
+ */
+#define BL_COREDUMP_MAGIC           0x44434C42  /* "BLCD" */
+#define BL_COREDUMP_VERSION         1
+
+/* why the record was written */
+#define BL_COREDUMP_FAULT           1   /* exception, mcause tells which */
+#define BL_COREDUMP_ASSERT          2
+#define BL_COREDUMP_STACK_OVERFLOW  3
+#define BL_COREDUMP_WATCHDOG        4   /* found at boot, nothing but the header */
+
+/* section types */
+#define BL_COREDUMP_SEC_REGS        1   /* bl_coredump_regs_t */
+#define BL_COREDUMP_SEC_MSG         2   /* text, no NUL */
+#define BL_COREDUMP_SEC_HEAP        3   /* bl_coredump_heap_t */
+#define BL_COREDUMP_SEC_STACK       4   /* start address, then the bytes from there up */
+#define BL_COREDUMP_SEC_TASK        5   /* bl_coredump_task_t, then the bytes from its sp up, the running task's are in STACK */
+#define BL_COREDUMP_SEC_LOG         6   /* the last console output */
+
+typedef struct bl_coredump_hdr {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t hdr_size;
+    uint32_t length;            /* of the whole record */
+    uint32_t crc;
+    uint32_t reason;
+    uint32_t uptime_ms;
+} bl_coredump_hdr_t;
+
+typedef struct bl_coredump_sec {
+    uint16_t type;
+    uint16_t len;
+} bl_coredump_sec_t;
+
+typedef struct bl_coredump_regs {
+    uint32_t mcause;
+    uint32_t mepc;              /* the pc for asserts and stack overflows */
+    uint32_t mtval;
+    uint32_t mstatus;
+    uint32_t x[32];             /* x[0] is 0 */
+} bl_coredump_regs_t;
+
+typedef struct bl_coredump_heap {
+    uint32_t free;
+    uint32_t min_free;
+} bl_coredump_heap_t;
+
+#define BL_COREDUMP_NAME_LEN        16
+
+typedef struct bl_coredump_task {
+    uint32_t handle;
+    /* from the saved context, from the fault for the running task, all
+     * 0 if the context could not be read */
+    uint32_t pc;
+    uint32_t ra;
+    uint32_t sp;
+    uint32_t stack_base;        /* lowest address of the stack */
+    uint32_t free_min;          /* stack high water mark, bytes */
+    uint8_t state;              /* eTaskState */
+    uint8_t prio;
+    uint8_t reserved[2];
+    char name[BL_COREDUMP_NAME_LEN];
+} bl_coredump_task_t;
+
+/* a section is written from up to this many pieces */
+typedef struct bl_coredump_part {
+    const void *data;
+    uint32_t len;
+} bl_coredump_part_t;
+
+/* off is relative to the start of the record, 0 on success */
+typedef int (*bl_coredump_out_t)(void *arg, uint32_t off, const void *data, uint32_t len);
+
+#ifndef BL_COREDUMP_CHUNK
+#define BL_COREDUMP_CHUNK           256
+#endif
+
+typedef struct bl_coredump_writer {
+    bl_coredump_out_t out;
+    void *arg;
+    uint32_t size;              /* room for the whole record */
+    uint32_t off;               /* bytes of the record so far */
+    uint32_t crc;
+    uint32_t fill;              /* bytes in buf, belonging at off - fill */
+    int err;
+    uint8_t buf[BL_COREDUMP_CHUNK];
+} bl_coredump_writer_t;
+
+void bl_coredump_begin(bl_coredump_writer_t *w, bl_coredump_out_t out, void *arg, uint32_t size);
+/*
+ * Append one section made of n parts. When the record is short of room the
+ * last part is cut, the section is dropped if even the other parts do not
+ * fit. Returns the bytes of data written, -1 if nothing was.
+ */
+int bl_coredump_section(bl_coredump_writer_t *w, uint16_t type, const bl_coredump_part_t *part, int n);
+/* flush the sections, then write the header, returns the record length or -1 */
+int bl_coredump_end(bl_coredump_writer_t *w, uint32_t reason, uint32_t uptime_ms);
+
+/* 0 when rec, word aligned, holds a whole record with a good CRC in size bytes */
+int bl_coredump_check(const uint8_t *rec, uint32_t size);
+/* first section with sec NULL, NULL after the last; only on a checked record */
+const bl_coredump_sec_t *bl_coredump_next(const uint8_t *rec, const bl_coredump_sec_t *sec);
+const char *bl_coredump_reason_str(uint32_t reason);
+#endif
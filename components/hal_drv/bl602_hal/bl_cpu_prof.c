@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bl602.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <cli.h>
+
+#include "bl_cpu_prof.h"
+#include "bl_cpu_prof_stat.h"
+
+#ifdef CFG_CPU_PROFILE
+
+#define CPU_PROF_WINDOW_MS          1000
+#define CPU_PROF_WINDOW_MS_MAX      (60 * 1000)     /* well within a turn of the counters */
+#define CPU_PROF_TASKS_EXTRA        4               /* for tasks created in the window */
+
+struct cpu_prof_irq {
+    uint64_t cycles;
+    uint32_t count;
+};
+
+static struct {
+    /* one more, for measuring the hooks */
+    struct cpu_prof_irq irq[BL_CPU_PROF_IRQS + 1];
+    volatile uint64_t irq_cycles;       /* of all of them */
+    uint32_t hook_cycles;
+} prof;
+
+struct cpu_prof_snap {
+    TaskStatus_t *tasks;
+    bl_cpu_prof_sample_t *task_samples;
+    int n_tasks;
+    bl_cpu_prof_sample_t irqs[BL_CPU_PROF_IRQS];
+    int n_irqs;
+    uint32_t now;
+};
+
+static inline uint64_t cpu_prof_cycles64(void)
+{
+    uint32_t hi, lo, hi2;
+
+    do {
+        __asm volatile ("csrr %0, mcycleh" : "=r"(hi));
+        __asm volatile ("csrr %0, mcycle" : "=r"(lo));
+        __asm volatile ("csrr %0, mcycleh" : "=r"(hi2));
+    } while (hi != hi2);
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* in TCM, it runs on every interrupt and an XIP cache miss would be most
+ * of what it costs
+ */
+void ATTR_TCM_SECTION bl_cpu_prof_irq_exit(uint32_t irq, uint32_t start)
+{
+    uint32_t cycles = bl_cpu_prof_irq_enter() - start;
+
+    prof.irq[irq].cycles += cycles;
+    prof.irq[irq].count++;
+    prof.irq_cycles += cycles;
+}
+
+uint32_t bl_cpu_prof_counter(void)
+{
+    uint64_t irq, now;
+
+    /* an interrupt in between moves irq_cycles, read again */
+    do {
+        irq = prof.irq_cycles;
+        now = cpu_prof_cycles64();
+    } while (irq != prof.irq_cycles);
+
+    return (uint32_t)((now - irq) >> BL_CPU_PROF_SHIFT);
+}
+
+/* what the hooks add to an interrupt, the best of a few runs */
+static uint32_t cpu_prof_hook_cost(void)
+{
+    uint32_t t1, t2, best = UINT32_MAX;
+    uint64_t saved;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        taskENTER_CRITICAL();
+        saved = prof.irq_cycles;
+        t1 = bl_cpu_prof_irq_enter();
+        bl_cpu_prof_irq_exit(BL_CPU_PROF_IRQS, t1);
+        t2 = bl_cpu_prof_irq_enter();
+        prof.irq_cycles = saved;
+        taskEXIT_CRITICAL();
+        if (t2 - t1 < best) {
+            best = t2 - t1;
+        }
+    }
+
+    return best;
+}
+
+static struct cpu_prof_snap *cpu_prof_snap_alloc(int max_tasks)
+{
+    struct cpu_prof_snap *s;
+
+    s = pvPortMalloc(sizeof(*s) + max_tasks * (sizeof(TaskStatus_t) + sizeof(bl_cpu_prof_sample_t)));
+    if (NULL == s) {
+        return NULL;
+    }
+    s->tasks = (TaskStatus_t *)(s + 1);
+    s->task_samples = (bl_cpu_prof_sample_t *)(s->tasks + max_tasks);
+    return s;
+}
+
+static void cpu_prof_snap(struct cpu_prof_snap *s, int max_tasks)
+{
+    uint32_t total;
+    int i;
+
+    s->n_tasks = uxTaskGetSystemState(s->tasks, max_tasks, &total);
+    for (i = 0; i < s->n_tasks; i++) {
+        s->task_samples[i].key = (uintptr_t)s->tasks[i].xHandle;
+        s->task_samples[i].time = s->tasks[i].ulRunTimeCounter;
+        s->task_samples[i].count = 0;
+    }
+
+    s->n_irqs = 0;
+    taskENTER_CRITICAL();
+    for (i = 0; i < BL_CPU_PROF_IRQS; i++) {
+        if (prof.irq[i].count) {
+            s->irqs[s->n_irqs].key = i;
+            s->irqs[s->n_irqs].time = (uint32_t)(prof.irq[i].cycles >> BL_CPU_PROF_SHIFT);
+            s->irqs[s->n_irqs].count = prof.irq[i].count;
+            s->n_irqs++;
+        }
+    }
+    s->now = (uint32_t)(cpu_prof_cycles64() >> BL_CPU_PROF_SHIFT);
+    taskEXIT_CRITICAL();
+}
+
+static const char *cpu_prof_task_name(const struct cpu_prof_snap *s, uintptr_t key)
+{
+    int i;
+
+    for (i = 0; i < s->n_tasks; i++) {
+        if ((uintptr_t)s->tasks[i].xHandle == key) {
+            return s->tasks[i].pcTaskName;
+        }
+    }
+    return "?";
+}
+
+static void cpu_prof_print(const struct cpu_prof_snap *start, const struct cpu_prof_snap *end,
+        uint32_t ms, bl_cpu_prof_row_t *rows)
+{
+    uint32_t window = end->now - start->now, tasks = 0, irqs = 0;
+    int n, i;
+
+    printf("top: %lu ms, %lu Mcycles, hooks %lu cycles per interrupt\r\n",
+            ms, (uint32_t)(((uint64_t)window << BL_CPU_PROF_SHIFT) / 1000000), prof.hook_cycles);
+
+    n = bl_cpu_prof_delta(start->task_samples, start->n_tasks, end->task_samples, end->n_tasks, window, rows);
+    puts(" cpu%  task\r\n");
+    for (i = 0; i < n; i++) {
+        tasks += rows[i].permille;
+        printf("%3lu.%lu  %s\r\n", rows[i].permille / 10, rows[i].permille % 10,
+                cpu_prof_task_name(end, rows[i].key));
+    }
+
+    n = bl_cpu_prof_delta(start->irqs, start->n_irqs, end->irqs, end->n_irqs, window, rows);
+    puts(" cpu%  irq       count\r\n");
+    for (i = 0; i < n; i++) {
+        if (0 == rows[i].count) {
+            continue;
+        }
+        irqs += rows[i].permille;
+        if (rows[i].key < 16) {
+            printf("%3lu.%lu  %-8lu %lu\r\n", rows[i].permille / 10, rows[i].permille % 10,
+                    (uint32_t)rows[i].key, rows[i].count);
+        } else {
+            printf("%3lu.%lu  16+%-5lu %lu\r\n", rows[i].permille / 10, rows[i].permille % 10,
+                    (uint32_t)rows[i].key - 16, rows[i].count);
+        }
+    }
+    printf("tasks %lu.%lu%%, interrupts %lu.%lu%%\r\n", tasks / 10, tasks % 10, irqs / 10, irqs % 10);
+}
+
+static void cmd_top([[gnu::unused]] char *buf, [[gnu::unused]] int len, int argc, char **argv)
+{
+    struct cpu_prof_snap *start = NULL, *end = NULL, *tmp;
+    bl_cpu_prof_row_t *rows = NULL;
+    uint32_t ms = CPU_PROF_WINDOW_MS;
+    int rounds = 1, max_tasks, max_rows;
+
+    if (argc > 1) {
+        ms = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        rounds = atoi(argv[2]);
+    }
+    if (0 == ms || ms > CPU_PROF_WINDOW_MS_MAX || rounds <= 0) {
+        printf("Usage: %s [window ms, up to %u] [rounds]\r\n", argv[0], CPU_PROF_WINDOW_MS_MAX);
+        return;
+    }
+    if (0 == prof.hook_cycles) {
+        prof.hook_cycles = cpu_prof_hook_cost();
+    }
+
+    max_tasks = uxTaskGetNumberOfTasks() + CPU_PROF_TASKS_EXTRA;
+    max_rows = max_tasks > BL_CPU_PROF_IRQS ? max_tasks : BL_CPU_PROF_IRQS;
+    start = cpu_prof_snap_alloc(max_tasks);
+    end = cpu_prof_snap_alloc(max_tasks);
+    rows = pvPortMalloc(max_rows * sizeof(*rows));
+    if (NULL == start || NULL == end || NULL == rows) {
+        puts("top: out of memory\r\n");
+        goto out;
+    }
+
+    cpu_prof_snap(start, max_tasks);
+    while (rounds--) {
+        vTaskDelay(pdMS_TO_TICKS(ms));
+        cpu_prof_snap(end, max_tasks);
+        cpu_prof_print(start, end, ms, rows);
+        /* the end of this window starts the next one */
+        tmp = start;
+        start = end;
+        end = tmp;
+    }
+
+out:
+    vPortFree(rows);
+    vPortFree(end);
+    vPortFree(start);
+}
+
+static const struct cli_command cmds_user[] STATIC_CLI_CMD_ATTRIBUTE = {
+    {"top", "CPU use of tasks and interrupts, top [window ms] [rounds]", cmd_top},
+};
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_CPU_PROF_H__
+#define __BL_CPU_PROF_H__
+#include <stdint.h>
+
+/*
+ * CPU profiler, built with CONFIG_CPU_PROFILE=1 and read with "top".
+ * interrupt_entry charges the mcycle count of every dispatched interrupt to
+ * its IRQ number, and the FreeRTOS run time counter is mcycle with that
+ * interrupt time taken out, so a task is only charged for what it ran
+ * itself. The trap entry and exit of portASM.S, the tick and the context
+ * switches stay with the task that was interrupted.
+ */
+#ifdef CFG_CPU_PROFILE
+
+/* run time counter units, 2^SHIFT cycles */
+#ifndef BL_CPU_PROF_SHIFT
+#define BL_CPU_PROF_SHIFT           4
+#endif
+/* the 16 core interrupts and 64 external ones of bl_irq.c */
+#define BL_CPU_PROF_IRQS            (16 + 64)
+
+static inline __attribute__((always_inline)) uint32_t bl_cpu_prof_irq_enter(void)
+{
+    uint32_t cycles;
+
+    __asm volatile ("csrr %0, mcycle" : "=r"(cycles));
+    return cycles;
+}
+
+/* start is what bl_cpu_prof_irq_enter returned */
+void bl_cpu_prof_irq_exit(uint32_t irq, uint32_t start);
+/* portGET_RUN_TIME_COUNTER_VALUE */
+uint32_t bl_cpu_prof_counter(void);
+
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+
+#include "bl_cpu_prof_stat.h"
+
+static const bl_cpu_prof_sample_t *sample_find(const bl_cpu_prof_sample_t *s, int n, uintptr_t key)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (s[i].key == key) {
+            return &s[i];
+        }
+    }
+    return NULL;
+}
+
+int bl_cpu_prof_delta(const bl_cpu_prof_sample_t *start, int n_start,
+        const bl_cpu_prof_sample_t *end, int n_end, uint32_t window, bl_cpu_prof_row_t *rows)
+{
+    const bl_cpu_prof_sample_t *s;
+    bl_cpu_prof_row_t row;
+    int i, j;
+
+    for (i = 0; i < n_end; i++) {
+        s = sample_find(start, n_start, end[i].key);
+        row.key = end[i].key;
+        /* modulo 2^32, right across a wrap */
+        row.time = end[i].time - (s ? s->time : 0);
+        row.count = end[i].count - (s ? s->count : 0);
+        if (0 == window) {
+            row.permille = 0;
+        } else {
+            row.permille = ((uint64_t)row.time * 1000 + window / 2) / window;
+            if (row.permille > 1000) {
+                row.permille = 1000;
+            }
+        }
+
+        /* insertion sort, a few dozen rows at most */
+        for (j = i; j > 0 && rows[j - 1].time < row.time; j--) {
+            rows[j] = rows[j - 1];
+        }
+        rows[j] = row;
+    }
+
+    return n_end;
+}
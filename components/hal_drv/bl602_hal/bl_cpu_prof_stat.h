@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_CPU_PROF_STAT_H__
+#define __BL_CPU_PROF_STAT_H__
+#include <stdint.h>
+
+/*
+ * Per window CPU shares of the "top" command, free of any hardware so that
+ * the host tests can drive it. A sample is a snapshot of the run time
+ * counter of a task or an IRQ; the counters wrap, a window has to be shorter
+ * than one turn of them.
+ */
+typedef struct bl_cpu_prof_sample {
+    uintptr_t key;              /* task handle or IRQ number */
+    uint32_t time;              /* run time so far */
+    uint32_t count;             /* interrupts taken so far, 0 for tasks */
+} bl_cpu_prof_sample_t;
+
+typedef struct bl_cpu_prof_row {
+    uintptr_t key;
+    uint32_t time;              /* run time in the window */
+    uint32_t count;
+    uint32_t permille;          /* of the window */
+} bl_cpu_prof_row_t;
+
+/*
+ * One row for every key of end, with what it used since start, sorted by
+ * time, the largest first. A key not in start showed up in the window and
+ * counts from 0, keys gone by the end are left out. rows has room for n_end.
+ */
+int bl_cpu_prof_delta(const bl_cpu_prof_sample_t *start, int n_start,
+        const bl_cpu_prof_sample_t *end, int n_end, uint32_t window, bl_cpu_prof_row_t *rows);
+#endif
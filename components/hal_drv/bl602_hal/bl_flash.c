@@ -29,43 +29,330 @@
  */
 #include <bl602_romdriver.h>
 
+#include <FreeRTOS.h>
+#include <task.h>
+
 #include "bl_flash.h"
+#include "bl_timer.h"
 #include <blog.h>
 #define USER_UNUSED(a) ((void)(a))
 
+/* Erase and program are split into steps of one page or one erase block.
+ * Interrupts are only off during a step and code runs from XIP again in
+ * between, so everything a step touches while the flash is busy lives in
+ * TCM or ROM. An erase still running after BL_FLASH_STEP_BUDGET_US is
+ * suspended on parts that support it and resumed by the next step, other
+ * parts are erased sector by sector. Other tasks run between steps unless an
+ * erase is suspended.
+ */
+#ifndef BL_FLASH_STEP_BUDGET_US
+#define BL_FLASH_STEP_BUDGET_US     (2000)
+#endif
+#define BL_FLASH_SUSPEND_MAX_US     (100)       /* tSUS is 20..40us */
+
+#define BL_FLASH_STEP_DONE          (0)
+#define BL_FLASH_STEP_MORE          (1)
+#define BL_FLASH_STEP_ERROR         (-1)
+
 static struct {
     uint32_t magic;
     SPI_Flash_Cfg_Type flashCfg;
 } boot2_flashCfg; //XXX Dont change the name of varaible, since we refer this boot2_partition_table in linker script
 
+struct bl_flash_suspend_cmd {
+    uint8_t mid;
+    uint8_t suspend;
+    uint8_t resume;
+};
+
+static const struct bl_flash_suspend_cmd suspend_cmds[] = {
+    {0xC8, 0x75, 0x7A},     /* GigaDevice */
+    {0xEF, 0x75, 0x7A},     /* Winbond */
+    {0x20, 0x75, 0x7A},     /* XMC */
+    {0x0B, 0x75, 0x7A},     /* XTX */
+    {0x68, 0x75, 0x7A},     /* Boya */
+    {0x85, 0x75, 0x7A},     /* Puya */
+    {0x9D, 0xB0, 0x30},     /* ISSI */
+};
+
+/* everything a step needs, resolved before the first step since .rodata is in flash */
+struct bl_flash_op {
+    SPI_Flash_Cfg_Type *cfg;
+    uint32_t addr;
+    uint32_t end;
+    uint8_t *src;
+    uint8_t erase;
+    uint8_t suspended;
+    uint8_t suspend_cmd;
+    uint8_t resume_cmd;
+    uint32_t block;         /* size of the erase in progress */
+    uint32_t busy_us;       /* time spent on it, for the timeout */
+};
+
+static bl_flash_stats_t flash_stats;
+
+#define FLASH_US_SINCE(t)   ((bl_timer_now_ticks() - (t)) / BL_TIMER_TICKS_PER_US)
+
+static void ATTR_TCM_SECTION flash_send_cmd(uint8_t cmd, uint32_t addr, uint8_t addr_size)
+{
+    SF_Ctrl_Cmd_Cfg_Type flashCmd;
+
+    RomDriver_BL602_MemSet(&flashCmd, 0, sizeof(flashCmd));
+    flashCmd.cmdBuf[0] = ((uint32_t)cmd << 24) | addr;
+    /* rwFlag don't care */
+    flashCmd.rwFlag = SF_CTRL_READ;
+    flashCmd.addrSize = addr_size;
+    RomDriver_SF_Ctrl_SendCmd(&flashCmd);
+}
+
+/* same block choice as SFlash_Erase, blocks only when the erase can be suspended */
+static uint32_t ATTR_TCM_SECTION flash_erase_start(struct bl_flash_op *op)
+{
+    SPI_Flash_Cfg_Type *cfg = op->cfg;
+    uint32_t sector = cfg->sectorSize * 1024;
+    uint32_t len = op->end - op->addr;
+    uint8_t cmd;
+
+    if (op->suspend_cmd && cfg->blk64EraseCmd != BFLB_SPIFLASH_CMD_INVALID &&
+            (op->addr & (BFLB_SPIFLASH_BLK64K_SIZE - 1)) == 0 &&
+            len > BFLB_SPIFLASH_BLK64K_SIZE - sector) {
+        op->block = BFLB_SPIFLASH_BLK64K_SIZE;
+        cmd = cfg->blk64EraseCmd;
+    } else if (op->suspend_cmd && cfg->blk32EraseCmd != BFLB_SPIFLASH_CMD_INVALID &&
+            (op->addr & (BFLB_SPIFLASH_BLK32K_SIZE - 1)) == 0 &&
+            len > BFLB_SPIFLASH_BLK32K_SIZE - sector) {
+        op->block = BFLB_SPIFLASH_BLK32K_SIZE;
+        cmd = cfg->blk32EraseCmd;
+    } else {
+        op->block = sector;
+        cmd = cfg->sectorEraseCmd;
+    }
+    if (SUCCESS != RomDriver_SFlash_Write_Enable(cfg)) {
+        return 0;
+    }
+    flash_send_cmd(cmd, op->addr, 3);
+    op->busy_us = 0;
+
+    return op->block;
+}
+
+static uint32_t ATTR_TCM_SECTION flash_erase_timeout_us(struct bl_flash_op *op)
+{
+    /* SFlash_Sector_Erase allows 1.5 times the nominal time */
+    if (op->block == BFLB_SPIFLASH_BLK64K_SIZE) {
+        return op->cfg->timeE64k * 1500;
+    } else if (op->block == BFLB_SPIFLASH_BLK32K_SIZE) {
+        return op->cfg->timeE32k * 1500;
+    }
+    return op->cfg->timeEsector * 1500;
+}
+
+static int ATTR_TCM_SECTION flash_step_erase(struct bl_flash_op *op, uint32_t start)
+{
+    uint32_t t, waited;
+
+    if (op->suspended) {
+        flash_send_cmd(op->resume_cmd, 0, 0);
+        op->suspended = 0;
+    } else if (0 == flash_erase_start(op)) {
+        return BL_FLASH_STEP_ERROR;
+    }
+
+    t = bl_timer_now_ticks();
+    while (SET == RomDriver_SFlash_Busy(op->cfg)) {
+        waited = FLASH_US_SINCE(t);
+        if (op->busy_us + waited > flash_erase_timeout_us(op)) {
+            return BL_FLASH_STEP_ERROR;
+        }
+        if (0 == op->suspend_cmd || FLASH_US_SINCE(start) < BL_FLASH_STEP_BUDGET_US) {
+            continue;
+        }
+        flash_send_cmd(op->suspend_cmd, 0, 0);
+        t = bl_timer_now_ticks();
+        while (SET == RomDriver_SFlash_Busy(op->cfg)) {
+            if (FLASH_US_SINCE(t) > BL_FLASH_SUSPEND_MAX_US) {
+                /* the part ignored it, never ask again */
+                op->suspend_cmd = 0;
+                break;
+            }
+        }
+        if (op->suspend_cmd) {
+            op->busy_us += waited;
+            op->suspended = 1;
+            flash_stats.suspends++;
+            return BL_FLASH_STEP_MORE;
+        }
+    }
+
+    op->addr += op->block;
+    return (op->addr < op->end) ? BL_FLASH_STEP_MORE : BL_FLASH_STEP_DONE;
+}
+
+static int ATTR_TCM_SECTION flash_step_program(struct bl_flash_op *op)
+{
+    uint32_t len;
+
+    len = op->cfg->pageSize - op->addr % op->cfg->pageSize;
+    if (len > op->end - op->addr) {
+        len = op->end - op->addr;
+    }
+    if (SUCCESS != RomDriver_SFlash_Program(op->cfg, SF_CTRL_QIO_MODE, op->addr, op->src, len)) {
+        return BL_FLASH_STEP_ERROR;
+    }
+    op->addr += len;
+    op->src += len;
+
+    return (op->addr < op->end) ? BL_FLASH_STEP_MORE : BL_FLASH_STEP_DONE;
+}
+
+/* one page or one erase slice, called with interrupts off */
+static int ATTR_TCM_SECTION flash_step(struct bl_flash_op *op)
+{
+    uint32_t start, offset, elapsed;
+    uint8_t aes;
+    int ret;
+
+    start = bl_timer_now_ticks();
+    RomDriver_XIP_SFlash_Opt_Enter(&aes);
+    if (op->suspended) {
+        /* State_Save sends a software reset, that would abort the suspended erase */
+        RomDriver_SF_Ctrl_Set_Owner(SF_CTRL_OWNER_SAHB);
+        RomDriver_SFlash_Reset_Continue_Read(op->cfg);
+        offset = RomDriver_SF_Ctrl_Get_Flash_Image_Offset();
+        RomDriver_SF_Ctrl_Set_Flash_Image_Offset(0);
+    } else if (SUCCESS != RomDriver_XIP_SFlash_State_Save(op->cfg, &offset)) {
+        RomDriver_SFlash_Set_IDbus_Cfg(op->cfg, SF_CTRL_QIO_MODE, 1, 0, 32);
+        RomDriver_XIP_SFlash_Opt_Exit(aes);
+        return BL_FLASH_STEP_ERROR;
+    }
+
+    ret = op->erase ? flash_step_erase(op, start) : flash_step_program(op);
+    if (BL_FLASH_STEP_ERROR == ret && op->suspended) {
+        flash_send_cmd(op->resume_cmd, 0, 0);
+        op->suspended = 0;
+    }
+
+    RomDriver_XIP_SFlash_State_Restore(op->cfg, offset);
+    RomDriver_XIP_SFlash_Opt_Exit(aes);
+
+    elapsed = FLASH_US_SINCE(start);
+    flash_stats.steps++;
+    flash_stats.irq_off_last_us = elapsed;
+    if (elapsed > flash_stats.irq_off_max_us) {
+        flash_stats.irq_off_max_us = elapsed;
+    }
+
+    return ret;
+}
+
+static int flash_run(struct bl_flash_op *op)
+{
+    unsigned long mstatus = 0;
+    size_t i;
+    int ret, in_task;
+
+    op->suspend_cmd = 0;
+    op->resume_cmd = 0;
+    op->suspended = 0;
+    for (i = 0; op->erase && i < sizeof(suspend_cmds)/sizeof(suspend_cmds[0]); i++) {
+        if (suspend_cmds[i].mid == op->cfg->mid) {
+            op->suspend_cmd = suspend_cmds[i].suspend;
+            op->resume_cmd = suspend_cmds[i].resume;
+            break;
+        }
+    }
+
+    /* only a task with interrupts on steps in critical sections. The exit of
+     * one turns interrupts on whenever the scheduler has started, suspended
+     * or not, so a caller with interrupts off, as the crash handler is, or
+     * one running before the scheduler gets its mstatus back as it was
+     */
+    in_task = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) &&
+            (read_csr(mstatus) & MSTATUS_MIE);
+    do {
+        /* other tasks must not see a suspended erase, the scheduler stays
+         * suspended from the step that suspends it to the one that resumes it
+         */
+        if (in_task) {
+            if (!op->suspended) {
+                vTaskSuspendAll();
+            }
+            taskENTER_CRITICAL();
+        } else {
+            mstatus = read_csr(mstatus);
+            __disable_irq();
+        }
+        ret = flash_step(op);
+        /* pending interrupts are taken here */
+        if (in_task) {
+            taskEXIT_CRITICAL();
+            if (!op->suspended) {
+                xTaskResumeAll();
+            }
+        } else if (mstatus & MSTATUS_MIE) {
+            __enable_irq();
+        }
+    } while (BL_FLASH_STEP_MORE == ret);
+
+    flash_stats.ops++;
+    if (BL_FLASH_STEP_ERROR == ret) {
+        flash_stats.errors++;
+        return -1;
+    }
+    return 0;
+}
+
 int bl_flash_erase(uint32_t addr, int len)
 {
+    struct bl_flash_op op;
+    uint32_t sector;
+
     /*We assume mid zeor is illegal*/
     if (0 == boot2_flashCfg.flashCfg.mid) {
         return -1;
     }
-    RomDriver_XIP_SFlash_Erase_With_Lock(
-            &boot2_flashCfg.flashCfg,
-            addr,
-            len
-    );
-    return 0;
+    if (len <= 0) {
+        return 0;
+    }
+    sector = boot2_flashCfg.flashCfg.sectorSize * 1024;
+    op.cfg = &boot2_flashCfg.flashCfg;
+    op.addr = addr & (~(sector - 1));
+    op.end = addr + len;
+    op.src = NULL;
+    op.erase = 1;
+
+    return flash_run(&op);
 }
 
 int bl_flash_write(uint32_t addr, uint8_t *src, int len)
 {
+    struct bl_flash_op op;
+
     /*We assume mid zeor is illegal*/
     if (0 == boot2_flashCfg.flashCfg.mid) {
         return -1;
     }
+    if (len <= 0) {
+        return 0;
+    }
+    op.cfg = &boot2_flashCfg.flashCfg;
+    op.addr = addr;
+    op.end = addr + len;
+    op.src = src;
+    op.erase = 0;
 
-    RomDriver_XIP_SFlash_Write_With_Lock(
-            &boot2_flashCfg.flashCfg,
-            addr,
-            src,
-            len
-    );
-    return 0;
+    return flash_run(&op);
+}
+
+void bl_flash_stats_get(bl_flash_stats_t *stats)
+{
+    *stats = flash_stats;
+}
+
+void bl_flash_stats_reset(void)
+{
+    flash_stats.irq_off_max_us = 0;
+    flash_stats.irq_off_last_us = 0;
 }
 
 int bl_flash_read(uint32_t addr, uint8_t *dst, int len)
@@ -99,6 +386,7 @@ static void _dump_flash_config()
     blog_info("clkInvert \t0x%X\r\n", boot2_flashCfg.flashCfg.clkInvert);
     blog_info("sector size\t%uKBytes\r\n", boot2_flashCfg.flashCfg.sectorSize);
     blog_info("page size\t%uBytes\r\n", boot2_flashCfg.flashCfg.pageSize);
+    blog_info("step budget\t%uus\r\n", BL_FLASH_STEP_BUDGET_US);
     blog_info("---------------------------------------------------------------\r\n");
 }
 
@@ -29,6 +29,17 @@
  */
 #ifndef __BL_FLASH_H__
 #define __BL_FLASH_H__
+#include <stdint.h>
+
+typedef struct bl_flash_stats {
+    uint32_t irq_off_max_us;        /* worst interrupt latency added by one step */
+    uint32_t irq_off_last_us;
+    uint32_t steps;
+    uint32_t suspends;              /* erase suspended to let interrupts run */
+    uint32_t ops;
+    uint32_t errors;
+} bl_flash_stats_t;
+
 int bl_flash_erase(uint32_t addr, int len);
 int bl_flash_write(uint32_t addr, uint8_t *src, int len);
 int bl_flash_read(uint32_t addr, uint8_t *dst, int len);
@@ -36,4 +47,6 @@ int bl_flash_config_update(void);
 void* bl_flash_get_flashCfg(void);
 
 int bl_flash_read_byxip(uint32_t addr, uint8_t *dst, int len);
+void bl_flash_stats_get(bl_flash_stats_t *stats);
+void bl_flash_stats_reset(void);
 #endif
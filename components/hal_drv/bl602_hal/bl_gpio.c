@@ -32,8 +32,12 @@
 #include <bl602_glb.h>
 #include <bl602_gpio.h>
 #include <bl602.h>
+#include <FreeRTOS.h>
+#include <task.h>
 #include "bl_gpio.h"
+#include "bl_gpio_demux.h"
 #include "bl_irq.h"
+#include "bl_timer.h"
 
 #define GPIO_FUNC_NUM_IN_BL602   (GPIO0_FUN_SWGPIO_0)
 #define GPIP_INT_STATE_OFFSET    (0x1a8)
@@ -122,53 +126,148 @@ int bl_gpio_int_clear(uint8_t gpioPin, uint8_t intClear)
     return 0;
 }
 
-static int check_gpio_is_interrupt(int gpioPin)
+uint32_t bl_gpio_port_input_get(void)
 {
-    int bitcount = 0;
-    int reg_val = 0;
+    return BL_RD_WORD(GLB_BASE + GLB_GPIO_INPUT_OFFSET);
+}
 
-    bitcount = 1 << gpioPin;
-    reg_val = *(int32_t *)(GLB_BASE + GPIP_INT_STATE_OFFSET);
+uint32_t bl_gpio_port_output_get(void)
+{
+    return BL_RD_WORD(GLB_BASE + GLB_GPIO_OUTPUT_OFFSET);
+}
 
-    if ((bitcount & reg_val) == bitcount) {
-        return 0;
+/*
+ * GLB has no set/clear registers, a masked write is a read-modify-write of
+ * the whole port. Tasks do it in a critical section; interrupts do not nest,
+ * so an interrupt handler, a demux callback say, is not interrupted anyway.
+ */
+static void gpio_port_modify(uint32_t clear, uint32_t toggle)
+{
+    int in_isr = xPortIsInsideInterrupt();
+    uint32_t tmpVal;
+
+    if (!in_isr) {
+        taskENTER_CRITICAL();
+    }
+    tmpVal = BL_RD_WORD(GLB_BASE + GLB_GPIO_OUTPUT_OFFSET);
+    BL_WR_WORD(GLB_BASE + GLB_GPIO_OUTPUT_OFFSET, (tmpVal & ~clear) ^ toggle);
+    if (!in_isr) {
+        taskEXIT_CRITICAL();
     }
-    return -1;
 }
 
-static int exec_gpio_handler(gpio_ctx_t *pstnode)
+void bl_gpio_port_output_set(uint32_t mask, uint32_t value)
 {
-    bl_gpio_intmask(pstnode->gpioPin, 1);
+    gpio_port_modify(mask, value & mask);
+}
 
-    if (pstnode->gpio_handler) {
-        pstnode->gpio_handler(pstnode);
-        return 0;
+void bl_gpio_port_output_toggle(uint32_t mask)
+{
+    gpio_port_modify(0, mask);
+}
+
+/*
+ * One GPIO interrupt entry for all pins, the per-pin table and the
+ * debounce live in bl_gpio_demux.c.
+ */
+static bl_gpio_demux_t gpio_demux;
+static uint8_t gpio_irq_registered;
+
+static void gpio_irq_clear(uint8_t gpioPin)
+{
+    bl_gpio_int_clear(gpioPin, SET);
+    bl_gpio_int_clear(gpioPin, RESET);
+}
+
+static void gpio_interrupt_entry(void *ctx)
+{
+    uint32_t pending;
+    uint32_t legacy;
+    uint32_t now_us;
+    uint32_t tmpVal;
+
+    (void)ctx;
+    now_us = bl_timer_now_us();
+    pending = BL_RD_WORD(GLB_BASE + GPIP_INT_STATE_OFFSET) & gpio_demux.attached;
+
+    /* attached pins are cleared in one go and stay unmasked */
+    if (pending & gpio_demux.cb_pins) {
+        tmpVal = BL_RD_REG(GLB_BASE, GLB_GPIO_INT_CLR1);
+        BL_WR_REG(GLB_BASE, GLB_GPIO_INT_CLR1, tmpVal | (pending & gpio_demux.cb_pins));
+        BL_WR_REG(GLB_BASE, GLB_GPIO_INT_CLR1, tmpVal & ~(pending & gpio_demux.cb_pins));
+    }
+    /* registered pins are masked, their handler unmasks them */
+    legacy = pending & ~gpio_demux.cb_pins;
+    while (legacy) {
+        bl_gpio_intmask(__builtin_ctz(legacy), 1);
+        legacy &= legacy - 1;
     }
 
-    return -1;
+    bl_gpio_demux_dispatch(&gpio_demux, pending, now_us);
 }
 
-static void gpio_interrupt_entry(gpio_ctx_t *pstnode)
+static void gpio_irq_install(void)
 {
-    int ret;
+    if (!gpio_irq_registered) {
+        gpio_irq_registered = 1;
+        bl_irq_register_with_ctx(GPIO_INT0_IRQn, gpio_interrupt_entry, NULL);
+    }
+    bl_irq_enable(GPIO_INT0_IRQn);
+}
 
-    while (pstnode) {
-        ret = check_gpio_is_interrupt(pstnode->gpioPin);
-        if (ret == 0) {
-            exec_gpio_handler(pstnode);
-        }
+int bl_gpio_irq_attach(uint8_t pin, uint8_t intCtrlMod, uint8_t intTrgMod,
+        uint32_t debounce_us, bl_gpio_irq_cb_t cb, void *arg)
+{
+    if (pin >= GLB_GPIO_PIN_MAX || NULL == cb) {
+        return -1;
+    }
+
+    bl_gpio_intmask(pin, 1);
+    bl_set_gpio_intmod(pin, intCtrlMod, intTrgMod);
+    taskENTER_CRITICAL();
+    bl_gpio_demux_attach(&gpio_demux, pin, debounce_us, cb, arg);
+    taskEXIT_CRITICAL();
+    gpio_irq_clear(pin);
+    gpio_irq_install();
+    bl_gpio_intmask(pin, 0);
+
+    return 0;
+}
 
-        pstnode = pstnode->next;
+int bl_gpio_irq_detach(uint8_t pin)
+{
+    if (pin >= GLB_GPIO_PIN_MAX) {
+        return -1;
     }
-    return;
+
+    bl_gpio_intmask(pin, 1);
+    taskENTER_CRITICAL();
+    bl_gpio_demux_detach(&gpio_demux, pin);
+    taskEXIT_CRITICAL();
+
+    return 0;
+}
+
+uint32_t bl_gpio_irq_bounce_count(uint8_t pin)
+{
+    if (pin >= GLB_GPIO_PIN_MAX) {
+        return 0;
+    }
+    return gpio_demux.slot[pin].bounce;
 }
 
 void bl_gpio_register(gpio_ctx_t *pstnode)
 {
+    if (pstnode->gpioPin >= GLB_GPIO_PIN_MAX) {
+        return;
+    }
+
     bl_gpio_intmask(pstnode->gpioPin, 1);
     bl_set_gpio_intmod(pstnode->gpioPin, pstnode->intCtrlMod, pstnode->intTrgMod);
-    bl_irq_register_with_ctx(GPIO_INT0_IRQn, gpio_interrupt_entry, pstnode);
+    taskENTER_CRITICAL();
+    /* hal_gpio links newer nodes in front, older nodes of the pin follow */
+    bl_gpio_demux_register(&gpio_demux, pstnode);
+    taskEXIT_CRITICAL();
+    gpio_irq_install();
     bl_gpio_intmask(pstnode->gpioPin, 0);
-    bl_irq_enable(GPIO_INT0_IRQn);
 }
-
@@ -51,4 +51,18 @@ void bl_gpio_intmask(uint8_t gpiopin, uint8_t mask);
 void bl_set_gpio_intmod(uint8_t gpioPin, uint8_t intCtrlMod, uint8_t intTrgMod);
 void bl_gpio_register(gpio_ctx_t *pstnode);
 
+/* port access, bit n of the value is GPIOn */
+uint32_t bl_gpio_port_input_get(void);
+uint32_t bl_gpio_port_output_get(void);
+void bl_gpio_port_output_set(uint32_t mask, uint32_t value);
+void bl_gpio_port_output_toggle(uint32_t mask);
+
+/* interrupt demux, time_us is sampled once on entry of the GPIO interrupt */
+typedef void (*bl_gpio_irq_cb_t)(uint8_t pin, uint32_t time_us, void *arg);
+
+int bl_gpio_irq_attach(uint8_t pin, uint8_t intCtrlMod, uint8_t intTrgMod,
+        uint32_t debounce_us, bl_gpio_irq_cb_t cb, void *arg);
+int bl_gpio_irq_detach(uint8_t pin);
+uint32_t bl_gpio_irq_bounce_count(uint8_t pin);
+
 #endif
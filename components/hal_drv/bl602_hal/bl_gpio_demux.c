@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <string.h>
+
+#include "bl_gpio_demux.h"
+
+void bl_gpio_demux_attach(bl_gpio_demux_t *demux, uint8_t pin, uint32_t debounce_us,
+        bl_gpio_irq_cb_t cb, void *arg)
+{
+    bl_gpio_demux_slot_t *slot = &demux->slot[pin];
+
+    slot->legacy = NULL;
+    slot->cb = cb;
+    slot->arg = arg;
+    slot->debounce_us = debounce_us;
+    slot->armed = 0;
+    slot->bounce = 0;
+    demux->attached |= (1U << pin);
+    demux->cb_pins |= (1U << pin);
+}
+
+void bl_gpio_demux_register(bl_gpio_demux_t *demux, gpio_ctx_t *pstnode)
+{
+    bl_gpio_demux_slot_t *slot = &demux->slot[pstnode->gpioPin];
+
+    slot->legacy = pstnode;
+    slot->cb = NULL;
+    demux->attached |= (1U << pstnode->gpioPin);
+    demux->cb_pins &= ~(1U << pstnode->gpioPin);
+}
+
+void bl_gpio_demux_detach(bl_gpio_demux_t *demux, uint8_t pin)
+{
+    demux->attached &= ~(1U << pin);
+    demux->cb_pins &= ~(1U << pin);
+    memset(&demux->slot[pin], 0, sizeof(demux->slot[pin]));
+}
+
+/* return 1 when the edge at now_us passes the debounce window */
+static int demux_debounce(bl_gpio_demux_slot_t *slot, uint32_t now_us)
+{
+    /* modulo 2^32, right across a wrap of the us counter */
+    if (slot->debounce_us && slot->armed &&
+            (uint32_t)(now_us - slot->last_us) < slot->debounce_us) {
+        slot->bounce++;
+        return 0;
+    }
+    slot->last_us = now_us;
+    slot->armed = 1;
+    return 1;
+}
+
+void bl_gpio_demux_dispatch(bl_gpio_demux_t *demux, uint32_t pending, uint32_t now_us)
+{
+    bl_gpio_demux_slot_t *slot;
+    gpio_ctx_t *pstnode;
+    uint8_t pin;
+
+    pending &= demux->attached;
+    while (pending) {
+        pin = __builtin_ctz(pending);
+        pending &= pending - 1;
+        slot = &demux->slot[pin];
+
+        if (slot->cb) {
+            if (demux_debounce(slot, now_us)) {
+                slot->cb(pin, now_us, slot->arg);
+            }
+            continue;
+        }
+        for (pstnode = slot->legacy; pstnode; pstnode = pstnode->next) {
+            if (pstnode->gpioPin == pin && pstnode->gpio_handler) {
+                pstnode->gpio_handler(pstnode);
+            }
+        }
+    }
+}
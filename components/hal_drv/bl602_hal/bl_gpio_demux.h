@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_GPIO_DEMUX_H__
+#define __BL_GPIO_DEMUX_H__
+#include <stdint.h>
+
+#include "bl_gpio.h"
+
+#define BL_GPIO_DEMUX_PINS      32
+
+/*
+ * Per pin table behind the GPIO interrupt entry, free of any hardware so
+ * that the host tests can drive it. bl_gpio.c reads the pending bits,
+ * clears the callback pins and masks the legacy pins, then dispatches.
+ *
+ * Pins registered with bl_gpio_register() call every gpio_ctx_t of that pin,
+ * the handler unmasks it. Pins attached with bl_gpio_irq_attach() call their
+ * callback; with debounce_us set, an edge within debounce_us of the last
+ * accepted edge of the pin is dropped and counted as a bounce, so no timer
+ * is needed per pin. The first edge after attaching is always accepted.
+ */
+typedef struct bl_gpio_demux_slot {
+    gpio_ctx_t *legacy;
+    bl_gpio_irq_cb_t cb;
+    void *arg;
+    uint32_t debounce_us;
+    uint32_t last_us;
+    uint32_t bounce;
+    uint8_t armed;
+} bl_gpio_demux_slot_t;
+
+typedef struct bl_gpio_demux {
+    bl_gpio_demux_slot_t slot[BL_GPIO_DEMUX_PINS];
+    uint32_t attached;          /* pins served at all */
+    uint32_t cb_pins;           /* pins served by a callback */
+} bl_gpio_demux_t;
+
+void bl_gpio_demux_attach(bl_gpio_demux_t *demux, uint8_t pin, uint32_t debounce_us,
+        bl_gpio_irq_cb_t cb, void *arg);
+/* pstnode is the head of the chain, older nodes of the pin follow it */
+void bl_gpio_demux_register(bl_gpio_demux_t *demux, gpio_ctx_t *pstnode);
+void bl_gpio_demux_detach(bl_gpio_demux_t *demux, uint8_t pin);
+
+/*
+ * Run the pins of pending from the lowest up, all with the same now_us.
+ * Pins nothing is attached to are ignored.
+ */
+void bl_gpio_demux_dispatch(bl_gpio_demux_t *demux, uint32_t pending, uint32_t now_us);
+#endif
@@ -36,6 +36,12 @@
 #include <blog.h>
 #include "bl_irq.h"
 #include "bl_sys.h"
+#ifdef CFG_COREDUMP
+#include "bl_coredump.h"
+#endif
+#ifdef CFG_CPU_PROFILE
+#include "bl_cpu_prof.h"
+#endif
 #include <panic.h>
 
 void bl_irq_enable(unsigned int source)
@@ -179,12 +185,18 @@ void interrupt_entry(uint32_t mcause)
         handler = handler_list[0][mcause];
     }
     if (handler) {
+#ifdef CFG_CPU_PROFILE
+        uint32_t start = bl_cpu_prof_irq_enter();
+#endif
         if (handler_list[1][mcause]) {
            ((void (*)(void *))handler)(handler_list[1][mcause]);//handler(ctx)
         }
         else {
             ((void (*)(void))handler)();
         }
+#ifdef CFG_CPU_PROFILE
+        bl_cpu_prof_irq_exit(mcause, start);
+#endif
     } else {
         printf("Cannot handle mcause 0x%lx:%lu, adjust to externel(0x%lx:%lu)\r\n",
                 mcause,
@@ -334,6 +346,9 @@ void exception_entry(uint32_t mcause, uint32_t mepc, uint32_t mtval, uintptr_t *
             mtval
         );
         __dump_exception_code_str(mcause & 0xFFFF);
+#ifdef CFG_COREDUMP
+        bl_coredump_fault(mcause, mepc, mtval, regs);
+#endif
 #ifdef REBOOT_ON_EXCEPTION
         bl_sys_reset_system();
 #else
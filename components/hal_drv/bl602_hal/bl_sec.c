@@ -28,12 +28,15 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <stdio.h>
+#include <string.h>
 
 #include <sec_eng_reg.h>
 #include <bl602_sec_eng.h>
 #include <aos/kernel.h>
+#include <task.h>
 
 #include "bl_sec.h"
+#include "bl_sec_drbg.h"
 #include "bl_irq.h"
 
 #include <blog.h>
@@ -47,8 +50,32 @@
 
 #define TRNG_SIZE_IN_WORD (8)
 #define TRNG_SIZE_IN_BYTES (32)
+#define TRNG_POOL_WORDS     (64)        /* eight samples, refilled by the TRNG interrupt */
+#define TRNG_FAIL_MAX       (3)         /* consecutive unhealthy samples before giving up */
+#define SEC_RAND_WORDS      (16)        /* DRBG output shared by bl_rand callers */
+#define SEC_AES_CHUNK_BLOCKS (16)
+
 static uint32_t trng_buffer[TRNG_SIZE_IN_WORD];
-static unsigned int trng_idx = 0;
+
+/* touched by the TRNG interrupt, tasks use it in a critical section */
+static struct {
+    uint32_t words[TRNG_POOL_WORDS];
+    uint16_t head;
+    uint16_t count;
+    uint8_t pending;                    /* a sample is being generated */
+    uint8_t fail_run;
+    uint8_t failed;
+    bl_trng_health_t health;
+} trng_pool;
+
+static bl_drbg_t sec_drbg;
+static StaticSemaphore_t drbg_mutex_buf;
+static SemaphoreHandle_t drbg_mutex;
+static bl_sec_rand_stats_t sec_rand_stats;
+
+/* generation << 8 | next word, claimed lock-free by bl_sec_get_random_word */
+static uint32_t sec_rand_cursor = SEC_RAND_WORDS;
+static uint32_t sec_rand_words[SEC_RAND_WORDS];
 
 static StaticSemaphore_t sha_mutex_buf;
 SemaphoreHandle_t g_bl_sec_sha_mutex = NULL;
@@ -59,7 +86,7 @@ static inline void _trng_trigger()
     uint32_t val;
 
     val = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0);
-    if (BL_IS_REG_BIT_SET(val, SEC_ENG_SE_TRNG_BUSY)) {
+    if (trng_pool.pending || BL_IS_REG_BIT_SET(val, SEC_ENG_SE_TRNG_BUSY)) {
         return;
     }
     BL_WR_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_1, trng_buffer[0]);
@@ -69,26 +96,20 @@ static inline void _trng_trigger()
     val = BL_SET_REG_BIT(val, SEC_ENG_SE_TRNG_EN);
     val = BL_SET_REG_BIT(val, SEC_ENG_SE_TRNG_TRIG_1T);
 
+    trng_pool.pending = 1;
     BL_WR_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0, val);
 }
 
-static inline void wait_trng4feed()
+static void trng_read_sample(void)
 {
     uint32_t TRNGx = SEC_ENG_BASE + SEC_ENG_TRNG_OFFSET;
     uint32_t val;
 
     val = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0);
-
-    while (BL_IS_REG_BIT_SET(val, SEC_ENG_SE_TRNG_BUSY)) {
-        /*wait until trng is NOT busy*/
-        val = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0);
-    }
-
     val = BL_SET_REG_BIT(val, SEC_ENG_SE_TRNG_INT_CLR_1T);
     val = BL_CLR_REG_BIT(val, SEC_ENG_SE_TRNG_TRIG_1T);
     BL_WR_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0, val);
 
-    blog_debug("Feed random number is %08lx\r\n", trng_buffer[0]);
     trng_buffer[0] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_0);
     trng_buffer[1] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_1);
     trng_buffer[2] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_2);
@@ -97,45 +118,256 @@ static inline void wait_trng4feed()
     trng_buffer[5] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_5);
     trng_buffer[6] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_6);
     trng_buffer[7] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_7);
+    trng_pool.pending = 0;
 }
 
-uint32_t bl_sec_get_random_word(void)
+static inline void wait_trng4feed()
 {
-    trng_idx = (trng_idx & 0x7);
-    if (0 == trng_idx) {
-        _trng_trigger();
+    uint32_t TRNGx = SEC_ENG_BASE + SEC_ENG_TRNG_OFFSET;
+    uint32_t val;
+
+    val = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0);
+
+    while (BL_IS_REG_BIT_SET(val, SEC_ENG_SE_TRNG_BUSY)) {
+        /*wait until trng is NOT busy*/
+        val = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0);
     }
-    return trng_buffer[trng_idx++];
+    trng_read_sample();
 }
 
-void bl_rand_stream(uint8_t *buf, int len)
+/* health test the sample just read and queue it, interrupts must be masked */
+static void trng_sample_accept(void)
 {
-    int pos, copysize;
+    int i;
 
-    pos = 0;
-    if (trng_idx) {
-        /*reset trng_buffer*/
-        _trng_trigger();
-        wait_trng4feed();
-        trng_idx = 0;
+    sec_rand_stats.trng_samples++;
+    if (bl_trng_health_check(&trng_pool.health, (const uint8_t*)trng_buffer, TRNG_SIZE_IN_BYTES)) {
+        sec_rand_stats.health_failures++;
+        if (++trng_pool.fail_run >= TRNG_FAIL_MAX && !trng_pool.failed) {
+            trng_pool.failed = 1;
+            puts("[BL] [SEC] TRNG failed health tests\r\n");
+        }
+        return;
+    }
+    trng_pool.fail_run = 0;
+    for (i = 0; i < TRNG_SIZE_IN_WORD && trng_pool.count < TRNG_POOL_WORDS; i++) {
+        trng_pool.words[(trng_pool.head + trng_pool.count) % TRNG_POOL_WORDS] = trng_buffer[i];
+        trng_pool.count++;
     }
+}
 
-    while (len > 0) {
-        if (trng_idx) {
-            /*reset trng_buffer*/
+/* take raw entropy words, generating samples in place if the pool ran dry.
+ * Interrupts do not nest, so bl_sec_get_random_word from one needs no
+ * critical section.
+ */
+static int trng_pool_take(uint32_t *out, int words)
+{
+    int in_isr = xPortIsInsideInterrupt();
+    int got = 0;
+
+    if (!in_isr) {
+        taskENTER_CRITICAL();
+    }
+    while (got < words && !trng_pool.failed) {
+        if (0 == trng_pool.count) {
             _trng_trigger();
             wait_trng4feed();
-            trng_idx = 0;
+            trng_sample_accept();
+            continue;
+        }
+        out[got++] = trng_pool.words[trng_pool.head];
+        trng_pool.words[trng_pool.head] = 0;
+        trng_pool.head = (trng_pool.head + 1) % TRNG_POOL_WORDS;
+        trng_pool.count--;
+    }
+    if (!trng_pool.failed) {
+        /* refilled in the background by sec_trng_IRQHandler */
+        _trng_trigger();
+    }
+    if (!in_isr) {
+        taskEXIT_CRITICAL();
+    }
+
+    return (got == words) ? 0 : -1;
+}
+
+/* AES-128-CTR keystream of the SEC engine, the DRBG block backend */
+static int sec_drbg_block(const uint8_t *key, const uint8_t *ctr, uint8_t *out, uint32_t blocks)
+{
+    static uint32_t zero[SEC_AES_CHUNK_BLOCKS * 4];
+    static uint32_t bounce[SEC_AES_CHUNK_BLOCKS * 4];
+    SEC_Eng_AES_Link_Config_Type linkCfg = {
+        .aesMode = SEC_ENG_AES_KEY_128BITS,
+        .aesDecEn = SEC_ENG_AES_ENCRYPTION,
+        .aesDecKeySel = SEC_ENG_AES_USE_NEW,
+        .aesBlockMode = SEC_ENG_AES_CTR,
+        .aesIVSel = SEC_ENG_AES_USE_NEW,
+    };
+    uint8_t iv[16];
+    uint8_t *dst;
+    uint32_t n, low;
+    int ret = 0;
+
+    /* key and iv are stored in byte order, see Sec_Eng_AES_Link_Case_CTR_128 */
+    memcpy(&linkCfg.aesKey0, key, BL_DRBG_KEY_LEN);
+    memcpy(iv, ctr, sizeof(iv));
+    Sec_Eng_AES_Enable_BE(SEC_ENG_AES_ID0);
+    Sec_Eng_AES_Enable_Link(SEC_ENG_AES_ID0);
+    while (blocks) {
+        n = blocks > SEC_AES_CHUNK_BLOCKS ? SEC_AES_CHUNK_BLOCKS : blocks;
+        dst = ((uint32_t)out & 3) ? (uint8_t*)bounce : out;
+        memcpy(&linkCfg.aesIV0, iv, sizeof(iv));
+        if (SUCCESS != Sec_Eng_AES_Link_Work(SEC_ENG_AES_ID0, (uint32_t)&linkCfg, (uint8_t*)zero, n * 16, dst)) {
+            ret = -1;
+            break;
+        }
+        if (dst != out) {
+            memcpy(out, dst, n * 16);
+        }
+        low = ((uint32_t)iv[12] << 24 | (uint32_t)iv[13] << 16 | (uint32_t)iv[14] << 8 | iv[15]) + n;
+        iv[12] = low >> 24;
+        iv[13] = low >> 16;
+        iv[14] = low >> 8;
+        iv[15] = low;
+        out += n * 16;
+        blocks -= n;
+    }
+    Sec_Eng_AES_Disable_Link(SEC_ENG_AES_ID0);
+    memset(&linkCfg, 0, sizeof(linkCfg));
+    memset(bounce, 0, sizeof(bounce));
+
+    return ret;
+}
+
+/* the DRBG may be used by tasks and before the scheduler starts, not from
+ * interrupts or while the scheduler is suspended */
+static int sec_drbg_lock(void)
+{
+    BaseType_t state;
+
+    if (xPortIsInsideInterrupt()) {
+        return -1;
+    }
+    state = xTaskGetSchedulerState();
+    if (taskSCHEDULER_SUSPENDED == state) {
+        return -1;
+    }
+    if (taskSCHEDULER_RUNNING == state) {
+        xSemaphoreTake(drbg_mutex, portMAX_DELAY);
+    }
+    return 0;
+}
+
+static void sec_drbg_unlock(void)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()) {
+        xSemaphoreGive(drbg_mutex);
+    }
+}
+
+/* called with the DRBG locked */
+static int sec_drbg_generate(uint8_t *buf, int len)
+{
+    uint32_t seed[BL_DRBG_SEED_LEN / 4];
+    int chunk, ret;
+
+    while (len > 0) {
+        if (bl_drbg_reseed_required(&sec_drbg)) {
+            if (trng_pool_take(seed, BL_DRBG_SEED_LEN / 4)) {
+                /* no healthy entropy, the state is not used past its interval */
+                sec_rand_stats.reseed_failures++;
+                return -1;
+            }
+            ret = (NULL == sec_drbg.block) ?
+                bl_drbg_instantiate(&sec_drbg, sec_drbg_block, (uint8_t*)seed, NULL, 0) :
+                bl_drbg_reseed(&sec_drbg, (uint8_t*)seed, NULL, 0);
+            memset(seed, 0, sizeof(seed));
+            if (ret) {
+                return -1;
+            }
+            sec_rand_stats.reseeds++;
+        }
+        chunk = len > BL_DRBG_MAX_REQUEST ? BL_DRBG_MAX_REQUEST : len;
+        if (bl_drbg_generate(&sec_drbg, buf, chunk, NULL, 0)) {
+            return -1;
+        }
+        buf += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/* 0 once unclaimed words are available, -1 if the DRBG can not be used */
+static int sec_rand_refill(void)
+{
+    uint32_t cursor;
+    int ret = 0;
+
+    if (sec_drbg_lock()) {
+        return -1;
+    }
+    cursor = __atomic_load_n(&sec_rand_cursor, __ATOMIC_ACQUIRE);
+    /* another caller may have refilled while we waited */
+    if ((cursor & 0xFF) >= SEC_RAND_WORDS) {
+        ret = sec_drbg_generate((uint8_t*)sec_rand_words, sizeof(sec_rand_words));
+        if (0 == ret) {
+            __atomic_store_n(&sec_rand_cursor, ((cursor >> 8) + 1) << 8, __ATOMIC_RELEASE);
+            sec_rand_stats.refills++;
         }
+    }
+    sec_drbg_unlock();
+
+    return ret;
+}
+
+uint32_t bl_sec_get_random_word(void)
+{
+    uint32_t cursor, word;
+    int ret;
+
+    do {
+        cursor = __atomic_load_n(&sec_rand_cursor, __ATOMIC_ACQUIRE);
+        while ((cursor & 0xFF) < SEC_RAND_WORDS) {
+            /* the word is only ours if nobody claimed it or refilled meanwhile */
+            word = __atomic_load_n(&sec_rand_words[cursor & 0xFF], __ATOMIC_RELAXED);
+            if (__atomic_compare_exchange_n(&sec_rand_cursor, &cursor, cursor + 1,
+                        0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return word;
+            }
+        }
+    } while (0 == sec_rand_refill());
+
+    /* interrupt context, scheduler suspended or DRBG failure */
+    sec_rand_stats.raw_fallbacks++;
+    ret = trng_pool_take(&word, 1);
+    /* the TRNG failed its health tests for good, there is no random word to give */
+    configASSERT(0 == ret);
+    return word;
+}
+
+void bl_rand_stream(uint8_t *buf, int len)
+{
+    uint32_t words[TRNG_SIZE_IN_WORD];
+    int ret = -1, copysize;
+
+    if (0 == sec_drbg_lock()) {
+        ret = sec_drbg_generate(buf, len);
+        sec_drbg_unlock();
+    }
+    if (0 == ret) {
+        return;
+    }
+
+    sec_rand_stats.raw_fallbacks++;
+    while (len > 0) {
         copysize = len > TRNG_SIZE_IN_BYTES ? TRNG_SIZE_IN_BYTES : len;
-        memcpy(buf + pos, trng_buffer, copysize);
-        pos += copysize;
+        ret = trng_pool_take(words, (copysize + 3) / 4);
+        configASSERT(0 == ret);
+        memcpy(buf, words, copysize);
+        buf += copysize;
         len -= copysize;
-        trng_idx = TRNG_SIZE_IN_BYTES - 1;
     }
-    _trng_trigger();
-    wait_trng4feed();
-    trng_idx = 0;
+    memset(words, 0, sizeof(words));
 }
 
 int bl_rand()
@@ -154,41 +386,42 @@ int bl_rand()
     return val;
 }
 
-void sec_trng_IRQHandler(void)
+void bl_sec_rand_stats_get(bl_sec_rand_stats_t *stats)
 {
-    uint32_t TRNGx = SEC_ENG_BASE + SEC_ENG_TRNG_OFFSET;
-    uint32_t val;
+    taskENTER_CRITICAL();
+    *stats = sec_rand_stats;
+    stats->pool_words = trng_pool.count;
+    stats->rct_failures = trng_pool.health.rct_failures;
+    stats->apt_failures = trng_pool.health.apt_failures;
+    stats->trng_failed = trng_pool.failed;
+    taskEXIT_CRITICAL();
+}
 
-    if (aos_now_ms() < 1000 * 2) {
-        /*debug when boot*/
-        puts("[BL] [SEC] TRNG Handler\r\n");
+void sec_trng_IRQHandler(void)
+{
+    /* the sample may already have been taken by trng_pool_take */
+    if (!trng_pool.pending) {
+        return;
+    }
+    trng_read_sample();
+    trng_sample_accept();
+    if (trng_pool.count < TRNG_POOL_WORDS && !trng_pool.failed) {
+        _trng_trigger();
     }
-    val = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0);
-    val = BL_SET_REG_BIT(val, SEC_ENG_SE_TRNG_INT_CLR_1T);
-    val = BL_CLR_REG_BIT(val, SEC_ENG_SE_TRNG_TRIG_1T);
-    BL_WR_REG(TRNGx, SEC_ENG_SE_TRNG_CTRL_0, val);
-
-    blog_debug("random number is %08lx\r\n", trng_buffer[0]);
-    trng_buffer[0] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_0);
-    trng_buffer[1] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_1);
-    trng_buffer[2] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_2);
-    trng_buffer[3] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_3);
-    trng_buffer[4] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_4);
-    trng_buffer[5] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_5);
-    trng_buffer[6] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_6);
-    trng_buffer[7] = BL_RD_REG(TRNGx, SEC_ENG_SE_TRNG_DOUT_7);
 }
 
 int bl_sec_init(void)
 {
     g_bl_sec_sha_mutex = xSemaphoreCreateMutexStatic(&sha_mutex_buf);
-    _trng_trigger();
-    wait_trng4feed();
-    /*Trigger again*/
+    bl_sec_sha_init();
+    drbg_mutex = xSemaphoreCreateMutexStatic(&drbg_mutex_buf);
+    bl_trng_health_init(&trng_pool.health);
+    /*first sample only seeds CTRL_1/CTRL_2 of the next one*/
     _trng_trigger();
     wait_trng4feed();
     bl_irq_register(SEC_TRNG_IRQn, sec_trng_IRQHandler);
     bl_irq_enable(SEC_TRNG_IRQn);
+    _trng_trigger();
 
     return 0;
 }
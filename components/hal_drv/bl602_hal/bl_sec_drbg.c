@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include "bl_sec_drbg.h"
+
+/* kept free of OS and register access so it can be checked on a host */
+
+static void drbg_ctr_add(uint8_t *v, uint32_t n)
+{
+    uint32_t ctr;
+
+    ctr = ((uint32_t)v[12] << 24) | ((uint32_t)v[13] << 16) | ((uint32_t)v[14] << 8) | v[15];
+    ctr += n;
+    v[12] = ctr >> 24;
+    v[13] = ctr >> 16;
+    v[14] = ctr >> 8;
+    v[15] = ctr;
+}
+
+/* out = E(K, V + 1) .. E(K, V + blocks), V is left on the last counter used */
+static int drbg_keystream(bl_drbg_t *drbg, uint8_t *out, uint32_t blocks)
+{
+    uint8_t ctr[BL_DRBG_BLOCK_LEN];
+    uint32_t n, room;
+
+    while (blocks) {
+        memcpy(ctr, drbg->v, sizeof(ctr));
+        drbg_ctr_add(ctr, 1);
+        /* split the run where the counter word wraps */
+        room = 0 - (((uint32_t)ctr[12] << 24) | ((uint32_t)ctr[13] << 16) | ((uint32_t)ctr[14] << 8) | ctr[15]);
+        n = (room && blocks > room) ? room : blocks;
+        if (drbg->block(drbg->key, ctr, out, n)) {
+            return -1;
+        }
+        drbg_ctr_add(drbg->v, n);
+        out += n * BL_DRBG_BLOCK_LEN;
+        blocks -= n;
+    }
+    return 0;
+}
+
+static int drbg_update(bl_drbg_t *drbg, const uint8_t *provided)
+{
+    uint8_t temp[BL_DRBG_SEED_LEN];
+    int i;
+
+    if (drbg_keystream(drbg, temp, BL_DRBG_SEED_LEN / BL_DRBG_BLOCK_LEN)) {
+        return -1;
+    }
+    for (i = 0; i < BL_DRBG_SEED_LEN; i++) {
+        temp[i] ^= provided[i];
+    }
+    memcpy(drbg->key, temp, BL_DRBG_KEY_LEN);
+    memcpy(drbg->v, temp + BL_DRBG_KEY_LEN, BL_DRBG_BLOCK_LEN);
+    memset(temp, 0, sizeof(temp));
+    return 0;
+}
+
+/* without a derivation function the input is zero padded to the seed length */
+static int drbg_seed_material(uint8_t *seed, const uint8_t *entropy, const uint8_t *data, int len)
+{
+    int i;
+
+    if (len < 0 || len > BL_DRBG_SEED_LEN || (len && NULL == data)) {
+        return -1;
+    }
+    memset(seed, 0, BL_DRBG_SEED_LEN);
+    if (len) {
+        memcpy(seed, data, len);
+    }
+    if (entropy) {
+        for (i = 0; i < BL_DRBG_SEED_LEN; i++) {
+            seed[i] ^= entropy[i];
+        }
+    }
+    return 0;
+}
+
+/**
+ * Instantiate from BL_DRBG_SEED_LEN bytes of full entropy.
+ *
+ * @return 0 on success, -1 on bad arguments or a backend error
+ */
+int bl_drbg_instantiate(bl_drbg_t *drbg, bl_drbg_block_fn_t block, const uint8_t *entropy,
+        const uint8_t *pers, int pers_len)
+{
+    uint8_t seed[BL_DRBG_SEED_LEN];
+    int ret;
+
+    if (NULL == block || NULL == entropy || drbg_seed_material(seed, entropy, pers, pers_len)) {
+        return -1;
+    }
+    memset(drbg, 0, sizeof(*drbg));
+    drbg->block = block;
+    ret = drbg_update(drbg, seed);
+    memset(seed, 0, sizeof(seed));
+    if (ret) {
+        bl_drbg_free(drbg);
+        return -1;
+    }
+    drbg->reseed_counter = 1;
+    return 0;
+}
+
+int bl_drbg_reseed(bl_drbg_t *drbg, const uint8_t *entropy, const uint8_t *add, int add_len)
+{
+    uint8_t seed[BL_DRBG_SEED_LEN];
+    int ret;
+
+    if (NULL == drbg->block || NULL == entropy || drbg_seed_material(seed, entropy, add, add_len)) {
+        return -1;
+    }
+    ret = drbg_update(drbg, seed);
+    memset(seed, 0, sizeof(seed));
+    if (ret) {
+        return -1;
+    }
+    drbg->reseed_counter = 1;
+    return 0;
+}
+
+/**
+ * Generate up to BL_DRBG_MAX_REQUEST bytes.
+ *
+ * @return 0 on success, -1 on bad arguments, a backend error or when a
+ *         reseed is required first
+ */
+int bl_drbg_generate(bl_drbg_t *drbg, uint8_t *out, int len, const uint8_t *add, int add_len)
+{
+    uint8_t seed[BL_DRBG_SEED_LEN];
+    uint8_t last[BL_DRBG_BLOCK_LEN];
+    int full, ret = -1;
+
+    if (NULL == drbg->block || len < 0 || len > BL_DRBG_MAX_REQUEST || bl_drbg_reseed_required(drbg) ||
+            drbg_seed_material(seed, NULL, add, add_len)) {
+        return -1;
+    }
+    if (add_len && drbg_update(drbg, seed)) {
+        goto out;
+    }
+
+    full = len / BL_DRBG_BLOCK_LEN;
+    if (full && drbg_keystream(drbg, out, full)) {
+        goto out;
+    }
+    if (len % BL_DRBG_BLOCK_LEN) {
+        if (drbg_keystream(drbg, last, 1)) {
+            goto out;
+        }
+        memcpy(out + full * BL_DRBG_BLOCK_LEN, last, len % BL_DRBG_BLOCK_LEN);
+        memset(last, 0, sizeof(last));
+    }
+
+    if (drbg_update(drbg, seed)) {
+        goto out;
+    }
+    drbg->reseed_counter++;
+    ret = 0;
+
+out:
+    memset(seed, 0, sizeof(seed));
+    return ret;
+}
+
+int bl_drbg_reseed_required(const bl_drbg_t *drbg)
+{
+    return (0 == drbg->reseed_counter || drbg->reseed_counter > BL_DRBG_RESEED_INTERVAL);
+}
+
+void bl_drbg_free(bl_drbg_t *drbg)
+{
+    memset(drbg, 0, sizeof(*drbg));
+}
+
+void bl_trng_health_init(bl_trng_health_t *health)
+{
+    memset(health, 0, sizeof(*health));
+}
+
+/**
+ * Run the repetition count and adaptive proportion tests over buf. The
+ * tests keep their state across calls.
+ *
+ * @return 0 if both passed, -1 if any of them failed within buf
+ */
+int bl_trng_health_check(bl_trng_health_t *health, const uint8_t *buf, int len)
+{
+    int i, ret = 0;
+
+    for (i = 0; i < len; i++) {
+        if (health->rct_count && buf[i] == health->rct_value) {
+            if (++health->rct_count >= BL_TRNG_RCT_CUTOFF) {
+                health->rct_failures++;
+                health->rct_count = 1;
+                ret = -1;
+            }
+        } else {
+            health->rct_value = buf[i];
+            health->rct_count = 1;
+        }
+
+        if (0 == health->apt_seen) {
+            health->apt_value = buf[i];
+            health->apt_count = 1;
+        } else if (buf[i] == health->apt_value) {
+            if (++health->apt_count >= BL_TRNG_APT_CUTOFF) {
+                health->apt_failures++;
+                /* start over with the next sample */
+                health->apt_seen = 0;
+                ret = -1;
+                continue;
+            }
+        }
+        if (++health->apt_seen >= BL_TRNG_APT_WINDOW) {
+            health->apt_seen = 0;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_SEC_DRBG_H__
+#define __BL_SEC_DRBG_H__
+#include <stdint.h>
+
+/* CTR_DRBG of SP 800-90A with AES-128, no derivation function, 32 bit counter */
+#define BL_DRBG_KEY_LEN             16
+#define BL_DRBG_BLOCK_LEN           16
+#define BL_DRBG_SEED_LEN            (BL_DRBG_KEY_LEN + BL_DRBG_BLOCK_LEN)
+#define BL_DRBG_MAX_REQUEST         (1 << 16)   /* bytes per generate */
+#ifndef BL_DRBG_RESEED_INTERVAL
+#define BL_DRBG_RESEED_INTERVAL     (1 << 12)   /* generates between reseeds */
+#endif
+
+/* SP 800-90B continuous health tests on byte samples, cutoffs for an assessed
+ * min-entropy of 4 bits per byte and a false positive rate of 2^-20 */
+#define BL_TRNG_RCT_CUTOFF          6
+#define BL_TRNG_APT_WINDOW          512
+#define BL_TRNG_APT_CUTOFF          62
+
+/**
+ * Block cipher backend: write E(key, ctr), E(key, ctr + 1), ... to out, the
+ * counter being the big endian last word of ctr. The DRBG never asks for a
+ * run that wraps that word, so any counter width of the backend gives the
+ * same output.
+ *
+ * @return 0 on success
+ */
+typedef int (*bl_drbg_block_fn_t)(const uint8_t *key, const uint8_t *ctr, uint8_t *out, uint32_t blocks);
+
+typedef struct bl_drbg {
+    uint8_t key[BL_DRBG_KEY_LEN];
+    uint8_t v[BL_DRBG_BLOCK_LEN];
+    uint32_t reseed_counter;
+    bl_drbg_block_fn_t block;
+} bl_drbg_t;
+
+typedef struct bl_trng_health {
+    uint8_t rct_value;
+    uint8_t apt_value;
+    uint16_t rct_count;
+    uint16_t apt_count;
+    uint16_t apt_seen;              /* samples of the current window */
+    uint32_t rct_failures;
+    uint32_t apt_failures;
+} bl_trng_health_t;
+
+int bl_drbg_instantiate(bl_drbg_t *drbg, bl_drbg_block_fn_t block, const uint8_t *entropy,
+        const uint8_t *pers, int pers_len);
+int bl_drbg_reseed(bl_drbg_t *drbg, const uint8_t *entropy, const uint8_t *add, int add_len);
+int bl_drbg_generate(bl_drbg_t *drbg, uint8_t *out, int len, const uint8_t *add, int add_len);
+int bl_drbg_reseed_required(const bl_drbg_t *drbg);
+void bl_drbg_free(bl_drbg_t *drbg);
+
+void bl_trng_health_init(bl_trng_health_t *health);
+int bl_trng_health_check(bl_trng_health_t *health, const uint8_t *buf, int len);
+#endif
@@ -28,14 +28,17 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <stdio.h>
+#include <string.h>
 
 #include <bl602_sec_eng.h>
 
 #include <FreeRTOS.h>
 #include <semphr.h>
+#include <task.h>
 
 #include "bl_irq.h"
 #include "bl_sec.h"
+#include "bl_sec_sha_engine.h"
 
 #include <blog.h>
 
@@ -66,22 +69,98 @@ int bl_sha_mutex_give()
     return 0;
 }
 
-void bl_sha_init(bl_sha_ctx_t *ctx, const bl_sha_type_t type)
+static StaticSemaphore_t sha_engine_mutex_buf;
+static SemaphoreHandle_t sha_engine_mutex;
+
+_Static_assert(sizeof(_bl_sha_SEC_Eng_SHA256_Link_Ctx_t) == sizeof(SEC_Eng_SHA256_Link_Ctx), "link ctx");
+_Static_assert(sizeof(_bl_sha_SEC_Eng_SHA_Link_Config_t) == sizeof(SEC_Eng_SHA_Link_Config_Type), "link cfg");
+
+void bl_sec_sha_init(void)
+{
+    sha_engine_mutex = xSemaphoreCreateMutexStatic(&sha_engine_mutex_buf);
+}
+
+/**
+ * Take the engine for one chunk.
+ *
+ * @return 0 if the engine is ours, -1 if it is busy and wait is 0 or
+ *         waiting is not possible in this context
+ */
+int bl_sha_engine_lock(int wait)
 {
-    const SEC_ENG_SHA_Type sha_type = (SEC_ENG_SHA_Type) type; // bl_sha_type_t is the same as SEC_ENG_SHA_Type in driver
+    BaseType_t state = xTaskGetSchedulerState();
 
-    Sec_Eng_SHA256_Init((SEC_Eng_SHA256_Ctx *)&ctx->sha_ctx, BL_SHA_ID, sha_type, ctx->tmp, ctx->pad);
-    Sec_Eng_SHA_Start(BL_SHA_ID);
+    if (taskSCHEDULER_NOT_STARTED == state) {
+        return 0;
+    }
+    if (xPortIsInsideInterrupt()) {
+        return -1;
+    }
+    if (taskSCHEDULER_SUSPENDED == state) {
+        wait = 0;
+    }
+    if (pdPASS != xSemaphoreTake(sha_engine_mutex, wait ? portMAX_DELAY : 0)) {
+        return -1;
+    }
+    return 0;
 }
 
-int bl_sha_update(bl_sha_ctx_t *ctx, const uint8_t *input, uint32_t len)
+void bl_sha_engine_unlock(void)
 {
-    return Sec_Eng_SHA256_Update((SEC_Eng_SHA256_Ctx *)&ctx->sha_ctx, BL_SHA_ID, input, len);
+    if (taskSCHEDULER_NOT_STARTED != xTaskGetSchedulerState()) {
+        xSemaphoreGive(sha_engine_mutex);
+    }
 }
 
-int bl_sha_finish(bl_sha_ctx_t *ctx, uint8_t *hash)
+/* link context setup only touches memory, no lock needed */
+void bl_sha_engine_start(bl_sha_ctx_t *ctx)
 {
-    return Sec_Eng_SHA256_Finish((SEC_Eng_SHA256_Ctx *)&ctx->sha_ctx, BL_SHA_ID, hash);
+    SEC_Eng_SHA_Link_Config_Type *linkCfg = (SEC_Eng_SHA_Link_Config_Type *)&ctx->u.hw.linkCfg;
+
+    memset(linkCfg, 0, sizeof(*linkCfg));
+    linkCfg->shaMode = ctx->type;  // bl_sha_type_t is the same as SEC_ENG_SHA_Type in driver
+    Sec_Eng_SHA256_Link_Init((SEC_Eng_SHA256_Link_Ctx *)&ctx->u.hw.ctx, BL_SHA_ID,
+            (uint32_t)linkCfg, ctx->u.hw.tmp, ctx->u.hw.pad);
+}
+
+/* engine locked by the caller */
+int bl_sha_engine_update(bl_sha_ctx_t *ctx, const uint8_t *input, uint32_t len)
+{
+    SEC_Eng_SHA256_Link_Ctx *link = (SEC_Eng_SHA256_Link_Ctx *)&ctx->u.hw.ctx;
+    uint32_t bounce[BL_SHA_BLOCK_LEN];
+    uint32_t n;
+    int ret = SUCCESS;
+
+    Sec_Eng_SHA_Enable_Link(BL_SHA_ID);
+    if (0 == ((uint32_t)input & 3)) {
+        ret = Sec_Eng_SHA256_Link_Update(link, BL_SHA_ID, input, len);
+    } else {
+        /* the engine fetches whole blocks by DMA from word aligned addresses */
+        while (len && SUCCESS == ret) {
+            n = len > sizeof(bounce) ? sizeof(bounce) : len;
+            memcpy(bounce, input, n);
+            ret = Sec_Eng_SHA256_Link_Update(link, BL_SHA_ID, (uint8_t *)bounce, n);
+            input += n;
+            len -= n;
+        }
+    }
+    Sec_Eng_SHA_Disable_Link(BL_SHA_ID);
+
+    return (SUCCESS == ret) ? 0 : -1;
+}
+
+/* engine locked by the caller */
+int bl_sha_engine_finish(bl_sha_ctx_t *ctx, uint8_t *hash)
+{
+    uint32_t result[BL_SHA_MAX_DIGEST_LEN / 4];
+    int ret;
+
+    Sec_Eng_SHA_Enable_Link(BL_SHA_ID);
+    ret = Sec_Eng_SHA256_Link_Finish((SEC_Eng_SHA256_Link_Ctx *)&ctx->u.hw.ctx, BL_SHA_ID, (uint8_t *)result);
+    Sec_Eng_SHA_Disable_Link(BL_SHA_ID);
+    memcpy(hash, result, bl_sha_digest_len(ctx->type));
+
+    return (SUCCESS == ret) ? 0 : -1;
 }
 
 static const uint8_t shaSrcBuf1[64] =
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_SEC_SHA_H__
+#define __BL_SEC_SHA_H__
+#include <stdint.h>
+
+#include <utils_sha256.h>
+
+/* copied SEC_Eng_SHA256_Link_Ctx from stddrv */
+typedef struct {
+    uint32_t total[2];
+    uint32_t *shaBuf;
+    uint32_t *shaPadding;
+    uint32_t linkAddr;
+} _bl_sha_SEC_Eng_SHA256_Link_Ctx_t;
+
+/* copied SEC_Eng_SHA_Link_Config_Type from stddrv, bit fields folded into cfg */
+typedef struct {
+    uint32_t cfg;
+    uint32_t shaSrcAddr;
+    uint32_t result[8];
+} __attribute__ ((aligned(4))) _bl_sha_SEC_Eng_SHA_Link_Config_t;
+
+/* copied SEC_ENG_SHA_Type from stddrv, SHA1_RSVD removed */
+typedef enum {
+    BL_SHA256,
+    BL_SHA224,
+    BL_SHA1,
+} bl_sha_type_t;
+
+#define BL_SHA_BLOCK_LEN            64
+#define BL_SHA_MAX_DIGEST_LEN       32
+
+/* the whole state lives in the context, the engine is only held while a
+ * chunk is hashed. The context holds pointers to itself and must not be
+ * copied between bl_sha_init and bl_sha_finish. */
+typedef struct bl_sha_ctx {
+    union {
+        struct {
+            _bl_sha_SEC_Eng_SHA256_Link_Ctx_t ctx;
+            _bl_sha_SEC_Eng_SHA_Link_Config_t linkCfg;
+            uint32_t tmp[16];
+            uint32_t pad[16];
+        } hw;
+        iot_sha256_context sw;      /* SHA-256 started while the engine was busy */
+    } u;
+    uint8_t type;
+    uint8_t backend;
+} bl_sha_ctx_t;
+
+typedef struct bl_hmac_ctx {
+    bl_sha_ctx_t sha;
+    uint32_t opad[BL_SHA_BLOCK_LEN / 4];   /* key ^ opad, word aligned for the engine */
+} bl_hmac_ctx_t;
+
+void bl_sha_init(bl_sha_ctx_t *ctx, const bl_sha_type_t type);
+int bl_sha_update(bl_sha_ctx_t *ctx, const uint8_t *input, uint32_t len);
+int bl_sha_finish(bl_sha_ctx_t *ctx, uint8_t *hash);
+int bl_sha_digest_len(bl_sha_type_t type);
+
+int bl_hmac_init(bl_hmac_ctx_t *ctx, bl_sha_type_t type, const uint8_t *key, uint32_t key_len);
+int bl_hmac_update(bl_hmac_ctx_t *ctx, const uint8_t *input, uint32_t len);
+int bl_hmac_finish(bl_hmac_ctx_t *ctx, uint8_t *mac);
+int bl_hmac(bl_sha_type_t type, const uint8_t *key, uint32_t key_len,
+        const uint8_t *input, uint32_t len, uint8_t *mac);
+#endif
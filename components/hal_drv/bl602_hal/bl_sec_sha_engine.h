@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BL_SEC_SHA_ENGINE_H__
+#define __BL_SEC_SHA_ENGINE_H__
+#include <stdint.h>
+
+#include "bl_sec_sha.h"
+
+/* between the portable SHA streams of bl_sec_sha_stream.c and the SEC engine
+ * link mode of bl_sec_sha.c, a host build links its own engine instead */
+
+#define BL_SHA_BACKEND_NONE         0   /* nothing hashed yet */
+#define BL_SHA_BACKEND_HW           1
+#define BL_SHA_BACKEND_SW           2
+
+/* bytes hashed per engine hold, bounds how long other streams wait */
+#ifndef BL_SHA_ENGINE_CHUNK
+#define BL_SHA_ENGINE_CHUNK         4096
+#endif
+
+int bl_sha_engine_lock(int wait);
+void bl_sha_engine_unlock(void);
+void bl_sha_engine_start(bl_sha_ctx_t *ctx);
+int bl_sha_engine_update(bl_sha_ctx_t *ctx, const uint8_t *input, uint32_t len);
+int bl_sha_engine_finish(bl_sha_ctx_t *ctx, uint8_t *hash);
+#endif
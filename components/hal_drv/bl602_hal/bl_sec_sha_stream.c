@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <utils_sha256.h>
+
+#include "bl_sec_sha.h"
+#include "bl_sec_sha_engine.h"
+
+/* SHA streams over the engine link mode. Every stream keeps its state in
+ * its own context, so any number of them interleave and the engine is only
+ * held for BL_SHA_ENGINE_CHUNK bytes at a time. A SHA-256 stream that finds
+ * the engine busy before its first byte runs on utils_sha256 instead. */
+
+int bl_sha_digest_len(bl_sha_type_t type)
+{
+    switch (type) {
+        case BL_SHA256:
+            return 32;
+        case BL_SHA224:
+            return 28;
+        case BL_SHA1:
+            return 20;
+        default:
+            return 0;
+    }
+}
+
+void bl_sha_init(bl_sha_ctx_t *ctx, const bl_sha_type_t type)
+{
+    ctx->type = type;
+    ctx->backend = BL_SHA_BACKEND_NONE;
+}
+
+/* pick the backend on first use, returns with the engine locked if it is hardware */
+static int sha_backend_select(bl_sha_ctx_t *ctx)
+{
+    if (0 == bl_sha_engine_lock(0)) {
+        ctx->backend = BL_SHA_BACKEND_HW;
+        bl_sha_engine_start(ctx);
+        return 0;
+    }
+    if (BL_SHA256 == ctx->type) {
+        ctx->backend = BL_SHA_BACKEND_SW;
+        utils_sha256_init(&ctx->u.sw);
+        utils_sha256_starts(&ctx->u.sw);
+        return 0;
+    }
+    if (bl_sha_engine_lock(1)) {
+        return -1;
+    }
+    ctx->backend = BL_SHA_BACKEND_HW;
+    bl_sha_engine_start(ctx);
+    return 0;
+}
+
+int bl_sha_update(bl_sha_ctx_t *ctx, const uint8_t *input, uint32_t len)
+{
+    uint32_t n;
+    int locked = 0;
+
+    if (0 == len) {
+        return 0;
+    }
+    if (BL_SHA_BACKEND_NONE == ctx->backend) {
+        if (sha_backend_select(ctx)) {
+            return -1;
+        }
+        locked = (BL_SHA_BACKEND_HW == ctx->backend);
+    }
+    if (BL_SHA_BACKEND_SW == ctx->backend) {
+        utils_sha256_update(&ctx->u.sw, input, len);
+        return 0;
+    }
+
+    while (len) {
+        if (!locked && bl_sha_engine_lock(1)) {
+            return -1;
+        }
+        n = len > BL_SHA_ENGINE_CHUNK ? BL_SHA_ENGINE_CHUNK : len;
+        if (bl_sha_engine_update(ctx, input, n)) {
+            bl_sha_engine_unlock();
+            return -1;
+        }
+        bl_sha_engine_unlock();
+        locked = 0;
+        input += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int bl_sha_finish(bl_sha_ctx_t *ctx, uint8_t *hash)
+{
+    int ret;
+
+    if (BL_SHA_BACKEND_NONE == ctx->backend) {
+        if (sha_backend_select(ctx)) {
+            return -1;
+        }
+    } else if (BL_SHA_BACKEND_HW == ctx->backend && bl_sha_engine_lock(1)) {
+        return -1;
+    }
+    if (BL_SHA_BACKEND_SW == ctx->backend) {
+        utils_sha256_finish(&ctx->u.sw, hash);
+        utils_sha256_free(&ctx->u.sw);
+        ret = 0;
+    } else {
+        ret = bl_sha_engine_finish(ctx, hash);
+        bl_sha_engine_unlock();
+    }
+    ctx->backend = BL_SHA_BACKEND_NONE;
+
+    return ret;
+}
+
+/**
+ * HMAC (RFC 2104) over any bl_sha_type_t, the key may be longer than a block.
+ *
+ * @return 0 on success
+ */
+int bl_hmac_init(bl_hmac_ctx_t *ctx, bl_sha_type_t type, const uint8_t *key, uint32_t key_len)
+{
+    uint32_t k[BL_SHA_BLOCK_LEN / 4];
+    uint8_t *kb = (uint8_t *)k;
+    int i, ret = -1;
+
+    if (0 == bl_sha_digest_len(type)) {
+        return -1;
+    }
+    memset(k, 0, sizeof(k));
+    if (key_len > BL_SHA_BLOCK_LEN) {
+        bl_sha_init(&ctx->sha, type);
+        if (bl_sha_update(&ctx->sha, key, key_len) || bl_sha_finish(&ctx->sha, kb)) {
+            goto out;
+        }
+    } else if (key_len) {
+        memcpy(kb, key, key_len);
+    }
+
+    for (i = 0; i < BL_SHA_BLOCK_LEN / 4; i++) {
+        ctx->opad[i] = k[i] ^ 0x5c5c5c5c;
+        k[i] ^= 0x36363636;
+    }
+    bl_sha_init(&ctx->sha, type);
+    ret = bl_sha_update(&ctx->sha, kb, BL_SHA_BLOCK_LEN);
+
+out:
+    memset(k, 0, sizeof(k));
+    return ret;
+}
+
+int bl_hmac_update(bl_hmac_ctx_t *ctx, const uint8_t *input, uint32_t len)
+{
+    return bl_sha_update(&ctx->sha, input, len);
+}
+
+int bl_hmac_finish(bl_hmac_ctx_t *ctx, uint8_t *mac)
+{
+    uint32_t inner[BL_SHA_MAX_DIGEST_LEN / 4];
+    bl_sha_type_t type = (bl_sha_type_t)ctx->sha.type;
+    int ret;
+
+    ret = bl_sha_finish(&ctx->sha, (uint8_t *)inner);
+    if (0 == ret) {
+        bl_sha_init(&ctx->sha, type);
+        ret = bl_sha_update(&ctx->sha, (uint8_t *)ctx->opad, BL_SHA_BLOCK_LEN);
+    }
+    if (0 == ret) {
+        ret = bl_sha_update(&ctx->sha, (uint8_t *)inner, bl_sha_digest_len(type));
+    }
+    if (0 == ret) {
+        ret = bl_sha_finish(&ctx->sha, mac);
+    }
+    memset(inner, 0, sizeof(inner));
+    memset(ctx->opad, 0, sizeof(ctx->opad));
+
+    return ret;
+}
+
+int bl_hmac(bl_sha_type_t type, const uint8_t *key, uint32_t key_len,
+        const uint8_t *input, uint32_t len, uint8_t *mac)
+{
+    bl_hmac_ctx_t ctx;
+
+    int ret;
+
+    ret = bl_hmac_init(&ctx, type, key, key_len);
+    if (0 == ret) {
+        ret = bl_hmac_update(&ctx, input, len);
+    }
+    if (0 == ret) {
+        ret = bl_hmac_finish(&ctx, mac);
+    }
+    memset(&ctx, 0, sizeof(ctx));
+
+    return ret;
+}
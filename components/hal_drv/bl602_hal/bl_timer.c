@@ -34,7 +34,6 @@
 #include <FreeRTOS.h>
 #include <task.h>
 
-#define MTIMER_TICKS_PER_US     (10)
 #if 0
 static inline uint64_t timer_us_now()
 {
@@ -57,12 +56,17 @@ extern uint64_t timer_us_now();
 
 uint32_t bl_timer_now_us(void)
 {
-    return timer_us_now() / MTIMER_TICKS_PER_US;
+    return timer_us_now() / BL_TIMER_TICKS_PER_US;
 }
 
 uint64_t bl_timer_now_us64(void)
 {
-    return timer_us_now() / MTIMER_TICKS_PER_US;
+    return timer_us_now() / BL_TIMER_TICKS_PER_US;
+}
+
+uint32_t ATTR_TCM_SECTION bl_timer_now_ticks(void)
+{
+    return *(volatile uint32_t*)0x0200BFF8;
 }
 
 #if 0
@@ -72,7 +76,7 @@ void bl_timer_delay_us(uint32_t us)
     int ticks, diff;
 
     tick_start = *(volatile uint32_t*)0x0200BFF8;
-    ticks = us * MTIMER_TICKS_PER_US;
+    ticks = us * BL_TIMER_TICKS_PER_US;
 
     do {
         tick_now = *(volatile uint32_t*)0x0200BFF8;
@@ -33,4 +33,10 @@
 uint32_t bl_timer_now_us(void);
 void bl_timer_delay_us(uint32_t us);
 uint64_t bl_timer_now_us64(void);
+
+#define BL_TIMER_TICKS_PER_US   (10)
+/* Low word of mtime, in TCM so it can be read while the flash is busy.
+ * It wraps every 7 minutes, take differences.
+ */
+uint32_t bl_timer_now_ticks(void);
 #endif
@@ -35,6 +35,7 @@
 #include <hal_sys.h>
 
 #include <libfdt.h>
+#include <blfdt_index.h>
 
 #include <blog.h>
 #include <utils_log.h>
@@ -59,7 +60,7 @@ static int update_mac_config_get_mac_from_dtb(const void *fdt, int offset1, uint
     const uint8_t *addr_prop = 0;
 
     /* set sta_mac_addr ap_mac_addr */
-    addr_prop = fdt_getprop(fdt, offset1, "sta_mac_addr", &lentmp);
+    addr_prop = blfdt_getprop(fdt, offset1, "sta_mac_addr", &lentmp);
     if (6 == lentmp) {
 
         memcpy(mac_addr, addr_prop, 6);
@@ -72,7 +73,7 @@ static int update_mac_config_get_mac_from_dtb(const void *fdt, int offset1, uint
         return -1;
     }
 
-    addr_prop = fdt_getprop(fdt, offset1, "ap_mac_addr", &lentmp);
+    addr_prop = blfdt_getprop(fdt, offset1, "ap_mac_addr", &lentmp);
     if (6 == lentmp) {
 
         memcpy(mac_addr, addr_prop, 6);
@@ -200,9 +201,9 @@ static void update_mac_config(const void *fdt, int offset1)
     const char *result = 0;
     char mac_mode[4];
 
-    countindex = fdt_stringlist_count(fdt, offset1, "mode");
+    countindex = blfdt_stringlist_count(fdt, offset1, "mode");
     if (1 == countindex) {
-        result = fdt_stringlist_get(fdt, offset1, "mode", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "mode", 0, &lentmp);
         blog_print("MAC address mode length %d\r\n", lentmp);
         if (lentmp <= MAC_ORDER_ADDR_LEN_MAX) {
             memcpy(mac_mode, result, lentmp);
@@ -236,7 +237,7 @@ static int update_xtal_config_get_mac_from_dtb(const void *fdt, int offset1, uin
     const uint8_t *addr_prop = 0;
     int lentmp = 0;
 
-    addr_prop = fdt_getprop(fdt, offset1, "xtal", &lentmp);
+    addr_prop = blfdt_getprop(fdt, offset1, "xtal", &lentmp);
 
     if (5*4 == lentmp) {
         blog_info(
@@ -315,9 +316,9 @@ static void update_xtal_config(const void *fdt, int offset1)
     char xtal_mode[3];
     const char *result = 0;
 
-    countindex = fdt_stringlist_count(fdt, offset1, "xtal_mode");
+    countindex = blfdt_stringlist_count(fdt, offset1, "xtal_mode");
     if (1 == countindex) {
-        result = fdt_stringlist_get(fdt, offset1, "xtal_mode", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "xtal_mode", 0, &lentmp);
         blog_info("xtal_mode length %d\r\n", lentmp);
         if (lentmp <= XTAL_ORDER_ADDR_LEN_MAX) {
             memcpy(xtal_mode, result, lentmp);
@@ -334,7 +335,7 @@ static int update_poweroffset_config_get_mac_from_dtb(const void *fdt, int offse
     const uint8_t *addr_prop = 0;
 
 #define PWR_OFFSET_BASE (10)
-    addr_prop = fdt_getprop(fdt, offset1, "pwr_offset", &lentmp);
+    addr_prop = blfdt_getprop(fdt, offset1, "pwr_offset", &lentmp);
     if (14*4 == lentmp) {
         for (i = 0; i < 14; i++) {
             poweroffset[i] = BL_FDT32_TO_U32(addr_prop, 4*i);
@@ -443,9 +444,9 @@ static void update_poweroffset_config(const void *fdt, int offset1)
     char pwr_mode[3];
     const char *result = 0;
 
-    countindex = fdt_stringlist_count(fdt, offset1, "pwr_mode");
+    countindex = blfdt_stringlist_count(fdt, offset1, "pwr_mode");
     if (1 == countindex) {
-        result = fdt_stringlist_get(fdt, offset1, "pwr_mode", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "pwr_mode", 0, &lentmp);
         blog_info("pwr_mode length %d\r\n", lentmp);
         if (lentmp <= PWR_OFFSET_ORDER_ADDR_LEN_MAX) {
             memcpy(pwr_mode, result, lentmp);
@@ -464,7 +465,7 @@ static int update_sta_field(const void *fdt, int wifi_offset, const char *name)
     const uint8_t *addr_prop = 0;
     int auto_connect_enable;
 
-    offset1 = fdt_subnode_offset(fdt, wifi_offset, name);
+    offset1 = blfdt_subnode_offset(fdt, wifi_offset, name);
     if (offset1 > 0) {
         /* set ssid pwd */
         uint8_t ap_ssid[32];
@@ -472,9 +473,9 @@ static int update_sta_field(const void *fdt, int wifi_offset, const char *name)
         uint8_t ap_psk[64];
         uint8_t ap_psk_len = 0;
 
-        countindex = fdt_stringlist_count(fdt, offset1, "ssid");
+        countindex = blfdt_stringlist_count(fdt, offset1, "ssid");
         if (1 == countindex) {
-            result = fdt_stringlist_get(fdt, offset1, "ssid", 0, &lentmp);
+            result = blfdt_stringlist_get(fdt, offset1, "ssid", 0, &lentmp);
             if ((lentmp > 0) &&(lentmp<32)) {/* !NULL */
                 blog_info("[STA] ap_ssid string[%d] = %s, ap_ssid_len = %d\r\n", 0, result, lentmp);
                 memcpy(ap_ssid, result, lentmp);
@@ -483,9 +484,9 @@ static int update_sta_field(const void *fdt, int wifi_offset, const char *name)
             }
         }
 
-        countindex = fdt_stringlist_count(fdt, offset1, "pwd");
+        countindex = blfdt_stringlist_count(fdt, offset1, "pwd");
         if (1 == countindex) {
-            result = fdt_stringlist_get(fdt, offset1, "pwd", 0, &lentmp);
+            result = blfdt_stringlist_get(fdt, offset1, "pwd", 0, &lentmp);
             if ((lentmp > 0) &&(lentmp<32)) {/* !NULL */
                 blog_info("[STA] ap_psk string[%d] = %s, ap_psk_len = %d\r\n", 0, result, lentmp);
                 memcpy(ap_psk, result, lentmp);
@@ -493,7 +494,7 @@ static int update_sta_field(const void *fdt, int wifi_offset, const char *name)
                 ap_psk_len = lentmp;
             }
         }
-        addr_prop = fdt_getprop(fdt, offset1, "auto_connect_enable", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "auto_connect_enable", &lentmp);
         if (addr_prop) {
             blog_info("auto_connect_enable = %ld\r\n", BL_FDT32_TO_U32(addr_prop, 0));
 
@@ -514,7 +515,7 @@ static int update_ap_field(const void *fdt, int wifi_offset, [[gnu::unused]] con
     const char *result = 0;
     const uint8_t *addr_prop = 0;
 
-    offset1 = fdt_subnode_offset(fdt, wifi_offset, "ap");
+    offset1 = blfdt_subnode_offset(fdt, wifi_offset, "ap");
     if (offset1 > 0)
     {
         /* set ssid pwd */
@@ -524,9 +525,9 @@ static int update_ap_field(const void *fdt, int wifi_offset, [[gnu::unused]] con
         uint8_t ap_psk_len = 0;
         uint8_t ap_channel = 0;
 
-        countindex = fdt_stringlist_count(fdt, offset1, "ssid");
+        countindex = blfdt_stringlist_count(fdt, offset1, "ssid");
         if (1 == countindex) {
-            result = fdt_stringlist_get(fdt, offset1, "ssid", 0, &lentmp);
+            result = blfdt_stringlist_get(fdt, offset1, "ssid", 0, &lentmp);
             if ((lentmp > 0) &&(lentmp<32)) {/* !NULL */
                 blog_info("ap_ssid string[%d] = %s, ap_ssid_len = %d\r\n", 0, result, lentmp);
                 memcpy(ap_ssid, result, lentmp);
@@ -535,9 +536,9 @@ static int update_ap_field(const void *fdt, int wifi_offset, [[gnu::unused]] con
             }
         }
 
-        countindex = fdt_stringlist_count(fdt, offset1, "pwd");
+        countindex = blfdt_stringlist_count(fdt, offset1, "pwd");
         if (1 == countindex) {
-            result = fdt_stringlist_get(fdt, offset1, "pwd", 0, &lentmp);
+            result = blfdt_stringlist_get(fdt, offset1, "pwd", 0, &lentmp);
             if ((lentmp > 0) &&(lentmp<32)) {/* !NULL */
                 blog_info("ap_psk string[%d] = %s, ap_psk_len = %d\r\n", 0, result, lentmp);
                 memcpy(ap_psk, result, lentmp);
@@ -546,7 +547,7 @@ static int update_ap_field(const void *fdt, int wifi_offset, [[gnu::unused]] con
             }
         }
 
-        addr_prop = fdt_getprop(fdt, offset1, "ap_channel", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "ap_channel", &lentmp);
         if (addr_prop) {
             blog_info("ap_channel = %ld\r\n", BL_FDT32_TO_U32(addr_prop, 0));
 
@@ -573,12 +574,12 @@ static int hal_board_load_fdt_info(const void *dtb)
     int lentmp = 0;
     int i;
 
-    wifi_offset = fdt_subnode_offset(fdt, 0, "wifi");
+    wifi_offset = blfdt_subnode_offset(fdt, 0, "wifi");
     if (!(wifi_offset > 0)) {
        blog_error("wifi NULL.\r\n");
     }
 
-    offset1 = fdt_subnode_offset(fdt, wifi_offset, "brd_rf");
+    offset1 = blfdt_subnode_offset(fdt, wifi_offset, "brd_rf");
     if (offset1 > 0) {
         uint32_t channel_div_table[15];
         uint16_t channel_cnt_table[14];
@@ -592,7 +593,7 @@ static int hal_board_load_fdt_info(const void *dtb)
         update_xtal_config(fdt, offset1);
 
         /* set channel_div_table, channel_cnt_table, lo_fcal_div */
-        addr_prop = fdt_getprop(fdt, offset1, "channel_div_table", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "channel_div_table", &lentmp);
         if (15*4 == lentmp) {
             for (i = 0; i < 15; i++) {
                 channel_div_table[i] = BL_FDT32_TO_U32(addr_prop, 4*i);
@@ -603,7 +604,7 @@ static int hal_board_load_fdt_info(const void *dtb)
             blog_error("channel_div_table NULL.\r\n");
         }
 
-        addr_prop = fdt_getprop(fdt, offset1, "channel_cnt_table", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "channel_cnt_table", &lentmp);
         if (14*4 == lentmp) {
             for (i = 0; i < 14; i++) {
                 channel_cnt_table[i] = BL_FDT32_TO_U16(addr_prop, 4*i);
@@ -614,7 +615,7 @@ static int hal_board_load_fdt_info(const void *dtb)
             blog_error("channel_cnt_table NULL.\r\n");
         }
 
-        addr_prop = fdt_getprop(fdt, offset1, "lo_fcal_div", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "lo_fcal_div", &lentmp);
         if (4 == lentmp) {
             lo_fcal_div = BL_FDT32_TO_U16(addr_prop, 4*0);
             blog_info("lo_fcal_div : %d\r\n", lo_fcal_div);
@@ -626,15 +627,15 @@ static int hal_board_load_fdt_info(const void *dtb)
         //bl60x_fw_rf_table_set(channel_div_table, channel_cnt_table, lo_fcal_div);
     }
 
-    offset1 = fdt_subnode_offset(fdt, wifi_offset, "mac");
+    offset1 = blfdt_subnode_offset(fdt, wifi_offset, "mac");
     if (offset1 > 0) {
         update_mac_config(fdt, offset1);
     }
 
-    offset1 = fdt_subnode_offset(fdt, wifi_offset, "region");
+    offset1 = blfdt_subnode_offset(fdt, wifi_offset, "region");
     if (offset1 > 0) {
         /* set country_code */
-        addr_prop = fdt_getprop(fdt, offset1, "country_code", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "country_code", &lentmp);
         if (4 == lentmp) {
             blog_info("country_code : %d\r\n", BL_FDT32_TO_U8(addr_prop, 4*0));
 
@@ -644,14 +645,14 @@ static int hal_board_load_fdt_info(const void *dtb)
         }
     }
 
-    offset1 = fdt_subnode_offset(fdt, wifi_offset, "brd_rf");
+    offset1 = blfdt_subnode_offset(fdt, wifi_offset, "brd_rf");
     if (offset1 > 0)
     {
         /* set tx_pwr_tbl */
         uint8_t pwr_table[24];
 
         USER_UNUSED(pwr_table);
-        addr_prop = fdt_getprop(fdt, offset1, "pwr_table_11b", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "pwr_table_11b", &lentmp);
         if (4*4 == lentmp) {
             for (i = 0; i < 4; i++) {
                 pwr_table[i] = BL_FDT32_TO_U32(addr_prop, 4*i);
@@ -667,7 +668,7 @@ static int hal_board_load_fdt_info(const void *dtb)
             blog_error("pwr_table_11b NULL. lentmp = %d\r\n", lentmp);
         }
 
-        addr_prop = fdt_getprop(fdt, offset1, "pwr_table_11g", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "pwr_table_11g", &lentmp);
         if (8*4 == lentmp) {
             for (i = 0; i < 8; i++) {
                 pwr_table[i] = BL_FDT32_TO_U32(addr_prop, 4*i);
@@ -687,7 +688,7 @@ static int hal_board_load_fdt_info(const void *dtb)
             blog_error("pwr_table_11g NULL. lentmp = %d\r\n", lentmp);
         }
 
-        addr_prop = fdt_getprop(fdt, offset1, "pwr_table_11n", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "pwr_table_11n", &lentmp);
         if (8*4 == lentmp) {
             for (i = 0; i < 8; i++) {
                 pwr_table[i] = BL_FDT32_TO_U32(addr_prop, 4*i);
@@ -712,16 +713,16 @@ static int hal_board_load_fdt_info(const void *dtb)
     offset1 = update_ap_field(fdt, wifi_offset, "ap");
     offset1 = update_sta_field(fdt, wifi_offset, "sta");
 
-    bt_offset = fdt_subnode_offset(fdt, 0, "bluetooth");
+    bt_offset = blfdt_subnode_offset(fdt, 0, "bluetooth");
     if (!(bt_offset > 0)) {
        blog_error("bt NULL.\r\n");
     }
 
 #ifdef CFG_BLE_ENABLE
-    int offset2 = fdt_subnode_offset(fdt, bt_offset, "brd_rf");
+    int offset2 = blfdt_subnode_offset(fdt, bt_offset, "brd_rf");
     if (offset2 > 0) {
         int pwr_table_ble = 0;
-        addr_prop = fdt_getprop(fdt, offset2, "pwr_table_ble", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset2, "pwr_table_ble", &lentmp);
         if (addr_prop) {
             pwr_table_ble = BL_FDT32_TO_U32(addr_prop, 0);
         } else {
@@ -899,6 +900,11 @@ int hal_board_cfg([[gnu::unused]] uint8_t board_code)
     }
 #endif
 
+    /* one walk over the board dtb, the hal_* drivers look their nodes up in O(1) */
+    if (blfdt_index_build((const void *)factory_addr) < 0) {
+        blog_warn("[MAIN] [BOARD] dtb index unavailable, use libfdt lookups\r\n");
+    }
+
 #ifndef FEATURE_WIFI_DISABLE
     hal_board_load_fdt_info((const void *)factory_addr);
 #endif
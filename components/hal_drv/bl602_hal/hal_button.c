@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <fdt.h>
 #include <libfdt.h>
+#include <blfdt_index.h>
 #include <blog.h>
 #include <loopset.h>
 
@@ -339,46 +340,46 @@ void fdt_button_module_init(const void *fdt, int button_offset)
     for (i = 0; i < GPIO_MODULE_MAX; i++) {
         memset(gpio_node, 0, sizeof(gpio_node));
         sprintf(gpio_node, "gpio%d", i);
-        offset1 = fdt_subnode_offset(fdt, button_offset, gpio_node);
+        offset1 = blfdt_subnode_offset(fdt, button_offset, gpio_node);
         if (0 > offset1) {
             //log_warn("gpio[%d] %s NULL. \r\n", i, gpio_node);
             continue;
         }
 
-        countindex = fdt_stringlist_count(fdt, offset1, "status");
+        countindex = blfdt_stringlist_count(fdt, offset1, "status");
         if (countindex != 1) {
             log_warn("gpio[%d] status_countindex = %d NULL. \r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
         if ((lentmp != 4) || (memcmp("okay", result, 4) != 0)) {
             log_warn("gpio[%d] status = %s\r\n", i, result);
             continue;
         }
 
-        countindex = fdt_stringlist_count(fdt, offset1, "feature");
+        countindex = blfdt_stringlist_count(fdt, offset1, "feature");
         if (countindex != 1) {
             log_warn("gpio[%d] feature_countindex = %d NULL. \r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset1, "feature", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "feature", 0, &lentmp);
         if ((lentmp != 6) || (memcmp("button", result, 6) != 0)) {
             log_warn("gpio[%d] feature = %s\r\n", i, result);
             continue;
         }//not button continue
 
-        countindex = fdt_stringlist_count(fdt, offset1, "mode");
+        countindex = blfdt_stringlist_count(fdt, offset1, "mode");
         if (countindex != 1) {
             log_warn("gpio[%d] mode = %d NULL. \r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset1, "mode", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "mode", 0, &lentmp);
         if ((lentmp != 10) || (memcmp("multipress", result, 10) != 0)) {
             log_warn("gpio[%d] multipress = %s\r\n", i, result);
             continue;
         }//not button continue
 
-        addr_prop = fdt_getprop(fdt, offset1, "pin", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "pin", &lentmp);
         if (addr_prop == NULL) {
             log_warn("gpio[%d] pin NULL. \r\n", i);
             continue;
@@ -386,18 +387,18 @@ void fdt_button_module_init(const void *fdt, int button_offset)
         stgpio.gpioPin = BL_FDT32_TO_U32(addr_prop, 0);
         log_info("i = %d, stgpio.gpioPin = %d\r\n", i, stgpio.gpioPin);
 
-        result = fdt_stringlist_get(fdt, offset1, "hbn_use", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "hbn_use", 0, &lentmp);
         if ((lentmp == 4) && (memcmp("okay", result, 4) == 0)) {
             log_warn("gpio[%d] status = %s\r\n", i, result);
             pinbuf[pinbuf_size++] = stgpio.gpioPin;
         }
 
-        offset2 = fdt_subnode_offset(fdt, offset1, "button");
+        offset2 = blfdt_subnode_offset(fdt, offset1, "button");
         if (0 >= offset2) {
             log_warn("button feature NULL \r\n");
             continue;
         }
-        addr_prop = fdt_getprop(fdt, offset2, "debounce", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset2, "debounce", &lentmp);
         if (addr_prop == NULL) {
             log_warn("debounce NULL. \r\n");
             continue;
@@ -406,26 +407,26 @@ void fdt_button_module_init(const void *fdt, int button_offset)
         ((button_ctx_t*)(stgpio.arg))->debounce = BL_FDT32_TO_U32(addr_prop, 0);
 
         /* short press */
-        offset3 = fdt_subnode_offset(fdt, offset2, "short_press_ms");
+        offset3 = blfdt_subnode_offset(fdt, offset2, "short_press_ms");
         if (0 >= offset3) {
             log_warn("gpio[%d] short_press_ms feature NULL \r\n", i);
             continue;
         }
-        addr_prop = fdt_getprop(fdt, offset3, "start", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset3, "start", &lentmp);
         if (addr_prop == NULL) {
             log_warn("press start  NULL. \r\n");
             continue;
         }
         ((button_ctx_t*)(stgpio.arg))->short_press_start_ms = BL_FDT32_TO_U32(addr_prop, 0);
 
-        addr_prop = fdt_getprop(fdt, offset3, "end", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset3, "end", &lentmp);
         if (addr_prop == NULL) {
             log_warn("press end  NULL. \r\n");
             continue;
         }
         ((button_ctx_t*)(stgpio.arg))->short_press_end_ms = BL_FDT32_TO_U32(addr_prop, 0);
 
-        addr_prop = fdt_getprop(fdt, offset3, "kevent", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset3, "kevent", &lentmp);
         if (addr_prop == NULL) {
             log_warn("gpio[%d] kevnet  NULL. \r\n", i);
             continue;
@@ -433,25 +434,25 @@ void fdt_button_module_init(const void *fdt, int button_offset)
         ((button_ctx_t*)(stgpio.arg))->short_kevent = BL_FDT32_TO_U32(addr_prop, 0);
 
         /* long press */
-        offset3 = fdt_subnode_offset(fdt, offset2, "long_press_ms");
+        offset3 = blfdt_subnode_offset(fdt, offset2, "long_press_ms");
         if (0 >= offset3) {
             log_warn("long_press_ms feature NULL \r\n");
         }
-        addr_prop = fdt_getprop(fdt, offset3, "start", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset3, "start", &lentmp);
         if (addr_prop == NULL) {
             log_warn("press start pin NULL. \r\n");
             continue;
         }
         ((button_ctx_t*)(stgpio.arg))->long_press_start_ms = BL_FDT32_TO_U32(addr_prop, 0);
 
-        addr_prop = fdt_getprop(fdt, offset3, "end", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset3, "end", &lentmp);
         if (addr_prop == NULL) {
             log_warn("press end pin NULL. \r\n");
             continue;
         }
         ((button_ctx_t*)(stgpio.arg))->long_press_end_ms = BL_FDT32_TO_U32(addr_prop, 0);
 
-        addr_prop = fdt_getprop(fdt, offset3, "kevent", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset3, "kevent", &lentmp);
         if (addr_prop == NULL) {
             log_warn("gpio[%d] kevent NULL. \r\n", i);
             continue;
@@ -459,30 +460,30 @@ void fdt_button_module_init(const void *fdt, int button_offset)
         ((button_ctx_t*)(stgpio.arg))->long_kevent = BL_FDT32_TO_U32(addr_prop, 0);
 
         /* longlong press */
-        offset3 = fdt_subnode_offset(fdt, offset2, "longlong_press_ms");
+        offset3 = blfdt_subnode_offset(fdt, offset2, "longlong_press_ms");
         if (0 >= offset3) {
             log_warn("long_press_ms feature NULL \r\n");
         }
-        addr_prop = fdt_getprop(fdt, offset3, "start", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset3, "start", &lentmp);
         if (addr_prop == NULL) {
             log_warn("press start pin NULL. \r\n");
             continue;
         }
         ((button_ctx_t*)(stgpio.arg))->longlong_press_ms = BL_FDT32_TO_U32(addr_prop, 0);
 
-        addr_prop = fdt_getprop(fdt, offset3, "kevent", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset3, "kevent", &lentmp);
         if (addr_prop == NULL) {
             log_warn("gpio[%d] kevent NULL \r\n");
             continue;
         }
         ((button_ctx_t*)(stgpio.arg))->longlong_kevent = BL_FDT32_TO_U32(addr_prop, 0);
 
-        countindex = fdt_stringlist_count(fdt, offset2, "trig_level");
+        countindex = blfdt_stringlist_count(fdt, offset2, "trig_level");
         if (countindex != 1) {
             //log_warn("gpio[%d] trig_level = %d NULL. \r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset2, "trig_level", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset2, "trig_level", 0, &lentmp);
         if (lentmp != 2) {
             log_warn("gpio[%d] trig_level = %s\r\n", i, result);
             continue;
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <fdt.h>
 #include <libfdt.h>
+#include <blfdt_index.h>
 #include <blog.h>
 #include <loopset.h>
 
@@ -66,7 +67,7 @@ static int _get_gpio_max(const void* fdt, uint32_t dtb_offset)
     const uint32_t *addr_prop = 0;
     uint32_t max_num;
 
-    addr_prop = fdt_getprop(fdt, dtb_offset, GPIO_MAX_NUM_STR, &lentmp);
+    addr_prop = blfdt_getprop(fdt, dtb_offset, GPIO_MAX_NUM_STR, &lentmp);
     if (NULL == addr_prop) {
         return -1;
     }
@@ -92,7 +93,7 @@ static int _get_gpio_config(const void* fdt, uint32_t dtb_offset, const char *na
      *
      * */
 
-    offset1 = fdt_subnode_offset(fdt, dtb_offset, name);
+    offset1 = blfdt_subnode_offset(fdt, dtb_offset, name);
     if (offset1 < 0) {
         blog_info("%s NOT found\r\n", name);
         return -1;
@@ -101,20 +102,20 @@ static int _get_gpio_config(const void* fdt, uint32_t dtb_offset, const char *na
     memset(gpio_config, 0, sizeof(struct gpio_feature_config));
     gpio_config->valid  = GPIO_VALID_NOT;
 
-    result = fdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
+    result = blfdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
     if ((lentmp != 4) || (memcmp("okay", result, 4) != 0)) {
         blog_info("[%s] status = %s\r\n", name, result);
         return 0;
     }
 
-    addr_prop = fdt_getprop(fdt, offset1, "pin", &lentmp);
+    addr_prop = blfdt_getprop(fdt, offset1, "pin", &lentmp);
     if (addr_prop == NULL) {
         blog_error("no pin found for %s\r\n", name);
         return 0;
     }
     gpio_config->pin = BL_FDT32_TO_U32(addr_prop, 0);
 
-    result = fdt_stringlist_get(fdt, offset1, "feature", 0, &lentmp);
+    result = blfdt_stringlist_get(fdt, offset1, "feature", 0, &lentmp);
     if (3 == lentmp && memcmp("led", result, 3) == 0) {
         gpio_config->feature = GPIO_FEATURE_CONFIG_LED;
     } else {
@@ -122,7 +123,7 @@ static int _get_gpio_config(const void* fdt, uint32_t dtb_offset, const char *na
         return 0;
     }
 
-    result = fdt_stringlist_get(fdt, offset1, "active", 0, &lentmp);
+    result = blfdt_stringlist_get(fdt, offset1, "active", 0, &lentmp);
     if (2 == lentmp && memcmp("Hi", result, 2) == 0) {
         gpio_config->active = GPIO_ACTIVE_HI;
     } else if (2 == lentmp && memcmp("Lo", result, 2) == 0) {
@@ -132,7 +133,7 @@ static int _get_gpio_config(const void* fdt, uint32_t dtb_offset, const char *na
         return 0;
     }
 
-    result = fdt_stringlist_get(fdt, offset1, "mode", 0, &lentmp);
+    result = blfdt_stringlist_get(fdt, offset1, "mode", 0, &lentmp);
     if (5 == lentmp && memcmp("blink", result, 5) == 0) {
         gpio_config->mode = GPIO_MODE_BLINK;
     } else if (9 == lentmp && memcmp("heartbeat", result, 9) == 0) {
@@ -142,7 +143,7 @@ static int _get_gpio_config(const void* fdt, uint32_t dtb_offset, const char *na
         return 0;
     }
 
-    addr_prop = fdt_getprop(fdt, offset1, "time", &lentmp);
+    addr_prop = blfdt_getprop(fdt, offset1, "time", &lentmp);
     if (addr_prop == NULL) {
         blog_error("%s: unvalid GPIO config\r\n", name);
         return 0;
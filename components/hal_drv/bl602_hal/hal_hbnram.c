@@ -112,7 +112,6 @@ static int sha_check_withctx(uint8_t *input, uint8_t *output, bl_sha_type_t shaT
     count = length / data_size;
     remain = length % data_size;
     bl_sha_ctx_t shaCtx;
-    bl_sha_mutex_take();
     bl_sha_init(&shaCtx, shaType);
 
     pallc = pvPortMalloc(data_size);
@@ -130,7 +129,6 @@ static int sha_check_withctx(uint8_t *input, uint8_t *output, bl_sha_type_t shaT
     if (bl_sha_finish(&shaCtx, output) != 0) {
         printf("Sec_Eng_SHA256_Finish error \r\n");
     }
-    bl_sha_mutex_give();
 
     vPortFree(pallc);
 
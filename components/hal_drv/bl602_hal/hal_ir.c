@@ -31,6 +31,7 @@
 #include <stdint.h>
 #include <fdt.h>
 #include <libfdt.h>
+#include <blfdt_index.h>
 #include <blog.h>
 #include <loopset.h>
 
@@ -63,7 +64,7 @@ int hal_ir_init_from_dts(uint32_t fdt_input, uint32_t dtb_offset)
     uint8_t pin = 0;
     uint16_t interval = 0;
 
-    addr_prop = fdt_getprop(fdt, dtb_offset, "ctrltype", &lentmp);
+    addr_prop = blfdt_getprop(fdt, dtb_offset, "ctrltype", &lentmp);
     if (addr_prop == NULL) {
         log_info("do not find ctrltype \r\n");
     } else {
@@ -71,26 +72,26 @@ int hal_ir_init_from_dts(uint32_t fdt_input, uint32_t dtb_offset)
         log_info("ctrltype == %d \r\n", ctrltype);
     }
 
-    offset1 = fdt_subnode_offset(fdt, dtb_offset, "rx");
+    offset1 = blfdt_subnode_offset(fdt, dtb_offset, "rx");
     if (0 >= offset1) {
         log_info("ir rx NULL.\r\n");
     } else {
-        countindex = fdt_stringlist_count(fdt, offset1, "status");
+        countindex = blfdt_stringlist_count(fdt, offset1, "status");
         if (countindex != 1) {
             log_info("ir rx status_countindex = %d NULL.\r\n", countindex);
         } else {
-            result = fdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
+            result = blfdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
             if ((lentmp != 4) || (memcmp("okay", result, 4) != 0)) {
                 log_info("ir rx status = %s\r\n", result);
             } else {
                 /* set id */
-                addr_prop = fdt_getprop(fdt, offset1, "pin", &lentmp);
+                addr_prop = blfdt_getprop(fdt, offset1, "pin", &lentmp);
                 if (addr_prop == NULL) {
                     log_info("ir rx pin NULL.\r\n");
                 } else {
                     pin = BL_FDT32_TO_U32(addr_prop, 0);
                     log_info("pin == %d \r\n", pin);
-                    addr_prop = fdt_getprop(fdt, offset1, "interval", &lentmp);
+                    addr_prop = blfdt_getprop(fdt, offset1, "interval", &lentmp);
                     if (addr_prop == NULL) {
                         log_info("ir rx interval NULL.\r\n");
                     } else {
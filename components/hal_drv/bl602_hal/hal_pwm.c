@@ -37,6 +37,7 @@
 
 #include <bl_pwm.h>
 #include <libfdt.h>
+#include <blfdt_index.h>
 
 #include <utils_log.h>
 
@@ -196,29 +197,29 @@ static void fdt_pwm_module_init(const void *fdt, int pwm_offset)
     };
 
     for (i = 0; i < PWM_MODULE_MAX; i++) {
-        offset1 = fdt_subnode_offset(fdt, pwm_offset, pwm_node[i]);
+        offset1 = blfdt_subnode_offset(fdt, pwm_offset, pwm_node[i]);
         if (0 >= offset1) {
             log_info("pwm[%d] %s NULL.\r\n", i, pwm_node[i]);
             continue;
         }
-        countindex = fdt_stringlist_count(fdt, offset1, "status");
+        countindex = blfdt_stringlist_count(fdt, offset1, "status");
         if (countindex != 1) {
             log_info("pwm[%d] status_countindex = %d NULL.\r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
         if ((lentmp != 4) || (memcmp("okay", result, 4) != 0)) {
             log_info("pwm[%d] status = %s\r\n", i, result);
             continue;
         }
 
         /* set path */
-        countindex = fdt_stringlist_count(fdt, offset1, "path");
+        countindex = blfdt_stringlist_count(fdt, offset1, "path");
         if (countindex != 1) {
             log_info("pwm[%d] path_countindex = %d NULL.\r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset1, "path", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "path", 0, &lentmp);
         if ((lentmp < 0) || (lentmp > 32))
         {
             log_info("pwm[%d] path lentmp = %d\r\n", i, lentmp);
@@ -226,7 +227,7 @@ static void fdt_pwm_module_init(const void *fdt, int pwm_offset)
         path = (char *)result;
 
         /* set id */
-        addr_prop = fdt_getprop(fdt, offset1, "id", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "id", &lentmp);
         if (addr_prop == NULL) {
             log_info("pwm[%d] id NULL.\r\n", i);
             continue;
@@ -234,7 +235,7 @@ static void fdt_pwm_module_init(const void *fdt, int pwm_offset)
         id = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* set pin */
-        addr_prop = fdt_getprop(fdt, offset1, "pin", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "pin", &lentmp);
         if (addr_prop == NULL) {
             log_info("pwm[%d] pin NULL.\r\n", i);
             continue;
@@ -242,7 +243,7 @@ static void fdt_pwm_module_init(const void *fdt, int pwm_offset)
         pin = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* set freq */
-        addr_prop = fdt_getprop(fdt, offset1, "freq", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "freq", &lentmp);
         if (addr_prop == NULL) {
             log_info("pwm[%d] freq NULL.\r\n", i);
             continue;
@@ -50,6 +50,7 @@
 #include <event_groups.h>
 
 #include <libfdt.h>
+#include <blfdt_index.h>
 #include <utils_log.h>
 #include <blog.h>
 
@@ -605,18 +606,18 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
     /* spi */
     for (i = 0; i < SPI_MODULE_MAX; i++) {
         /* get spi0 ? spi1 ? spi2 offset1 */
-        offset1 = fdt_subnode_offset(fdt, dtb_spi_offset, spi_node[i]);
+        offset1 = blfdt_subnode_offset(fdt, dtb_spi_offset, spi_node[i]);
         if (0 >= offset1) {
             continue;
         }
 
-        result = fdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
         if ((lentmp != 4) || (memcmp("okay", result, 4) != 0)) {
             blog_info("spi[%d] status != okay\r\n", i);
             continue;
         }
 
-        result = fdt_stringlist_get(fdt, offset1, "mode", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "mode", 0, &lentmp);
         if ((lentmp != 6 && lentmp != 5) || ((memcmp("master", result, 6) != 0) && (memcmp("slave", result, 5)))) {
             blog_info("spi[%d] mode != master or slave\r\n", i);
             continue;
@@ -629,19 +630,19 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         }
 
         /* set path */
-        countindex = fdt_stringlist_count(fdt, offset1, "path");
+        countindex = blfdt_stringlist_count(fdt, offset1, "path");
         if (countindex != 1) {
             blog_info("spi[%d] path_countindex = %d NULL.\r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset1, "path", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "path", 0, &lentmp);
         if ((lentmp < 0) || (lentmp > 32)) {
             blog_info("spi[%d] path lentmp = %d\r\n", i, lentmp);
         }
         path = (char *)result;
 
         /* sure port == i */
-        addr_prop = fdt_getprop(fdt, offset1, "port", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "port", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] port NULL.\r\n", i);
             continue;
@@ -653,7 +654,7 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         }
 
         /* get polar_phase */
-        addr_prop = fdt_getprop(fdt, offset1, "polar_phase", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "polar_phase", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] polar_phase NULL.\r\n", i);
             continue;
@@ -661,7 +662,7 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         polar_phase = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* get freq */
-        addr_prop = fdt_getprop(fdt, offset1, "freq", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "freq", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] freq NULL.\r\n", i);
             continue;
@@ -669,13 +670,13 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         freq = BL_FDT32_TO_U32(addr_prop, 0);
 
         /* set pin */
-        offset2 = fdt_subnode_offset(fdt, offset1, "pin");
+        offset2 = blfdt_subnode_offset(fdt, offset1, "pin");
         if (0 >= offset1) {
             continue;
         }
 
         /* get pin_clk */
-        addr_prop = fdt_getprop(fdt, offset2, "clk", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset2, "clk", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] clk NULL.\r\n", i);
             continue;
@@ -683,7 +684,7 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         pin_clk = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* get pin_cs */
-        addr_prop = fdt_getprop(fdt, offset2, "cs", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset2, "cs", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] cs NULL.\r\n", i);
             continue;
@@ -691,7 +692,7 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         pin_cs = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* get pin_mosi */
-        addr_prop = fdt_getprop(fdt, offset2, "mosi", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset2, "mosi", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] mosi NULL.\r\n", i);
             continue;
@@ -699,7 +700,7 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         pin_mosi = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* get pin_miso */
-        addr_prop = fdt_getprop(fdt, offset2, "miso", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset2, "miso", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] miso NULL.\r\n", i);
             continue;
@@ -707,13 +708,13 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         pin_miso = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* set dma_cfg */
-        offset2 = fdt_subnode_offset(fdt, offset1, "dma_cfg");
+        offset2 = blfdt_subnode_offset(fdt, offset1, "dma_cfg");
         if (0 >= offset1) {
             continue;
         }
 
         /* get tx_dma_ch */
-        addr_prop = fdt_getprop(fdt, offset2, "tx_dma_ch", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset2, "tx_dma_ch", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] tx_dma_ch NULL.\r\n", i);
             continue;
@@ -721,7 +722,7 @@ int spi_arg_set_fdt2(const void * fdt, uint32_t dtb_spi_offset)
         tx_dma_ch = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* get rx_dma_ch */
-        addr_prop = fdt_getprop(fdt, offset2, "rx_dma_ch", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset2, "rx_dma_ch", &lentmp);
         if (addr_prop == NULL) {
             blog_info("spi[%d] rx_dma_ch NULL.\r\n", i);
             continue;
@@ -37,6 +37,7 @@
 #include "hal_uart.h"
 
 #include <libfdt.h>
+#include <blfdt_index.h>
 
 #include <blog.h>
 
@@ -295,30 +296,30 @@ static void fdt_uart_module_init(const void *fdt, int uart_offset)
     };
 
     for (i = 0; i < UART_MODULE_MAX; i++) {
-        offset1 = fdt_subnode_offset(fdt, uart_offset, uart_node[i]);
+        offset1 = blfdt_subnode_offset(fdt, uart_offset, uart_node[i]);
         if (0 >= offset1) {
             blog_info("uart[%d] %s NULL.\r\n", i, uart_node[i]);
             continue;
         }
 
-        countindex = fdt_stringlist_count(fdt, offset1, "status");
+        countindex = blfdt_stringlist_count(fdt, offset1, "status");
         if (countindex != 1) {
             blog_info("uart[%d] status_countindex = %d NULL.\r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "status", 0, &lentmp);
         if ((lentmp != 4) || (memcmp("okay", result, 4) != 0)) {
             blog_info("uart[%d] status = %s\r\n", i, result);
             continue;
         }
 
         /* set path */
-        countindex = fdt_stringlist_count(fdt, offset1, "path");
+        countindex = blfdt_stringlist_count(fdt, offset1, "path");
         if (countindex != 1) {
             blog_info("uart[%d] path_countindex = %d NULL.\r\n", i, countindex);
             continue;
         }
-        result = fdt_stringlist_get(fdt, offset1, "path", 0, &lentmp);
+        result = blfdt_stringlist_get(fdt, offset1, "path", 0, &lentmp);
         if ((lentmp < 0) || (lentmp > 32))
         {
             blog_info("uart[%d] path lentmp = %d\r\n", i, lentmp);
@@ -326,7 +327,7 @@ static void fdt_uart_module_init(const void *fdt, int uart_offset)
         path = (char *)result;
 
         /* set baudrate */
-        addr_prop = fdt_getprop(fdt, offset1, "baudrate", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "baudrate", &lentmp);
         if (addr_prop == NULL) {
             blog_info("uart[%d] baudrate NULL.\r\n", i);
             continue;
@@ -334,7 +335,7 @@ static void fdt_uart_module_init(const void *fdt, int uart_offset)
         baudrate = BL_FDT32_TO_U32(addr_prop, 0);
 
         /* set id */
-        addr_prop = fdt_getprop(fdt, offset1, "id", &lentmp);
+        addr_prop = blfdt_getprop(fdt, offset1, "id", &lentmp);
         if (addr_prop == NULL) {
             blog_info("uart[%d] id NULL.\r\n", i);
             continue;
@@ -342,19 +343,19 @@ static void fdt_uart_module_init(const void *fdt, int uart_offset)
         id = BL_FDT32_TO_U8(addr_prop, 0);
 
         /* set buffer size */
-        offset2 = fdt_subnode_offset(fdt, offset1, "buf_size");
+        offset2 = blfdt_subnode_offset(fdt, offset1, "buf_size");
         if (0 >= offset2) {
             blog_info("uart[%d] buf_size NULL, will use default.\r\n", i);
             rx_buf_size = 512;
             tx_buf_size = 512;
         } else {
-            addr_prop = fdt_getprop(fdt, offset2, "rx_size", &lentmp);
+            addr_prop = blfdt_getprop(fdt, offset2, "rx_size", &lentmp);
             if (addr_prop == NULL) {
                 blog_info("uart[%d] %s NULL.\r\n", i, "rx_size");
                 continue;
             }
             rx_buf_size = BL_FDT32_TO_U32(addr_prop, 0);
-            addr_prop = fdt_getprop(fdt, offset2, "tx_size", &lentmp);
+            addr_prop = blfdt_getprop(fdt, offset2, "tx_size", &lentmp);
             if (addr_prop == NULL) {
                 blog_info("uart[%d] %s NULL.\r\n", i, "tx_size");
                 continue;
@@ -364,29 +365,29 @@ static void fdt_uart_module_init(const void *fdt, int uart_offset)
         blog_info("uart[%d] rx_buf_size %d, tx_buf_size %d\r\n", i, rx_buf_size, tx_buf_size);
 
         for (j = 0; j < 4; j++) {
-            offset2 = fdt_subnode_offset(fdt, offset1, "feature");
+            offset2 = blfdt_subnode_offset(fdt, offset1, "feature");
             if (0 >= offset2) {
                 blog_info("uart[%d] feature NULL.\r\n", i);
                 continue;
             }
-            countindex = fdt_stringlist_count(fdt, offset2, feature_pin[j].featue_name);
+            countindex = blfdt_stringlist_count(fdt, offset2, feature_pin[j].featue_name);
             if (countindex != 1) {
                 blog_info("uart[%d] %s countindex = %d.\r\n", i, feature_pin[j].featue_name, countindex);
                 continue;
             }
-            result = fdt_stringlist_get(fdt, offset2, feature_pin[j].featue_name, 0, &lentmp);
+            result = blfdt_stringlist_get(fdt, offset2, feature_pin[j].featue_name, 0, &lentmp);
             if ((lentmp != 4) || (memcmp("okay", result, 4) != 0)) {
                 blog_info("uart[%d] %s status = %s lentmp = %d\r\n", i, feature_pin[j].featue_name, result, lentmp);
                 continue;
             }
 
             /* get pin_name */
-            offset2 = fdt_subnode_offset(fdt, offset1, "pin");
+            offset2 = blfdt_subnode_offset(fdt, offset1, "pin");
             if (0 >= offset2) {
                 blog_info("uart[%d] pin NULL.\r\n", i);
                 break;
             }
-            addr_prop = fdt_getprop(fdt, offset2, feature_pin[j].pin_name, &lentmp);
+            addr_prop = blfdt_getprop(fdt, offset2, feature_pin[j].pin_name, &lentmp);
             if (addr_prop == NULL) {
                 blog_info("uart[%d] %s NULL.\r\n", i, feature_pin[j].pin_name);
                 continue;
@@ -0,0 +1,9 @@
+/* Host test stand-in for the sources under test */
+#ifndef TEST_FREERTOS_H
+#define TEST_FREERTOS_H
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+
+#endif
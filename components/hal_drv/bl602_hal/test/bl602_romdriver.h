@@ -0,0 +1,87 @@
+/* Host test stand-in for the sources under test. mstatus is a variable
+ * and turning MIE on lets the test deliver what is pending.
+ */
+#ifndef TEST_BL602_ROMDRIVER_H
+#define TEST_BL602_ROMDRIVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ATTR_TCM_SECTION
+
+#define MSTATUS_MIE                 0x00000008
+#define read_csr(reg)               (test_##reg)
+
+extern unsigned long test_mstatus;
+void test_irq_on(void);
+
+static inline void __disable_irq(void)
+{
+    test_mstatus &= ~MSTATUS_MIE;
+}
+
+static inline void __enable_irq(void)
+{
+    test_mstatus |= MSTATUS_MIE;
+    test_irq_on();
+}
+
+typedef enum {
+    RESET = 0,
+    SET = 1,
+} BL_Sts_Type;
+
+typedef enum {
+    SUCCESS = 0,
+    ERROR = 1,
+} BL_Err_Type;
+
+#define SF_CTRL_READ                0
+#define SF_CTRL_QIO_MODE            4
+#define SF_CTRL_OWNER_SAHB          0
+#define BFLB_SPIFLASH_BLK32K_SIZE   (32 * 1024)
+#define BFLB_SPIFLASH_BLK64K_SIZE   (64 * 1024)
+#define BFLB_SPIFLASH_CMD_INVALID   0xff
+
+typedef struct {
+    uint8_t mid;
+    uint8_t clkDelay;
+    uint8_t clkInvert;
+    uint8_t sectorSize;
+    uint16_t pageSize;
+    uint8_t sectorEraseCmd;
+    uint8_t blk32EraseCmd;
+    uint8_t blk64EraseCmd;
+    uint16_t timeEsector;
+    uint16_t timeE32k;
+    uint16_t timeE64k;
+} SPI_Flash_Cfg_Type;
+
+typedef struct {
+    uint8_t rwFlag;
+    uint8_t addrSize;
+    uint32_t nbData;
+    uint32_t cmdBuf[2];
+} SF_Ctrl_Cmd_Cfg_Type;
+
+void RomDriver_BL602_MemSet(void *s, uint8_t c, uint32_t n);
+void RomDriver_SF_Ctrl_SendCmd(SF_Ctrl_Cmd_Cfg_Type *cfg);
+void RomDriver_SF_Ctrl_Set_Owner(int owner);
+uint32_t RomDriver_SF_Ctrl_Get_Flash_Image_Offset(void);
+void RomDriver_SF_Ctrl_Set_Flash_Image_Offset(uint32_t offset);
+BL_Err_Type RomDriver_SFlash_Write_Enable(SPI_Flash_Cfg_Type *cfg);
+BL_Sts_Type RomDriver_SFlash_Busy(SPI_Flash_Cfg_Type *cfg);
+BL_Err_Type RomDriver_SFlash_Program(SPI_Flash_Cfg_Type *cfg, int io_mode,
+        uint32_t addr, uint8_t *data, uint32_t len);
+void RomDriver_SFlash_Reset_Continue_Read(SPI_Flash_Cfg_Type *cfg);
+BL_Err_Type RomDriver_SFlash_Set_IDbus_Cfg(SPI_Flash_Cfg_Type *cfg, int io_mode,
+        uint8_t cont_read, uint32_t addr, uint32_t len);
+void RomDriver_XIP_SFlash_Opt_Enter(uint8_t *aes);
+void RomDriver_XIP_SFlash_Opt_Exit(uint8_t aes);
+BL_Err_Type RomDriver_XIP_SFlash_State_Save(SPI_Flash_Cfg_Type *cfg, uint32_t *offset);
+BL_Err_Type RomDriver_XIP_SFlash_State_Restore(SPI_Flash_Cfg_Type *cfg, uint32_t offset);
+BL_Err_Type RomDriver_XIP_SFlash_Read_With_Lock(SPI_Flash_Cfg_Type *cfg,
+        uint32_t addr, uint8_t *data, uint32_t len);
+
+#endif
@@ -0,0 +1,10 @@
+/* Host test stand-in for the sources under test */
+#ifndef TEST_BLOG_H
+#define TEST_BLOG_H
+
+#define blog_debug(...) do {} while (0)
+#define blog_info(...) do {} while (0)
+#define blog_warn(...) do {} while (0)
+#define blog_error(...) do {} while (0)
+
+#endif
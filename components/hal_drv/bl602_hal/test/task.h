@@ -0,0 +1,23 @@
+/* Host test stand-in for the sources under test. The critical section
+ * nests and turns interrupts back on at the outermost exit once the
+ * scheduler has started, suspended or not, like the port does.
+ */
+#ifndef TEST_TASK_H
+#define TEST_TASK_H
+
+#include "FreeRTOS.h"
+
+#define taskSCHEDULER_SUSPENDED     0
+#define taskSCHEDULER_NOT_STARTED   1
+#define taskSCHEDULER_RUNNING       2
+
+BaseType_t xTaskGetSchedulerState(void);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+void vTaskEnterCritical(void);
+void vTaskExitCritical(void);
+
+#define taskENTER_CRITICAL() vTaskEnterCritical()
+#define taskEXIT_CRITICAL() vTaskExitCritical()
+
+#endif
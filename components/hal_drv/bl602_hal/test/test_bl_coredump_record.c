@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Host test of the crash record format: the writer against a fake flash
+ * that only takes writes to erased bytes, the checker and the section
+ * walk. From this directory:
+ *
+ *   gcc -I.. -I../../../utils/include test_bl_coredump_record.c \
+ *       ../bl_coredump_record.c ../../../utils/src/utils_crc.c -o test_bl_coredump_record
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <utils_crc.h>
+
+#include "bl_coredump_record.h"
+
+#define FLASH_SIZE      4096
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\r\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+/* word aligned like the buffer the firmware reads the record into */
+static uint32_t flash_words[FLASH_SIZE / 4];
+static uint8_t *flash = (uint8_t *)flash_words;
+static int flash_writes;
+static int flash_fail_at;       /* fail the nth write, 0 never */
+static uint32_t flash_max_len;
+
+static void flash_erase(void)
+{
+    memset(flash, 0xff, FLASH_SIZE);
+    flash_writes = 0;
+    flash_fail_at = 0;
+    flash_max_len = 0;
+}
+
+static int flash_out(void *arg, uint32_t off, const void *data, uint32_t len)
+{
+    uint32_t i;
+
+    CHECK(arg == flash, "arg %p", arg);
+    if (++flash_writes == flash_fail_at) {
+        return -1;
+    }
+    CHECK(off + len <= FLASH_SIZE, "write %u+%u past the end", off, len);
+    for (i = 0; i < len; i++) {
+        CHECK(0xff == flash[off + i], "write %u+%u over programmed byte %u", off, len, off + i);
+    }
+    if (len > flash_max_len) {
+        flash_max_len = len;
+    }
+    memcpy(flash + off, data, len);
+    return 0;
+}
+
+static const bl_coredump_sec_t *find(const bl_coredump_sec_t *sec, uint16_t type)
+{
+    for (sec = bl_coredump_next(flash, NULL); sec; sec = bl_coredump_next(flash, sec)) {
+        if (type == sec->type) {
+            return sec;
+        }
+    }
+    return NULL;
+}
+
+static void test_crc(void)
+{
+    char s[] = "123456789";
+    uint32_t crc;
+
+    CHECK(0xCBF43926 == utils_crc32(s, 9), "crc32 %08x", utils_crc32(s, 9));
+    crc = utils_crc32_update(0, s, 4);
+    crc = utils_crc32_update(crc, s + 4, 5);
+    CHECK(utils_crc32(s, 9) == crc, "chained crc32 %08x", crc);
+    CHECK(0 == utils_crc32_update(0, s, 0), "crc32 of nothing");
+}
+
+static void test_round_trip(void)
+{
+    static bl_coredump_writer_t w;
+    static uint8_t stack[700];
+    bl_coredump_regs_t regs;
+    bl_coredump_heap_t heap = {12345, 678};
+    bl_coredump_task_t task;
+    bl_coredump_part_t part[2];
+    const bl_coredump_hdr_t *hdr = (const bl_coredump_hdr_t *)flash;
+    const bl_coredump_sec_t *sec;
+    uint32_t addr = 0x42020000, i;
+    int ret, n;
+
+    for (i = 0; i < sizeof(stack); i++) {
+        stack[i] = i * 7;
+    }
+    memset(&regs, 0, sizeof(regs));
+    regs.mcause = 5;
+    regs.mepc = 0x23001234;
+    for (i = 1; i < 32; i++) {
+        regs.x[i] = 0x100 * i;
+    }
+    memset(&task, 0, sizeof(task));
+    task.handle = 0x42021000;
+    strcpy(task.name, "IDLE");
+
+    flash_erase();
+    bl_coredump_begin(&w, flash_out, flash, FLASH_SIZE);
+    part[0].data = &regs;
+    part[0].len = sizeof(regs);
+    CHECK(sizeof(regs) == bl_coredump_section(&w, BL_COREDUMP_SEC_REGS, part, 1), "regs");
+    part[0].data = "boom";
+    part[0].len = 5;
+    CHECK(5 == bl_coredump_section(&w, BL_COREDUMP_SEC_MSG, part, 1), "msg");
+    part[0].data = &heap;
+    part[0].len = sizeof(heap);
+    CHECK(sizeof(heap) == bl_coredump_section(&w, BL_COREDUMP_SEC_HEAP, part, 1), "heap");
+    part[0].data = &addr;
+    part[0].len = 4;
+    part[1].data = stack;
+    part[1].len = sizeof(stack);
+    CHECK(4 + sizeof(stack) == bl_coredump_section(&w, BL_COREDUMP_SEC_STACK, part, 2), "stack");
+    for (n = 0; n < 3; n++) {
+        task.prio = n;
+        part[0].data = &task;
+        part[0].len = sizeof(task);
+        part[1].data = stack + n;
+        part[1].len = 61;
+        CHECK(sizeof(task) + 61 == bl_coredump_section(&w, BL_COREDUMP_SEC_TASK, part, 2), "task %d", n);
+    }
+    /* nothing reaches the flash at offset 0 before the end */
+    CHECK(0xffffffff == hdr->magic, "header written early");
+    ret = bl_coredump_end(&w, BL_COREDUMP_FAULT, 4321);
+    CHECK(ret > 0 && (uint32_t)ret == hdr->length, "end %d, length %u", ret, hdr->length);
+    CHECK(flash_max_len <= BL_COREDUMP_CHUNK, "write of %u", flash_max_len);
+
+    CHECK(0 == bl_coredump_check(flash, FLASH_SIZE), "check");
+    CHECK(0 == bl_coredump_check(flash, hdr->length), "check, exact size");
+    CHECK(BL_COREDUMP_FAULT == hdr->reason && 4321 == hdr->uptime_ms, "reason %u uptime %u",
+            hdr->reason, hdr->uptime_ms);
+    CHECK(0 == strcmp("fault", bl_coredump_reason_str(hdr->reason)), "reason str");
+
+    sec = find(NULL, BL_COREDUMP_SEC_REGS);
+    CHECK(sec && sizeof(regs) == sec->len && 0 == memcmp(sec + 1, &regs, sizeof(regs)), "regs back");
+    sec = find(NULL, BL_COREDUMP_SEC_MSG);
+    CHECK(sec && 5 == sec->len && 0 == memcmp(sec + 1, "boom", 5), "msg back");
+    sec = find(NULL, BL_COREDUMP_SEC_HEAP);
+    CHECK(sec && 0 == memcmp(sec + 1, &heap, sizeof(heap)), "heap back");
+    sec = find(NULL, BL_COREDUMP_SEC_STACK);
+    CHECK(sec && 4 + sizeof(stack) == sec->len && 0 == memcmp(sec + 1, &addr, 4) &&
+            0 == memcmp((const uint8_t *)(sec + 1) + 4, stack, sizeof(stack)), "stack back");
+
+    n = 0;
+    for (sec = bl_coredump_next(flash, NULL); sec; sec = bl_coredump_next(flash, sec)) {
+        const bl_coredump_task_t *t = (const bl_coredump_task_t *)(sec + 1);
+
+        CHECK(0 == ((const uint8_t *)sec - flash) % 4, "section at %d", (int)((const uint8_t *)sec - flash));
+        if (BL_COREDUMP_SEC_TASK != sec->type) {
+            continue;
+        }
+        CHECK(t->prio == n && 0 == strcmp("IDLE", t->name) &&
+                0 == memcmp(t + 1, stack + n, 61), "task %d back", n);
+        n++;
+    }
+    CHECK(3 == n, "%d tasks", n);
+
+    /* any flipped bit fails the check */
+    flash[100] ^= 0x10;
+    CHECK(0 != bl_coredump_check(flash, FLASH_SIZE), "check, flipped bit");
+    flash[100] ^= 0x10;
+    flash[2] ^= 1;
+    CHECK(0 != bl_coredump_check(flash, FLASH_SIZE), "check, bad magic");
+    flash[2] ^= 1;
+    CHECK(0 != bl_coredump_check(flash, hdr->length - 4), "check, short");
+    CHECK(0 != bl_coredump_check(flash, 8), "check, no header");
+}
+
+static void test_truncate(void)
+{
+    static bl_coredump_writer_t w;
+    static uint8_t big[2000];
+    const bl_coredump_sec_t *sec;
+    bl_coredump_part_t part[2];
+    uint32_t head = 0x11223344, size = 256;
+    int ret;
+
+    memset(big, 0x5a, sizeof(big));
+    flash_erase();
+    bl_coredump_begin(&w, flash_out, flash, size);
+
+    /* the last part is cut to what is left, in whole words */
+    part[0].data = &head;
+    part[0].len = 4;
+    part[1].data = big;
+    part[1].len = 150;
+    ret = bl_coredump_section(&w, BL_COREDUMP_SEC_STACK, part, 2);
+    CHECK(154 == ret, "first %d", ret);
+    ret = bl_coredump_section(&w, BL_COREDUMP_SEC_STACK, part, 2);
+    /* 256 - 24 header - 4 - 156 - 4 left for data */
+    CHECK(68 == ret, "cut %d", ret);
+    /* no room for even the section header */
+    ret = bl_coredump_section(&w, BL_COREDUMP_SEC_LOG, part, 1);
+    CHECK(-1 == ret, "full %d", ret);
+    CHECK(size == w.off, "off %u", w.off);
+    CHECK(size == (uint32_t)bl_coredump_end(&w, BL_COREDUMP_ASSERT, 0), "end");
+    CHECK(0 == bl_coredump_check(flash, size), "check");
+    sec = bl_coredump_next(flash, bl_coredump_next(flash, NULL));
+    CHECK(sec && 68 == sec->len && 0 == memcmp(sec + 1, &head, 4), "cut section");
+    CHECK(NULL == bl_coredump_next(flash, sec), "two sections");
+
+    /* the section goes when the first parts do not fit */
+    flash_erase();
+    bl_coredump_begin(&w, flash_out, flash, 64);
+    part[0].data = big;
+    part[0].len = 40;
+    part[1].data = big;
+    part[1].len = 10;
+    CHECK(-1 == bl_coredump_section(&w, BL_COREDUMP_SEC_TASK, part, 2), "dropped");
+    part[1].len = 1;
+    part[0].len = 30;
+    CHECK(31 == bl_coredump_section(&w, BL_COREDUMP_SEC_TASK, part, 2), "after drop");
+    ret = bl_coredump_end(&w, BL_COREDUMP_ASSERT, 0);
+    CHECK(24 + 4 + 32 == ret && 0 == bl_coredump_check(flash, 64), "end %d", ret);
+}
+
+static void test_header_only(void)
+{
+    static bl_coredump_writer_t w;
+    const bl_coredump_hdr_t *hdr = (const bl_coredump_hdr_t *)flash;
+
+    flash_erase();
+    bl_coredump_begin(&w, flash_out, flash, FLASH_SIZE);
+    CHECK(sizeof(*hdr) == bl_coredump_end(&w, BL_COREDUMP_WATCHDOG, 0), "end");
+    CHECK(0 == bl_coredump_check(flash, FLASH_SIZE), "check");
+    CHECK(NULL == bl_coredump_next(flash, NULL), "no sections");
+    CHECK(0 == strcmp("watchdog", bl_coredump_reason_str(hdr->reason)), "reason");
+
+    /* erased flash is no record */
+    flash_erase();
+    CHECK(0 != bl_coredump_check(flash, FLASH_SIZE), "erased");
+
+    /* not even room for the header */
+    bl_coredump_begin(&w, flash_out, flash, sizeof(*hdr) - 1);
+    CHECK(-1 == bl_coredump_end(&w, BL_COREDUMP_WATCHDOG, 0), "tiny");
+}
+
+static void test_write_error(void)
+{
+    static bl_coredump_writer_t w;
+    static uint8_t big[1000];
+    bl_coredump_part_t part;
+    int i;
+
+    /* a failed chunk leaves no header, so no record */
+    for (i = 1; i <= 5; i++) {
+        flash_erase();
+        flash_fail_at = i;
+        bl_coredump_begin(&w, flash_out, flash, FLASH_SIZE);
+        part.data = big;
+        part.len = sizeof(big);
+        bl_coredump_section(&w, BL_COREDUMP_SEC_STACK, &part, 1);
+        CHECK(-1 == bl_coredump_end(&w, BL_COREDUMP_FAULT, 0), "write %d failed", i);
+        CHECK(0 != bl_coredump_check(flash, FLASH_SIZE), "write %d failed, check", i);
+        CHECK(-1 == bl_coredump_section(&w, BL_COREDUMP_SEC_STACK, &part, 1), "after error");
+    }
+}
+
+int main(void)
+{
+    test_crc();
+    test_round_trip();
+    test_truncate();
+    test_header_only();
+    test_write_error();
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Host test of the window arithmetic behind "top": deltas across counter
+ * wraps, tasks created and deleted in the window, the sort and the shares.
+ * From this directory:
+ *
+ *   gcc -I.. test_bl_cpu_prof_stat.c ../bl_cpu_prof_stat.c -o test_bl_cpu_prof_stat
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bl_cpu_prof_stat.h"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\r\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+#define N(a)    ((int)(sizeof(a) / sizeof((a)[0])))
+
+static void test_tasks(void)
+{
+    /* 0x20 is deleted in the window, 0x50 created in it */
+    static const bl_cpu_prof_sample_t start[] = {
+        {0x10, 1000, 0},
+        {0x20, 5000, 0},
+        {0x30, 0xfffffff0, 0},
+        {0x40, 7, 0},
+    };
+    static const bl_cpu_prof_sample_t end[] = {
+        {0x40, 7, 0},
+        {0x30, 0x000003d0, 0},
+        {0x50, 300, 0},
+        {0x10, 9000, 0},
+    };
+    bl_cpu_prof_row_t rows[N(end)];
+    int n;
+
+    n = bl_cpu_prof_delta(start, N(start), end, N(end), 10000, rows);
+    CHECK(4 == n, "%d rows", n);
+    CHECK(0x10 == rows[0].key && 8000 == rows[0].time && 800 == rows[0].permille,
+            "row 0: %lx %u %u", (unsigned long)rows[0].key, rows[0].time, rows[0].permille);
+    /* across the wrap */
+    CHECK(0x30 == rows[1].key && 0x3e0 == rows[1].time && 99 == rows[1].permille,
+            "row 1: %lx %u %u", (unsigned long)rows[1].key, rows[1].time, rows[1].permille);
+    /* new in the window, counts from 0 */
+    CHECK(0x50 == rows[2].key && 300 == rows[2].time && 30 == rows[2].permille,
+            "row 2: %lx %u %u", (unsigned long)rows[2].key, rows[2].time, rows[2].permille);
+    CHECK(0x40 == rows[3].key && 0 == rows[3].time && 0 == rows[3].permille,
+            "row 3: %lx %u %u", (unsigned long)rows[3].key, rows[3].time, rows[3].permille);
+}
+
+static void test_irqs(void)
+{
+    static const bl_cpu_prof_sample_t start[] = {
+        {23, 100, 10},
+        {59, 0xfffffffe, 0xffffffff},
+    };
+    static const bl_cpu_prof_sample_t end[] = {
+        {23, 100, 10},
+        {59, 50, 4},
+        {60, 25, 1},
+    };
+    bl_cpu_prof_row_t rows[N(end)];
+    int n;
+
+    n = bl_cpu_prof_delta(start, N(start), end, N(end), 1000, rows);
+    CHECK(3 == n, "%d rows", n);
+    CHECK(59 == rows[0].key && 52 == rows[0].time && 5 == rows[0].count && 52 == rows[0].permille,
+            "irq 59: %u %u %u", rows[0].time, rows[0].count, rows[0].permille);
+    CHECK(60 == rows[1].key && 25 == rows[1].time && 1 == rows[1].count, "irq 60");
+    CHECK(23 == rows[2].key && 0 == rows[2].count, "irq 23 idle");
+}
+
+static void test_shares(void)
+{
+    bl_cpu_prof_sample_t end[3] = {
+        {1, 1, 0},              /* 0.05% rounds up to 0.1% */
+        {2, 3000, 0},           /* more than the window, clamped */
+        {3, 0, 0},
+    };
+    bl_cpu_prof_row_t rows[3];
+    int n, i;
+
+    n = bl_cpu_prof_delta(NULL, 0, end, 3, 2000, rows);
+    CHECK(3 == n && 2 == rows[0].key && 1000 == rows[0].permille, "clamp %u", rows[0].permille);
+    CHECK(1 == rows[1].key && 1 == rows[1].permille, "round %u", rows[1].permille);
+
+    /* a zero window has no shares */
+    n = bl_cpu_prof_delta(NULL, 0, end, 3, 0, rows);
+    for (i = 0; i < n; i++) {
+        CHECK(0 == rows[i].permille, "row %d of a zero window", i);
+    }
+
+    /* equal times keep their order */
+    for (i = 0; i < 3; i++) {
+        end[i].time = 10;
+    }
+    n = bl_cpu_prof_delta(NULL, 0, end, 3, 100, rows);
+    CHECK(1 == rows[0].key && 2 == rows[1].key && 3 == rows[2].key, "stable");
+
+    CHECK(0 == bl_cpu_prof_delta(end, 3, NULL, 0, 100, rows), "no tasks left");
+}
+
+int main(void)
+{
+    test_tasks();
+    test_irqs();
+    test_shares();
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
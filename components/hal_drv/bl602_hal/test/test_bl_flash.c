@@ -0,0 +1,515 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Host test of the step scheduler of bl_flash.c on a simulated part that
+ * erases in real time and may suspend. Two interrupt sources with their
+ * handlers in flash fire all the time and must never run while XIP is off,
+ * and other tasks get the CPU between steps but never while an erase is
+ * suspended. mtime wraps during the first erase. From this directory:
+ *
+ *   gcc -Wno-int-to-pointer-cast -I. test_bl_flash.c -o test_bl_flash
+ *   ./test_bl_flash
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../bl_flash.c"
+
+#define FLASH_SIZE      (1024 * 1024)
+#define SLOW            0
+#define FAST            1
+#define ISR_US          5
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+uint8_t __boot2_flashCfg_src;
+unsigned long test_mstatus = MSTATUS_MIE;
+static uint32_t mtime = 0u - 200000;   /* 20ms before the wrap */
+
+/* the part */
+static uint8_t mem[FLASH_SIZE];
+static int wel, erasing, suspended, suspend_us, suspend_caps;
+static uint32_t erase_addr, erase_len;
+static int32_t erase_us;
+static int xip_off, xip_faults, aborted;
+
+/* the interrupts */
+static struct {
+    uint32_t period_us;
+    uint32_t next;
+    uint32_t raised;
+    int pending;
+    uint32_t runs;
+    uint32_t worst_us;
+} irq[2] = {
+    [SLOW] = {.period_us = 700},
+    [FAST] = {.period_us = 300},
+};
+static int in_isr;
+
+/* the scheduler */
+static int sched_state = taskSCHEDULER_RUNNING;
+static int sched_depth, nesting, task_runs, seen_suspended;
+
+static void irq_deliver(void)
+{
+    int i;
+
+    if (in_isr || !(test_mstatus & MSTATUS_MIE)) {
+        return;
+    }
+    for (i = 0; i < 2; i++) {
+        if (!irq[i].pending) {
+            continue;
+        }
+        if (xip_off) {
+            xip_faults++;
+        }
+        if ((mtime - irq[i].raised) / 10 > irq[i].worst_us) {
+            irq[i].worst_us = (mtime - irq[i].raised) / 10;
+        }
+        irq[i].pending = 0;
+        irq[i].runs++;
+        in_isr = 1;
+        mtime += ISR_US * 10;
+        in_isr = 0;
+    }
+}
+
+static void tick(uint32_t us)
+{
+    int i;
+
+    mtime += us * 10;
+    if (erasing && !suspended) {
+        if (suspend_us && (suspend_us -= us) <= 0) {
+            suspend_us = 0;
+            suspended = 1;
+        }
+        if ((erase_us -= us) <= 0) {
+            memset(mem + erase_addr, 0xFF, erase_len);
+            erasing = 0;
+            suspended = 0;
+            suspend_us = 0;
+        }
+    }
+    for (i = 0; i < 2; i++) {
+        while ((int32_t)(mtime - irq[i].next) >= 0) {
+            if (!irq[i].pending) {
+                irq[i].pending = 1;
+                irq[i].raised = irq[i].next;
+            }
+            irq[i].next += irq[i].period_us * 10;
+        }
+    }
+    irq_deliver();
+}
+
+static void run(uint32_t us)
+{
+    for (; us > 10; us -= 10) {
+        tick(10);
+    }
+    tick(us);
+}
+
+void test_irq_on(void)
+{
+    irq_deliver();
+}
+
+uint32_t bl_timer_now_ticks(void)
+{
+    return mtime;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    if (taskSCHEDULER_RUNNING == sched_state && sched_depth) {
+        return taskSCHEDULER_SUSPENDED;
+    }
+    return sched_state;
+}
+
+void vTaskSuspendAll(void)
+{
+    sched_depth++;
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    CHECK(sched_depth > 0, "resume of a running scheduler");
+    if (0 == --sched_depth) {
+        /* other tasks may read the flash now */
+        task_runs++;
+        seen_suspended += suspended;
+    }
+    return 0;
+}
+
+/* as in tasks.c, which counts the nesting once the scheduler has started
+ * and does not look at whether it is suspended
+ */
+void vTaskEnterCritical(void)
+{
+    __disable_irq();
+    if (taskSCHEDULER_NOT_STARTED != sched_state) {
+        nesting++;
+    }
+}
+
+void vTaskExitCritical(void)
+{
+    if (taskSCHEDULER_NOT_STARTED == sched_state || 0 == nesting) {
+        return;
+    }
+    /* a tick here switches tasks unless the scheduler is suspended */
+    if (1 == nesting && 0 == sched_depth) {
+        task_runs++;
+        seen_suspended += suspended;
+    }
+    if (0 == --nesting) {
+        __enable_irq();
+    }
+}
+
+void RomDriver_BL602_MemSet(void *s, uint8_t c, uint32_t n)
+{
+    memset(s, c, n);
+}
+
+void RomDriver_SF_Ctrl_SendCmd(SF_Ctrl_Cmd_Cfg_Type *cfg)
+{
+    uint8_t cmd = cfg->cmdBuf[0] >> 24;
+    uint32_t addr = cfg->cmdBuf[0] & 0xFFFFFF;
+
+    tick(2);
+    if (0x20 == cmd || 0x52 == cmd || 0xD8 == cmd) {
+        CHECK(wel && !erasing, "erase while busy");
+        erase_len = (0x20 == cmd) ? 4096 : (0x52 == cmd) ? 32768 : 65536;
+        erase_us = (0x20 == cmd) ? 45000 : (0x52 == cmd) ? 120000 : 150000;
+        CHECK(0 == addr % erase_len, "erase of %u at %06x", erase_len, addr);
+        erase_addr = addr;
+        erasing = 1;
+        wel = 0;
+    } else if (0x75 == cmd && suspend_caps) {
+        if (erasing && !suspended) {
+            suspend_us = 30;
+        }
+    } else if (0x7A == cmd && suspend_caps) {
+        CHECK(erasing && suspended, "resume of no suspended erase");
+        suspended = 0;
+    }
+}
+
+void RomDriver_SF_Ctrl_Set_Owner(int owner)
+{
+}
+
+uint32_t RomDriver_SF_Ctrl_Get_Flash_Image_Offset(void)
+{
+    return 0x2000;
+}
+
+void RomDriver_SF_Ctrl_Set_Flash_Image_Offset(uint32_t offset)
+{
+}
+
+BL_Err_Type RomDriver_SFlash_Write_Enable(SPI_Flash_Cfg_Type *cfg)
+{
+    tick(2);
+    wel = 1;
+    return SUCCESS;
+}
+
+BL_Sts_Type RomDriver_SFlash_Busy(SPI_Flash_Cfg_Type *cfg)
+{
+    tick(10);
+    return (erasing && !suspended) ? SET : RESET;
+}
+
+BL_Err_Type RomDriver_SFlash_Program(SPI_Flash_Cfg_Type *cfg, int io_mode,
+        uint32_t addr, uint8_t *data, uint32_t len)
+{
+    uint32_t i;
+
+    CHECK(!erasing, "program while erasing");
+    CHECK(addr / 256 == (addr + len - 1) / 256, "%u bytes at %06x cross a page",
+            len, addr);
+    for (i = 0; i < len; i++) {
+        mem[addr + i] &= data[i];
+    }
+    run(700);
+    return SUCCESS;
+}
+
+void RomDriver_SFlash_Reset_Continue_Read(SPI_Flash_Cfg_Type *cfg)
+{
+}
+
+BL_Err_Type RomDriver_SFlash_Set_IDbus_Cfg(SPI_Flash_Cfg_Type *cfg, int io_mode,
+        uint8_t cont_read, uint32_t addr, uint32_t len)
+{
+    return SUCCESS;
+}
+
+void RomDriver_XIP_SFlash_Opt_Enter(uint8_t *aes)
+{
+    CHECK(!(test_mstatus & MSTATUS_MIE), "XIP off with interrupts on");
+    *aes = 0;
+    xip_off = 1;
+}
+
+void RomDriver_XIP_SFlash_Opt_Exit(uint8_t aes)
+{
+    xip_off = 0;
+}
+
+BL_Err_Type RomDriver_XIP_SFlash_State_Save(SPI_Flash_Cfg_Type *cfg, uint32_t *offset)
+{
+    /* it sends a software reset */
+    aborted += erasing;
+    tick(20);
+    *offset = 0x2000;
+    return SUCCESS;
+}
+
+BL_Err_Type RomDriver_XIP_SFlash_State_Restore(SPI_Flash_Cfg_Type *cfg, uint32_t offset)
+{
+    tick(10);
+    return SUCCESS;
+}
+
+BL_Err_Type RomDriver_XIP_SFlash_Read_With_Lock(SPI_Flash_Cfg_Type *cfg,
+        uint32_t addr, uint8_t *data, uint32_t len)
+{
+    return SUCCESS;
+}
+
+static void setup(uint8_t mid, int caps)
+{
+    SPI_Flash_Cfg_Type *cfg = bl_flash_get_flashCfg();
+    int i;
+
+    cfg->mid = mid;
+    cfg->sectorSize = 4;
+    cfg->pageSize = 256;
+    cfg->sectorEraseCmd = 0x20;
+    cfg->blk32EraseCmd = 0x52;
+    cfg->blk64EraseCmd = 0xD8;
+    cfg->timeEsector = 300;
+    cfg->timeE32k = 1200;
+    cfg->timeE64k = 1200;
+    suspend_caps = caps;
+    bl_flash_stats_reset();
+
+    memset(mem, 0, sizeof(mem));
+    for (i = 0; i < 2; i++) {
+        irq[i].next = mtime + irq[i].period_us * 10;
+        irq[i].pending = 0;
+        irq[i].runs = 0;
+        irq[i].worst_us = 0;
+    }
+    xip_faults = 0;
+    aborted = 0;
+    task_runs = 0;
+    seen_suspended = 0;
+}
+
+static int erased(uint32_t addr, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = addr; i < addr + len; i++) {
+        if (0xFF != mem[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void check_idle(const char *name)
+{
+    CHECK(!erasing && !xip_off, "%s: erasing %d XIP off %d", name, erasing, xip_off);
+    CHECK(0 == sched_depth && 0 == nesting, "%s: scheduler %d critical %d",
+            name, sched_depth, nesting);
+    CHECK(0 == xip_faults && 0 == aborted && 0 == seen_suspended,
+            "%s: %d XIP faults, %d erases aborted, %d task switches with a suspended erase",
+            name, xip_faults, aborted, seen_suspended);
+}
+
+static void test_suspend_erase(void)
+{
+    bl_flash_stats_t stats;
+
+    setup(0xC8, 1);
+    CHECK(0 == bl_flash_erase(0x11000 + 100, 200 * 1024), "erase");
+    CHECK(erased(0x11000, 100 + 200 * 1024) && 0 == mem[0x10FFF] &&
+            0 == mem[0x11000 + 100 + 200 * 1024 + 4095], "erased range");
+    check_idle("suspend");
+
+    bl_flash_stats_get(&stats);
+    CHECK(stats.irq_off_max_us < BL_FLASH_STEP_BUDGET_US + 200 && stats.suspends > 100,
+            "%u us with interrupts off, %u suspends", stats.irq_off_max_us, stats.suspends);
+    /* 7 sectors, a 32K block, two 64K blocks and 4 sectors */
+    CHECK(14 == task_runs, "%d task switches", task_runs);
+    CHECK(irq[SLOW].worst_us < BL_FLASH_STEP_BUDGET_US + 200 && irq[SLOW].runs > 100,
+            "slow source %u runs, %u us late", irq[SLOW].runs, irq[SLOW].worst_us);
+    CHECK(irq[FAST].worst_us < BL_FLASH_STEP_BUDGET_US + 200 && irq[FAST].runs > 300,
+            "fast source %u runs, %u us late", irq[FAST].runs, irq[FAST].worst_us);
+}
+
+static void test_program(void)
+{
+    static uint8_t data[10000];
+    size_t i;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = rand();
+    }
+    setup(0xC8, 1);
+    memset(mem, 0xFF, sizeof(mem));
+    CHECK(0 == bl_flash_write(0x11000 + 77, data, sizeof(data)), "write");
+    CHECK(0 == memcmp(mem + 0x11000 + 77, data, sizeof(data)) &&
+            0xFF == mem[0x11000 + 76] && 0xFF == mem[0x11000 + 77 + sizeof(data)],
+            "programmed data");
+    check_idle("program");
+    CHECK(40 == task_runs, "%d task switches for 40 pages", task_runs);
+    CHECK(irq[FAST].worst_us < 1000, "fast source %u us late", irq[FAST].worst_us);
+}
+
+static void test_plain_erase(void)
+{
+    bl_flash_stats_t stats;
+    uint32_t steps;
+
+    setup(0x51, 0);
+    bl_flash_stats_get(&stats);
+    steps = stats.steps;
+    CHECK(0 == bl_flash_erase(0x20000, 64 * 1024), "erase");
+    CHECK(erased(0x20000, 64 * 1024) && 0 == mem[0x30000], "erased range");
+    check_idle("plain");
+
+    /* no block erases without suspend, a sector per step */
+    bl_flash_stats_get(&stats);
+    CHECK(16 == stats.steps - steps && 16 == task_runs, "%u steps, %d task switches",
+            stats.steps - steps, task_runs);
+    CHECK(stats.irq_off_max_us < 46000, "%u us with interrupts off", stats.irq_off_max_us);
+    CHECK(irq[FAST].worst_us < 46000, "fast source %u us late", irq[FAST].worst_us);
+}
+
+static void test_suspend_ignored(void)
+{
+    /* listed as suspending but it does not */
+    setup(0xEF, 0);
+    CHECK(0 == bl_flash_erase(0x40000, 8192), "erase");
+    CHECK(erased(0x40000, 8192), "erased range");
+    check_idle("ignored");
+}
+
+static void test_irq_off(void)
+{
+    setup(0xC8, 1);
+    taskENTER_CRITICAL();
+    CHECK(0 == bl_flash_erase(0x50000, 4096), "erase");
+    CHECK(0 == irq[SLOW].runs && 0 == irq[FAST].runs && !(test_mstatus & MSTATUS_MIE),
+            "interrupts ran in a critical section");
+    taskEXIT_CRITICAL();
+    CHECK(1 == irq[SLOW].runs && 1 == irq[FAST].runs, "pending interrupts lost");
+    check_idle("critical");
+
+    /* the crash handler: interrupts off and the scheduler suspended, where
+     * the exit of a critical section would turn them on
+     */
+    setup(0xC8, 1);
+    __disable_irq();
+    vTaskSuspendAll();
+    CHECK(0 == bl_flash_erase(0x50000, 64 * 1024), "erase");
+    CHECK(erased(0x50000, 64 * 1024), "erased range");
+    CHECK(0 == irq[SLOW].runs && 0 == irq[FAST].runs && !(test_mstatus & MSTATUS_MIE),
+            "interrupts ran with the scheduler suspended");
+    CHECK(1 == sched_depth && 0 == nesting, "scheduler %d critical %d", sched_depth, nesting);
+    sched_depth = 0;
+    __enable_irq();
+    check_idle("suspended");
+
+    /* before the scheduler starts MIE is left as it was, interrupts run
+     * between steps
+     */
+    setup(0xC8, 1);
+    sched_state = taskSCHEDULER_NOT_STARTED;
+    CHECK(0 == bl_flash_erase(0x50000, 64 * 1024), "erase");
+    CHECK((test_mstatus & MSTATUS_MIE) && irq[SLOW].runs > 0, "interrupts left off");
+    CHECK(0 == task_runs, "%d task switches", task_runs);
+    check_idle("not started");
+    sched_state = taskSCHEDULER_RUNNING;
+}
+
+static void test_timeout(void)
+{
+    SPI_Flash_Cfg_Type *cfg = bl_flash_get_flashCfg();
+    bl_flash_stats_t stats;
+    uint32_t errors;
+
+    setup(0xC8, 1);
+    bl_flash_stats_get(&stats);
+    errors = stats.errors;
+    cfg->timeEsector = 10;
+    CHECK(-1 == bl_flash_erase(0x60000, 4096), "erase did not time out");
+    bl_flash_stats_get(&stats);
+    CHECK(errors + 1 == stats.errors, "%u errors", stats.errors - errors);
+    CHECK(!suspended && 0 == sched_depth && 0 == nesting,
+            "suspended %d scheduler %d critical %d", suspended, sched_depth, nesting);
+    run(50000);
+}
+
+int main(void)
+{
+    test_suspend_erase();
+    test_program();
+    test_plain_erase();
+    test_suspend_ignored();
+    test_irq_off();
+    test_timeout();
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Host test of the GPIO interrupt demux: dispatch order of several pending
+ * pins, the debounce window across a wrap of the us counter, bounce counts,
+ * legacy chains shared between pins, re-attaching and detaching.
+ * From this directory:
+ *
+ *   gcc -I.. test_bl_gpio_demux.c ../bl_gpio_demux.c -o test_bl_gpio_demux
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bl_gpio_demux.h"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\r\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+#define LOG_MAX     16
+
+static struct {
+    uint8_t pin;
+    uint32_t time_us;
+    void *arg;
+} cb_log[LOG_MAX];
+static int cb_n;
+
+static void cb(uint8_t pin, uint32_t time_us, void *arg)
+{
+    if (cb_n < LOG_MAX) {
+        cb_log[cb_n].pin = pin;
+        cb_log[cb_n].time_us = time_us;
+        cb_log[cb_n].arg = arg;
+    }
+    cb_n++;
+}
+
+static gpio_ctx_t *legacy_log[LOG_MAX];
+static int legacy_n;
+
+static void legacy_handler(void *arg)
+{
+    if (legacy_n < LOG_MAX) {
+        legacy_log[legacy_n] = arg;
+    }
+    legacy_n++;
+}
+
+static void reset_log(void)
+{
+    cb_n = 0;
+    legacy_n = 0;
+}
+
+static void test_order(void)
+{
+    static bl_gpio_demux_t demux;
+    static int a, b, c;
+
+    bl_gpio_demux_attach(&demux, 17, 0, cb, &a);
+    bl_gpio_demux_attach(&demux, 3, 0, cb, &b);
+    bl_gpio_demux_attach(&demux, 0, 0, cb, &c);
+    CHECK(demux.attached == ((1U << 17) | (1U << 3) | 1U), "attached %08x", demux.attached);
+    CHECK(demux.cb_pins == demux.attached, "cb pins %08x", demux.cb_pins);
+
+    /* pin 5 pending but not attached */
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, (1U << 17) | (1U << 5) | (1U << 3) | 1U, 1234);
+    CHECK(3 == cb_n, "%d callbacks", cb_n);
+    CHECK(0 == cb_log[0].pin && &c == cb_log[0].arg, "first pin %u", cb_log[0].pin);
+    CHECK(3 == cb_log[1].pin && &b == cb_log[1].arg, "second pin %u", cb_log[1].pin);
+    CHECK(17 == cb_log[2].pin && &a == cb_log[2].arg, "third pin %u", cb_log[2].pin);
+    CHECK(1234 == cb_log[0].time_us && 1234 == cb_log[2].time_us, "time %u", cb_log[2].time_us);
+
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 0, 1300);
+    CHECK(0 == cb_n, "%d callbacks without pending", cb_n);
+}
+
+static void test_debounce(void)
+{
+    static bl_gpio_demux_t demux;
+    const uint32_t t0 = 0xffffff00;
+
+    bl_gpio_demux_attach(&demux, 8, 1000, cb, NULL);
+    bl_gpio_demux_attach(&demux, 9, 0, cb, NULL);
+
+    /* the first edge is accepted whatever the clock says */
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 1U << 8, t0);
+    CHECK(1 == cb_n && t0 == cb_log[0].time_us, "first edge: %d callbacks", cb_n);
+
+    /* bounces inside the window, across the wrap */
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 1U << 8, t0 + 10);
+    bl_gpio_demux_dispatch(&demux, 1U << 8, t0 + 0x100);
+    bl_gpio_demux_dispatch(&demux, 1U << 8, t0 + 999);
+    CHECK(0 == cb_n, "%d bounces passed", cb_n);
+    CHECK(3 == demux.slot[8].bounce, "%u bounces", demux.slot[8].bounce);
+
+    /* the window counts from the last accepted edge, not the last bounce */
+    bl_gpio_demux_dispatch(&demux, 1U << 8, t0 + 1000);
+    CHECK(1 == cb_n && t0 + 1000 == cb_log[0].time_us, "edge at the window: %d callbacks", cb_n);
+    CHECK(t0 + 1000 == demux.slot[8].last_us, "last %u", demux.slot[8].last_us);
+
+    /* no debounce on pin 9, every edge goes through */
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 1U << 9, 50);
+    bl_gpio_demux_dispatch(&demux, 1U << 9, 50);
+    bl_gpio_demux_dispatch(&demux, 1U << 9, 51);
+    CHECK(3 == cb_n && 0 == demux.slot[9].bounce, "%d callbacks, %u bounces", cb_n, demux.slot[9].bounce);
+
+    /* attaching again starts over */
+    bl_gpio_demux_attach(&demux, 8, 1000, cb, NULL);
+    CHECK(0 == demux.slot[8].bounce, "bounce kept %u", demux.slot[8].bounce);
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 1U << 8, t0 + 1001);
+    CHECK(1 == cb_n, "first edge after re-attach: %d callbacks", cb_n);
+}
+
+static void test_legacy(void)
+{
+    static bl_gpio_demux_t demux;
+    /* hal_gpio keeps one list for all pins, newest first */
+    gpio_ctx_t n4_old, n7, n4_new;
+
+    memset(&n4_old, 0, sizeof(n4_old));
+    memset(&n7, 0, sizeof(n7));
+    memset(&n4_new, 0, sizeof(n4_new));
+    n4_old.gpioPin = 4;
+    n4_old.gpio_handler = legacy_handler;
+    n7.gpioPin = 7;
+    n7.gpio_handler = legacy_handler;
+    n7.next = &n4_old;
+    n4_new.gpioPin = 4;
+    n4_new.gpio_handler = legacy_handler;
+    n4_new.next = &n7;
+
+    bl_gpio_demux_register(&demux, &n4_old);
+    bl_gpio_demux_register(&demux, &n7);
+    bl_gpio_demux_register(&demux, &n4_new);
+    CHECK(demux.attached == ((1U << 4) | (1U << 7)), "attached %08x", demux.attached);
+    CHECK(0 == demux.cb_pins, "cb pins %08x", demux.cb_pins);
+
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 1U << 4, 0);
+    CHECK(2 == legacy_n && &n4_new == legacy_log[0] && &n4_old == legacy_log[1],
+            "pin 4: %d handlers", legacy_n);
+
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 1U << 7, 0);
+    CHECK(1 == legacy_n && &n7 == legacy_log[0], "pin 7: %d handlers", legacy_n);
+
+    /* a node without a handler is skipped */
+    n4_old.gpio_handler = NULL;
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 1U << 4, 0);
+    CHECK(1 == legacy_n && &n4_new == legacy_log[0], "pin 4 without handler: %d", legacy_n);
+
+    /* attaching a callback takes the pin over from the chain */
+    bl_gpio_demux_attach(&demux, 4, 0, cb, NULL);
+    CHECK(demux.cb_pins == (1U << 4) && NULL == demux.slot[4].legacy, "cb pins %08x", demux.cb_pins);
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, (1U << 4) | (1U << 7), 0);
+    CHECK(1 == cb_n && 4 == cb_log[0].pin, "%d callbacks", cb_n);
+    CHECK(1 == legacy_n && &n7 == legacy_log[0], "%d handlers", legacy_n);
+
+    /* and registering gives it back */
+    bl_gpio_demux_register(&demux, &n4_new);
+    CHECK(0 == demux.cb_pins && NULL == demux.slot[4].cb, "cb pins %08x", demux.cb_pins);
+}
+
+static void test_detach(void)
+{
+    static bl_gpio_demux_t demux;
+
+    bl_gpio_demux_attach(&demux, 21, 500, cb, NULL);
+    bl_gpio_demux_dispatch(&demux, 1U << 21, 0);
+    bl_gpio_demux_dispatch(&demux, 1U << 21, 1);
+    CHECK(1 == demux.slot[21].bounce, "%u bounces", demux.slot[21].bounce);
+
+    bl_gpio_demux_detach(&demux, 21);
+    CHECK(0 == demux.attached && 0 == demux.cb_pins, "attached %08x", demux.attached);
+    CHECK(0 == demux.slot[21].bounce && NULL == demux.slot[21].cb, "slot kept");
+    reset_log();
+    bl_gpio_demux_dispatch(&demux, 1U << 21, 1000);
+    CHECK(0 == cb_n, "%d callbacks after detach", cb_n);
+}
+
+int main(void)
+{
+    test_order();
+    test_debounce();
+    test_legacy();
+    test_detach();
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Host test of the CTR_DRBG and the TRNG health tests of bl_sec_drbg.c. The
+ * block backend is the AES of tinycrypt with a 128 bit counter, so a run of
+ * the DRBG that wraps the 32 bit counter would show. The first vector is
+ * from the CAVP set for AES-128 without derivation function, the others were
+ * made with a separate CTR_DRBG on OpenSSL that gives the CAVP output too.
+ * From this directory:
+ *
+ *   gcc -I.. -I../../../network/ble/blestack/src/common/tinycrypt/include/tinycrypt \
+ *       test_bl_sec_drbg.c ../bl_sec_drbg.c \
+ *       ../../../network/ble/blestack/src/common/tinycrypt/source/aes_encrypt.c \
+ *       ../../../network/ble/blestack/src/common/tinycrypt/source/utils.c \
+ *       -o test_bl_sec_drbg
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <aes.h>
+
+#include "bl_sec_drbg.h"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+static int block_calls;
+static int block_error;
+
+static int aes_block(const uint8_t *key, const uint8_t *ctr, uint8_t *out, uint32_t blocks)
+{
+    struct tc_aes_key_sched_struct sched;
+    uint8_t c[BL_DRBG_BLOCK_LEN];
+    int i;
+
+    block_calls++;
+    if (block_error) {
+        return -1;
+    }
+    tc_aes128_set_encrypt_key(&sched, key);
+    memcpy(c, ctr, sizeof(c));
+    while (blocks--) {
+        tc_aes_encrypt(out, c, &sched);
+        out += BL_DRBG_BLOCK_LEN;
+        for (i = BL_DRBG_BLOCK_LEN - 1; i >= 0 && 0 == ++c[i]; i--) {
+        }
+    }
+    return 0;
+}
+
+static void check(const char *name, const uint8_t *out, int len, const char *hex)
+{
+    char buf[2 * 64 + 1];
+    int i;
+
+    for (i = 0; i < len; i++) {
+        sprintf(buf + 2 * i, "%02x", out[i]);
+    }
+    if (strcmp(buf, hex)) {
+        printf("FAIL %s\r\n  got %s\r\n  exp %s\r\n", name, buf, hex);
+        failures++;
+    } else {
+        printf("ok   %s\r\n", name);
+    }
+}
+
+static void unhex(uint8_t *out, const char *hex)
+{
+    unsigned int byte;
+
+    while (*hex && 1 == sscanf(hex, "%2x", &byte)) {
+        *out++ = byte;
+        hex += 2;
+    }
+}
+
+static void test_vectors(void)
+{
+    uint8_t entropy[BL_DRBG_SEED_LEN], entropy2[BL_DRBG_SEED_LEN], out[64];
+    bl_drbg_t drbg;
+    int i;
+
+    /* CAVP CTR_DRBG AES-128 no df, no reseed, COUNT = 0 */
+    unhex(entropy, "ce50f33da5d4c1d3d4004eb35244b7f2cd7f2e5076fbf6780a7ff634b249a5fc");
+    CHECK(0 == bl_drbg_instantiate(&drbg, aes_block, entropy, NULL, 0), "instantiate");
+    CHECK(0 == bl_drbg_generate(&drbg, out, 64, NULL, 0), "generate");
+    CHECK(0 == bl_drbg_generate(&drbg, out, 64, NULL, 0), "generate");
+    check("cavp count 0", out, 64, "6545c0529d372443b392ceb3ae3a99a30f963eaf313280f1d1a1e87f"
+            "9db373d361e75d18018266499cccd64d9bbb8de0185f213383080faddec46bae1f784e5a");
+
+    /* personalization, a partial block, additional input and a reseed */
+    for (i = 0; i < BL_DRBG_SEED_LEN; i++) {
+        entropy[i] = i;
+        entropy2[i] = BL_DRBG_SEED_LEN + i;
+    }
+    CHECK(0 == bl_drbg_instantiate(&drbg, aes_block, entropy, (const uint8_t *)"bl602", 5),
+            "instantiate");
+    CHECK(0 == bl_drbg_generate(&drbg, out, 37, NULL, 0), "generate");
+    check("personalization, 37 bytes", out, 37, "c5667ca99b773c47d5a58fcde1dee67e48e13d"
+            "fb4a7825fffe036cba54f45696da2abf3701");
+    CHECK(0 == bl_drbg_generate(&drbg, out, 64, (const uint8_t *)"additional", 10), "generate");
+    check("additional input", out, 64, "aa2dcbc5ed4387caea8e90231122f9171e8fde619be5adb782"
+            "54623d8d9cbd4eb7ae83a96acfb19a853a03f276ce5f3992169ceb76d83805d5cdf0768e042295");
+    CHECK(0 == bl_drbg_reseed(&drbg, entropy2, (const uint8_t *)"rs", 2), "reseed");
+    CHECK(0 == bl_drbg_generate(&drbg, out, 16, NULL, 0), "generate");
+    check("reseed", out, 16, "016e7a7a5e680c80b84bd0c7dd11a15c");
+
+    /* V two blocks before the wrap of its counter word */
+    memset(&drbg, 0, sizeof(drbg));
+    drbg.block = aes_block;
+    drbg.reseed_counter = 1;
+    memset(drbg.v + 12, 0xff, 4);
+    drbg.v[15] = 0xfe;
+    block_calls = 0;
+    CHECK(0 == bl_drbg_generate(&drbg, out, 64, NULL, 0), "generate");
+    check("counter wrap", out, 64, "28c16380c491088ca019f8a76853b1e866e94bd4ef8a2c3b884cfa"
+            "59ca342b2e58e2fccefa7e3061367f1d57a4e7455a0388dace60b6a392f328c2b971b2fe78");
+    check("counter wrap, key", drbg.key, 16, "f795aaab494b5923f7fd89ff948bc1e0");
+    check("counter wrap, v", drbg.v, 16, "200211214e7394da2089b6acd093abe0");
+    CHECK(block_calls > 2, "%d backend calls, the run was not split", block_calls);
+}
+
+static void test_errors(void)
+{
+    uint8_t entropy[BL_DRBG_SEED_LEN] = {0}, out[16];
+    bl_drbg_t drbg;
+    int i;
+
+    CHECK(-1 == bl_drbg_instantiate(&drbg, NULL, entropy, NULL, 0), "no backend");
+    CHECK(-1 == bl_drbg_instantiate(&drbg, aes_block, entropy, out, BL_DRBG_SEED_LEN + 1),
+            "long personalization");
+    CHECK(0 == bl_drbg_instantiate(&drbg, aes_block, entropy, NULL, 0), "instantiate");
+    CHECK(-1 == bl_drbg_generate(&drbg, out, BL_DRBG_MAX_REQUEST + 1, NULL, 0), "long request");
+    CHECK(-1 == bl_drbg_generate(&drbg, out, 1, entropy, BL_DRBG_SEED_LEN + 1), "long input");
+
+    /* the interval runs out, generate refuses until a reseed */
+    for (i = 0; i < BL_DRBG_RESEED_INTERVAL; i++) {
+        CHECK(0 == bl_drbg_generate(&drbg, out, 1, NULL, 0), "generate %d", i);
+    }
+    CHECK(bl_drbg_reseed_required(&drbg), "no reseed required");
+    CHECK(-1 == bl_drbg_generate(&drbg, out, 1, NULL, 0), "generate past the interval");
+    CHECK(0 == bl_drbg_reseed(&drbg, entropy, NULL, 0), "reseed");
+    CHECK(!bl_drbg_reseed_required(&drbg), "reseed required");
+    CHECK(0 == bl_drbg_generate(&drbg, out, 1, NULL, 0), "generate");
+
+    /* a backend error */
+    block_error = 1;
+    CHECK(-1 == bl_drbg_generate(&drbg, out, 16, NULL, 0), "generate");
+    CHECK(-1 == bl_drbg_instantiate(&drbg, aes_block, entropy, NULL, 0), "instantiate");
+    block_error = 0;
+    CHECK(NULL == drbg.block && bl_drbg_reseed_required(&drbg), "state kept");
+    CHECK(-1 == bl_drbg_generate(&drbg, out, 1, NULL, 0), "generate");
+    CHECK(-1 == bl_drbg_reseed(&drbg, entropy, NULL, 0), "reseed");
+}
+
+static void test_health(void)
+{
+    bl_trng_health_t health;
+    uint8_t buf[BL_TRNG_APT_WINDOW];
+    int i, j, fails = 0;
+
+    /* random samples, 2^-20 false positives */
+    srand(1);
+    bl_trng_health_init(&health);
+    for (i = 0; i < 2000; i++) {
+        for (j = 0; j < 32; j++) {
+            buf[j] = rand() >> 7;
+        }
+        fails += bl_trng_health_check(&health, buf, 32);
+    }
+    CHECK(0 == fails, "%d random samples failed", fails);
+
+    /* stuck, also across calls */
+    bl_trng_health_init(&health);
+    memset(buf, 0xaa, BL_TRNG_RCT_CUTOFF);
+    CHECK(0 == bl_trng_health_check(&health, buf, BL_TRNG_RCT_CUTOFF - 1), "stuck");
+    CHECK(-1 == bl_trng_health_check(&health, buf, 1) && 1 == health.rct_failures,
+            "stuck, %u repetition failures", (unsigned)health.rct_failures);
+
+    /* one value in 5 gives 102 per window */
+    bl_trng_health_init(&health);
+    for (i = 0; i < BL_TRNG_APT_WINDOW; i++) {
+        buf[i] = (i % 5) ? 0x56 + i % 100 : 0x55;
+    }
+    CHECK(-1 == bl_trng_health_check(&health, buf, BL_TRNG_APT_WINDOW) &&
+            health.apt_failures && !health.rct_failures, "biased, %u proportion failures",
+            (unsigned)health.apt_failures);
+
+    /* one in 10 gives 51, under the cutoff */
+    bl_trng_health_init(&health);
+    for (i = 0; i < BL_TRNG_APT_WINDOW; i++) {
+        buf[i] = (i % 10) ? 0x56 + i % 100 : 0x55;
+    }
+    CHECK(0 == bl_trng_health_check(&health, buf, BL_TRNG_APT_WINDOW), "slightly biased");
+}
+
+int main(void)
+{
+    test_vectors();
+    test_errors();
+    test_health();
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
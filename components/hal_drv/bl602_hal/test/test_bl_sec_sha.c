@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Host test of the SHA streams and HMAC against NIST/RFC vectors, the engine
+ * is replaced by utils_sha256 and a small SHA-1. From this directory:
+ *
+ *   gcc -I.. -I../../../utils/include test_bl_sec_sha.c ../bl_sec_sha_stream.c \
+ *       ../../../utils/src/utils_sha256.c -o test_bl_sec_sha
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <utils_sha256.h>
+
+#include "bl_sec_sha.h"
+#include "bl_sec_sha_engine.h"
+
+/* utils_sha1 needs the iot_import.h of its sdk, a bare SHA-1 does here */
+typedef struct {
+    uint32_t h[5];
+    uint64_t total;
+    uint8_t buf[64];
+} sha1_ctx_t;
+
+#define ROL(x, n)       (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void sha1_block(sha1_ctx_t *c, const uint8_t *p)
+{
+    uint32_t w[80], a, b, d, e, f, k, t, cc;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (i = 16; i < 80; i++) {
+        w[i] = ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    a = c->h[0]; b = c->h[1]; cc = c->h[2]; d = c->h[3]; e = c->h[4];
+    for (i = 0; i < 80; i++) {
+        if (i < 20) {
+            f = (b & cc) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ cc ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & cc) | (b & d) | (cc & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ cc ^ d;
+            k = 0xCA62C1D6;
+        }
+        t = ROL(a, 5) + f + e + k + w[i];
+        e = d; d = cc; cc = ROL(b, 30); b = a; a = t;
+    }
+    c->h[0] += a; c->h[1] += b; c->h[2] += cc; c->h[3] += d; c->h[4] += e;
+}
+
+static void sha1_starts(sha1_ctx_t *c)
+{
+    static const uint32_t iv[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    memcpy(c->h, iv, sizeof(iv));
+    c->total = 0;
+}
+
+static void sha1_update(sha1_ctx_t *c, const uint8_t *p, uint32_t len)
+{
+    while (len--) {
+        c->buf[c->total++ % 64] = *p++;
+        if (0 == c->total % 64) {
+            sha1_block(c, c->buf);
+        }
+    }
+}
+
+static void sha1_finish(sha1_ctx_t *c, uint8_t *out)
+{
+    uint64_t bits = c->total * 8;
+    uint8_t len[8];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        len[i] = bits >> (56 - 8 * i);
+    }
+    sha1_update(c, (const uint8_t *)"\x80", 1);
+    while (c->total % 64 != 56) {
+        sha1_update(c, (const uint8_t *)"", 1);
+    }
+    sha1_update(c, len, 8);
+    for (i = 0; i < 20; i++) {
+        out[i] = c->h[i / 4] >> (24 - 8 * (i % 4));
+    }
+}
+
+/* fake engine, keeps a software context per stream */
+#define FAKE_STREAMS    8
+
+static struct {
+    bl_sha_ctx_t *owner;
+    iot_sha256_context s256;
+    sha1_ctx_t s1;
+} fake[FAKE_STREAMS];
+
+static int engine_held;
+static int engine_busy;         /* held by somebody else */
+static int engine_max_chunk;
+static int engine_locks;
+
+static int fake_slot(bl_sha_ctx_t *ctx)
+{
+    int i;
+
+    for (i = 0; i < FAKE_STREAMS; i++) {
+        if (fake[i].owner == ctx) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int bl_sha_engine_lock(int wait)
+{
+    if (engine_held || (engine_busy && !wait)) {
+        return -1;
+    }
+    /* a waiting caller gets the engine once the other holder is done */
+    engine_busy = 0;
+    engine_held = 1;
+    engine_locks++;
+    return 0;
+}
+
+void bl_sha_engine_unlock(void)
+{
+    engine_held = 0;
+}
+
+void bl_sha_engine_start(bl_sha_ctx_t *ctx)
+{
+    static const uint32_t sha224_iv[8] = {
+        0xC1059ED8, 0x367CD507, 0x3070DD17, 0xF70E5939, 0xFFC00B31, 0x68581511, 0x64F98FA7, 0xBEFA4FA4,
+    };
+    int i = fake_slot(ctx);
+
+    if (i < 0) {
+        i = fake_slot(NULL);
+    }
+    fake[i].owner = ctx;
+    utils_sha256_starts(&fake[i].s256);
+    if (BL_SHA224 == ctx->type) {
+        memcpy(fake[i].s256.state, sha224_iv, sizeof(sha224_iv));
+        fake[i].s256.is224 = 1;
+    }
+    sha1_starts(&fake[i].s1);
+}
+
+int bl_sha_engine_update(bl_sha_ctx_t *ctx, const uint8_t *input, uint32_t len)
+{
+    int i = fake_slot(ctx);
+
+    if (!engine_held || i < 0) {
+        return -1;
+    }
+    if ((int)len > engine_max_chunk) {
+        engine_max_chunk = len;
+    }
+    if (BL_SHA1 == ctx->type) {
+        sha1_update(&fake[i].s1, input, len);
+    } else {
+        utils_sha256_update(&fake[i].s256, input, len);
+    }
+    return 0;
+}
+
+int bl_sha_engine_finish(bl_sha_ctx_t *ctx, uint8_t *hash)
+{
+    int i = fake_slot(ctx);
+
+    if (!engine_held || i < 0) {
+        return -1;
+    }
+    if (BL_SHA1 == ctx->type) {
+        sha1_finish(&fake[i].s1, hash);
+    } else {
+        utils_sha256_finish(&fake[i].s256, hash);
+    }
+    fake[i].owner = NULL;
+    return 0;
+}
+
+static int failures;
+
+static void check(const char *name, const uint8_t *out, int len, const char *hex)
+{
+    char buf[2 * BL_SHA_MAX_DIGEST_LEN + 1];
+    int i;
+
+    for (i = 0; i < len; i++) {
+        sprintf(buf + 2 * i, "%02x", out[i]);
+    }
+    if (strcmp(buf, hex)) {
+        printf("FAIL %s\r\n  got %s\r\n  exp %s\r\n", name, buf, hex);
+        failures++;
+    } else {
+        printf("ok   %s\r\n", name);
+    }
+}
+
+static void hash(const char *name, bl_sha_type_t type, const void *msg, uint32_t len, const char *hex)
+{
+    bl_sha_ctx_t ctx;
+    uint8_t out[BL_SHA_MAX_DIGEST_LEN];
+
+    bl_sha_init(&ctx, type);
+    bl_sha_update(&ctx, msg, len);
+    bl_sha_finish(&ctx, out);
+    check(name, out, bl_sha_digest_len(type), hex);
+}
+
+int main(void)
+{
+    static const char abc448[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    static const char rfc_long_key_msg[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+    static uint8_t million_a[1000000];
+    uint8_t key20[20], key131[131], out[BL_SHA_MAX_DIGEST_LEN], out2[BL_SHA_MAX_DIGEST_LEN];
+    bl_sha_ctx_t a, b;
+    uint32_t i;
+
+    /* FIPS 180 examples */
+    hash("sha256 abc", BL_SHA256, "abc", 3,
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    hash("sha256 empty", BL_SHA256, "", 0,
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    hash("sha256 448 bit", BL_SHA256, abc448, strlen(abc448),
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    hash("sha224 abc", BL_SHA224, "abc", 3,
+            "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7");
+    hash("sha1 abc", BL_SHA1, "abc", 3,
+            "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    /* a long message goes to the engine in chunks */
+    memset(million_a, 'a', sizeof(million_a));
+    engine_max_chunk = 0;
+    engine_locks = 0;
+    hash("sha256 million a", BL_SHA256, million_a, sizeof(million_a),
+            "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    printf("     %d engine holds, largest chunk %d\r\n", engine_locks, engine_max_chunk);
+    if (engine_max_chunk > BL_SHA_ENGINE_CHUNK) {
+        failures++;
+    }
+
+    /* SHA-256 started while the engine is busy runs in software */
+    engine_busy = 1;
+    engine_locks = 0;
+    hash("sha256 abc, engine busy", BL_SHA256, "abc", 3,
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    if (engine_locks) {
+        failures++;
+    }
+    /* other types wait for it */
+    engine_busy = 1;
+    hash("sha1 abc, engine busy", BL_SHA1, "abc", 3,
+            "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    /* two streams interleaved byte by byte */
+    bl_sha_init(&a, BL_SHA256);
+    bl_sha_init(&b, BL_SHA1);
+    for (i = 0; i < strlen(abc448); i++) {
+        bl_sha_update(&a, (const uint8_t *)abc448 + i, 1);
+        bl_sha_update(&b, (const uint8_t *)"abc" + (i % 3), i < 3);
+    }
+    bl_sha_finish(&b, out2);
+    bl_sha_finish(&a, out);
+    check("interleaved sha256", out, 32, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    check("interleaved sha1", out2, 20, "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    /* RFC 4231 and RFC 2202 */
+    memset(key20, 0x0b, sizeof(key20));
+    memset(key131, 0xaa, sizeof(key131));
+    bl_hmac(BL_SHA256, key20, 20, (const uint8_t *)"Hi There", 8, out);
+    check("hmac-sha256 case 1", out, 32, "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+    bl_hmac(BL_SHA224, key20, 20, (const uint8_t *)"Hi There", 8, out);
+    check("hmac-sha224 case 1", out, 28, "896fb1128abbdf196832107cd49df33f47b4b1169912ba4f53684b22");
+    bl_hmac(BL_SHA256, (const uint8_t *)"Jefe", 4, (const uint8_t *)"what do ya want for nothing?", 28, out);
+    check("hmac-sha256 case 2", out, 32, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    bl_hmac(BL_SHA256, key131, 131, (const uint8_t *)rfc_long_key_msg, strlen(rfc_long_key_msg), out);
+    check("hmac-sha256 case 6", out, 32, "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+    bl_hmac(BL_SHA1, key20, 20, (const uint8_t *)"Hi There", 8, out);
+    check("hmac-sha1 case 1", out, 20, "b617318655057264e28bc0b6fb378c8ef146be00");
+    engine_busy = 1;
+    bl_hmac(BL_SHA256, (const uint8_t *)"Jefe", 4, (const uint8_t *)"what do ya want for nothing?", 28, out);
+    check("hmac-sha256 case 2, engine busy", out, 32, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
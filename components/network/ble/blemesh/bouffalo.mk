@@ -27,6 +27,7 @@ COMPONENT_SRCS   := src/access.c \
 					src/net.c \
 					src/prov.c \
 					src/proxy.c \
+					src/proxy_filter.c \
 					src/settings.c \
 					src/transport.c \
 					src/mesh_cli_cmds/mesh_cli_cmds.c \
@@ -45,6 +45,40 @@
 static const struct bt_mesh_comp *dev_comp;
 static u16_t dev_primary_addr;
 
+/* Dispatch index.
+ *
+ * ops[] holds one entry per (model, opcode) sorted by opcode, element and
+ * model, so the candidates of an opcode are contiguous and in the order the
+ * linear element/model walk would visit them. It only depends on the
+ * composition and is built by bt_mesh_comp_register().
+ *
+ * groups[] maps a subscribed group or virtual address to the bitmap of
+ * elements having a model subscribed to it. It is rebuilt lazily after
+ * bt_mesh_access_subs_changed().
+ *
+ * If a table does not fit, the linear lookups are used instead.
+ */
+struct access_op_entry {
+    u32_t opcode;
+    const struct bt_mesh_model_op *op;
+    struct bt_mesh_model *model;
+};
+
+struct access_group_entry {
+    u16_t addr;
+    u32_t elem_map;
+};
+
+static struct {
+    struct access_op_entry ops[CONFIG_BT_MESH_ACCESS_OP_INDEX_SIZE];
+    struct access_group_entry groups[CONFIG_BT_MESH_ACCESS_GROUP_INDEX_SIZE];
+    u16_t op_count;
+    u8_t group_count;
+    bool op_valid;
+    bool group_valid;
+    bool group_stale;
+} access_idx;
+
 static const struct {
     const u16_t id;
     int (*const init)(struct bt_mesh_model *model, bool primary);
@@ -378,6 +412,219 @@ static void mod_init(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
     }
 }
 
+static bool op_entry_before(const struct access_op_entry *a,
+                const struct access_op_entry *b)
+{
+    if (a->opcode != b->opcode) {
+        return a->opcode < b->opcode;
+    }
+
+    if (a->model->elem_idx != b->model->elem_idx) {
+        return a->model->elem_idx < b->model->elem_idx;
+    }
+
+    return a->model->mod_idx < b->model->mod_idx;
+}
+
+static void op_index_add(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
+             bool vnd, bool primary, void *user_data)
+{
+    const struct bt_mesh_model_op *op, *prev;
+    struct access_op_entry entry;
+    int i;
+
+    for (op = mod->op; op && op->func; op++) {
+        /* Vendor opcodes are only looked up in vendor models and SIG
+         * opcodes in SIG models, so the opcode also tells the model list
+         * and (opcode, elem_idx, mod_idx) is unique.
+         */
+        if ((op->opcode >= 0x10000) != vnd) {
+            continue;
+        }
+
+        /* Only the first entry of an opcode is ever used */
+        for (prev = mod->op; prev != op; prev++) {
+            if (prev->opcode == op->opcode) {
+                break;
+            }
+        }
+
+        if (prev != op) {
+            continue;
+        }
+
+        if (access_idx.op_count == ARRAY_SIZE(access_idx.ops)) {
+            access_idx.op_valid = false;
+            return;
+        }
+
+        entry.opcode = op->opcode;
+        entry.op = op;
+        entry.model = mod;
+
+        /* Insertion sort, the table is only built once */
+        for (i = access_idx.op_count; i > 0; i--) {
+            if (!op_entry_before(&entry, &access_idx.ops[i - 1])) {
+                break;
+            }
+
+            access_idx.ops[i] = access_idx.ops[i - 1];
+        }
+
+        access_idx.ops[i] = entry;
+        access_idx.op_count++;
+    }
+}
+
+static void op_index_build(void)
+{
+    access_idx.op_count = 0U;
+    access_idx.op_valid = true;
+
+    bt_mesh_model_foreach(op_index_add, NULL);
+
+    BT_DBG("op index %u entries valid %u", access_idx.op_count,
+           access_idx.op_valid);
+}
+
+/* Index of the first entry of opcode, op_count if there is none */
+static u16_t op_index_find(u32_t opcode)
+{
+    u16_t lo = 0U, hi = access_idx.op_count;
+
+    while (lo < hi) {
+        u16_t mid = (lo + hi) / 2U;
+
+        if (access_idx.ops[mid].opcode < opcode) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo < access_idx.op_count && access_idx.ops[lo].opcode == opcode) {
+        return lo;
+    }
+
+    return access_idx.op_count;
+}
+
+static bool group_index_add(u16_t addr, u8_t elem_idx)
+{
+    int i, j;
+
+    for (i = 0; i < access_idx.group_count; i++) {
+        if (access_idx.groups[i].addr == addr) {
+            access_idx.groups[i].elem_map |= BIT(elem_idx);
+            return true;
+        }
+
+        if (access_idx.groups[i].addr > addr) {
+            break;
+        }
+    }
+
+    if (access_idx.group_count == ARRAY_SIZE(access_idx.groups)) {
+        return false;
+    }
+
+    for (j = access_idx.group_count; j > i; j--) {
+        access_idx.groups[j] = access_idx.groups[j - 1];
+    }
+
+    access_idx.groups[i].addr = addr;
+    access_idx.groups[i].elem_map = BIT(elem_idx);
+    access_idx.group_count++;
+
+    return true;
+}
+
+static bool group_index_add_model(struct bt_mesh_model *mod)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(mod->groups); i++) {
+        if (mod->groups[i] == BT_MESH_ADDR_UNASSIGNED) {
+            continue;
+        }
+
+        if (!group_index_add(mod->groups[i], mod->elem_idx)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void group_index_build(void)
+{
+    int i, j;
+
+    access_idx.group_stale = false;
+    access_idx.group_count = 0U;
+    access_idx.group_valid = false;
+
+    if (dev_comp->elem_count > 32) {
+        return;
+    }
+
+    for (i = 0; i < dev_comp->elem_count; i++) {
+        struct bt_mesh_elem *elem = &dev_comp->elem[i];
+
+        for (j = 0; j < elem->model_count; j++) {
+            if (!group_index_add_model(&elem->models[j])) {
+                return;
+            }
+        }
+
+        for (j = 0; j < elem->vnd_model_count; j++) {
+            if (!group_index_add_model(&elem->vnd_models[j])) {
+                return;
+            }
+        }
+    }
+
+    access_idx.group_valid = true;
+}
+
+/* Bitmap of elements subscribed to addr, false if the index can't tell */
+static bool group_index_lookup(u16_t addr, u32_t *elem_map)
+{
+    u8_t lo = 0U, hi;
+
+    if (access_idx.group_stale) {
+        group_index_build();
+    }
+
+    if (!access_idx.group_valid) {
+        return false;
+    }
+
+    hi = access_idx.group_count;
+    while (lo < hi) {
+        u8_t mid = (lo + hi) / 2U;
+
+        if (access_idx.groups[mid].addr < addr) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo < access_idx.group_count && access_idx.groups[lo].addr == addr) {
+        *elem_map = access_idx.groups[lo].elem_map;
+    } else {
+        *elem_map = 0U;
+    }
+
+    return true;
+}
+
+void bt_mesh_access_subs_changed(void)
+{
+    access_idx.group_stale = true;
+}
+
 int bt_mesh_comp_register(const struct bt_mesh_comp *comp)
 {
     /* There must be at least one element */
@@ -389,6 +636,9 @@ int bt_mesh_comp_register(const struct bt_mesh_comp *comp)
 
     bt_mesh_model_foreach(mod_init, NULL);
 
+    op_index_build();
+    bt_mesh_access_subs_changed();
+
     return 0;
 }
 
@@ -417,6 +667,7 @@ void bt_mesh_comp_unprovision(void)
     dev_primary_addr = BT_MESH_ADDR_UNASSIGNED;
 
     bt_mesh_model_foreach(mod_init, NULL);
+    bt_mesh_access_subs_changed();
 }
 
 u16_t bt_mesh_primary_addr(void)
@@ -467,8 +718,28 @@ static struct bt_mesh_model *bt_mesh_elem_find_group(struct bt_mesh_elem *elem,
 
 struct bt_mesh_elem *bt_mesh_elem_find(u16_t addr)
 {
+    u32_t elem_map;
     int i;
 
+    if (BT_MESH_ADDR_IS_GROUP(addr) || BT_MESH_ADDR_IS_VIRTUAL(addr)) {
+        if (group_index_lookup(addr, &elem_map)) {
+            if (!elem_map) {
+                return NULL;
+            }
+
+            return &dev_comp->elem[find_lsb_set(elem_map) - 1];
+        }
+    } else if (BT_MESH_ADDR_IS_UNICAST(addr) && dev_primary_addr &&
+           addr >= dev_primary_addr &&
+           addr - dev_primary_addr < dev_comp->elem_count) {
+        /* Element addresses are assigned consecutively */
+        struct bt_mesh_elem *elem = &dev_comp->elem[addr - dev_primary_addr];
+
+        if (elem->addr == addr) {
+            return elem;
+        }
+    }
+
     for (i = 0; i < dev_comp->elem_count; i++) {
         struct bt_mesh_elem *elem = &dev_comp->elem[i];
 
@@ -589,6 +860,90 @@ bool bt_mesh_fixed_group_match(u16_t addr)
     }
 }
 
+static bool model_recv_elem_match(struct bt_mesh_net_rx *rx, int elem_idx)
+{
+    struct bt_mesh_elem *elem = &dev_comp->elem[elem_idx];
+
+    if (BT_MESH_ADDR_IS_UNICAST(rx->ctx.recv_dst)) {
+        return elem->addr == rx->ctx.recv_dst;
+    } else if (BT_MESH_ADDR_IS_GROUP(rx->ctx.recv_dst) ||
+           BT_MESH_ADDR_IS_VIRTUAL(rx->ctx.recv_dst)) {
+        /* model subscriptions are checked per candidate */
+        return true;
+    }
+
+    return elem_idx == 0 && bt_mesh_fixed_group_match(rx->ctx.recv_dst);
+}
+
+static void model_recv_deliver(struct bt_mesh_net_rx *rx,
+                   struct net_buf_simple *buf, u32_t opcode,
+                   const struct bt_mesh_model_op *op,
+                   struct bt_mesh_model *model)
+{
+    struct net_buf_simple_state state;
+
+    if (buf->len < op->min_len) {
+        BT_ERR("Too short message for OpCode 0x%08x", opcode);
+        return;
+    }
+
+    rx->ctx.recv_op = opcode;
+    rx->ctx.model = model;
+    rx->ctx.srv_send = true;
+
+    /* The callback will likely parse the buffer, so
+     * store the parsing state in case multiple models
+     * receive the message.
+     */
+    net_buf_simple_save(buf, &state);
+    op->func(model, &rx->ctx, buf);
+    net_buf_simple_restore(buf, &state);
+}
+
+/* Same delivery as the element walk below: per element, the first model
+ * implementing the opcode that is subscribed (group destinations) and
+ * bound to the AppKey receives the message.
+ */
+static void model_recv_indexed(struct bt_mesh_net_rx *rx,
+                   struct net_buf_simple *buf, u32_t opcode)
+{
+    const struct access_op_entry *entry;
+    u16_t dst = rx->ctx.recv_dst;
+    int last_elem = -1;
+    u32_t elem_map;
+    u16_t i;
+
+    if (!(BT_MESH_ADDR_IS_GROUP(dst) || BT_MESH_ADDR_IS_VIRTUAL(dst)) ||
+        !group_index_lookup(dst, &elem_map)) {
+        elem_map = 0xFFFFFFFF;
+    }
+
+    for (i = op_index_find(opcode); i < access_idx.op_count; i++) {
+        entry = &access_idx.ops[i];
+        if (entry->opcode != opcode) {
+            break;
+        }
+
+        if (entry->model->elem_idx == last_elem ||
+            !(elem_map & BIT(entry->model->elem_idx & 0x1F)) ||
+            !model_recv_elem_match(rx, entry->model->elem_idx)) {
+            continue;
+        }
+
+        if ((BT_MESH_ADDR_IS_GROUP(dst) || BT_MESH_ADDR_IS_VIRTUAL(dst)) &&
+            !bt_mesh_model_find_group(entry->model, dst)) {
+            continue;
+        }
+
+        if (!model_has_key(entry->model, rx->ctx.app_idx)) {
+            continue;
+        }
+
+        last_elem = entry->model->elem_idx;
+        model_recv_deliver(rx, buf, opcode, entry->op, entry->model);
+    }
+}
+
 void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
 {
     struct bt_mesh_model *models, *model;
@@ -608,6 +963,11 @@ void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
 
     BT_DBG("OpCode 0x%08x", opcode);
 
+    if (access_idx.op_valid) {
+        model_recv_indexed(rx, buf, opcode);
+        return;
+    }
+
     for (i = 0; i < dev_comp->elem_count; i++) {
         struct bt_mesh_elem *elem = &dev_comp->elem[i];
 
@@ -638,26 +998,7 @@ void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
         op = find_op(models, count, rx->ctx.recv_dst, rx->ctx.app_idx,
                  opcode, &model);
         if (op) {
-            struct net_buf_simple_state state;
-
-            if (buf->len < op->min_len) {
-                BT_ERR("Too short message for OpCode 0x%08x",
-                       opcode);
-                continue;
-            }
-
-            rx->ctx.recv_op = opcode;
-            rx->ctx.model = model;
-            rx->ctx.srv_send = true;
-
-            /* The callback will likely parse the buffer, so
-             * store the parsing state in case multiple models
-             * receive the message.
-             */
-            net_buf_simple_save(buf, &state);
-            op->func(model, &rx->ctx, buf);
-            net_buf_simple_restore(buf, &state);
-
+            model_recv_deliver(rx, buf, opcode, op, model);
         } else {
             BT_DBG("No OpCode 0x%08x for elem %d", opcode, i);
         }
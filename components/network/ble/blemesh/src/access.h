@@ -35,6 +35,9 @@ struct bt_mesh_model *bt_mesh_model_find(struct bt_mesh_elem *elem,
 
 u16_t *bt_mesh_model_find_group(struct bt_mesh_model *mod, u16_t addr);
 
+/* Must be called whenever a model subscription list is modified */
+void bt_mesh_access_subs_changed(void);
+
 bool bt_mesh_fixed_group_match(u16_t addr);
 
 void bt_mesh_model_foreach(void (*func)(struct bt_mesh_model *mod,
@@ -423,6 +423,7 @@ static u8_t app_key_set(u16_t net_idx, u16_t app_idx, const u8_t val[16],
     key->net_idx = net_idx;
     key->app_idx = app_idx;
     memcpy(keys->val, val, 16);
+    bt_mesh_app_key_index_update();
 
     if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
         BT_DBG("Storing AppKey persistently");
@@ -513,6 +514,7 @@ void bt_mesh_app_key_del(struct bt_mesh_app_key *key, bool store)
     key->app_idx = BT_MESH_KEY_UNUSED;
     key->updated = false;
     #endif
+    bt_mesh_app_key_index_update();
 }
 
 static void app_key_del(struct bt_mesh_model *model,
@@ -1190,6 +1192,8 @@ static size_t mod_sub_list_clear(struct bt_mesh_model *mod)
         }
     }
 
+    bt_mesh_access_subs_changed();
+
     return clear_count;
 }
 
@@ -1286,6 +1290,8 @@ static size_t mod_sub_list_clear(struct bt_mesh_model *mod)
         }
     }
 
+    bt_mesh_access_subs_changed();
+
     return clear_count;
 }
 
@@ -1419,6 +1425,7 @@ static void mod_sub_add(struct bt_mesh_model *model,
     for (i = 0; i < ARRAY_SIZE(mod->groups); i++) {
         if (mod->groups[i] == BT_MESH_ADDR_UNASSIGNED) {
             mod->groups[i] = sub_addr;
+            bt_mesh_access_subs_changed();
             break;
         }
     }
@@ -1497,6 +1504,7 @@ static void mod_sub_del(struct bt_mesh_model *model,
     match = bt_mesh_model_find_group(mod, sub_addr);
     if (match) {
         *match = BT_MESH_ADDR_UNASSIGNED;
+        bt_mesh_access_subs_changed();
 
         if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
             bt_mesh_store_mod_sub(mod);
@@ -1558,6 +1566,7 @@ static void mod_sub_overwrite(struct bt_mesh_model *model,
 
     if (ARRAY_SIZE(mod->groups) > 0) {
         mod->groups[0] = sub_addr;
+        bt_mesh_access_subs_changed();
         status = STATUS_SUCCESS;
 
         if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
@@ -1800,6 +1809,7 @@ static void mod_sub_va_add(struct bt_mesh_model *model,
     for (i = 0; i < ARRAY_SIZE(mod->groups); i++) {
         if (mod->groups[i] == BT_MESH_ADDR_UNASSIGNED) {
             mod->groups[i] = sub_addr;
+            bt_mesh_access_subs_changed();
             break;
         }
     }
@@ -1876,6 +1886,7 @@ static void mod_sub_va_del(struct bt_mesh_model *model,
     match = bt_mesh_model_find_group(mod, sub_addr);
     if (match) {
         *match = BT_MESH_ADDR_UNASSIGNED;
+        bt_mesh_access_subs_changed();
 
         if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
             bt_mesh_store_mod_sub(mod);
@@ -1939,6 +1950,7 @@ static void mod_sub_va_overwrite(struct bt_mesh_model *model,
         status = va_add(label_uuid, &sub_addr);
         if (status == STATUS_SUCCESS) {
             mod->groups[0] = sub_addr;
+            bt_mesh_access_subs_changed();
 
             if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
                 bt_mesh_store_mod_sub(mod);
@@ -3508,6 +3520,20 @@ u8_t *bt_mesh_label_uuid_get(u16_t addr)
     return NULL;
 }
 
+/* Iterate over all Label UUIDs of a virtual address, several labels can
+ * hash to the same address. Start with *idx = 0.
+ */
+u8_t *bt_mesh_label_uuid_next(u16_t addr, int *idx)
+{
+    for (; *idx < ARRAY_SIZE(labels); (*idx)++) {
+        if (labels[*idx].addr == addr) {
+            return labels[(*idx)++].uuid;
+        }
+    }
+
+    return NULL;
+}
+
 struct bt_mesh_hb_pub *bt_mesh_hb_pub_get(void)
 {
     if (!conf) {
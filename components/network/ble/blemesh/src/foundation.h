@@ -129,6 +129,7 @@ void bt_mesh_heartbeat(u16_t src, u16_t dst, u8_t hops, u16_t feat);
 void bt_mesh_attention(struct bt_mesh_model *model, u8_t time);
 
 u8_t *bt_mesh_label_uuid_get(u16_t addr);
+u8_t *bt_mesh_label_uuid_next(u16_t addr, int *idx);
 
 struct bt_mesh_hb_pub *bt_mesh_hb_pub_get(void);
 void bt_mesh_hb_pub_disable(void);
@@ -169,8 +169,10 @@ static void friend_clear(struct bt_mesh_friend *frnd)
     frnd->valid = 0U;
     frnd->established = 0U;
     frnd->pending_buf = 0U;
+    frnd->frag_head = 0U;
     frnd->fsn = 0U;
     frnd->queue_size = 0U;
+    frnd->seg_pending = 0U;
     frnd->pending_req = 0U;
     (void)memset(frnd->sub_list, 0, sizeof(frnd->sub_list));
 }
@@ -515,8 +517,65 @@ int bt_mesh_friend_sub_rem(struct bt_mesh_net_rx *rx,
     return 0;
 }
 
+/* Drop the oldest whole message from the Friend Queue. The buffers of a
+ * segmented message are contiguous in the queue and all but the last one
+ * carry NET_BUF_FRAGS. If the LPN already got the first segments of the
+ * message at the head, the message after it goes first, and if there is
+ * none nothing is dropped: cutting the message short would only make the
+ * LPN wait out its SAR timer.
+ */
+static bool friend_queue_evict(struct bt_mesh_friend *frnd)
+{
+    sys_snode_t *cur, *prev = NULL;
+    struct net_buf *buf;
+    bool last;
+
+    cur = sys_slist_peek_head(&frnd->queue);
+    if (!cur) {
+        return false;
+    }
+
+    if (frnd->frag_head) {
+        while (cur && (((struct net_buf *)cur)->flags & NET_BUF_FRAGS)) {
+            cur = sys_slist_peek_next(cur);
+        }
+
+        if (!cur || !sys_slist_peek_next(cur)) {
+            return false;
+        }
+
+        prev = cur;
+        cur = sys_slist_peek_next(cur);
+    }
+
+    do {
+        buf = (void *)cur;
+        cur = sys_slist_peek_next(cur);
+        last = !(buf->flags & NET_BUF_FRAGS);
+
+        sys_slist_remove(&frnd->queue, prev, &buf->node);
+        frnd->queue_size--;
+
+        /* Make sure old slist entry state doesn't remain */
+        buf->frags = NULL;
+        buf->flags &= ~NET_BUF_FRAGS;
+
+        net_buf_unref(buf);
+    } while (!last && cur);
+
+    frnd->evicted++;
+
+    return true;
+}
+
 static void enqueue_buf(struct bt_mesh_friend *frnd, struct net_buf *buf)
 {
+    /* Keep every LPN within its share of the friend buffer pool */
+    while (frnd->queue_size + frnd->seg_pending >=
+           CONFIG_BT_MESH_FRIEND_QUEUE_SIZE &&
+           friend_queue_evict(frnd)) {
+    }
+
     net_buf_slist_put(&frnd->queue, buf);
     frnd->queue_size++;
 }
@@ -874,11 +933,10 @@ init_friend:
     return 0;
 }
 
-static struct bt_mesh_friend_seg *get_seg(struct bt_mesh_friend *frnd,
-                      u16_t src, u64_t *seq_auth,
-                      u8_t seg_count)
+static struct bt_mesh_friend_seg *find_seg(struct bt_mesh_friend *frnd,
+                       u16_t src, u64_t *seq_auth,
+                       struct bt_mesh_friend_seg **unassigned)
 {
-    struct bt_mesh_friend_seg *unassigned = NULL;
     int i;
 
     for (i = 0; i < ARRAY_SIZE(frnd->seg); i++) {
@@ -890,18 +948,41 @@ static struct bt_mesh_friend_seg *get_seg(struct bt_mesh_friend *frnd,
             return seg;
         }
 
-        if (!unassigned && !buf) {
-            unassigned = seg;
+        if (unassigned && !*unassigned && !buf) {
+            *unassigned = seg;
         }
     }
 
+    return NULL;
+}
+
+static struct bt_mesh_friend_seg *get_seg(struct bt_mesh_friend *frnd,
+                      u16_t src, u64_t *seq_auth,
+                      u8_t seg_count)
+{
+    struct bt_mesh_friend_seg *unassigned = NULL;
+    struct bt_mesh_friend_seg *seg;
+
+    seg = find_seg(frnd, src, seq_auth, &unassigned);
+    if (seg) {
+        return seg;
+    }
+
     if (unassigned) {
         unassigned->seg_count = seg_count;
+        frnd->seg_pending += seg_count;
     }
 
     return unassigned;
 }
 
+static void seg_release(struct bt_mesh_friend *frnd,
+            struct bt_mesh_friend_seg *seg)
+{
+    frnd->seg_pending -= seg->seg_count;
+    seg->seg_count = 0U;
+}
+
 static void enqueue_friend_pdu(struct bt_mesh_friend *frnd,
                    enum bt_mesh_friend_pdu_type type,
                    u8_t seg_count, struct net_buf *buf)
@@ -946,7 +1027,7 @@ static void enqueue_friend_pdu(struct bt_mesh_friend *frnd,
         }
 
         sys_slist_merge_slist(&frnd->queue, &seg->queue);
-        seg->seg_count = 0U;
+        seg_release(frnd, seg);
     } else {
         /* Mark the buffer as having more to come after it */
         buf->flags |= NET_BUF_FRAGS;
@@ -1022,7 +1103,10 @@ static void friend_timeout(struct k_work *work)
         return;
     }
 
-    /* Clear the flag we use for segment tracking */
+    /* Clear the flag we use for segment tracking, the queue head is
+     * then the rest of a message the LPN has started receiving.
+     */
+    frnd->frag_head = !!(frnd->last->flags & NET_BUF_FRAGS);
     frnd->last->flags &= ~NET_BUF_FRAGS;
     frnd->last->frags = NULL;
 
@@ -1225,30 +1309,15 @@ bool bt_mesh_friend_match(u16_t net_idx, u16_t addr)
 static bool friend_queue_has_space(struct bt_mesh_friend *frnd, u16_t addr,
                    u64_t *seq_auth, u8_t seg_count)
 {
-    u32_t total = 0;
-    int i;
-
     if (seg_count > CONFIG_BT_MESH_FRIEND_QUEUE_SIZE) {
         return false;
     }
 
-    for (i = 0; i < ARRAY_SIZE(frnd->seg); i++) {
-        struct bt_mesh_friend_seg *seg = &frnd->seg[i];
-
-        if (seq_auth) {
-            struct net_buf *buf;
-
-            /* If there's a segment queue for this message then the
-             * space verification has already happened.
-             */
-            buf = (void *)sys_slist_peek_head(&seg->queue);
-            if (buf && BT_MESH_ADV(buf)->addr == addr &&
-                FRIEND_ADV(buf)->seq_auth == *seq_auth) {
-                return true;
-            }
-        }
-
-        total += seg->seg_count;
+    /* If there's a segment queue for this message then the space
+     * verification has already happened.
+     */
+    if (seq_auth && find_seg(frnd, addr, seq_auth, NULL)) {
+        return true;
     }
 
     /* If currently pending segments combined with this segmented message
@@ -1256,7 +1325,8 @@ static bool friend_queue_has_space(struct bt_mesh_friend *frnd, u16_t addr,
      * is because we don't have a mechanism of aborting already pending
      * segmented messages to free up buffers.
      */
-    return (CONFIG_BT_MESH_FRIEND_QUEUE_SIZE - total) > seg_count;
+    return (int)CONFIG_BT_MESH_FRIEND_QUEUE_SIZE - frnd->seg_pending >
+           seg_count;
 }
 
 bool bt_mesh_friend_queue_has_space(u16_t net_idx, u16_t src, u16_t dst,
@@ -1294,37 +1364,33 @@ bool bt_mesh_friend_queue_has_space(u16_t net_idx, u16_t src, u16_t dst,
     return someone_has_space;
 }
 
+/* The queued buffers of an LPN plus the space reserved for its pending
+ * segmented messages never exceed CONFIG_BT_MESH_FRIEND_QUEUE_SIZE, so
+ * one busy LPN can't drain the friend buffer pool of the others.
+ */
 static bool friend_queue_prepare_space(struct bt_mesh_friend *frnd, u16_t addr,
                        u64_t *seq_auth, u8_t seg_count)
 {
-    bool pending_segments;
-    u8_t avail_space;
+    /* A pending security update goes in ahead of the message */
+    u8_t need = seg_count + frnd->sec_update;
 
     if (!friend_queue_has_space(frnd, addr, seq_auth, seg_count)) {
+        frnd->refused++;
         return false;
     }
 
-    avail_space = CONFIG_BT_MESH_FRIEND_QUEUE_SIZE - frnd->queue_size;
-    pending_segments = false;
-
-    while (pending_segments || avail_space < seg_count) {
-        struct net_buf *buf = (void *)sys_slist_get(&frnd->queue);
+    /* Segments of a message under way are already reserved for */
+    if (seq_auth && find_seg(frnd, addr, seq_auth, NULL)) {
+        need = frnd->sec_update;
+    }
 
-        if (!buf) {
+    while (frnd->queue_size + frnd->seg_pending + need >
+           CONFIG_BT_MESH_FRIEND_QUEUE_SIZE) {
+        if (!friend_queue_evict(frnd)) {
             BT_ERR("Unable to free up enough buffers");
+            frnd->refused++;
             return false;
         }
-
-        frnd->queue_size--;
-        avail_space++;
-
-        pending_segments = (buf->flags & NET_BUF_FRAGS);
-
-        /* Make sure old slist entry state doesn't remain */
-        buf->frags = NULL;
-        buf->flags &= ~NET_BUF_FRAGS;
-
-        net_buf_unref(buf);
     }
 
     return true;
@@ -1437,7 +1503,25 @@ void bt_mesh_friend_clear_incomplete(struct bt_mesh_subnet *sub, u16_t src,
             BT_WARN("Clearing incomplete segments for 0x%04x", src);
 
             purge_buffers(&seg->queue);
-            seg->seg_count = 0U;
+            seg_release(frnd, seg);
         }
     }
 }
+
+int bt_mesh_friend_overflow_get(u16_t lpn_addr, u32_t *evicted,
+                u32_t *refused)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
+        struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+
+        if (frnd->valid && frnd->lpn == lpn_addr) {
+            *evicted = frnd->evicted;
+            *refused = frnd->refused;
+            return 0;
+        }
+    }
+
+    return -ENOENT;
+}
@@ -38,6 +38,9 @@ void bt_mesh_friend_sec_update(u16_t net_idx);
 
 void bt_mesh_friend_clear_net_idx(u16_t net_idx);
 
+int bt_mesh_friend_overflow_get(u16_t lpn_addr, u32_t *evicted,
+                u32_t *refused);
+
 int bt_mesh_friend_poll(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf);
 int bt_mesh_friend_req(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf);
 int bt_mesh_friend_clear(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf);
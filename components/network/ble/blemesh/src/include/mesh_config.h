@@ -57,8 +57,21 @@
 #define CONFIG_MESH_ADV_STACK_SIZE  1024
 #endif
 
+#ifndef CONFIG_BT_MESH_ACCESS_OP_INDEX_SIZE
+#define CONFIG_BT_MESH_ACCESS_OP_INDEX_SIZE 64
+#endif
+
+#ifndef CONFIG_BT_MESH_ACCESS_GROUP_INDEX_SIZE
+#define CONFIG_BT_MESH_ACCESS_GROUP_INDEX_SIZE 16
+#endif
+
 #ifndef CONFIG_BT_MESH_PROXY_FILTER_SIZE
-#define CONFIG_BT_MESH_PROXY_FILTER_SIZE 1
+#define CONFIG_BT_MESH_PROXY_FILTER_SIZE 64
+#endif
+
+/* Hash slots shared by the filters of all Proxy Clients */
+#ifndef CONFIG_BT_MESH_PROXY_FILTER_POOL_SIZE
+#define CONFIG_BT_MESH_PROXY_FILTER_POOL_SIZE 256
 #endif
 
 #ifndef CONFIG_BT_MESH_NODE_ID_TIMEOUT
@@ -3,6 +3,7 @@
 #include "foundation.h"
 #include "log.h"
 #include "net.h"
+#include "transport.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -54,5 +55,6 @@ uint8_t bt_mesh_app_key_add(uint16_t app_idx, uint16_t net_idx,
 		printf("Unable to import application key\r\n");
 		return STATUS_CANNOT_SET;
 	}
+	bt_mesh_app_key_index_update();
 	return STATUS_SUCCESS;
 }
\ No newline at end of file
@@ -520,6 +520,7 @@ void bt_mesh_net_revoke_keys(struct bt_mesh_subnet *sub)
 
         memcpy(&key->keys[0], &key->keys[1], sizeof(key->keys[0]));
         key->updated = false;
+        bt_mesh_app_key_index_update();
 
 #if defined(BFLB_BLE_MESH_PATCH_NET_REVOKE_KEYS)
         if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
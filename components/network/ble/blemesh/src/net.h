@@ -99,7 +99,8 @@ struct bt_mesh_friend {
           sec_update:1,
           pending_buf:1,
           valid:1,
-          established:1;
+          established:1,
+          frag_head:1;
     s32_t poll_to;
     u8_t  num_elem;
     u16_t lpn_counter;
@@ -121,11 +122,20 @@ struct bt_mesh_friend {
         u8_t        seg_count;
     } seg[FRIEND_SEG_RX];
 
+    /* Sum of seg_count over all segment contexts, i.e. the queue
+     * space reserved for segmented messages still being received.
+     */
+    u16_t seg_pending;
+
     struct net_buf *last;
 
     sys_slist_t queue;
     u32_t queue_size;
 
+    /* Friend Queue overflow counters */
+    u32_t evicted;      /* Messages dropped to make room */
+    u32_t refused;      /* PDUs not queued for lack of space */
+
     /* Friend Clear Procedure */
     struct {
         u32_t start;                  /* Clear Procedure start */
@@ -28,6 +28,7 @@
 #include "foundation.h"
 #include "access.h"
 #include "proxy.h"
+#include "proxy_filter.h"
 #if defined(BFLB_BLE)
 #include "../../blestack/src/include/bluetooth/crypto.h"
 #endif
@@ -88,7 +89,6 @@ static bool prov_fast_adv;
 
 static struct bt_mesh_proxy_client {
     struct bt_conn *conn;
-    u16_t filter[CONFIG_BT_MESH_PROXY_FILTER_SIZE];
     enum __packed {
         NONE,
         WHITELIST,
@@ -122,6 +122,26 @@ static enum {
     MESH_GATT_PROXY,
 } gatt_svc = MESH_GATT_NONE;
 
+/* The filter of clients[i] is filters[i], their tables share the pool */
+static u16_t filter_slots[CONFIG_BT_MESH_PROXY_FILTER_POOL_SIZE];
+static struct proxy_filter filters[CONFIG_BT_MAX_CONN];
+static struct proxy_filter_pool filter_pool = {
+    .slots = filter_slots,
+    .size = ARRAY_SIZE(filter_slots),
+    .filters = filters,
+    .filter_count = ARRAY_SIZE(filters),
+};
+
+static inline struct proxy_filter *client_filter(struct bt_mesh_proxy_client *client)
+{
+    return &filters[client - clients];
+}
+
+static void filter_clear(struct bt_mesh_proxy_client *client)
+{
+    proxy_filter_clear(&filter_pool, client_filter(client));
+}
+
 static struct bt_mesh_proxy_client *find_client(struct bt_conn *conn)
 {
     int i;
@@ -170,11 +190,11 @@ static int filter_set(struct bt_mesh_proxy_client *client,
 
     switch (type) {
     case 0x00:
-        (void)memset(client->filter, 0, sizeof(client->filter));
+        filter_clear(client);
         client->filter_type = WHITELIST;
         break;
     case 0x01:
-        (void)memset(client->filter, 0, sizeof(client->filter));
+        filter_clear(client);
         client->filter_type = BLACKLIST;
         break;
     default:
@@ -187,44 +207,25 @@ static int filter_set(struct bt_mesh_proxy_client *client,
 
 static void filter_add(struct bt_mesh_proxy_client *client, u16_t addr)
 {
-    int i;
+    int err;
 
     BT_DBG("addr 0x%04x", addr);
 
-    if (addr == BT_MESH_ADDR_UNASSIGNED) {
-        return;
-    }
-
-    for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-        if (client->filter[i] == addr) {
-            return;
-        }
-    }
-
-    for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-        if (client->filter[i] == BT_MESH_ADDR_UNASSIGNED) {
-            client->filter[i] = addr;
-            return;
-        }
+    err = proxy_filter_add(&filter_pool, client_filter(client), addr,
+                   CONFIG_BT_MESH_PROXY_FILTER_SIZE);
+    if (err == -ENOSPC) {
+        BT_WARN("Proxy filter full");
+    } else if (err == -ENOMEM) {
+        BT_WARN("No space for Proxy filter of %u addresses",
+            client_filter(client)->count + 1);
     }
 }
 
 static void filter_remove(struct bt_mesh_proxy_client *client, u16_t addr)
 {
-    int i;
-
     BT_DBG("addr 0x%04x", addr);
 
-    if (addr == BT_MESH_ADDR_UNASSIGNED) {
-        return;
-    }
-
-    for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-        if (client->filter[i] == addr) {
-            client->filter[i] = BT_MESH_ADDR_UNASSIGNED;
-            return;
-        }
-    }
+    proxy_filter_remove(&filter_pool, client_filter(client), addr);
 }
 
 static void send_filter_status(struct bt_mesh_proxy_client *client,
@@ -236,8 +237,7 @@ static void send_filter_status(struct bt_mesh_proxy_client *client,
         .ctx = &rx->ctx,
         .src = bt_mesh_primary_addr(),
     };
-    u16_t filter_size;
-    int i, err;
+    int err;
 
     /* Configuration messages always have dst unassigned */
     tx.ctx->addr = BT_MESH_ADDR_UNASSIGNED;
@@ -253,13 +253,7 @@ static void send_filter_status(struct bt_mesh_proxy_client *client,
         net_buf_simple_add_u8(buf, 0x01);
     }
 
-    for (filter_size = 0U, i = 0; i < ARRAY_SIZE(client->filter); i++) {
-        if (client->filter[i] != BT_MESH_ADDR_UNASSIGNED) {
-            filter_size++;
-        }
-    }
-
-    net_buf_simple_add_be16(buf, filter_size);
+    net_buf_simple_add_be16(buf, client_filter(client)->count);
 
     BT_DBG("%u bytes: %s", buf->len, bt_hex(buf->data, buf->len));
 
@@ -576,7 +570,7 @@ static void proxy_connected(struct bt_conn *conn, u8_t err)
 
     client->conn = bt_conn_ref(conn);
     client->filter_type = NONE;
-    (void)memset(client->filter, 0, sizeof(client->filter));
+    filter_clear(client);
     net_buf_simple_reset(&client->buf);
 }
 
@@ -598,6 +592,7 @@ static void proxy_disconnected(struct bt_conn *conn, u8_t reason)
             }
 
             k_delayed_work_cancel(&client->sar_timer);
+            filter_clear(client);
             bt_conn_unref(client->conn);
             client->conn = NULL;
             break;
@@ -963,28 +958,14 @@ void bt_mesh_proxy_addr_add(struct net_buf_simple *buf, u16_t addr)
 static bool client_filter_match(struct bt_mesh_proxy_client *client,
                 u16_t addr)
 {
-    int i;
-
     BT_DBG("filter_type %u addr 0x%04x", client->filter_type, addr);
 
     if (client->filter_type == WHITELIST) {
-        for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-            if (client->filter[i] == addr) {
-                return true;
-            }
-        }
-
-        return false;
+        return proxy_filter_has(&filter_pool, client_filter(client), addr);
     }
 
     if (client->filter_type == BLACKLIST) {
-        for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-            if (client->filter[i] == addr) {
-                return false;
-            }
-        }
-
-        return true;
+        return !proxy_filter_has(&filter_pool, client_filter(client), addr);
     }
 
     return false;
@@ -0,0 +1,187 @@
+/*  Bluetooth Mesh */
+
+#include <errno.h>
+#include <string.h>
+
+#include "include/access.h"
+#include "proxy_filter.h"
+
+#define FILTER_MIN_CAP 8
+
+static u16_t filter_pool_used(const struct proxy_filter_pool *pool)
+{
+    u16_t used = 0U;
+    int i;
+
+    for (i = 0; i < pool->filter_count; i++) {
+        used += pool->filters[i].cap;
+    }
+
+    return used;
+}
+
+static inline u16_t filter_hash(u16_t addr, u16_t cap)
+{
+    return (u16_t)(((u32_t)addr * 0x9E3779B1U) >> 16) & (cap - 1);
+}
+
+static void filter_insert(struct proxy_filter_pool *pool,
+              struct proxy_filter *filter, u16_t addr)
+{
+    u16_t *slots = &pool->slots[filter->off];
+    u16_t i = filter_hash(addr, filter->cap);
+
+    while (slots[i] != BT_MESH_ADDR_UNASSIGNED) {
+        i = (i + 1) & (filter->cap - 1);
+    }
+
+    slots[i] = addr;
+    filter->count++;
+}
+
+static int filter_find(const struct proxy_filter_pool *pool,
+               const struct proxy_filter *filter, u16_t addr)
+{
+    const u16_t *slots = &pool->slots[filter->off];
+    u16_t i;
+
+    if (!filter->count || addr == BT_MESH_ADDR_UNASSIGNED) {
+        return -ENOENT;
+    }
+
+    for (i = filter_hash(addr, filter->cap);
+         slots[i] != BT_MESH_ADDR_UNASSIGNED;
+         i = (i + 1) & (filter->cap - 1)) {
+        if (slots[i] == addr) {
+            return i;
+        }
+    }
+
+    return -ENOENT;
+}
+
+/* Resize the table of a filter to cap slots (0 releases it), the entries
+ * are rehashed through scratch space at the free end of the pool.
+ */
+static int filter_resize(struct proxy_filter_pool *pool,
+             struct proxy_filter *filter, u16_t cap)
+{
+    u16_t used = filter_pool_used(pool);
+    u16_t old_cap = filter->cap;
+    u16_t end = filter->off + old_cap;
+    u16_t *scratch;
+    int delta = (int)cap - (int)old_cap;
+    int i;
+
+    if (delta > 0 && used + delta + old_cap > pool->size) {
+        return -ENOMEM;
+    }
+
+    if (!old_cap) {
+        filter->off = used;
+        end = used;
+    }
+
+    memmove(&pool->slots[end + delta], &pool->slots[end],
+        (used - end) * sizeof(pool->slots[0]));
+
+    for (i = 0; i < pool->filter_count; i++) {
+        if (&pool->filters[i] != filter && pool->filters[i].cap &&
+            pool->filters[i].off >= end) {
+            pool->filters[i].off += delta;
+        }
+    }
+
+    filter->cap = cap;
+    filter->count = 0U;
+
+    if (!cap) {
+        return 0;
+    }
+
+    scratch = &pool->slots[used + delta];
+    memcpy(scratch, &pool->slots[filter->off],
+           old_cap * sizeof(pool->slots[0]));
+    (void)memset(&pool->slots[filter->off], 0,
+             cap * sizeof(pool->slots[0]));
+
+    for (i = 0; i < old_cap; i++) {
+        if (scratch[i] != BT_MESH_ADDR_UNASSIGNED) {
+            filter_insert(pool, filter, scratch[i]);
+        }
+    }
+
+    return 0;
+}
+
+int proxy_filter_add(struct proxy_filter_pool *pool,
+             struct proxy_filter *filter, u16_t addr, u16_t max)
+{
+    u16_t cap;
+    int err;
+
+    if (addr == BT_MESH_ADDR_UNASSIGNED ||
+        filter_find(pool, filter, addr) >= 0) {
+        return -EALREADY;
+    }
+
+    if (filter->count >= max) {
+        return -ENOSPC;
+    }
+
+    if ((filter->count + 1) * 4 > filter->cap * 3) {
+        cap = filter->cap ? filter->cap * 2 : FILTER_MIN_CAP;
+        err = filter_resize(pool, filter, cap);
+        if (err) {
+            return err;
+        }
+    }
+
+    filter_insert(pool, filter, addr);
+
+    return 0;
+}
+
+void proxy_filter_remove(struct proxy_filter_pool *pool,
+             struct proxy_filter *filter, u16_t addr)
+{
+    u16_t *slots = &pool->slots[filter->off];
+    u16_t mask = filter->cap - 1;
+    u16_t home;
+    int i, j;
+
+    i = filter_find(pool, filter, addr);
+    if (i < 0) {
+        return;
+    }
+
+    slots[i] = BT_MESH_ADDR_UNASSIGNED;
+    filter->count--;
+
+    /* Backward shift deletion: pull up every entry of the probe run whose
+     * home slot is not between the hole and its current slot.
+     */
+    for (j = (i + 1) & mask; slots[j] != BT_MESH_ADDR_UNASSIGNED;
+         j = (j + 1) & mask) {
+        home = filter_hash(slots[j], filter->cap);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            slots[i] = slots[j];
+            slots[j] = BT_MESH_ADDR_UNASSIGNED;
+            i = j;
+        }
+    }
+}
+
+bool proxy_filter_has(const struct proxy_filter_pool *pool,
+              const struct proxy_filter *filter, u16_t addr)
+{
+    return filter_find(pool, filter, addr) >= 0;
+}
+
+void proxy_filter_clear(struct proxy_filter_pool *pool,
+            struct proxy_filter *filter)
+{
+    if (filter->cap) {
+        (void)filter_resize(pool, filter, 0);
+    }
+}
@@ -0,0 +1,42 @@
+/*  Bluetooth Mesh */
+
+#ifndef __PROXY_FILTER_H__
+#define __PROXY_FILTER_H__
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+
+/* The filter of a Proxy Client is an open addressing hash set of addresses
+ * with BT_MESH_ADDR_UNASSIGNED as empty slot. The tables of all filters of
+ * a pool are packed back to back in its slots, and a table doubles when it
+ * gets 3/4 full by shifting up the tables behind it. Nothing here depends
+ * on GATT or connections, so that the host tests can drive it.
+ */
+struct proxy_filter {
+    u16_t off;      /* first slot of the table */
+    u16_t cap;      /* slots, 0 or a power of 2 */
+    u16_t count;
+};
+
+struct proxy_filter_pool {
+    u16_t *slots;
+    u16_t size;
+    struct proxy_filter *filters;
+    u8_t filter_count;
+};
+
+/* 0 when added, -EALREADY when addr is unassigned or already there,
+ * -ENOSPC when the filter holds max addresses, -ENOMEM when the pool is
+ * out of slots.
+ */
+int proxy_filter_add(struct proxy_filter_pool *pool,
+             struct proxy_filter *filter, u16_t addr, u16_t max);
+void proxy_filter_remove(struct proxy_filter_pool *pool,
+             struct proxy_filter *filter, u16_t addr);
+bool proxy_filter_has(const struct proxy_filter_pool *pool,
+              const struct proxy_filter *filter, u16_t addr);
+/* Empty the filter and give its table back to the pool */
+void proxy_filter_clear(struct proxy_filter_pool *pool,
+            struct proxy_filter *filter);
+
+#endif /* __PROXY_FILTER_H__ */
@@ -331,6 +331,7 @@ static int app_key_set(void)
 
        bt_mesh_app_id(app->keys[0].val, &app->keys[0].id);
        bt_mesh_app_id(app->keys[1].val, &app->keys[1].id);
+       bt_mesh_app_key_index_update();
 
        BT_DBG("AppKeyIndex 0x%03x recovered from storage", app->app_idx);
     }
@@ -416,6 +417,7 @@ static int mod_set_sub(struct bt_mesh_model *mod, bool vnd)
 
     /* Start with empty array regardless of cleared or set value */
     (void)memset(mod->groups, 0, sizeof(mod->groups));
+    bt_mesh_access_subs_changed();
 
     encode_mod_path(mod, vnd, "sub", path, sizeof(path));
 
@@ -834,6 +836,7 @@ static int app_key_set(const char *name, size_t len_rd,
 
     bt_mesh_app_id(app->keys[0].val, &app->keys[0].id);
     bt_mesh_app_id(app->keys[1].val, &app->keys[1].id);
+    bt_mesh_app_key_index_update();
 
     BT_DBG("AppKeyIndex 0x%03x recovered from storage", app_idx);
 
@@ -949,6 +952,7 @@ static int mod_set_sub(struct bt_mesh_model *mod, size_t len_rd,
 
     /* Start with empty array regardless of cleared or set value */
     (void)memset(mod->groups, 0, sizeof(mod->groups));
+    bt_mesh_access_subs_changed();
 
     if (len_rd == 0) {
         BT_DBG("Cleared subscriptions for model");
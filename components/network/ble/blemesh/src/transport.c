@@ -504,6 +504,38 @@ static int send_seg(struct bt_mesh_net_tx *net_tx, struct net_buf_simple *sdu,
     return 0;
 }
 
+/* AppKeys by AID, one chain entry per key version (slot * 2 + version),
+ * stored +1 so that 0 ends a chain. Chains follow the order of
+ * bt_mesh.app_keys so the first matching key wins as with a plain scan.
+ */
+static u8_t app_aid_head[AID_MASK + 1];
+static u8_t app_aid_next[ARRAY_SIZE(bt_mesh.app_keys) * 2];
+
+BUILD_ASSERT(ARRAY_SIZE(bt_mesh.app_keys) * 2 < 0xff);
+
+/* Must be called whenever an AppKey is added, updated or deleted */
+void bt_mesh_app_key_index_update(void)
+{
+    int i, v;
+
+    (void)memset(app_aid_head, 0, sizeof(app_aid_head));
+
+    for (i = ARRAY_SIZE(bt_mesh.app_keys) - 1; i >= 0; i--) {
+        struct bt_mesh_app_key *key = &bt_mesh.app_keys[i];
+
+        if (key->net_idx == BT_MESH_KEY_UNUSED) {
+            continue;
+        }
+
+        for (v = key->updated ? 1 : 0; v >= 0; v--) {
+            u8_t aid = key->keys[v].id & AID_MASK;
+
+            app_aid_next[i * 2 + v] = app_aid_head[aid];
+            app_aid_head[aid] = i * 2 + v + 1;
+        }
+    }
+}
+
 struct bt_mesh_app_key *bt_mesh_app_key_find(u16_t app_idx)
 {
     int i;
@@ -664,7 +696,8 @@ static int sdu_recv(struct bt_mesh_net_rx *rx, u32_t seq, u8_t hdr,
 {
     NET_BUF_SIMPLE_DEFINE(sdu, CONFIG_BT_MESH_RX_SDU_MAX - 4);
     u8_t *ad;
-    u16_t i;
+    u8_t e;
+    int label;
     int err;
 
     BT_DBG("ASZMIC %u AKF %u AID 0x%02x", aszmic, AKF(&hdr), AID(&hdr));
@@ -681,8 +714,12 @@ static int sdu_recv(struct bt_mesh_net_rx *rx, u32_t seq, u8_t hdr,
         return 0;
     }
 
+    /* A virtual address is only a 16-bit hash of its Label UUID, the
+     * AppKeys are tried with every label that has this address.
+     */
+    label = 0;
     if (BT_MESH_ADDR_IS_VIRTUAL(rx->ctx.recv_dst)) {
-        ad = bt_mesh_label_uuid_get(rx->ctx.recv_dst);
+        ad = bt_mesh_label_uuid_next(rx->ctx.recv_dst, &label);
     } else {
         ad = NULL;
     }
@@ -709,43 +746,37 @@ static int sdu_recv(struct bt_mesh_net_rx *rx, u32_t seq, u8_t hdr,
         return 0;
     }
 
-    for (i = 0U; i < ARRAY_SIZE(bt_mesh.app_keys); i++) {
-        struct bt_mesh_app_key *key = &bt_mesh.app_keys[i];
-        struct bt_mesh_app_keys *keys;
-
-        /* Check that this AppKey matches received net_idx */
-        if (key->net_idx != rx->sub->net_idx) {
-            continue;
-        }
+    do {
+        for (e = app_aid_head[AID(&hdr)]; e; e = app_aid_next[e - 1]) {
+            struct bt_mesh_app_key *key = &bt_mesh.app_keys[(e - 1) / 2];
+            struct bt_mesh_app_keys *keys = &key->keys[(e - 1) % 2];
 
-        if (rx->new_key && key->updated) {
-            keys = &key->keys[1];
-        } else {
-            keys = &key->keys[0];
-        }
+            /* Check that this AppKey matches received net_idx and that
+             * the key version is the one of the Key Refresh phase.
+             */
+            if (key->net_idx != rx->sub->net_idx ||
+                ((e - 1) % 2) != (rx->new_key && key->updated) ||
+                AID(&hdr) != keys->id) {
+                continue;
+            }
 
-        /* Check that the AppKey ID matches */
-        if (AID(&hdr) != keys->id) {
-            continue;
-        }
+            net_buf_simple_reset(&sdu);
+            err = bt_mesh_app_decrypt(keys->val, false, aszmic, buf,
+                          &sdu, ad, rx->ctx.addr,
+                          rx->ctx.recv_dst, seq,
+                          BT_MESH_NET_IVI_RX(rx));
+            if (err) {
+                BT_WARN("Unable to decrypt with AppKey 0x%03x",
+                    key->app_idx);
+                continue;
+            }
 
-        net_buf_simple_reset(&sdu);
-        err = bt_mesh_app_decrypt(keys->val, false, aszmic, buf,
-                      &sdu, ad, rx->ctx.addr,
-                      rx->ctx.recv_dst, seq,
-                      BT_MESH_NET_IVI_RX(rx));
-        if (err) {
-            BT_WARN("Unable to decrypt with AppKey 0x%03x",
-                key->app_idx);
-            continue;
+            rx->ctx.app_idx = key->app_idx;
 
+            bt_mesh_model_recv(rx, &sdu);
+            return 0;
         }
-
-        rx->ctx.app_idx = key->app_idx;
-
-        bt_mesh_model_recv(rx, &sdu);
-        return 0;
-    }
+    } while (ad && (ad = bt_mesh_label_uuid_next(rx->ctx.recv_dst, &label)));
 
 #ifdef CONFIG_BT_MESH_PTS
     BT_PTS("[PTS] Unknown application key");
@@ -88,6 +88,7 @@ s32_t bt_mesh_get_seg_retrans_timeout(u8_t ttl);
 void bt_mesh_set_hb_sub_dst(u16_t addr);
 
 struct bt_mesh_app_key *bt_mesh_app_key_find(u16_t app_idx);
+void bt_mesh_app_key_index_update(void);
 
 bool bt_mesh_tx_in_progress(void);
 
@@ -0,0 +1,2 @@
+/* Host test stand-in, mesh_config.h only needs the priorities */
+#define configMAX_PRIORITIES    32
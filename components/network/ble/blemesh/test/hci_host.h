@@ -0,0 +1,2 @@
+/* Host test stand-in, see zephyr.h */
+#include <zephyr.h>
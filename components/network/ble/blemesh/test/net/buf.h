@@ -0,0 +1,247 @@
+/* Host test stand-in, only the simple buffers the sources under test use */
+#ifndef TEST_NET_BUF_H
+#define TEST_NET_BUF_H
+#include <zephyr.h>
+
+struct net_buf_simple {
+    u8_t *data;
+    u16_t len;
+    u16_t size;
+    u8_t *__buf;
+};
+
+struct net_buf_simple_state {
+    u16_t offset;
+    u16_t len;
+};
+
+#define NET_BUF_FRAGS           BIT(0)
+
+struct net_buf {
+    union {
+        sys_snode_t node;
+        struct net_buf *frags;
+    };
+    u8_t ref;
+    u8_t flags;
+    union {
+        struct {
+            u8_t *data;
+            u16_t len;
+            u16_t size;
+            u8_t *__buf;
+        };
+        struct net_buf_simple b;
+    };
+    void *user_data[1];
+};
+
+/* A fixed pool only, the buffers are handed out by net_buf_alloc() */
+struct net_buf_pool {
+    u16_t buf_count;
+    u16_t data_size;
+    struct net_buf *__bufs;
+    u8_t *data;
+};
+
+#define NET_BUF_POOL_FIXED_DEFINE(_name, _count, _data_size, _destroy) \
+    static struct net_buf net_buf_##_name[_count]; \
+    static u8_t net_buf_data_##_name[_count][_data_size]; \
+    struct net_buf_pool _name = { _count, _data_size, net_buf_##_name, \
+                      (u8_t *)net_buf_data_##_name }
+
+#define NET_BUF_SIMPLE_DEFINE(name, sz) \
+    u8_t name##_data[sz]; \
+    struct net_buf_simple name = { name##_data, 0, sz, name##_data }
+
+static inline void net_buf_simple_save(struct net_buf_simple *buf, struct net_buf_simple_state *state)
+{
+    state->offset = buf->data - buf->__buf;
+    state->len = buf->len;
+}
+
+static inline void net_buf_simple_restore(struct net_buf_simple *buf, struct net_buf_simple_state *state)
+{
+    buf->data = buf->__buf + state->offset;
+    buf->len = state->len;
+}
+
+static inline void *net_buf_simple_pull(struct net_buf_simple *buf, size_t len)
+{
+    buf->len -= len;
+    return buf->data += len;
+}
+
+static inline u8_t net_buf_simple_pull_u8(struct net_buf_simple *buf)
+{
+    buf->len--;
+    return *buf->data++;
+}
+
+static inline u16_t net_buf_simple_pull_be16(struct net_buf_simple *buf)
+{
+    u16_t val = (buf->data[0] << 8) | buf->data[1];
+
+    buf->data += 2;
+    buf->len -= 2;
+    return val;
+}
+
+static inline u32_t net_buf_simple_pull_be32(struct net_buf_simple *buf)
+{
+    u32_t val = net_buf_simple_pull_be16(buf) << 16;
+
+    return val | net_buf_simple_pull_be16(buf);
+}
+
+static inline u16_t net_buf_simple_pull_le16(struct net_buf_simple *buf)
+{
+    u16_t val = (buf->data[1] << 8) | buf->data[0];
+
+    buf->data += 2;
+    buf->len -= 2;
+    return val;
+}
+
+static inline void net_buf_simple_init(struct net_buf_simple *buf, size_t reserve)
+{
+    buf->data = buf->__buf + reserve;
+    buf->len = 0;
+}
+
+static inline void net_buf_simple_reset(struct net_buf_simple *buf)
+{
+    net_buf_simple_init(buf, 0);
+}
+
+static inline size_t net_buf_simple_tailroom(struct net_buf_simple *buf)
+{
+    return buf->size - (buf->data - buf->__buf) - buf->len;
+}
+
+static inline void *net_buf_simple_add_mem(struct net_buf_simple *buf, const void *mem, size_t len)
+{
+    u8_t *tail = buf->data + buf->len;
+
+    memcpy(tail, mem, len);
+    buf->len += len;
+    return tail;
+}
+
+static inline void net_buf_simple_add_u8(struct net_buf_simple *buf, u8_t val)
+{
+    net_buf_simple_add_mem(buf, &val, 1);
+}
+
+static inline void net_buf_simple_add_be16(struct net_buf_simple *buf, u16_t val)
+{
+    u8_t b[2] = { val >> 8, val };
+
+    net_buf_simple_add_mem(buf, b, 2);
+}
+
+static inline void net_buf_simple_add_le16(struct net_buf_simple *buf, u16_t val)
+{
+    u8_t b[2] = { val, val >> 8 };
+
+    net_buf_simple_add_mem(buf, b, 2);
+}
+
+static inline void net_buf_simple_reserve(struct net_buf_simple *buf, size_t reserve)
+{
+    buf->data = buf->__buf + reserve;
+}
+
+static inline void *net_buf_simple_add(struct net_buf_simple *buf, size_t len)
+{
+    u8_t *tail = buf->data + buf->len;
+
+    buf->len += len;
+    return tail;
+}
+
+static inline void net_buf_simple_push_u8(struct net_buf_simple *buf, u8_t val)
+{
+    *--buf->data = val;
+    buf->len++;
+}
+
+static inline struct net_buf *net_buf_alloc(struct net_buf_pool *pool)
+{
+    int i;
+
+    for (i = 0; i < pool->buf_count; i++) {
+        struct net_buf *buf = &pool->__bufs[i];
+
+        if (!buf->ref) {
+            memset(buf, 0, sizeof(*buf));
+            buf->ref = 1;
+            buf->__buf = pool->data + i * pool->data_size;
+            buf->data = buf->__buf;
+            buf->size = pool->data_size;
+            return buf;
+        }
+    }
+
+    return NULL;
+}
+
+static inline int net_buf_id(struct net_buf_pool *pool, struct net_buf *buf)
+{
+    return buf - pool->__bufs;
+}
+
+static inline void *net_buf_user_data(struct net_buf *buf)
+{
+    return buf->user_data;
+}
+
+static inline struct net_buf *net_buf_ref(struct net_buf *buf)
+{
+    buf->ref++;
+    return buf;
+}
+
+/* Like the real one, the fragment chain goes with the last reference */
+static inline void net_buf_unref(struct net_buf *buf)
+{
+    assert(buf->ref);
+
+    while (buf) {
+        struct net_buf *frags = buf->frags;
+
+        if (--buf->ref > 0) {
+            return;
+        }
+
+        buf->frags = NULL;
+        buf = frags;
+    }
+}
+
+static inline void net_buf_slist_put(sys_slist_t *list, struct net_buf *buf)
+{
+    sys_slist_append(list, &buf->node);
+}
+
+static inline void net_buf_reserve(struct net_buf *buf, size_t reserve)
+{
+    net_buf_simple_reserve(&buf->b, reserve);
+}
+
+static inline void *net_buf_add_mem(struct net_buf *buf, const void *mem, size_t len)
+{
+    return net_buf_simple_add_mem(&buf->b, mem, len);
+}
+
+static inline void net_buf_add_u8(struct net_buf *buf, u8_t val)
+{
+    net_buf_simple_add_u8(&buf->b, val);
+}
+
+static inline void net_buf_add_be16(struct net_buf *buf, u16_t val)
+{
+    net_buf_simple_add_be16(&buf->b, val);
+}
+
+#endif
@@ -0,0 +1,318 @@
+/*
+ * Host test of the access layer dispatch index. Random compositions with
+ * random subscriptions and AppKey bindings get every opcode to every kind
+ * of destination, once through the index and once through the linear
+ * element/model walk, and the models called have to be the same in the
+ * same order. bt_mesh_elem_find is compared the same way. A composition
+ * with more opcodes than the table holds checks the fallback. From this
+ * directory:
+ *
+ *   gcc -I. -I../src -I../src/include test_access_index.c -o test_access_index
+ *   ./test_access_index [compositions]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/access.c"
+
+#define ELEMS       6
+#define MODELS      6
+#define VND_MODELS  4
+#define OPS         5
+#define LOG_MAX     64
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+/* what access.c needs from the rest of the stack */
+int bt_mesh_cfg_srv_init(struct bt_mesh_model *model, bool primary)
+{
+    (void)model;
+    (void)primary;
+    return 0;
+}
+
+int bt_mesh_health_srv_init(struct bt_mesh_model *model, bool primary)
+{
+    (void)model;
+    (void)primary;
+    return 0;
+}
+
+u8_t bt_mesh_net_transmit_get(void)
+{
+    return 0;
+}
+
+u8_t bt_mesh_relay_get(void)
+{
+    return BT_MESH_RELAY_ENABLED;
+}
+
+u8_t bt_mesh_friend_get(void)
+{
+    return BT_MESH_FRIEND_NOT_SUPPORTED;
+}
+
+struct bt_mesh_subnet *bt_mesh_subnet_get(u16_t net_idx)
+{
+    (void)net_idx;
+    return NULL;
+}
+
+struct bt_mesh_app_key *bt_mesh_app_key_find(u16_t app_idx)
+{
+    (void)app_idx;
+    return NULL;
+}
+
+int bt_mesh_trans_send(struct bt_mesh_net_tx *tx, struct net_buf_simple *msg,
+               const struct bt_mesh_send_cb *cb, void *cb_data)
+{
+    (void)tx;
+    (void)msg;
+    (void)cb;
+    (void)cb_data;
+    return -EINVAL;
+}
+
+bool bt_mesh_is_provisioned(void)
+{
+    return true;
+}
+
+static const u32_t sig_ops[] = { 0x01, 0x02, 0x03, 0x8201, 0x8202, 0x8203 };
+static const u32_t vnd_ops[] = { 0xc00001, 0xc10002, 0xc20003 };
+static const u16_t dsts[] = {
+    0x0100, 0x0101, 0x0102, 0x0105, 0x0999,
+    0xc000, 0xc001, 0xc002, 0xc003, 0x8001,
+    BT_MESH_ADDR_ALL_NODES, BT_MESH_ADDR_FRIENDS, BT_MESH_ADDR_RELAYS,
+};
+static const u16_t group_pool[] = { 0xc000, 0xc001, 0xc002, 0xc003, 0x8001 };
+
+static struct bt_mesh_model_op op_tab[ELEMS * (MODELS + VND_MODELS)][OPS + 1];
+static struct bt_mesh_model models[ELEMS][MODELS];
+static struct bt_mesh_model vnd_models[ELEMS][VND_MODELS];
+static struct bt_mesh_elem elems[ELEMS];
+static struct bt_mesh_comp comp;
+
+static struct bt_mesh_model *delivered[LOG_MAX];
+static int delivered_n;
+static bool op_index_built;
+
+static void handler(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
+            struct net_buf_simple *buf)
+{
+    (void)ctx;
+    (void)buf;
+    if (delivered_n < LOG_MAX) {
+        delivered[delivered_n] = model;
+    }
+    delivered_n++;
+}
+
+static struct bt_mesh_model *model_at(int e, int m)
+{
+    if (m < elems[e].model_count) {
+        return &elems[e].models[m];
+    }
+    return &elems[e].vnd_models[m - elems[e].model_count];
+}
+
+static void set_op(struct bt_mesh_model_op *op, u32_t opcode, size_t min_len)
+{
+    struct bt_mesh_model_op tmp = { opcode, min_len, handler };
+
+    memcpy(op, &tmp, sizeof(tmp));
+}
+
+static void make_comp(int elem_count, int ops_per_model)
+{
+    struct bt_mesh_model tmp;
+    int e, m, k, tab = 0;
+
+    memset(models, 0, sizeof(models));
+    memset(vnd_models, 0, sizeof(vnd_models));
+    memset(op_tab, 0, sizeof(op_tab));
+
+    for (e = 0; e < elem_count; e++) {
+        /* with ops_per_model set every element is full */
+        struct bt_mesh_elem elem = { 0, 0,
+                         ops_per_model ? MODELS : rand() % (MODELS + 1),
+                         ops_per_model ? VND_MODELS : rand() % (VND_MODELS + 1),
+                         models[e], vnd_models[e] };
+
+        memcpy(&elems[e], &elem, sizeof(elem));
+
+        for (m = 0; m < elem.model_count + elem.vnd_model_count; m++) {
+            bool vnd = m >= elem.model_count;
+            int n = ops_per_model ? ops_per_model : rand() % OPS;
+
+            memset(&tmp, 0, sizeof(tmp));
+            if (vnd) {
+                tmp.vnd.company = 0x0001;
+                tmp.vnd.id = 0x1000 + m;
+            } else {
+                *(u16_t *)&tmp.vnd.company = 0x1000 + m;
+            }
+            for (k = 0; k < n; k++) {
+                /* now and then an opcode of the other kind, which the
+                 * walk never looks up in this model list
+                 */
+                bool other = !(rand() % 8);
+
+                set_op(&op_tab[tab][k], vnd != other ? vnd_ops[rand() % ARRAY_SIZE(vnd_ops)] :
+                       sig_ops[rand() % ARRAY_SIZE(sig_ops)], rand() % 3);
+            }
+            /* a zero opcode ends the list */
+            tmp.op = op_tab[tab++];
+            memcpy(model_at(e, m), &tmp, sizeof(tmp));
+        }
+    }
+
+    comp.elem_count = elem_count;
+    comp.elem = elems;
+    CHECK(bt_mesh_comp_register(&comp) == 0, "register");
+    bt_mesh_comp_provision(0x0100);
+    op_index_built = access_idx.op_valid;
+}
+
+static void random_subs(void)
+{
+    struct bt_mesh_model *mod;
+    size_t e, i;
+    int m;
+
+    for (e = 0; e < comp.elem_count; e++) {
+        for (m = 0; m < elems[e].model_count + elems[e].vnd_model_count; m++) {
+            mod = model_at(e, m);
+            for (i = 0; i < ARRAY_SIZE(mod->groups); i++) {
+                mod->groups[i] = rand() % 3 ? BT_MESH_ADDR_UNASSIGNED :
+                         group_pool[rand() % ARRAY_SIZE(group_pool)];
+            }
+            for (i = 0; i < ARRAY_SIZE(mod->keys); i++) {
+                mod->keys[i] = rand() % 3 ? BT_MESH_KEY_UNUSED : rand() % 3;
+            }
+        }
+    }
+    bt_mesh_access_subs_changed();
+}
+
+static int recv(u16_t dst, u16_t app_idx, u32_t opcode, int payload, bool indexed)
+{
+    u8_t data[8] = { 0 };
+    struct net_buf_simple buf = { data, 0, sizeof(data), data };
+    struct bt_mesh_net_rx rx;
+
+    memset(&rx, 0, sizeof(rx));
+    rx.ctx.recv_dst = dst;
+    rx.ctx.app_idx = app_idx;
+    if (opcode < 0x100) {
+        data[0] = opcode;
+        buf.len = 1;
+    } else if (opcode < 0x10000) {
+        data[0] = opcode >> 8;
+        data[1] = opcode;
+        buf.len = 2;
+    } else {
+        data[0] = opcode >> 16;
+        data[1] = opcode;
+        data[2] = opcode >> 8;
+        buf.len = 3;
+    }
+    buf.len += payload;
+
+    access_idx.op_valid = indexed && op_index_built;
+    delivered_n = 0;
+    bt_mesh_model_recv(&rx, &buf);
+    access_idx.op_valid = op_index_built;
+    return delivered_n;
+}
+
+static struct bt_mesh_elem *elem_find_linear(u16_t addr)
+{
+    bool group_valid = access_idx.group_valid, group_stale = access_idx.group_stale;
+    u16_t primary = dev_primary_addr;
+    struct bt_mesh_elem *elem;
+
+    access_idx.group_valid = false;
+    access_idx.group_stale = false;
+    dev_primary_addr = BT_MESH_ADDR_UNASSIGNED;
+    elem = bt_mesh_elem_find(addr);
+    access_idx.group_valid = group_valid;
+    access_idx.group_stale = group_stale;
+    dev_primary_addr = primary;
+    return elem;
+}
+
+/* every opcode, AppKey and length to every destination, both ways */
+static int compare(unsigned *deliveries)
+{
+    struct bt_mesh_model *indexed[LOG_MAX];
+    struct bt_mesh_elem *elem;
+    size_t d, o;
+    int a, l, n, checked = 0;
+    u32_t opcode;
+
+    for (d = 0; d < ARRAY_SIZE(dsts); d++) {
+        elem = bt_mesh_elem_find(dsts[d]);
+        CHECK(elem == elem_find_linear(dsts[d]), "elem_find 0x%04x", dsts[d]);
+        /* five group addresses always fit */
+        CHECK(BT_MESH_ADDR_IS_UNICAST(dsts[d]) || dsts[d] >= 0xff00 ||
+              (access_idx.group_valid && !access_idx.group_stale), "group index not used");
+
+        for (o = 0; o < ARRAY_SIZE(sig_ops) + ARRAY_SIZE(vnd_ops); o++) {
+            opcode = o < ARRAY_SIZE(sig_ops) ? sig_ops[o] : vnd_ops[o - ARRAY_SIZE(sig_ops)];
+            for (a = 0; a < 3; a++) {
+                for (l = 0; l < 3; l++) {
+                    n = recv(dsts[d], a, opcode, l, true);
+                    memcpy(indexed, delivered, sizeof(indexed));
+                    CHECK(recv(dsts[d], a, opcode, l, false) == n &&
+                          !memcmp(indexed, delivered, n * sizeof(indexed[0])),
+                          "dst 0x%04x op 0x%06x app %d len %d: %d models indexed, %d linear",
+                          dsts[d], opcode, a, l, n, delivered_n);
+                    *deliveries += n;
+                    checked++;
+                }
+            }
+        }
+    }
+    return checked;
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = argc > 1 ? atoi(argv[1]) : 1000;
+    int i, k, checked = 0, unindexed = 0;
+    unsigned deliveries = 0;
+
+    srand(1);
+    for (i = 0; i < runs; i++) {
+        /* the largest ones do not fit and run linear both ways */
+        make_comp(1 + rand() % ELEMS, 0);
+        unindexed += !op_index_built;
+        for (k = 0; k < 4; k++) {
+            random_subs();
+            checked += compare(&deliveries);
+        }
+    }
+
+    /* 6 x 10 models with 5 opcodes each do not fit */
+    make_comp(ELEMS, OPS);
+    CHECK(!op_index_built, "oversized composition indexed");
+    random_subs();
+    checked += compare(&deliveries);
+
+    printf("%d compositions, %d over the op index, %d dispatches compared, %u deliveries\r\n",
+           runs + 1, unindexed + 1, checked, deliveries);
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,321 @@
+/*
+ * Host test of the AID index of the AppKeys. Random AppKey tables, with
+ * few AIDs so that they collide, keys of several subnets and keys in Key
+ * Refresh, get access PDUs for unicast and for virtual addresses that
+ * several Label UUIDs hash to. Each PDU goes through sdu_recv() and
+ * through the plain scan of bt_mesh.app_keys over every label, and both
+ * have to pick the same AppKey with the same number of decryptions, or
+ * both find none. From this directory:
+ *
+ *   gcc -DBFLB_BLE -DCONFIG_BT_MESH_APP_KEY_COUNT=16 \
+ *       -DCONFIG_BT_MESH_LABEL_COUNT=4 -I. -I../src -I../src/include \
+ *       test_app_key_index.c -o test_app_key_index
+ *   ./test_app_key_index [pdus]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/transport.c"
+
+#define KEYS        CONFIG_BT_MESH_APP_KEY_COUNT
+#define LABELS      CONFIG_BT_MESH_LABEL_COUNT
+#define SUBNETS     3
+#define AIDS        4           /* of the 64, so that chains are long */
+#define VIRT_ADDR   0x8123
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+struct bt_mesh_net bt_mesh;
+
+/* What the PDU was encrypted with, the stand-in AES accepts only that */
+static const u8_t *pdu_key;
+static const u8_t *pdu_label;
+static long decrypts;
+static int received = -1;
+
+int bt_mesh_app_decrypt(const u8_t key[16], bool dev_key, u8_t aszmic,
+            struct net_buf_simple *buf, struct net_buf_simple *out,
+            const u8_t *ad, u16_t src, u16_t dst, u32_t seq_num,
+            u32_t iv_index)
+{
+    decrypts++;
+
+    if (key != pdu_key || ad != pdu_label) {
+        return -EINVAL;
+    }
+
+    net_buf_simple_add_mem(out, buf->data, buf->len);
+    return 0;
+}
+
+void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
+{
+    received = rx->ctx.app_idx;
+}
+
+/* Labels of cfg_srv.c, all but the last with the same virtual address */
+static struct {
+    u16_t addr;
+    u8_t uuid[16];
+} labels[LABELS];
+
+u8_t *bt_mesh_label_uuid_next(u16_t addr, int *idx)
+{
+    for (; *idx < ARRAY_SIZE(labels); (*idx)++) {
+        if (labels[*idx].addr == addr) {
+            return labels[(*idx)++].uuid;
+        }
+    }
+
+    return NULL;
+}
+
+/* Not on the receive path */
+unsigned int find_msb_set(uint32_t data)
+{
+    return data ? 32 - __builtin_clz(data) : 0;
+}
+
+struct net_buf *bt_mesh_adv_create(enum bt_mesh_adv_type type, u8_t xmit,
+                   s32_t timeout)
+{
+    return NULL;
+}
+
+int bt_mesh_app_encrypt(const u8_t key[16], bool dev_key, u8_t aszmic,
+            struct net_buf_simple *buf, const u8_t *ad,
+            u16_t src, u16_t dst, u32_t seq_num, u32_t iv_index)
+{
+    return -EINVAL;
+}
+
+struct bt_mesh_cfg_srv *bt_mesh_cfg_get(void)
+{
+    return NULL;
+}
+
+u8_t bt_mesh_default_ttl_get(void)
+{
+    return 7;
+}
+
+u8_t bt_mesh_friend_get(void)
+{
+    return 0;
+}
+
+u8_t bt_mesh_gatt_proxy_get(void)
+{
+    return 0;
+}
+
+u8_t bt_mesh_relay_get(void)
+{
+    return 0;
+}
+
+void bt_mesh_heartbeat(u16_t src, u16_t dst, u8_t hops, u16_t feat)
+{
+}
+
+u8_t *bt_mesh_label_uuid_get(u16_t addr)
+{
+    int idx = 0;
+
+    return bt_mesh_label_uuid_next(addr, &idx);
+}
+
+struct bt_mesh_elem *bt_mesh_model_elem(struct bt_mesh_model *mod)
+{
+    return NULL;
+}
+
+bool bt_mesh_net_iv_update(u32_t iv_index, bool iv_update)
+{
+    return false;
+}
+
+void bt_mesh_net_sec_update(struct bt_mesh_subnet *sub)
+{
+}
+
+int bt_mesh_net_send(struct bt_mesh_net_tx *tx, struct net_buf *buf,
+             const struct bt_mesh_send_cb *cb, void *cb_data)
+{
+    return -EINVAL;
+}
+
+int bt_mesh_net_resend(struct bt_mesh_subnet *sub, struct net_buf *buf,
+               bool new_key, const struct bt_mesh_send_cb *cb,
+               void *cb_data)
+{
+    return -EINVAL;
+}
+
+u8_t bt_mesh_net_transmit_get(void)
+{
+    return 0;
+}
+
+u16_t bt_mesh_primary_addr(void)
+{
+    return 0x0001;
+}
+
+struct bt_mesh_subnet *bt_mesh_subnet_get(u16_t net_idx)
+{
+    return NULL;
+}
+
+/* The scan sdu_recv() did before the index */
+static int scan_recv(u16_t net_idx, bool new_key, u8_t aid, u16_t dst)
+{
+    int label = 0, i;
+    u8_t *ad = BT_MESH_ADDR_IS_VIRTUAL(dst) ?
+               bt_mesh_label_uuid_next(dst, &label) : NULL;
+
+    do {
+        for (i = 0; i < KEYS; i++) {
+            struct bt_mesh_app_key *key = &bt_mesh.app_keys[i];
+            struct bt_mesh_app_keys *keys;
+
+            if (key->net_idx != net_idx) {
+                continue;
+            }
+
+            keys = (new_key && key->updated) ? &key->keys[1] : &key->keys[0];
+            if (keys->id != aid) {
+                continue;
+            }
+
+            decrypts++;
+            if (keys->val == pdu_key && ad == pdu_label) {
+                return key->app_idx;
+            }
+        }
+    } while (ad && (ad = bt_mesh_label_uuid_next(dst, &label)));
+
+    return -1;
+}
+
+static void random_keys(void)
+{
+    int i;
+
+    for (i = 0; i < KEYS; i++) {
+        struct bt_mesh_app_key *key = &bt_mesh.app_keys[i];
+
+        key->net_idx = (rand() % 5) ? rand() % SUBNETS : BT_MESH_KEY_UNUSED;
+        key->app_idx = i;
+        key->updated = !(rand() % 3);
+        key->keys[0].id = rand() % AIDS;
+        key->keys[1].id = key->updated ? rand() % AIDS : 0;
+    }
+
+    bt_mesh_app_key_index_update();
+}
+
+static double secs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    long pdus = argc > 1 ? atol(argv[1]) : 200000;
+    long n, found = 0, index_decrypts = 0, scan_decrypts = 0;
+    struct bt_mesh_subnet subs[SUBNETS];
+    double t_index = 0, t_scan = 0, t0;
+    int i;
+
+    for (i = 0; i < LABELS; i++) {
+        labels[i].addr = (i == LABELS - 1) ? VIRT_ADDR + 1 : VIRT_ADDR;
+    }
+    for (i = 0; i < SUBNETS; i++) {
+        subs[i].net_idx = i;
+    }
+
+    srand(7);
+    for (n = 0; n < pdus; n++) {
+        NET_BUF_SIMPLE_DEFINE(buf, 32);
+        struct bt_mesh_net_rx rx = { 0 };
+        struct bt_mesh_app_key *key;
+        int want, err, version;
+        u8_t hdr;
+
+        if (!(n % 1000)) {
+            random_keys();
+        }
+
+        do {
+            key = &bt_mesh.app_keys[rand() % KEYS];
+        } while (key->net_idx == BT_MESH_KEY_UNUSED);
+
+        rx.new_key = rand() % 2;
+        rx.ctx.addr = 0x0002;
+        rx.ctx.recv_dst = (rand() % 2) ? VIRT_ADDR : 0x0001;
+        rx.sub = &subs[key->net_idx];
+        rx.local_match = 1;
+
+        version = rx.new_key && key->updated;
+        pdu_key = key->keys[version].val;
+        hdr = BIT(6) | key->keys[version].id;
+        pdu_label = NULL;
+        if (BT_MESH_ADDR_IS_VIRTUAL(rx.ctx.recv_dst)) {
+            pdu_label = labels[rand() % (LABELS - 1)].uuid;
+        }
+
+        /* a key or label we do not have */
+        if (!(rand() % 4)) {
+            pdu_key = NULL;
+        }
+
+        decrypts = 0;
+        t0 = secs();
+        want = scan_recv(key->net_idx, rx.new_key, hdr & AID_MASK,
+                         rx.ctx.recv_dst);
+        t_scan += secs() - t0;
+        scan_decrypts += decrypts;
+
+        net_buf_simple_add_u8(&buf, hdr);
+        net_buf_simple_add_mem(&buf, "payload+mic", 11);
+        net_buf_simple_pull_u8(&buf);
+
+        received = -1;
+        decrypts = 0;
+        t0 = secs();
+        err = sdu_recv(&rx, 1, hdr, 0, &buf);
+        t_index += secs() - t0;
+        index_decrypts += decrypts;
+
+        CHECK(received == want && !err == (want >= 0),
+              "pdu %ld: AppKey %d, the scan found %d", n, received, want);
+        found += want >= 0;
+        if (failures > 10) {
+            break;
+        }
+    }
+
+    CHECK(index_decrypts == scan_decrypts, "%ld decryptions, the scan %ld",
+          index_decrypts, scan_decrypts);
+
+    printf("%ld PDUs, %ld with a key, %.2f decryptions each\r\n",
+           n, found, (double)index_decrypts / n);
+    printf("sdu_recv %.0f ns, plain scan %.0f ns per PDU\r\n",
+           t_index / n * 1e9, t_scan / n * 1e9);
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
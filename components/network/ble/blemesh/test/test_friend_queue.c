@@ -0,0 +1,404 @@
+/*
+ * Host simulation of the Friend Queue quotas. Three LPNs share the friend
+ * buffer pool, one of them gets most of the traffic and polls seldom, the
+ * other two are quiet. Single and segmented messages go through
+ * bt_mesh_friend_enqueue_rx() and the LPNs poll through
+ * bt_mesh_friend_poll() and the friend timeout, so the real queue code is
+ * what runs. Every message an LPN gets has to be whole and in order, no
+ * queue may go over its share, the pool must never run dry and the
+ * overflow counters have to add up with what was lost. From this
+ * directory:
+ *
+ *   gcc -DBFLB_BLE -DCONFIG_BT_MESH_FRIEND -DCONFIG_BT_MESH_FRIEND_LPN_COUNT=3 \
+ *       -DCONFIG_BT_MESH_FRIEND_SEG_RX=2 -I. -I../src -I../src/include \
+ *       test_friend_queue.c -o test_friend_queue
+ *   ./test_friend_queue [steps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/friend.c"
+
+#define LPNS        CONFIG_BT_MESH_FRIEND_LPN_COUNT
+#define LPN_ADDR    0x0100
+#define SRC_ADDR    0x0001
+#define PAYLOAD_LEN 6
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+/* what friend.c needs from the rest of the stack */
+struct bt_mesh_net bt_mesh;
+static struct bt_mesh_subnet subnet;
+static u32_t seq;
+static int alloc_failed;
+
+struct bt_mesh_subnet *bt_mesh_subnet_get(u16_t net_idx)
+{
+    (void)net_idx;
+    return &subnet;
+}
+
+int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
+            const u8_t **enc, const u8_t **priv)
+{
+    (void)sub;
+    (void)addr;
+    *nid = 0U;
+    *enc = subnet.keys[0].enc;
+    *priv = subnet.keys[0].privacy;
+    return 0;
+}
+
+int friend_cred_del(u16_t net_idx, u16_t addr)
+{
+    (void)net_idx;
+    (void)addr;
+    return 0;
+}
+
+struct friend_cred *friend_cred_create(struct bt_mesh_subnet *sub, u16_t addr,
+                       u16_t lpn_counter, u16_t frnd_counter)
+{
+    (void)sub;
+    (void)addr;
+    (void)lpn_counter;
+    (void)frnd_counter;
+    return NULL;
+}
+
+int bt_mesh_net_encrypt(const u8_t key[16], struct net_buf_simple *buf,
+            u32_t iv_index, bool proxy)
+{
+    (void)key;
+    (void)buf;
+    (void)iv_index;
+    (void)proxy;
+    return 0;
+}
+
+int bt_mesh_net_obfuscate(u8_t *pdu, u32_t iv_index, const u8_t privacy_key[16])
+{
+    (void)pdu;
+    (void)iv_index;
+    (void)privacy_key;
+    return 0;
+}
+
+u8_t bt_mesh_net_flags(struct bt_mesh_subnet *sub)
+{
+    (void)sub;
+    return 0U;
+}
+
+u32_t bt_mesh_next_seq(void)
+{
+    return seq++;
+}
+
+u16_t bt_mesh_primary_addr(void)
+{
+    return 0x0002;
+}
+
+u8_t bt_mesh_net_transmit_get(void)
+{
+    return 0U;
+}
+
+u8_t bt_mesh_friend_get(void)
+{
+    return BT_MESH_FRIEND_ENABLED;
+}
+
+struct bt_mesh_elem *bt_mesh_elem_find(u16_t addr)
+{
+    (void)addr;
+    return NULL;
+}
+
+int bt_mesh_ctl_send(struct bt_mesh_net_tx *tx, u8_t ctl_op, void *data,
+             size_t data_len, u64_t *seq_auth,
+             const struct bt_mesh_send_cb *cb, void *cb_data)
+{
+    (void)tx;
+    (void)ctl_op;
+    (void)data;
+    (void)data_len;
+    (void)seq_auth;
+    (void)cb;
+    (void)cb_data;
+    return 0;
+}
+
+struct net_buf *bt_mesh_adv_create_from_pool(struct net_buf_pool *pool,
+                         bt_mesh_adv_alloc_t get_id,
+                         enum bt_mesh_adv_type type,
+                         u8_t xmit, s32_t timeout)
+{
+    struct bt_mesh_adv *adv;
+    struct net_buf *buf;
+
+    (void)timeout;
+
+    buf = net_buf_alloc(pool);
+    if (!buf) {
+        alloc_failed++;
+        return NULL;
+    }
+
+    adv = get_id(net_buf_id(pool, buf));
+    BT_MESH_ADV(buf) = adv;
+    (void)memset(adv, 0, sizeof(*adv));
+    adv->type = type;
+    adv->xmit = xmit;
+
+    return buf;
+}
+
+/* What each LPN has received, a message is a run of segments 0..n-1 */
+static struct lpn {
+    u32_t accepted;
+    u32_t delivered;
+    u32_t updates;
+    u32_t broken;
+    int msg;
+    int got;
+    u8_t fsn;
+} lpn[LPNS];
+
+static struct bt_mesh_friend *sent_to;
+
+void bt_mesh_adv_send(struct net_buf *buf, const struct bt_mesh_send_cb *cb,
+              void *cb_data)
+{
+    struct bt_mesh_friend *frnd = cb_data;
+    struct lpn *l = &lpn[frnd - bt_mesh.frnd];
+    const u8_t *pdu = buf->data + BT_MESH_NET_HDR_LEN;
+    int msg, segi, segn;
+
+    sent_to = frnd;
+
+    if (buf->data[1] & 0x80) {
+        l->updates++;
+    } else {
+        msg = sys_get_be16(pdu);
+        segi = pdu[2];
+        segn = pdu[3];
+
+        if (segi == 0) {
+            if (l->msg >= 0) {
+                l->broken++;
+            }
+            l->msg = msg;
+            l->got = 0;
+        }
+
+        if (msg != l->msg || segi != l->got) {
+            l->broken++;
+            l->msg = -1;
+        } else if (++l->got == segn) {
+            l->delivered++;
+            l->msg = -1;
+        }
+    }
+
+    cb->start(0, 0, cb_data);
+    cb->end(0, cb_data);
+}
+
+static void check_quota(void)
+{
+    int i;
+
+    for (i = 0; i < LPNS; i++) {
+        struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+        sys_snode_t *node;
+        u32_t len = 0U;
+
+        for (node = sys_slist_peek_head(&frnd->queue); node;
+             node = sys_slist_peek_next(node)) {
+            len++;
+        }
+
+        CHECK(len == frnd->queue_size, "LPN %d queue %u size %u",
+              i, len, frnd->queue_size);
+        CHECK(frnd->queue_size + frnd->seg_pending <=
+              CONFIG_BT_MESH_FRIEND_QUEUE_SIZE,
+              "LPN %d over its share, %u queued %u pending", i,
+              frnd->queue_size, frnd->seg_pending);
+    }
+}
+
+static void poll(int i)
+{
+    struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+    struct bt_mesh_net_rx rx = {
+        .sub = &subnet,
+        .ctx.addr = LPN_ADDR + i,
+    };
+    NET_BUF_SIMPLE_DEFINE(buf, 1);
+
+    net_buf_simple_add_u8(&buf, lpn[i].fsn);
+
+    sent_to = NULL;
+    CHECK(!bt_mesh_friend_poll(&rx, &buf), "poll of LPN %d", i);
+    friend_timeout(&frnd->timer.work);
+    CHECK(sent_to == frnd, "LPN %d got nothing", i);
+
+    lpn[i].fsn ^= 1U;
+}
+
+static int msg_next;
+
+/* For the busy LPN a segmented message may have a second one arrive in
+ * the middle of it, like two senders talking to the same group. Both hold
+ * a segment reservation then and the second one may get refused.
+ */
+static void send_msg(int i, u8_t segn, bool nest)
+{
+    struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+    struct bt_mesh_net_rx rx = {
+        .sub = &subnet,
+        .ctx.addr = SRC_ADDR,
+        .ctx.recv_dst = LPN_ADDR + i,
+        .ctx.recv_ttl = 5,
+        .net_if = BT_MESH_NET_IF_ADV,
+        .friend_match = 1,
+    };
+    int msg = ++msg_next & 0xffff;
+    u64_t seq_auth = msg;
+    u32_t refused = 0U;
+    u8_t segi;
+
+    for (segi = 0U; segi < segn; segi++) {
+        NET_BUF_SIMPLE_DEFINE(sdu, PAYLOAD_LEN);
+        enum bt_mesh_friend_pdu_type type;
+        u32_t before;
+
+        if (nest && segi == segn / 2 && rand() % 2) {
+            send_msg(i, 2 + rand() % 7, false);
+        }
+
+        net_buf_simple_add_be16(&sdu, msg);
+        net_buf_simple_add_u8(&sdu, segi);
+        net_buf_simple_add_u8(&sdu, segn);
+        net_buf_simple_add_be16(&sdu, 0);
+
+        if (segn == 1) {
+            type = BT_MESH_FRIEND_PDU_SINGLE;
+        } else if (segi == segn - 1) {
+            type = BT_MESH_FRIEND_PDU_COMPLETE;
+        } else {
+            type = BT_MESH_FRIEND_PDU_PARTIAL;
+        }
+
+        before = frnd->refused;
+        rx.seq = seq++;
+        bt_mesh_friend_enqueue_rx(&rx, type, segn > 1 ? &seq_auth : NULL,
+                      segn, &sdu);
+        refused += frnd->refused - before;
+        check_quota();
+    }
+
+    /* no reservation, no segment of it gets in */
+    CHECK(!refused || refused == segn, "LPN %d took %u of %u segments",
+          i, segn - refused, segn);
+
+    if (!refused) {
+        lpn[i].accepted++;
+    }
+}
+
+static void run(long steps)
+{
+    u32_t evicted, refused, lost;
+    long t;
+    int i;
+
+    bt_mesh_friend_init();
+
+    for (i = 0; i < LPNS; i++) {
+        struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+
+        frnd->lpn = LPN_ADDR + i;
+        frnd->num_elem = 1U;
+        frnd->net_idx = 0U;
+        frnd->valid = 1U;
+        frnd->established = 1U;
+        lpn[i].msg = -1;
+    }
+
+    for (t = 0; t < steps; t++) {
+        /* LPN 0 gets seven messages out of ten */
+        int to = (rand() % 10 < 7) ? 0 : 1 + rand() % (LPNS - 1);
+        u8_t segn = (rand() % 3 == 0) ? 2 + rand() % 7 : 1;
+
+        send_msg(to, segn, to == 0);
+
+        if (rand() % 16 == 0) {
+            poll(0);
+        }
+
+        /* the quiet ones keep up, whatever they lose is down to LPN 0 */
+        for (i = 1; i < LPNS; i++) {
+            while (!sys_slist_is_empty(&bt_mesh.frnd[i].queue)) {
+                poll(i);
+            }
+        }
+    }
+
+    /* drain, the last poll of each LPN gets an empty update */
+    for (i = 0; i < LPNS; i++) {
+        while (!sys_slist_is_empty(&bt_mesh.frnd[i].queue)) {
+            poll(i);
+        }
+        poll(i);
+    }
+
+    CHECK(!alloc_failed, "%d friend buffer allocations failed",
+          alloc_failed);
+
+    for (i = 0; i < LPNS; i++) {
+        CHECK(!bt_mesh_friend_overflow_get(LPN_ADDR + i, &evicted,
+                           &refused), "LPN %d counters", i);
+        CHECK(!lpn[i].broken, "LPN %d got %u broken messages", i,
+              lpn[i].broken);
+        CHECK(lpn[i].msg < 0, "LPN %d left in a message", i);
+
+        /* Friend Updates are only queued to an empty queue and sent
+         * right away, so whatever was evicted was an accepted message.
+         */
+        lost = lpn[i].accepted - lpn[i].delivered;
+        CHECK(lost == evicted, "LPN %d lost %u, %u evicted", i, lost,
+              evicted);
+
+        if (i == 0) {
+            CHECK(evicted && refused, "LPN 0 never overflowed");
+        } else {
+            CHECK(!evicted && !refused,
+                  "quiet LPN %d lost %u refused %u", i, evicted, refused);
+        }
+
+        printf("LPN %d: %u accepted, %u delivered, %u evicted, "
+               "%u refused, %u updates\r\n", i, lpn[i].accepted,
+               lpn[i].delivered, evicted, refused, lpn[i].updates);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    srand(1);
+    run(argc > 1 ? atol(argv[1]) : 200000);
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * Host test of the Proxy filter hash sets. Random add, remove and clear
+ * sequences on three clients sharing one pool are checked against a
+ * reference set after every step: membership, counts, and tables that stay
+ * inside the pool without overlapping. Then the per-client limit and a
+ * pool too small for all clients. From this directory:
+ *
+ *   gcc -DBFLB_BLE -I. -I../src -I../src/include test_proxy_filter.c ../src/proxy_filter.c -o test_proxy_filter
+ *   ./test_proxy_filter [steps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "include/access.h"
+#include "proxy_filter.h"
+
+#define CLIENTS     3
+#define ADDRS       400
+#define LIMIT       64
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+static u16_t slots[256];
+static struct proxy_filter filters[CLIENTS];
+static struct proxy_filter_pool pool = { slots, ARRAY_SIZE(slots), filters, CLIENTS };
+
+static u8_t ref[CLIENTS][ADDRS];
+static int ref_count[CLIENTS];
+
+/* group addresses and a few unicast ones, 0 included */
+static u16_t addr_of(int i)
+{
+    return i < 16 ? i : 0xc000 + i;
+}
+
+static void check_layout(void)
+{
+    int i, j, used = 0;
+
+    for (i = 0; i < CLIENTS; i++) {
+        used += filters[i].cap;
+        CHECK(!filters[i].cap || filters[i].off + filters[i].cap <= pool.size,
+              "client %d table %u+%u outside the pool", i, filters[i].off, filters[i].cap);
+        CHECK(!(filters[i].cap & (filters[i].cap - 1)), "client %d cap %u", i, filters[i].cap);
+        CHECK(filters[i].count * 4 <= filters[i].cap * 3, "client %d %u in %u slots",
+              i, filters[i].count, filters[i].cap);
+        for (j = 0; j < CLIENTS; j++) {
+            if (i != j && filters[i].cap && filters[j].cap) {
+                CHECK(filters[i].off + filters[i].cap <= filters[j].off ||
+                      filters[j].off + filters[j].cap <= filters[i].off,
+                      "clients %d and %d overlap", i, j);
+            }
+        }
+    }
+    CHECK(used <= pool.size, "%d slots used", used);
+}
+
+static void check_client(int c)
+{
+    int i;
+
+    CHECK(filters[c].count == ref_count[c], "client %d count %u, expected %d", c, filters[c].count, ref_count[c]);
+    for (i = 0; i < ADDRS; i++) {
+        CHECK(proxy_filter_has(&pool, &filters[c], addr_of(i)) == (ref[c][i] != 0),
+              "client %d addr 0x%04x", c, addr_of(i));
+    }
+}
+
+static void test_fuzz(long steps)
+{
+    int c, i, r, err;
+    long s;
+    unsigned full = 0;
+
+    for (s = 0; s < steps; s++) {
+        c = rand() % CLIENTS;
+        r = rand() % 100;
+        /* mostly low addresses, so that removes hit */
+        i = rand() % (rand() % 8 ? 80 : ADDRS);
+
+        if (r < 50) {
+            err = proxy_filter_add(&pool, &filters[c], addr_of(i), LIMIT);
+            if (!addr_of(i) || ref[c][i]) {
+                CHECK(err == -EALREADY, "add 0x%04x again: %d", addr_of(i), err);
+            } else if (ref_count[c] >= LIMIT) {
+                CHECK(err == -ENOSPC, "add over the limit: %d", err);
+                full++;
+            } else {
+                /* three full clients need 3 x 128 slots, the pool has 256 */
+                CHECK(!err || err == -ENOMEM, "add 0x%04x: %d", addr_of(i), err);
+                if (!err) {
+                    ref[c][i] = 1;
+                    ref_count[c]++;
+                } else {
+                    full++;
+                }
+            }
+        } else if (r < 97) {
+            proxy_filter_remove(&pool, &filters[c], addr_of(i));
+            if (ref[c][i]) {
+                ref[c][i] = 0;
+                ref_count[c]--;
+            }
+        } else {
+            proxy_filter_clear(&pool, &filters[c]);
+            CHECK(!filters[c].cap && !filters[c].count, "client %d not released", c);
+            memset(ref[c], 0, sizeof(ref[c]));
+            ref_count[c] = 0;
+        }
+
+        check_layout();
+        if (s % 64 == 0) {
+            for (c = 0; c < CLIENTS; c++) {
+                check_client(c);
+            }
+        } else {
+            check_client(c);
+        }
+    }
+    printf("%ld steps, %u adds refused\r\n", steps, full);
+
+    for (c = 0; c < CLIENTS; c++) {
+        proxy_filter_clear(&pool, &filters[c]);
+        memset(ref[c], 0, sizeof(ref[c]));
+        ref_count[c] = 0;
+    }
+}
+
+/* tables grow while the others move around them, rehashing needs room */
+static void test_grow(void)
+{
+    int c, i;
+
+    for (i = 0; i < LIMIT; i++) {
+        CHECK(proxy_filter_add(&pool, &filters[0], 0xc000 + i, LIMIT) == 0, "client 0 add %d", i);
+    }
+    CHECK(filters[0].cap == 128, "client 0 cap %u", filters[0].cap);
+    CHECK(proxy_filter_add(&pool, &filters[0], 0xd000, LIMIT) == -ENOSPC, "client 0 over the limit");
+
+    /* 48 addresses fill 64 slots, doubling needs 64 more and 64 scratch */
+    for (i = 0; i < 48; i++) {
+        CHECK(proxy_filter_add(&pool, &filters[1], 0xc100 + i, LIMIT) == 0, "client 1 add %d", i);
+    }
+    CHECK(proxy_filter_add(&pool, &filters[1], 0xc100 + i, LIMIT) == -ENOMEM, "client 1 in a full pool");
+    CHECK(filters[1].count == 48 && filters[1].cap == 64, "client 1 after refusal: %u/%u",
+          filters[1].count, filters[1].cap);
+    /* a new table of 8 slots still fits behind them */
+    CHECK(proxy_filter_add(&pool, &filters[2], 0xc200, LIMIT) == 0, "client 2 add");
+    CHECK(filters[2].off == 192 && filters[2].cap == 8, "client 2 at %u/%u", filters[2].off, filters[2].cap);
+    check_layout();
+
+    /* releasing the first table moves the others down, entries intact */
+    proxy_filter_clear(&pool, &filters[0]);
+    CHECK(filters[1].off == 0, "client 1 at %u", filters[1].off);
+    for (i = 0; i < 48; i++) {
+        CHECK(proxy_filter_has(&pool, &filters[1], 0xc100 + i), "client 1 lost 0x%04x", 0xc100 + i);
+    }
+    for (; i < LIMIT; i++) {
+        CHECK(proxy_filter_add(&pool, &filters[1], 0xc100 + i, LIMIT) == 0, "client 1 add %d", i);
+    }
+    CHECK(filters[2].off == 128, "client 2 at %u", filters[2].off);
+    for (i = 0; i < LIMIT; i++) {
+        CHECK(proxy_filter_has(&pool, &filters[1], 0xc100 + i), "client 1 lost 0x%04x", 0xc100 + i);
+    }
+    CHECK(proxy_filter_has(&pool, &filters[2], 0xc200), "client 2 lost 0xc200");
+    check_layout();
+
+    for (c = 0; c < CLIENTS; c++) {
+        proxy_filter_clear(&pool, &filters[c]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    srand(1);
+    test_grow();
+    test_fuzz(argc > 1 ? atol(argv[1]) : 200000);
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,240 @@
+/* Host test stand-in, enough of the blestack port for the blemesh sources */
+#ifndef TEST_ZEPHYR_H
+#define TEST_ZEPHYR_H
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef uint64_t u64_t;
+typedef int8_t s8_t;
+typedef int16_t s16_t;
+typedef int32_t s32_t;
+typedef int64_t s64_t;
+typedef int atomic_t;
+
+#define __packed                __attribute__((packed))
+#define BIT(n)                  (1UL << (n))
+#define BIT_MASK(n)             (BIT(n) - 1)
+#define ARRAY_SIZE(a)           (sizeof(a) / sizeof((a)[0]))
+#define CONTAINER_OF(p, t, f)   ((t *)((char *)(p) - offsetof(t, f)))
+#define IS_ENABLED(x)           0
+#define CODE_UNREACHABLE        __builtin_unreachable()
+#define ATOMIC_DEFINE(n, b)     atomic_t n[((b) + 31) / 32]
+#define __ASSERT_NO_MSG(x)      assert(x)
+#define BUILD_ASSERT(x)         _Static_assert(x, "")
+#define MIN(a, b)               (((a) < (b)) ? (a) : (b))
+#define MAX(a, b)               (((a) > (b)) ? (a) : (b))
+
+#define BT_DBG(...)
+#define BT_INFO(...)
+#define BT_WARN(...)
+#define BT_ERR(...)
+
+#define K_NO_WAIT               0
+#define K_MSEC(ms)              (ms)
+#define K_SECONDS(s)            ((s) * 1000)
+#define K_MINUTES(m)            ((m) * 60000)
+
+struct k_sem {
+    int count;
+};
+
+struct k_work {
+    void (*handler)(struct k_work *work);
+};
+
+struct k_delayed_work {
+    struct k_work work;
+};
+
+typedef struct _snode {
+    struct _snode *next;
+} sys_snode_t;
+
+typedef struct {
+    sys_snode_t *head;
+    sys_snode_t *tail;
+} sys_slist_t;
+
+#define SYS_SLIST_FOR_EACH_CONTAINER(l, cn, n) \
+    for (cn = (void *)(l)->head; cn; cn = (void *)(cn)->n.next)
+
+static inline void sys_slist_init(sys_slist_t *list)
+{
+    list->head = NULL;
+    list->tail = NULL;
+}
+
+static inline bool sys_slist_is_empty(sys_slist_t *list)
+{
+    return !list->head;
+}
+
+static inline sys_snode_t *sys_slist_peek_head(sys_slist_t *list)
+{
+    return list->head;
+}
+
+static inline sys_snode_t *sys_slist_peek_next(sys_snode_t *node)
+{
+    return node ? node->next : NULL;
+}
+
+static inline void sys_slist_append(sys_slist_t *list, sys_snode_t *node)
+{
+    node->next = NULL;
+    if (list->tail) {
+        list->tail->next = node;
+    } else {
+        list->head = node;
+    }
+    list->tail = node;
+}
+
+static inline void sys_slist_remove(sys_slist_t *list, sys_snode_t *prev, sys_snode_t *node)
+{
+    if (prev) {
+        prev->next = node->next;
+    } else {
+        list->head = node->next;
+    }
+    if (list->tail == node) {
+        list->tail = prev;
+    }
+    node->next = NULL;
+}
+
+static inline sys_snode_t *sys_slist_get(sys_slist_t *list)
+{
+    sys_snode_t *node = list->head;
+
+    if (node) {
+        sys_slist_remove(list, NULL, node);
+    }
+    return node;
+}
+
+static inline sys_snode_t *sys_slist_get_not_empty(sys_slist_t *list)
+{
+    return sys_slist_get(list);
+}
+
+static inline void sys_slist_merge_slist(sys_slist_t *list, sys_slist_t *list_to_append)
+{
+    if (!list_to_append->head) {
+        return;
+    }
+    if (list->tail) {
+        list->tail->next = list_to_append->head;
+    } else {
+        list->head = list_to_append->head;
+    }
+    list->tail = list_to_append->tail;
+    sys_slist_init(list_to_append);
+}
+
+static inline void k_delayed_work_init(struct k_delayed_work *work, void *handler)
+{
+    (void)work;
+    (void)handler;
+}
+
+static inline int k_delayed_work_submit(struct k_delayed_work *work, s32_t delay)
+{
+    (void)work;
+    (void)delay;
+    return 0;
+}
+
+static inline int k_delayed_work_cancel(struct k_delayed_work *work)
+{
+    (void)work;
+    return 0;
+}
+
+static inline s32_t k_delayed_work_remaining_get(struct k_delayed_work *work)
+{
+    (void)work;
+    return 0;
+}
+
+static inline u32_t k_uptime_get_32(void)
+{
+    return 0;
+}
+
+static inline u16_t sys_get_le16(const u8_t *src)
+{
+    return (src[1] << 8) | src[0];
+}
+
+static inline u16_t sys_get_be16(const u8_t *src)
+{
+    return (src[0] << 8) | src[1];
+}
+
+static inline void sys_put_be16(u16_t val, u8_t dst[2])
+{
+    dst[0] = val >> 8;
+    dst[1] = val;
+}
+
+static inline void sys_put_be32(u32_t val, u8_t dst[4])
+{
+    sys_put_be16(val >> 16, dst);
+    sys_put_be16(val, &dst[2]);
+}
+
+static inline u16_t sys_cpu_to_be16(u16_t val)
+{
+    return __builtin_bswap16(val);
+}
+
+static inline u16_t sys_be16_to_cpu(u16_t val)
+{
+    return __builtin_bswap16(val);
+}
+
+static inline u32_t sys_cpu_to_be32(u32_t val)
+{
+    return __builtin_bswap32(val);
+}
+
+static inline bool atomic_test_bit(const atomic_t *target, int bit)
+{
+    return (target[bit / 32] >> (bit % 32)) & 1;
+}
+
+static inline bool atomic_test_and_clear_bit(atomic_t *target, int bit)
+{
+    bool old = atomic_test_bit(target, bit);
+
+    target[bit / 32] &= ~(1 << (bit % 32));
+    return old;
+}
+
+static inline unsigned int find_lsb_set(u32_t op)
+{
+    return op ? __builtin_ctz(op) + 1 : 0;
+}
+
+static inline int popcount(u32_t x)
+{
+    return __builtin_popcount(x);
+}
+
+static inline const char *bt_hex(const void *buf, size_t len)
+{
+    (void)buf;
+    (void)len;
+    return "";
+}
+
+#endif
@@ -53,6 +53,7 @@ COMPONENT_PRIV_INCLUDEDIRS   :=
 
 ## This component's src
 ble_stack_srcs  := src/port/bl_port.c \
+					src/port/bl_timer_wheel.c \
 					src/common/atomic_c.c \
 					src/common/buf.c \
 					src/common/log.c \
@@ -90,7 +91,8 @@ ble_stack_srcs  := src/port/bl_port.c \
 
 ifneq ($(CONFIG_DISABLE_BT_SMP), 1)
 ble_stack_srcs  += src/host/smp.c \
-                   src/host/keys.c
+                   src/host/keys.c \
+                   src/host/rpa_cache.c
 endif
 
 ifeq ($(CONFIG_BT_OAD_CLIENT),1)
@@ -98,7 +100,8 @@ ble_stack_srcs   += src/host_cmdproc/oadc_cmdproc.c
 endif
 
 ifneq ($(CONFIG_DBG_RUN_ON_FPGA), 1)
-ble_stack_srcs   += src/host/settings.c
+ble_stack_srcs   += src/host/settings.c \
+                    src/host/settings_ef.c
 endif
 
 ifeq ($(CONFIG_BT_OAD_SERVER),1)
@@ -8,11 +8,6 @@ struct k_work_q {
     struct k_fifo fifo;
 };
 
-typedef struct{
-    bl_timer_t timer;
-    struct k_delayed_work *delay_work;
-}timer_rec_d;
-
 int k_work_q_start();
 
 enum {
@@ -54,9 +49,5 @@ int k_delayed_work_cancel(struct k_delayed_work *work);
 s32_t k_delayed_work_remaining_get(struct k_delayed_work *work);
 void k_delayed_work_del_timer(struct k_delayed_work *work);
 int k_delayed_work_free(struct k_delayed_work *work);
-
-int add_timer_record(struct k_delayed_work *delay_work);
-timer_rec_d *get_timer_record(void *hdl);
-int remv_timer_record(struct k_delayed_work *delay_work);
 #endif
 #endif /* WORK_Q_H */
@@ -22,12 +22,6 @@ static BT_STACK_NOINIT(work_q_stack, CONFIG_BT_WORK_QUEUE_STACK_SIZE);
 #endif
 struct k_work_q g_work_queue_main;
 
-#if defined(BFLB_BLE)
-static timer_rec_d timer_records[CONFIG_MAX_TIMER_REC];
-static void timer_rec_init();
-static int alloc_timer_record(struct k_delayed_work *delay_work);
-#endif
-
 static void k_work_submit_to_queue(struct k_work_q *work_q,
                                    struct k_work *work)
 {
@@ -43,9 +37,11 @@ static void work_queue_main(void *p1)
     UNUSED(p1);
 
     while (1) {
-        work = k_fifo_get(&g_work_queue_main.fifo, K_FOREVER);
+        /* this thread runs the timers too, NULL is a wakeup for them */
+        work = k_fifo_get(&g_work_queue_main.fifo,
+                          k_timer_dispatch((struct k_queue *)&g_work_queue_main.fifo));
 
-        if (atomic_test_and_clear_bit(work->flags, K_WORK_STATE_PENDING)) {
+        if (work && atomic_test_and_clear_bit(work->flags, K_WORK_STATE_PENDING)) {
             work->handler(work);
         }
 
@@ -55,7 +51,6 @@ static void work_queue_main(void *p1)
 
 int k_work_q_start(void)
 {
-    timer_rec_init();
     k_fifo_init(&g_work_queue_main.fifo, 20);
     return k_thread_create(&work_q_thread, "work_q_thread",
                            CONFIG_BT_WORK_QUEUE_STACK_SIZE,
@@ -76,18 +71,18 @@ void k_work_submit(struct k_work *work)
     k_work_submit_to_queue(&g_work_queue_main, work);
 }
 
-static void work_timeout(void *timer)
+static void work_timeout(void *args)
 {
-    timer_rec_d *rec = get_timer_record(timer);
-    BT_ASSERT(rec != NULL);
-    struct k_delayed_work *w = rec->delay_work;
+    struct k_delayed_work *w = args;
 
-    /* submit work to workqueue */
-    k_timer_stop(&w->timer);
-    k_work_submit_to_queue(w->work_q, &w->work);
     /* detach from workqueue, for cancel to return appropriate status */
     w->work_q = NULL;
-    rec->timer.hdl = NULL;
+
+    /* timers are run by the work queue thread, run the work right away
+       rather than through the fifo, unless it was submitted there already */
+    if (!atomic_test_bit(w->work.flags, K_WORK_STATE_PENDING)) {
+        w->work.handler(&w->work);
+    }
 }
 
 void k_delayed_work_init(struct k_delayed_work *work, k_work_handler_t handler)
@@ -129,8 +124,6 @@ static int k_delayed_work_submit_to_queue(struct k_work_q *work_q,
     } else {
         /* Add timeout */
         k_timer_start(&work->timer, delay);
-        err = add_timer_record(work);
-        BT_ASSERT(err == 0);
     }
 
     err = 0;
@@ -168,7 +161,6 @@ int k_delayed_work_cancel(struct k_delayed_work *work)
     }
 
     k_timer_stop(&work->timer);
-    remv_timer_record(work);
     work->work_q = NULL;
     work->timer.timeout = 0;
     work->timer.start_ms = 0;
@@ -180,19 +172,22 @@ exit:
 
 s32_t k_delayed_work_remaining_get(struct k_delayed_work *work)
 {
-    int32_t remain;
-    k_timer_t *timer;
+    int64_t remain;
+    int key;
 
     if (work == NULL) {
         return 0;
     }
 
-    timer = &work->timer;
-    remain = timer->timeout - (k_now_ms() - timer->start_ms);
-    if (remain < 0) {
+    key = irq_lock();
+    if (bl_timer_wheel_pending(&work->timer.node)) {
+        remain = work->timer.node.expiry - k_now_ms();
+    } else {
         remain = 0;
     }
-    return remain;
+    irq_unlock(key);
+
+    return remain > 0 ? remain : 0;
 }
 
 void k_delayed_work_del_timer(struct k_delayed_work *work)
@@ -206,70 +201,11 @@ void k_delayed_work_del_timer(struct k_delayed_work *work)
 
 int k_delayed_work_free(struct k_delayed_work *work)
 {
-    remv_timer_record(work);
     k_delayed_work_del_timer(work);
     return 0;
 }
 
 
-static void timer_rec_init()
-{
-    for(int i = 0; i < ARRAY_SIZE(timer_records); i++)
-    {
-        timer_records[i].timer.hdl = NULL;
-        timer_records[i].delay_work = NULL;
-    }
-}
-
-static int alloc_timer_record(struct k_delayed_work *delay_work)
-{
-     for(int i = 0; i < ARRAY_SIZE(timer_records); i++)
-    {
-        if(timer_records[i].timer.hdl == NULL)
-        {
-            timer_records[i].timer.hdl = delay_work->timer.timer.hdl;
-            timer_records[i].delay_work = delay_work;
-            return 0;
-        }
-    }
-    return -1;
-}
-
-int add_timer_record(struct k_delayed_work *delay_work)
-{
-    for(int i = 0; i < ARRAY_SIZE(timer_records); i++)
-    {
-        if(timer_records[i].timer.hdl == delay_work->timer.timer.hdl)
-            return 0;
-    }
-
-    return alloc_timer_record(delay_work);
-}
-
-int remv_timer_record(struct k_delayed_work *delay_work)
-{
-    for(int i = 0; i < ARRAY_SIZE(timer_records); i++)
-    {
-        if(timer_records[i].timer.hdl == delay_work->timer.timer.hdl)
-        {
-            timer_records[i].timer.hdl = NULL;
-            break;
-        }
-    }
-
-    return 0;
-}
-
-timer_rec_d *get_timer_record(void *hdl)
-{
-    for(int i = 0; i < ARRAY_SIZE(timer_records); i++){
-        if(hdl == timer_records[i].timer.hdl)
-            return &timer_records[i];
-    }
-
-    return NULL;
-}
-
 #else
 static void work_q_main(void *work_q_ptr, void *p2, void *p3)
 {
@@ -4150,7 +4150,11 @@ static int bt_gatt_store_cf(struct bt_conn *conn)
                        &conn->le.dst, NULL);
     }
 
+#if defined(BFLB_BLE)
+    err = bt_settings_set_bin_deferred(key, (const u8_t *)str, len);
+#else
     err = settings_save_one(key, str, len);
+#endif
     if (err) {
         BT_ERR("Failed to store Client Features (err %d)", err);
         return err;
@@ -4181,6 +4185,10 @@ void bt_gatt_disconnected(struct bt_conn *conn)
         bt_gatt_store_cf(conn);
     }
 
+#if defined(BFLB_BLE) && defined(CONFIG_BT_SETTINGS)
+    bt_settings_flush();
+#endif
+
 #if defined(CONFIG_BT_GATT_CLIENT)
     remove_subscriptions(conn);
 #endif /* CONFIG_BT_GATT_CLIENT */
@@ -4261,7 +4269,12 @@ int bt_gatt_store_ccc(u8_t id, const bt_addr_le_t *addr)
         len = 0;
     }
 
+#if defined(BFLB_BLE)
+    /* Written when the peer disconnects or the deferred write times out */
+    err = bt_settings_set_bin_deferred(key, (const u8_t *)str, len);
+#else
     err = settings_save_one(key, (const u8_t *)str, len);
+#endif
     if (err) {
         BT_ERR("Failed to store CCCs (err %d)", err);
         return err;
@@ -512,6 +512,12 @@ static int set_random_address(const bt_addr_t *addr)
     bt_addr_copy(&bt_dev.random_addr.a, addr);
     bt_dev.random_addr.type = BT_ADDR_LE_RANDOM;
 
+#if defined(CONFIG_BLE_MULTI_ADV)
+    /* NRPA of an active scan or a new RPA, the instant's own address has
+     * to be set again */
+    multi_adv_air_invalidate();
+#endif
+
     return 0;
 }
 
@@ -6195,6 +6201,10 @@ int bt_le_adv_update_data(const struct bt_data *ad, size_t ad_len,
                       BT_DEV_ADVERTISING_CONNECTABLE);
     use_name = atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING_NAME);
 
+#if defined(CONFIG_BLE_MULTI_ADV)
+    multi_adv_air_invalidate();
+#endif
+
     return le_adv_update(ad, ad_len, sd, sd_len, connectable, use_name);
 }
 
@@ -6221,6 +6231,10 @@ int bt_le_adv_start_internal(const struct bt_le_adv_param *param,
         return -EALREADY;
     }
 
+#if defined(CONFIG_BLE_MULTI_ADV)
+    multi_adv_air_invalidate();
+#endif
+
     (void)memset(&set_param, 0, sizeof(set_param));
 
     set_param.min_interval = sys_cpu_to_le16(param->interval_min);
@@ -6701,7 +6715,7 @@ int bt_le_adv_start(const struct bt_le_adv_param *param,
     return bt_le_adv_start_internal(param, ad, ad_len, sd, sd_len, NULL);
 }
 
-int bt_le_adv_stop(void)
+static int le_adv_stop(void)
 {
     int err;
 
@@ -6730,7 +6744,21 @@ int bt_le_adv_stop(void)
     return 0;
 }
 
+int bt_le_adv_stop(void)
+{
 #if defined(CONFIG_BLE_MULTI_ADV)
+    multi_adv_air_invalidate();
+#endif
+
+    return le_adv_stop();
+}
+
+#if defined(CONFIG_BLE_MULTI_ADV)
+int bt_le_adv_stop_instant(void)
+{
+    return le_adv_stop();
+}
+
 static int set_ad_data(u16_t hci_op, const uint8_t *ad_data, int ad_len)
 {
     struct bt_hci_cp_le_set_adv_data *set_data;
@@ -6756,25 +6784,42 @@ static int set_ad_data(u16_t hci_op, const uint8_t *ad_data, int ad_len)
 int bt_le_adv_start_instant(const struct bt_le_adv_param *param,
         const uint8_t *ad_data, size_t ad_len,
         const uint8_t *sd_data, size_t sd_len)
+{
+    return bt_le_adv_update_instant(param, ad_data, ad_len, sd_data, sd_len,
+                                    BT_LE_ADV_UPDATE_ALL);
+}
+
+/*
+ * Only the parts flagged in update are written to the controller. Data can
+ * be replaced while advertising, new parameters need advertising to be
+ * stopped first. Advertising is enabled if it is not running afterwards.
+ */
+int bt_le_adv_update_instant(const struct bt_le_adv_param *param,
+        const uint8_t *ad_data, size_t ad_len,
+        const uint8_t *sd_data, size_t sd_len, uint8_t update)
 {
     struct bt_hci_cp_le_set_adv_param set_param;
     struct net_buf *                  buf;
     const bt_addr_le_t *id_addr;
     int                               err;
 
-    bt_le_adv_stop();
+    if (update & BT_LE_ADV_UPDATE_PARAM) {
+        le_adv_stop();
 
-    if (!valid_adv_param(param, false)) {
-        return -EINVAL;
-    }
+        if (!valid_adv_param(param, false)) {
+            return -EINVAL;
+        }
 
-    if (atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING)) {
-        return -EALREADY;
+        if (atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING)) {
+            return -EALREADY;
+        }
     }
 
-    err = set_ad_data(BT_HCI_OP_LE_SET_ADV_DATA, ad_data, ad_len);
-    if (err) {
-        return err;
+    if (update & BT_LE_ADV_UPDATE_AD) {
+        err = set_ad_data(BT_HCI_OP_LE_SET_ADV_DATA, ad_data, ad_len);
+        if (err) {
+            return err;
+        }
     }
 
     /*
@@ -6786,13 +6831,21 @@ int bt_le_adv_start_instant(const struct bt_le_adv_param *param,
      * Clearing sd is done by calling set_ad() with NULL data and zero len.
      * So following condition check is unusual but correct.
      */
-    if (sd_len || (param->options & BT_LE_ADV_OPT_CONNECTABLE)) {
+    if ((update & BT_LE_ADV_UPDATE_SD) &&
+        (sd_len || (param->options & BT_LE_ADV_OPT_CONNECTABLE))) {
         err = set_ad_data(BT_HCI_OP_LE_SET_SCAN_RSP_DATA, sd_data, sd_len);
         if (err) {
             return err;
         }
     }
 
+    if (!(update & BT_LE_ADV_UPDATE_PARAM)) {
+        if (atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING)) {
+            return 0;
+        }
+        goto enable;
+    }
+
     memset(&set_param, 0, sizeof(set_param));
 
     set_param.min_interval = sys_cpu_to_le16(param->interval_min);
@@ -6852,6 +6905,7 @@ int bt_le_adv_start_instant(const struct bt_le_adv_param *param,
         return err;
     }
 
+enable:
     err = set_advertise_enable(true);
     if (err) {
         return err;
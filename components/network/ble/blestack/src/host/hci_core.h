@@ -242,9 +242,22 @@ int bt_le_adv_start_internal(const struct bt_le_adv_param *param,
                  const struct bt_data *sd, size_t sd_len,
                  const bt_addr_le_t *peer);
 #if defined(CONFIG_BLE_MULTI_ADV)
+#define BT_LE_ADV_UPDATE_AD         BIT(0)
+#define BT_LE_ADV_UPDATE_SD         BIT(1)
+#define BT_LE_ADV_UPDATE_PARAM      BIT(2)
+#define BT_LE_ADV_UPDATE_ALL        (BT_LE_ADV_UPDATE_AD | BT_LE_ADV_UPDATE_SD | BT_LE_ADV_UPDATE_PARAM)
+
 int bt_le_adv_start_instant(const struct bt_le_adv_param *param,
         const uint8_t *ad_data, size_t ad_len,
         const uint8_t *sd_data, size_t sd_len);
+int bt_le_adv_update_instant(const struct bt_le_adv_param *param,
+        const uint8_t *ad_data, size_t ad_len,
+        const uint8_t *sd_data, size_t sd_len, uint8_t update);
+/* bt_le_adv_stop() for the multi advertising scheduler, which knows what
+ * the controller still holds afterwards */
+int bt_le_adv_stop_instant(void);
+/* the controller got advertising state the scheduler did not give it */
+void multi_adv_air_invalidate(void);
 #endif
 
 #if defined (BFLB_BLE)
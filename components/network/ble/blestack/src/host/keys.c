@@ -25,6 +25,7 @@
 #include "smp.h"
 #include "settings.h"
 #include "keys.h"
+#include "rpa_cache.h"
 #if defined(BFLB_BLE)
 #if defined(CONFIG_BT_SETTINGS)
 #include "easyflash.h"
@@ -165,8 +166,32 @@ struct bt_keys *bt_keys_get_type(int type, u8_t id, const bt_addr_le_t *addr)
     return keys;
 }
 
+/* RPA resolution cache, see rpa_cache.h */
+#ifndef CONFIG_BT_RPA_CACHE_SIZE
+#define CONFIG_BT_RPA_CACHE_SIZE        8
+#endif
+#ifndef CONFIG_BT_RPA_NEG_CACHE_SIZE
+#define CONFIG_BT_RPA_NEG_CACHE_SIZE    32
+#endif
+
+#define RPA_CACHE_LIFETIME      (CONFIG_BT_RPA_TIMEOUT * 1000U)
+
+RPA_CACHE_DEFINE(rpa_cache, CONFIG_BT_RPA_CACHE_SIZE);
+RPA_CACHE_DEFINE(rpa_neg_cache, CONFIG_BT_RPA_NEG_CACHE_SIZE);
+
+static struct rpa_irk_sched irk_sched[CONFIG_BT_MAX_PAIRED];
+
+/* A bond went or got a new IRK, RPAs that matched nothing may match now */
+static void keys_rpa_forget(int idx)
+{
+    rpa_cache_forget(&rpa_cache, idx);
+    rpa_cache_forget(&rpa_neg_cache, -1);
+}
+
 struct bt_keys *bt_keys_find_irk(u8_t id, const bt_addr_le_t *addr)
 {
+    struct rpa_cache_entry *entry;
+    u32_t now;
     int i;
 
     BT_DBG("%s", bt_addr_le_str(addr));
@@ -175,6 +200,29 @@ struct bt_keys *bt_keys_find_irk(u8_t id, const bt_addr_le_t *addr)
         return NULL;
     }
 
+    now = k_uptime_get_32();
+
+    entry = rpa_cache_lookup(&rpa_cache, id, &addr->a, now,
+                 RPA_CACHE_LIFETIME);
+    /* A bond can lose its IRK and stay, e.g. when it does not fit the
+     * controller resolving list, its RPAs must not resolve then.
+     */
+    if (entry && !(key_pool[entry->idx].keys & BT_KEYS_IRK)) {
+        rpa_cache_forget(&rpa_cache, entry->idx);
+        entry = NULL;
+    }
+    if (entry) {
+        BT_DBG("cached RPA %s for %s", bt_addr_str(&addr->a),
+               bt_addr_le_str(&key_pool[entry->idx].addr));
+        return &key_pool[entry->idx];
+    }
+
+    if (rpa_cache_lookup(&rpa_neg_cache, id, &addr->a, now,
+                 RPA_CACHE_LIFETIME)) {
+        BT_DBG("RPA %s known to be unresolvable", bt_addr_str(&addr->a));
+        return NULL;
+    }
+
     for (i = 0; i < ARRAY_SIZE(key_pool); i++) {
         if (!(key_pool[i].keys & BT_KEYS_IRK)) {
             continue;
@@ -185,6 +233,7 @@ struct bt_keys *bt_keys_find_irk(u8_t id, const bt_addr_le_t *addr)
             BT_DBG("cached RPA %s for %s",
                    bt_addr_str(&key_pool[i].irk.rpa),
                    bt_addr_le_str(&key_pool[i].addr));
+            rpa_cache_insert(&rpa_cache, id, &addr->a, i, now);
             return &key_pool[i];
         }
     }
@@ -198,12 +247,14 @@ struct bt_keys *bt_keys_find_irk(u8_t id, const bt_addr_le_t *addr)
             continue;
         }
 
-        if (bt_rpa_irk_matches(key_pool[i].irk.val, &addr->a)) {
+        if (rpa_irk_sched_matches(&irk_sched[i], key_pool[i].irk.val,
+                      &addr->a)) {
             BT_DBG("RPA %s matches %s",
                    bt_addr_str(&key_pool[i].irk.rpa),
                    bt_addr_le_str(&key_pool[i].addr));
 
             bt_addr_copy(&key_pool[i].irk.rpa, &addr->a);
+            rpa_cache_insert(&rpa_cache, id, &addr->a, i, now);
 
             return &key_pool[i];
         }
@@ -211,6 +262,8 @@ struct bt_keys *bt_keys_find_irk(u8_t id, const bt_addr_le_t *addr)
 
     BT_DBG("No IRK for %s", bt_addr_le_str(addr));
 
+    rpa_cache_insert(&rpa_neg_cache, id, &addr->a, 0, now);
+
     return NULL;
 }
 
@@ -233,10 +286,18 @@ struct bt_keys *bt_keys_find_addr(u8_t id, const bt_addr_le_t *addr)
 void bt_keys_add_type(struct bt_keys *keys, int type)
 {
     keys->keys |= type;
+
+    /* A new IRK may resolve RPAs seen before */
+    if (type & BT_KEYS_IRK) {
+        keys_rpa_forget(keys - key_pool);
+    }
 }
 
 void bt_keys_clear(struct bt_keys *keys)
 {
+    keys_rpa_forget(keys - key_pool);
+    irk_sched[keys - key_pool].valid = false;
+
 #if defined(BFLB_BLE)
     if (keys->keys & BT_KEYS_IRK) {
         bt_id_del(keys);
@@ -458,8 +519,24 @@ static int keys_commit(void)
 #if defined(BFLB_BLE)
 int bt_keys_load(void)
 {
+    keys_rpa_forget(-1);
+
     return bt_settings_get_bin(NV_KEY_POOL, (u8_t *)&key_pool[0], sizeof(key_pool), NULL);
 }
+
+/* Aging counter updates are written on the next disconnect, or by the
+ * deferred write timeout if that comes first
+ */
+static void bt_keys_store_deferred(void)
+{
+    int err;
+
+    err = bt_settings_set_bin_deferred(NV_KEY_POOL, (const u8_t *)&key_pool[0],
+                       sizeof(key_pool));
+    if (err) {
+        BT_ERR("Failed to save keys (err %d)", err);
+    }
+}
 #endif
 
 #endif /* CONFIG_BT_SETTINGS */
@@ -484,7 +561,11 @@ void bt_keys_update_usage(u8_t id, const bt_addr_le_t *addr)
            keys->aging_counter);
 
     if (IS_ENABLED(CONFIG_BT_KEYS_SAVE_AGING_COUNTER_ON_PAIRING)) {
+#if defined(BFLB_BLE) && defined(CONFIG_BT_SETTINGS)
+        bt_keys_store_deferred();
+#else
         bt_keys_store(keys);
+#endif
     }
 }
 
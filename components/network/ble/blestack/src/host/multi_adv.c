@@ -12,7 +12,17 @@
 #include "multi_adv.h"
 #include "work_q.h"
 
-static struct multi_adv_instant g_multi_adv_list[MAX_MULTI_ADV_INSTANT];
+/*
+ * Instants are served earliest deadline first. An instant is due at its
+ * release time and must be on air before release + window, where the window
+ * is the slack between interval_min and interval_max. Each serve enables
+ * advertising for one event, the next release is one interval after the
+ * previous one so late serves inside the window do not drift the average
+ * interval.
+ */
+
+static struct multi_adv_instant *g_multi_adv_list;
+static uint8_t g_multi_adv_list_num;
 static struct multi_adv_scheduler g_multi_adv_scheduler;
 static struct k_delayed_work g_multi_adv_timer;
 
@@ -22,9 +32,9 @@ int multi_adv_schedule_timer_stop(void);
 int multi_adv_get_instant_num(void)
 {
     int i, num = 0;
-    struct multi_adv_instant *inst = &(g_multi_adv_list[0]);
+    struct multi_adv_instant *inst = g_multi_adv_list;
 
-    for (i = 0; i < MAX_MULTI_ADV_INSTANT; i++) {
+    for (i = 0; i < g_multi_adv_list_num; i++) {
         if (inst[i].inuse_flag)
             num++;
     }
@@ -34,9 +44,9 @@ int multi_adv_get_instant_num(void)
 struct multi_adv_instant *multi_adv_alloc_unused_instant(void)
 {
     int i;
-    struct multi_adv_instant *inst = &(g_multi_adv_list[0]);
+    struct multi_adv_instant *inst = g_multi_adv_list;
 
-    for (i = 0; i < MAX_MULTI_ADV_INSTANT; i++) {
+    for (i = 0; i < g_multi_adv_list_num; i++) {
         if (inst[i].inuse_flag == 0) {
             inst[i].inuse_flag = 1;
             inst[i].instant_id = i+1;
@@ -49,9 +59,9 @@ struct multi_adv_instant *multi_adv_alloc_unused_instant(void)
 int multi_adv_delete_instant_by_id(int instant_id)
 {
     int i;
-    struct multi_adv_instant *inst = &(g_multi_adv_list[0]);
+    struct multi_adv_instant *inst = g_multi_adv_list;
 
-    for (i = 0; i < MAX_MULTI_ADV_INSTANT; i++) {
+    for (i = 0; i < g_multi_adv_list_num; i++) {
         if ((inst[i].inuse_flag) && (instant_id == (inst[i].instant_id))) {
             inst[i].inuse_flag = 0;
             return 0;
@@ -63,9 +73,9 @@ int multi_adv_delete_instant_by_id(int instant_id)
 struct multi_adv_instant *multi_adv_find_instant_by_id(int instant_id)
 {
     int i;
-    struct multi_adv_instant *inst = &(g_multi_adv_list[0]);
+    struct multi_adv_instant *inst = g_multi_adv_list;
 
-    for (i = 0; i < MAX_MULTI_ADV_INSTANT; i++) {
+    for (i = 0; i < g_multi_adv_list_num; i++) {
         if ((inst[i].inuse_flag) && (instant_id == (inst[i].instant_id))) {
             return &(inst[i]);
         }
@@ -76,7 +86,7 @@ struct multi_adv_instant *multi_adv_find_instant_by_id(int instant_id)
 struct multi_adv_instant *multi_adv_find_instant_by_order(int order)
 {
 
-    struct multi_adv_instant *inst = &(g_multi_adv_list[0]);
+    struct multi_adv_instant *inst = g_multi_adv_list;
 
     if (inst[order].inuse_flag) {
         return &(inst[order]);
@@ -86,7 +96,8 @@ struct multi_adv_instant *multi_adv_find_instant_by_order(int order)
 
 int multi_adv_set_ad_data(uint8_t * ad_data, const struct bt_data *ad, size_t ad_len)
 {
-    int i, len;
+    size_t i;
+    int len;
 
     memset(ad_data, 0, MAX_AD_DATA_LEN);
     len = 0;
@@ -106,138 +117,82 @@ int multi_adv_set_ad_data(uint8_t * ad_data, const struct bt_data *ad, size_t ad
     return len;
 }
 
-int change_to_tick(int min_interval, int max_interval)
+static bool multi_adv_param_equal(const struct bt_le_adv_param *a, const struct bt_le_adv_param *b)
 {
-    int tick;
-
-    if (max_interval/SLOT_PER_PERIOD != min_interval/SLOT_PER_PERIOD) {
-        tick = min_interval/SLOT_PER_PERIOD;
-        if (min_interval%SLOT_PER_PERIOD)
-            tick++;
-    } else {
-        tick = min_interval/SLOT_PER_PERIOD;
-    }
-    if (tick <= 1)
-        tick = 1;
-
-    return tick;
+    return (a->id == b->id && a->options == b->options &&
+            a->interval_min == b->interval_min && a->interval_max == b->interval_max);
 }
 
-int calculate_min_multi(int a, int b)
+/* interval the controller runs while instants are multiplexed */
+static uint16_t multi_adv_air_interval(struct multi_adv_instant *adv_instant)
 {
-    int x = a, y = b, z;
-
-    while (y != 0) {
-        z = x%y;
-        x = y;
-        y = z;
+    /* BT Core 4.2 [Vol 2, Part E, 7.8.5], see valid_adv_param() */
+    if (!(adv_instant->param.options & BT_LE_ADV_OPT_CONNECTABLE) &&
+        bt_dev.hci_version < BT_HCI_VERSION_5_0) {
+        return MULTI_ADV_AIR_INTERVAL_4_2;
     }
-
-    return a*b/x;
+    return MULTI_ADV_AIR_INTERVAL;
 }
 
-void multi_adv_reorder(int inst_num, uint16_t inst_interval[], uint8_t inst_order[])
+/*
+ * Put an instant on air, only the advertising data, scan response data and
+ * parameters that differ from what the controller already has are written.
+ */
+int multi_adv_start_adv_instant(struct multi_adv_instant *adv_instant, const struct bt_le_adv_param *param)
 {
-    int i, j;
-
-    for (i = 0; i < inst_num; i++) {
-        int max = inst_interval[0];
-        int max_idx = 0;
-        int temp;
+    struct multi_adv_air *air = &g_multi_adv_scheduler.air;
+    uint8_t update = 0;
+    int ret;
 
-        for (j = 1; j < inst_num-i ; j++) {
-            if (max < inst_interval[j]) {
-                max = inst_interval[j];
-                max_idx = j;
-            }
+    if (!air->valid) {
+        update = BT_LE_ADV_UPDATE_ALL;
+    } else {
+        /* the advertising type depends on whether there is scan response data */
+        if (!multi_adv_param_equal(&air->param, param) ||
+            (air->sd_len == 0) != (adv_instant->sd_len == 0)) {
+            update |= BT_LE_ADV_UPDATE_PARAM;
         }
-
-        temp = inst_interval[inst_num-i-1];
-        inst_interval[inst_num-i-1] = inst_interval[max_idx];
-        inst_interval[max_idx] = temp;
-
-        temp = inst_order[inst_num-i-1];
-        inst_order[inst_num-i-1] = inst_order[max_idx];
-        inst_order[max_idx] = temp;
-    }
-}
-
-int calculate_offset(uint16_t interval[], uint16_t offset[], int num, int duration)
-{
-    int i, j, k, curr_offset = 0;
-    int curr_max_instants, min_max_instants, instants;
-    int offset_range;
-
-    offset_range = interval[num];
-    if (offset_range > duration)
-        offset_range = duration;
-
-    if (num == 0)
-        return 0;
-
-    min_max_instants = 0x7fffffff;
-    /* using 0-interval-1 as offset */
-    for (i = 0; i < offset_range; i++) {
-
-        curr_max_instants = 0;
-        /* search slot form 0 - duration to get the max instants number */
-        for (j = 0; j < duration; j++) {
-
-            /* get instant number in each slot */
-            instants = 0;
-            for (k = 0; k < num; k++) {
-                if (j%interval[k] == offset[k]) {
-                    instants++;
-                }
-            }
-            if (j%interval[num] == i)
-                instants++;
-            if (curr_max_instants < instants) {
-                curr_max_instants = instants;
-            }
+        if (air->ad_len != adv_instant->ad_len ||
+            memcmp(air->ad, adv_instant->ad, adv_instant->ad_len)) {
+            update |= BT_LE_ADV_UPDATE_AD;
         }
-
-        /* check if min max instants */
-        if (min_max_instants > curr_max_instants) {
-            min_max_instants = curr_max_instants;
-            curr_offset = i;
+        if (!air->sd_valid || air->sd_len != adv_instant->sd_len ||
+            memcmp(air->sd, adv_instant->sd, adv_instant->sd_len)) {
+            update |= BT_LE_ADV_UPDATE_SD;
         }
     }
-    return curr_offset;
 
-}
+    if (!update && atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING)) {
+        return 0;
+    }
 
-void multi_adv_schedule_table(int inst_num, uint16_t inst_interval[], uint16_t inst_offset[])
-{
-    int i, min_multi, last_min_multi;
-    /* calculate min multi */
-    last_min_multi = min_multi = inst_interval[0];
-    for (i = 1; i < inst_num; i++) {
-        min_multi = calculate_min_multi(min_multi, inst_interval[i]);
-        if (min_multi > MAX_MIN_MULTI) {
-            min_multi = last_min_multi;
-            break;
-        }
-        last_min_multi = min_multi;
+    ret = bt_le_adv_update_instant(param,
+                                adv_instant->ad, adv_instant->ad_len,
+                                adv_instant->sd, adv_instant->sd_len, update);
+    if (ret) {
+        air->valid = 0;
+        printf("adv start instant failed: inst_id %d, err %d", adv_instant->instant_id, ret);
+        return ret;
     }
 
-    /* offset calcute for schedule just for small interval range */
-    for (i = 0; i < inst_num; i++) {
-        inst_offset[i] = calculate_offset(inst_interval, inst_offset, i, min_multi);
+    air->valid = 1;
+    memcpy(&air->param, param, sizeof(air->param));
+    if (update & BT_LE_ADV_UPDATE_AD) {
+        memcpy(air->ad, adv_instant->ad, adv_instant->ad_len);
+        air->ad_len = adv_instant->ad_len;
+    }
+    if (update & BT_LE_ADV_UPDATE_SD) {
+        memcpy(air->sd, adv_instant->sd, adv_instant->sd_len);
+        air->sd_len = adv_instant->sd_len;
+        /* empty scan response data is not written for non-connectable instants */
+        air->sd_valid = (adv_instant->sd_len || (param->options & BT_LE_ADV_OPT_CONNECTABLE));
     }
+    return 0;
 }
 
-int multi_adv_start_adv_instant(struct multi_adv_instant *adv_instant)
+void multi_adv_air_invalidate(void)
 {
-    int ret;
-
-    ret = bt_le_adv_start_instant(&adv_instant->param,
-                                adv_instant->ad, adv_instant->ad_len,
-                                adv_instant->sd, adv_instant->sd_len);
-    if (ret) {
-        printf("adv start instant failed: inst_id %d, err %d", adv_instant->instant_id, ret);
-    }
-    return ret;
+    g_multi_adv_scheduler.air.valid = 0;
 }
 
 void multi_adv_schedule_timer_handle(void)
@@ -248,15 +203,13 @@ void multi_adv_schedule_timer_handle(void)
     if (adv_scheduler->schedule_state == SCHEDULE_STOP)
         return;
 
-    adv_scheduler->slot_clock = adv_scheduler->next_slot_clock;
-    adv_scheduler->slot_offset = adv_scheduler->next_slot_offset;
-
     multi_adv_schedule_timeslot(adv_scheduler);
     return;
 }
 
 void multi_adv_schedule_timer_callback(struct k_work *timer)
 {
+    (void)timer;
     multi_adv_schedule_timer_handle();
     return;
 }
@@ -285,83 +238,47 @@ int multi_adv_schedule_timer_stop(void)
 
 void multi_adv_schedule_timeslot(struct multi_adv_scheduler *adv_scheduler)
 {
-    int i, inst_num;
-    int inst_clk, inst_off, match, insts = 0, next_slot, min_next_slot;
-    struct multi_adv_instant *adv_instant;
-    uint16_t inst_interval[MAX_MULTI_ADV_INSTANT];
-    uint16_t inst_offset[MAX_MULTI_ADV_INSTANT];
-    uint8_t inst_order[MAX_MULTI_ADV_INSTANT];
-    uint8_t match_order[MAX_MULTI_ADV_INSTANT];
+    int i;
+    uint32_t now = k_uptime_get_32();
+    int32_t wait = 0x7fffffff;
+    struct multi_adv_instant *adv_instant, *next = 0;
+    struct bt_le_adv_param param;
 
-    inst_num = 0;
-    for (i = 0; i < MAX_MULTI_ADV_INSTANT; i++) {
+    (void)adv_scheduler;
+
+    /* the dwell of the previous instant is over */
+    bt_le_adv_stop_instant();
+
+    for (i = 0; i < g_multi_adv_list_num; i++) {
         adv_instant = multi_adv_find_instant_by_order(i);
-        if (adv_instant) {
-            inst_interval[inst_num] = adv_instant->instant_interval;
-            inst_offset[inst_num] = adv_instant->instant_offset;
-            inst_order[inst_num] = i;
-            inst_num++;
+        if (adv_instant == 0)
+            continue;
+
+        if ((int32_t)(adv_instant->release - now) > 0) {
+            if ((int32_t)(adv_instant->release - now) < wait)
+                wait = adv_instant->release - now;
+        } else if (next == 0 ||
+                   (int32_t)((adv_instant->release + adv_instant->window) - (next->release + next->window)) < 0) {
+            next = adv_instant;
         }
     }
 
-    inst_clk = adv_scheduler->slot_clock;
-    inst_off = adv_scheduler->slot_offset;
-    match = 0;
-    for (i = 0; i < inst_num; i++) {
-        if ((inst_clk%inst_interval[i]) == inst_offset[i]) {
-            match_order[match] = i;
-            match++;
-        }
+    if (next == 0) {
+        multi_adv_schedule_timer_start(wait);
+        return;
     }
 
-//    BT_DBG("multi_adv_schedule_timeslot, num = %d, match = %d", inst_num, match);
-    if (match) {
-        int offset_per_instant, diff;
-        offset_per_instant = TIME_PRIOD_MS/match;
-        diff = inst_off - (inst_off+offset_per_instant/2)/offset_per_instant*offset_per_instant;
-
-        /* means this is the time to start */
-        if (diff <= 2) {
-            insts = (inst_off+offset_per_instant/2)/offset_per_instant;
+    /* a missed deadline restarts the instant from now instead of
+     * catching up with a burst */
+    if ((int32_t)(now - (next->release + next->window)) > 0)
+        next->release = now;
+    next->release += next->interval;
 
-            /* start instant */
-            adv_instant = multi_adv_find_instant_by_order(inst_order[match_order[insts]]);
-            multi_adv_start_adv_instant(adv_instant);
-        }
+    param = next->param;
+    param.interval_min = param.interval_max = multi_adv_air_interval(next);
+    multi_adv_start_adv_instant(next, &param);
 
-        /* next instant in the same slot */
-        if (match-insts > 1) {
-            adv_scheduler->next_slot_offset = adv_scheduler->slot_offset+offset_per_instant;
-            adv_scheduler->next_slot_clock = adv_scheduler->slot_clock;
-
-            if ((adv_scheduler->next_slot_offset >= (TIME_PRIOD_MS-2))&&(adv_scheduler->slot_offset <= (TIME_PRIOD_MS+2))) {
-                adv_scheduler->next_slot_clock++;
-                adv_scheduler->next_slot_offset = 0;
-            }
-            multi_adv_schedule_timer_start(offset_per_instant);
-            return;
-        }
-    }
-
-    /* next instant not in the same slot */
-    min_next_slot = 0x7fffffff;
-    for (i = 0; i < inst_num; i++) {
-        if (inst_clk-inst_offset[i] < 0) {
-            match = 0;
-        } else {
-            match = (inst_clk-inst_offset[i])/inst_interval[i]+1;
-        }
-        next_slot = match*inst_interval[i]+inst_offset[i];
-        if (next_slot < min_next_slot) {
-            min_next_slot = next_slot;
-        }
-    }
-    adv_scheduler->next_slot_offset = 0;
-    adv_scheduler->next_slot_clock = min_next_slot;
-
-    next_slot = (adv_scheduler->next_slot_clock - adv_scheduler->slot_clock)*TIME_PRIOD_MS+(adv_scheduler->next_slot_offset-adv_scheduler->slot_offset);
-    multi_adv_schedule_timer_start(next_slot);
-    return;
+    multi_adv_schedule_timer_start(CONFIG_BT_MULTI_ADV_DWELL_MS);
 }
 
 void multi_adv_schedule_stop(void)
@@ -376,14 +293,10 @@ void multi_adv_schedule_start(void)
 {
     struct multi_adv_scheduler *adv_scheduler = &g_multi_adv_scheduler;
 
-    /* get all instant and calculate ticks and */
     if (adv_scheduler->schedule_state == SCHEDULE_START) {
         multi_adv_schedule_stop();
     }
 
-    /* reinit scheduler */
-    adv_scheduler->slot_clock = 0;
-    adv_scheduler->slot_offset = 0;
     adv_scheduler->schedule_state = SCHEDULE_START;
     multi_adv_schedule_timeslot(adv_scheduler);
 }
@@ -391,11 +304,8 @@ void multi_adv_schedule_start(void)
 void multi_adv_new_schedule(void)
 {
     int i;
-    struct multi_adv_instant *adv_instant, *high_duty_instant;
+    struct multi_adv_instant *adv_instant, *high_duty_instant, *single_instant;
     struct multi_adv_scheduler *adv_scheduler = &g_multi_adv_scheduler;
-    uint16_t inst_offset[MAX_MULTI_ADV_INSTANT];
-    uint16_t inst_interval[MAX_MULTI_ADV_INSTANT];
-    uint8_t inst_order[MAX_MULTI_ADV_INSTANT];
     int inst_num = 0;
 
     if (adv_scheduler->schedule_state == SCHEDULE_START) {
@@ -403,7 +313,8 @@ void multi_adv_new_schedule(void)
     }
     /* get all instant and calculate ticks and */
     high_duty_instant = 0;
-    for (i = 0; i < MAX_MULTI_ADV_INSTANT; i++) {
+    single_instant = 0;
+    for (i = 0; i < g_multi_adv_list_num; i++) {
         adv_instant = multi_adv_find_instant_by_order(i);
         if (adv_instant) {
             /* if high duty cycle adv found */
@@ -412,51 +323,61 @@ void multi_adv_new_schedule(void)
                 break;
             }
 
-            inst_interval[inst_num] = change_to_tick(adv_instant->param.interval_min, adv_instant->param.interval_max);
-            inst_order[inst_num] = i;
+            adv_instant->interval = adv_instant->param.interval_min*5/8;
+            adv_instant->window = (adv_instant->param.interval_max - adv_instant->param.interval_min)*5/8;
+            single_instant = adv_instant;
             inst_num++;
         }
     }
 
     if (high_duty_instant) {
         //printf("High Duty Cycle Instants, id = %d, interval = %d\n", adv_instant->instant_id, adv_instant->param.interval_min);
-        multi_adv_start_adv_instant(adv_instant);
+        multi_adv_start_adv_instant(high_duty_instant, &high_duty_instant->param);
         return;
     }
 
-    /* instant number equal 0 and 1 */
+    /* instant number equal 0 and 1, the controller keeps the interval */
     if (inst_num == 0) {
-        bt_le_adv_stop();
+        bt_le_adv_stop_instant();
         return;
     }
     if (inst_num == 1) {
-        adv_instant = multi_adv_find_instant_by_order(inst_order[0]);
-        multi_adv_start_adv_instant(adv_instant);
+        multi_adv_start_adv_instant(single_instant, &single_instant->param);
         return;
     }
 
-    /* reorder by inst_interval */
-    multi_adv_reorder(inst_num, inst_interval, inst_order);
+    multi_adv_schedule_start();
+}
 
-    /* calcuate schedule table */
-    multi_adv_schedule_table(inst_num, inst_interval, inst_offset);
+int bt_le_multi_adv_pool_init(uint8_t instant_num)
+{
+    struct multi_adv_instant *list;
 
-    /* set interval and offset to instant */
-    for (i = 0; i < inst_num; i++) {
-        adv_instant = multi_adv_find_instant_by_order(inst_order[i]);
-        adv_instant->instant_interval = inst_interval[i];
-        adv_instant->instant_offset = inst_offset[i];
+    if (instant_num == 0)
+        return -EINVAL;
+    if (multi_adv_get_instant_num())
+        return -EBUSY;
+    if (instant_num == g_multi_adv_list_num)
+        return 0;
 
-        //printf("adv_instant id = %d, interval = %d, offset = %d\n", adv_instant->instant_id, adv_instant->instant_interval, adv_instant->instant_offset);
-    }
+    list = k_malloc(instant_num*sizeof(struct multi_adv_instant));
+    if (list == 0)
+        return -ENOMEM;
+    memset(list, 0, instant_num*sizeof(struct multi_adv_instant));
 
-    multi_adv_schedule_start();
+    if (g_multi_adv_list)
+        k_free(g_multi_adv_list);
+    g_multi_adv_list = list;
+    g_multi_adv_list_num = instant_num;
+    return 0;
 }
 
 int bt_le_multi_adv_thread_init(void)
 {
     /* timer and event init */
     k_delayed_work_init(&g_multi_adv_timer, multi_adv_schedule_timer_callback);
+    if (g_multi_adv_list == 0)
+        return bt_le_multi_adv_pool_init(CONFIG_BT_MULTI_ADV_INSTANTS);
     return 0;
 }
 
@@ -464,13 +385,8 @@ int bt_le_multi_adv_start(const struct bt_le_adv_param *param,
                     const struct bt_data *ad, size_t ad_len,
                     const struct bt_data *sd, size_t sd_len, int *instant_id)
 {
-    int instant_num;
     struct multi_adv_instant *adv_instant;
 
-    instant_num = multi_adv_get_instant_num();
-    if (instant_num >= MAX_MULTI_ADV_INSTANT)
-        return -1;
-
     adv_instant = multi_adv_alloc_unused_instant();
     if (adv_instant == 0)
         return -1;
@@ -479,6 +395,7 @@ int bt_le_multi_adv_start(const struct bt_le_adv_param *param,
 
     adv_instant->ad_len = multi_adv_set_ad_data(adv_instant->ad, ad, ad_len);
     adv_instant->sd_len = multi_adv_set_ad_data(adv_instant->sd, sd, sd_len);
+    adv_instant->release = k_uptime_get_32();
 
     multi_adv_new_schedule();
 
@@ -497,4 +414,3 @@ int bt_le_multi_adv_stop(int instant_id)
     return 0;
 }
 
-
@@ -5,13 +5,20 @@
 #ifndef _MULTI_ADV_H_
 #define _MULTI_ADV_H_
 
-#define MAX_MULTI_ADV_INSTANT       4
+/* default pool size, bt_le_multi_adv_pool_init() resizes it at runtime */
+#ifndef CONFIG_BT_MULTI_ADV_INSTANTS
+#define CONFIG_BT_MULTI_ADV_INSTANTS    8
+#endif
 #define MAX_AD_DATA_LEN             31
 
-#define TIME_PRIOD_MS               100
-#define SLOT_PER_PERIOD             (TIME_PRIOD_MS*8/5)
-
-#define MAX_MIN_MULTI               300
+/* while several instants share the controller each one is enabled for
+ * CONFIG_BT_MULTI_ADV_DWELL_MS, long enough for the advertising event sent
+ * on enable and shorter than the air interval so there is no second one */
+#ifndef CONFIG_BT_MULTI_ADV_DWELL_MS
+#define CONFIG_BT_MULTI_ADV_DWELL_MS    10
+#endif
+#define MULTI_ADV_AIR_INTERVAL      0x0020
+#define MULTI_ADV_AIR_INTERVAL_4_2  0x00a0
 
 #define HIGH_DUTY_CYCLE_INTERVAL    (40*8/5)
 
@@ -26,18 +33,11 @@ struct multi_adv_instant {
     uint8_t sd[MAX_AD_DATA_LEN];
     uint8_t sd_len;
 
-    /* own address maybe used */
-    bt_addr_t own_addr;
-    uint8_t own_addr_valid;
-
-    /* for schedule */
+    /* for schedule, all in ms */
     int instant_id;
-    int instant_interval;
-    int instant_offset;
-    uint32_t clock;
-    uint32_t clock_instant_offset;
-    uint32_t clock_instant_total;
-    uint32_t next_wakeup_time;
+    uint32_t interval;          /* interval_min */
+    uint32_t window;            /* interval_max - interval_min, the jitter allowed */
+    uint32_t release;           /* next event is due from here to release + window */
 };
 
 typedef enum {
@@ -47,16 +47,25 @@ typedef enum {
     SCHEDULE_STOP,
 }SCHEDULE_STATE;
 
+/* what the controller was last given, to only send what changes */
+struct multi_adv_air {
+    uint8_t valid;
+    struct bt_le_adv_param param;
+    uint8_t ad[MAX_AD_DATA_LEN];
+    uint8_t ad_len;
+    uint8_t sd[MAX_AD_DATA_LEN];
+    uint8_t sd_len;
+    uint8_t sd_valid;           /* 0 when the controller may hold other data */
+};
+
 struct multi_adv_scheduler {
     SCHEDULE_STATE schedule_state;
     uint8_t schedule_timer_active;
-    uint32_t slot_clock;
-    uint16_t slot_offset;
-    uint16_t next_slot_offset;
-    uint32_t next_slot_clock;
+    struct multi_adv_air air;
 };
 
 int bt_le_multi_adv_thread_init(void);
+int bt_le_multi_adv_pool_init(uint8_t instant_num);
 int bt_le_multi_adv_start(const struct bt_le_adv_param *param,
                     const struct bt_data *ad, size_t ad_len,
                     const struct bt_data *sd, size_t sd_len, int *instant_id);
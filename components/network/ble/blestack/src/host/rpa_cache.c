@@ -0,0 +1,99 @@
+/* rpa_cache.c - RPA resolution cache */
+
+#include <string.h>
+#include <zephyr.h>
+#include <misc/byteorder.h>
+#include <tinycrypt/constants.h>
+
+#include "rpa_cache.h"
+
+struct rpa_cache_entry *rpa_cache_lookup(struct rpa_cache *cache, u8_t id,
+                     const bt_addr_t *rpa, u32_t now,
+                     u32_t lifetime)
+{
+    struct rpa_cache_entry *e = cache->entries;
+    struct rpa_cache_entry entry;
+    int i;
+
+    for (i = 0; i < cache->count; i++) {
+        if (e[i].id != id || bt_addr_cmp(&e[i].rpa, rpa)) {
+            continue;
+        }
+
+        if (now - e[i].stamp >= lifetime) {
+            cache->count--;
+            memmove(&e[i], &e[i + 1], (cache->count - i) * sizeof(e[0]));
+            return NULL;
+        }
+
+        entry = e[i];
+        memmove(&e[1], &e[0], i * sizeof(e[0]));
+        e[0] = entry;
+
+        return &e[0];
+    }
+
+    return NULL;
+}
+
+void rpa_cache_insert(struct rpa_cache *cache, u8_t id, const bt_addr_t *rpa,
+              u8_t idx, u32_t now)
+{
+    struct rpa_cache_entry *e = cache->entries;
+
+    if (cache->count < cache->size) {
+        cache->count++;
+    }
+
+    memmove(&e[1], &e[0], (cache->count - 1) * sizeof(e[0]));
+    bt_addr_copy(&e[0].rpa, rpa);
+    e[0].id = id;
+    e[0].idx = idx;
+    e[0].stamp = now;
+}
+
+void rpa_cache_forget(struct rpa_cache *cache, int idx)
+{
+    int i, j;
+
+    if (idx < 0) {
+        cache->count = 0U;
+        return;
+    }
+
+    for (i = 0, j = 0; i < cache->count; i++) {
+        if (cache->entries[i].idx != idx) {
+            cache->entries[j++] = cache->entries[i];
+        }
+    }
+
+    cache->count = j;
+}
+
+bool rpa_irk_sched_matches(struct rpa_irk_sched *sched, const u8_t irk[16],
+               const bt_addr_t *addr)
+{
+    u8_t block[16], out[16];
+
+    if (!sched->valid || memcmp(sched->irk, irk, 16)) {
+        sys_memcpy_swap(block, irk, 16);
+        if (tc_aes128_set_encrypt_key(&sched->sched, block) ==
+            TC_CRYPTO_FAIL) {
+            return false;
+        }
+
+        memcpy(sched->irk, irk, 16);
+        sched->valid = true;
+    }
+
+    /* r' = padding || prand, big endian */
+    (void)memset(block, 0, 13);
+    sys_memcpy_swap(&block[13], addr->val + 3, 3);
+
+    if (tc_aes_encrypt(out, block, &sched->sched) == TC_CRYPTO_FAIL) {
+        return false;
+    }
+
+    return out[15] == addr->val[0] && out[14] == addr->val[1] &&
+           out[13] == addr->val[2];
+}
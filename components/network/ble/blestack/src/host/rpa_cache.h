@@ -0,0 +1,59 @@
+/* rpa_cache.h - RPA resolution cache */
+
+#ifndef __RPA_CACHE_H__
+#define __RPA_CACHE_H__
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+#include <tinycrypt/aes.h>
+#include "addr.h"
+
+/* Every advertising report from an RPA used to cost one AES per bonded
+ * IRK. Resolved RPAs and RPAs that matched no IRK are remembered for one
+ * RPA timeout (the peer rotates its address by then), and resolving a new
+ * RPA runs the IRKs with AES key schedules expanded once per bond. Nothing
+ * here knows about the key pool, so that the host tests can drive it.
+ */
+struct rpa_cache_entry {
+    bt_addr_t rpa;
+    u8_t id;
+    u8_t idx;           /* key_pool index, unused for negative entries */
+    u32_t stamp;        /* k_uptime_get_32() when resolved */
+};
+
+/* Kept most recently used first */
+struct rpa_cache {
+    struct rpa_cache_entry *entries;
+    u8_t size;
+    u8_t count;
+};
+
+#define RPA_CACHE_DEFINE(_name, _size) \
+    static struct rpa_cache_entry _name##_entries[_size]; \
+    static struct rpa_cache _name = { _name##_entries, _size, 0 }
+
+struct rpa_irk_sched {
+    u8_t irk[16];       /* IRK the schedule was expanded from */
+    bool valid;
+    struct tc_aes_key_sched_struct sched;
+};
+
+/* The entry of rpa moved to the front, NULL if there is none or it is
+ * lifetime ms old, in which case it is dropped.
+ */
+struct rpa_cache_entry *rpa_cache_lookup(struct rpa_cache *cache, u8_t id,
+                     const bt_addr_t *rpa, u32_t now,
+                     u32_t lifetime);
+/* Adds rpa at the front, the least recently used entry goes if full */
+void rpa_cache_insert(struct rpa_cache *cache, u8_t id, const bt_addr_t *rpa,
+              u8_t idx, u32_t now);
+/* Drops the entries of key_pool index idx, all of them if idx < 0 */
+void rpa_cache_forget(struct rpa_cache *cache, int idx);
+
+/* bt_rpa_irk_matches() with a key schedule kept in sched, expanded again
+ * when irk is not the one it was made from.
+ */
+bool rpa_irk_sched_matches(struct rpa_irk_sched *sched, const u8_t irk[16],
+               const bt_addr_t *addr);
+
+#endif /* __RPA_CACHE_H__ */
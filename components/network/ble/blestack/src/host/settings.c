@@ -232,97 +232,6 @@ static void save_id(struct k_work *work)
 
 K_WORK_DEFINE(save_id_work, save_id);
 #endif //!BFLB_BLE
-#if defined (BFLB_BLE)
-#if defined(CONFIG_BT_SETTINGS)
-bool ef_ready_flag = false;
-int bt_check_if_ef_ready()
-{
-    int err = 0;
-
-    if(!ef_ready_flag){
-        err = easyflash_init();
-        if(!err)
-            ef_ready_flag = true;
-    }
-
-    return err;
-}
-
-int bt_settings_set_bin(const char *key, const uint8_t *value, size_t length)
-{
-    const char *lookup = "0123456789abcdef";
-    char *str_value;
-    int err;
-
-    err =  bt_check_if_ef_ready();
-    if(err)
-        return err;
-
-    str_value = pvPortMalloc(length*2 + 1);
-
-    BT_ASSERT(str_value != NULL);
-
-    for(size_t i = 0; i < length; i++){
-        str_value[(i * 2) + 0] = lookup[(value[i] >> 4) & 0x0F];
-        str_value[(i * 2) + 1] = lookup[value[i] & 0x0F];
-    }
-    str_value[length * 2] = '\0';
-
-    err = ef_set_env(key, (const char *)str_value);
-
-    vPortFree(str_value);
-
-    return err;
-}
-
-int bt_settings_get_bin(const char *key, u8_t *value, size_t exp_len, size_t *real_len)
-{
-    char *str_value;
-    size_t str_value_len;
-    char rand[3];
-    int err;
-
-    err = bt_check_if_ef_ready();
-    if(err)
-        return err;
-
-
-    str_value  = ef_get_env(key);
-    if(str_value == NULL)
-    {
-        return -1;
-    }
-
-    str_value_len = strlen(str_value);
-
-    if((str_value_len % 2) != 0 || (exp_len >0 && str_value_len > exp_len*2))
-    {
-        return -1;
-    }
-
-    if(real_len)
-        *real_len = str_value_len/2;
-
-    for(size_t i = 0; i < str_value_len/2; i++){
-        strncpy(rand, str_value+2*i, 2);
-        rand[2] = '\0';
-        value[i] = strtol(rand, NULL, 16);
-    }
-
-    return 0;
-}
-
-int settings_delete(const char *key)
-{
-    return ef_del_env(key);
-}
-
-int settings_save_one(const char *key, const u8_t *value, size_t length)
-{
-    return bt_settings_set_bin(key, value, length);
-}
-#endif //CONFIG_BT_SETTINGS
-#endif
 
 void bt_settings_save_id(void)
 {
@@ -30,8 +30,14 @@ int bt_settings_init(void);
 #define NV_KEY_POOL        "KEY_POOL"
 #define NV_IMG_info        "IMG_INFO"
 
+int bt_check_if_ef_ready(void);
 int bt_settings_get_bin(const char *key, u8_t *value, size_t exp_len, size_t *real_len);
 int bt_settings_set_bin(const char *key, const u8_t *value, size_t length);
+/* Like bt_settings_set_bin() but kept in RAM until bt_settings_flush(),
+ * or BT_SETTINGS_DEFER_TIMEOUT at the most
+ */
+int bt_settings_set_bin_deferred(const char *key, const u8_t *value, size_t length);
+void bt_settings_flush(void);
 int settings_delete(const char *key);
 int settings_save_one(const char *key, const u8_t *value, size_t length);
 void bt_settings_save_name(void);
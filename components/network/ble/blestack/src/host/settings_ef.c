@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2018 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <zephyr.h>
+
+#define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_DEBUG_SETTINGS)
+#define LOG_MODULE_NAME bt_settings
+#include "log.h"
+
+#include "settings.h"
+#if defined(CONFIG_BT_SETTINGS)
+#include "easyflash.h"
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include "portable.h"
+#include <misc/byteorder.h>
+
+/* Values are EasyFlash blobs behind a small versioned header. Releases
+ * before it stored hex strings, a hex value is rewritten as a record the
+ * first time it is read, which for ids, bonds and mesh state is at boot.
+ */
+#define BT_SETTINGS_REC_MAGIC       0xB7
+#define BT_SETTINGS_REC_VERSION     1
+#define BT_SETTINGS_REC_HDR_LEN     4
+
+/* Records up to this size are built on the stack */
+#ifndef BT_SETTINGS_REC_STACK_MAX
+#define BT_SETTINGS_REC_STACK_MAX   64
+#endif
+
+/* Values stored with bt_settings_set_bin_deferred() stay in RAM until
+ * bt_settings_flush() or the flush timer, larger ones or ones without a
+ * free slot are written through.
+ */
+#ifndef BT_SETTINGS_DEFER_SLOTS
+#define BT_SETTINGS_DEFER_SLOTS     3
+#endif
+#ifndef BT_SETTINGS_DEFER_MAX
+#define BT_SETTINGS_DEFER_MAX       256
+#endif
+
+/* A deferred value reaches flash at the latest this long after the
+ * first one was deferred, so a power cut before the next disconnect
+ * loses no more than that.
+ */
+#ifndef BT_SETTINGS_DEFER_TIMEOUT
+#define BT_SETTINGS_DEFER_TIMEOUT   K_SECONDS(10)
+#endif
+
+static struct bt_settings_deferred {
+    char key[BT_SETTINGS_KEY_MAX];  /* empty if the slot is free */
+    u16_t len;                      /* record length */
+    u8_t rec[BT_SETTINGS_REC_HDR_LEN + BT_SETTINGS_DEFER_MAX];
+} deferred[BT_SETTINGS_DEFER_SLOTS];
+
+static SemaphoreHandle_t settings_lock;
+static struct k_delayed_work flush_work;
+
+static void flush_timeout(struct k_work *work)
+{
+    (void)work;
+    bt_settings_flush();
+}
+
+bool ef_ready_flag = false;
+int bt_check_if_ef_ready()
+{
+    int err = 0;
+
+    if(!ef_ready_flag){
+        err = easyflash_init();
+        if(!err) {
+            settings_lock = xSemaphoreCreateMutex();
+            BT_ASSERT(settings_lock != NULL);
+            k_delayed_work_init(&flush_work, flush_timeout);
+            ef_ready_flag = true;
+        }
+    }
+
+    return err;
+}
+
+static void settings_rec_build(u8_t *rec, const u8_t *value, size_t length)
+{
+    rec[0] = BT_SETTINGS_REC_MAGIC;
+    rec[1] = BT_SETTINGS_REC_VERSION;
+    sys_put_le16(length, &rec[2]);
+    if (length) {
+        memcpy(&rec[BT_SETTINGS_REC_HDR_LEN], value, length);
+    }
+}
+
+static bool settings_rec_equal(const char *key, const u8_t *rec, size_t rec_len)
+{
+    struct env_node_obj env;
+    u32_t buf[8];
+    size_t off, n;
+
+    if (!ef_get_env_obj(key, &env) || env.value_len != rec_len) {
+        return false;
+    }
+
+    for (off = 0; off < rec_len; off += n) {
+        n = MIN(rec_len - off, sizeof(buf));
+        if (ef_port_read(env.addr.value + off, buf, n) != EF_NO_ERR ||
+            memcmp(buf, &rec[off], n)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Rewriting an unchanged record would only wear the flash */
+static int settings_rec_write(const char *key, const u8_t *rec, size_t rec_len)
+{
+    if (settings_rec_equal(key, rec, rec_len)) {
+        return 0;
+    }
+
+    return ef_set_env_blob(key, rec, rec_len);
+}
+
+static struct bt_settings_deferred *deferred_find(const char *key)
+{
+    for (int i = 0; i < BT_SETTINGS_DEFER_SLOTS; i++) {
+        if (deferred[i].key[0] && !strcmp(deferred[i].key, key)) {
+            return &deferred[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int settings_store(const char *key, const u8_t *value, size_t length)
+{
+    u8_t stack_rec[BT_SETTINGS_REC_STACK_MAX];
+    size_t rec_len = BT_SETTINGS_REC_HDR_LEN + length;
+    struct bt_settings_deferred *d;
+    u8_t *rec = stack_rec;
+    int err;
+
+    if (length > 0xFFFF) {
+        return -EINVAL;
+    }
+
+    /* A direct write supersedes a pending one */
+    d = deferred_find(key);
+    if (d) {
+        d->key[0] = '\0';
+    }
+
+    if (rec_len > sizeof(stack_rec)) {
+        rec = pvPortMalloc(rec_len);
+        if (!rec) {
+            return -ENOMEM;
+        }
+    }
+
+    settings_rec_build(rec, value, length);
+    err = settings_rec_write(key, rec, rec_len);
+
+    if (rec != stack_rec) {
+        vPortFree(rec);
+    }
+
+    return err;
+}
+
+/* Decode a hex string value of an older release into value */
+static int settings_hex_load(env_node_obj_t env, u8_t *value, size_t exp_len,
+                 size_t *len)
+{
+    u32_t buf[8];
+    size_t off, n;
+
+    if ((env->value_len % 2) != 0 ||
+        (exp_len > 0 && env->value_len > exp_len * 2)) {
+        return -1;
+    }
+
+    for (off = 0; off < env->value_len; off += n) {
+        n = MIN(env->value_len - off, sizeof(buf));
+        if (ef_port_read(env->addr.value + off, buf, n) != EF_NO_ERR ||
+            hex2bin((const char *)buf, n, &value[off / 2], n / 2) != n / 2) {
+            return -1;
+        }
+    }
+
+    *len = env->value_len / 2;
+
+    return 0;
+}
+
+static int settings_load(const char *key, u8_t *value, size_t exp_len,
+             size_t *real_len)
+{
+    struct bt_settings_deferred *d;
+    struct env_node_obj env;
+    /* ef_port_read() takes a u32_t buffer */
+    u32_t hdr_buf[(BT_SETTINGS_REC_HDR_LEN + 3) / 4];
+    const u8_t *hdr = (const u8_t *)hdr_buf;
+    u32_t buf[8];
+    size_t len, off, n;
+
+    d = deferred_find(key);
+    if (d) {
+        len = d->len - BT_SETTINGS_REC_HDR_LEN;
+        if (exp_len > 0 && len > exp_len) {
+            return -1;
+        }
+
+        memcpy(value, &d->rec[BT_SETTINGS_REC_HDR_LEN], len);
+        goto done;
+    }
+
+    if (!ef_get_env_obj(key, &env)) {
+        return -1;
+    }
+
+    if (env.value_len < BT_SETTINGS_REC_HDR_LEN ||
+        ef_port_read(env.addr.value, hdr_buf, BT_SETTINGS_REC_HDR_LEN) != EF_NO_ERR ||
+        hdr[0] != BT_SETTINGS_REC_MAGIC) {
+        if (settings_hex_load(&env, value, exp_len, &len)) {
+            return -1;
+        }
+
+        BT_INFO("Converting %s to a binary record", key);
+        (void)settings_store(key, value, len);
+        goto done;
+    }
+
+    len = sys_get_le16(&hdr[2]);
+    if (hdr[1] != BT_SETTINGS_REC_VERSION ||
+        len != env.value_len - BT_SETTINGS_REC_HDR_LEN) {
+        BT_ERR("Bad settings record %s (version %u)", key, hdr[1]);
+        return -1;
+    }
+
+    if (exp_len > 0 && len > exp_len) {
+        return -1;
+    }
+
+    for (off = 0; off < len; off += n) {
+        n = MIN(len - off, sizeof(buf));
+        if (ef_port_read(env.addr.value + BT_SETTINGS_REC_HDR_LEN + off,
+                 buf, n) != EF_NO_ERR) {
+            return -1;
+        }
+        memcpy(&value[off], buf, n);
+    }
+
+done:
+    if (real_len) {
+        *real_len = len;
+    }
+
+    return 0;
+}
+
+int bt_settings_set_bin(const char *key, const uint8_t *value, size_t length)
+{
+    int err;
+
+    err =  bt_check_if_ef_ready();
+    if(err)
+        return err;
+
+    xSemaphoreTake(settings_lock, portMAX_DELAY);
+    err = settings_store(key, value, length);
+    xSemaphoreGive(settings_lock);
+
+    return err;
+}
+
+int bt_settings_set_bin_deferred(const char *key, const u8_t *value, size_t length)
+{
+    struct bt_settings_deferred *d;
+    int err;
+
+    err = bt_check_if_ef_ready();
+    if(err)
+        return err;
+
+    xSemaphoreTake(settings_lock, portMAX_DELAY);
+
+    d = deferred_find(key);
+    for (int i = 0; !d && i < BT_SETTINGS_DEFER_SLOTS; i++) {
+        if (!deferred[i].key[0]) {
+            d = &deferred[i];
+        }
+    }
+
+    if (!d || length > BT_SETTINGS_DEFER_MAX ||
+        strlen(key) >= sizeof(d->key)) {
+        err = settings_store(key, value, length);
+    } else {
+        strcpy(d->key, key);
+        d->len = BT_SETTINGS_REC_HDR_LEN + length;
+        settings_rec_build(d->rec, value, length);
+
+        /* Later values ride on the timer of the first one */
+        if (!k_delayed_work_remaining_get(&flush_work)) {
+            k_delayed_work_submit(&flush_work, BT_SETTINGS_DEFER_TIMEOUT);
+        }
+    }
+
+    xSemaphoreGive(settings_lock);
+
+    return err;
+}
+
+void bt_settings_flush(void)
+{
+    if (!ef_ready_flag) {
+        return;
+    }
+
+    xSemaphoreTake(settings_lock, portMAX_DELAY);
+
+    k_delayed_work_cancel(&flush_work);
+
+    for (int i = 0; i < BT_SETTINGS_DEFER_SLOTS; i++) {
+        struct bt_settings_deferred *d = &deferred[i];
+
+        if (d->key[0]) {
+            if (settings_rec_write(d->key, d->rec, d->len)) {
+                BT_ERR("Failed to flush %s", d->key);
+            }
+            d->key[0] = '\0';
+        }
+    }
+
+    xSemaphoreGive(settings_lock);
+}
+
+int bt_settings_get_bin(const char *key, u8_t *value, size_t exp_len, size_t *real_len)
+{
+    int err;
+
+    err = bt_check_if_ef_ready();
+    if(err)
+        return err;
+
+    xSemaphoreTake(settings_lock, portMAX_DELAY);
+    err = settings_load(key, value, exp_len, real_len);
+    xSemaphoreGive(settings_lock);
+
+    return err;
+}
+
+int settings_delete(const char *key)
+{
+    struct bt_settings_deferred *d;
+    int err;
+
+    err = bt_check_if_ef_ready();
+    if(err)
+        return err;
+
+    xSemaphoreTake(settings_lock, portMAX_DELAY);
+    d = deferred_find(key);
+    if (d) {
+        d->key[0] = '\0';
+    }
+    err = ef_del_env(key);
+    xSemaphoreGive(settings_lock);
+
+    return err;
+}
+
+int settings_save_one(const char *key, const u8_t *value, size_t length)
+{
+    return bt_settings_set_bin(key, value, length);
+}
+#endif //CONFIG_BT_SETTINGS
@@ -14,7 +14,6 @@
 #include <FreeRTOS.h>
 #include <task.h>
 #include <semphr.h>
-#include <timers.h>
 #if defined(BL702)
 #include "bl702.h"
 #endif
@@ -266,58 +265,169 @@ int k_is_in_isr(void)
     return 0;
 }
 
+/*
+ * k_timer runs on a timer wheel rather than on one FreeRTOS timer each, so
+ * that starting and stopping a timer is a list operation under irq_lock
+ * instead of commands to the timer daemon, and the handlers run from the
+ * thread calling k_timer_dispatch(), the work queue one.
+ */
+static struct bl_timer_wheel timer_wheel;
+static bool timer_wheel_ready;
+static TaskHandle_t timer_task;
+static struct k_queue *timer_queue;
+/* when the timer thread is back, BL_TIMER_WHEEL_NEVER if it waits for work only */
+static uint64_t timer_wake_ms = BL_TIMER_WHEEL_NEVER;
+
+/* with irq locked */
+static void timer_wheel_setup(void)
+{
+    if (!timer_wheel_ready) {
+        bl_timer_wheel_init(&timer_wheel, k_now_ms());
+        timer_wheel_ready = true;
+    }
+}
+
+static void timer_wake(void)
+{
+    void *msg = NULL;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (NULL == timer_queue->hdl) {
+        return;
+    }
+
+    /* a full queue wakes the thread anyway */
+    if (k_is_in_isr()) {
+        xQueueSendFromISR(timer_queue->hdl, &msg, &xHigherPriorityTaskWoken);
+        if (xHigherPriorityTaskWoken == pdTRUE) {
+            portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+        }
+    } else {
+        xQueueSend(timer_queue->hdl, &msg, 0);
+    }
+}
+
 void k_timer_init(k_timer_t *timer, k_timer_handler_t handle, void *args)
 {
+    unsigned int key;
+
     BT_ASSERT(timer != NULL);
+
+    key = irq_lock();
+    timer_wheel_setup();
+    /* initialized again while running */
+    if (timer->timer.hdl == timer) {
+        bl_timer_wheel_del(&timer_wheel, &timer->node);
+    }
+    timer->node.where = 0;
     timer->handler = handle;
     timer->args = args;
-
-    timer->timer.hdl = xTimerCreate("Timer", pdMS_TO_TICKS(1000), 0, 0, (TimerCallbackFunction_t)(timer->handler));
-    BT_ASSERT(timer->timer.hdl != NULL);
+    timer->timer.hdl = timer;
+    irq_unlock(key);
 }
 
 void k_timer_start(k_timer_t *timer, uint32_t timeout)
 {
-    BaseType_t ret;
-    (void) ret;
+    unsigned int key;
+    uint64_t now;
+    uint64_t expiry;
+    bool wake = false;
 
     BT_ASSERT(timer != NULL);
+
+    now = k_now_ms();
+    expiry = now + timeout;
+
+    key = irq_lock();
     timer->timeout = timeout;
-    timer->start_ms = k_now_ms();
+    timer->start_ms = now;
+    bl_timer_wheel_add(&timer_wheel, &timer->node, expiry);
+
+    /* the timer thread recomputes its wait itself, except from an interrupt
+       taken between that and its wait */
+    if (timer_queue && expiry < timer_wake_ms &&
+            (k_is_in_isr() || xTaskGetCurrentTaskHandle() != timer_task)) {
+        timer_wake_ms = expiry;
+        wake = true;
+    }
+    irq_unlock(key);
 
-    ret = xTimerStop(timer->timer.hdl, 0);
-    BT_ASSERT(ret == pdPASS);
-    ret = xTimerChangePeriod(timer->timer.hdl, pdMS_TO_TICKS(timeout), 0);
-    BT_ASSERT(ret == pdPASS);
-    ret = xTimerStart(timer->timer.hdl, 0);
-    BT_ASSERT(ret == pdPASS);
+    if (wake) {
+        timer_wake();
+    }
 }
 
 void k_timer_stop(k_timer_t *timer)
 {
-    BaseType_t ret;
+    unsigned int key;
 
-    (void) ret;
     BT_ASSERT(timer != NULL);
 
-    ret = xTimerStop(timer->timer.hdl, 0);
-    BT_ASSERT(ret == pdPASS);
+    key = irq_lock();
+    bl_timer_wheel_del(&timer_wheel, &timer->node);
+    irq_unlock(key);
 }
 
 void k_timer_delete(k_timer_t *timer)
 {
-    BaseType_t ret;
-    (void) ret;
+    unsigned int key;
 
     BT_ASSERT(timer != NULL);
 
-    ret = xTimerDelete(timer->timer.hdl, 0);
-    BT_ASSERT(ret == pdPASS);
+    key = irq_lock();
+    bl_timer_wheel_del(&timer_wheel, &timer->node);
+    timer->timer.hdl = NULL;
+    irq_unlock(key);
 }
 
+s32_t k_timer_dispatch(struct k_queue *queue)
+{
+    struct bl_timer_node *node;
+    k_timer_t *timer;
+    unsigned int key;
+    uint64_t now;
+    uint64_t next;
+
+    now = k_now_ms();
+
+    key = irq_lock();
+    timer_wheel_setup();
+    timer_task = xTaskGetCurrentTaskHandle();
+    timer_queue = queue;
+
+    /* one at a time, the handlers run unlocked and may start or stop timers */
+    while ((node = bl_timer_wheel_expire(&timer_wheel, now)) != NULL) {
+        timer = CONTAINER_OF(node, k_timer_t, node);
+        irq_unlock(key);
+        timer->handler(timer->args);
+        key = irq_lock();
+    }
+
+    next = bl_timer_wheel_next(&timer_wheel);
+    timer_wake_ms = next;
+    irq_unlock(key);
+
+    if (next == BL_TIMER_WHEEL_NEVER) {
+        return K_FOREVER;
+    }
+
+    now = k_now_ms();
+    return next > now ? (s32_t)(next - now) : 0;
+}
+
+/* the tick count with the kernel's count of its overflows on top, so that it
+   does not wrap after 49 days, and the product does not wrap after 71 minutes */
 long long k_now_ms(void)
 {
-    return (long long)(xTaskGetTickCount() * 1000)/configTICK_RATE_HZ;
+    TimeOut_t now;
+
+    if (k_is_in_isr()) {
+        vTaskInternalSetTimeOutState(&now);
+    } else {
+        vTaskSetTimeOutState(&now);
+    }
+
+    return (long long)((((uint64_t)(uint32_t)now.xOverflowCount << 32) | now.xTimeOnEntering) * 1000 / configTICK_RATE_HZ);
 }
 
 void k_get_random_byte_array(uint8_t *buf, size_t len)
@@ -0,0 +1,182 @@
+#include "bl_timer_wheel.h"
+
+#define SLOT_MASK       (BL_TIMER_WHEEL_SLOTS - 1)
+#define SHIFT(level)    ((level) * BL_TIMER_WHEEL_BITS)
+#define SPAN            ((uint64_t)1 << SHIFT(BL_TIMER_WHEEL_LEVELS))
+#define NODE_EXPIRED    0xff
+
+/* the list node is the first member */
+#define TIMER_OF(n)     ((struct bl_timer_node *)(n))
+
+static void link_timer(struct bl_timer_wheel *wheel, struct bl_timer_node *timer)
+{
+    uint64_t expiry = timer->expiry;
+    uint64_t delta;
+    int level;
+
+    if (expiry < wheel->base) {
+        expiry = wheel->base;
+    }
+
+    /* park what is beyond the top level in its furthest slot */
+    delta = expiry - wheel->base;
+    if (delta >= SPAN) {
+        delta = SPAN - 1;
+        expiry = wheel->base + delta;
+    }
+
+    for (level = 0; level < BL_TIMER_WHEEL_LEVELS - 1; level++) {
+        if (delta < ((uint64_t)1 << SHIFT(level + 1))) {
+            break;
+        }
+    }
+
+    timer->where = level + 1;
+    timer->slot = (expiry >> SHIFT(level)) & SLOT_MASK;
+    sys_dlist_append(&wheel->slots[level][timer->slot], &timer->node);
+    wheel->pending[level] |= 1u << timer->slot;
+}
+
+/* move the timers of a slot one level down, or to expired from level 0 */
+static void move_slot(struct bl_timer_wheel *wheel, int level, int slot)
+{
+    sys_dlist_t *list = &wheel->slots[level][slot];
+    sys_dnode_t *node;
+
+    wheel->pending[level] &= ~(1u << slot);
+
+    while ((node = sys_dlist_get(list)) != NULL) {
+        if (0 == level) {
+            TIMER_OF(node)->where = NODE_EXPIRED;
+            sys_dlist_append(&wheel->expired, node);
+        } else {
+            link_timer(wheel, TIMER_OF(node));
+        }
+    }
+}
+
+static void run_tick(struct bl_timer_wheel *wheel)
+{
+    uint64_t tick = wheel->base;
+    int level;
+    int slot;
+
+    /* a level is moved down each time the one below wraps */
+    for (level = 1; level < BL_TIMER_WHEEL_LEVELS; level++) {
+        if (tick & (((uint64_t)1 << SHIFT(level)) - 1)) {
+            break;
+        }
+        slot = (tick >> SHIFT(level)) & SLOT_MASK;
+        if (wheel->pending[level] & (1u << slot)) {
+            move_slot(wheel, level, slot);
+        }
+    }
+
+    slot = tick & SLOT_MASK;
+    if (wheel->pending[0] & (1u << slot)) {
+        move_slot(wheel, 0, slot);
+    }
+
+    wheel->base = tick + 1;
+}
+
+/* the number of slots from first to the first pending one, which is there */
+static int first_pending(uint32_t pending, int first)
+{
+    uint32_t rotated = (pending >> first) | (pending << ((BL_TIMER_WHEEL_SLOTS - first) & SLOT_MASK));
+
+    return __builtin_ctz(rotated);
+}
+
+void bl_timer_wheel_init(struct bl_timer_wheel *wheel, uint64_t now)
+{
+    int level;
+    int slot;
+
+    wheel->base = now;
+    for (level = 0; level < BL_TIMER_WHEEL_LEVELS; level++) {
+        wheel->pending[level] = 0;
+        for (slot = 0; slot < BL_TIMER_WHEEL_SLOTS; slot++) {
+            sys_dlist_init(&wheel->slots[level][slot]);
+        }
+    }
+    sys_dlist_init(&wheel->expired);
+}
+
+void bl_timer_wheel_add(struct bl_timer_wheel *wheel, struct bl_timer_node *timer, uint64_t expiry)
+{
+    bl_timer_wheel_del(wheel, timer);
+    timer->expiry = expiry;
+    link_timer(wheel, timer);
+}
+
+void bl_timer_wheel_del(struct bl_timer_wheel *wheel, struct bl_timer_node *timer)
+{
+    int level;
+
+    if (!timer->where) {
+        return;
+    }
+
+    sys_dlist_remove(&timer->node);
+    if (timer->where != NODE_EXPIRED) {
+        level = timer->where - 1;
+        if (sys_dlist_is_empty(&wheel->slots[level][timer->slot])) {
+            wheel->pending[level] &= ~(1u << timer->slot);
+        }
+    }
+    timer->where = 0;
+}
+
+struct bl_timer_node *bl_timer_wheel_expire(struct bl_timer_wheel *wheel, uint64_t now)
+{
+    struct bl_timer_node *timer;
+    uint64_t next;
+
+    while (sys_dlist_is_empty(&wheel->expired) && wheel->base <= now) {
+        /* skip the milliseconds with nothing to do */
+        next = bl_timer_wheel_next(wheel);
+        if (next > now) {
+            wheel->base = now + 1;
+            break;
+        }
+        wheel->base = next;
+        run_tick(wheel);
+    }
+
+    timer = TIMER_OF(sys_dlist_get(&wheel->expired));
+    if (timer) {
+        timer->where = 0;
+    }
+    return timer;
+}
+
+uint64_t bl_timer_wheel_next(const struct bl_timer_wheel *wheel)
+{
+    uint64_t next = BL_TIMER_WHEEL_NEVER;
+    uint64_t block;
+    uint64_t when;
+    int level;
+
+    if (!sys_dlist_is_empty((sys_dlist_t *)&wheel->expired)) {
+        return 0;
+    }
+
+    if (wheel->pending[0]) {
+        next = wheel->base + first_pending(wheel->pending[0], wheel->base & SLOT_MASK);
+    }
+
+    /* an upper slot is due when the wheel reaches the start of its block */
+    for (level = 1; level < BL_TIMER_WHEEL_LEVELS; level++) {
+        if (!wheel->pending[level]) {
+            continue;
+        }
+        block = (wheel->base + ((uint64_t)1 << SHIFT(level)) - 1) >> SHIFT(level);
+        when = (block + first_pending(wheel->pending[level], block & SLOT_MASK)) << SHIFT(level);
+        if (when < next) {
+            next = when;
+        }
+    }
+
+    return next;
+}
@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "types.h"
+#include "bl_timer_wheel.h"
 
 #define BT_UINT_MAX        0xffffffff
 #define BL_WAIT_FOREVER    0xffffffffu
@@ -156,18 +157,22 @@ struct k_mutex {
     sys_dlist_t poll_events;
 };
 
-typedef void (*k_timer_handler_t)(void *timer);
+typedef void (*k_timer_handler_t)(void *args);
 
 typedef struct k_timer {
+    /* hdl is the timer itself once initialized, NULL once deleted */
     bl_timer_t timer;
     k_timer_handler_t handler;
     void *args;
     uint32_t timeout;
     uint32_t start_ms;
+    struct bl_timer_node node;
 } k_timer_t;
 
 /**
  * @brief Initialize a timer.
+ *
+ * The handler is called with args, from the thread calling k_timer_dispatch().
  */
 void k_timer_init(k_timer_t *timer, k_timer_handler_t handle, void *args);
 
@@ -188,6 +193,17 @@ void k_timer_stop(k_timer_t *timer);
  */
 void k_timer_delete(k_timer_t *timer);
 
+/**
+ * @brief Run the timers that are due.
+ *
+ * Called in a loop by the one thread running the timers, which then waits on
+ * queue. An empty message is put on it when a timer is started from another
+ * context to expire before the thread would be back.
+ *
+ * @return milliseconds until the next call, K_FOREVER when no timer runs
+ */
+s32_t k_timer_dispatch(struct k_queue *queue);
+
 /*time define*/
 #define MSEC_PER_SEC 1000
 #define K_MSEC(ms)     (ms)
@@ -0,0 +1,69 @@
+#ifndef BL_TIMER_WHEEL_H
+#define BL_TIMER_WHEEL_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <misc/dlist.h>
+
+/*
+ * Hierarchical timing wheel with a 1 ms resolution, behind k_timer.
+ *
+ * Level 0 has one slot per millisecond, each level above one slot per
+ * rotation of the level below. A timer goes to the lowest level its delay
+ * fits in and is moved down when the wheel reaches its slot, so adding and
+ * removing a timer are O(1). Timers beyond the top level are parked in it
+ * and moved again when their slot comes around.
+ *
+ * Times are absolute milliseconds of a 64-bit clock the caller provides,
+ * nothing here depends on the OS, and nothing is locked: the port serializes
+ * the calls.
+ */
+/* 32 slots a level, the pending bitmaps are 32 bits, and 4 levels span 17 minutes */
+#define BL_TIMER_WHEEL_BITS    5
+#define BL_TIMER_WHEEL_SLOTS   (1 << BL_TIMER_WHEEL_BITS)
+#define BL_TIMER_WHEEL_LEVELS  4
+
+#define BL_TIMER_WHEEL_NEVER   UINT64_MAX
+
+struct bl_timer_node {
+    sys_dnode_t node;
+    uint64_t expiry;
+    /* 0 when idle, level + 1 while on the wheel, 0xff once due */
+    uint8_t where;
+    uint8_t slot;
+};
+
+struct bl_timer_wheel {
+    /* first millisecond not processed yet, the timers due before it are on expired */
+    uint64_t base;
+    /* non-empty slots, one bit each */
+    uint32_t pending[BL_TIMER_WHEEL_LEVELS];
+    sys_dlist_t slots[BL_TIMER_WHEEL_LEVELS][BL_TIMER_WHEEL_SLOTS];
+    sys_dlist_t expired;
+};
+
+void bl_timer_wheel_init(struct bl_timer_wheel *wheel, uint64_t now);
+
+/* (re)arm a timer, an expiry in the past makes it due at the next expire */
+void bl_timer_wheel_add(struct bl_timer_wheel *wheel, struct bl_timer_node *timer, uint64_t expiry);
+void bl_timer_wheel_del(struct bl_timer_wheel *wheel, struct bl_timer_node *timer);
+
+static inline bool bl_timer_wheel_pending(const struct bl_timer_node *timer)
+{
+    return timer->where != 0;
+}
+
+/*
+ * Advance the wheel to now and take one due timer off it, NULL once there is
+ * none left. Called in a loop so that the caller can run each timer's handler
+ * without holding its lock.
+ */
+struct bl_timer_node *bl_timer_wheel_expire(struct bl_timer_wheel *wheel, uint64_t now);
+
+/*
+ * The time expire has to be called at next, BL_TIMER_WHEEL_NEVER when the
+ * wheel is empty. It is at or before the earliest expiry, a timer parked on
+ * an upper level makes it the time that level's slot is moved down.
+ */
+uint64_t bl_timer_wheel_next(const struct bl_timer_wheel *wheel);
+
+#endif /* BL_TIMER_WHEEL_H */
@@ -140,10 +140,6 @@ extern "C" {
 #define CONFIG_BT_RX_BUF_LEN 255 //108 //76
 #endif
 
-#ifndef CONFIG_MAX_TIMER_REC
-#define CONFIG_MAX_TIMER_REC 5
-#endif
-
 /**
 * CONFIG_BT_CENTRAL: Enable central Role
 */
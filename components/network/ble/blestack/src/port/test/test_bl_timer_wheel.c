@@ -0,0 +1,230 @@
+/*
+ * Host test of the timer wheel behind k_timer, driven by a virtual clock.
+ * Timers are started, restarted and stopped at random, the clock is moved
+ * either a millisecond at a time or straight to the time the wheel asks to
+ * be called at, as the work queue thread does, and every timer has to fire
+ * once, exactly when the clock gets to its expiry. From this
+ * directory:
+ *
+ *   gcc -I../include -I../../common/include ../bl_timer_wheel.c test_bl_timer_wheel.c -o test_bl_timer_wheel
+ *   ./test_bl_timer_wheel
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bl_timer_wheel.h"
+
+#define TIMERS  64
+#define ROUNDS  200000
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+struct test_timer {
+    struct bl_timer_node node;
+    uint64_t expiry;        /* the model, BL_TIMER_WHEEL_NEVER when stopped */
+    uint64_t due;           /* no earlier than the first millisecond not run yet */
+};
+
+static struct bl_timer_wheel wheel;
+static struct test_timer timers[TIMERS];
+static unsigned fired;
+
+static uint32_t rnd(void)
+{
+    static uint32_t x = 2463534242u;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+/* short timers mostly, as the stack has, some beyond the wheel span */
+static uint64_t random_delay(void)
+{
+    switch (rnd() % 8) {
+    case 0:
+        return 0;
+    case 1:
+        return rnd() % 4;
+    case 2:
+    case 3:
+        return rnd() % 100;
+    case 4:
+    case 5:
+        return rnd() % 5000;
+    case 6:
+        return rnd() % 200000;
+    default:
+        return rnd() % 3000000;
+    }
+}
+
+static uint64_t earliest(void)
+{
+    uint64_t min = BL_TIMER_WHEEL_NEVER;
+    int i;
+
+    for (i = 0; i < TIMERS; i++) {
+        if (timers[i].due < min) {
+            min = timers[i].due;
+        }
+    }
+    return min;
+}
+
+/* what the handlers do, from inside the expire loop */
+static void poke(uint64_t now)
+{
+    struct test_timer *t = &timers[rnd() % TIMERS];
+
+    if (rnd() % 4) {
+        t->expiry = now + random_delay();
+        t->due = t->expiry < wheel.base ? wheel.base : t->expiry;
+        bl_timer_wheel_add(&wheel, &t->node, t->expiry);
+    } else {
+        t->expiry = BL_TIMER_WHEEL_NEVER;
+        t->due = BL_TIMER_WHEEL_NEVER;
+        bl_timer_wheel_del(&wheel, &t->node);
+    }
+    CHECK(bl_timer_wheel_pending(&t->node) == (t->expiry != BL_TIMER_WHEEL_NEVER),
+          "timer %d pending %d", (int)(t - timers), bl_timer_wheel_pending(&t->node));
+}
+
+static void expire(uint64_t now)
+{
+    struct bl_timer_node *node;
+    struct test_timer *t;
+    int i;
+
+    while ((node = bl_timer_wheel_expire(&wheel, now)) != NULL) {
+        t = (struct test_timer *)node;
+        i = (int)(t - timers);
+        CHECK(t->expiry != BL_TIMER_WHEEL_NEVER, "timer %d fired while stopped at %llu",
+              i, (unsigned long long)now);
+        CHECK(t->expiry <= now, "timer %d fired early at %llu, due %llu",
+              i, (unsigned long long)now, (unsigned long long)t->expiry);
+        CHECK(t->due == now, "timer %d late at %llu, due %llu",
+              i, (unsigned long long)now, (unsigned long long)t->due);
+        CHECK(!bl_timer_wheel_pending(node), "timer %d still pending", i);
+        t->expiry = BL_TIMER_WHEEL_NEVER;
+        t->due = BL_TIMER_WHEEL_NEVER;
+        fired++;
+        if (rnd() % 2) {
+            poke(now);
+        }
+    }
+
+    /* nothing left behind that was due, restarted handlers included */
+    CHECK(earliest() > now, "timer due %llu missed at %llu",
+          (unsigned long long)earliest(), (unsigned long long)now);
+}
+
+static void run(uint64_t start, int step_by_ms)
+{
+    uint64_t now = start;
+    uint64_t next;
+    int round;
+    int i;
+
+    bl_timer_wheel_init(&wheel, now);
+    for (i = 0; i < TIMERS; i++) {
+        timers[i].node.where = 0;
+        timers[i].expiry = BL_TIMER_WHEEL_NEVER;
+        timers[i].due = BL_TIMER_WHEEL_NEVER;
+    }
+
+    for (round = 0; round < ROUNDS; round++) {
+        if (rnd() % 3 == 0) {
+            poke(now);
+        }
+
+        next = bl_timer_wheel_next(&wheel);
+        CHECK(next <= earliest(), "next %llu after the earliest expiry %llu",
+              (unsigned long long)next, (unsigned long long)earliest());
+
+        if (step_by_ms) {
+            now++;
+            expire(now);
+        } else if (next != BL_TIMER_WHEEL_NEVER) {
+            /* the driver sleeps until next, sometimes wakes before */
+            if (next > now) {
+                now = rnd() % 4 ? next : now + (next - now) / 2;
+            }
+            expire(now);
+        } else {
+            now += rnd() % 10000;
+            expire(now);
+        }
+    }
+
+    for (i = 0; i < TIMERS; i++) {
+        bl_timer_wheel_del(&wheel, &timers[i].node);
+    }
+    CHECK(bl_timer_wheel_next(&wheel) == BL_TIMER_WHEEL_NEVER, "wheel not empty");
+}
+
+static void test_basic(void)
+{
+    struct test_timer *a = &timers[0], *b = &timers[1];
+
+    bl_timer_wheel_init(&wheel, 1000);
+    a->node.where = 0;
+    b->node.where = 0;
+    CHECK(bl_timer_wheel_next(&wheel) == BL_TIMER_WHEEL_NEVER, "empty wheel has a next");
+    CHECK(bl_timer_wheel_expire(&wheel, 5000) == NULL, "empty wheel expired a timer");
+
+    /* a past expiry is due at once */
+    bl_timer_wheel_add(&wheel, &a->node, 10);
+    CHECK(bl_timer_wheel_next(&wheel) == 5001, "next %llu", (unsigned long long)bl_timer_wheel_next(&wheel));
+    CHECK(bl_timer_wheel_expire(&wheel, 5001) == &a->node, "past timer not expired");
+
+    /* restart moves it, stop before expiry drops it */
+    bl_timer_wheel_add(&wheel, &a->node, 6000);
+    bl_timer_wheel_add(&wheel, &a->node, 5100);
+    bl_timer_wheel_add(&wheel, &b->node, 5050);
+    bl_timer_wheel_del(&wheel, &b->node);
+    bl_timer_wheel_del(&wheel, &b->node);
+    CHECK(bl_timer_wheel_expire(&wheel, 5099) == NULL, "expired early");
+    CHECK(bl_timer_wheel_expire(&wheel, 5100) == &a->node, "restarted timer not expired");
+    CHECK(bl_timer_wheel_expire(&wheel, 7000) == NULL, "stopped timer expired");
+
+    /* stopping a due timer that was not taken yet */
+    bl_timer_wheel_add(&wheel, &a->node, 7010);
+    bl_timer_wheel_add(&wheel, &b->node, 7010);
+    CHECK(bl_timer_wheel_expire(&wheel, 7010) != NULL, "due timer not expired");
+    bl_timer_wheel_del(&wheel, &a->node);
+    bl_timer_wheel_del(&wheel, &b->node);
+    CHECK(bl_timer_wheel_expire(&wheel, 7010) == NULL, "stopped due timer expired");
+
+    /* hours ahead, past the span of the wheel */
+    bl_timer_wheel_add(&wheel, &a->node, 7010 + 5ull * 3600 * 1000);
+    CHECK(bl_timer_wheel_expire(&wheel, 7009 + 5ull * 3600 * 1000) == NULL, "long timer expired early");
+    CHECK(bl_timer_wheel_expire(&wheel, 7010 + 5ull * 3600 * 1000) == &a->node, "long timer not expired");
+}
+
+int main(void)
+{
+    test_basic();
+
+    /* from boot, across 2^32 ms where a 32-bit clock wraps, and far out */
+    run(0, 1);
+    run(0, 0);
+    run(0xffffffffull - 100000, 1);
+    run(0xffffffffull - 100000, 0);
+    run(0x123456789abull, 0);
+
+    printf("%u timers fired\r\n", fired);
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,11 @@
+/* Host test stand-in, the heap only */
+#ifndef TEST_FREERTOS_H
+#define TEST_FREERTOS_H
+#include <stddef.h>
+
+#define portMAX_DELAY           0xffffffffUL
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+
+#endif
@@ -0,0 +1,25 @@
+/* Host test stand-in, the address types and their helpers */
+#ifndef TEST_ADDR_H
+#define TEST_ADDR_H
+#include <zephyr.h>
+
+typedef struct {
+    u8_t val[6];
+} bt_addr_t;
+
+typedef struct {
+    u8_t type;
+    bt_addr_t a;
+} bt_addr_le_t;
+
+static inline int bt_addr_cmp(const bt_addr_t *a, const bt_addr_t *b)
+{
+    return memcmp(a, b, sizeof(*a));
+}
+
+static inline void bt_addr_copy(bt_addr_t *dst, const bt_addr_t *src)
+{
+    memcpy(dst, src, sizeof(*dst));
+}
+
+#endif
@@ -0,0 +1,25 @@
+/* Host test stand-in, single threaded bit operations */
+#ifndef TEST_ATOMIC_H
+#define TEST_ATOMIC_H
+#include <zephyr.h>
+
+typedef long atomic_t;
+
+#define ATOMIC_BITS             (sizeof(atomic_t) * 8)
+
+static inline bool atomic_test_bit(const atomic_t *target, int bit)
+{
+    return (target[bit / ATOMIC_BITS] >> (bit % ATOMIC_BITS)) & 1;
+}
+
+static inline void atomic_set_bit(atomic_t *target, int bit)
+{
+    target[bit / ATOMIC_BITS] |= 1L << (bit % ATOMIC_BITS);
+}
+
+static inline void atomic_clear_bit(atomic_t *target, int bit)
+{
+    target[bit / ATOMIC_BITS] &= ~(1L << (bit % ATOMIC_BITS));
+}
+
+#endif
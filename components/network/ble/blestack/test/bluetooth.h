@@ -0,0 +1,26 @@
+/* Host test stand-in, the advertising API types */
+#ifndef TEST_BLUETOOTH_H
+#define TEST_BLUETOOTH_H
+#include <zephyr.h>
+#include <addr.h>
+
+struct bt_data {
+    u8_t type;
+    u8_t data_len;
+    const u8_t *data;
+};
+
+enum {
+    BT_LE_ADV_OPT_NONE = 0,
+    BT_LE_ADV_OPT_CONNECTABLE = BIT(0),
+    BT_LE_ADV_OPT_ONE_TIME = BIT(1),
+};
+
+struct bt_le_adv_param {
+    u8_t  id;
+    u8_t  options;
+    u16_t interval_min;
+    u16_t interval_max;
+};
+
+#endif
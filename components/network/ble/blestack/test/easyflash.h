@@ -0,0 +1,30 @@
+/* Host test stand-in, the env area is an append-only log in memory */
+#ifndef TEST_EASYFLASH_H
+#define TEST_EASYFLASH_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    EF_NO_ERR,
+    EF_READ_ERR,
+    EF_ENV_FULL,
+} EfErrCode;
+
+struct env_node_obj {
+    uint32_t value_len;
+    struct {
+        uint32_t value;
+    } addr;
+};
+typedef struct env_node_obj *env_node_obj_t;
+
+EfErrCode easyflash_init(void);
+bool ef_get_env_obj(const char *key, env_node_obj_t env);
+EfErrCode ef_set_env_blob(const char *key, const void *value_buf, size_t buf_len);
+char *ef_get_env(const char *key);
+EfErrCode ef_set_env(const char *key, const char *value);
+EfErrCode ef_del_env(const char *key);
+EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size);
+
+#endif
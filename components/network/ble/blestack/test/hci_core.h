@@ -0,0 +1,35 @@
+/* Host test stand-in, the part of bt_dev and the instant API multi_adv.c
+ * uses, the test models the controller behind it
+ */
+#ifndef TEST_HCI_CORE_H
+#define TEST_HCI_CORE_H
+#include <atomic.h>
+#include <bluetooth.h>
+
+#define BT_HCI_VERSION_5_0          9
+
+enum {
+    BT_DEV_ADVERTISING,
+
+    BT_DEV_NUM_FLAGS,
+};
+
+struct bt_dev {
+    u8_t hci_version;
+    atomic_t flags[1];
+};
+
+extern struct bt_dev bt_dev;
+
+#define BT_LE_ADV_UPDATE_AD         BIT(0)
+#define BT_LE_ADV_UPDATE_SD         BIT(1)
+#define BT_LE_ADV_UPDATE_PARAM      BIT(2)
+#define BT_LE_ADV_UPDATE_ALL        (BT_LE_ADV_UPDATE_AD | BT_LE_ADV_UPDATE_SD | BT_LE_ADV_UPDATE_PARAM)
+
+int bt_le_adv_update_instant(const struct bt_le_adv_param *param,
+        const uint8_t *ad_data, size_t ad_len,
+        const uint8_t *sd_data, size_t sd_len, uint8_t update);
+int bt_le_adv_stop_instant(void);
+void multi_adv_air_invalidate(void);
+
+#endif
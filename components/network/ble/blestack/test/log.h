@@ -0,0 +1,12 @@
+/* Host test stand-in, logging is compiled out */
+#ifndef TEST_LOG_H
+#define TEST_LOG_H
+#include <assert.h>
+
+#define BT_DBG(...)
+#define BT_INFO(...)
+#define BT_WARN(...)
+#define BT_ERR(...)
+#define BT_ASSERT(cond)         assert(cond)
+
+#endif
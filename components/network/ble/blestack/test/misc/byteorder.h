@@ -0,0 +1,27 @@
+/* Host test stand-in, the byte order helpers the sources use */
+#ifndef TEST_BYTEORDER_H
+#define TEST_BYTEORDER_H
+#include <zephyr.h>
+
+static inline void sys_put_le16(u16_t val, u8_t dst[2])
+{
+    dst[0] = val;
+    dst[1] = val >> 8;
+}
+
+static inline u16_t sys_get_le16(const u8_t src[2])
+{
+    return ((u16_t)src[1] << 8) | src[0];
+}
+
+static inline void sys_memcpy_swap(void *dst, const void *src, size_t length)
+{
+    const u8_t *s = (const u8_t *)src + length;
+    u8_t *d = dst;
+
+    while (length--) {
+        *d++ = *--s;
+    }
+}
+
+#endif
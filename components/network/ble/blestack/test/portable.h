@@ -0,0 +1,2 @@
+/* Host test stand-in, see FreeRTOS.h */
+#include <FreeRTOS.h>
@@ -0,0 +1,25 @@
+/* Host test stand-in, single threaded so the mutex only counts */
+#ifndef TEST_SEMPHR_H
+#define TEST_SEMPHR_H
+
+typedef int *SemaphoreHandle_t;
+
+extern int test_mutex;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return &test_mutex;
+}
+
+static inline int xSemaphoreTake(SemaphoreHandle_t sem, unsigned long ticks)
+{
+    (void)ticks;
+    return ++*sem == 1;
+}
+
+static inline int xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return --*sem == 0;
+}
+
+#endif
@@ -0,0 +1,414 @@
+/*
+ * Host simulation of the multi advertising scheduler against a model of
+ * the controller and of the parts of hci_core.c that drive it. Instants
+ * of different intervals are multiplexed for ten minutes, each has to see
+ * its average interval between interval_min and interval_max, and every
+ * advertising event has to carry the data, type and address of the
+ * instant it belongs to. Meanwhile active scans set NRPAs between slots,
+ * and the application advertises directly in between, both behind the
+ * back of the scheduler's view of the controller. From this directory:
+ *
+ *   gcc -I. test_multi_adv.c -o test_multi_adv
+ *   ./test_multi_adv [instants]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/host/multi_adv.c"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+#define RUN_MS          (600 * 1000U)
+#define SCAN_EVERY_MS   2000    /* on average, while advertising is off */
+
+struct bt_dev bt_dev;
+
+static u32_t now = 1000;
+
+u32_t k_uptime_get_32(void)
+{
+    return now;
+}
+
+void *k_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void k_free(void *ptr)
+{
+    free(ptr);
+}
+
+void k_delayed_work_init(struct k_delayed_work *work, k_work_handler_t handler)
+{
+    work->work.handler = handler;
+    work->pending = false;
+}
+
+int k_delayed_work_submit(struct k_delayed_work *work, uint32_t delay)
+{
+    work->due = now + delay;
+    work->pending = true;
+    return 0;
+}
+
+int k_delayed_work_cancel(struct k_delayed_work *work)
+{
+    work->pending = false;
+    return 0;
+}
+
+/* The controller */
+enum { ADV_IND, ADV_SCAN_IND, ADV_NONCONN_IND };
+
+static struct {
+    u8_t type;
+    u32_t interval;             /* ms */
+    u8_t ad[MAX_AD_DATA_LEN], ad_len;
+    u8_t sd[MAX_AD_DATA_LEN], sd_len;
+    bt_addr_t addr;
+    u32_t next_event;
+} ctl;
+
+static long hci_cmds, param_cmds;
+
+static const bt_addr_t id_addr = { { 0x11, 0x22, 0x33, 0x44, 0x55, 0xc6 } };
+
+/* hci_core.c from here on, for a build without CONFIG_BT_PRIVACY */
+static void set_random_address(const bt_addr_t *addr)
+{
+    if (!memcmp(addr, &ctl.addr, sizeof(*addr))) {
+        return;
+    }
+
+    hci_cmds++;
+    ctl.addr = *addr;
+    multi_adv_air_invalidate();
+}
+
+static void set_advertise_enable(bool enable)
+{
+    hci_cmds++;
+
+    if (enable) {
+        atomic_set_bit(bt_dev.flags, BT_DEV_ADVERTISING);
+        /* the first event goes out at once, the controller adds its delay */
+        ctl.next_event = now + rand() % 3;
+    } else {
+        atomic_clear_bit(bt_dev.flags, BT_DEV_ADVERTISING);
+    }
+}
+
+static void set_ad(u8_t *dst, u8_t *dst_len, const u8_t *data, size_t len)
+{
+    hci_cmds++;
+    memcpy(dst, data, len);
+    *dst_len = len;
+}
+
+static void le_adv_stop(void)
+{
+    if (atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING)) {
+        set_advertise_enable(false);
+    }
+}
+
+int bt_le_adv_stop_instant(void)
+{
+    le_adv_stop();
+    return 0;
+}
+
+int bt_le_adv_update_instant(const struct bt_le_adv_param *param,
+        const uint8_t *ad_data, size_t ad_len,
+        const uint8_t *sd_data, size_t sd_len, uint8_t update)
+{
+    bool conn = param->options & BT_LE_ADV_OPT_CONNECTABLE;
+
+    if (update & BT_LE_ADV_UPDATE_PARAM) {
+        le_adv_stop();
+    }
+
+    if (update & BT_LE_ADV_UPDATE_AD) {
+        set_ad(ctl.ad, &ctl.ad_len, ad_data, ad_len);
+    }
+
+    if ((update & BT_LE_ADV_UPDATE_SD) && (sd_len || conn)) {
+        set_ad(ctl.sd, &ctl.sd_len, sd_data, sd_len);
+    }
+
+    if (!(update & BT_LE_ADV_UPDATE_PARAM)) {
+        if (atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING)) {
+            return 0;
+        }
+        set_advertise_enable(true);
+        return 0;
+    }
+
+    if (conn) {
+        set_random_address(&id_addr);
+        ctl.type = ADV_IND;
+    } else {
+        ctl.type = sd_len ? ADV_SCAN_IND : ADV_NONCONN_IND;
+    }
+
+    hci_cmds++;
+    param_cmds++;
+    ctl.interval = param->interval_min * 5 / 8;
+
+    set_advertise_enable(true);
+    return 0;
+}
+
+/* bt_le_adv_start() and bt_le_adv_stop() of the application */
+static void app_adv_start(void)
+{
+    static const u8_t app_ad[] = { 0x02, 0x01, 0x06 };
+
+    multi_adv_air_invalidate();
+    set_random_address(&id_addr);
+    set_ad(ctl.ad, &ctl.ad_len, app_ad, sizeof(app_ad));
+    set_ad(ctl.sd, &ctl.sd_len, NULL, 0);
+    ctl.type = ADV_IND;
+    ctl.interval = 100;
+    set_advertise_enable(true);
+}
+
+static void app_adv_stop(void)
+{
+    multi_adv_air_invalidate();
+    le_adv_stop();
+}
+
+/* start_le_scan() of an active scan while advertising is off */
+static void active_scan(void)
+{
+    bt_addr_t nrpa;
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        nrpa.val[i] = rand();
+    }
+    nrpa.val[5] &= 0x3f;
+
+    set_random_address(&nrpa);
+}
+/* hci_core.c ends */
+
+static struct {
+    u32_t last, events, min_gap, max_gap;
+    double sum;
+} seen[32];
+
+static long wrong_data, wrong_type, wrong_addr;
+static bool app_on_air;
+
+static struct multi_adv_instant *instant_on_air(void)
+{
+    int i;
+
+    for (i = 0; i < g_multi_adv_list_num; i++) {
+        struct multi_adv_instant *inst = &g_multi_adv_list[i];
+
+        if (inst->inuse_flag && inst->ad_len == ctl.ad_len &&
+            !memcmp(inst->ad, ctl.ad, ctl.ad_len)) {
+            return inst;
+        }
+    }
+
+    return NULL;
+}
+
+static void adv_event(void)
+{
+    struct multi_adv_instant *inst = instant_on_air();
+    int i;
+    u32_t gap;
+
+    if (app_on_air) {
+        return;
+    }
+
+    if (!inst) {
+        wrong_data++;
+        return;
+    }
+
+    if (inst->param.options & BT_LE_ADV_OPT_CONNECTABLE) {
+        wrong_type += ctl.type != ADV_IND;
+        wrong_addr += memcmp(&ctl.addr, &id_addr, sizeof(id_addr)) != 0;
+    } else {
+        wrong_type += ctl.type != (inst->sd_len ? ADV_SCAN_IND : ADV_NONCONN_IND);
+    }
+    if (inst->sd_len) {
+        wrong_data += ctl.sd_len != inst->sd_len ||
+                      memcmp(ctl.sd, inst->sd, inst->sd_len);
+    }
+
+    i = inst - g_multi_adv_list;
+    if (seen[i].events) {
+        gap = now - seen[i].last;
+        seen[i].sum += gap;
+        if (gap > seen[i].max_gap) {
+            seen[i].max_gap = gap;
+        }
+        if (gap < seen[i].min_gap) {
+            seen[i].min_gap = gap;
+        }
+    }
+    seen[i].events++;
+    seen[i].last = now;
+}
+
+static void run(u32_t ms)
+{
+    u32_t end = now + ms;
+
+    while (now != end) {
+        now++;
+
+        if (atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING) &&
+            (s32_t)(now - ctl.next_event) >= 0) {
+            adv_event();
+            ctl.next_event = now + ctl.interval + rand() % 11;
+        }
+
+        if (g_multi_adv_timer.pending && (s32_t)(now - g_multi_adv_timer.due) >= 0) {
+            g_multi_adv_timer.pending = false;
+            g_multi_adv_timer.work.handler(&g_multi_adv_timer.work);
+        }
+
+        if (!atomic_test_bit(bt_dev.flags, BT_DEV_ADVERTISING) &&
+            !(rand() % SCAN_EVERY_MS)) {
+            active_scan();
+        }
+    }
+}
+
+static const u16_t intervals[] = {
+    160, 480, 320, 800, 1600, 160, 960, 240, 400, 1280, 640, 1600,
+};
+
+static void instant_param(struct bt_le_adv_param *param, int i)
+{
+    u16_t iv = intervals[i % ARRAY_SIZE(intervals)];
+
+    memset(param, 0, sizeof(*param));
+    param->options = (i % 4 == 3) ? BT_LE_ADV_OPT_CONNECTABLE : 0;
+    param->interval_min = iv;
+    param->interval_max = iv + iv / 4;
+}
+
+static void test_schedule(int n, int *ids)
+{
+    static u8_t data[32][2];
+    struct bt_le_adv_param param;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        struct bt_data ad = { 0xff, 2, data[i] };
+        struct bt_data sd = { 0x09, 2, data[i] };
+
+        data[i][0] = 0xaa;
+        data[i][1] = i;
+        instant_param(&param, i);
+        CHECK(!bt_le_multi_adv_start(&param, &ad, 1, &sd, i % 3 == 1, &ids[i]),
+              "start %d", i);
+    }
+
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < n; i++) {
+        seen[i].min_gap = ~0U;
+    }
+    hci_cmds = param_cmds = 0;
+
+    run(RUN_MS);
+
+    for (i = 0; i < n; i++) {
+        u16_t iv = intervals[i % ARRAY_SIZE(intervals)];
+        double lo = iv * 5 / 8.0, hi = (iv + iv / 4) * 5 / 8.0;
+        double avg = seen[i].sum / (seen[i].events - 1);
+
+        printf("instant %d: %4.0f..%4.0f ms, average %6.1f, gaps %u..%u, %u events\r\n",
+               i, lo, hi, avg, seen[i].min_gap, seen[i].max_gap, seen[i].events);
+        CHECK(avg >= lo * 0.95 && avg <= hi * 1.05, "instant %d interval", i);
+    }
+
+    printf("%ld HCI commands in %u s, %ld of them parameters\r\n",
+           hci_cmds, RUN_MS / 1000, param_cmds);
+}
+
+/* The connectable instant left on air alone, the application stops it,
+ * advertises on its own and stops again, then a slow instant comes. The
+ * connectable one is served several times in a row between the slow one's
+ * events and with the same parameters, and has to go out with its own data
+ * and address, not with what the application or an active scan left.
+ */
+static void test_direct_adv(int conn_id)
+{
+    static const u8_t data[] = { 0xbb };
+    struct bt_data ad = { 0xff, 1, data };
+    struct bt_le_adv_param param;
+    int id;
+
+    memset(seen, 0, sizeof(seen));
+    instant_param(&param, 4);
+
+    app_adv_stop();
+    app_on_air = true;
+    app_adv_start();
+    run(2000);
+    app_adv_stop();
+    app_on_air = false;
+
+    CHECK(!bt_le_multi_adv_start(&param, &ad, 1, NULL, 0, &id), "start");
+    run(60 * 1000);
+    CHECK(seen[conn_id - 1].events > 100 && seen[id - 1].events > 50,
+          "%u and %u events", seen[conn_id - 1].events, seen[id - 1].events);
+
+    bt_le_multi_adv_stop(id);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 8;
+    int ids[16];
+    int i;
+
+    /* with more, CONFIG_BT_MULTI_ADV_DWELL_MS per event no longer fits */
+    if (n < 4 || n > 16) {
+        printf("4 to 16 instants\r\n");
+        return 1;
+    }
+
+    srand(1);
+    bt_dev.hci_version = BT_HCI_VERSION_5_0;
+    CHECK(!bt_le_multi_adv_pool_init(n), "pool");
+    bt_le_multi_adv_thread_init();
+
+    test_schedule(n, ids);
+
+    for (i = 0; i < n; i++) {
+        if (i != 3) {
+            bt_le_multi_adv_stop(ids[i]);
+        }
+    }
+    test_direct_adv(ids[3]);
+
+    CHECK(!wrong_data, "%ld events with data of no instant", wrong_data);
+    CHECK(!wrong_type, "%ld events of the wrong type", wrong_type);
+    CHECK(!wrong_addr, "%ld connectable events from an NRPA", wrong_addr);
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
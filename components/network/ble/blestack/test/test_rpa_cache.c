@@ -0,0 +1,302 @@
+/*
+ * Host test and benchmark of the RPA resolution cache. The IRK matcher is
+ * checked against the ah() sample data of the Core spec and against a
+ * plain tinycrypt ah() on random IRKs, the caches for LRU order, expiry
+ * and forgetting. The benchmark replays advertising reports of rotating
+ * phones, some bonded and most not, through the resolution path of
+ * bt_keys_find_irk() with and without the caches, and every report has to
+ * resolve to the same bond both ways. From this directory:
+ *
+ *   T=../src/common/tinycrypt
+ *   gcc -O2 -I. -I../src/host -I$T/include -I$T/include/tinycrypt \
+ *       test_rpa_cache.c ../src/host/rpa_cache.c $T/source/aes_encrypt.c \
+ *       $T/source/utils.c -o test_rpa_cache
+ *   ./test_rpa_cache [reports]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <tinycrypt/constants.h>
+#include <misc/byteorder.h>
+
+#include "rpa_cache.h"
+
+#define LIFETIME    (15 * 60 * 1000U)
+#define BONDS_MAX   32
+#define PHONES      60
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+/* ah(k, r) of the spec with a fresh key schedule, IRK little endian
+ * like in the key pool
+ */
+static u32_t ah(const u8_t irk[16], u32_t prand)
+{
+    struct tc_aes_key_sched_struct sched;
+    u8_t key[16], block[16] = { 0 }, out[16];
+
+    sys_memcpy_swap(key, irk, 16);
+    block[13] = prand >> 16;
+    block[14] = prand >> 8;
+    block[15] = prand;
+
+    tc_aes128_set_encrypt_key(&sched, key);
+    tc_aes_encrypt(out, block, &sched);
+
+    return (out[13] << 16) | (out[14] << 8) | out[15];
+}
+
+static void rpa_make(bt_addr_t *rpa, const u8_t irk[16], u32_t prand)
+{
+    u32_t hash;
+
+    prand = (prand & 0x3fffff) | 0x400000;
+    hash = ah(irk, prand);
+
+    rpa->val[0] = hash;
+    rpa->val[1] = hash >> 8;
+    rpa->val[2] = hash >> 16;
+    rpa->val[3] = prand;
+    rpa->val[4] = prand >> 8;
+    rpa->val[5] = prand >> 16;
+}
+
+static void test_matches(void)
+{
+    /* Core spec Vol 3 Part H, ah sample data */
+    static const u8_t irk[16] = {
+        0x9b, 0x7d, 0x39, 0x0a, 0xa6, 0x10, 0x10, 0x34,
+        0x05, 0xad, 0xc8, 0x57, 0xa3, 0x34, 0x02, 0xec,
+    };
+    bt_addr_t rpa = { { 0xaa, 0xfb, 0x0d, 0x94, 0x81, 0x70 } };
+    struct rpa_irk_sched sched = { 0 };
+    u8_t irks[8][16];
+    int i, j;
+
+    CHECK(ah(irk, 0x708194) == 0x0dfbaa, "ah sample data");
+    CHECK(rpa_irk_sched_matches(&sched, irk, &rpa), "sample RPA");
+    for (i = 0; i < 3; i++) {
+        rpa.val[i] ^= 1;
+        CHECK(!rpa_irk_sched_matches(&sched, irk, &rpa),
+              "wrong hash byte %d matched", i);
+        rpa.val[i] ^= 1;
+    }
+    rpa.val[3] ^= 1;
+    CHECK(!rpa_irk_sched_matches(&sched, irk, &rpa), "wrong prand matched");
+
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 16; j++) {
+            irks[i][j] = rand();
+        }
+    }
+
+    /* one schedule for all IRKs, so it is expanded again on every change */
+    for (i = 0; i < 1000; i++) {
+        int owner = rand() % 8, k = rand() % 8;
+
+        rpa_make(&rpa, irks[owner], rand());
+        CHECK(rpa_irk_sched_matches(&sched, irks[k], &rpa) == (k == owner),
+              "IRK %d RPA of %d", k, owner);
+        CHECK(!memcmp(sched.irk, irks[k], 16), "schedule of the wrong IRK");
+    }
+}
+
+static void addr_of(bt_addr_t *a, int n)
+{
+    memset(a, 0, sizeof(*a));
+    a->val[0] = n;
+    a->val[5] = 0x40;
+}
+
+static void test_cache(void)
+{
+    RPA_CACHE_DEFINE(cache, 4);
+    bt_addr_t a;
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        addr_of(&a, i);
+        rpa_cache_insert(&cache, 0, &a, i, 1000 * i);
+    }
+
+    CHECK(cache.count == 4, "count %u", cache.count);
+    addr_of(&a, 0);
+    CHECK(!rpa_cache_lookup(&cache, 0, &a, 5000, LIFETIME),
+          "least recently used entry kept");
+
+    /* a hit moves to the front, so 2 is the oldest now */
+    addr_of(&a, 1);
+    CHECK(rpa_cache_lookup(&cache, 0, &a, 5000, LIFETIME) &&
+          cache.entries[0].idx == 1, "hit not moved to the front");
+    addr_of(&a, 5);
+    rpa_cache_insert(&cache, 0, &a, 5, 5000);
+    addr_of(&a, 2);
+    CHECK(!rpa_cache_lookup(&cache, 0, &a, 5000, LIFETIME), "2 kept");
+    addr_of(&a, 1);
+    CHECK(rpa_cache_lookup(&cache, 0, &a, 5000, LIFETIME), "1 dropped");
+
+    /* other identity */
+    CHECK(!rpa_cache_lookup(&cache, 1, &a, 5000, LIFETIME), "id ignored");
+
+    /* expiry counts from when it was resolved, not from the last hit */
+    addr_of(&a, 3);
+    CHECK(rpa_cache_lookup(&cache, 0, &a, 3000 + LIFETIME - 1, LIFETIME),
+          "expired early");
+    CHECK(!rpa_cache_lookup(&cache, 0, &a, 3000 + LIFETIME, LIFETIME),
+          "not expired");
+    CHECK(cache.count == 3, "expired entry kept, count %u", cache.count);
+
+    /* and across the wrap of the uptime */
+    addr_of(&a, 7);
+    rpa_cache_insert(&cache, 0, &a, 7, 0xfffff000);
+    CHECK(rpa_cache_lookup(&cache, 0, &a, 0x1000, LIFETIME), "wrap");
+
+    rpa_cache_forget(&cache, 7);
+    CHECK(!rpa_cache_lookup(&cache, 0, &a, 0x1000, LIFETIME) &&
+          cache.count == 3, "forget 7, count %u", cache.count);
+    rpa_cache_forget(&cache, -1);
+    CHECK(!cache.count, "forget all");
+}
+
+/* The lookup order of bt_keys_find_irk() */
+static struct {
+    u8_t irk[BONDS_MAX][16];
+    struct rpa_irk_sched sched[BONDS_MAX];
+    int count;
+} bonds;
+
+RPA_CACHE_DEFINE(pos_cache, 8);
+RPA_CACHE_DEFINE(neg_cache, 32);
+
+static int resolve(const bt_addr_t *rpa, u32_t now)
+{
+    struct rpa_cache_entry *e;
+    int i;
+
+    e = rpa_cache_lookup(&pos_cache, 0, rpa, now, LIFETIME);
+    if (e) {
+        return e->idx;
+    }
+
+    if (rpa_cache_lookup(&neg_cache, 0, rpa, now, LIFETIME)) {
+        return -1;
+    }
+
+    for (i = 0; i < bonds.count; i++) {
+        if (rpa_irk_sched_matches(&bonds.sched[i], bonds.irk[i], rpa)) {
+            rpa_cache_insert(&pos_cache, 0, rpa, i, now);
+            return i;
+        }
+    }
+
+    rpa_cache_insert(&neg_cache, 0, rpa, 0, now);
+    return -1;
+}
+
+static int resolve_plain(const bt_addr_t *rpa)
+{
+    u32_t prand = rpa->val[3] | (rpa->val[4] << 8) | (rpa->val[5] << 16);
+    u32_t hash = rpa->val[0] | (rpa->val[1] << 8) | (rpa->val[2] << 16);
+    int i;
+
+    for (i = 0; i < bonds.count; i++) {
+        if (ah(bonds.irk[i], prand) == hash) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static double secs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Phones 0..bond_count-1 are bonded, each rotates its RPA every lifetime
+ * at its own phase, and reports come every 5 ms from a random phone.
+ */
+static void bench(int bond_count, long reports)
+{
+    static u8_t phone_irk[PHONES][16];
+    static bt_addr_t rpa[PHONES][2];
+    static int want[PHONES][2];
+    double t0, plain, cached;
+    long n, mismatch = 0;
+    int i, j;
+
+    bonds.count = bond_count;
+    rpa_cache_forget(&pos_cache, -1);
+    rpa_cache_forget(&neg_cache, -1);
+
+    for (i = 0; i < PHONES; i++) {
+        for (j = 0; j < 16; j++) {
+            phone_irk[i][j] = rand();
+        }
+        if (i < bond_count) {
+            memcpy(bonds.irk[i], phone_irk[i], 16);
+            bonds.sched[i].valid = false;
+        }
+        for (j = 0; j < 2; j++) {
+            rpa_make(&rpa[i][j], phone_irk[i], rand());
+            want[i][j] = i < bond_count ? i : -1;
+        }
+    }
+
+    /* both passes see the same reports */
+    srand(bond_count);
+    t0 = secs();
+    for (n = 0; n < reports; n++) {
+        u32_t now = n * 5;
+        int p = rand() % PHONES;
+        int r = ((now + p * (LIFETIME / PHONES)) / LIFETIME) % 2;
+
+        mismatch += resolve_plain(&rpa[p][r]) != want[p][r];
+    }
+    plain = secs() - t0;
+
+    srand(bond_count);
+    t0 = secs();
+    for (n = 0; n < reports; n++) {
+        u32_t now = n * 5;
+        int p = rand() % PHONES;
+        int r = ((now + p * (LIFETIME / PHONES)) / LIFETIME) % 2;
+
+        mismatch += resolve(&rpa[p][r], now) != want[p][r];
+    }
+    cached = secs() - t0;
+
+    CHECK(!mismatch, "%d bonds: %ld reports resolved wrong", bond_count,
+          mismatch);
+
+    printf("%2d bonds: %8.0f reports/s without the cache, %10.0f with it\r\n",
+           bond_count, reports / plain, reports / cached);
+}
+
+int main(int argc, char *argv[])
+{
+    long reports = argc > 1 ? atol(argv[1]) : 400000;
+
+    srand(1);
+    test_matches();
+    test_cache();
+
+    bench(8, reports);
+    bench(32, reports);
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,365 @@
+/*
+ * Host test of the EasyFlash settings backend on an append-only env area
+ * in memory. Covers the hex values of older releases, binary round trips,
+ * skipped rewrites and the deferred writes: coalescing, slots running out,
+ * direct writes and deletes over a pending value, and that a deferred
+ * value survives a power cut once BT_SETTINGS_DEFER_TIMEOUT has passed
+ * without any disconnect. From this directory:
+ *
+ *   gcc -DBFLB_BLE -DCONFIG_BT_SETTINGS -I. -I../src/host \
+ *       test_settings_ef.c ../src/common/hex.c -o test_settings_ef
+ *   ./test_settings_ef
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/host/settings_ef.c"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+int test_mutex;
+
+static int mallocs;
+
+void *pvPortMalloc(size_t size)
+{
+    mallocs++;
+    return malloc(size);
+}
+
+void vPortFree(void *ptr)
+{
+    free(ptr);
+}
+
+/* The flash: every set appends, the newest live node of a key wins */
+#define FLASH_SIZE  (1 << 20)
+#define ENV_MAX     512
+
+static u8_t flash[FLASH_SIZE];
+static u32_t flash_top;
+static int flash_writes;
+
+static struct {
+    char key[64];
+    u32_t addr;
+    u32_t len;
+    bool live;
+} envs[ENV_MAX];
+static int env_count;
+static char env_str[512];
+
+static int env_find(const char *key)
+{
+    int i;
+
+    for (i = env_count - 1; i >= 0; i--) {
+        if (envs[i].live && !strcmp(envs[i].key, key)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+EfErrCode easyflash_init(void)
+{
+    return EF_NO_ERR;
+}
+
+bool ef_get_env_obj(const char *key, env_node_obj_t env)
+{
+    int i = env_find(key);
+
+    if (i < 0) {
+        return false;
+    }
+
+    env->value_len = envs[i].len;
+    env->addr.value = envs[i].addr;
+    return true;
+}
+
+EfErrCode ef_port_read(uint32_t addr, uint32_t *buf, size_t size)
+{
+    /* the flash driver reads whole words */
+    CHECK(!((uintptr_t)buf & 3), "unaligned ef_port_read buffer");
+    memcpy(buf, &flash[addr], size);
+    return EF_NO_ERR;
+}
+
+EfErrCode ef_set_env_blob(const char *key, const void *value_buf, size_t buf_len)
+{
+    int i = env_find(key);
+
+    if (env_count == ENV_MAX || flash_top + buf_len > FLASH_SIZE) {
+        return EF_ENV_FULL;
+    }
+
+    if (i >= 0) {
+        envs[i].live = false;
+    }
+
+    i = env_count++;
+    strcpy(envs[i].key, key);
+    envs[i].addr = flash_top;
+    envs[i].len = buf_len;
+    envs[i].live = true;
+    memcpy(&flash[flash_top], value_buf, buf_len);
+    flash_top += buf_len;
+    flash_writes++;
+
+    return EF_NO_ERR;
+}
+
+EfErrCode ef_set_env(const char *key, const char *value)
+{
+    return ef_set_env_blob(key, value, strlen(value));
+}
+
+char *ef_get_env(const char *key)
+{
+    int i = env_find(key);
+
+    if (i < 0 || envs[i].len >= sizeof(env_str)) {
+        return NULL;
+    }
+
+    memcpy(env_str, &flash[envs[i].addr], envs[i].len);
+    env_str[envs[i].len] = '\0';
+    return env_str;
+}
+
+EfErrCode ef_del_env(const char *key)
+{
+    int i = env_find(key);
+
+    if (i >= 0) {
+        envs[i].live = false;
+    }
+
+    return EF_NO_ERR;
+}
+
+/* The work queue clock */
+static u32_t now;
+
+void k_delayed_work_init(struct k_delayed_work *work, k_work_handler_t handler)
+{
+    work->work.handler = handler;
+    work->pending = false;
+}
+
+int k_delayed_work_submit(struct k_delayed_work *work, uint32_t delay)
+{
+    work->due = now + delay;
+    work->pending = true;
+    return 0;
+}
+
+int k_delayed_work_cancel(struct k_delayed_work *work)
+{
+    work->pending = false;
+    return 0;
+}
+
+s32_t k_delayed_work_remaining_get(struct k_delayed_work *work)
+{
+    return work->pending ? (s32_t)(work->due - now) : 0;
+}
+
+static void advance(u32_t ms)
+{
+    now += ms;
+
+    if (flush_work.pending && (s32_t)(now - flush_work.due) >= 0) {
+        flush_work.pending = false;
+        flush_work.work.handler(&flush_work.work);
+    }
+}
+
+/* RAM is gone, the flash stays */
+static void power_cut(void)
+{
+    memset(deferred, 0, sizeof(deferred));
+    flush_work.pending = false;
+    ef_ready_flag = false;
+}
+
+static bool flash_holds(const char *key, const u8_t *value, size_t len)
+{
+    struct env_node_obj env;
+
+    return ef_get_env_obj(key, &env) &&
+           env.value_len == BT_SETTINGS_REC_HDR_LEN + len &&
+           flash[env.addr.value] == BT_SETTINGS_REC_MAGIC &&
+           !memcmp(&flash[env.addr.value + BT_SETTINGS_REC_HDR_LEN], value, len);
+}
+
+static void test_hex(void)
+{
+    u8_t out[8];
+    size_t n = 0;
+
+    ef_set_env("KEY_POOL", "00ff10a5B7");
+    CHECK(!bt_settings_get_bin("KEY_POOL", out, 5, &n) && n == 5 &&
+          out[1] == 0xff && out[4] == 0xb7, "hex value not decoded");
+    CHECK(flash_holds("KEY_POOL", (const u8_t *)"\x00\xff\x10\xa5\xb7", 5),
+          "hex value not rewritten as a record");
+    CHECK(!bt_settings_get_bin("KEY_POOL", out, 5, &n) && n == 5 &&
+          out[4] == 0xb7, "record read back");
+    CHECK(bt_settings_get_bin("KEY_POOL", out, 4, &n) == -1,
+          "record longer than the buffer");
+
+    ef_set_env("bad", "0g");
+    CHECK(bt_settings_get_bin("bad", out, 0, &n) == -1, "bad hex");
+    CHECK(bt_settings_get_bin("none", out, 0, &n) == -1, "missing key");
+}
+
+static void test_round_trip(void)
+{
+    u8_t v[300], out[300];
+    size_t n = 0;
+    int writes, i;
+
+    for (i = 0; i < (int)sizeof(v); i++) {
+        v[i] = rand();
+    }
+
+    writes = flash_writes;
+    CHECK(!bt_settings_set_bin("a", v, 20), "set a");
+    CHECK(!bt_settings_get_bin("a", out, 20, &n) && n == 20 &&
+          !memcmp(out, v, 20), "a read back");
+    CHECK(!bt_settings_set_bin("a", v, 20) && flash_writes == writes + 1,
+          "unchanged record written again");
+
+    mallocs = 0;
+    CHECK(!bt_settings_set_bin("b", v, 200) && mallocs == 1,
+          "large record not on the heap");
+    CHECK(!bt_settings_get_bin("b", out, 0, &n) && n == 200 &&
+          !memcmp(out, v, 200), "b read back");
+    CHECK(!bt_settings_get_bin("b", out + 1, 0, &n) && n == 200 &&
+          !memcmp(out + 1, v, 200), "b read back unaligned");
+
+    CHECK(!bt_settings_set_bin("z", NULL, 0), "set empty");
+    CHECK(!bt_settings_get_bin("z", out, 4, &n) && n == 0, "empty read back");
+}
+
+static void test_deferred(void)
+{
+    u8_t v[BT_SETTINGS_DEFER_MAX + 1], out[sizeof(v)];
+    char key[8];
+    size_t n = 0;
+    int writes, i;
+
+    memset(v, 0x5a, sizeof(v));
+
+    /* coalesced in RAM, visible to reads, one write on flush */
+    writes = flash_writes;
+    for (i = 0; i < 50; i++) {
+        v[0] = i;
+        CHECK(!bt_settings_set_bin_deferred("bt/ccc/x", v, 192), "defer");
+    }
+    CHECK(flash_writes == writes, "deferred value written early");
+    CHECK(!bt_settings_get_bin("bt/ccc/x", out, 192, &n) && n == 192 &&
+          out[0] == 49, "pending value not read back");
+    bt_settings_flush();
+    CHECK(flash_writes == writes + 1 && flash_holds("bt/ccc/x", v, 192),
+          "flush");
+    CHECK(!flush_work.pending, "flush left the timer running");
+
+    /* no slot or too large, written through */
+    writes = flash_writes;
+    for (i = 0; i <= BT_SETTINGS_DEFER_SLOTS; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        CHECK(!bt_settings_set_bin_deferred(key, v, 8), "defer %s", key);
+    }
+    CHECK(flash_writes == writes + 1 && flash_holds(key, v, 8),
+          "no free slot but not written through");
+    CHECK(!bt_settings_set_bin_deferred("big", v, sizeof(v)) &&
+          flash_writes == writes + 2, "oversized value deferred");
+    bt_settings_flush();
+    CHECK(flash_writes == writes + 2 + BT_SETTINGS_DEFER_SLOTS,
+          "flushed %d", flash_writes - writes);
+
+    /* a direct write or a delete wins over the pending value */
+    v[0] = 1;
+    bt_settings_set_bin_deferred("d", v, 8);
+    v[0] = 2;
+    bt_settings_set_bin("d", v, 8);
+    bt_settings_flush();
+    CHECK(flash_holds("d", v, 8), "pending value flushed over a direct write");
+
+    bt_settings_set_bin_deferred("d", v, 8);
+    settings_delete("d");
+    bt_settings_flush();
+    CHECK(bt_settings_get_bin("d", out, 8, &n) == -1,
+          "pending value flushed over a delete");
+}
+
+/* The key pool aging counter is deferred. No disconnect comes and the
+ * power goes: the value has to be in flash once the timeout has passed.
+ */
+static void test_power_cut(void)
+{
+    u8_t pool[64], out[64];
+    size_t n = 0;
+
+    memset(pool, 0x11, sizeof(pool));
+    bt_settings_set_bin(NV_KEY_POOL, pool, sizeof(pool));
+
+    pool[0] = 0x22;
+    bt_settings_set_bin_deferred(NV_KEY_POOL, pool, sizeof(pool));
+    advance(BT_SETTINGS_DEFER_TIMEOUT - 1);
+    CHECK(!flash_holds(NV_KEY_POOL, pool, sizeof(pool)),
+          "written before the timeout");
+
+    /* a later value does not push the flush out */
+    pool[0] = 0x33;
+    bt_settings_set_bin_deferred(NV_KEY_POOL, pool, sizeof(pool));
+    bt_settings_set_bin_deferred("bt/cf/x", pool, 1);
+    advance(1);
+    CHECK(flash_holds(NV_KEY_POOL, pool, sizeof(pool)) &&
+          flash_holds("bt/cf/x", pool, 1), "not written at the timeout");
+
+    /* and the timer restarts with the next deferred value */
+    pool[0] = 0x44;
+    bt_settings_set_bin_deferred(NV_KEY_POOL, pool, sizeof(pool));
+    advance(BT_SETTINGS_DEFER_TIMEOUT);
+    power_cut();
+
+    CHECK(!bt_settings_get_bin(NV_KEY_POOL, out, sizeof(out), &n) &&
+          n == sizeof(out) && out[0] == 0x44, "key pool lost in a power cut");
+
+    /* what is lost is at most one timeout worth */
+    pool[0] = 0x55;
+    bt_settings_set_bin_deferred(NV_KEY_POOL, pool, sizeof(pool));
+    advance(BT_SETTINGS_DEFER_TIMEOUT / 2);
+    power_cut();
+    CHECK(!bt_settings_get_bin(NV_KEY_POOL, out, sizeof(out), &n) &&
+          out[0] == 0x44, "power cut inside the timeout");
+}
+
+int main(void)
+{
+    srand(1);
+    test_hex();
+    test_round_trip();
+    test_deferred();
+    test_power_cut();
+
+    CHECK(!test_mutex, "settings lock held");
+
+    printf("%d flash writes\r\n", flash_writes);
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+/* Host test stand-in, enough of the blestack port for the sources under test */
+#ifndef TEST_ZEPHYR_H
+#define TEST_ZEPHYR_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int8_t s8_t;
+typedef int16_t s16_t;
+typedef int32_t s32_t;
+
+#define IS_ENABLED(x)           0
+#define MIN(a, b)               (((a) < (b)) ? (a) : (b))
+#define BIT(n)                  (1UL << (n))
+#define ARRAY_SIZE(a)           (sizeof(a) / sizeof((a)[0]))
+
+#define K_NO_WAIT               0
+#define K_MSEC(ms)              (ms)
+#define K_SECONDS(s)            ((s) * 1000)
+
+struct k_work;
+typedef void (*k_work_handler_t)(struct k_work *work);
+
+struct k_work {
+    k_work_handler_t handler;
+};
+
+/* Fires from the test clock, see the test */
+struct k_delayed_work {
+    struct k_work work;
+    u32_t due;
+    bool pending;
+};
+
+void k_delayed_work_init(struct k_delayed_work *work, k_work_handler_t handler);
+int k_delayed_work_submit(struct k_delayed_work *work, uint32_t delay);
+int k_delayed_work_cancel(struct k_delayed_work *work);
+s32_t k_delayed_work_remaining_get(struct k_delayed_work *work);
+
+u32_t k_uptime_get_32(void);
+void *k_malloc(size_t size);
+void k_free(void *ptr);
+
+size_t hex2bin(const char *hex, size_t hexlen, u8_t *buf, size_t buflen);
+
+#endif
@@ -0,0 +1,191 @@
+/**
+ * @file
+ * TCP receive window and send buffer autotuning
+ *
+ * Every pcb starts with TCP_AUTOTUNE_WND_MIN/TCP_AUTOTUNE_SND_BUF_MIN. The
+ * receive window doubles when the application consumed at least half of it
+ * within one smoothed RTT, i.e. when the window and not the link is the
+ * bottleneck. The send buffer grows by two segments per ACK while the
+ * buffer is full and the peer's window and cwnd could take more.
+ *
+ * Growth is paid from a global budget: a step is refused when it exceeds
+ * 1/TCP_AUTOTUNE_HEAP_SHARE of the free heap above TCP_AUTOTUNE_HEAP_RESERVE
+ * or when the total granted bytes would exceed TCP_AUTOTUNE_MEM_MAX. When
+ * the free heap drops below the reserve, the slow timer halves the grown
+ * part of every pcb until the heap recovers.
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_TCP && LWIP_TCP_AUTOTUNE /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/sys.h"
+#include "lwip/priv/tcp_priv.h"
+
+static struct tcp_autotune_stats tcp_at_stats;
+
+/* Until both sides agree on window scaling the window cannot go past 64K */
+#if LWIP_WND_SCALE
+#define TCP_AUTOTUNE_WND_LIMIT(pcb)  ((tcpwnd_size_t)(((pcb)->flags & TF_WND_SCALE) ? TCP_WND : TCPWND16(TCP_WND)))
+#else
+#define TCP_AUTOTUNE_WND_LIMIT(pcb)  TCP_WND
+#endif
+
+static u32_t
+tcp_autotune_budget(void)
+{
+  u32_t free_heap = (u32_t)TCP_AUTOTUNE_FREE_HEAP();
+  u32_t budget;
+
+  if (free_heap <= TCP_AUTOTUNE_HEAP_RESERVE) {
+    return 0;
+  }
+  budget = (free_heap - TCP_AUTOTUNE_HEAP_RESERVE) / TCP_AUTOTUNE_HEAP_SHARE;
+  if (tcp_at_stats.granted >= TCP_AUTOTUNE_MEM_MAX) {
+    return 0;
+  }
+  return LWIP_MIN(budget, TCP_AUTOTUNE_MEM_MAX - tcp_at_stats.granted);
+}
+
+/* Take up to 'want' bytes from the budget, returns the granted amount
+   rounded down to whole segments */
+static tcpwnd_size_t
+tcp_autotune_take(tcpwnd_size_t want)
+{
+  u32_t grant = LWIP_MIN(want, tcp_autotune_budget());
+
+  grant -= grant % TCP_MSS;
+  if (grant == 0) {
+    tcp_at_stats.denied++;
+    return 0;
+  }
+  tcp_at_stats.granted += grant;
+  if (tcp_at_stats.granted > tcp_at_stats.granted_peak) {
+    tcp_at_stats.granted_peak = tcp_at_stats.granted;
+  }
+  tcp_at_stats.grow++;
+  return (tcpwnd_size_t)grant;
+}
+
+void
+tcp_autotune_init_pcb(struct tcp_pcb *pcb)
+{
+  pcb->rcv_wnd_max = TCP_AUTOTUNE_WND_MIN;
+  pcb->snd_buf_max = TCP_AUTOTUNE_SND_BUF_MIN;
+  pcb->snd_buf = TCP_AUTOTUNE_SND_BUF_MIN;
+  pcb->rcv_wnd = pcb->rcv_ann_wnd = TCPWND_MIN16(TCP_AUTOTUNE_WND_MIN);
+  pcb->at_rcv_bytes = 0;
+  pcb->at_rcv_time = sys_now();
+}
+
+void
+tcp_autotune_free_pcb(struct tcp_pcb *pcb)
+{
+  tcp_at_stats.granted -= (pcb->rcv_wnd_max - TCP_AUTOTUNE_WND_MIN) +
+                          (pcb->snd_buf_max - TCP_AUTOTUNE_SND_BUF_MIN);
+  pcb->rcv_wnd_max = TCP_AUTOTUNE_WND_MIN;
+  pcb->snd_buf_max = TCP_AUTOTUNE_SND_BUF_MIN;
+}
+
+/**
+ * Called by tcp_recved() before the window is reopened by 'len' bytes.
+ */
+void
+tcp_autotune_recved(struct tcp_pcb *pcb, u16_t len)
+{
+  u32_t now = sys_now();
+  u32_t interval;
+  tcpwnd_size_t limit, target, grow;
+
+  pcb->at_rcv_bytes += len;
+
+  /* pcb->sa is 8 times the smoothed RTT in slow timer ticks */
+  interval = LWIP_MAX(((u32_t)(pcb->sa >> 3) * TCP_SLOW_INTERVAL), TCP_AUTOTUNE_INTERVAL_MIN);
+  if ((u32_t)(now - pcb->at_rcv_time) < interval) {
+    return;
+  }
+
+  limit = TCP_AUTOTUNE_WND_LIMIT(pcb);
+  if ((pcb->at_rcv_bytes * 2 >= pcb->rcv_wnd_max) && (pcb->rcv_wnd_max < limit)) {
+    target = (tcpwnd_size_t)LWIP_MIN(pcb->at_rcv_bytes * 2, limit);
+    if (target > pcb->rcv_wnd_max) {
+      /* rcv_wnd_max - rcv_wnd is the data not yet taken by the application,
+         the extra space is available right away */
+      grow = tcp_autotune_take(target - pcb->rcv_wnd_max);
+      pcb->rcv_wnd_max += grow;
+      pcb->rcv_wnd += grow;
+    }
+  }
+  pcb->at_rcv_bytes = 0;
+  pcb->at_rcv_time = now;
+}
+
+/**
+ * Called on every ACK that freed send buffer space.
+ */
+void
+tcp_autotune_acked(struct tcp_pcb *pcb)
+{
+  tcpwnd_size_t in_use = pcb->snd_buf_max - pcb->snd_buf;
+  tcpwnd_size_t grow;
+
+  if ((pcb->snd_buf_max >= TCP_SND_BUF) ||
+      (in_use + 2 * pcb->mss < pcb->snd_buf_max) ||
+      (LWIP_MIN(pcb->cwnd, pcb->snd_wnd) <= pcb->snd_buf_max)) {
+    /* not buffer limited */
+    return;
+  }
+  grow = tcp_autotune_take((tcpwnd_size_t)LWIP_MIN(2 * TCP_MSS, TCP_SND_BUF - pcb->snd_buf_max));
+  pcb->snd_buf_max += grow;
+  pcb->snd_buf += grow;
+}
+
+static void
+tcp_autotune_shrink(struct tcp_pcb *pcb)
+{
+  tcpwnd_size_t excess, cut;
+
+  /* only window space not holding unread data can be given back, the
+     announced right edge is kept by tcp_update_rcv_ann_wnd() */
+  excess = LWIP_MIN(pcb->rcv_wnd_max - TCP_AUTOTUNE_WND_MIN, pcb->rcv_wnd);
+  if (excess) {
+    cut = LWIP_MAX(excess / 2, LWIP_MIN(excess, TCP_MSS));
+    pcb->rcv_wnd_max -= cut;
+    pcb->rcv_wnd -= cut;
+    tcp_at_stats.granted -= cut;
+  }
+
+  /* only the unused part of the send buffer can be given back */
+  excess = LWIP_MIN(pcb->snd_buf_max - TCP_AUTOTUNE_SND_BUF_MIN, pcb->snd_buf);
+  if (excess) {
+    cut = LWIP_MAX(excess / 2, LWIP_MIN(excess, TCP_MSS));
+    pcb->snd_buf_max -= cut;
+    pcb->snd_buf -= cut;
+    tcp_at_stats.granted -= cut;
+  }
+}
+
+/**
+ * Called from tcp_slowtmr(), gives memory back while the heap is short.
+ */
+void
+tcp_autotune_tmr(void)
+{
+  struct tcp_pcb *pcb;
+
+  if ((tcp_at_stats.granted == 0) || ((u32_t)TCP_AUTOTUNE_FREE_HEAP() >= TCP_AUTOTUNE_HEAP_RESERVE)) {
+    return;
+  }
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    tcp_autotune_shrink(pcb);
+  }
+  tcp_at_stats.shrink++;
+}
+
+const struct tcp_autotune_stats *
+tcp_autotune_stats(void)
+{
+  return &tcp_at_stats;
+}
+
+#endif /* LWIP_TCP && LWIP_TCP_AUTOTUNE */
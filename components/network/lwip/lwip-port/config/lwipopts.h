@@ -104,13 +104,36 @@ a lot of data that needs to be copied, this should be set high. */
 //#define TCP_MSS                 (1500 - 80)     /* TCP_MSS = (Ethernet MTU - IP header size - TCP header size) */
 #define TCP_MSS                 (800 - 40 - 80 + 8)   /* TCP_MSS = (Ethernet MTU - IP header size - TCP header size) */
 
+/* Grow the receive window and send buffer of busy connections from their
+   measured throughput, as long as the heap allows it. TCP_WND and
+   TCP_SND_BUF are then the per-connection ceilings. */
+#ifndef LWIP_TCP_AUTOTUNE
+#define LWIP_TCP_AUTOTUNE       1
+#endif
+
+#if LWIP_TCP_AUTOTUNE
+#define TCP_AUTOTUNE_WND_MIN        (3*TCP_MSS)
+#define TCP_AUTOTUNE_SND_BUF_MIN    (8*TCP_MSS)
+#define TCP_AUTOTUNE_HEAP_RESERVE   (24*1024)
+#define TCP_AUTOTUNE_FREE_HEAP()    xPortGetFreeHeapSize()
+#endif
+
 /* TCP sender buffer space (bytes). */
+#if LWIP_TCP_AUTOTUNE
+#define TCP_SND_BUF             (16*TCP_MSS)
+#else
 #define TCP_SND_BUF             (8*TCP_MSS)
+#endif
 
 /*  TCP_SND_QUEUELEN: TCP sender buffer space (pbufs). This must be at least
   as much as (2 * TCP_SND_BUF/TCP_MSS) for things to work. */
 #define TCP_SND_QUEUELEN        ((2 * (TCP_SND_BUF) + (TCP_MSS - 1))/(TCP_MSS))
 
+#if LWIP_TCP_AUTOTUNE && !defined(MEMP_NUM_TCP_SEG)
+/* enough segments for one connection at its largest send buffer */
+#define MEMP_NUM_TCP_SEG        TCP_SND_QUEUELEN
+#endif
+
 #if defined(WITH_COAP) && !WITH_COAP
 #define MEMP_NUM_TCPIP_MSG_INPKT        (32)
 #endif
@@ -120,16 +143,31 @@ a lot of data that needs to be copied, this should be set high. */
  * than TCP_SND_QUEUELEN. If the number of pbufs queued on a pcb drops below
  * this number, select returns writable (combined with TCP_SNDLOWAT).
  */
+#if LWIP_TCP_AUTOTUNE
+/* writable thresholds follow the smallest send buffer, so that a pcb that
+   never grows still becomes writable */
+#define TCP_SNDQUEUELOWAT               (((2 * (TCP_AUTOTUNE_SND_BUF_MIN) + (TCP_MSS - 1))/(TCP_MSS))/2)
+#define TCP_SNDLOWAT                    LWIP_MIN(LWIP_MAX(((TCP_AUTOTUNE_SND_BUF_MIN)/2), (2 * TCP_MSS) + 1), (TCP_AUTOTUNE_SND_BUF_MIN) - 1)
+#else
 #define TCP_SNDQUEUELOWAT               ((TCP_SND_QUEUELEN)/2)
+#endif
 
 /* TCP receive window. */
+#if LWIP_TCP_AUTOTUNE
+#define TCP_WND                 (16*TCP_MSS)
+#else
 #define TCP_WND                 (3*TCP_MSS)
+#endif
 
 /**
  * TCP_WND_UPDATE_THRESHOLD: difference in window to trigger an
  * explicit window update
  */
+#if LWIP_TCP_AUTOTUNE
+#define TCP_WND_UPDATE_THRESHOLD   LWIP_MIN((TCP_AUTOTUNE_WND_MIN / 2), (TCP_MSS * 6))
+#else
 #define TCP_WND_UPDATE_THRESHOLD   LWIP_MIN((TCP_WND / 2), (TCP_MSS * 6))
+#endif
 
 /**
  * By default, TCP socket/netconn close waits 20 seconds max to send the FIN
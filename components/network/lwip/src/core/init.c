@@ -133,6 +133,9 @@ PACK_STRUCT_END
 #error "MEMP_NUM_REASSDATA > IP_REASS_MAX_PBUFS doesn't make sense since each struct ip_reassdata must hold 2 pbufs at least!"
 #endif
 #endif /* !MEMP_MEM_MALLOC */
+#if LWIP_TCP && LWIP_TCP_AUTOTUNE && ((TCP_AUTOTUNE_WND_MIN > TCP_WND) || (TCP_AUTOTUNE_SND_BUF_MIN > TCP_SND_BUF))
+#error "TCP_AUTOTUNE_WND_MIN/TCP_AUTOTUNE_SND_BUF_MIN must not exceed TCP_WND/TCP_SND_BUF"
+#endif
 #if LWIP_WND_SCALE
 #if (LWIP_TCP && (TCP_WND > 0xffffffff))
 #error "If you want to use TCP, TCP_WND must fit in an u32_t, so, you have to reduce it in your lwipopts.h"
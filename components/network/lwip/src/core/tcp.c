@@ -212,6 +212,9 @@ tcp_free(struct tcp_pcb *pcb)
   LWIP_ASSERT("tcp_free: LISTEN", pcb->state != LISTEN);
 #if LWIP_TCP_PCB_NUM_EXT_ARGS
   tcp_ext_arg_invoke_callbacks_destroyed(pcb->ext_args);
+#endif
+#if LWIP_TCP_AUTOTUNE
+  tcp_autotune_free_pcb(pcb);
 #endif
   memp_free(MEMP_TCP_PCB, pcb);
 }
@@ -982,6 +985,10 @@ tcp_recved(struct tcp_pcb *pcb, u16_t len)
   LWIP_ASSERT("don't call tcp_recved for listen-pcbs",
               pcb->state != LISTEN);
 
+#if LWIP_TCP_AUTOTUNE
+  tcp_autotune_recved(pcb, len);
+#endif
+
   rcv_wnd = (tcpwnd_size_t)(pcb->rcv_wnd + len);
   if ((rcv_wnd > TCP_WND_MAX(pcb)) || (rcv_wnd < pcb->rcv_wnd)) {
     /* window got too big or tcpwnd_size_t overflow */
@@ -1153,7 +1160,11 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
   pcb->snd_lbb = iss - 1;
   /* Start with a window that does not need scaling. When window scaling is
      enabled and used, the window is enlarged when both sides agree on scaling. */
+#if LWIP_TCP_AUTOTUNE
+  pcb->rcv_wnd = pcb->rcv_ann_wnd = TCPWND_MIN16(pcb->rcv_wnd_max);
+#else
   pcb->rcv_wnd = pcb->rcv_ann_wnd = TCPWND_MIN16(TCP_WND);
+#endif
   pcb->rcv_ann_right_edge = pcb->rcv_nxt;
   pcb->snd_wnd = TCP_WND;
   /* As initial send MSS, we use TCP_MSS but limit it to 536.
@@ -1206,6 +1217,10 @@ tcp_slowtmr(void)
   ++tcp_ticks;
   ++tcp_timer_ctr;
 
+#if LWIP_TCP_AUTOTUNE
+  tcp_autotune_tmr();
+#endif
+
 tcp_slowtmr_start:
   /* Steps through all of the active PCBs. */
   prev = NULL;
@@ -1926,6 +1941,10 @@ tcp_alloc(u8_t prio)
     largest effective cwnd (amount of in-flight data) that the sender can have. */
     pcb->ssthresh = TCP_SND_BUF;
 
+#if LWIP_TCP_AUTOTUNE
+    tcp_autotune_init_pcb(pcb);
+#endif
+
 #if LWIP_CALLBACK_API
     pcb->recv = tcp_recv_null;
 #endif /* LWIP_CALLBACK_API */
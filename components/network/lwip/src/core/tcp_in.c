@@ -1320,6 +1320,9 @@ tcp_receive(struct tcp_pcb *pcb)
 #endif /* LWIP_IPV6 && LWIP_ND6_TCP_REACHABILITY_HINTS*/
 
       pcb->snd_buf = (tcpwnd_size_t)(pcb->snd_buf + recv_acked);
+#if LWIP_TCP_AUTOTUNE
+      tcp_autotune_acked(pcb);
+#endif
       /* check if this ACK ends our retransmission of in-flight data */
       if (pcb->flags & TF_RTO) {
         /* RTO is done if
@@ -1978,9 +1981,15 @@ tcp_parseopt(struct tcp_pcb *pcb)
             pcb->rcv_scale = TCP_RCV_SCALE;
             tcp_set_flags(pcb, TF_WND_SCALE);
             /* window scaling is enabled, we can use the full receive window */
+#if LWIP_TCP_AUTOTUNE
+            LWIP_ASSERT("window not at default value", pcb->rcv_wnd == TCPWND_MIN16(pcb->rcv_wnd_max));
+            LWIP_ASSERT("window not at default value", pcb->rcv_ann_wnd == TCPWND_MIN16(pcb->rcv_wnd_max));
+            pcb->rcv_wnd = pcb->rcv_ann_wnd = pcb->rcv_wnd_max;
+#else
             LWIP_ASSERT("window not at default value", pcb->rcv_wnd == TCPWND_MIN16(TCP_WND));
             LWIP_ASSERT("window not at default value", pcb->rcv_ann_wnd == TCPWND_MIN16(TCP_WND));
             pcb->rcv_wnd = pcb->rcv_ann_wnd = TCP_WND;
+#endif
           }
           break;
 #endif /* LWIP_WND_SCALE */
@@ -1394,8 +1394,11 @@ tcp_output(struct tcp_pcb *pcb)
           seg->next = (*cur_seg);
           (*cur_seg) = seg;
         } else {
-          /* add segment to tail of unacked list */
-          useg = seg;
+          /* add segment to tail of unacked list, linked from the old tail
+             as in upstream lwIP; the segments after it were lost otherwise */
+          LWIP_ASSERT("unacked tail", useg != NULL);
+          useg->next = seg;
+          useg = useg->next;
         }
       }
       /* do not queue empty segments on the unacked list */
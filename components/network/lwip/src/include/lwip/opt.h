@@ -1548,6 +1548,68 @@
 #define LWIP_TCP_PCB_NUM_EXT_ARGS       0
 #endif
 
+/**
+ * LWIP_TCP_AUTOTUNE==1: grow the receive window and the send buffer of each
+ * pcb from its measured throughput. Every pcb starts at TCP_AUTOTUNE_WND_MIN
+ * and TCP_AUTOTUNE_SND_BUF_MIN, TCP_WND and TCP_SND_BUF become the per-pcb
+ * ceilings. Growth is bounded by a global budget taken from
+ * TCP_AUTOTUNE_FREE_HEAP() and is given back when the heap runs low.
+ */
+#if !defined LWIP_TCP_AUTOTUNE || defined __DOXYGEN__
+#define LWIP_TCP_AUTOTUNE               0
+#endif
+
+/**
+ * TCP_AUTOTUNE_WND_MIN: initial (and smallest) autotuned receive window.
+ */
+#if !defined TCP_AUTOTUNE_WND_MIN || defined __DOXYGEN__
+#define TCP_AUTOTUNE_WND_MIN            TCP_WND
+#endif
+
+/**
+ * TCP_AUTOTUNE_SND_BUF_MIN: initial (and smallest) autotuned send buffer.
+ */
+#if !defined TCP_AUTOTUNE_SND_BUF_MIN || defined __DOXYGEN__
+#define TCP_AUTOTUNE_SND_BUF_MIN        TCP_SND_BUF
+#endif
+
+/**
+ * TCP_AUTOTUNE_HEAP_RESERVE: free heap (bytes) below which no window grows
+ * and grown windows are shrunk back.
+ */
+#if !defined TCP_AUTOTUNE_HEAP_RESERVE || defined __DOXYGEN__
+#define TCP_AUTOTUNE_HEAP_RESERVE       (16 * 1024)
+#endif
+
+/**
+ * TCP_AUTOTUNE_HEAP_SHARE: a single grow step may take at most
+ * 1/TCP_AUTOTUNE_HEAP_SHARE of the free heap above the reserve.
+ */
+#if !defined TCP_AUTOTUNE_HEAP_SHARE || defined __DOXYGEN__
+#define TCP_AUTOTUNE_HEAP_SHARE         4
+#endif
+
+/**
+ * TCP_AUTOTUNE_MEM_MAX: upper bound of the bytes granted above the minimum
+ * windows, summed over all pcbs.
+ */
+#if !defined TCP_AUTOTUNE_MEM_MAX || defined __DOXYGEN__
+#define TCP_AUTOTUNE_MEM_MAX            (MEMP_NUM_TCP_PCB * ((TCP_WND - TCP_AUTOTUNE_WND_MIN) + (TCP_SND_BUF - TCP_AUTOTUNE_SND_BUF_MIN)))
+#endif
+
+/**
+ * TCP_AUTOTUNE_INTERVAL_MIN: shortest measurement interval in milliseconds,
+ * the interval is otherwise the smoothed RTT of the pcb.
+ */
+#if !defined TCP_AUTOTUNE_INTERVAL_MIN || defined __DOXYGEN__
+#define TCP_AUTOTUNE_INTERVAL_MIN       50
+#endif
+
+/**
+ * TCP_AUTOTUNE_FREE_HEAP(): returns the free bytes of the heap the windows
+ * are allocated from, must be defined by the port when LWIP_TCP_AUTOTUNE==1.
+ */
+
 /** LWIP_ALTCP==1: enable the altcp API.
  * altcp is an abstraction layer that prevents applications linking against the
  * tcp.h functions but provides the same functionality. It is used to e.g. add
@@ -510,6 +510,24 @@ void tcp_netif_ip_addr_changed(const ip_addr_t* old_addr, const ip_addr_t* new_a
 void tcp_free_ooseq(struct tcp_pcb *pcb);
 #endif
 
+#if LWIP_TCP_AUTOTUNE
+/** Autotuning counters, see tcp_autotune_stats() */
+struct tcp_autotune_stats {
+  u32_t granted;       /* bytes currently granted above the minimum windows */
+  u32_t granted_peak;
+  u32_t grow;          /* number of grow steps */
+  u32_t shrink;        /* number of shrink steps under memory pressure */
+  u32_t denied;        /* grow steps refused by the budget */
+};
+
+void tcp_autotune_init_pcb(struct tcp_pcb *pcb);
+void tcp_autotune_free_pcb(struct tcp_pcb *pcb);
+void tcp_autotune_recved(struct tcp_pcb *pcb, u16_t len);
+void tcp_autotune_acked(struct tcp_pcb *pcb);
+void tcp_autotune_tmr(void);
+const struct tcp_autotune_stats *tcp_autotune_stats(void);
+#endif /* LWIP_TCP_AUTOTUNE */
+
 #if LWIP_TCP_PCB_NUM_EXT_ARGS
 err_t tcp_ext_arg_invoke_callbacks_passive_open(struct tcp_pcb_listen *lpcb, struct tcp_pcb *cpcb);
 #endif
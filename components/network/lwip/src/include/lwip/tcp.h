@@ -144,6 +144,14 @@ typedef err_t (*tcp_connected_fn)(void *arg, struct tcp_pcb *tpcb, err_t err);
 #define TCPWND16(x)             (x)
 #define TCP_WND_MAX(pcb)        TCP_WND
 #endif
+#if LWIP_TCP_AUTOTUNE
+#undef TCP_WND_MAX
+#if LWIP_WND_SCALE
+#define TCP_WND_MAX(pcb)        ((tcpwnd_size_t)(((pcb)->flags & TF_WND_SCALE) ? (pcb)->rcv_wnd_max : TCPWND16((pcb)->rcv_wnd_max)))
+#else
+#define TCP_WND_MAX(pcb)        ((pcb)->rcv_wnd_max)
+#endif
+#endif
 /* Increments a tcpwnd_size_t and holds at max value rather than rollover */
 #define TCP_WND_INC(wnd, inc)   do { \
                                   if ((tcpwnd_size_t)(wnd + inc) >= wnd) { \
@@ -285,6 +293,15 @@ struct tcp_pcb {
   tcpwnd_size_t rcv_ann_wnd; /* receiver window to announce */
   u32_t rcv_ann_right_edge; /* announced right edge of window */
 
+#if LWIP_TCP_AUTOTUNE
+  /* autotuned window and send buffer limits */
+  tcpwnd_size_t rcv_wnd_max;
+  tcpwnd_size_t snd_buf_max;
+  /* bytes consumed by the application since at_rcv_time */
+  u32_t at_rcv_bytes;
+  u32_t at_rcv_time;
+#endif /* LWIP_TCP_AUTOTUNE */
+
 #if LWIP_TCP_SACK_OUT
   /* SACK ranges to include in ACK packets (entry is invalid if left==right) */
   struct tcp_sack_range rcv_sacks[LWIP_TCP_MAX_SACK_NUM];
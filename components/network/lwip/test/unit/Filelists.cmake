@@ -15,6 +15,7 @@ endif()
 set(LWIP_TESTDIR ${LWIP_DIR}/test/unit)
 set(LWIP_TESTFILES
 	${LWIP_TESTDIR}/lwip_unittests.c
+	${LWIP_DIR}/lwip-port/FreeRTOS/tcp_autotune.c
 	${LWIP_TESTDIR}/api/test_sockets.c
 	${LWIP_TESTDIR}/arch/sys_arch.c
 	${LWIP_TESTDIR}/core/test_def.c
@@ -33,6 +34,7 @@ set(LWIP_TESTFILES
 	${LWIP_TESTDIR}/tcp/test_tcp_oos.c
 	${LWIP_TESTDIR}/tcp/test_tcp_state.c
 	${LWIP_TESTDIR}/tcp/test_tcp.c
+	${LWIP_TESTDIR}/tcp/test_tcp_autotune.c
 	${LWIP_TESTDIR}/udp/test_udp.c
 	${LWIP_TESTDIR}/ppp/test_pppos.c
 )
@@ -66,6 +66,17 @@
 #define TCP_WND                         (10 * TCP_MSS)
 #define LWIP_WND_SCALE                  1
 #define TCP_RCV_SCALE                   0
+
+/* TCP autotuning starts every pcb with a smaller window than the other TCP
+   tests expect, so it is tested in a build of its own (see check/Makefile) */
+#ifdef LWIP_TEST_TCP_AUTOTUNE
+#define LWIP_TCP_AUTOTUNE               1
+#define TCP_AUTOTUNE_WND_MIN            (3 * TCP_MSS)
+#define TCP_AUTOTUNE_SND_BUF_MIN        (4 * TCP_MSS)
+#define TCP_AUTOTUNE_HEAP_RESERVE       (16 * 1024)
+unsigned int test_tcp_autotune_free_heap(void);
+#define TCP_AUTOTUNE_FREE_HEAP()        test_tcp_autotune_free_heap()
+#endif
 #define PBUF_POOL_SIZE                  400 /* pbuf tests need ~200KByte */
 
 /* Enable IGMP and MDNS for MDNS tests */
@@ -0,0 +1,431 @@
+#include "test_tcp_autotune.h"
+
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/stats.h"
+#include "tcp_helper.h"
+#include "arch/sys_arch.h"
+
+#if !LWIP_STATS || !TCP_STATS || !MEMP_STATS
+#error "This tests needs TCP- and MEMP-statistics enabled"
+#endif
+
+/* Setups/teardown functions */
+static struct netif *old_netif_list;
+static struct netif *old_netif_default;
+
+#if LWIP_TCP_AUTOTUNE
+#if (TCP_AUTOTUNE_WND_MIN != 3 * TCP_MSS) || (TCP_AUTOTUNE_SND_BUF_MIN != 4 * TCP_MSS) || (TCP_WND != 10 * TCP_MSS)
+#error "This tests needs the autotune sizes of test/unit/lwipopts.h"
+#endif
+
+static u8_t test_data[TCP_SND_BUF];
+static u32_t test_free_heap;
+
+/* TCP_AUTOTUNE_FREE_HEAP() of the tests */
+unsigned int
+test_tcp_autotune_free_heap(void)
+{
+  return test_free_heap;
+}
+
+/* plenty of heap, growth is only limited by TCP_WND/TCP_SND_BUF */
+#define TEST_HEAP_PLENTY  (TCP_AUTOTUNE_HEAP_RESERVE + 1024 * 1024)
+#endif /* LWIP_TCP_AUTOTUNE */
+
+static void
+tcp_autotune_setup(void)
+{
+  old_netif_list = netif_list;
+  old_netif_default = netif_default;
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+#if LWIP_TCP_AUTOTUNE
+  test_free_heap = TEST_HEAP_PLENTY;
+#endif
+  lwip_sys_now = 1000;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+tcp_autotune_teardown(void)
+{
+  netif_list = NULL;
+  netif_default = NULL;
+  tcp_remove_all();
+  /* restore netif_list for next tests (e.g. loopif) */
+  netif_list = old_netif_list;
+  netif_default = old_netif_default;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+#if LWIP_TCP_AUTOTUNE
+static struct tcp_pcb *
+test_tcp_autotune_pcb(struct netif *netif, struct test_tcp_txcounters *txcounters,
+                      struct test_tcp_counters *counters)
+{
+  struct tcp_pcb *pcb;
+
+  test_tcp_init_netif(netif, txcounters, &test_local_ip, &test_netmask);
+  memset(counters, 0, sizeof(*counters));
+  pcb = test_tcp_new_counters_pcb(counters);
+  if (pcb != NULL) {
+    tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  }
+  return pcb;
+}
+
+/* the peer sends full segments, the application takes 'taken' bytes of them */
+static void
+test_tcp_autotune_rx(struct tcp_pcb *pcb, struct netif *netif, int segments, u16_t taken)
+{
+  struct pbuf *p;
+  int i;
+
+  for (i = 0; i < segments; i++) {
+    p = tcp_create_rx_segment(pcb, test_data, TCP_MSS, 0, 0, TCP_ACK);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, netif);
+  }
+  if (taken) {
+    tcp_recved(pcb, taken);
+  }
+}
+
+/* Test functions */
+
+/** A new pcb starts at the minimum sizes and gives nothing back when freed */
+START_TEST(test_tcp_autotune_init)
+{
+  struct tcp_pcb *pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = tcp_new();
+  EXPECT_RET(pcb != NULL);
+  EXPECT(pcb->rcv_wnd_max == TCP_AUTOTUNE_WND_MIN);
+  EXPECT(pcb->rcv_wnd == TCP_AUTOTUNE_WND_MIN);
+  EXPECT(pcb->rcv_ann_wnd == TCP_AUTOTUNE_WND_MIN);
+  EXPECT(pcb->snd_buf_max == TCP_AUTOTUNE_SND_BUF_MIN);
+  EXPECT(tcp_sndbuf(pcb) == TCP_AUTOTUNE_SND_BUF_MIN);
+  EXPECT(TCP_WND_MAX(pcb) == TCP_AUTOTUNE_WND_MIN);
+  tcp_abort(pcb);
+  EXPECT(tcp_autotune_stats()->granted == 0);
+}
+END_TEST
+
+/** The receive window doubles when the application keeps up, up to TCP_WND */
+START_TEST(test_tcp_autotune_rcv_grow)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  u32_t grow = tcp_autotune_stats()->grow;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_autotune_pcb(&netif, &txcounters, &counters);
+  EXPECT_RET(pcb != NULL);
+
+  /* a full window taken at once, but within one interval: no decision yet */
+  test_tcp_autotune_rx(pcb, &netif, 3, 3 * TCP_MSS);
+  EXPECT(counters.recved_bytes == 3 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd_max == TCP_AUTOTUNE_WND_MIN);
+
+  /* 4 segments taken in the interval, the window becomes 8 */
+  lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+  test_tcp_autotune_rx(pcb, &netif, 1, TCP_MSS);
+  EXPECT(pcb->rcv_wnd_max == 8 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd == 8 * TCP_MSS);
+  EXPECT(pcb->rcv_ann_wnd == 8 * TCP_MSS);
+  EXPECT(tcp_autotune_stats()->grow == grow + 1);
+  EXPECT(tcp_autotune_stats()->granted == 5 * TCP_MSS);
+
+  /* the peer can use the larger window right away */
+  test_tcp_autotune_rx(pcb, &netif, 8, 0);
+  EXPECT(counters.recved_bytes == 12 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd == 0);
+
+  /* 8 segments taken, 16 would be next but TCP_WND is the ceiling */
+  lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+  tcp_recved(pcb, 8 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd_max == TCP_WND);
+  EXPECT(pcb->rcv_wnd == TCP_WND);
+  EXPECT(TCP_WND_MAX(pcb) == TCP_WND);
+  EXPECT(tcp_autotune_stats()->granted == TCP_WND - TCP_AUTOTUNE_WND_MIN);
+
+  /* and it stays there */
+  lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+  test_tcp_autotune_rx(pcb, &netif, 10, 10 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd_max == TCP_WND);
+  EXPECT(pcb->rcv_wnd == TCP_WND);
+  EXPECT(tcp_autotune_stats()->grow == grow + 2);
+
+  /* everything granted is given back with the pcb */
+  tcp_abort(pcb);
+  EXPECT(tcp_autotune_stats()->granted == 0);
+}
+END_TEST
+
+/** An application that takes less than half the window does not grow it */
+START_TEST(test_tcp_autotune_rcv_slow_reader)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_autotune_pcb(&netif, &txcounters, &counters);
+  EXPECT_RET(pcb != NULL);
+
+  for (i = 0; i < 10; i++) {
+    lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+    test_tcp_autotune_rx(pcb, &netif, 1, TCP_MSS);
+    EXPECT(pcb->rcv_wnd_max == TCP_AUTOTUNE_WND_MIN);
+  }
+  EXPECT(tcp_autotune_stats()->granted == 0);
+  tcp_abort(pcb);
+}
+END_TEST
+
+/** Growth is refused or cut to whole segments by the heap budget */
+START_TEST(test_tcp_autotune_rcv_budget)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  u32_t denied = tcp_autotune_stats()->denied;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_autotune_pcb(&netif, &txcounters, &counters);
+  EXPECT_RET(pcb != NULL);
+
+  /* a quarter of the heap above the reserve is a bit more than 2 segments */
+  test_free_heap = TCP_AUTOTUNE_HEAP_RESERVE + TCP_AUTOTUNE_HEAP_SHARE * (2 * TCP_MSS + 100);
+  lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+  test_tcp_autotune_rx(pcb, &netif, 3, 3 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd_max == 5 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd == 5 * TCP_MSS);
+  EXPECT(tcp_autotune_stats()->granted == 2 * TCP_MSS);
+
+  /* less than a segment left: refused */
+  test_free_heap = TCP_AUTOTUNE_HEAP_RESERVE + TCP_AUTOTUNE_HEAP_SHARE * (TCP_MSS - 1);
+  lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+  test_tcp_autotune_rx(pcb, &netif, 5, 5 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd_max == 5 * TCP_MSS);
+  EXPECT(tcp_autotune_stats()->denied == denied + 1);
+
+  /* below the reserve: refused */
+  test_free_heap = TCP_AUTOTUNE_HEAP_RESERVE - 1;
+  lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+  test_tcp_autotune_rx(pcb, &netif, 5, 5 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd_max == 5 * TCP_MSS);
+  EXPECT(tcp_autotune_stats()->denied == denied + 2);
+
+  tcp_abort(pcb);
+  EXPECT(tcp_autotune_stats()->granted == 0);
+}
+END_TEST
+
+/** Below the heap reserve the slow timer shrinks the window back to the
+ * minimum, without dropping unread data or retracting the announced edge */
+START_TEST(test_tcp_autotune_rcv_shrink)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  u32_t shrink = tcp_autotune_stats()->shrink;
+  u32_t right_edge;
+  tcpwnd_size_t last;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_autotune_pcb(&netif, &txcounters, &counters);
+  EXPECT_RET(pcb != NULL);
+
+  /* grow to TCP_WND */
+  lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+  test_tcp_autotune_rx(pcb, &netif, 3, 3 * TCP_MSS);
+  lwip_sys_now += TCP_AUTOTUNE_INTERVAL_MIN;
+  test_tcp_autotune_rx(pcb, &netif, 6, 6 * TCP_MSS);
+  EXPECT_RET(pcb->rcv_wnd_max == TCP_WND);
+
+  /* two segments the application has not taken yet */
+  test_tcp_autotune_rx(pcb, &netif, 2, 0);
+  EXPECT(pcb->rcv_wnd == TCP_WND - 2 * TCP_MSS);
+  right_edge = pcb->rcv_ann_right_edge;
+
+  /* the heap recovered before the timer ran: nothing to do */
+  tcp_slowtmr();
+  EXPECT(pcb->rcv_wnd_max == TCP_WND);
+  EXPECT(tcp_autotune_stats()->shrink == shrink);
+
+  test_free_heap = TCP_AUTOTUNE_HEAP_RESERVE - 1;
+  last = pcb->rcv_wnd_max;
+  for (i = 0; i < 10; i++) {
+    tcp_slowtmr();
+    EXPECT(pcb->rcv_wnd_max >= TCP_AUTOTUNE_WND_MIN);
+    EXPECT(pcb->rcv_wnd_max < last || last == TCP_AUTOTUNE_WND_MIN);
+    EXPECT(pcb->rcv_wnd_max - pcb->rcv_wnd == 2 * TCP_MSS);
+    EXPECT(pcb->rcv_ann_right_edge == right_edge);
+    EXPECT(tcp_autotune_stats()->granted == pcb->rcv_wnd_max - TCP_AUTOTUNE_WND_MIN);
+    last = pcb->rcv_wnd_max;
+  }
+  EXPECT(pcb->rcv_wnd_max == TCP_AUTOTUNE_WND_MIN);
+  EXPECT(tcp_autotune_stats()->shrink > shrink);
+
+  /* the unread data can still be taken */
+  tcp_recved(pcb, 2 * TCP_MSS);
+  EXPECT(pcb->rcv_wnd == TCP_AUTOTUNE_WND_MIN);
+  tcp_abort(pcb);
+  EXPECT(tcp_autotune_stats()->granted == 0);
+}
+END_TEST
+
+/* fill the send buffer, then the peer acks one segment with window 'wnd' */
+static void
+test_tcp_autotune_tx_round(struct tcp_pcb *pcb, struct netif *netif, u16_t wnd)
+{
+  struct pbuf *p;
+  u16_t len = tcp_sndbuf(pcb);
+  err_t err;
+
+  if (len) {
+    err = tcp_write(pcb, test_data, len, TCP_WRITE_FLAG_COPY);
+    EXPECT_RET(err == ERR_OK);
+  }
+  /* no congestion window limit */
+  pcb->cwnd = 2 * TCP_SND_BUF;
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  p = tcp_create_rx_segment_wnd(pcb, NULL, 0, 0, TCP_MSS, TCP_ACK, wnd);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, netif);
+}
+
+/** A full send buffer grows by two segments per ACK, up to TCP_SND_BUF */
+START_TEST(test_tcp_autotune_snd_grow)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  tcpwnd_size_t last = TCP_AUTOTUNE_SND_BUF_MIN;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_autotune_pcb(&netif, &txcounters, &counters);
+  EXPECT_RET(pcb != NULL);
+
+  for (i = 0; i < 10; i++) {
+    test_tcp_autotune_tx_round(pcb, &netif, 0xffff);
+    EXPECT(pcb->snd_buf_max == LWIP_MIN(last + 2 * TCP_MSS, TCP_SND_BUF));
+    /* what is not acked yet is still charged to the buffer */
+    EXPECT(pcb->snd_buf_max - pcb->snd_buf == pcb->snd_lbb - pcb->lastack);
+    last = pcb->snd_buf_max;
+  }
+  EXPECT(pcb->snd_buf_max == TCP_SND_BUF);
+  EXPECT(tcp_autotune_stats()->granted == TCP_SND_BUF - TCP_AUTOTUNE_SND_BUF_MIN);
+
+  tcp_abort(pcb);
+  EXPECT(tcp_autotune_stats()->granted == 0);
+}
+END_TEST
+
+/** A send buffer larger than the peer's window would not help */
+START_TEST(test_tcp_autotune_snd_peer_limited)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_autotune_pcb(&netif, &txcounters, &counters);
+  EXPECT_RET(pcb != NULL);
+
+  for (i = 0; i < 5; i++) {
+    test_tcp_autotune_tx_round(pcb, &netif, 3 * TCP_MSS);
+    EXPECT(pcb->snd_buf_max == TCP_AUTOTUNE_SND_BUF_MIN);
+  }
+  EXPECT(tcp_autotune_stats()->granted == 0);
+
+  tcp_abort(pcb);
+}
+END_TEST
+
+/** Under memory pressure only the unused part of the send buffer goes back */
+START_TEST(test_tcp_autotune_snd_shrink)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = test_tcp_autotune_pcb(&netif, &txcounters, &counters);
+  EXPECT_RET(pcb != NULL);
+
+  for (i = 0; i < 4; i++) {
+    test_tcp_autotune_tx_round(pcb, &netif, 0xffff);
+  }
+  EXPECT_RET(pcb->snd_buf_max == TCP_SND_BUF);
+
+  test_free_heap = TCP_AUTOTUNE_HEAP_RESERVE - 1;
+  for (i = 0; i < 10; i++) {
+    tcp_slowtmr();
+    EXPECT(pcb->snd_buf_max >= TCP_AUTOTUNE_SND_BUF_MIN);
+    EXPECT(pcb->snd_buf_max - pcb->snd_buf == pcb->snd_lbb - pcb->lastack);
+  }
+  /* the data in flight keeps its space */
+  EXPECT(pcb->snd_buf_max == LWIP_MAX(TCP_AUTOTUNE_SND_BUF_MIN, pcb->snd_lbb - pcb->lastack));
+  EXPECT(tcp_autotune_stats()->granted == pcb->snd_buf_max - TCP_AUTOTUNE_SND_BUF_MIN);
+
+  tcp_abort(pcb);
+  EXPECT(tcp_autotune_stats()->granted == 0);
+}
+END_TEST
+
+#else /* LWIP_TCP_AUTOTUNE */
+
+/** Without autotuning every pcb has the fixed sizes */
+START_TEST(test_tcp_autotune_off)
+{
+  struct tcp_pcb *pcb;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = tcp_new();
+  EXPECT_RET(pcb != NULL);
+  EXPECT(pcb->rcv_wnd == TCPWND_MIN16(TCP_WND));
+  EXPECT(tcp_sndbuf(pcb) == TCPWND16(TCP_SND_BUF));
+  tcp_abort(pcb);
+}
+END_TEST
+
+#endif /* LWIP_TCP_AUTOTUNE */
+
+/** Create the suite including all tests for this module */
+Suite *
+tcp_autotune_suite(void)
+{
+  testfunc tests[] = {
+#if LWIP_TCP_AUTOTUNE
+    TESTFUNC(test_tcp_autotune_init),
+    TESTFUNC(test_tcp_autotune_rcv_grow),
+    TESTFUNC(test_tcp_autotune_rcv_slow_reader),
+    TESTFUNC(test_tcp_autotune_rcv_budget),
+    TESTFUNC(test_tcp_autotune_rcv_shrink),
+    TESTFUNC(test_tcp_autotune_snd_grow),
+    TESTFUNC(test_tcp_autotune_snd_peer_limited),
+    TESTFUNC(test_tcp_autotune_snd_shrink)
+#else
+    TESTFUNC(test_tcp_autotune_off)
+#endif
+  };
+  return create_suite("TCP_AUTOTUNE", tests, sizeof(tests)/sizeof(testfunc), tcp_autotune_setup, tcp_autotune_teardown);
+}
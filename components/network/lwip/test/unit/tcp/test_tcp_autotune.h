@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_TCP_AUTOTUNE_H
+#define LWIP_HDR_TEST_TCP_AUTOTUNE_H
+
+#include "../lwip_check.h"
+
+Suite *tcp_autotune_suite(void);
+
+#endif
@@ -7,11 +7,14 @@ COMPONENT_ADD_INCLUDEDIRS += .
 COMPONENT_PRIV_INCLUDEDIRS :=
 
 ## This component's src
-COMPONENT_SRCS := dhcp_server_raw.c
+COMPONENT_SRCS := dhcp_server_raw.c dhcp_lease.c
 COMPONENT_OBJS := $(patsubst %.c,%.o, $(COMPONENT_SRCS))
 
 COMPONENT_SRCDIRS := .
 
 
 ##
-#CPPFLAGS +=
\ No newline at end of file
+#CPPFLAGS +=
+ifeq ($(CONFIG_DHCPD_LEASE_PERSIST),1)
+CPPFLAGS += -DDHCPD_LEASE_PERSIST
+endif
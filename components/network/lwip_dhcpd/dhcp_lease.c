@@ -0,0 +1,434 @@
+
+/**
+ ****************************************************************************************
+ *
+ * @file dhcp_lease.c
+ * Copyright (C) Bouffalo Lab 2016-2018
+ *
+ ****************************************************************************************
+ */
+
+
+#include <string.h>
+#include <stdint.h>
+#include <FreeRTOS.h>
+
+#include "dhcp_lease.h"
+
+#ifdef DHCPD_LEASE_PERSIST
+#include <easyflash.h>
+#endif
+
+#define LEASE_MAP_WORDS(count)      (((count) + 31) / 32)
+
+static u32_t dhcp_lease_hash(const u8_t *chaddr)
+{
+    /* the NIC specific part of the MAC is well distributed */
+    return (chaddr[3] ^ chaddr[4] ^ (chaddr[5] << 1) ^ (chaddr[5] >> 3)) & (DHCPD_LEASE_HASH_SIZE - 1);
+}
+
+static dhcp_lease_idx_t *dhcp_lease_list_head(struct dhcp_lease_table *table, struct dhcp_lease *lease)
+{
+    if (lease->state == DHCP_LEASE_EXPIRED) {
+        return &table->expired_head;
+    }
+    return &table->wheel[lease->lease_end % DHCPD_LEASE_WHEEL_SLOTS];
+}
+
+static void dhcp_lease_list_unlink(struct dhcp_lease_table *table, dhcp_lease_idx_t idx)
+{
+    struct dhcp_lease *lease = &table->leases[idx];
+    dhcp_lease_idx_t *head = dhcp_lease_list_head(table, lease);
+
+    if (lease->prev != DHCP_LEASE_NIL) {
+        table->leases[lease->prev].next = lease->next;
+    } else {
+        *head = lease->next;
+    }
+    if (lease->next != DHCP_LEASE_NIL) {
+        table->leases[lease->next].prev = lease->prev;
+    } else if (lease->state == DHCP_LEASE_EXPIRED) {
+        table->expired_tail = lease->prev;
+    }
+    lease->next = lease->prev = DHCP_LEASE_NIL;
+}
+
+static void dhcp_lease_list_link(struct dhcp_lease_table *table, dhcp_lease_idx_t idx)
+{
+    struct dhcp_lease *lease = &table->leases[idx];
+
+    if (lease->state == DHCP_LEASE_EXPIRED) {
+        /* append, the head is always the oldest expired lease */
+        lease->next = DHCP_LEASE_NIL;
+        lease->prev = table->expired_tail;
+        if (table->expired_tail != DHCP_LEASE_NIL) {
+            table->leases[table->expired_tail].next = idx;
+        } else {
+            table->expired_head = idx;
+        }
+        table->expired_tail = idx;
+    } else {
+        dhcp_lease_idx_t *head = dhcp_lease_list_head(table, lease);
+
+        lease->prev = DHCP_LEASE_NIL;
+        lease->next = *head;
+        if (*head != DHCP_LEASE_NIL) {
+            table->leases[*head].prev = idx;
+        }
+        *head = idx;
+    }
+}
+
+static void dhcp_lease_hash_unlink(struct dhcp_lease_table *table, dhcp_lease_idx_t idx)
+{
+    dhcp_lease_idx_t *pos = &table->hash[dhcp_lease_hash(table->leases[idx].chaddr)];
+
+    while (*pos != DHCP_LEASE_NIL) {
+        if (*pos == idx) {
+            *pos = table->leases[idx].hash_next;
+            break;
+        }
+        pos = &table->leases[*pos].hash_next;
+    }
+    table->leases[idx].hash_next = DHCP_LEASE_NIL;
+}
+
+static void dhcp_lease_free_map_set(struct dhcp_lease_table *table, int idx, int free)
+{
+    if (free) {
+        table->free_map[idx / 32] |= (1UL << (idx % 32));
+    } else {
+        table->free_map[idx / 32] &= ~(1UL << (idx % 32));
+    }
+}
+
+static int dhcp_lease_free_map_first(struct dhcp_lease_table *table)
+{
+    int i;
+
+    for (i = 0; i < LEASE_MAP_WORDS(table->count); i++) {
+        if (table->free_map[i]) {
+            return i * 32 + __builtin_ctz(table->free_map[i]);
+        }
+    }
+    return -1;
+}
+
+/* drop a lease back to the never-used state */
+static void dhcp_lease_clear(struct dhcp_lease_table *table, int idx)
+{
+    struct dhcp_lease *lease = &table->leases[idx];
+
+    if (lease->state == DHCP_LEASE_FREE) {
+        return;
+    }
+    dhcp_lease_list_unlink(table, idx);
+    dhcp_lease_hash_unlink(table, idx);
+    lease->state = DHCP_LEASE_FREE;
+    dhcp_lease_free_map_set(table, idx, 1);
+    table->used--;
+    table->dirty = 1;
+}
+
+/**
+* Initialize the lease table for the pool [start, end]
+*
+* @param table The lease table
+* @param start First address of the pool, host order
+* @param end Last address of the pool, host order
+* @return 0 on success, -1 on bad range or out of memory
+*/
+int dhcp_lease_table_init(struct dhcp_lease_table *table, u32_t start, u32_t end)
+{
+    u32_t count;
+    int i;
+
+    memset(table, 0, sizeof(*table));
+    if (end < start || (end - start + 1) > DHCP_LEASE_MAX) {
+        return -1;
+    }
+    count = end - start + 1;
+
+    table->leases = (struct dhcp_lease *)pvPortMalloc(count * sizeof(struct dhcp_lease));
+    table->free_map = (u32_t *)pvPortMalloc(LEASE_MAP_WORDS(count) * sizeof(u32_t));
+    if (NULL == table->leases || NULL == table->free_map) {
+        dhcp_lease_table_deinit(table);
+        return -1;
+    }
+    table->start = start;
+    table->count = count;
+
+    memset(table->leases, 0, count * sizeof(struct dhcp_lease));
+    memset(table->free_map, 0, LEASE_MAP_WORDS(count) * sizeof(u32_t));
+    for (i = 0; i < count; i++) {
+        table->leases[i].hash_next = DHCP_LEASE_NIL;
+        table->leases[i].next = DHCP_LEASE_NIL;
+        table->leases[i].prev = DHCP_LEASE_NIL;
+        dhcp_lease_free_map_set(table, i, 1);
+    }
+    memset(table->hash, DHCP_LEASE_NIL, sizeof(table->hash));
+    memset(table->wheel, DHCP_LEASE_NIL, sizeof(table->wheel));
+    table->expired_head = DHCP_LEASE_NIL;
+    table->expired_tail = DHCP_LEASE_NIL;
+
+    return 0;
+}
+
+void dhcp_lease_table_deinit(struct dhcp_lease_table *table)
+{
+    if (table->leases) {
+        vPortFree(table->leases);
+    }
+    if (table->free_map) {
+        vPortFree(table->free_map);
+    }
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+* Find a lease by mac address
+*
+* @return lease index, -1 if not found
+*/
+int dhcp_lease_find_by_mac(struct dhcp_lease_table *table, const u8_t *chaddr)
+{
+    dhcp_lease_idx_t idx;
+
+    for (idx = table->hash[dhcp_lease_hash(chaddr)]; idx != DHCP_LEASE_NIL; idx = table->leases[idx].hash_next) {
+        if (0 == memcmp(table->leases[idx].chaddr, chaddr, DHCP_LEASE_HLEN)) {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+/**
+* Find a lease by ip address
+*
+* @param ipaddr Address in host order
+* @return lease index, -1 if the address is out of pool or not leased
+*/
+int dhcp_lease_find_by_ip(struct dhcp_lease_table *table, u32_t ipaddr)
+{
+    u32_t idx = ipaddr - table->start;
+
+    if (ipaddr < table->start || idx >= table->count || table->leases[idx].state == DHCP_LEASE_FREE) {
+        return -1;
+    }
+    return idx;
+}
+
+/**
+* Pick a lease for a client. The order of preference is the lease already
+* held by this mac, the requested address when it is not held by anyone else,
+* the lowest never-used address and finally the oldest expired lease.
+*
+* @param requested Requested address in host order, 0 if none
+* @return lease index, -1 if the pool is exhausted
+*/
+int dhcp_lease_alloc(struct dhcp_lease_table *table, const u8_t *chaddr, u32_t requested)
+{
+    u32_t off = requested - table->start;
+    int idx;
+
+    idx = dhcp_lease_find_by_mac(table, chaddr);
+    if (idx >= 0) {
+        return idx;
+    }
+
+    /* wraps for addresses below the pool, so one compare covers both ends */
+    if (off < (u32_t)table->count) {
+        if (table->leases[off].state == DHCP_LEASE_FREE) {
+            return off;
+        }
+        if (table->leases[off].state == DHCP_LEASE_EXPIRED) {
+            dhcp_lease_clear(table, off);
+            return off;
+        }
+    }
+
+    idx = dhcp_lease_free_map_first(table);
+    if (idx >= 0) {
+        return idx;
+    }
+
+    if (table->expired_head != DHCP_LEASE_NIL) {
+        idx = table->expired_head;
+        dhcp_lease_clear(table, idx);
+        return idx;
+    }
+
+    return -1;
+}
+
+/**
+* Bind a lease to a mac and (re)arm its expiry
+*
+* @param state DHCP_LEASE_OFFERED or DHCP_LEASE_BOUND
+* @param duration Lease time in seconds
+*/
+void dhcp_lease_set(struct dhcp_lease_table *table, int idx, const u8_t *chaddr, u8_t state, u32_t duration)
+{
+    struct dhcp_lease *lease = &table->leases[idx];
+    u32_t bucket;
+
+    if (lease->state == DHCP_LEASE_FREE) {
+        memcpy(lease->chaddr, chaddr, DHCP_LEASE_HLEN);
+        bucket = dhcp_lease_hash(chaddr);
+        lease->hash_next = table->hash[bucket];
+        table->hash[bucket] = idx;
+        dhcp_lease_free_map_set(table, idx, 0);
+        table->used++;
+        table->dirty = 1;
+    } else {
+        dhcp_lease_list_unlink(table, idx);
+    }
+
+    lease->state = state;
+    /* round up so a lease never expires early, and always lands in a future slot */
+    lease->lease_end = table->now + 1 + (duration + DHCPD_LEASE_WHEEL_TICK_S - 1) / DHCPD_LEASE_WHEEL_TICK_S;
+    dhcp_lease_list_link(table, idx);
+}
+
+/**
+* Release a lease, the address returns to the never-used pool
+*/
+void dhcp_lease_release(struct dhcp_lease_table *table, int idx)
+{
+    dhcp_lease_clear(table, idx);
+}
+
+/**
+* Advance the expiry wheel by one tick, called every DHCPD_LEASE_WHEEL_TICK_S.
+* Only the leases hashed to the current slot are visited.
+*/
+void dhcp_lease_tick(struct dhcp_lease_table *table)
+{
+    dhcp_lease_idx_t idx, next;
+    struct dhcp_lease *lease;
+
+    table->now++;
+    for (idx = table->wheel[table->now % DHCPD_LEASE_WHEEL_SLOTS]; idx != DHCP_LEASE_NIL; idx = next) {
+        lease = &table->leases[idx];
+        next = lease->next;
+        if ((s32_t)(table->now - lease->lease_end) >= 0) {
+            dhcp_lease_list_unlink(table, idx);
+            lease->state = DHCP_LEASE_EXPIRED;
+            dhcp_lease_list_link(table, idx);
+        }
+    }
+}
+
+#ifdef DHCPD_LEASE_PERSIST
+#define DHCP_LEASE_RECORD_VERSION   1
+
+struct dhcp_lease_record
+{
+    u8_t chaddr[DHCP_LEASE_HLEN];
+    u8_t offset;
+    u8_t reserved;
+};
+
+struct dhcp_lease_record_hdr
+{
+    u8_t version;
+    u8_t count;
+    u16_t reserved;
+    u32_t start;
+};
+
+/**
+* Restore the mac to address bindings saved by dhcp_lease_save. The elapsed
+* time is unknown after a reboot, so restored leases are expired but sticky:
+* the same station gets the same address back until the pool runs short.
+*
+* @return number of restored leases, -1 on error
+*/
+int dhcp_lease_load(struct dhcp_lease_table *table, const char *key)
+{
+    struct dhcp_lease_record_hdr hdr;
+    struct dhcp_lease_record *records;
+    size_t len, saved_len = 0;
+    int i, restored = 0;
+
+    if (0 == ef_get_env_blob(key, NULL, 0, &saved_len) || saved_len < sizeof(hdr)) {
+        return 0;
+    }
+    records = (struct dhcp_lease_record *)pvPortMalloc(saved_len);
+    if (NULL == records) {
+        return -1;
+    }
+    len = ef_get_env_blob(key, records, saved_len, NULL);
+    memcpy(&hdr, records, sizeof(hdr));
+    if (len != saved_len || hdr.version != DHCP_LEASE_RECORD_VERSION || hdr.start != table->start ||
+            sizeof(hdr) + hdr.count * sizeof(struct dhcp_lease_record) > len) {
+        vPortFree(records);
+        return -1;
+    }
+
+    for (i = 0; i < hdr.count; i++) {
+        struct dhcp_lease_record *rec = (struct dhcp_lease_record *)((u8_t *)records + sizeof(hdr)) + i;
+
+        if (rec->offset >= table->count || table->leases[rec->offset].state != DHCP_LEASE_FREE ||
+                dhcp_lease_find_by_mac(table, rec->chaddr) >= 0) {
+            continue;
+        }
+        dhcp_lease_set(table, rec->offset, rec->chaddr, DHCP_LEASE_BOUND, 0);
+        dhcp_lease_list_unlink(table, rec->offset);
+        table->leases[rec->offset].state = DHCP_LEASE_EXPIRED;
+        dhcp_lease_list_link(table, rec->offset);
+        restored++;
+    }
+    vPortFree(records);
+    table->dirty = 0;
+
+    return restored;
+}
+
+/**
+* Save all mac to address bindings if they changed since the last save
+*
+* @return 0 on success or nothing to do, -1 on error
+*/
+int dhcp_lease_save(struct dhcp_lease_table *table, const char *key)
+{
+    struct dhcp_lease_record_hdr hdr;
+    struct dhcp_lease_record *rec;
+    u8_t *buf;
+    size_t len;
+    int i, ret;
+
+    if (!table->dirty) {
+        return 0;
+    }
+    len = sizeof(hdr) + table->used * sizeof(struct dhcp_lease_record);
+    buf = (u8_t *)pvPortMalloc(len);
+    if (NULL == buf) {
+        return -1;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.version = DHCP_LEASE_RECORD_VERSION;
+    hdr.start = table->start;
+    rec = (struct dhcp_lease_record *)(buf + sizeof(hdr));
+    for (i = 0; i < table->count && hdr.count < table->used; i++) {
+        if (table->leases[i].state == DHCP_LEASE_FREE) {
+            continue;
+        }
+        memcpy(rec->chaddr, table->leases[i].chaddr, DHCP_LEASE_HLEN);
+        rec->offset = i;
+        rec->reserved = 0;
+        rec++;
+        hdr.count++;
+    }
+    memcpy(buf, &hdr, sizeof(hdr));
+
+    ret = (EF_NO_ERR == ef_set_env_blob(key, buf, len)) ? 0 : -1;
+    vPortFree(buf);
+    if (0 == ret) {
+        table->dirty = 0;
+    }
+
+    return ret;
+}
+#endif
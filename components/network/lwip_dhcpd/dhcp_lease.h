@@ -0,0 +1,109 @@
+
+/**
+ ****************************************************************************************
+ *
+ * @file dhcp_lease.h
+ * Copyright (C) Bouffalo Lab 2016-2018
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef DHCPV4_LEASE_H__
+#define DHCPV4_LEASE_H__
+
+#include <lwip/arch.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Mac address length  */
+#define DHCP_LEASE_HLEN             6
+
+/** Number of MAC hash buckets, must be a power of 2 */
+#ifndef DHCPD_LEASE_HASH_SIZE
+    #define DHCPD_LEASE_HASH_SIZE   32
+#endif
+
+/** Expiry timer wheel geometry, one slot per tick */
+#ifndef DHCPD_LEASE_WHEEL_SLOTS
+    #define DHCPD_LEASE_WHEEL_SLOTS 32
+#endif
+#ifndef DHCPD_LEASE_WHEEL_TICK_S
+    #define DHCPD_LEASE_WHEEL_TICK_S 30
+#endif
+
+/** Index type for lease slots, leases are limited to one /24 */
+typedef u8_t dhcp_lease_idx_t;
+#define DHCP_LEASE_NIL              ((dhcp_lease_idx_t)0xFF)
+#define DHCP_LEASE_MAX              (DHCP_LEASE_NIL - 1)
+
+enum dhcp_lease_state
+{
+    DHCP_LEASE_FREE = 0,
+    DHCP_LEASE_OFFERED,
+    DHCP_LEASE_BOUND,
+    DHCP_LEASE_EXPIRED,
+};
+
+/**
+* One lease slot, the slot index is the offset of the address in the pool.
+* A lease is linked either in a timer wheel slot (OFFERED/BOUND) or in the
+* expired list (EXPIRED). Expired leases keep their MAC binding so that a
+* returning station gets the same address, until the pool runs out of
+* never-used addresses and the oldest expired one is reclaimed.
+*/
+struct dhcp_lease
+{
+    u8_t chaddr[DHCP_LEASE_HLEN];
+    u8_t state;
+    dhcp_lease_idx_t hash_next;
+    dhcp_lease_idx_t next;
+    dhcp_lease_idx_t prev;
+    u32_t lease_end;
+};
+
+/**
+* The lease table of one dhcp server.
+*/
+struct dhcp_lease_table
+{
+    struct dhcp_lease *leases;
+    u32_t start;                 /* first pool address, host order */
+    u16_t count;
+    u16_t used;
+    u32_t *free_map;             /* bit set = address never bound or released */
+    dhcp_lease_idx_t hash[DHCPD_LEASE_HASH_SIZE];
+    dhcp_lease_idx_t wheel[DHCPD_LEASE_WHEEL_SLOTS];
+    dhcp_lease_idx_t expired_head;
+    dhcp_lease_idx_t expired_tail;
+    u32_t now;                   /* wheel ticks since start */
+    u8_t dirty;
+};
+
+int dhcp_lease_table_init(struct dhcp_lease_table *table, u32_t start, u32_t end);
+void dhcp_lease_table_deinit(struct dhcp_lease_table *table);
+
+int dhcp_lease_find_by_mac(struct dhcp_lease_table *table, const u8_t *chaddr);
+int dhcp_lease_find_by_ip(struct dhcp_lease_table *table, u32_t ipaddr);
+int dhcp_lease_alloc(struct dhcp_lease_table *table, const u8_t *chaddr, u32_t requested);
+void dhcp_lease_set(struct dhcp_lease_table *table, int idx, const u8_t *chaddr, u8_t state, u32_t duration);
+void dhcp_lease_release(struct dhcp_lease_table *table, int idx);
+void dhcp_lease_tick(struct dhcp_lease_table *table);
+
+static inline u32_t dhcp_lease_ip(struct dhcp_lease_table *table, int idx)
+{
+    return table->start + (u32_t)idx;
+}
+
+#ifdef DHCPD_LEASE_PERSIST
+int dhcp_lease_load(struct dhcp_lease_table *table, const char *key);
+int dhcp_lease_save(struct dhcp_lease_table *table, const char *key);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
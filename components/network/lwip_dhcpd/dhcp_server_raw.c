@@ -16,6 +16,7 @@
 
 #include <lwip/opt.h>
 #include <lwip/sockets.h>
+#include <lwip/inet.h>
 #include <lwip/inet_chksum.h>
 #include <netif/etharp.h>
 #include <ethernetif.h>
@@ -24,6 +25,9 @@
 
 
 #include <lwip/prot/dhcp.h>
+#include <lwip/timeouts.h>
+
+#include "dhcp_lease.h"
 
 /* DHCP server option */
 #define DHCP_CLIENT_PORT  68
@@ -57,9 +61,19 @@
 #include <lwip/dhcp.h>
 
 /** Mac address length  */
-#define DHCP_MAX_HLEN               6
-/** dhcp default live time */
-#define DHCP_DEFAULT_LIVE_TIME      0x80510100
+#define DHCP_MAX_HLEN               DHCP_LEASE_HLEN
+/** dhcp lease time in seconds */
+#ifndef DHCPD_LEASE_TIME
+    #define DHCPD_LEASE_TIME        (2 * 60 * 60)
+#endif
+/** how long an offered address is held for the REQUEST, in seconds */
+#ifndef DHCPD_OFFER_TIME
+    #define DHCPD_OFFER_TIME        60
+#endif
+/** EasyFlash key of the persisted leases */
+#ifndef DHCPD_LEASE_PERSIST_KEY
+    #define DHCPD_LEASE_PERSIST_KEY "dhcpd_leases"
+#endif
 
 /** Minimum length for request before packet is parsed */
 #define DHCP_MIN_REQUEST_LEN        44
@@ -67,17 +81,6 @@
 #define LWIP_NETIF_LOCK(...)
 #define LWIP_NETIF_UNLOCK(...)
 
-/**
-* The dhcp client node struct.
-*/
-struct dhcp_client_node
-{
-    struct dhcp_client_node *next;
-    u8_t chaddr[DHCP_MAX_HLEN];
-    ip4_addr_t ipaddr;
-    u32_t lease_end;
-};
-
 /**
 * The dhcp server struct.
 */
@@ -86,10 +89,9 @@ struct dhcp_server
     struct dhcp_server *next;
     struct netif *netif;
     struct udp_pcb *pcb;
-    struct dhcp_client_node *node_list;
+    struct dhcp_lease_table leases;
     ip4_addr_t start;
     ip4_addr_t end;
-    ip4_addr_t current;
 };
 
 static u8_t *dhcp_server_option_find(u8_t *buf, u16_t len, u8_t option);
@@ -100,153 +102,109 @@ static u8_t *dhcp_server_option_find(u8_t *buf, u16_t len, u8_t option);
 static struct dhcp_server *lw_dhcp_server;
 
 /**
-* Find a dhcp client node by mac address
+* Get the requested ip address option of a message
 *
-* @param dhcpserver The dhcp server
-* @param chaddr Mac address
-* @param hlen   Mac address length
-* @return dhcp client node
+* @param opt_buf The option buffer
+* @param len The option buffer length
+* @return requested ip address in host order, 0 if none
 */
-static struct dhcp_client_node *
-dhcp_client_find_by_mac(struct dhcp_server *dhcpserver, const u8_t *chaddr, u8_t hlen)
+static u32_t
+dhcp_client_requested_ip(u8_t *opt_buf, u16_t len)
 {
-    struct dhcp_client_node *node;
+    u8_t *opt;
+    u32_t ipval;
 
-    for (node = dhcpserver->node_list; node != NULL; node = node->next)
+    opt = dhcp_server_option_find(opt_buf, len, DHCP_OPTION_REQUESTED_IP);
+    if (opt == NULL || opt[1] != 4)
     {
-        if (memcmp(node->chaddr, chaddr, hlen) == 0)
-        {
-            return node;
-        }
+        return 0;
     }
-
-    return NULL;
-}
-
-/**
-* Find a dhcp client node by ip address
-*
-* @param dhcpserver The dhcp server
-* @param chaddr Mac address
-* @param hlen   Mac address length
-* @return dhcp client node
-*/
-static struct dhcp_client_node *
-dhcp_client_find_by_ip(struct dhcp_server *dhcpserver, const uint8_t *ip)
-{
-    struct dhcp_client_node *node;
-    ip_addr_t ipaddr;
-    uint32_t ipval;
-
     // Copy ipaddr to avoid aligment issue
-    memcpy(&ipval, ip, sizeof(ipval));
-    ip4_addr_set_u32(&ipaddr, ipval);
-    for (node = dhcpserver->node_list; node != NULL; node = node->next)
-    {
-        if (ip4_addr_cmp(&node->ipaddr, &ipaddr))
-        {
-            return node;
-        }
-    }
+    memcpy(&ipval, &opt[2], sizeof(ipval));
 
-    return NULL;
+    return ntohl(ipval);
 }
 
 /**
-* Find a dhcp client node by ip address
+* Find the lease of a dhcp client
 *
 * @param dhcpserver The dhcp server
-* @param chaddr Mac address
-* @param hlen   Mac address length
-* @return dhcp client node
+* @param msg The dhcp message
+* @param opt_buf The option buffer
+* @param len The option buffer length
+* @return lease index, -1 if the client holds no lease
 */
-static struct dhcp_client_node *
+static int
 dhcp_client_find(struct dhcp_server *dhcpserver, struct dhcp_msg *msg,
                  u8_t *opt_buf, u16_t len)
 {
-    u8_t *opt;
-    //u32_t ipaddr;
-    struct dhcp_client_node *node;
+    int idx;
+    u32_t requested;
 
-    node = dhcp_client_find_by_mac(dhcpserver, msg->chaddr, msg->hlen);
-    if (node != NULL)
+    idx = dhcp_lease_find_by_mac(&dhcpserver->leases, msg->chaddr);
+    if (idx >= 0)
     {
-        return node;
+        return idx;
     }
 
-    opt = dhcp_server_option_find(opt_buf, len, DHCP_OPTION_REQUESTED_IP);
-    if (opt != NULL)
+    requested = dhcp_client_requested_ip(opt_buf, len);
+    if (requested != 0 && dhcp_lease_find_by_ip(&dhcpserver->leases, requested) >= 0)
     {
-        node = dhcp_client_find_by_ip(dhcpserver, &opt[2]);
-        if (node != NULL)
-        {
-            if (0 == memcmp(node->chaddr, msg->chaddr, msg->hlen)) {
-                return node;
-            } else {
-                puts("IP Found, but MAC address is NOT the same\r\n");
-            }
-        }
+        puts("IP Found, but MAC address is NOT the same\r\n");
     }
 
-    return NULL;
+    return -1;
 }
 
 /**
-* Find a dhcp client node by ip address
+* Allocate a lease for a dhcp client
 *
 * @param dhcpserver The dhcp server
-* @param chaddr Mac address
-* @param hlen   Mac address length
-* @return dhcp client node
+* @param msg The dhcp message
+* @param opt_buf The option buffer
+* @param len The option buffer length
+* @return lease index, -1 if the pool is exhausted
 */
-static struct dhcp_client_node *
+static int
 dhcp_client_alloc(struct dhcp_server *dhcpserver, struct dhcp_msg *msg,
                   u8_t *opt_buf, u16_t len)
 {
-    u8_t *opt;
-    u32_t ipaddr;
-    struct dhcp_client_node *node;
+    return dhcp_lease_alloc(&dhcpserver->leases, msg->chaddr, dhcp_client_requested_ip(opt_buf, len));
+}
 
-    node = dhcp_client_find_by_mac(dhcpserver, msg->chaddr, msg->hlen);
-    if (node != NULL)
-    {
-        return node;
-    }
+/**
+* Expire leases and save the changed bindings, runs every wheel tick
+*/
+static void
+dhcp_server_tick(void *arg)
+{
+    struct dhcp_server *dhcp_server = (struct dhcp_server *)arg;
 
-    opt = dhcp_server_option_find(opt_buf, len, DHCP_OPTION_REQUESTED_IP);
-    if (opt != NULL)
-    {
-        node = dhcp_client_find_by_ip(dhcpserver, &opt[2]);
-        if (node != NULL)
-        {
-            return node;
-        }
-    }
+    dhcp_lease_tick(&dhcp_server->leases);
+#ifdef DHCPD_LEASE_PERSIST
+    dhcp_lease_save(&dhcp_server->leases, DHCPD_LEASE_PERSIST_KEY);
+#endif
+    sys_timeout(DHCPD_LEASE_WHEEL_TICK_S * 1000, dhcp_server_tick, dhcp_server);
+}
 
-dhcp_alloc_again:
-    node = dhcp_client_find_by_ip(dhcpserver, (uint8_t*)&dhcpserver->current);
-    if (node != NULL)
+/**
+* (Re)build the lease table of a dhcp server for its address range
+*/
+static err_t
+dhcp_server_leases_init(struct dhcp_lease_table *leases, ip4_addr_t *start, ip4_addr_t *end)
+{
+    if (dhcp_lease_table_init(leases, ntohl(start->addr), ntohl(end->addr)))
     {
-        ipaddr = (ntohl(dhcpserver->current.addr) + 1);
-        if (ipaddr > ntohl(dhcpserver->end.addr))
-        {
-            ipaddr = ntohl(dhcpserver->start.addr);
-        }
-        dhcpserver->current.addr = htonl(ipaddr);
-        goto dhcp_alloc_again;
+        return ERR_MEM;
     }
-    node = (struct dhcp_client_node *)mem_malloc(sizeof(struct dhcp_client_node));
-    if (node == NULL)
+#ifdef DHCPD_LEASE_PERSIST
+    if (dhcp_lease_load(leases, DHCPD_LEASE_PERSIST_KEY) < 0)
     {
-        return NULL;
+        DEBUG_PRINTF("drop bad persisted leases\r\n");
     }
-    SMEMCPY(node->chaddr, msg->chaddr, msg->hlen);
-    node->ipaddr = dhcpserver->current;
-
-    node->next = dhcpserver->node_list;
-    dhcpserver->node_list = node;
+#endif
 
-    return node;
+    return ERR_OK;
 }
 
 /**
@@ -283,7 +241,8 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
     struct pbuf *q;
     u8_t *opt_buf;
     u8_t *opt;
-    struct dhcp_client_node *node;
+    int idx;
+    ip4_addr_t yiaddr;
     u8_t msg_type;
     u16_t length;
     ip_addr_t addr = *recv_addr;
@@ -345,12 +304,13 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
         msg_type = *(opt + 2);
         if (msg_type == DHCP_DISCOVER)
         {
-            node = dhcp_client_alloc(dhcp_server, msg, opt_buf, length);
-            if (node == NULL)
+            idx = dhcp_client_alloc(dhcp_server, msg, opt_buf, length);
+            if (idx < 0)
             {
                 goto free_pbuf_and_return;
             }
-            node->lease_end = DHCP_DEFAULT_LIVE_TIME;
+            dhcp_lease_set(&dhcp_server->leases, idx, msg->chaddr, DHCP_LEASE_OFFERED, DHCPD_OFFER_TIME);
+            yiaddr.addr = htonl(dhcp_lease_ip(&dhcp_server->leases, idx));
             /* create dhcp offer and send */
             msg->op = DHCP_BOOTREPLY;
             msg->hops = 0;
@@ -359,7 +319,7 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
             msg->sname[0] = '\0';
             msg->file[0] = '\0';
             msg->cookie = PP_HTONL(DHCP_MAGIC_COOKIE);
-            SMEMCPY(&msg->yiaddr, &node->ipaddr, 4);
+            SMEMCPY(&msg->yiaddr, &yiaddr, 4);
 
             opt_buf = (u8_t *)msg + DHCP_OPTIONS_OFS;
             /* add msg type */
@@ -376,7 +336,7 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
             /* add_lease_time */
             *opt_buf++ = DHCP_OPTION_LEASE_TIME;
             *opt_buf++ = 4;
-            tmp = PP_HTONL(DHCP_DEFAULT_LIVE_TIME);
+            tmp = PP_HTONL(DHCPD_LEASE_TIME);
             SMEMCPY(opt_buf, &tmp, 4);
             opt_buf += 4;
 
@@ -408,7 +368,7 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
             /* add option end */
             *opt_buf++ = DHCP_OPTION_END;
 
-            length = (u32_t)opt_buf - (u32_t)msg;
+            length = opt_buf - (u8_t *)msg;
             if (length < q->tot_len)
             {
                 pbuf_realloc(q, length);
@@ -423,11 +383,12 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
             {
                 if (msg_type == DHCP_REQUEST)
                 {
-                    node = dhcp_client_find(dhcp_server, msg, opt_buf, length);
-                    if (node != NULL)
+                    idx = dhcp_client_find(dhcp_server, msg, opt_buf, length);
+                    if (idx >= 0)
                     {
                         /* Send ack */
-                        node->lease_end = DHCP_DEFAULT_LIVE_TIME;
+                        dhcp_lease_set(&dhcp_server->leases, idx, msg->chaddr, DHCP_LEASE_BOUND, DHCPD_LEASE_TIME);
+                        yiaddr.addr = htonl(dhcp_lease_ip(&dhcp_server->leases, idx));
                         /* create dhcp offer and send */
                         msg->op = DHCP_BOOTREPLY;
                         msg->hops = 0;
@@ -436,7 +397,7 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
                         msg->sname[0] = '\0';
                         msg->file[0] = '\0';
                         msg->cookie = PP_HTONL(DHCP_MAGIC_COOKIE);
-                        SMEMCPY(&msg->yiaddr, &node->ipaddr, 4);
+                        SMEMCPY(&msg->yiaddr, &yiaddr, 4);
                         opt_buf = (u8_t *)msg + DHCP_OPTIONS_OFS;
 
                         /* add msg type */
@@ -453,7 +414,7 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
                         /* add_lease_time */
                         *opt_buf++ = DHCP_OPTION_LEASE_TIME;
                         *opt_buf++ = 4;
-                        tmp = PP_HTONL(DHCP_DEFAULT_LIVE_TIME);
+                        tmp = PP_HTONL(DHCPD_LEASE_TIME);
                         SMEMCPY(opt_buf, &tmp, 4);
                         opt_buf += 4;
 
@@ -485,7 +446,7 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
                         /* add option end */
                         *opt_buf++ = DHCP_OPTION_END;
 
-                        length = (u32_t)opt_buf - (u32_t)msg;
+                        length = opt_buf - (u8_t *)msg;
                         if (length < q->tot_len)
                         {
                             pbuf_realloc(q, length);
@@ -521,7 +482,7 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
 
                         /* add option end */
                         *opt_buf++ = DHCP_OPTION_END;
-                        length = (u32_t)opt_buf - (u32_t)msg;
+                        length = opt_buf - (u8_t *)msg;
                         if (length < q->tot_len)
                         {
                             pbuf_realloc(q, length);
@@ -533,29 +494,10 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
                 }
                 else if (msg_type == DHCP_RELEASE)
                 {
-                    struct dhcp_client_node *node_prev = NULL;
-
-                    for (node = dhcp_server->node_list; node != NULL; node = node->next)
-                    {
-                        if (memcmp(node->chaddr, msg->chaddr, msg->hlen) == 0)
-                        {
-                            if (node == dhcp_server->node_list)
-                            {
-                                dhcp_server->node_list = node->next;
-                            }
-                            else
-                            {
-                                node_prev->next = node->next;
-                            }
-                            break;
-                        }
-                        node_prev = node;
-                        node = node->next;
-                    }
-
-                    if (node != NULL)
+                    idx = dhcp_lease_find_by_mac(&dhcp_server->leases, msg->chaddr);
+                    if (idx >= 0)
                     {
-                        mem_free(node);
+                        dhcp_lease_release(&dhcp_server->leases, idx);
                     }
                 }
                 else if (msg_type ==  DHCP_DECLINE)
@@ -588,15 +530,27 @@ err_t
 dhcp_server_start(struct netif *netif, ip4_addr_t *start, ip4_addr_t *end)
 {
     struct dhcp_server *dhcp_server;
+    struct dhcp_lease_table leases;
 
     /* If this netif alreday use the dhcp server. */
     for (dhcp_server = lw_dhcp_server; dhcp_server != NULL; dhcp_server = dhcp_server->next)
     {
         if (dhcp_server->netif == netif)
         {
+            /* the old table goes away, keep what was not written back yet */
+#ifdef DHCPD_LEASE_PERSIST
+            dhcp_lease_save(&dhcp_server->leases, DHCPD_LEASE_PERSIST_KEY);
+#endif
+            /* and it keeps serving the old range if the new one cannot be had */
+            if (dhcp_server_leases_init(&leases, start, end) != ERR_OK)
+            {
+                LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_server_start(): could not allocate leases\n"));
+                return ERR_MEM;
+            }
+            dhcp_lease_table_deinit(&dhcp_server->leases);
+            dhcp_server->leases = leases;
             dhcp_server->start = *start;
             dhcp_server->end = *end;
-            dhcp_server->current = *start;
             return ERR_OK;
         }
     }
@@ -613,29 +567,37 @@ dhcp_server_start(struct netif *netif, ip4_addr_t *start, ip4_addr_t *end)
     /* clear data structure */
     memset(dhcp_server, 0, sizeof(struct dhcp_server));
 
-    /* store this dhcp server to list */
-    dhcp_server->next = lw_dhcp_server;
-    lw_dhcp_server = dhcp_server;
     dhcp_server->netif = netif;
-    dhcp_server->node_list = NULL;
     dhcp_server->start = *start;
     dhcp_server->end = *end;
-    dhcp_server->current = *start;
+    if (dhcp_server_leases_init(&dhcp_server->leases, start, end) != ERR_OK)
+    {
+        LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_server_start(): could not allocate leases\n"));
+        mem_free(dhcp_server);
+        return ERR_MEM;
+    }
 
     /* allocate UDP PCB */
     dhcp_server->pcb = udp_new();
     if (dhcp_server->pcb == NULL)
     {
         LWIP_DEBUGF(DHCP_DEBUG  | LWIP_DBG_TRACE, ("dhcp_server_start(): could not obtain pcb\n"));
+        dhcp_lease_table_deinit(&dhcp_server->leases);
+        mem_free(dhcp_server);
         return ERR_MEM;
     }
 
+    /* store this dhcp server to list, once nothing can fail */
+    dhcp_server->next = lw_dhcp_server;
+    lw_dhcp_server = dhcp_server;
+
     ip_set_option(dhcp_server->pcb, SOF_BROADCAST);
     /* set up local and remote port for the pcb */
     udp_bind(dhcp_server->pcb, IP_ADDR_ANY, DHCP_SERVER_PORT);
     //udp_connect(dhcp_server->pcb, IP_ADDR_ANY, DHCP_CLIENT_PORT);
     /* set up the recv callback and argument */
     udp_recv(dhcp_server->pcb, dhcp_server_recv, dhcp_server);
+    sys_timeout(DHCPD_LEASE_WHEEL_TICK_S * 1000, dhcp_server_tick, dhcp_server);
     LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_server_start(): starting DHCP server\n"));
 
     return ERR_OK;
@@ -662,6 +624,11 @@ err_t dhcp_server_stop(struct netif *netif)
     if (dhcp_server->pcb) {
         udp_remove(dhcp_server->pcb);
     }
+    sys_untimeout(dhcp_server_tick, dhcp_server);
+#ifdef DHCPD_LEASE_PERSIST
+    dhcp_lease_save(&dhcp_server->leases, DHCPD_LEASE_PERSIST_KEY);
+#endif
+    dhcp_lease_table_deinit(&dhcp_server->leases);
     /*clean linked list*/
     //FIXME no linked list, just one pointer
     lw_dhcp_server = NULL;
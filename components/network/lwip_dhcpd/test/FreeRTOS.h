@@ -0,0 +1,9 @@
+/* Host test stand-in, the lease table only needs the heap */
+#ifndef TEST_FREERTOS_H
+#define TEST_FREERTOS_H
+#include <stddef.h>
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+
+#endif
@@ -0,0 +1,14 @@
+/* Host test stand-in, the env blobs live in memory */
+#ifndef TEST_EASYFLASH_H
+#define TEST_EASYFLASH_H
+#include <stddef.h>
+
+typedef enum {
+    EF_NO_ERR,
+    EF_ENV_FULL,
+} EfErrCode;
+
+size_t ef_get_env_blob(const char *key, void *value_buf, size_t buf_len, size_t *saved_value_len);
+EfErrCode ef_set_env_blob(const char *key, const void *value_buf, size_t buf_len);
+
+#endif
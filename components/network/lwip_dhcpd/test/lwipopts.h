@@ -0,0 +1,16 @@
+/* lwIP config of the host test, the core only, driven from one thread */
+#ifndef LWIP_HDR_LWIPOPTS_H
+#define LWIP_HDR_LWIPOPTS_H
+
+#define NO_SYS                          1
+#define SYS_LIGHTWEIGHT_PROT            0
+#define LWIP_NETCONN                    0
+#define LWIP_SOCKET                     0
+#define LWIP_IPV6                       0
+#define LWIP_DHCP                       1
+
+#define MEM_SIZE                        16000
+#define PBUF_POOL_SIZE                  16
+#define MEMP_NUM_SYS_TIMEOUT            (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 2)
+
+#endif
@@ -0,0 +1,426 @@
+/**
+ ****************************************************************************************
+ *
+ * @file test_dhcp_server.c
+ * Copyright (C) Bouffalo Lab 2016-2018
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * Host test of the dhcp server on the lwIP core, NO_SYS with the clock in
+ * the test. Synthetic DISCOVER/REQUEST/RELEASE frames go in through the
+ * netif input, the replies are taken off its output. The lease persistence
+ * runs on an in-memory EasyFlash. From this directory:
+ *
+ *   L=../../lwip
+ *   gcc -DDHCPD_LEASE_PERSIST -I. -I.. -I$L/src/include -I$L/contrib/ports/unix/port/include \
+ *       -I$L/lwip-port/FreeRTOS \
+ *       test_dhcp_server.c ../dhcp_server_raw.c ../dhcp_lease.c \
+ *       $(find $L/src/core -name '*.c') $L/src/netif/ethernet.c -o test_dhcp_server
+ *   ./test_dhcp_server
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lwip/init.h>
+#include <lwip/netif.h>
+#include <lwip/ip.h>
+#include <lwip/inet_chksum.h>
+#include <lwip/stats.h>
+#include <lwip/timeouts.h>
+#include <lwip/prot/dhcp.h>
+
+#include <FreeRTOS.h>
+#include <easyflash.h>
+
+#include "dhcp_lease.h"
+
+err_t dhcp_server_start(struct netif *netif, ip4_addr_t *start, ip4_addr_t *end);
+err_t dhcp_server_stop(struct netif *netif);
+void set_if(struct netif *netif, char *ip_addr, char *gw_addr, char *nm_addr);
+
+#define SERVER_IP       PP_HTONL(LWIP_MAKEU32(192, 168, 169, 1))
+#define POOL_FIRST      LWIP_MAKEU32(192, 168, 169, 2)
+#define POOL_LAST       LWIP_MAKEU32(192, 168, 169, 5)
+
+#define OPTIONS_OFS     240
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+/* heap of the lease table, allocations can be made to fail */
+static int fail_allocs;
+
+void *pvPortMalloc(size_t size)
+{
+    if (fail_allocs) {
+        fail_allocs--;
+        return NULL;
+    }
+    return malloc(size);
+}
+
+void vPortFree(void *ptr)
+{
+    free(ptr);
+}
+
+/* the one EasyFlash blob the server uses */
+static char ef_key[32];
+static unsigned char ef_blob[1024];
+static size_t ef_len;
+static int ef_writes;
+
+size_t ef_get_env_blob(const char *key, void *value_buf, size_t buf_len, size_t *saved_value_len)
+{
+    if (0 == ef_len || strcmp(key, ef_key)) {
+        return 0;
+    }
+    if (saved_value_len) {
+        *saved_value_len = ef_len;
+    }
+    if (value_buf == NULL) {
+        return ef_len;
+    }
+    if (buf_len > ef_len) {
+        buf_len = ef_len;
+    }
+    memcpy(value_buf, ef_blob, buf_len);
+    return buf_len;
+}
+
+EfErrCode ef_set_env_blob(const char *key, const void *value_buf, size_t buf_len)
+{
+    if (buf_len > sizeof(ef_blob) || strlen(key) >= sizeof(ef_key)) {
+        return EF_ENV_FULL;
+    }
+    strcpy(ef_key, key);
+    memcpy(ef_blob, value_buf, buf_len);
+    ef_len = buf_len;
+    ef_writes++;
+    return EF_NO_ERR;
+}
+
+static u32_t now_ms;
+
+u32_t sys_now(void)
+{
+    return now_ms;
+}
+
+/* what the unix port provides */
+unsigned int lwip_port_rand(void)
+{
+    return (unsigned int)rand();
+}
+
+/* only dhcpd_start needs it, which is not run here */
+void set_if(struct netif *netif, char *ip_addr, char *gw_addr, char *nm_addr)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(ip_addr);
+    LWIP_UNUSED_ARG(gw_addr);
+    LWIP_UNUSED_ARG(nm_addr);
+}
+
+/* the last reply the server sent */
+static struct {
+    int count;
+    u8_t type;
+    u8_t chaddr[6];
+    u32_t yiaddr;       /* host order */
+    u32_t server_id;
+    u32_t lease_time;   /* host order */
+} reply;
+
+static struct netif test_netif;
+
+static u32_t get_be32(const u8_t *p)
+{
+    return (u32_t)p[0] << 24 | (u32_t)p[1] << 16 | (u32_t)p[2] << 8 | p[3];
+}
+
+static err_t test_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    u8_t buf[600];
+    u8_t *msg, *opt, *end;
+    u16_t len;
+
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    len = pbuf_copy_partial(p, buf, sizeof(buf), 0);
+    msg = buf + (buf[0] & 0x0f) * 4 + 8;
+    CHECK(len >= (msg - buf) + OPTIONS_OFS + 1, "short reply %u", len);
+    CHECK(msg[0] == DHCP_BOOTREPLY, "reply op %u", msg[0]);
+    CHECK(get_be32(msg + 236) == DHCP_MAGIC_COOKIE, "reply cookie");
+
+    reply.count++;
+    memcpy(reply.chaddr, msg + 28, 6);
+    reply.yiaddr = get_be32(msg + 16);
+    reply.type = 0;
+    reply.server_id = 0;
+    reply.lease_time = 0;
+    end = buf + len;
+    for (opt = msg + OPTIONS_OFS; opt < end && *opt != DHCP_OPTION_END; opt += opt[1] + 2) {
+        if (*opt == DHCP_OPTION_MESSAGE_TYPE) {
+            reply.type = opt[2];
+        } else if (*opt == DHCP_OPTION_SERVER_ID) {
+            memcpy(&reply.server_id, opt + 2, 4);
+        } else if (*opt == DHCP_OPTION_LEASE_TIME) {
+            reply.lease_time = get_be32(opt + 2);
+        }
+    }
+    return ERR_OK;
+}
+
+static err_t test_netif_init(struct netif *netif)
+{
+    netif->name[0] = 'a';
+    netif->name[1] = 'p';
+    netif->output = test_output;
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_LINK_UP;
+    netif->hwaddr_len = 6;
+    return ERR_OK;
+}
+
+/* a client frame from 0.0.0.0:68 to the broadcast address, as sent before it has an address */
+static void send_frame(u8_t op, u8_t type, u8_t mac, u32_t requested, u32_t cookie, u16_t dhcp_len)
+{
+    u8_t buf[600];
+    u8_t *udp = buf + 20, *msg = buf + 28, *opt = msg + OPTIONS_OFS;
+    u16_t len, chksum;
+    struct pbuf *p;
+
+    memset(buf, 0, sizeof(buf));
+    msg[0] = op;
+    msg[1] = 1;
+    msg[2] = 6;
+    msg[4] = 0x12; msg[5] = 0x34; msg[6] = 0x56; msg[7] = mac;
+    msg[28] = 0x02; msg[29] = 0x00; msg[30] = 0x5e; msg[33] = mac;
+    msg[236] = cookie >> 24; msg[237] = cookie >> 16; msg[238] = cookie >> 8; msg[239] = cookie;
+    *opt++ = DHCP_OPTION_MESSAGE_TYPE;
+    *opt++ = 1;
+    *opt++ = type;
+    if (requested) {
+        *opt++ = DHCP_OPTION_REQUESTED_IP;
+        *opt++ = 4;
+        *opt++ = requested >> 24; *opt++ = requested >> 16; *opt++ = requested >> 8; *opt++ = requested;
+    }
+    *opt++ = DHCP_OPTION_END;
+    if (dhcp_len == 0) {
+        dhcp_len = opt - msg;
+    }
+
+    len = 28 + dhcp_len;
+    buf[0] = 0x45;
+    buf[2] = len >> 8; buf[3] = len;
+    buf[8] = 64;
+    buf[9] = IP_PROTO_UDP;
+    memset(buf + 16, 0xff, 4);
+    chksum = inet_chksum(buf, 20);
+    memcpy(buf + 10, &chksum, 2);
+    udp[1] = 68;
+    udp[3] = 67;
+    udp[4] = (8 + dhcp_len) >> 8; udp[5] = 8 + dhcp_len;
+
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+    CHECK(p != NULL, "no pbuf");
+    pbuf_take(p, buf, len);
+    test_netif.input(p, &test_netif);
+}
+
+/* the reply to one client message, 0 when none was sent */
+static u8_t exchange(u8_t type, u8_t mac, u32_t requested)
+{
+    int count = reply.count;
+
+    send_frame(DHCP_BOOTREQUEST, type, mac, requested, DHCP_MAGIC_COOKIE, 0);
+    if (reply.count == count) {
+        return 0;
+    }
+    CHECK(reply.chaddr[5] == mac, "reply to %u for %u", reply.chaddr[5], mac);
+    return reply.type;
+}
+
+/* DISCOVER then REQUEST the offer, returns the bound address in host order */
+static u32_t bind(u8_t mac)
+{
+    u32_t offered;
+
+    CHECK(exchange(DHCP_DISCOVER, mac, 0) == DHCP_OFFER, "no offer to %u", mac);
+    offered = reply.yiaddr;
+    CHECK(exchange(DHCP_REQUEST, mac, offered) == DHCP_ACK, "no ack to %u", mac);
+    CHECK(reply.yiaddr == offered, "ack %08x for offer %08x", reply.yiaddr, offered);
+    return reply.yiaddr;
+}
+
+static void start(void)
+{
+    ip4_addr_t first, last;
+
+    first.addr = PP_HTONL(POOL_FIRST);
+    last.addr = PP_HTONL(POOL_LAST);
+    CHECK(dhcp_server_start(&test_netif, &first, &last) == ERR_OK, "start failed");
+}
+
+static void test_exchange(void)
+{
+    u32_t a, b, c, d;
+
+    start();
+
+    CHECK(exchange(DHCP_DISCOVER, 1, 0) == DHCP_OFFER, "no offer");
+    CHECK(reply.yiaddr >= POOL_FIRST && reply.yiaddr <= POOL_LAST, "offer %08x out of pool", reply.yiaddr);
+    CHECK(reply.server_id == SERVER_IP, "server id %08x", reply.server_id);
+    a = reply.yiaddr;
+    CHECK(exchange(DHCP_REQUEST, 1, a) == DHCP_ACK, "no ack");
+    CHECK(reply.yiaddr == a, "ack %08x for offer %08x", reply.yiaddr, a);
+    CHECK(reply.lease_time == 2 * 60 * 60, "lease time %u", reply.lease_time);
+
+    /* again, as a renewing client does, same address */
+    CHECK(exchange(DHCP_DISCOVER, 1, 0) == DHCP_OFFER && reply.yiaddr == a, "rediscover got %08x", reply.yiaddr);
+    CHECK(exchange(DHCP_REQUEST, 1, a) == DHCP_ACK && reply.yiaddr == a, "renew got %08x", reply.yiaddr);
+
+    /* a REQUEST without an offer is refused */
+    CHECK(exchange(DHCP_REQUEST, 2, a) == DHCP_NAK, "no nak");
+    CHECK(reply.yiaddr == 0, "nak with address %08x", reply.yiaddr);
+
+    /* the pool of four runs out */
+    b = bind(2);
+    c = bind(3);
+    CHECK(exchange(DHCP_DISCOVER, 4, c) == DHCP_OFFER, "no offer");
+    d = reply.yiaddr;
+    CHECK(a != b && a != c && a != d && b != c && b != d && c != d, "address given twice");
+    CHECK(exchange(DHCP_DISCOVER, 5, 0) == 0, "offer %08x from an exhausted pool", reply.yiaddr);
+
+    /* a RELEASE is not answered and frees the address for the next one */
+    CHECK(exchange(DHCP_RELEASE, 1, 0) == 0, "release answered");
+    CHECK(exchange(DHCP_REQUEST, 1, a) == DHCP_NAK, "released lease still acked");
+    CHECK(exchange(DHCP_DISCOVER, 5, 0) == DHCP_OFFER && reply.yiaddr == a, "released address not reused");
+
+    /* short, a reply and a bad cookie are dropped */
+    send_frame(DHCP_BOOTREQUEST, DHCP_DISCOVER, 6, 0, DHCP_MAGIC_COOKIE, 40);
+    send_frame(DHCP_BOOTREPLY, DHCP_DISCOVER, 6, 0, DHCP_MAGIC_COOKIE, 0);
+    send_frame(DHCP_BOOTREQUEST, DHCP_DISCOVER, 6, 0, 0x12345678, 0);
+    CHECK(reply.chaddr[5] != 6, "answered a bad frame");
+
+    dhcp_server_stop(&test_netif);
+}
+
+static void test_requested_out_of_pool(void)
+{
+    /* a pool below 128.0.0.0, so start + 2^31 is still an address */
+    static const u32_t first = LWIP_MAKEU32(10, 0, 0, 2);
+    static const u32_t requested[] = {
+        first - 1, first + 4, first + 0x7fffffffu, first + 0x80000000u, first + 0xfffffffeu,
+    };
+    static const u8_t chaddr[6] = {0x02, 0, 0, 0, 0, 0x10};
+    struct dhcp_lease_table table;
+    unsigned int i;
+
+    /* option 50 far from the pool is ignored, not used as an index */
+    CHECK(dhcp_lease_table_init(&table, first, first + 3) == 0, "table init failed");
+    for (i = 0; i < sizeof(requested) / sizeof(requested[0]); i++) {
+        CHECK(dhcp_lease_alloc(&table, chaddr, requested[i]) == 0, "bad lease for %08x", requested[i]);
+    }
+    CHECK(dhcp_lease_alloc(&table, chaddr, first + 2) == 2, "requested address in the pool not given");
+    dhcp_lease_table_deinit(&table);
+}
+
+static void test_restart_keeps_leases(void)
+{
+    u32_t a, b;
+    int writes;
+
+    ef_len = 0;
+    start();
+    a = bind(1);
+    b = bind(2);
+
+    /* restarted before the tick wrote the bindings back */
+    writes = ef_writes;
+    start();
+    CHECK(ef_writes == writes + 1, "leases not saved on restart");
+
+    /* the second station asks first and still gets its own address */
+    CHECK(exchange(DHCP_DISCOVER, 2, 0) == DHCP_OFFER && reply.yiaddr == b, "got %08x, had %08x", reply.yiaddr, b);
+    CHECK(exchange(DHCP_DISCOVER, 1, 0) == DHCP_OFFER && reply.yiaddr == a, "got %08x, had %08x", reply.yiaddr, a);
+
+    /* the tick writes back a change, and only a change */
+    writes = ef_writes;
+    CHECK(exchange(DHCP_RELEASE, 1, 0) == 0, "release answered");
+    now_ms += DHCPD_LEASE_WHEEL_TICK_S * 1000;
+    sys_check_timeouts();
+    CHECK(ef_writes == writes + 1, "release not saved by the tick");
+    now_ms += DHCPD_LEASE_WHEEL_TICK_S * 1000;
+    sys_check_timeouts();
+    CHECK(ef_writes == writes + 1, "clean table saved");
+
+    dhcp_server_stop(&test_netif);
+}
+
+static void test_start_failure(void)
+{
+    mem_size_t used = lwip_stats.mem.used;
+    u32_t a;
+
+    /* out of memory for the lease table, nothing is left behind */
+    ef_len = 0;
+    fail_allocs = 1;
+    CHECK(dhcp_server_start(&test_netif, &(ip4_addr_t){PP_HTONL(POOL_FIRST)}, &(ip4_addr_t){PP_HTONL(POOL_LAST)}) == ERR_MEM,
+          "start did not fail");
+    fail_allocs = 0;
+    CHECK(lwip_stats.mem.used == used, "server leaked, %u bytes", (unsigned)(lwip_stats.mem.used - used));
+    CHECK(exchange(DHCP_DISCOVER, 1, 0) == 0, "failed server answered");
+
+    /* and the next start is a clean one */
+    start();
+    a = bind(1);
+
+    /* a restart short of memory leaves the running pool as it was */
+    now_ms += DHCPD_LEASE_WHEEL_TICK_S * 1000;
+    sys_check_timeouts();
+    fail_allocs = 1;
+    CHECK(dhcp_server_start(&test_netif, &(ip4_addr_t){PP_HTONL(POOL_FIRST)}, &(ip4_addr_t){PP_HTONL(POOL_FIRST)}) == ERR_MEM,
+          "restart did not fail");
+    fail_allocs = 0;
+    CHECK(exchange(DHCP_DISCOVER, 1, 0) == DHCP_OFFER && reply.yiaddr == a, "got %08x, had %08x", reply.yiaddr, a);
+    CHECK(bind(2) != a, "lease given twice");
+    now_ms += DHCPD_LEASE_WHEEL_TICK_S * 1000;
+    sys_check_timeouts();
+    dhcp_server_stop(&test_netif);
+    CHECK(lwip_stats.mem.used == used, "server leaked, %u bytes", (unsigned)(lwip_stats.mem.used - used));
+}
+
+int main(void)
+{
+    ip4_addr_t addr, mask, gw;
+
+    lwip_init();
+    addr.addr = SERVER_IP;
+    mask.addr = PP_HTONL(LWIP_MAKEU32(255, 255, 255, 0));
+    gw.addr = 0;
+    netif_add(&test_netif, &addr, &mask, &gw, NULL, test_netif_init, ip_input);
+    netif_set_up(&test_netif);
+
+    test_exchange();
+    test_requested_out_of_pool();
+    test_restart_keeps_leases();
+    test_start_failure();
+
+    printf("%d replies\r\n", reply.count);
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -9,7 +9,8 @@ COMPONENT_PRIV_INCLUDEDIRS :=
 ## This component's src
 COMPONENT_SRCS := src/fdt.c src/fdt_ro.c src/fdt_wip.c src/fdt_sw.c src/fdt_rw.c src/fdt_strerror.c\
 src/fdt_empty_tree.c src/fdt_addresses.c src/fdt_overlay.c\
-test/tc_blfdt_dump.c test/tc_blfdt_wifi.c \
+src/blfdt_index.c \
+test/tc_blfdt_dump.c test/tc_blfdt_wifi.c test/tc_blfdt_index.c \
 test/blfdt_cli_test.c \
 
 
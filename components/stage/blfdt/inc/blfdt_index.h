@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __BLFDT_INDEX_H__
+#define __BLFDT_INDEX_H__
+
+/*
+ * Hashed lookup index over one device tree blob.
+ *
+ * blfdt_index_build() walks the blob once and records every node and
+ * property under a hash of (parent offset, name). The blfdt_* lookups below
+ * are drop-in replacements for the libfdt functions of the same name: for
+ * the indexed blob they resolve in O(1), for any other blob (or when the
+ * blob did not fit in the index) they call libfdt.
+ */
+
+#include <libfdt.h>
+
+int blfdt_index_build(const void *fdt);
+void blfdt_index_release(void);
+int blfdt_index_is_active(const void *fdt);
+const void *blfdt_index_fdt(void);
+
+int blfdt_subnode_offset(const void *fdt, int parentoffset, const char *name);
+const void *blfdt_getprop(const void *fdt, int nodeoffset, const char *name, int *lenp);
+int blfdt_stringlist_count(const void *fdt, int nodeoffset, const char *property);
+const char *blfdt_stringlist_get(const void *fdt, int nodeoffset, const char *property, int idx, int *lenp);
+
+#endif
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include <libfdt.h>
+#include <blfdt_index.h>
+
+/* The index is built by hal_board_cfg before the heap exists, so the table
+ * is static. A board dtb has a few hundred nodes and properties, the table
+ * is kept at most 3/4 full and lookups fall back to libfdt if it does not fit.
+ */
+#ifndef BLFDT_INDEX_SLOTS
+#define BLFDT_INDEX_SLOTS       512     /* power of 2 */
+#endif
+#define BLFDT_INDEX_EMPTY       0xFFFF
+#define BLFDT_INDEX_MAX_DEPTH   16
+
+/* one slot per node or property, offsets of a board dtb fit in 16 bits */
+struct blfdt_index_slot {
+    uint16_t hash;
+    uint16_t parent;
+    uint16_t target;
+};
+
+static struct {
+    const void *fdt;
+    struct blfdt_index_slot slots[BLFDT_INDEX_SLOTS];
+} idx_ctx;
+
+#define BLFDT_INDEX_MASK        (BLFDT_INDEX_SLOTS - 1)
+
+static uint32_t blfdt_index_hash(int parent, const char *name, int len)
+{
+    uint32_t hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    hash ^= (uint32_t)parent * 0x9E3779B1u;
+    return hash ^ (hash >> 16);
+}
+
+static void blfdt_index_insert(uint32_t hash, int parent, int target)
+{
+    uint32_t pos = hash & BLFDT_INDEX_MASK;
+
+    /* linear probing keeps entries of one key in insertion order, so a
+     * lookup returns the first match in tree order like libfdt does */
+    while (idx_ctx.slots[pos].target != BLFDT_INDEX_EMPTY) {
+        pos = (pos + 1) & BLFDT_INDEX_MASK;
+    }
+    idx_ctx.slots[pos].hash = (uint16_t)hash;
+    idx_ctx.slots[pos].parent = parent;
+    idx_ctx.slots[pos].target = target;
+}
+
+/* same matching rule as libfdt: "uart" matches "uart@4000A000" */
+static int blfdt_index_node_match(const void *fdt, int offset, const char *name, int namelen)
+{
+    const char *p;
+    int len;
+
+    p = fdt_get_name(fdt, offset, &len);
+    if (NULL == p || len < namelen || memcmp(p, name, namelen) != 0) {
+        return 0;
+    }
+    if (p[namelen] == '\0') {
+        return 1;
+    }
+    return (NULL == memchr(name, '@', namelen) && p[namelen] == '@');
+}
+
+static int blfdt_index_prop_match(const void *fdt, int offset, const char *name)
+{
+    const char *p = NULL;
+
+    if (NULL == fdt_getprop_by_offset(fdt, offset, &p, NULL) || NULL == p) {
+        return 0;
+    }
+    return (0 == strcmp(p, name));
+}
+
+/* name length without the unit address, -1 if there is none */
+static int blfdt_index_base_len(const char *name, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (name[i] == '@') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Index all nodes and properties of fdt, replacing any previous index.
+ *
+ * @return number of indexed entries, negative on error (lookups then use libfdt)
+ */
+int blfdt_index_build(const void *fdt)
+{
+    int depth, offset, prop, count, parent, base;
+    int parents[BLFDT_INDEX_MAX_DEPTH];
+    const char *name;
+    int len;
+
+    blfdt_index_release();
+    if (fdt_check_header(fdt) != 0 || fdt_totalsize(fdt) >= BLFDT_INDEX_EMPTY) {
+        return -1;
+    }
+    memset(idx_ctx.slots, 0xFF, sizeof(idx_ctx.slots));
+
+    count = 0;
+    depth = 0;
+    for (offset = 0; offset >= 0 && depth >= 0; offset = fdt_next_node(fdt, offset, &depth)) {
+        if (depth >= BLFDT_INDEX_MAX_DEPTH) {
+            return -1;
+        }
+        parents[depth] = offset;
+        if (depth > 0 && NULL != (name = fdt_get_name(fdt, offset, &len))) {
+            parent = parents[depth - 1];
+            base = blfdt_index_base_len(name, len);
+            count += (base < 0) ? 1 : 2;
+            if (count > BLFDT_INDEX_SLOTS * 3 / 4) {
+                return -1;
+            }
+            blfdt_index_insert(blfdt_index_hash(parent, name, len), parent, offset);
+            /* the unit address may be omitted in lookups */
+            if (base >= 0) {
+                blfdt_index_insert(blfdt_index_hash(parent, name, base), parent, offset);
+            }
+        }
+        fdt_for_each_property_offset(prop, fdt, offset) {
+            name = NULL;
+            if (fdt_getprop_by_offset(fdt, prop, &name, NULL) && name) {
+                if (++count > BLFDT_INDEX_SLOTS * 3 / 4) {
+                    return -1;
+                }
+                blfdt_index_insert(blfdt_index_hash(offset, name, strlen(name)), offset, prop);
+            }
+        }
+    }
+    idx_ctx.fdt = fdt;
+
+    return count;
+}
+
+void blfdt_index_release(void)
+{
+    idx_ctx.fdt = NULL;
+}
+
+int blfdt_index_is_active(const void *fdt)
+{
+    return (NULL != fdt && fdt == idx_ctx.fdt);
+}
+
+const void *blfdt_index_fdt(void)
+{
+    return idx_ctx.fdt;
+}
+
+static int blfdt_index_lookup(const void *fdt, int parent, const char *name, int namelen, int is_prop)
+{
+    uint32_t hash = blfdt_index_hash(parent, name, namelen);
+    uint32_t pos = hash & BLFDT_INDEX_MASK;
+    struct blfdt_index_slot *slot;
+
+    for (slot = &idx_ctx.slots[pos]; slot->target != BLFDT_INDEX_EMPTY; slot = &idx_ctx.slots[pos]) {
+        if (slot->hash == (uint16_t)hash && slot->parent == parent) {
+            if (is_prop ? blfdt_index_prop_match(fdt, slot->target, name) :
+                    blfdt_index_node_match(fdt, slot->target, name, namelen)) {
+                return slot->target;
+            }
+        }
+        pos = (pos + 1) & BLFDT_INDEX_MASK;
+    }
+    return -FDT_ERR_NOTFOUND;
+}
+
+int blfdt_subnode_offset(const void *fdt, int parentoffset, const char *name)
+{
+    if (!blfdt_index_is_active(fdt) || parentoffset < 0) {
+        return fdt_subnode_offset(fdt, parentoffset, name);
+    }
+    return blfdt_index_lookup(fdt, parentoffset, name, strlen(name), 0);
+}
+
+const void *blfdt_getprop(const void *fdt, int nodeoffset, const char *name, int *lenp)
+{
+    int offset;
+
+    if (!blfdt_index_is_active(fdt) || nodeoffset < 0) {
+        return fdt_getprop(fdt, nodeoffset, name, lenp);
+    }
+    offset = blfdt_index_lookup(fdt, nodeoffset, name, strlen(name), 1);
+    if (offset < 0) {
+        if (lenp) {
+            *lenp = offset;
+        }
+        return NULL;
+    }
+    return fdt_getprop_by_offset(fdt, offset, NULL, lenp);
+}
+
+int blfdt_stringlist_count(const void *fdt, int nodeoffset, const char *property)
+{
+    const char *list, *end;
+    int length, count = 0;
+
+    list = blfdt_getprop(fdt, nodeoffset, property, &length);
+    if (!list) {
+        return length;
+    }
+
+    end = list + length;
+    while (list < end) {
+        length = strnlen(list, end - list) + 1;
+        if (list + length > end) {
+            return -FDT_ERR_BADVALUE;
+        }
+        list += length;
+        count++;
+    }
+
+    return count;
+}
+
+const char *blfdt_stringlist_get(const void *fdt, int nodeoffset, const char *property, int idx, int *lenp)
+{
+    const char *list, *end;
+    int length;
+
+    list = blfdt_getprop(fdt, nodeoffset, property, &length);
+    if (!list) {
+        if (lenp) {
+            *lenp = length;
+        }
+        return NULL;
+    }
+
+    end = list + length;
+    while (list < end) {
+        length = strnlen(list, end - list) + 1;
+        if (list + length > end) {
+            if (lenp) {
+                *lenp = -FDT_ERR_BADVALUE;
+            }
+            return NULL;
+        }
+        if (idx == 0) {
+            if (lenp) {
+                *lenp = length - 1;
+            }
+            return list;
+        }
+        list += length;
+        idx--;
+    }
+
+    if (lenp) {
+        *lenp = -FDT_ERR_NOTFOUND;
+    }
+    return NULL;
+}
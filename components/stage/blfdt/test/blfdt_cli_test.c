@@ -45,9 +45,11 @@ void blfdt([[gnu::unused]] char *buf, [[gnu::unused]] int len, [[gnu::unused]] i
 {
     int tc_fdt_wifi(void);
     int tc_blfdtdump(void);
+    int tc_blfdt_index(void);
 
     tc_fdt_wifi();
     tc_blfdtdump();
+    tc_blfdt_index();
 }
 
 // STATIC_CLI_CMD_ATTRIBUTE makes this(these) command(s) static
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2020 Bouffalolab.
+ *
+ * This file is part of
+ *     *** Bouffalolab Software Dev Kit ***
+ *      (see www.bouffalolab.com).
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of Bouffalo Lab nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <libfdt.h>
+#include <blfdt_index.h>
+
+#include <utils_log.h>
+
+extern const uint8_t tc_wifi_dtb[];
+
+/* every node and property must resolve to the same offset and value through
+ * the index as through libfdt */
+static int tc_blfdt_index_compare(const void *fdt)
+{
+    int depth = 0, offset, parent, prop, len_fdt, len_idx;
+    int parents[16];
+    const char *name;
+    char base[64];
+    const void *val_fdt, *val_idx;
+    int checked = 0;
+
+    for (offset = 0; offset >= 0 && depth >= 0; offset = fdt_next_node(fdt, offset, &depth)) {
+        if (depth >= 16) {
+            continue;
+        }
+        parents[depth] = offset;
+        if (depth > 0) {
+            parent = parents[depth - 1];
+            name = fdt_get_name(fdt, offset, NULL);
+            if (fdt_subnode_offset(fdt, parent, name) != blfdt_subnode_offset(fdt, parent, name)) {
+                log_error("node %s mismatch\r\n", name);
+                return -1;
+            }
+            /* lookup without the unit address */
+            strncpy(base, name, sizeof(base) - 1);
+            base[sizeof(base) - 1] = '\0';
+            if (strchr(base, '@')) {
+                *strchr(base, '@') = '\0';
+                if (fdt_subnode_offset(fdt, parent, base) != blfdt_subnode_offset(fdt, parent, base)) {
+                    log_error("node %s mismatch\r\n", base);
+                    return -1;
+                }
+            }
+            checked++;
+        }
+        fdt_for_each_property_offset(prop, fdt, offset) {
+            fdt_getprop_by_offset(fdt, prop, &name, NULL);
+            val_fdt = fdt_getprop(fdt, offset, name, &len_fdt);
+            val_idx = blfdt_getprop(fdt, offset, name, &len_idx);
+            if (val_fdt != val_idx || len_fdt != len_idx) {
+                log_error("prop %s mismatch\r\n", name);
+                return -1;
+            }
+            checked++;
+        }
+    }
+
+    /* misses must be reported the same way */
+    if (fdt_subnode_offset(fdt, 0, "no_such_node") != blfdt_subnode_offset(fdt, 0, "no_such_node")) {
+        log_error("missing node mismatch\r\n");
+        return -1;
+    }
+    val_fdt = fdt_getprop(fdt, 0, "no_such_prop", &len_fdt);
+    val_idx = blfdt_getprop(fdt, 0, "no_such_prop", &len_idx);
+    if (val_fdt != val_idx || len_fdt != len_idx) {
+        log_error("missing prop mismatch\r\n");
+        return -1;
+    }
+
+    log_info("%d entries checked\r\n", checked);
+    return 0;
+}
+
+int tc_blfdt_index(void)
+{
+    const void *fdt = (const void *)tc_wifi_dtb;
+    const void *board_fdt = blfdt_index_fdt();
+    int result;
+
+    if (blfdt_index_build(fdt) < 0) {
+        printf("fdt index build failed\r\n");
+        return -1;
+    }
+    result = tc_blfdt_index_compare(fdt);
+
+    /* give the index back to the board dtb */
+    blfdt_index_release();
+    if (board_fdt) {
+        blfdt_index_build(board_fdt);
+    }
+
+    if (result) {
+        printf("fdt index failed\r\n");
+    } else {
+        printf("fdt index successed\r\n");
+    }
+
+    return result;
+}
@@ -0,0 +1,182 @@
+/*
+ * Host test of the blfdt lookup index. Every dtb given on the command line
+ * has to fit the index, and every node, property and string list lookup
+ * through it has to give what libfdt gives. A generated dtb too large for
+ * the table checks that the lookups then fall back to libfdt. From this
+ * directory:
+ *
+ *   gcc -I../inc ../src/blfdt_index.c ../src/fdt.c ../src/fdt_ro.c ../src/fdt_sw.c ../src/fdt_strerror.c test_blfdt_index.c -o test_blfdt_index
+ *   ./test_blfdt_index board.dtb ...
+ *
+ * test_blfdt_index.sh converts every dts in the tree and runs it on them.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libfdt.h>
+#include <blfdt_index.h>
+
+#define MAX_DEPTH   16
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+static void check_node(const void *fdt, int parent, const char *name)
+{
+    int expect = fdt_subnode_offset(fdt, parent, name);
+    int got = blfdt_subnode_offset(fdt, parent, name);
+
+    CHECK(got == expect, "node %s under %d: %d, libfdt %d", name, parent, got, expect);
+}
+
+static void check_prop(const void *fdt, int node, const char *name)
+{
+    const void *val_fdt, *val_idx;
+    const char *str_fdt, *str_idx;
+    int len_fdt, len_idx, count, i;
+
+    val_fdt = fdt_getprop(fdt, node, name, &len_fdt);
+    val_idx = blfdt_getprop(fdt, node, name, &len_idx);
+    CHECK(val_idx == val_fdt && len_idx == len_fdt, "prop %s of %d: %p/%d, libfdt %p/%d",
+          name, node, val_idx, len_idx, val_fdt, len_fdt);
+
+    count = fdt_stringlist_count(fdt, node, name);
+    CHECK(blfdt_stringlist_count(fdt, node, name) == count, "prop %s of %d: string count %d, libfdt %d",
+          name, node, blfdt_stringlist_count(fdt, node, name), count);
+    for (i = 0; i <= count; i++) {
+        str_fdt = fdt_stringlist_get(fdt, node, name, i, &len_fdt);
+        str_idx = blfdt_stringlist_get(fdt, node, name, i, &len_idx);
+        CHECK(str_idx == str_fdt && len_idx == len_fdt, "prop %s of %d: string %d differs", name, node, i);
+    }
+}
+
+/* every lookup the tree allows, with and without the unit address */
+static int check_tree(const void *fdt)
+{
+    int parents[MAX_DEPTH];
+    int depth = 0, offset, prop, checked = 0;
+    const char *name;
+    char base[64];
+
+    for (offset = 0; offset >= 0 && depth >= 0; offset = fdt_next_node(fdt, offset, &depth)) {
+        CHECK(depth < MAX_DEPTH, "tree deeper than %d", MAX_DEPTH);
+        if (depth >= MAX_DEPTH) {
+            return checked;
+        }
+        parents[depth] = offset;
+        if (depth > 0) {
+            name = fdt_get_name(fdt, offset, NULL);
+            check_node(fdt, parents[depth - 1], name);
+            snprintf(base, sizeof(base), "%s", name);
+            if (strchr(base, '@')) {
+                *strchr(base, '@') = '\0';
+                check_node(fdt, parents[depth - 1], base);
+            }
+            check_node(fdt, offset, "no_such_node");
+            checked++;
+        }
+        fdt_for_each_property_offset(prop, fdt, offset) {
+            fdt_getprop_by_offset(fdt, prop, &name, NULL);
+            check_prop(fdt, offset, name);
+            checked++;
+        }
+        check_prop(fdt, offset, "no_such_prop");
+    }
+    return checked;
+}
+
+static void *load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    long size;
+    void *buf;
+
+    if (NULL == f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(size > 0 ? size : 1);
+    if (buf && fread(buf, 1, size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+static void test_dtb(const char *path)
+{
+    void *fdt = load(path);
+    int entries, checked;
+
+    CHECK(fdt != NULL, "%s: cannot read", path);
+    if (NULL == fdt) {
+        return;
+    }
+    CHECK(fdt_check_header(fdt) == 0, "%s: not a dtb", path);
+
+    entries = blfdt_index_build(fdt);
+    CHECK(entries > 0, "%s: does not fit the index (%d)", path, entries);
+    CHECK(blfdt_index_is_active(fdt), "%s: index not active", path);
+    checked = check_tree(fdt);
+    printf("%s: %d entries, %d lookups checked\r\n", path, entries, checked);
+
+    blfdt_index_release();
+    CHECK(!blfdt_index_is_active(fdt), "%s: index still active", path);
+    free(fdt);
+}
+
+/* a node with more properties than the table holds */
+static void test_overflow(void)
+{
+    static char fdt[64 * 1024];
+    char name[16];
+    uint32_t val;
+    int i;
+
+    CHECK(fdt_create(fdt, sizeof(fdt)) == 0, "fdt_create");
+    fdt_finish_reservemap(fdt);
+    fdt_begin_node(fdt, "");
+    fdt_begin_node(fdt, "big@1000");
+    for (i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), "p%d", i);
+        val = i;
+        fdt_property(fdt, name, &val, sizeof(val));
+    }
+    fdt_end_node(fdt);
+    fdt_end_node(fdt);
+    CHECK(fdt_finish(fdt) == 0, "fdt_finish");
+
+    CHECK(blfdt_index_build(fdt) < 0, "oversized dtb indexed");
+    CHECK(!blfdt_index_is_active(fdt), "index active after a failed build");
+    check_tree(fdt);
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+
+    if (argc < 2) {
+        printf("usage: %s board.dtb ...\r\n", argv[0]);
+        return 2;
+    }
+    for (i = 1; i < argc; i++) {
+        test_dtb(argv[i]);
+    }
+    test_overflow();
+
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
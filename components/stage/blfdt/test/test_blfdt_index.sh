@@ -0,0 +1,60 @@
+#!/bin/sh
+##
+## Copyright (c) 2020 Bouffalolab.
+##
+## This file is part of
+##     *** Bouffalolab Software Dev Kit ***
+##      (see www.bouffalolab.com).
+##
+## Redistribution and use in source and binary forms, with or without modification,
+## are permitted provided that the following conditions are met:
+##   1. Redistributions of source code must retain the above copyright notice,
+##      this list of conditions and the following disclaimer.
+##   2. Redistributions in binary form must reproduce the above copyright notice,
+##      this list of conditions and the following disclaimer in the documentation
+##      and/or other materials provided with the distribution.
+##   3. Neither the name of Bouffalo Lab nor the names of its contributors
+##      may be used to endorse or promote products derived from this software
+##      without specific prior written permission.
+##
+## THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+## AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+## IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+## DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+## FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+## DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+## SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+## CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+## OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+## OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+##
+
+# Build the lookup index for every dts in the tree on the host and check it
+# against libfdt. The dts are converted the way image_conf/flash_build.py
+# does it, with the python fdt module.
+
+cd $(dirname $0)
+top=../../../..
+out=$(mktemp -d)
+trap 'rm -rf $out' EXIT
+
+gcc -I../inc ../src/blfdt_index.c ../src/fdt.c ../src/fdt_ro.c ../src/fdt_sw.c ../src/fdt_strerror.c \
+    test_blfdt_index.c -o $out/test_blfdt_index || exit 1
+
+dtbs=
+for dts in $(find $top -name '*.dts' -not -path '*/build_out/*'); do
+    dtb=$out/$(echo ${dts#$top/} | tr '/' '_').dtb
+    if python3 -c "import fdt, os, sys
+src = sys.argv[1]
+with open(src) as f:
+    tree = fdt.parse_dts(f.read(), os.path.dirname(src))
+with open(sys.argv[2], 'wb') as f:
+    f.write(tree.to_dtb(version=17))" $dts $dtb 2>/dev/null; then
+        dtbs="$dtbs $dtb"
+    else
+        # e.g. an /include/ of a dtsi the tree does not ship
+        echo "skipped $dts: cannot convert"
+    fi
+done
+
+$out/test_blfdt_index $dtbs
@@ -12,12 +12,17 @@ COMPONENT_SRCS := src/yloop.c \
                   src/aos_freertos.c \
                   src/device.c \
                   src/local_event.c \
+                  src/yloop_pool.c \
 
 
 COMPONENT_OBJS := $(patsubst %.c,%.o, $(COMPONENT_SRCS))
 
 COMPONENT_SRCDIRS := src
 
+ifneq ($(CONFIG_YLOOP_TIMEOUT_POOL_SIZE),)
+CFLAGS += -DYLOOP_TIMEOUT_POOL_SIZE=$(CONFIG_YLOOP_TIMEOUT_POOL_SIZE)
+endif
+
 ifeq ($(CONFIG_USE_STDLIB_MALLOC), 1)
 CFLAGS += -DUSE_STDLIB_MALLOC
 endif
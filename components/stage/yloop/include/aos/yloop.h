@@ -10,6 +10,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <aos/list.h>
 #include <event_type_code.h>
 
 #ifndef AOS_DOXYGEN_MODE
@@ -117,6 +118,31 @@ typedef void (*aos_call_t)(void *arg);
 /* Delayed execution callback */
 typedef void (*aos_poll_call_t)(int fd, void *arg);
 
+/*
+ * Delayed action node, may be embedded in a caller's struct and posted with
+ * aos_post_delayed_node() without any allocation. Zero it before first use.
+ */
+typedef struct aos_delayed_node {
+    dlist_t     next;
+    long long   timeout_ms;
+    void       *private_data;
+    aos_call_t  cb;
+    int         ms;
+    uint8_t     flags;
+} aos_delayed_node_t;
+
+/* yloop object pools */
+#define AOS_LOOP_POOL_TIMEOUT        0
+
+typedef struct {
+    uint16_t capacity;      /* objects in the static pool */
+    uint16_t used;          /* pool objects in use */
+    uint16_t peak;          /* high-water mark of used */
+    uint16_t heap_used;     /* heap objects in use, pool was exhausted */
+    uint32_t heap_fallback; /* allocations that missed the pool */
+    uint32_t alloc_fail;    /* allocations that missed the heap too */
+} aos_loop_pool_stats_t;
+
 /**
  * Register system event filter callback.
  *
@@ -190,6 +216,36 @@ int aos_post_delayed_action(int ms, aos_call_t action, void *arg);
  */
 void aos_cancel_delayed_action(int ms, aos_call_t action, void *arg);
 
+/**
+ * Post a caller-owned delayed action node to be executed in main loop.
+ * The node is not freed by the loop and may be posted again from action.
+ *
+ * @param[in]  node    zeroed or previously used node, not pending.
+ * @param[in]  ms      milliseconds to wait.
+ * @param[in]  action  action to be executed.
+ * @param[in]  arg     private data past to action.
+ *
+ * @return  the operation status, 0 is OK, -EBUSY if node is pending.
+ */
+int aos_post_delayed_node(aos_delayed_node_t *node, int ms, aos_call_t action, void *arg);
+
+/**
+ * Cancel a pending delayed action node, no-op if it is not pending.
+ *
+ * @param[in]  node    node posted by aos_post_delayed_node.
+ */
+void aos_cancel_delayed_node(aos_delayed_node_t *node);
+
+/**
+ * Get the statistics of a yloop object pool.
+ *
+ * @param[in]   pool   AOS_LOOP_POOL_TIMEOUT.
+ * @param[out]  stats  pool statistics.
+ *
+ * @return  the operation status, 0 is OK, others is error.
+ */
+int aos_loop_pool_stats(int pool, aos_loop_pool_stats_t *stats);
+
 
 /**
  * Schedule a callback in next event loop.
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2015-2017 Alibaba Group Holding Limited
+ */
+
+#ifndef YLOOP_POOL_H
+#define YLOOP_POOL_H
+
+#include <stdint.h>
+#include <aos/yloop.h>
+
+/*
+ * Fixed-size object pool with heap fallback.
+ * Objects are carved from a static array on first use and recycled through
+ * a free list linked via their first word, so objects must be at least
+ * pointer sized. When the array is used up the object comes from the heap.
+ */
+typedef struct {
+    void     *free;
+    uint8_t  *base;
+    uint16_t  size;
+    uint16_t  cap;
+    uint16_t  carved;
+    uint16_t  used;
+    uint16_t  peak;
+    uint16_t  heap_used;
+    uint32_t  heap_fallback;
+    uint32_t  alloc_fail;
+} yloop_pool_t;
+
+#define YLOOP_POOL_DEFINE(name, type, n)                            \
+    static type name##_mem[n];                                      \
+    static yloop_pool_t name = {                                    \
+        .base = (uint8_t *)name##_mem,                              \
+        .size = sizeof(type),                                       \
+        .cap  = (n),                                                \
+    }
+
+/* aos_delayed_node_t flags */
+#define YLOOP_NODE_USER     0x01    /* owned by the caller, never freed */
+#define YLOOP_NODE_PENDING  0x02    /* linked in a loop or queued */
+
+void *yloop_pool_alloc(yloop_pool_t *pool);
+void  yloop_pool_free(yloop_pool_t *pool, void *obj);
+void  yloop_pool_get_stats(yloop_pool_t *pool, aos_loop_pool_stats_t *stats);
+
+#endif /* YLOOP_POOL_H */
@@ -17,17 +17,17 @@
 
 
 #include "yloop.h"
+#include "yloop_pool.h"
 
 #define TAG "yloop"
 
-typedef struct yloop_timeout_s {
-    dlist_t          next;
-    long long        timeout_ms;
-    void            *private_data;
-    aos_call_t       cb;
-    int              ms;
-} yloop_timeout_t;
+#ifndef YLOOP_TIMEOUT_POOL_SIZE
+#define YLOOP_TIMEOUT_POOL_SIZE 16
+#endif
 
+typedef aos_delayed_node_t yloop_timeout_t;
+
+YLOOP_POOL_DEFINE(g_timeout_pool, yloop_timeout_t, YLOOP_TIMEOUT_POOL_SIZE);
 
 yloop_ctx_t    *g_main_ctx = NULL;
 static aos_task_key_t  g_loop_key;
@@ -170,24 +170,24 @@ void aos_cancel_poll_read_fd(int sock, [[gnu::unused]] aos_poll_call_t action, [
     ctx->reader_count--;
 }
 
-int aos_post_delayed_action(int ms, aos_call_t action, void *param)
+static void _timeout_release(yloop_timeout_t *timeout)
 {
-    if (action == NULL) {
-        return -EINVAL;
+    timeout->flags &= ~YLOOP_NODE_PENDING;
+    if (!(timeout->flags & YLOOP_NODE_USER)) {
+        yloop_pool_free(&g_timeout_pool, timeout);
     }
+}
 
-    yloop_ctx_t *ctx = get_context();
-    yloop_timeout_t *timeout = pvPortMalloc(sizeof(*timeout));
-    if (timeout == NULL) {
-        return -ENOMEM;
-    }
+static void _timeout_add(yloop_ctx_t *ctx, yloop_timeout_t *timeout, int ms,
+                         aos_call_t action, void *param)
+{
+    yloop_timeout_t *tmp;
 
     timeout->timeout_ms = aos_now_ms() + ms;
     timeout->private_data = param;
     timeout->cb = action;
     timeout->ms = ms;
-
-    yloop_timeout_t *tmp;
+    timeout->flags |= YLOOP_NODE_PENDING;
 
     dlist_for_each_entry(&ctx->timeouts, tmp, yloop_timeout_t, next) {
         if (timeout->timeout_ms < tmp->timeout_ms) {
@@ -196,10 +196,52 @@ int aos_post_delayed_action(int ms, aos_call_t action, void *param)
     }
 
     dlist_add_tail(&timeout->next, &tmp->next);
+}
+
+int aos_post_delayed_action(int ms, aos_call_t action, void *param)
+{
+    if (action == NULL) {
+        return -EINVAL;
+    }
+
+    yloop_ctx_t *ctx = get_context();
+    yloop_timeout_t *timeout = yloop_pool_alloc(&g_timeout_pool);
+    if (timeout == NULL) {
+        return -ENOMEM;
+    }
+
+    timeout->flags = 0;
+    _timeout_add(ctx, timeout, ms, action, param);
 
     return 0;
 }
 
+int aos_post_delayed_node(aos_delayed_node_t *node, int ms, aos_call_t action, void *param)
+{
+    if (node == NULL || action == NULL) {
+        return -EINVAL;
+    }
+
+    if (node->flags & YLOOP_NODE_PENDING) {
+        return -EBUSY;
+    }
+
+    node->flags = YLOOP_NODE_USER;
+    _timeout_add(get_context(), node, ms, action, param);
+
+    return 0;
+}
+
+void aos_cancel_delayed_node(aos_delayed_node_t *node)
+{
+    if (node == NULL || !(node->flags & YLOOP_NODE_PENDING)) {
+        return;
+    }
+
+    dlist_del(&node->next);
+    _timeout_release(node);
+}
+
 void aos_cancel_delayed_action(int ms, aos_call_t cb, void *private_data)
 {
     yloop_ctx_t *ctx = get_context();
@@ -219,7 +261,7 @@ void aos_cancel_delayed_action(int ms, aos_call_t cb, void *private_data)
         }
 
         dlist_del(&tmp->next);
-        vPortFree(tmp);
+        _timeout_release(tmp);
         return;
     }
 }
@@ -263,9 +305,13 @@ void aos_loop_run(void)
             long long now = aos_now_ms();
 
             if (now >= tmo->timeout_ms) {
+                aos_call_t cb = tmo->cb;
+                void *private_data = tmo->private_data;
+
+                /* release first so that cb may post the node or reuse the slot */
                 dlist_del(&tmo->next);
-                tmo->cb(tmo->private_data);
-                vPortFree(tmo);
+                _timeout_release(tmo);
+                cb(private_data);
             }
         }
 
@@ -305,7 +351,7 @@ void aos_loop_destroy(void)
         yloop_timeout_t *timeout = dlist_first_entry(&ctx->timeouts, yloop_timeout_t,
                                                      next);
         dlist_del(&timeout->next);
-        vPortFree(timeout);
+        _timeout_release(timeout);
     }
 
     vPortFree(ctx->readers);
@@ -318,3 +364,18 @@ void aos_loop_destroy(void)
     vPortFree(ctx);
 }
 
+
+int aos_loop_pool_stats(int pool, aos_loop_pool_stats_t *stats)
+{
+    if (stats == NULL) {
+        return -EINVAL;
+    }
+
+    switch (pool) {
+    case AOS_LOOP_POOL_TIMEOUT:
+        yloop_pool_get_stats(&g_timeout_pool, stats);
+        return 0;
+    default:
+        return -EINVAL;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2015-2017 Alibaba Group Holding Limited
+ */
+
+#include <stddef.h>
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "yloop_pool.h"
+
+static inline int _in_pool(yloop_pool_t *pool, void *obj)
+{
+    uint8_t *p = obj;
+
+    return p >= pool->base && p < pool->base + (size_t)pool->size * pool->cap;
+}
+
+void *yloop_pool_alloc(yloop_pool_t *pool)
+{
+    void *obj;
+
+    taskENTER_CRITICAL();
+    obj = pool->free;
+    if (obj) {
+        pool->free = *(void **)obj;
+    } else if (pool->carved < pool->cap) {
+        obj = pool->base + (size_t)pool->size * pool->carved++;
+    }
+    if (obj) {
+        if (++pool->used > pool->peak) {
+            pool->peak = pool->used;
+        }
+    } else {
+        pool->heap_fallback++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (obj) {
+        return obj;
+    }
+
+    obj = pvPortMalloc(pool->size);
+    taskENTER_CRITICAL();
+    if (obj) {
+        pool->heap_used++;
+    } else {
+        pool->alloc_fail++;
+    }
+    taskEXIT_CRITICAL();
+
+    return obj;
+}
+
+void yloop_pool_free(yloop_pool_t *pool, void *obj)
+{
+    if (obj == NULL) {
+        return;
+    }
+
+    if (!_in_pool(pool, obj)) {
+        vPortFree(obj);
+        taskENTER_CRITICAL();
+        pool->heap_used--;
+        taskEXIT_CRITICAL();
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    *(void **)obj = pool->free;
+    pool->free = obj;
+    pool->used--;
+    taskEXIT_CRITICAL();
+}
+
+void yloop_pool_get_stats(yloop_pool_t *pool, aos_loop_pool_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    stats->capacity      = pool->cap;
+    stats->used          = pool->used;
+    stats->peak          = pool->peak;
+    stats->heap_used     = pool->heap_used;
+    stats->heap_fallback = pool->heap_fallback;
+    stats->alloc_fail    = pool->alloc_fail;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,48 @@
+/* Host test stand-in, enough for yloop and heap_5.c */
+#ifndef TEST_FREERTOS_H
+#define TEST_FREERTOS_H
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#define configSUPPORT_DYNAMIC_ALLOCATION    1
+#define configUSE_MALLOC_FAILED_HOOK        0
+#define configASSERT(x)                     assert(x)
+#define portBYTE_ALIGNMENT                  8
+#define portBYTE_ALIGNMENT_MASK             (portBYTE_ALIGNMENT - 1)
+#define portMAX_DELAY                       ((size_t)-1)
+#define PRIVILEGED_FUNCTION
+#define traceMALLOC(addr, size)
+#define traceFREE(addr, size)
+#define mtCOVERAGE_TEST_MARKER()
+
+typedef long BaseType_t;
+
+typedef struct HeapRegion {
+    uint8_t *pucStartAddress;
+    size_t xSizeInBytes;
+} HeapRegion_t;
+
+typedef struct xHeapStats {
+    size_t xAvailableHeapSpaceInBytes;
+    size_t xSizeOfLargestFreeBlockInBytes;
+    size_t xSizeOfSmallestFreeBlockInBytes;
+    size_t xNumberOfFreeBlocks;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+} HeapStats_t;
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+void vPortDefineHeapRegions(const HeapRegion_t *regions);
+void vPortGetHeapStats(HeapStats_t *stats);
+size_t xPortGetFreeHeapSize(void);
+
+/* single threaded */
+static inline void vTaskSuspendAll(void) {}
+static inline BaseType_t xTaskResumeAll(void) { return 0; }
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif
@@ -0,0 +1,276 @@
+/*
+ * Host soak test of the yloop timeouts on the FreeRTOS heap_5 allocator,
+ * driven by a virtual clock. Re-arming timers, one-shot actions that are
+ * cancelled at random, a caller-owned node and application buffers of
+ * random size and lifetime run for a million loop iterations. Every action
+ * has to run exactly at its expiry and once, and the timeout pool and the
+ * heap have to be back where they started after aos_loop_destroy. From
+ * this directory:
+ *
+ *   gcc -I. -I../include test_yloop_soak.c ../src/yloop.c ../src/yloop_pool.c ../../../freertos/portable/MemMang/heap_5.c -o test_yloop_soak
+ *   ./test_yloop_soak
+ *
+ * Built with -DYLOOP_TIMEOUT_POOL_SIZE=1 nearly every timeout comes from
+ * the heap, for a comparison of the fragmentation.
+ */
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <aos/kernel.h>
+#include <aos/yloop.h>
+#include <yloop_types.h>
+#include <vfs.h>
+#include "yloop.h"
+
+#define ITERATIONS  1000000
+#define TIMERS      12
+#define ONESHOTS    24
+#define APP_SLOTS   64
+#define NODE_MS     7
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\r\n"); \
+        failures++; \
+    } \
+} while (0)
+
+struct action {
+    long long due;
+    int pending;
+    unsigned fired;
+};
+
+static long long now_ms;
+static long iter;
+static void *loop_ctx;
+
+static struct action timers[TIMERS];
+static struct action oneshots[ONESHOTS];
+static struct action node_action;
+static aos_delayed_node_t node;
+static unsigned posted, cancelled, oneshot_fired, fired;
+static long long last_due;
+
+static void *app[APP_SLOTS];
+static long long app_end[APP_SLOTS];
+
+static uint8_t heap[96 * 1024] __attribute__((aligned(8)));
+
+/* what yloop needs from the kernel and vfs */
+long long aos_now_ms(void)
+{
+    return now_ms;
+}
+
+int aos_task_key_create(aos_task_key_t *key)
+{
+    *key = 0;
+    return 0;
+}
+
+int aos_task_setspecific(aos_task_key_t key, void *vp)
+{
+    (void)key;
+    loop_ctx = vp;
+    return 0;
+}
+
+void *aos_task_getspecific(aos_task_key_t key)
+{
+    (void)key;
+    return loop_ctx;
+}
+
+int aos_event_service_init(void)
+{
+    return 0;
+}
+
+void aos_event_service_deinit(int fd)
+{
+    (void)fd;
+}
+
+int aos_fcntl(int fd, int cmd, int val)
+{
+    (void)fd;
+    (void)cmd;
+    (void)val;
+    return 0;
+}
+
+static uint32_t rnd(void)
+{
+    static uint32_t x = 2463534242u;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+/* sleeping in poll moves the clock, the application allocates meanwhile */
+int aos_poll(struct pollfd *fds, int nfds, int timeout)
+{
+    int i = rnd() % APP_SLOTS;
+
+    (void)fds;
+    (void)nfds;
+    CHECK(timeout >= 0, "loop sleeps forever with timers pending");
+    now_ms += timeout > 0 ? timeout : 0;
+
+    if (app[i] && now_ms >= app_end[i]) {
+        vPortFree(app[i]);
+        app[i] = NULL;
+    }
+    if (!app[i]) {
+        app[i] = pvPortMalloc(16 + rnd() % 480);
+        app_end[i] = now_ms + rnd() % 2000;
+    }
+    if (++iter >= ITERATIONS) {
+        aos_loop_exit();
+    }
+    return 0;
+}
+
+static void fire(struct action *a, const char *what)
+{
+    CHECK(a->pending, "%s fired while not pending", what);
+    CHECK(now_ms == a->due, "%s fired at %lld, due %lld", what, now_ms, a->due);
+    CHECK(a->due >= last_due, "%s due %lld fired after %lld", what, a->due, last_due);
+    last_due = a->due;
+    a->pending = 0;
+    a->fired++;
+    fired++;
+}
+
+static void oneshot_cb(void *arg)
+{
+    fire(arg, "oneshot");
+    oneshot_fired++;
+}
+
+static void post_oneshot(void)
+{
+    struct action *a = &oneshots[rnd() % ONESHOTS];
+    int ms = 1 + rnd() % 50;
+
+    if (a->pending) {
+        /* one pending post per action, so that a cancel finds it */
+        aos_cancel_delayed_action(-1, oneshot_cb, a);
+        a->pending = 0;
+        cancelled++;
+        return;
+    }
+    CHECK(aos_post_delayed_action(ms, oneshot_cb, a) == 0, "post oneshot");
+    a->due = now_ms + ms;
+    a->pending = 1;
+    posted++;
+}
+
+/* a busy application re-arms its timers from the callbacks */
+static void timer_cb(void *arg)
+{
+    struct action *a = arg;
+    int ms = 1 + rnd() % 500;
+
+    fire(a, "timer");
+    CHECK(aos_post_delayed_action(ms, timer_cb, a) == 0, "re-arm timer");
+    a->due = now_ms + ms;
+    a->pending = 1;
+    if (rnd() % 4 == 0) {
+        post_oneshot();
+    }
+}
+
+static void node_cb(void *arg)
+{
+    fire(arg, "node");
+    /* the node is released before its action runs and can be posted again */
+    CHECK(aos_post_delayed_node(&node, NODE_MS, node_cb, arg) == 0, "re-post node");
+    node_action.due = now_ms + NODE_MS;
+    node_action.pending = 1;
+    CHECK(aos_post_delayed_node(&node, NODE_MS, node_cb, arg) == -EBUSY, "node posted twice");
+}
+
+static void report(const char *tag)
+{
+    HeapStats_t heap_stats;
+    aos_loop_pool_stats_t pool;
+
+    vPortGetHeapStats(&heap_stats);
+    aos_loop_pool_stats(AOS_LOOP_POOL_TIMEOUT, &pool);
+    printf("%-6s heap free %6u largest %6u blocks %3u | pool used %u peak %u/%u heap %u fallback %u\r\n",
+           tag, (unsigned)heap_stats.xAvailableHeapSpaceInBytes,
+           (unsigned)heap_stats.xSizeOfLargestFreeBlockInBytes,
+           (unsigned)heap_stats.xNumberOfFreeBlocks,
+           pool.used, pool.peak, pool.capacity, pool.heap_used, (unsigned)pool.heap_fallback);
+}
+
+int main(void)
+{
+    HeapRegion_t regions[] = {{heap, sizeof(heap)}, {NULL, 0}};
+    aos_loop_pool_stats_t pool;
+    size_t heap_start;
+    unsigned left;
+    int i;
+
+    vPortDefineHeapRegions(regions);
+    heap_start = xPortGetFreeHeapSize();
+    aos_loop_init();
+    report("start");
+
+    for (i = 0; i < TIMERS; i++) {
+        CHECK(aos_post_delayed_action(1 + i, timer_cb, &timers[i]) == 0, "post timer");
+        timers[i].due = 1 + i;
+        timers[i].pending = 1;
+    }
+
+    /* a pending node can be cancelled and posted again, once */
+    CHECK(aos_post_delayed_node(&node, NODE_MS, node_cb, &node_action) == 0, "post node");
+    CHECK(aos_post_delayed_node(&node, NODE_MS, node_cb, &node_action) == -EBUSY, "node posted twice");
+    aos_cancel_delayed_node(&node);
+    aos_cancel_delayed_node(&node);
+    CHECK(aos_post_delayed_node(&node, NODE_MS, node_cb, &node_action) == 0, "post cancelled node");
+    node_action.due = NODE_MS;
+    node_action.pending = 1;
+
+    aos_loop_run();
+    report("run");
+
+    CHECK(node_action.fired == node_action.due / NODE_MS - 1, "node fired %u times by %lld",
+          node_action.fired, node_action.due);
+    left = 0;
+    for (i = 0; i < ONESHOTS; i++) {
+        left += oneshots[i].pending;
+    }
+    CHECK(posted == cancelled + oneshot_fired + left, "oneshots posted %u cancelled %u fired %u pending %u",
+          posted, cancelled, oneshot_fired, left);
+
+    for (i = 0; i < APP_SLOTS; i++) {
+        vPortFree(app[i]);
+        app[i] = NULL;
+    }
+    aos_loop_destroy();
+    report("end");
+
+    aos_loop_pool_stats(AOS_LOOP_POOL_TIMEOUT, &pool);
+    CHECK(pool.used == 0 && pool.heap_used == 0, "timeouts left: pool %u heap %u", pool.used, pool.heap_used);
+    CHECK(pool.alloc_fail == 0, "%u timeouts not allocated", (unsigned)pool.alloc_fail);
+    CHECK(pool.peak <= pool.capacity, "peak %u over capacity %u", pool.peak, pool.capacity);
+    CHECK(xPortGetFreeHeapSize() == heap_start, "heap leaked %d bytes",
+          (int)(heap_start - xPortGetFreeHeapSize()));
+
+    printf("%u actions fired, %u oneshots cancelled\r\n", fired, cancelled);
+    printf("%s\r\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
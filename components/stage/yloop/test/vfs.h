@@ -0,0 +1,9 @@
+/* Host test stand-in, the test provides the loop's poll */
+#ifndef TEST_VFS_H
+#define TEST_VFS_H
+#include <yloop_types.h>
+
+int aos_poll(struct pollfd *fds, int nfds, int timeout);
+int aos_fcntl(int fd, int cmd, int val);
+
+#endif
@@ -33,5 +33,7 @@
 
 uint16_t utils_crc16(void *dataIn, uint32_t len);
 uint32_t utils_crc32(void *dataIn, uint32_t len);
+/* CRC-32 of data following the bytes crc was returned for, 0 to start */
+uint32_t utils_crc32_update(uint32_t crc, const void *dataIn, uint32_t len);
 
 #endif
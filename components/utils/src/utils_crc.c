@@ -156,10 +156,9 @@ static const uint32_t crc32Tab[256] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
-uint32_t utils_crc32(void *dataIn, uint32_t len)
+uint32_t utils_crc32_update(uint32_t crc, const void *dataIn, uint32_t len)
 {
-    uint32_t crc=0;
-  uint8_t *data=(uint8_t *)dataIn;
+    const uint8_t *data = (const uint8_t *)dataIn;
 
     crc = crc ^ 0xffffffff;
 
@@ -168,3 +167,8 @@ uint32_t utils_crc32(void *dataIn, uint32_t len)
 
     return crc ^ 0xffffffff;
 }
+
+uint32_t utils_crc32(void *dataIn, uint32_t len)
+{
+    return utils_crc32_update(0, dataIn, len);
+}
@@ -50,7 +50,6 @@ static void Bl_F_fast(unsigned char digest[36], unsigned char digest1[A_SHA_DIGE
     digest[ssidlength+2] = (unsigned char)((count>>8) & 0xff);
     digest[ssidlength+3] = (unsigned char)(count & 0xff);
 
-    bl_sha_mutex_take();
     utils_hmac_sha1_fast(&pTemp,
                    &tmpLen,
                    1,
@@ -83,7 +82,6 @@ static void Bl_F_fast(unsigned char digest[36], unsigned char digest1[A_SHA_DIGE
             output[j] ^= digest[j];
         }
     }
-    bl_sha_mutex_give();
 }
 
 int utils_wifi_psk_cal_fast_bin(char *password, unsigned char *ssid, int ssidlength, unsigned char *output)
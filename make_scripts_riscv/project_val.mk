@@ -31,3 +31,11 @@ endif
 ifeq ($(CONFIG_SYS_BIG_DEBUG_BUFFER),1)
 CPPFLAGS += -DSYS_BIG_DEBUG_BUFFER=1
 endif
+
+ifeq ($(CONFIG_COREDUMP),1)
+CPPFLAGS += -DCFG_COREDUMP=1
+endif
+
+ifeq ($(CONFIG_CPU_PROFILE),1)
+CPPFLAGS += -DCFG_CPU_PROFILE=1
+endif
@@ -0,0 +1,194 @@
+#!/bin/env python3
+
+# Decode the crash record printed by "coredump hex", built with
+# CONFIG_COREDUMP=1, and symbolize it against the ELF of that build.
+#
+#   coredump.py build_out/app.elf console.log
+#   coredump.py build_out/app.elf < console.log
+#   coredump.py --raw build_out/app.elf record.bin
+#
+# The layout is the one of components/hal_drv/bl602_hal/bl_coredump_record.h.
+
+import argparse
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import zlib
+
+ADDR2LINE = 'riscv32-unknown-elf-addr2line'
+
+START = re.compile(r'coredump hex (\d+)')
+LINE = re.compile(r'^\s*([0-9a-fA-F]{4,8}): ([0-9a-fA-F]+)\s*$')
+END = re.compile(r'coredump end')
+
+MAGIC = 0x44434C42
+VERSION = 1
+HDR = struct.Struct('<IHHIIII')
+SEC = struct.Struct('<HH')
+REGS = struct.Struct('<4I32I')
+HEAP = struct.Struct('<II')
+TASK = struct.Struct('<6IBB2x16s')
+
+SEC_REGS, SEC_MSG, SEC_HEAP, SEC_STACK, SEC_TASK, SEC_LOG = range(1, 7)
+REASONS = {1: 'fault', 2: 'assert', 3: 'stack overflow', 4: 'watchdog'}
+STATES = ['run', 'ready', 'block', 'susp', 'del']
+REG_NAMES = ['zero', 'ra', 'sp', 'gp', 'tp', 't0', 't1', 't2',
+             's0', 's1', 'a0', 'a1', 'a2', 'a3', 'a4', 'a5',
+             'a6', 'a7', 's2', 's3', 's4', 's5', 's6', 's7',
+             's8', 's9', 's10', 's11', 't3', 't4', 't5', 't6']
+MCAUSES = {0: 'instruction address misaligned', 1: 'instruction access fault',
+           2: 'illegal instruction', 3: 'breakpoint', 4: 'load address misaligned',
+           5: 'load access fault', 6: 'store address misaligned',
+           7: 'store access fault', 11: 'ecall from M-mode'}
+
+# XIP flash, then the TCM where ATTR_TCM_SECTION code runs, see flash.ld
+CODE = [(0x23000000, 0x23400000), (0x4200C000, 0x42030000)]
+
+def find_addr2line():
+    sdk = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    path = os.path.join(sdk, 'toolchain', 'compiler', 'bin', ADDR2LINE)
+    if os.access(path, os.X_OK):
+        return path
+    path = shutil.which(ADDR2LINE)
+    if path is None:
+        sys.exit(f"{ADDR2LINE} not found in the SDK toolchain or PATH")
+    return path
+
+def parse_hex(lines):
+    """the last complete dump in a console log"""
+    rec, data, length = None, None, 0
+    for line in lines:
+        m = START.search(line)
+        if m:
+            data, length = bytearray(), int(m.group(1))
+            continue
+        if data is None:
+            continue
+        if END.search(line):
+            if len(data) == length:
+                rec = bytes(data)
+            data = None
+            continue
+        m = LINE.match(line)
+        if m and int(m.group(1), 16) == len(data):
+            data += bytes.fromhex(m.group(2))
+    return rec
+
+def sections(rec):
+    magic, version, hdr_size, length, crc, reason, uptime = HDR.unpack_from(rec)
+    if magic != MAGIC or version != VERSION or hdr_size != HDR.size:
+        sys.exit("not a crash record, or of another version")
+    if length > len(rec) or zlib.crc32(rec[hdr_size:length]) != crc:
+        sys.exit("crash record is damaged, CRC mismatch")
+    secs = []
+    off = hdr_size
+    while off < length:
+        kind, size = SEC.unpack_from(rec, off)
+        off += SEC.size
+        secs.append((kind, rec[off:off + size]))
+        off += (size + 3) & ~3
+    return reason, uptime, length, secs
+
+def is_code(word):
+    return not word & 1 and any(lo <= word < hi for lo, hi in CODE)
+
+def symbolize(addr2line, elf, addrs):
+    if not addrs:
+        return {}
+    addrs = sorted(addrs)
+    out = subprocess.run([addr2line, '-e', elf, '-f', '-C', '-s'] + [f"0x{a:08x}" for a in addrs],
+                         check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout.splitlines()
+    syms = {}
+    for i, a in enumerate(addrs):
+        func, line = out[2 * i], out[2 * i + 1]
+        if func != '??':
+            syms[a] = f"{func}  {line}"
+    return syms
+
+def words(data):
+    return struct.unpack_from(f'<{len(data) // 4}I', data)
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode and symbolize a crash record")
+    parser.add_argument("elf", help="the ELF of the build that crashed")
+    parser.add_argument("log", nargs="?", help="console log holding 'coredump hex', stdin if omitted")
+    parser.add_argument("--raw", action="store_true", help="log is the record itself, as a binary file")
+    parser.add_argument("--addr2line", help=f"path of {ADDR2LINE}")
+    args = parser.parse_args()
+
+    if args.raw:
+        if not args.log:
+            sys.exit("--raw needs the record file")
+        with open(args.log, 'rb') as f:
+            rec = f.read()
+    elif args.log:
+        with open(args.log, errors="replace") as f:
+            rec = parse_hex(f)
+    else:
+        rec = parse_hex(sys.stdin)
+    if rec is None:
+        sys.exit("no complete 'coredump hex' output found")
+
+    reason, uptime, length, secs = sections(rec)
+
+    # everything that may be a code address, looked up in one go
+    addrs = set()
+    for kind, data in secs:
+        if kind == SEC_REGS:
+            addrs.update(w for w in words(data)[1:] if is_code(w))
+        elif kind == SEC_STACK:
+            addrs.update(w for w in words(data[4:]) if is_code(w))
+        elif kind == SEC_TASK:
+            task = TASK.unpack_from(data)
+            addrs.update(w for w in task[1:3] + words(data[TASK.size:]) if is_code(w))
+    syms = symbolize(args.addr2line or find_addr2line(), args.elf, addrs)
+
+    def sym(a):
+        return syms.get(a, '')
+
+    print(f"{REASONS.get(reason, 'unknown')}, {uptime} ms after boot, {length} bytes")
+    for kind, data in secs:
+        if kind == SEC_REGS:
+            r = REGS.unpack_from(data)
+            mcause, mepc, mtval, mstatus, x = r[0], r[1], r[2], r[3], r[4:]
+            if reason == 1:
+                print(f"mcause {mcause:08x} ({MCAUSES.get(mcause & 0x3ff, 'unknown')})  mtval {mtval:08x}")
+            print(f"pc  {mepc:08x}  {sym(mepc)}")
+            print(f"ra  {x[1]:08x}  {sym(x[1])}")
+            print(f"mstatus {mstatus:08x}")
+            for i in range(1, 32, 4):
+                print('  '.join(f"{REG_NAMES[n]:>4} {x[n]:08x}" for n in range(i, min(i + 4, 32))))
+        elif kind == SEC_MSG:
+            print(f"message: {data.decode(errors='replace')}")
+        elif kind == SEC_HEAP:
+            free, min_free = HEAP.unpack_from(data)
+            print(f"heap free {free}, min free {min_free}")
+        elif kind == SEC_STACK:
+            sp, = struct.unpack_from('<I', data)
+            print(f"stack from sp {sp:08x}, {len(data) - 4} bytes, code addresses:")
+            for i, w in enumerate(words(data[4:])):
+                if w in syms:
+                    print(f"  {sp + 4 * i:08x}: {w:08x}  {syms[w]}")
+        elif kind == SEC_TASK:
+            handle, pc, ra, sp, base, free, state, prio, name = TASK.unpack_from(data)
+            name = name.split(b'\0', 1)[0].decode(errors='replace')
+            state = STATES[state] if state < len(STATES) else '?'
+            print(f"task {name} ({handle:08x}) {state} prio {prio} sp {sp:08x} "
+                  f"stack {base:08x} min free {free}")
+            for label, a in (('pc', pc), ('ra', ra)):
+                if a:
+                    print(f"  {label} {a:08x}  {sym(a)}")
+            for i, w in enumerate(words(data[TASK.size:])):
+                if w in syms:
+                    print(f"  {sp + 4 * i:08x}: {w:08x}  {syms[w]}")
+        elif kind == SEC_LOG:
+            print("log tail:")
+            print(data.decode(errors='replace').replace('\r', ''))
+        else:
+            print(f"section {kind}, {len(data)} bytes")
+
+if __name__ == "__main__":
+    main()
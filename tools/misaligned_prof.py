@@ -0,0 +1,79 @@
+#!/bin/env python3
+
+# Symbolize the output of the "misaligned" CLI command, built with
+# CONFIG_MISALIGNED_PROFILE=1.
+#
+#   misaligned_prof.py build_out/app.elf console.log
+#   misaligned_prof.py build_out/app.elf < console.log
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+LINE = re.compile(r'0x([0-9a-fA-F]{8})\s+(load|store)\s+(\d+)')
+SUMMARY = re.compile(r'misaligned traps:.*')
+ADDR2LINE = 'riscv32-unknown-elf-addr2line'
+
+def find_addr2line():
+    sdk = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    path = os.path.join(sdk, 'toolchain', 'compiler', 'bin', ADDR2LINE)
+    if os.access(path, os.X_OK):
+        return path
+    path = shutil.which(ADDR2LINE)
+    if path is None:
+        sys.exit(f"{ADDR2LINE} not found in the SDK toolchain or PATH")
+    return path
+
+def parse(lines):
+    summary = None
+    hits = {}
+    for line in lines:
+        m = SUMMARY.search(line)
+        if m:
+            # a later dump replaces an earlier one
+            summary = m.group(0).strip()
+            hits = {}
+            continue
+        m = LINE.search(line)
+        if m:
+            key = (int(m.group(1), 16), m.group(2))
+            hits[key] = int(m.group(3))
+    return summary, hits
+
+def symbolize(addr2line, elf, pcs):
+    if not pcs:
+        return {}
+    out = subprocess.run([addr2line, '-e', elf, '-f', '-C', '-s'] + [f"0x{pc:08x}" for pc in pcs],
+                         check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout.splitlines()
+    return {pc: (out[2 * i], out[2 * i + 1]) for i, pc in enumerate(pcs)}
+
+def main():
+    parser = argparse.ArgumentParser(description="Map misaligned trap PCs to source lines")
+    parser.add_argument("elf", help="the ELF the dump was taken from")
+    parser.add_argument("log", nargs="?", help="console log holding the dump, stdin if omitted")
+    parser.add_argument("--addr2line", help=f"path of {ADDR2LINE}")
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, errors="replace") as f:
+            summary, hits = parse(f)
+    else:
+        summary, hits = parse(sys.stdin)
+    if summary is None and not hits:
+        sys.exit("no misaligned dump found")
+
+    pcs = sorted({pc for pc, _ in hits})
+    syms = symbolize(args.addr2line or find_addr2line(), args.elf, pcs)
+
+    if summary:
+        print(summary)
+    print(f"{'count':>8}  {'type':5}  {'pc':10}  function / line")
+    for (pc, kind), count in sorted(hits.items(), key=lambda kv: -kv[1]):
+        func, line = syms[pc]
+        print(f"{count:>8}  {kind:5}  0x{pc:08x}  {func}  {line}")
+
+if __name__ == "__main__":
+    main()